@@ -0,0 +1,86 @@
+#!/usr/bin/env python3
+
+# Copyright (c) 2026, NVIDIA CORPORATION.
+#
+# Permission is hereby granted, free of charge, to any person obtaining a
+# copy of this software and/or associated documentation files (the
+# "Materials"), to deal in the Materials without restriction, including
+# without limitation the rights to use, copy, modify, merge, publish,
+# distribute, sublicense, and/or sell copies of the Materials, and to
+# permit persons to whom the Materials are furnished to do so, subject to
+# the following conditions:
+#
+# The above copyright notice and this permission notice shall be included
+# unaltered in all copies or substantial portions of the Materials.
+# Any additions, deletions, or changes to the original source files
+# must be clearly indicated in accompanying documentation.
+#
+# THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+# EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+# IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+# CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+# TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+# MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+
+"""
+Builds a hot-function profile from the call counts that libGLdispatch writes.
+
+Run a program with __GLVND_CALL_COUNTS=<path> to get a <path>.<pid> file for
+each process, and then pass any number of those files to this script. It adds
+the counts for each function together, and prints them from the most calls
+to the fewest, in the format that genCommon.readProfile expects. That output
+can replace src/generate/gl_hot_functions.txt, or be appended to it.
+"""
+
+import argparse
+import sys
+
+def read_counts(filename, totals):
+    with open(filename, "r") as f:
+        for (lineNumber, line) in enumerate(f, 1):
+            fields = line.split()
+            if len(fields) == 0:
+                continue
+            if len(fields) != 2:
+                raise ValueError("%s:%d: Expected a call count and a function name"
+                        % (filename, lineNumber))
+            try:
+                count = int(fields[0])
+            except ValueError:
+                raise ValueError("%s:%d: Invalid call count %r"
+                        % (filename, lineNumber, fields[0]))
+            totals[fields[1]] = totals.get(fields[1], 0) + count
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+            formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("files", nargs="+",
+            help="The call count files to read")
+    parser.add_argument("--limit", type=int, default=0,
+            help="Only print this many of the most frequently called functions")
+    parser.add_argument("--no-weights", action="store_true",
+            help="Only print the function names, without their call counts")
+    args = parser.parse_args()
+
+    totals = {}
+    for filename in args.files:
+        read_counts(filename, totals)
+
+    names = sorted(totals, key=lambda name: (-totals[name], name))
+    if args.limit > 0:
+        names = names[:args.limit]
+
+    print("# Generated by callcount-profile.py from %d call count file(s)."
+            % (len(args.files),))
+    for name in names:
+        if args.no_weights:
+            print(name)
+        else:
+            print("%d %s" % (totals[name], name))
+
+if __name__ == "__main__":
+    try:
+        main()
+    except (IOError, ValueError) as e:
+        sys.exit("%s: %s" % (sys.argv[0], e))
@@ -0,0 +1,74 @@
+#!/usr/bin/env python3
+
+# Copyright (c) 2026, NVIDIA CORPORATION.
+#
+# Permission is hereby granted, free of charge, to any person obtaining a
+# copy of this software and/or associated documentation files (the
+# "Materials"), to deal in the Materials without restriction, including
+# without limitation the rights to use, copy, modify, merge, publish,
+# distribute, sublicense, and/or sell copies of the Materials, and to
+# permit persons to whom the Materials are furnished to do so, subject to
+# the following conditions:
+#
+# The above copyright notice and this permission notice shall be included
+# unaltered in all copies or substantial portions of the Materials.
+# Any additions, deletions, or changes to the original source files
+# must be clearly indicated in accompanying documentation.
+#
+# THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+# EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+# IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+# CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+# TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+# MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+
+"""
+Does a profile-guided build of libglvnd with meson.
+
+This sets up a build directory with b_pgo=generate, builds it, and runs the
+benchmarks in the "pgo" test suite as the training workload. Those are the
+dispatch benchmarks (benchgldispatch and benchvendordirect), benchmakecurrent,
+and the libGLdispatch and libEGL variants of benchgetprocaddress, all of which
+run against the dummy vendor libraries in tests/dummy, so no real driver or X
+server is needed. Then it switches the build directory to b_pgo=use and
+rebuilds everything with the profile.
+
+Any extra arguments are passed to "meson setup", so for example:
+
+    bin/pgo-build.py build -Dbuildtype=release -Dprefix=/usr
+
+The result is an ordinary build directory, which can be installed with
+"meson install" as usual.
+"""
+
+import argparse
+import subprocess
+import sys
+
+def run(args):
+    print("+ " + " ".join(args), flush=True)
+    subprocess.check_call(args)
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--meson", default="meson")
+    parser.add_argument("--ninja", default="ninja")
+    parser.add_argument("builddir")
+    parser.add_argument("setup_args", nargs=argparse.REMAINDER,
+            help="extra arguments for meson setup")
+    args = parser.parse_args()
+
+    run([args.meson, "setup", args.builddir, "-Db_pgo=generate"]
+            + args.setup_args)
+    run([args.ninja, "-C", args.builddir])
+    run([args.meson, "test", "-C", args.builddir, "--benchmark",
+            "--suite", "pgo"])
+    run([args.meson, "configure", args.builddir, "-Db_pgo=use"])
+    run([args.ninja, "-C", args.builddir])
+
+if __name__ == "__main__":
+    try:
+        main()
+    except (OSError, subprocess.CalledProcessError) as e:
+        sys.exit("%s: %s" % (sys.argv[0], e))
@@ -0,0 +1,129 @@
+#!/usr/bin/env python3
+
+# Copyright (c) 2026, NVIDIA CORPORATION.
+#
+# Permission is hereby granted, free of charge, to any person obtaining a
+# copy of this software and/or associated documentation files (the
+# "Materials"), to deal in the Materials without restriction, including
+# without limitation the rights to use, copy, modify, merge, publish,
+# distribute, sublicense, and/or sell copies of the Materials, and to
+# permit persons to whom the Materials are furnished to do so, subject to
+# the following conditions:
+#
+# The above copyright notice and this permission notice shall be included
+# unaltered in all copies or substantial portions of the Materials.
+# Any additions, deletions, or changes to the original source files
+# must be clearly indicated in accompanying documentation.
+#
+# THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+# EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+# IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+# CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+# TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+# MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+
+"""
+Prints the shared memory statistics from every running process that uses
+libglvnd.
+
+A process writes them when the __GLVND_SHM_STATS environment variable is set.
+Each one has a file named glvnd-<pid> in /dev/shm, or in the directory that
+__GLVND_SHM_STATS names. The format is described in
+src/GLdispatch/GLdispatchPrivate.h.
+
+This prints one line per process, as comma-separated values. Files left
+behind by a process that crashed are skipped, unless --stale is given.
+"""
+
+import argparse
+import errno
+import glob
+import os
+import struct
+import sys
+
+FILE_MAGIC = b"GLVNDSHM"
+FILE_VERSION = 1
+
+HEADER = struct.Struct("=8sIIQ")
+
+# These have to match the order of the counters in __GLdispatchShmStats.
+COUNTERS = (
+    "make_current",
+    "vendor_switch",
+    "fixup",
+    "fixup_us",
+    "tables",
+    "patch_owner",
+    "patch",
+    "unpatch",
+    "patch_us",
+    "lock_acquired",
+    "lock_contended",
+    "lock_wait_us",
+    "dynamic_stubs",
+    "dynamic_stub_max",
+)
+
+# The counters that are in nanoseconds, which get printed in microseconds.
+NS_COUNTERS = ("fixup_us", "lock_wait_us")
+
+def read_stats(data):
+    """
+    Returns the pid and a dictionary of counters from a statistics file, or
+    None if the file isn't filled in yet.
+    """
+    if len(data) < HEADER.size:
+        return None
+    (magic, version, size, pid) = HEADER.unpack_from(data, 0)
+    if magic != FILE_MAGIC:
+        return None
+    if version != FILE_VERSION:
+        raise ValueError("unsupported version %d" % (version,))
+
+    # A newer libglvnd might add counters to the end, and an older one might
+    # not have all of these.
+    count = min(len(COUNTERS), (min(size, len(data)) - HEADER.size) // 8)
+    values = struct.unpack_from("=%dQ" % (count,), data, HEADER.size)
+    stats = {}
+    for (name, value) in zip(COUNTERS, values):
+        if name in NS_COUNTERS:
+            stats[name] = "%.3f" % (value / 1000.0,)
+        else:
+            stats[name] = str(value)
+    return (pid, stats)
+
+def process_exists(pid):
+    try:
+        os.kill(pid, 0)
+    except OSError as e:
+        return e.errno == errno.EPERM
+    return True
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+            formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--dir", default="/dev/shm",
+            help="The directory with the statistics files")
+    parser.add_argument("--stale", action="store_true",
+            help="Include files from processes that no longer exist")
+    args = parser.parse_args()
+
+    print("# pid," + ",".join(COUNTERS))
+    for path in sorted(glob.glob(os.path.join(args.dir, "glvnd-*"))):
+        try:
+            with open(path, "rb") as f:
+                result = read_stats(f.read())
+        except (IOError, ValueError) as e:
+            sys.stderr.write("%s: %s: %s\n" % (sys.argv[0], path, e))
+            continue
+        if result is None:
+            continue
+        (pid, stats) = result
+        if not args.stale and not process_exists(pid):
+            continue
+        print(",".join([str(pid)] + [stats.get(name, "") for name in COUNTERS]))
+
+if __name__ == "__main__":
+    main()
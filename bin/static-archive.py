@@ -0,0 +1,125 @@
+#!/usr/bin/env python3
+
+# Copyright (c) 2026, NVIDIA CORPORATION.
+#
+# Permission is hereby granted, free of charge, to any person obtaining a
+# copy of this software and/or associated documentation files (the
+# "Materials"), to deal in the Materials without restriction, including
+# without limitation the rights to use, copy, modify, merge, publish,
+# distribute, sublicense, and/or sell copies of the Materials, and to
+# permit persons to whom the Materials are furnished to do so, subject to
+# the following conditions:
+#
+# The above copyright notice and this permission notice shall be included
+# unaltered in all copies or substantial portions of the Materials.
+# Any additions, deletions, or changes to the original source files
+# must be clearly indicated in accompanying documentation.
+#
+# THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+# EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+# IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+# CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+# TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+# MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+
+"""
+Turns one of libglvnd's libraries into a static archive that can be linked
+into an executable alongside the others.
+
+Each library is normally a shared object, and its internal functions are
+hidden, so different libraries are free to use the same names for them. They
+do: libGLdispatch and libOpenGL each have their own copy of the GL stubs, and
+they all have their own copies of the helpers in src/util.
+
+So instead of just putting the object files into an archive, this links them
+into a single relocatable object with "ld -r", and then makes every symbol
+local except for the ones that the shared library would export. The first
+archive is included whole, the same as link_whole in meson, and the rest only
+supply the members that the first one needs.
+
+Having everything in one object also means that an executable gets the whole
+library, including its constructor and destructor, as soon as it uses any
+function from it.
+"""
+
+import argparse
+import os
+import subprocess
+import sys
+import tempfile
+
+def read_symbols_file(path):
+    """
+    Reads a list of exported symbols in the format that symbols-check.py uses.
+    """
+    symbols = []
+    with open(path) as f:
+        for line in f:
+            fields = line.split("#")[0].split()
+            if fields:
+                symbols.append(fields[-1])
+    return symbols
+
+def read_version_script(path):
+    """
+    Reads the names in the "global:" section of a linker version script.
+    """
+    symbols = []
+    in_global = False
+    with open(path) as f:
+        for line in f:
+            line = line.split("#")[0].strip()
+            if line == "global:":
+                in_global = True
+            elif line.startswith("local:") or line.startswith("}"):
+                in_global = False
+            elif in_global and line.endswith(";"):
+                symbols.append(line[:-1].strip())
+    return symbols
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--ld", default="ld")
+    parser.add_argument("--objcopy", default="objcopy")
+    parser.add_argument("--ar", default="ar")
+    exports = parser.add_mutually_exclusive_group(required=True)
+    exports.add_argument("--symbols-file",
+            help="file listing the exported symbols, like symbols-check.py")
+    exports.add_argument("--version-script",
+            help="linker version script listing the exported symbols")
+    parser.add_argument("--output", required=True,
+            help="the static archive to write")
+    parser.add_argument("archives", nargs="+",
+            help="the library's own archive, followed by the internal "
+            "archives that it links with")
+    args = parser.parse_args()
+
+    if args.symbols_file is not None:
+        symbols = read_symbols_file(args.symbols_file)
+    else:
+        symbols = read_version_script(args.version_script)
+
+    base = os.path.splitext(os.path.basename(args.output))[0]
+    with tempfile.TemporaryDirectory() as tmpdir:
+        obj = os.path.join(tmpdir, base + ".o")
+        keep = os.path.join(tmpdir, base + ".symbols")
+
+        subprocess.check_call([args.ld, "-r", "-o", obj,
+                "--whole-archive", args.archives[0], "--no-whole-archive",
+                "--start-group"] + args.archives[1:] + ["--end-group"])
+
+        with open(keep, "w") as f:
+            f.write("\n".join(symbols) + "\n")
+        subprocess.check_call([args.objcopy,
+                "--keep-global-symbols=" + keep, obj])
+
+        if os.path.exists(args.output):
+            os.remove(args.output)
+        subprocess.check_call([args.ar, "rcs", args.output, obj])
+
+if __name__ == "__main__":
+    try:
+        main()
+    except (OSError, subprocess.CalledProcessError) as e:
+        sys.exit("%s: %s" % (sys.argv[0], e))
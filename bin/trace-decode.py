@@ -0,0 +1,216 @@
+#!/usr/bin/env python3
+
+# Copyright (c) 2026, NVIDIA CORPORATION.
+#
+# Permission is hereby granted, free of charge, to any person obtaining a
+# copy of this software and/or associated documentation files (the
+# "Materials"), to deal in the Materials without restriction, including
+# without limitation the rights to use, copy, modify, merge, publish,
+# distribute, sublicense, and/or sell copies of the Materials, and to
+# permit persons to whom the Materials are furnished to do so, subject to
+# the following conditions:
+#
+# The above copyright notice and this permission notice shall be included
+# unaltered in all copies or substantial portions of the Materials.
+# Any additions, deletions, or changes to the original source files
+# must be clearly indicated in accompanying documentation.
+#
+# THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+# EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+# IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+# CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+# TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+# MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+
+"""
+Prints a trace file written by libGLdispatch as text.
+
+The trace file format is described in src/GLdispatch/GLdispatchTrace.c. Each
+line of output has the time in microseconds since tracing started, the thread
+ID, the event name, and the event's arguments. With --merge, the events from
+every thread are sorted by time, instead of being listed one thread at a time.
+
+With --phases, it prints how long each startup phase took instead, by
+pairing up the PhaseBegin and PhaseEnd events on each thread.
+
+A ProcLookup event only has a hash of the function name. With --names, any
+hash that matches a name in the given file is printed as that name. The file
+has one name per line, and anything before the name on a line is ignored, so
+tests/procaddress_trace.txt from the build tree works.
+"""
+
+import argparse
+import struct
+import sys
+
+FILE_MAGIC = b"GLVNDTRC"
+FILE_VERSION = 1
+
+FILE_HEADER = struct.Struct("=8sIIQQQQ")
+THREAD_HEADER = struct.Struct("=QII")
+RECORD = struct.Struct("=QIIQQ")
+
+API_NAMES = { 0: "GLX", 1: "EGL" }
+
+# These have to match the GLDISPATCH_TRACE_* values in GLdispatch.h.
+EVENTS = {
+    1: ("MakeCurrent", lambda a0, a1: "vendor=%d dispatch=0x%x" % (a0, a1)),
+    2: ("LoseCurrent", lambda a0, a1: ""),
+    3: ("Patch", lambda a0, a1: "vendor=%d owner=%d" % (a0, a1)),
+    4: ("Fixup", lambda a0, a1: "dispatch=0x%x entries=%d" % (a0, a1)),
+    5: ("VendorLoad", lambda a0, a1: "api=%s vendor=%d"
+        % (API_NAMES.get(a0, str(a0)), a1)),
+    6: ("PhaseBegin", lambda a0, a1: format_phase(a0, a1)),
+    7: ("PhaseEnd", lambda a0, a1: format_phase(a0, a1)),
+    8: ("SwitchCurrent", lambda a0, a1: "from=%d vendor=%d" % (a0, a1)),
+    9: ("ProcLookup", lambda a0, a1: "api=%s name=%s"
+        % (API_NAMES.get(a0, str(a0)), format_name(a1))),
+    10: ("Swap", lambda a0, a1: "api=%s drawable=0x%x"
+        % (API_NAMES.get(a0, str(a0)), a1)),
+    11: ("ForkReset", lambda a0, a1: ""),
+}
+EVENT_PHASE_BEGIN = 6
+EVENT_PHASE_END = 7
+
+# These have to match the GLDISPATCH_PHASE_* values in GLdispatch.h.
+PHASE_NAMES = {
+    1: "config_scan",
+    2: "config_parse",
+    3: "dlopen",
+    4: "vendor_main",
+    5: "lookup",
+    6: "fixup",
+}
+PHASE_FIXUP = 6
+
+# Maps the hash of a function name to the name, filled in from --names.
+PROC_NAMES = {}
+
+def hash_string(name):
+    """
+    Computes the 32-bit FNV-1a hash of a name, the same as glvndHashString.
+    """
+    h = 0x811c9dc5
+    for c in name.encode("ascii"):
+        h = ((h ^ c) * 0x01000193) & 0xffffffff
+    return h
+
+def read_names(path):
+    with open(path, "r") as f:
+        for line in f:
+            fields = line.split()
+            if len(fields) == 0 or fields[0].startswith("#"):
+                continue
+            PROC_NAMES[hash_string(fields[-1])] = fields[-1]
+
+def format_name(h):
+    return PROC_NAMES.get(h, "0x%08x" % (h,))
+
+def phase_key(phase, api):
+    name = PHASE_NAMES.get(phase, "phase%d" % (phase,))
+    if phase == PHASE_FIXUP:
+        return name
+    return "%s/%s" % (API_NAMES.get(api, str(api)), name)
+
+def format_phase(phase, api):
+    return "phase=%s" % (phase_key(phase, api),)
+
+def read_trace(data):
+    if len(data) < FILE_HEADER.size:
+        raise ValueError("File is too short")
+    (magic, version, recordSize, startTicks, startNS, endTicks,
+            endNS) = FILE_HEADER.unpack_from(data, 0)
+    if magic != FILE_MAGIC:
+        raise ValueError("Not a libglvnd trace file")
+    if version != FILE_VERSION or recordSize != RECORD.size:
+        raise ValueError("Unsupported trace file version %d" % (version,))
+
+    # Map timestamps to nanoseconds using the two reference points.
+    if endTicks > startTicks and endNS > startNS:
+        scale = float(endNS - startNS) / (endTicks - startTicks)
+    else:
+        scale = 1.0
+
+    events = []
+    offset = FILE_HEADER.size
+    while offset + THREAD_HEADER.size <= len(data):
+        (threadID, count, _) = THREAD_HEADER.unpack_from(data, offset)
+        offset += THREAD_HEADER.size
+        for i in range(count):
+            if offset + RECORD.size > len(data):
+                raise ValueError("File is truncated")
+            (ticks, event, _, arg0, arg1) = RECORD.unpack_from(data, offset)
+            offset += RECORD.size
+            ns = (ticks - startTicks) * scale
+            events.append((ns, threadID, event, arg0, arg1))
+    return events
+
+def format_event(ns, threadID, event, arg0, arg1):
+    if event in EVENTS:
+        (name, formatArgs) = EVENTS[event]
+        args = formatArgs(arg0, arg1)
+    else:
+        name = "Event%d" % (event,)
+        args = "0x%x 0x%x" % (arg0, arg1)
+    return "%14.3f %8d %-13s %s" % (ns / 1000.0, threadID, name, args)
+
+def summarize_phases(events):
+    """
+    Returns a list of (phase, count, total ns) tuples, in the order that each
+    phase first started. A begin event without a matching end, which happens
+    if something fails partway through, is left out.
+    """
+    pending = {}
+    totals = {}
+    order = []
+    for (ns, threadID, event, arg0, arg1) in events:
+        if event == EVENT_PHASE_BEGIN:
+            pending[(threadID, arg0, arg1)] = ns
+        elif event == EVENT_PHASE_END:
+            start = pending.pop((threadID, arg0, arg1), None)
+            if start is None:
+                continue
+            key = phase_key(arg0, arg1)
+            if key not in totals:
+                totals[key] = [0, 0.0]
+                order.append(key)
+            totals[key][0] += 1
+            totals[key][1] += ns - start
+    return [(key, totals[key][0], totals[key][1]) for key in order]
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+            formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("file", help="The trace file to decode")
+    parser.add_argument("--merge", action="store_true",
+            help="Sort the events from all threads by time")
+    parser.add_argument("--phases", action="store_true",
+            help="Print the total time spent in each startup phase")
+    parser.add_argument("--names", metavar="FILE",
+            help="Look up the names of ProcLookup events in FILE")
+    args = parser.parse_args()
+
+    if args.names is not None:
+        read_names(args.names)
+
+    with open(args.file, "rb") as f:
+        events = read_trace(f.read())
+
+    if args.phases:
+        events.sort(key=lambda e: e[0])
+        print("# phase,count,total_us")
+        for (key, count, ns) in summarize_phases(events):
+            print("%s,%d,%.3f" % (key, count, ns / 1000.0))
+        return
+
+    if args.merge:
+        events.sort(key=lambda e: e[0])
+    for e in events:
+        print(format_event(*e).rstrip())
+
+if __name__ == "__main__":
+    try:
+        main()
+    except ValueError as e:
+        sys.exit("%s: %s" % (sys.argv[0], e))
@@ -71,6 +71,10 @@ enum {
 
     /*!
      * Used for stubs on x86-64 systems.
+     *
+     * If libglvnd is built with --enable-compact-tls-stubs, then the stubs
+     * are only 16 bytes, so a vendor library should check the \c stubSize
+     * parameter of \c isPatchSupported.
      */
     __GLDISPATCH_STUB_X86_64,
 
@@ -103,6 +107,16 @@ enum {
      * Used for stubs on PPC64LE systems. Same as PPC64, for compatibility.
      */
     __GLDISPATCH_STUB_PPC64LE = __GLDISPATCH_STUB_PPC64,
+
+    /*!
+     * Used for stubs on 64-bit RISC-V systems.
+     */
+    __GLDISPATCH_STUB_RISCV64,
+
+    /*!
+     * Used for stubs on LoongArch64 systems.
+     */
+    __GLDISPATCH_STUB_LOONGARCH64,
 };
 
 /*!
@@ -133,6 +147,31 @@ enum {
 typedef GLboolean (*DispatchPatchLookupStubOffset)(const char *funcName,
         void **writePtr, const void **execPtr);
 
+/*!
+ * A callback function called by the vendor library to point an entrypoint
+ * directly at one of its own functions.
+ *
+ * This is used for the thread-safe version of entrypoint patching. Instead of
+ * having the vendor library write its own code into each entrypoint, libglvnd
+ * changes the entrypoint to jump to \p target. Libglvnd writes that jump with
+ * a single aligned store, so it can safely do so (and undo it) while other
+ * threads are calling the entrypoint.
+ *
+ * \p target must have the same signature as the OpenGL function, and must
+ * remain valid until libglvnd calls \c releasePatch.
+ *
+ * Note that if this function fails, then the entrypoint will still dispatch
+ * through the current dispatch table as usual, and the vendor library can
+ * still try to patch other entrypoints.
+ *
+ * \param funcName The function name.
+ * \param target The function that the entrypoint should jump to.
+ * \return GL_TRUE if the entrypoint was changed, or GL_FALSE if it doesn't
+ * exist or libglvnd can't change it.
+ */
+typedef GLboolean (*DispatchPatchSetStubTarget)(const char *funcName,
+        const void *target);
+
 #if defined(__cplusplus)
 }
 #endif
@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+#if !defined(__GL_DISPATCH_LAYER_ABI_H)
+#define __GL_DISPATCH_LAYER_ABI_H
+
+#include <stdint.h>
+#include <GL/gl.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/*!
+ * \defgroup gldispatchlayerabi GL dispatch layer ABI
+ *
+ * A layer is a library that sits between the application and the vendor
+ * library, and intercepts some subset of the OpenGL functions. Profilers,
+ * validators, and capture tools can use this instead of interposing every
+ * OpenGL function with LD_PRELOAD.
+ *
+ * Layers are listed in JSON manifest files, which are found through the
+ * __GLVND_LAYER_FILENAMES and __GLVND_LAYER_DIRS environment variables. A
+ * manifest looks like this:
+ *
+ * \code
+ * {
+ *     "file_format_version" : "1.0.0",
+ *     "layer" : {
+ *         "library_path" : "libmylayer.so"
+ *     }
+ * }
+ * \endcode
+ *
+ * libGLdispatch puts each layer's functions directly into the dispatch
+ * tables, when it looks up the vendor's functions. Any function that a layer
+ * doesn't intercept goes straight to the vendor, and if no layers are loaded,
+ * then nothing changes at all.
+ *
+ * Entrypoint rewriting is disabled while any layers are loaded, since that
+ * would skip the dispatch tables.
+ * @{
+ */
+
+/*!
+ * The layer ABI version. This uses the same major and minor version scheme as
+ * the libEGL and libGLX vendor ABIs.
+ */
+#define GLDISPATCH_LAYER_ABI_MAJOR_VERSION ((uint32_t) 0)
+#define GLDISPATCH_LAYER_ABI_MINOR_VERSION ((uint32_t) 0)
+#define GLDISPATCH_LAYER_ABI_VERSION ((GLDISPATCH_LAYER_ABI_MAJOR_VERSION << 16) | GLDISPATCH_LAYER_ABI_MINOR_VERSION)
+static inline uint32_t GLDISPATCH_LAYER_ABI_GET_MAJOR_VERSION(uint32_t version)
+{
+    return version >> 16;
+}
+static inline uint32_t GLDISPATCH_LAYER_ABI_GET_MINOR_VERSION(uint32_t version)
+{
+    return version & 0xFFFF;
+}
+
+typedef void (*__GLdispatchLayerProc)(void);
+
+/*!
+ * The functions that libGLdispatch provides to a layer.
+ */
+typedef struct __GLdispatchLayerExportsRec {
+    /*!
+     * Returns the function that a layer should call to pass a call down the
+     * chain. That's the next layer's function, or the vendor's function if
+     * there isn't another layer.
+     *
+     * This looks at the dispatch table that's current on the calling thread,
+     * so a layer should call it from its own function each time, rather than
+     * keeping the result. It doesn't take any locks.
+     *
+     * \param layerIndex The index that was passed to the layer's main
+     * function.
+     * \param slot The slot that was passed to the layer's \c getProcAddress
+     * callback for this function.
+     * \return The next function, or a no-op function if there isn't a
+     * current context.
+     */
+    __GLdispatchLayerProc (*getNext)(int layerIndex, int slot);
+} __GLdispatchLayerExports;
+
+/*!
+ * The functions that a layer provides to libGLdispatch.
+ */
+typedef struct __GLdispatchLayerImportsRec {
+    /*!
+     * Returns the layer's function for an OpenGL function, or NULL if the
+     * layer doesn't intercept it.
+     *
+     * This is called with libGLdispatch's lock held, each time a dispatch
+     * table is filled in, but only for functions that the vendor library
+     * supports. It must not call into libGLdispatch or any other libglvnd
+     * library.
+     *
+     * \param procName The name of the function.
+     * \param slot The dispatch table slot for the function, which the layer
+     * has to pass to \c getNext.
+     * \param param The \c param value from this struct.
+     */
+    void *(*getProcAddress)(const char *procName, int slot, void *param);
+
+    /*!
+     * An arbitrary value to pass to \c getProcAddress.
+     */
+    void *param;
+} __GLdispatchLayerImports;
+
+#define __GLDISPATCH_LAYER_MAIN_PROTO_NAME "__glDispatchLayerMain"
+
+typedef GLboolean (* __PFNGLDISPATCHLAYERMAINPROC) (uint32_t version,
+        const __GLdispatchLayerExports *exports, int layerIndex,
+        __GLdispatchLayerImports *imports);
+
+/*!
+ * Layer libraries must export a function called __glDispatchLayerMain() with
+ * the following prototype.
+ *
+ * This is called when libGLdispatch is initialized, with libGLdispatch's lock
+ * held.
+ *
+ * \param[in] version The ABI version.
+ * \param[in] exports The functions provided by libGLdispatch. This pointer
+ * will remain valid for as long as the layer is loaded.
+ * \param[in] layerIndex The layer's position in the chain, starting at zero
+ * for the layer closest to the application.
+ * \param[out] imports The function table that the layer should fill in.
+ * \return True on success, or False if the layer doesn't support this ABI
+ * version, in which case it's unloaded.
+ */
+GLboolean __glDispatchLayerMain(uint32_t version,
+        const __GLdispatchLayerExports *exports, int layerIndex,
+        __GLdispatchLayerImports *imports);
+
+/*!
+ * @}
+ */
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif // !defined(__GL_DISPATCH_LAYER_ABI_H)
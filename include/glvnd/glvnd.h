@@ -0,0 +1,263 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+#if !defined(__GLVND_CLIENT_H)
+#define __GLVND_CLIENT_H
+
+/*!
+ * \file
+ *
+ * Extra functions that libGLX, libEGL, and libGLdispatch export for
+ * applications.
+ *
+ * These aren't part of any GLX or EGL extension, so an application that
+ * wants to keep working with other implementations should look them up with
+ * dlsym instead of linking to them directly.
+ */
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+struct _XDisplay;
+
+/*!
+ * \defgroup glvndpreinit Pre-initialization
+ *
+ * Flags for \c glXPreinitializeGLVND and \c eglPreinitializeGLVND.
+ */
+/*@{*/
+
+/*!
+ * Load the vendor libraries.
+ *
+ * For libEGL, that's every vendor library that it would otherwise load on
+ * demand. For libGLX, that's the vendors for every screen of the display, and
+ * any vendors listed in __GLX_PRELOAD_VENDORS.
+ */
+#define GLVND_PREINIT_LOAD_VENDORS      0x0001
+
+/*!
+ * Fill in the OpenGL dispatch table for each vendor that's been loaded, so
+ * that the first MakeCurrent call doesn't have to look up every function.
+ */
+#define GLVND_PREINIT_POPULATE_DISPATCH 0x0002
+
+/*!
+ * Fault in the dispatch stubs and dispatch tables. This is the same as setting
+ * __GLVND_PREWARM_DISPATCH=1 for the rest of the process.
+ */
+#define GLVND_PREINIT_PREFAULT          0x0004
+
+#define GLVND_PREINIT_ALL               0x0007
+
+/*@}*/
+
+/*!
+ * Does the work that libGLX would otherwise do the first time each vendor is
+ * used.
+ *
+ * This is meant for a process that forks workers after initializing, like a
+ * zygote or a prefork server. If it calls this before it forks, then the
+ * children share the loaded vendors and filled-in dispatch tables, and don't
+ * have to repeat any of it.
+ *
+ * \param dpy The display to load vendors for, or NULL to only load the
+ *      vendors in __GLX_PRELOAD_VENDORS.
+ * \param flags A bitmask of GLVND_PREINIT_* flags.
+ * \return Non-zero if every vendor that was asked for could be loaded.
+ */
+int glXPreinitializeGLVND(struct _XDisplay *dpy, unsigned int flags);
+
+/*!
+ * The same as \c glXPreinitializeGLVND, but for libEGL.
+ *
+ * \param flags A bitmask of GLVND_PREINIT_* flags.
+ * \return Non-zero if at least one vendor library is loaded.
+ */
+int eglPreinitializeGLVND(unsigned int flags);
+
+/*!
+ * Saves the calling thread's current GLX context, and leaves the thread with
+ * no current context.
+ *
+ * This is meant for middleware like overlays and capture tools, which need to
+ * make their own context current for a moment and then put back whatever the
+ * application had. Saving and restoring it with \c glXGetCurrentContext and
+ * \c glXMakeCurrent would mean two full make current calls each time.
+ * Instead, libglvnd keeps the pushed context's thread state and dispatch
+ * table, so \c glXPopCurrentGLVND doesn't have to look anything up again.
+ *
+ * The pushed context stays bound to the thread as far as
+ * \c glXDestroyContext is concerned, so it isn't freed until it's popped.
+ * Each thread has its own stack, and a thread should pop everything it pushes
+ * before it exits.
+ *
+ * \return Non-zero on success, or zero if the vendor library couldn't
+ *      release the context, or another API has a current context.
+ */
+int glXPushCurrentGLVND(void);
+
+/*!
+ * Releases the calling thread's current GLX context, if it has one, and
+ * restores the context from the last call to \c glXPushCurrentGLVND.
+ *
+ * \return Non-zero on success. If the current context couldn't be released,
+ *      then the pushed context stays pushed. If the pushed context couldn't be
+ *      made current again, then the thread is left with no current context.
+ */
+int glXPopCurrentGLVND(void);
+
+/*!
+ * The same as \c glXPushCurrentGLVND, but for libEGL.
+ *
+ * Failures set an EGL error, which the caller can get from \c eglGetError.
+ */
+int eglPushCurrentGLVND(void);
+
+/*!
+ * The same as \c glXPopCurrentGLVND, but for libEGL.
+ */
+int eglPopCurrentGLVND(void);
+
+/*!
+ * A generic function pointer, as returned by \c glXGetProcAddressesGLVND and
+ * \c eglGetProcAddressesGLVND.
+ */
+typedef void (* GLVNDproc) (void);
+
+/*!
+ * Looks up a list of functions at once.
+ *
+ * This returns the same addresses that calling glXGetProcAddress for each
+ * name would, but it's meant for a loader that looks up every function it
+ * knows about. It only needs to take libglvnd's locks once, rather than once
+ * for each new OpenGL function.
+ *
+ * \param procNames The names of the functions to look up.
+ * \param[out] procs Receives the address of each function, or NULL.
+ * \param count The number of names.
+ * \return The number of functions that were found.
+ */
+int glXGetProcAddressesGLVND(const char * const *procNames,
+        GLVNDproc *procs, int count);
+
+/*!
+ * The same as \c glXGetProcAddressesGLVND, but for eglGetProcAddress.
+ */
+int eglGetProcAddressesGLVND(const char * const *procNames,
+        GLVNDproc *procs, int count);
+
+/*!
+ * \defgroup glvndcurrentinfo Current context info
+ *
+ * Values for \c GLVNDcurrentInfo::api.
+ */
+/*@{*/
+#define GLVND_CURRENT_API_NONE 0
+#define GLVND_CURRENT_API_GLX  1
+#define GLVND_CURRENT_API_EGL  2
+/*@}*/
+
+/*!
+ * The current context on a thread, as returned by
+ * \c __glDispatchGetCurrentInfo.
+ *
+ * libGLX and libEGL update this each time a context is made current or
+ * released. A signal handler might interrupt the thread partway through an
+ * update, so \c sequence is odd while an update is in progress. Since the
+ * thread can't finish the update while the handler is running, a handler
+ * that reads an odd \c sequence should treat the record as unknown rather
+ * than waiting for it to change.
+ */
+typedef struct GLVNDcurrentInfoRec {
+    unsigned int sequence;
+
+    /// One of the GLVND_CURRENT_API_* values.
+    int api;
+
+    /*!
+     * The libglvnd ID of the vendor library that owns the current context.
+     * This is unique within a process, but doesn't mean anything outside of
+     * it.
+     */
+    int vendorID;
+
+    /// The current GLXContext or EGLContext, or NULL.
+    void *context;
+
+    /// The current Display or EGLDisplay, or NULL.
+    void *display;
+} GLVNDcurrentInfo;
+
+/*!
+ * Returns the current context record for the calling thread.
+ *
+ * This is exported by libGLdispatch. It's async-signal-safe, so a sampling
+ * profiler can call it from a signal handler to find out which context the
+ * interrupted thread was using. The record is in thread-local storage, so the
+ * pointer is only valid on the calling thread, and only until it exits.
+ *
+ * \return The calling thread's record, or NULL if libglvnd was built without
+ *      thread-local storage support.
+ */
+const volatile GLVNDcurrentInfo *__glDispatchGetCurrentInfo(void);
+
+/*!
+ * Detaches the calling thread's current GLX or EGL context, so that another
+ * thread can attach it with \c __glDispatchAttachCurrent.
+ *
+ * This is exported by libGLdispatch, for fiber and job-system schedulers that
+ * move a task between worker threads. The context stays current while it's
+ * detached, so nothing has to be repatched or looked up again when it's
+ * attached. The calling thread is left without a current context.
+ *
+ * The vendor library has to support it. Otherwise, this fails and the context
+ * stays current on the calling thread.
+ *
+ * \return A handle for \c __glDispatchAttachCurrent, or NULL on failure.
+ */
+void *__glDispatchDetachCurrent(void);
+
+/*!
+ * Makes a context that was detached with \c __glDispatchDetachCurrent current
+ * on the calling thread.
+ *
+ * The calling thread must not have a current context. A detached context must
+ * be attached to some thread before the application releases or destroys it.
+ *
+ * \return Non-zero on success. On failure, the context stays detached.
+ */
+int __glDispatchAttachCurrent(void *state);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif // !defined(__GLVND_CLIENT_H)
@@ -86,7 +86,7 @@ extern "C" {
  * will still work.
  */
 #define EGL_VENDOR_ABI_MAJOR_VERSION ((uint32_t) 0)
-#define EGL_VENDOR_ABI_MINOR_VERSION ((uint32_t) 1)
+#define EGL_VENDOR_ABI_MINOR_VERSION ((uint32_t) 8)
 #define EGL_VENDOR_ABI_VERSION ((EGL_VENDOR_ABI_MAJOR_VERSION << 16) | EGL_VENDOR_ABI_MINOR_VERSION)
 static inline uint32_t EGL_VENDOR_ABI_GET_MAJOR_VERSION(uint32_t version)
 {
@@ -98,6 +98,15 @@ static inline uint32_t EGL_VENDOR_ABI_GET_MINOR_VERSION(uint32_t version)
 }
 
 
+/*!
+ * The number of OpenGL dispatch tables that libEGL can keep for each vendor.
+ *
+ * Variant 0 is the default table, which libEGL fills in with the vendor's
+ * \c getProcAddress function. A vendor can select the other variants with the
+ * \c getContextDispatchVariant function.
+ */
+#define __EGL_DISPATCH_VARIANT_COUNT 8
+
 /*!
  * This opaque structure stores function pointers for EGL extension functions.
  * It is allocated at runtime by the API library. Vendor-provided dispatch
@@ -219,6 +228,74 @@ enum
     __EGL_VENDOR_STRING_PLATFORM_EXTENSIONS,
 };
 
+/*!
+ * This structure stores function pointers for all functions defined in EGL 1.5,
+ * plus a few extension functions that libEGL needs to dispatch itself.
+ *
+ * A vendor library can fill this in with \c __EGLapiImports::getStaticDispatch.
+ * New members will only be added at the end.
+ */
+typedef struct __EGLdispatchTableStaticRec {
+    EGLBoolean (* initialize) (EGLDisplay dpy, EGLint *major, EGLint *minor);
+
+    EGLBoolean (* chooseConfig) (EGLDisplay dpy, const EGLint *attrib_list, EGLConfig *configs, EGLint config_size, EGLint *num_config);
+    EGLBoolean (* copyBuffers) (EGLDisplay dpy, EGLSurface surface, EGLNativePixmapType target);
+    EGLContext (* createContext) (EGLDisplay dpy, EGLConfig config, EGLContext share_context, const EGLint *attrib_list);
+    EGLSurface (* createPbufferSurface) (EGLDisplay dpy, EGLConfig config, const EGLint *attrib_list);
+    EGLSurface (* createPixmapSurface) (EGLDisplay dpy, EGLConfig config, EGLNativePixmapType pixmap, const EGLint *attrib_list);
+    EGLSurface (* createWindowSurface) (EGLDisplay dpy, EGLConfig config, EGLNativeWindowType win, const EGLint *attrib_list);
+    EGLBoolean (* destroyContext) (EGLDisplay dpy, EGLContext ctx);
+    EGLBoolean (* destroySurface) (EGLDisplay dpy, EGLSurface surface);
+    EGLBoolean (* getConfigAttrib) (EGLDisplay dpy, EGLConfig config, EGLint attribute, EGLint *value);
+    EGLBoolean (* getConfigs) (EGLDisplay dpy, EGLConfig *configs, EGLint config_size, EGLint *num_config);
+    EGLBoolean (* makeCurrent) (EGLDisplay dpy, EGLSurface draw, EGLSurface read, EGLContext ctx);
+    EGLBoolean (* queryContext) (EGLDisplay dpy, EGLContext ctx, EGLint attribute, EGLint *value);
+    const char *(* queryString) (EGLDisplay dpy, EGLint name);
+    EGLBoolean (* querySurface) (EGLDisplay dpy, EGLSurface surface, EGLint attribute, EGLint *value);
+    EGLBoolean (* swapBuffers) (EGLDisplay dpy, EGLSurface surface);
+    EGLBoolean (* terminate) (EGLDisplay dpy);
+    EGLBoolean (* waitGL) (void);
+    EGLBoolean (* waitNative) (EGLint engine);
+    EGLBoolean (* bindTexImage) (EGLDisplay dpy, EGLSurface surface, EGLint buffer);
+    EGLBoolean (* releaseTexImage) (EGLDisplay dpy, EGLSurface surface, EGLint buffer);
+    EGLBoolean (* surfaceAttrib) (EGLDisplay dpy, EGLSurface surface, EGLint attribute, EGLint value);
+    EGLBoolean (* swapInterval) (EGLDisplay dpy, EGLint interval);
+
+    EGLBoolean (* bindAPI) (EGLenum api);
+    EGLSurface (* createPbufferFromClientBuffer) (EGLDisplay dpy, EGLenum buftype, EGLClientBuffer buffer, EGLConfig config, const EGLint *attrib_list);
+    EGLBoolean (* releaseThread) (void);
+    EGLBoolean (* waitClient) (void);
+
+    EGLint (* getError) (void);
+
+#if 0
+    EGLDisplay (* getCurrentDisplay) (void);
+    EGLSurface (* getCurrentSurface) (EGLint readdraw);
+    EGLDisplay (* getDisplay) (EGLNativeDisplayType display_id);
+    EGLContext (* getCurrentContext) (void);
+#endif
+
+    // EGL 1.5 functions. A vendor library is not requires to implement these.
+    EGLSync (* createSync) (EGLDisplay dpy, EGLenum type, const EGLAttrib *attrib_list);
+    EGLBoolean (* destroySync) (EGLDisplay dpy, EGLSync sync);
+    EGLint (* clientWaitSync) (EGLDisplay dpy, EGLSync sync, EGLint flags, EGLTime timeout);
+    EGLBoolean (* getSyncAttrib) (EGLDisplay dpy, EGLSync sync, EGLint attribute, EGLAttrib *value);
+    EGLImage (* createImage) (EGLDisplay dpy, EGLContext ctx, EGLenum target, EGLClientBuffer buffer, const EGLAttrib *attrib_list);
+    EGLBoolean (* destroyImage) (EGLDisplay dpy, EGLImage image);
+    EGLSurface (* createPlatformWindowSurface) (EGLDisplay dpy, EGLConfig config, void *native_window, const EGLAttrib *attrib_list);
+    EGLSurface (* createPlatformPixmapSurface) (EGLDisplay dpy, EGLConfig config, void *native_pixmap, const EGLAttrib *attrib_list);
+    EGLBoolean (* waitSync) (EGLDisplay dpy, EGLSync sync, EGLint flags);
+    //EGLDisplay (* getPlatformDisplay) (EGLenum platform, void *native_display, const EGLAttrib *attrib_list);
+
+    // Extension functions that libEGL cares about.
+    EGLBoolean (* queryDevicesEXT) (EGLint max_devices, EGLDeviceEXT *devices, EGLint *num_devices);
+
+
+    EGLint (* debugMessageControlKHR) (EGLDEBUGPROCKHR callback, const EGLAttrib *attrib_list);
+    EGLBoolean (* queryDebugKHR) (EGLint attribute, EGLAttrib* value);
+    EGLint (* labelObjectKHR) (EGLDisplay display, EGLenum objectType, EGLObjectKHR object, EGLLabelKHR label);
+} __EGLdispatchTableStatic;
+
 /*!
  * This structure stores required and optional vendor library callbacks.
  */
@@ -412,6 +489,195 @@ typedef struct __EGLapiImportsRec {
      * \return Either a platform type enum or EGL_NONE.
      */
     EGLenum (* findNativeDisplayPlatform) (void *native_display);
+
+    /*!
+     * (OPTIONAL) Called by libglvnd to request that a vendor library point
+     * some of the top-level entrypoints directly at its own functions.
+     *
+     * This is a thread-safe alternative to \c isPatchSupported and
+     * \c initiatePatch. The vendor library calls \p setStubTarget for each
+     * function that it wants to patch, and libglvnd takes care of rewriting
+     * the entrypoints. Because of that, libglvnd can patch the entrypoints
+     * even if other threads have a current context, as long as all of those
+     * contexts belong to the same vendor. If another vendor's context becomes
+     * current later, then libglvnd will restore the entrypoints and call
+     * \c releasePatch.
+     *
+     * If a vendor library provides this function, then libglvnd will use it
+     * instead of \c isPatchSupported and \c initiatePatch.
+     *
+     * Like \c initiatePatch, this function may be called more than once to
+     * patch multiple sets of entrypoints.
+     *
+     * This function is only available if the ABI version is 0.2 or later.
+     *
+     * \param setStubTarget A callback into libglvnd to change each
+     * entrypoint.
+     * \return GL_TRUE if the vendor library patched any entrypoints.
+     */
+    GLboolean (*initiatePatchTargets)(DispatchPatchSetStubTarget setStubTarget);
+
+    /*
+     * By default, libEGL uses a single OpenGL dispatch table for every context
+     * from a vendor library. The getContextDispatchVariant and
+     * getVariantProcAddress callbacks let a vendor library use a different
+     * dispatch table for some contexts instead, such as a table for GLES
+     * contexts that skips any desktop GL validation.
+     *
+     * A vendor library must provide both of these functions, or neither.
+     *
+     * These functions are only available if the ABI version is 0.3 or later.
+     */
+
+    /*!
+     * (OPTIONAL) Returns the dispatch table variant to use for a context.
+     *
+     * libEGL calls this from eglMakeCurrent, before it calls the vendor's
+     * eglMakeCurrent function. Every context that returns the same variant
+     * shares the same dispatch table.
+     *
+     * \param dpy The EGLDisplay that \p context belongs to.
+     * \param context The context that's about to become current.
+     * \return The variant, from 0 to \c __EGL_DISPATCH_VARIANT_COUNT - 1. Zero
+     * means the default dispatch table.
+     */
+    int (* getContextDispatchVariant) (EGLDisplay dpy, EGLContext context);
+
+    /*!
+     * (OPTIONAL) Looks up an OpenGL function for a dispatch table variant.
+     *
+     * This works the same way as \c getProcAddress, except that it's used to
+     * fill in the dispatch table for \p variant. libEGL only calls it for
+     * OpenGL functions, not for EGL functions.
+     *
+     * Note that if the vendor library also patches the entrypoints, then the
+     * patched entrypoints are used instead of any dispatch table.
+     *
+     * \param variant The variant, from 1 to
+     * \c __EGL_DISPATCH_VARIANT_COUNT - 1.
+     * \param procName The name of the function.
+     * \return A pointer to a function, or \c NULL if the vendor does not
+     * support the function.
+     */
+    void * (* getVariantProcAddress) (int variant, const char *procName);
+
+    /*!
+     * (OPTIONAL) Looks up several OpenGL functions at once.
+     *
+     * If a vendor library provides this, then libEGL uses it to fill in the
+     * vendor's default dispatch table. That lets the vendor look up a whole
+     * batch of functions at once, instead of getting a separate
+     * \c getProcAddress call for each one.
+     *
+     * It's only called for OpenGL functions, not for EGL functions.
+     *
+     * This function is only available if the ABI version is 0.4 or later.
+     *
+     * \param procNames An array of function names.
+     * \param[out] procs Returns the address of each function, or \c NULL for
+     * any function that the vendor does not support. The array is
+     * zero-filled before the call.
+     * \param count The number of elements in \p procNames and \p procs.
+     */
+    void (* getProcAddressBulk) (const char * const *procNames, void **procs, int count);
+
+    /*!
+     * (OPTIONAL) Notifies the vendor library of the dispatch table indices
+     * for several EGL functions at once.
+     *
+     * The indices are contiguous, so \p procNames is a compact table of
+     * names: \c procNames[i] is assigned the index \c first + \c i. The
+     * array is only valid during the call, so a vendor library that wants to
+     * keep it has to copy it.
+     *
+     * If a vendor library provides this, then libEGL uses it instead of
+     * \c setDispatchIndex when it has more than one index to report, such
+     * as when it first loads the vendor library.
+     *
+     * This function is only available if the ABI version is 0.5 or later.
+     *
+     * \param procNames An array of function names.
+     * \param first The index of \c procNames[0].
+     * \param count The number of elements in \p procNames.
+     */
+    void (* setDispatchIndexBulk) (const char * const *procNames, int first, int count);
+
+    /*!
+     * (OPTIONAL) Saves and releases the calling thread's current state, so
+     * that \c attachCurrent can restore it on another thread.
+     *
+     * libglvnd calls this from \c __glDispatchDetachCurrent, while one of
+     * the vendor's contexts is current. The context should stay current as
+     * far as the vendor library is concerned, but the calling thread should
+     * no longer refer to it.
+     *
+     * If a vendor library doesn't provide this and \c attachCurrent, then
+     * its contexts can't be moved between threads.
+     *
+     * This function is only available if the ABI version is 0.6 or later.
+     *
+     * \param[out] vendorState Returns an opaque pointer, which libglvnd
+     * passes to \c attachCurrent.
+     * \return True on success. On failure, the context stays current on
+     * the calling thread.
+     */
+    EGLBoolean (* detachCurrent) (void **vendorState);
+
+    /*!
+     * (OPTIONAL) Restores a current state that was saved with
+     * \c detachCurrent on the calling thread.
+     *
+     * The calling thread won't have a current context.
+     *
+     * This function is only available if the ABI version is 0.6 or later.
+     *
+     * \param vendorState The pointer that \c detachCurrent returned.
+     * \return True on success. On failure, libglvnd keeps the context
+     * detached, and might try again on another thread.
+     */
+    EGLBoolean (* attachCurrent) (void *vendorState);
+
+    /*!
+     * (OPTIONAL) Fills in all of the vendor library's static EGL functions at
+     * once.
+     *
+     * libglvnd calls this once, after \c __egl_Main returns, with a zeroed
+     * table. It then calls \c getProcAddress for any member that's still
+     * NULL, so a vendor library can leave out any function that it would
+     * rather look up by name.
+     *
+     * The vendor library must only write the members that exist in the ABI
+     * version that libglvnd passed to \c __egl_Main.
+     *
+     * This function is only available if the ABI version is 0.7 or later.
+     *
+     * \param[out] table The table to fill in.
+     */
+    void (* getStaticDispatch) (__EGLdispatchTableStatic *table);
+
+    /*!
+     * (OPTIONAL) Returns the vendor library's OpenGL functions in an array,
+     * in the same order as the static slots in libglvnd's dispatch table.
+     *
+     * If a vendor library provides this, then libglvnd copies the array into
+     * the vendor's dispatch table, instead of calling \c getProcAddress for
+     * each OpenGL function.
+     *
+     * The order of the static slots depends on how libglvnd was built, and
+     * it's identified by \p layoutHash. That's a 32-bit FNV-1a hash of the
+     * name of each function in slot order, with each name followed by a NUL
+     * byte. A vendor library should return NULL if it doesn't have an array
+     * in that order.
+     *
+     * This function is only available if the ABI version is 0.8 or later.
+     *
+     * \param layoutHash The layout hash of libglvnd's dispatch table.
+     * \param[out] count Returns the number of elements in the array.
+     * \return An array of functions, or NULL. A NULL element means that the
+     * vendor library doesn't support that function. The array must stay
+     * valid until the vendor library is unloaded.
+     */
+    const void * const *(* getGLStaticFuncs) (uint32_t layoutHash, int *count);
 } __EGLapiImports;
 
 /*****************************************************************************/
@@ -100,7 +100,7 @@ extern "C" {
  * will still work.
  */
 #define GLX_VENDOR_ABI_MAJOR_VERSION ((uint32_t) 1)
-#define GLX_VENDOR_ABI_MINOR_VERSION ((uint32_t) 0)
+#define GLX_VENDOR_ABI_MINOR_VERSION ((uint32_t) 7)
 #define GLX_VENDOR_ABI_VERSION ((GLX_VENDOR_ABI_MAJOR_VERSION << 16) | GLX_VENDOR_ABI_MINOR_VERSION)
 static inline uint32_t GLX_VENDOR_ABI_GET_MAJOR_VERSION(uint32_t version)
 {
@@ -228,8 +228,161 @@ typedef struct __GLXapiExportsRec {
      */
     __GLXvendorInfo * (*vendorFromDrawable)(Display *dpy, GLXDrawable drawable);
 
+    /*!
+     * Throws away any glXGetFBConfigs and glXChooseFBConfig results that
+     * libGLX has cached for a screen. See
+     * \c __GLXapiImports::isFBConfigCacheable.
+     *
+     * A vendor library must call this whenever the set of GLXFBConfigs that
+     * it would return for a screen changes.
+     *
+     * This function is only available if the ABI version is 1.7 or later.
+     *
+     * \param dpy The display connection.
+     * \param screen The screen number, or -1 for every screen.
+     */
+    void (*invalidateFBConfigCache)(Display *dpy, int screen);
+
 } __GLXapiExports;
 
+/*!
+ * This structure stores function pointers for all functions defined in GLX 1.4,
+ * plus a few extension functions that libGLX needs to dispatch itself.
+ *
+ * A vendor library can fill this in with \c __GLXapiImports::getStaticDispatch.
+ * New members will only be added at the end.
+ */
+typedef struct __GLXdispatchTableStaticRec {
+    XVisualInfo* (*chooseVisual)          (Display *dpy,
+                                           int screen,
+                                           int *attrib_list);
+
+    void         (*copyContext)           (Display *dpy,
+                                           GLXContext src,
+                                           GLXContext dst,
+                                           unsigned long mask);
+
+    GLXContext   (*createContext)         (Display *dpy,
+                                           XVisualInfo *vis,
+                                           GLXContext share_list,
+                                           Bool direct);
+
+    GLXPixmap    (*createGLXPixmap)       (Display *dpy,
+                                           XVisualInfo *vis,
+                                           Pixmap pixmap);
+
+    void         (*destroyContext)        (Display *dpy,
+                                           GLXContext ctx);
+
+    void         (*destroyGLXPixmap)      (Display *dpy,
+                                           GLXPixmap pix);
+
+    int          (*getConfig)             (Display *dpy,
+                                           XVisualInfo *vis,
+                                           int attrib,
+                                           int *value);
+
+    Bool         (*isDirect)              (Display *dpy,
+                                           GLXContext ctx);
+
+    Bool         (*makeCurrent)           (Display *dpy,
+                                           GLXDrawable drawable,
+                                           GLXContext ctx);
+
+    void         (*swapBuffers)           (Display *dpy,
+                                           GLXDrawable drawable);
+
+    void         (*useXFont)              (Font font,
+                                           int first,
+                                           int count,
+                                           int list_base);
+
+    void         (*waitGL)                (void);
+
+    void         (*waitX)                 (void);
+
+    const char*  (*queryServerString)     (Display *dpy,
+                                           int screen,
+                                           int name);
+
+    const char*  (*getClientString)     (Display *dpy,
+                                         int name);
+
+    const char*  (*queryExtensionsString) (Display *dpy,
+                                           int screen);
+
+    GLXFBConfig* (*chooseFBConfig)        (Display *dpy,
+                                           int screen,
+                                           const int *attrib_list,
+                                           int *nelements);
+
+    GLXContext   (*createNewContext)      (Display *dpy,
+                                           GLXFBConfig config,
+                                           int render_type,
+                                           GLXContext share_list,
+                                           Bool direct);
+
+    GLXPbuffer   (*createPbuffer)         (Display *dpy,
+                                           GLXFBConfig config,
+                                           const int *attrib_list);
+
+    GLXPixmap    (*createPixmap)          (Display *dpy,
+                                           GLXFBConfig config,
+                                           Pixmap pixmap,
+                                           const int *attrib_list);
+
+    GLXWindow    (*createWindow)          (Display *dpy,
+                                           GLXFBConfig config,
+                                           Window win,
+                                           const int *attrib_list);
+
+    void         (*destroyPbuffer)        (Display *dpy,
+                                           GLXPbuffer pbuf);
+
+    void         (*destroyPixmap)         (Display *dpy,
+                                           GLXPixmap pixmap);
+
+    void         (*destroyWindow)         (Display *dpy,
+                                           GLXWindow win);
+
+    int          (*getFBConfigAttrib)     (Display *dpy,
+                                           GLXFBConfig config,
+                                           int attribute,
+                                           int *value);
+
+    GLXFBConfig* (*getFBConfigs)          (Display *dpy,
+                                           int screen,
+                                           int *nelements);
+
+    void         (*getSelectedEvent)      (Display *dpy,
+                                           GLXDrawable draw,
+                                           unsigned long *event_mask);
+
+    XVisualInfo* (*getVisualFromFBConfig) (Display *dpy,
+                                           GLXFBConfig config);
+
+    Bool         (*makeContextCurrent)    (Display *dpy, GLXDrawable draw,
+                                           GLXDrawable read, GLXContext ctx);
+
+    int          (*queryContext)          (Display *dpy,
+                                           GLXContext ctx,
+                                           int attribute,
+                                           int *value);
+
+    void         (*queryDrawable)         (Display *dpy,
+                                           GLXDrawable draw,
+                                           int attribute,
+                                           unsigned int *value);
+
+    void         (*selectEvent)           (Display *dpy,
+                                           GLXDrawable draw,
+                                           unsigned long event_mask);
+
+    PFNGLXIMPORTCONTEXTEXTPROC importContextEXT;
+    PFNGLXFREECONTEXTEXTPROC freeContextEXT;
+    PFNGLXCREATECONTEXTATTRIBSARBPROC createContextAttribsARB;
+} __GLXdispatchTableStatic;
+
 /*****************************************************************************
  * API library imports                                                       *
  *****************************************************************************/
@@ -390,6 +543,173 @@ typedef struct __GLXapiImportsRec {
      */
     void (*patchThreadAttach)(void);
 
+    /*!
+     * (OPTIONAL) Called by libglvnd to request that a vendor library point
+     * some of the top-level entrypoints directly at its own functions.
+     *
+     * This is a thread-safe alternative to \c isPatchSupported and
+     * \c initiatePatch. The vendor library calls \p setStubTarget for each
+     * function that it wants to patch, and libglvnd takes care of rewriting
+     * the entrypoints. Because of that, libglvnd can patch the entrypoints
+     * even if other threads have a current context, as long as all of those
+     * contexts belong to the same vendor. If another vendor's context becomes
+     * current later, then libglvnd will restore the entrypoints and call
+     * \c releasePatch.
+     *
+     * If a vendor library provides this function, then libglvnd will use it
+     * instead of \c isPatchSupported and \c initiatePatch.
+     *
+     * Like \c initiatePatch, this function may be called more than once to
+     * patch multiple sets of entrypoints.
+     *
+     * This function is only available if the ABI version is 1.1 or later.
+     *
+     * \param setStubTarget A callback into libglvnd to change each
+     * entrypoint.
+     * \return GL_TRUE if the vendor library patched any entrypoints.
+     */
+    GLboolean (*initiatePatchTargets)(DispatchPatchSetStubTarget setStubTarget);
+
+    /*!
+     * (OPTIONAL) Returns the names of every GLX function that
+     * \c getDispatchAddress can return a dispatch function for.
+     *
+     * libglvnd calls this once, after \c __glx_Main returns, and uses the
+     * list to figure out which vendor to ask when an application calls
+     * glXGetProcAddress for a GLX extension function. Without it, libglvnd
+     * has to call \c getDispatchAddress and \c getProcAddress in every
+     * vendor library until one of them recognizes the name.
+     *
+     * The list doesn't have to be complete. libglvnd will still probe every
+     * vendor for a name that's not in any vendor's list.
+     *
+     * This function is only available if the ABI version is 1.2 or later.
+     *
+     * \return A NULL-terminated array of function names, or NULL. The array
+     * must stay valid until the vendor library is unloaded.
+     */
+    const char * const *(*getDispatchProcNames)(void);
+
+    /*!
+     * (OPTIONAL) Notifies the vendor library of the dispatch table indices
+     * for several GLX functions at once.
+     *
+     * The indices are contiguous, so \p procNames is a compact table of
+     * names: \c procNames[i] is assigned the index \c first + \c i. The
+     * array is only valid during the call, so a vendor library that wants to
+     * keep it has to copy it.
+     *
+     * If a vendor library provides this, then libGLX uses it instead of
+     * \c setDispatchIndex when it has more than one index to report, such
+     * as when it first loads the vendor library.
+     *
+     * This function is only available if the ABI version is 1.3 or later.
+     *
+     * \param procNames An array of function names.
+     * \param first The index of \c procNames[0].
+     * \param count The number of elements in \p procNames.
+     */
+    void (*setDispatchIndexBulk)(const GLubyte * const *procNames, int first, int count);
+
+    /*!
+     * (OPTIONAL) Saves and releases the calling thread's current state, so
+     * that \c attachCurrent can restore it on another thread.
+     *
+     * libglvnd calls this from \c __glDispatchDetachCurrent, while one of
+     * the vendor's contexts is current. The context should stay current as
+     * far as the vendor library is concerned, but the calling thread should
+     * no longer refer to it.
+     *
+     * If a vendor library doesn't provide this and \c attachCurrent, then
+     * its contexts can't be moved between threads.
+     *
+     * This function is only available if the ABI version is 1.4 or later.
+     *
+     * \param[out] vendorState Returns an opaque pointer, which libglvnd
+     * passes to \c attachCurrent.
+     * \return True on success. On failure, the context stays current on
+     * the calling thread.
+     */
+    Bool (*detachCurrent)(void **vendorState);
+
+    /*!
+     * (OPTIONAL) Restores a current state that was saved with
+     * \c detachCurrent on the calling thread.
+     *
+     * The calling thread won't have a current context.
+     *
+     * This function is only available if the ABI version is 1.4 or later.
+     *
+     * \param vendorState The pointer that \c detachCurrent returned.
+     * \return True on success. On failure, libglvnd keeps the context
+     * detached, and might try again on another thread.
+     */
+    Bool (*attachCurrent)(void *vendorState);
+
+    /*!
+     * (OPTIONAL) Fills in all of the vendor library's static GLX functions at
+     * once.
+     *
+     * libglvnd calls this once, after \c __glx_Main returns, with a zeroed
+     * table. It then calls \c getProcAddress for any member that's still
+     * NULL, so a vendor library can leave out any function that it would
+     * rather look up by name.
+     *
+     * The vendor library must only write the members that exist in the ABI
+     * version that libglvnd passed to \c __glx_Main.
+     *
+     * This function is only available if the ABI version is 1.5 or later.
+     *
+     * \param[out] table The table to fill in.
+     */
+    void (*getStaticDispatch)(__GLXdispatchTableStatic *table);
+
+    /*!
+     * (OPTIONAL) Returns the vendor library's OpenGL functions in an array,
+     * in the same order as the static slots in libglvnd's dispatch table.
+     *
+     * If a vendor library provides this, then libglvnd copies the array into
+     * the vendor's dispatch table, instead of calling \c getProcAddress for
+     * each OpenGL function.
+     *
+     * The order of the static slots depends on how libglvnd was built, and
+     * it's identified by \p layoutHash. That's a 32-bit FNV-1a hash of the
+     * name of each function in slot order, with each name followed by a NUL
+     * byte. A vendor library should return NULL if it doesn't have an array
+     * in that order.
+     *
+     * This function is only available if the ABI version is 1.6 or later.
+     *
+     * \param layoutHash The layout hash of libglvnd's dispatch table.
+     * \param[out] count Returns the number of elements in the array.
+     * \return An array of functions, or NULL. A NULL element means that the
+     * vendor library doesn't support that function. The array must stay
+     * valid until the vendor library is unloaded.
+     */
+    const void * const *(*getGLStaticFuncs)(uint32_t layoutHash, int *count);
+
+    /*!
+     * (OPTIONAL) Checks whether libGLX can cache the results of
+     * glXGetFBConfigs and glXChooseFBConfig for a screen.
+     *
+     * If this returns True, then libGLX remembers the configs that the vendor
+     * library returned for each attribute list, and answers a later call with
+     * the same display, screen, and attributes with a copy of them, without
+     * calling into the vendor library.
+     *
+     * A vendor library that says yes must call
+     * \c __GLXapiExports::invalidateFBConfigCache if the configs for that
+     * screen ever change. libGLX also drops the cached results for a display
+     * if the vendor calls \c removeVendorFBConfigMapping.
+     *
+     * This function is only available if the ABI version is 1.7 or later.
+     *
+     * \param dpy The display connection.
+     * \param screen The screen number.
+     * \return True if libGLX can cache the configs for the screen.
+     */
+    Bool (*isFBConfigCacheable)(Display *dpy, int screen);
+
 } __GLXapiImports;
 
 /*****************************************************************************/
@@ -41,6 +41,11 @@
 #endif
 
 #include "glvnd_pthread.h"
+#include "glvnd_fork.h"
+#include "glvnd_exit.h"
+#include "proc_address_cache.h"
+#include "glvnd_hashmap.h"
+#include "glvnd_memstats.h"
 #include "libeglabipriv.h"
 #include "libeglmapping.h"
 #include "libeglcurrent.h"
@@ -48,10 +53,12 @@
 #include "utils_misc.h"
 #include "trace.h"
 #include "egldispatchstubs.h"
+#include "g_egldispatchstubs.h"
 #include "compiler.h"
 #include "utils_misc.h"
 
-#include "lkdhash.h"
+#include "glvnd_atomic.h"
+#include "glvnd/glvnd.h"
 
 #if !defined(HAVE_RTLD_NOLOAD)
 #define RTLD_NOLOAD 0
@@ -109,8 +116,14 @@ static const struct {
    { EGL_NONE, NULL }
 };
 
-static char *clientExtensionString = NULL;
-glvnd_mutex_t clientExtensionStringMutex = GLVND_MUTEX_INITIALIZER;
+/*!
+ * The client extension string. This is built the first time it's needed, and
+ * then published with a release store, so later calls to eglQueryString don't
+ * need a lock. Every vendor is already loaded by then, so the string doesn't
+ * change after that.
+ */
+static char * volatile clientExtensionString = NULL;
+static glvnd_mutex_t clientExtensionStringMutex = GLVND_MUTEX_INITIALIZER;
 
 void __eglEntrypointCommon(void)
 {
@@ -118,6 +131,25 @@ void __eglEntrypointCommon(void)
     __eglSetError(EGL_SUCCESS);
 }
 
+/*
+ * A cheaper version of __eglEntrypointCommon for the functions that only read
+ * the current thread's state, which some applications call on every frame.
+ *
+ * A thread with a current context already went through
+ * __glDispatchCheckMultithreaded in eglMakeCurrent, and the patch callbacks
+ * can't change while it's current, so this only calls it for a thread that
+ * doesn't have a current context. The fork check is still needed, since a
+ * fork resets the current state.
+ */
+static void CurrentStateEntrypointCommon(void)
+{
+    glvndCheckFork();
+    if (__eglGetCurrentAPIState() == NULL) {
+        __glDispatchCheckMultithreaded();
+    }
+    __eglSetError(EGL_SUCCESS);
+}
+
 static EGLBoolean _eglPointerIsDereferencable(void *p)
 {
 #if defined(HAVE_MINCORE)
@@ -162,7 +194,44 @@ static void *SafeDereference(void *ptr)
     return NULL;
 }
 
-static EGLBoolean IsGbmDisplay(void *native_display)
+/*!
+ * A cache of the platforms that GuessPlatformType found for each native
+ * display, so that repeated eglGetDisplay calls with the same handle don't
+ * have to go through dladdr and dlopen again.
+ *
+ * Each entry also records the value that identified the platform: the first
+ * pointer in the native display for GBM and Wayland, or the resource_alloc
+ * pointer for X11. A cached entry is only used if that value still matches, so
+ * that a native display that gets freed and replaced with a different kind of
+ * display at the same address doesn't use a stale platform.
+ */
+typedef struct __EGLnativePlatformHashRec {
+    EGLenum platform;
+    void *tag;
+} __EGLnativePlatformHash;
+
+/*!
+ * A map of native displays to __EGLnativePlatformHash entries. The entries
+ * are never modified once they're added, so that a reader can't see a
+ * platform and tag from two different updates.
+ */
+static __GLVNDhashMap __eglNativePlatformHash = GLVND_HASHMAP_INITIALIZER(free);
+
+/*!
+ * The maximum number of entries in __eglNativePlatformHash. If an app goes
+ * through more native displays than this, then we just start over.
+ */
+#define NATIVE_PLATFORM_HASH_MAX_COUNT 64
+
+#if defined(USE_X11)
+/*!
+ * The address of _XAllocID, once we've found it. libX11 can't be unloaded
+ * while there's a Display open, so it's safe to hold on to this.
+ */
+static void * volatile cachedXAllocID = NULL;
+#endif
+
+static EGLBoolean IsGbmDisplay(void *native_display, void **tag)
 {
     void *first_pointer = SafeDereference(native_display);
     Dl_info info;
@@ -175,34 +244,55 @@ static EGLBoolean IsGbmDisplay(void *native_display)
         return EGL_FALSE;
     }
 
-    return !strcmp(info.dli_sname, "gbm_create_device");
+    if (strcmp(info.dli_sname, "gbm_create_device") != 0) {
+        return EGL_FALSE;
+    }
+    *tag = first_pointer;
+    return EGL_TRUE;
+}
+
+#if defined(USE_X11)
+static void *GetXAllocID(void)
+{
+    void *XAllocID = glvndAtomicLoadAcquirePtr(&cachedXAllocID);
+
+    if (XAllocID == NULL) {
+        void *handle = dlopen("libX11.so.6", RTLD_LOCAL | RTLD_LAZY | RTLD_NOLOAD);
+        if (handle != NULL) {
+            XAllocID = dlsym(handle, "_XAllocID");
+            dlclose(handle);
+        }
+        if (XAllocID != NULL) {
+            glvndAtomicStoreReleasePtr(&cachedXAllocID, XAllocID);
+        }
+    }
+    return XAllocID;
 }
+#endif // defined(USE_X11)
 
-static EGLBoolean IsX11Display(void *dpy)
+static EGLBoolean IsX11Display(void *dpy, void **tag)
 {
 #if defined(USE_X11)
     void *alloc;
-    void *handle;
-    void *XAllocID = NULL;
+    void *XAllocID;
 
     alloc = SafeDereference(&((_XPrivDisplay)dpy)->resource_alloc);
     if (alloc == NULL) {
         return EGL_FALSE;
     }
 
-    handle = dlopen("libX11.so.6", RTLD_LOCAL | RTLD_LAZY | RTLD_NOLOAD);
-    if (handle != NULL) {
-        XAllocID = dlsym(handle, "_XAllocID");
-        dlclose(handle);
+    XAllocID = GetXAllocID();
+    if (XAllocID == NULL || XAllocID != alloc) {
+        return EGL_FALSE;
     }
-
-    return (XAllocID != NULL && XAllocID == alloc);
+    *tag = alloc;
+    return EGL_TRUE;
 #else // defined(USE_X11)
     return EGL_FALSE;
 #endif // defined(USE_X11)
 }
 
-static EGLBoolean IsWaylandDisplay(void *native_display)
+static EGLBoolean IsWaylandDisplay(void *native_display, void **tag)
 {
     void *first_pointer = SafeDereference(native_display);
     Dl_info info;
@@ -215,7 +305,71 @@ static EGLBoolean IsWaylandDisplay(void *native_display)
         return EGL_FALSE;
     }
 
-    return !strcmp(info.dli_sname, "wl_display_interface");
+    if (strcmp(info.dli_sname, "wl_display_interface") != 0) {
+        return EGL_FALSE;
+    }
+    *tag = first_pointer;
+    return EGL_TRUE;
+}
+
+/*!
+ * Reads the value that identifies the platform of a native display, as
+ * recorded in a \c __EGLnativePlatformHash entry.
+ */
+static void *GetNativePlatformTag(void *native_display, EGLenum platform)
+{
+#if defined(USE_X11)
+    if (platform == EGL_PLATFORM_X11_KHR) {
+        return SafeDereference(&((_XPrivDisplay)native_display)->resource_alloc);
+    }
+#endif
+    // The app gave us a valid GBM or Wayland display last time, so reading
+    // the first pointer is safe if it's still valid now.
+    return *((void **) native_display);
+}
+
+static EGLenum LookupCachedPlatform(void *native_display)
+{
+    __EGLnativePlatformHash *entry;
+    EGLenum platform = EGL_NONE;
+    void *tag = NULL;
+
+    __glvndHashMapReadBegin();
+    entry = (__EGLnativePlatformHash *) __glvndHashMapFind(&__eglNativePlatformHash,
+            &native_display, sizeof(native_display));
+    if (entry != NULL) {
+        platform = entry->platform;
+        tag = entry->tag;
+    }
+    __glvndHashMapReadEnd();
+
+    if (platform != EGL_NONE && GetNativePlatformTag(native_display, platform) != tag) {
+        platform = EGL_NONE;
+    }
+    return platform;
+}
+
+static void AddCachedPlatform(void *native_display, EGLenum platform, void *tag)
+{
+    __EGLnativePlatformHash *entry;
+
+    if (__glvndHashMapCount(&__eglNativePlatformHash) >= NATIVE_PLATFORM_HASH_MAX_COUNT) {
+        __glvndHashMapClear(&__eglNativePlatformHash);
+    }
+
+    entry = malloc(sizeof(__EGLnativePlatformHash));
+    if (entry == NULL) {
+        return;
+    }
+    entry->platform = platform;
+    entry->tag = tag;
+
+    __glvndHashMapLock(&__eglNativePlatformHash, &native_display, sizeof(native_display));
+    if (!__glvndHashMapReplace(&__eglNativePlatformHash, &native_display,
+                sizeof(native_display), entry)) {
+        free(entry);
+    }
+    __glvndHashMapUnlock(&__eglNativePlatformHash, &native_display, sizeof(native_display));
 }
 
 /*!
@@ -227,13 +381,24 @@ static EGLenum GuessPlatformType(EGLNativeDisplayType display_id)
     EGLBoolean gbmSupported = EGL_FALSE;
     EGLBoolean waylandSupported = EGL_FALSE;
     EGLBoolean x11Supported = EGL_FALSE;
-    struct glvnd_list *vendorList = __eglLoadVendors();
+    struct glvnd_list *vendorList;
     __EGLvendorInfo *vendor;
+    EGLenum platform;
+    void *tag = NULL;
+
+    // If we've already identified this display, then we don't need to go
+    // through the rest of the checks again.
+    platform = LookupCachedPlatform((void *) display_id);
+    if (platform != EGL_NONE) {
+        return platform;
+    }
+
+    vendorList = __eglLoadVendors();
 
     // First, see if any of the vendor libraries can identify the display.
     glvnd_list_for_each_entry(vendor, vendorList, entry) {
         if (vendor->eglvc.findNativeDisplayPlatform != NULL) {
-            EGLenum platform = vendor->eglvc.findNativeDisplayPlatform((void *) display_id);
+            platform = vendor->eglvc.findNativeDisplayPlatform((void *) display_id);
             if (platform != EGL_NONE) {
                 return platform;
             }
@@ -258,29 +423,233 @@ static EGLenum GuessPlatformType(EGLNativeDisplayType display_id)
         }
     }
 
-    if (gbmSupported && IsGbmDisplay(display_id)) {
-        return EGL_PLATFORM_GBM_KHR;
+    if (gbmSupported && IsGbmDisplay(display_id, &tag)) {
+        platform = EGL_PLATFORM_GBM_KHR;
+    } else if (waylandSupported && IsWaylandDisplay(display_id, &tag)) {
+        platform = EGL_PLATFORM_WAYLAND_KHR;
+    } else if (x11Supported && IsX11Display(display_id, &tag)) {
+        platform = EGL_PLATFORM_X11_KHR;
+    } else {
+        return EGL_NONE;
+    }
+
+    AddCachedPlatform((void *) display_id, platform, tag);
+    return platform;
+};
+
+/*!
+ * Remembers which vendor returned a display for each platform, so that the
+ * next eglGetPlatformDisplay call can try that vendor first instead of
+ * probing every vendor ahead of it.
+ *
+ * EGL_DEFAULT_DISPLAY is tracked separately from other native displays, since
+ * a vendor that can't create a default display might still handle an
+ * explicit one, or vice versa.
+ *
+ * Note that this can change which vendor gets a display if a vendor that
+ * failed the first time would succeed on a later call. In practice, a vendor
+ * that can't handle a platform keeps failing.
+ */
+typedef struct __EGLplatformVendorRec {
+    EGLenum platform;
+    EGLBoolean isDefault;
+    __EGLvendorInfo *vendor;
+} __EGLplatformVendor;
+
+#define PLATFORM_VENDOR_MAX_COUNT 16
+
+static __EGLplatformVendor platformVendors[PLATFORM_VENDOR_MAX_COUNT];
+static int platformVendorCount = 0;
+static glvnd_mutex_t platformVendorMutex = GLVND_MUTEX_INITIALIZER;
+
+static __EGLvendorInfo *LookupPlatformVendor(EGLenum platform, void *native_display)
+{
+    EGLBoolean isDefault = (native_display == (void *) EGL_DEFAULT_DISPLAY);
+    __EGLvendorInfo *vendor = NULL;
+    int i;
+
+    __glvndPthreadFuncs.mutex_lock(&platformVendorMutex);
+    for (i=0; i<platformVendorCount; i++) {
+        if (platformVendors[i].platform == platform
+                && platformVendors[i].isDefault == isDefault) {
+            vendor = platformVendors[i].vendor;
+            break;
+        }
     }
-    if (waylandSupported && IsWaylandDisplay(display_id)) {
-        return EGL_PLATFORM_WAYLAND_KHR;
+    __glvndPthreadFuncs.mutex_unlock(&platformVendorMutex);
+
+    return vendor;
+}
+
+static void SetPlatformVendor(EGLenum platform, void *native_display, __EGLvendorInfo *vendor)
+{
+    EGLBoolean isDefault = (native_display == (void *) EGL_DEFAULT_DISPLAY);
+    int i;
+
+    __glvndPthreadFuncs.mutex_lock(&platformVendorMutex);
+    for (i=0; i<platformVendorCount; i++) {
+        if (platformVendors[i].platform == platform
+                && platformVendors[i].isDefault == isDefault) {
+            break;
+        }
     }
-    if (x11Supported && IsX11Display(display_id)) {
-        return EGL_PLATFORM_X11_KHR;
+    if (i < PLATFORM_VENDOR_MAX_COUNT) {
+        platformVendors[i].platform = platform;
+        platformVendors[i].isDefault = isDefault;
+        platformVendors[i].vendor = vendor;
+        if (i == platformVendorCount) {
+            platformVendorCount++;
+        }
     }
+    __glvndPthreadFuncs.mutex_unlock(&platformVendorMutex);
+}
 
-    return EGL_NONE;
-};
+/*!
+ * Remembers the EGLDisplay handles that eglGetPlatformDisplay returned, keyed
+ * by the platform, native display, and attribute list. Calling
+ * eglGetPlatformDisplay again with the same arguments has to return the same
+ * display anyway, so a hit skips the vendors altogether.
+ *
+ * Each entry records the display generation (see __eglGetDisplayGeneration)
+ * from when it was added, so removing a display invalidates everything.
+ *
+ * Attribute lists with more than DISPLAY_CACHE_MAX_ATTRIBS pairs aren't
+ * cached, and neither are displays with EGL_TRACK_REFERENCES_KHR, since the
+ * vendor has to count each call.
+ */
+#define DISPLAY_CACHE_MAX_COUNT 16
+#define DISPLAY_CACHE_MAX_ATTRIBS 8
+
+typedef struct __EGLdisplayCacheEntryRec {
+    EGLenum platform;
+    void *native_display;
+    int attribCount;
+    EGLAttrib attribs[DISPLAY_CACHE_MAX_ATTRIBS * 2];
+    EGLDisplay dpy;
+    int generation;
+} __EGLdisplayCacheEntry;
+
+static __EGLdisplayCacheEntry displayCache[DISPLAY_CACHE_MAX_COUNT];
+static int displayCacheCount = 0;
+static int displayCacheNext = 0;
+static glvnd_mutex_t displayCacheMutex = GLVND_MUTEX_INITIALIZER;
 
-static EGLDisplay GetPlatformDisplayCommon(EGLenum platform,
+/*!
+ * Returns the number of attribute pairs in \p attrib_list, or -1 if the
+ * display shouldn't be cached.
+ */
+static int GetCacheableAttribCount(const EGLAttrib *attrib_list)
+{
+    int count = 0;
+
+    if (attrib_list == NULL) {
+        return 0;
+    }
+    while (attrib_list[count * 2] != EGL_NONE) {
+        if (count >= DISPLAY_CACHE_MAX_ATTRIBS) {
+            return -1;
+        }
+        if (attrib_list[count * 2] == EGL_TRACK_REFERENCES_KHR
+                && attrib_list[count * 2 + 1] != EGL_FALSE) {
+            return -1;
+        }
+        count++;
+    }
+    return count;
+}
+
+static EGLDisplay LookupCachedDisplay(EGLenum platform, void *native_display,
+        const EGLAttrib *attrib_list, int attribCount)
+{
+    EGLDisplay dpy = EGL_NO_DISPLAY;
+    int generation = __eglGetDisplayGeneration();
+    int i;
+
+    __glvndPthreadFuncs.mutex_lock(&displayCacheMutex);
+    for (i=0; i<displayCacheCount; i++) {
+        __EGLdisplayCacheEntry *entry = &displayCache[i];
+        if (entry->generation == generation
+                && entry->platform == platform
+                && entry->native_display == native_display
+                && entry->attribCount == attribCount
+                && (attribCount == 0 || memcmp(entry->attribs, attrib_list,
+                        attribCount * 2 * sizeof(EGLAttrib)) == 0)) {
+            dpy = entry->dpy;
+            break;
+        }
+    }
+    __glvndPthreadFuncs.mutex_unlock(&displayCacheMutex);
+
+    return dpy;
+}
+
+static void AddCachedDisplay(EGLenum platform, void *native_display,
+        const EGLAttrib *attrib_list, int attribCount, EGLDisplay dpy,
+        int generation)
+{
+    __EGLdisplayCacheEntry *entry;
+
+    __glvndPthreadFuncs.mutex_lock(&displayCacheMutex);
+    if (displayCacheCount < DISPLAY_CACHE_MAX_COUNT) {
+        entry = &displayCache[displayCacheCount++];
+    } else {
+        entry = &displayCache[displayCacheNext];
+        displayCacheNext = (displayCacheNext + 1) % DISPLAY_CACHE_MAX_COUNT;
+    }
+    entry->platform = platform;
+    entry->native_display = native_display;
+    entry->attribCount = attribCount;
+    if (attribCount > 0) {
+        memcpy(entry->attribs, attrib_list, attribCount * 2 * sizeof(EGLAttrib));
+    }
+    entry->dpy = dpy;
+    entry->generation = generation;
+    __glvndPthreadFuncs.mutex_unlock(&displayCacheMutex);
+}
+
+/*!
+ * Returns true if \p vendor should be tried on pass \p pass of
+ * GetPlatformDisplayInternal.
+ *
+ * The first pass only tries the vendor that succeeded last time, the second
+ * tries any vendors that list \p platform as preferred in their config files,
+ * and the last tries everything else. Each pass goes in priority order.
+ */
+static EGLBoolean IsVendorInPass(__EGLvendorInfo *vendor, int pass,
+        __EGLvendorInfo *lastVendor, EGLenum platform)
+{
+    if (pass == 0) {
+        return (vendor == lastVendor);
+    } else if (vendor == lastVendor) {
+        return EGL_FALSE;
+    } else if (pass == 1) {
+        return __eglVendorPrefersPlatform(vendor, platform);
+    } else {
+        return !__eglVendorPrefersPlatform(vendor, platform);
+    }
+}
+
+static EGLDisplay GetPlatformDisplayInternal(EGLenum platform,
         void *native_display, const EGLAttrib *attrib_list,
-        const char *funcName)
+        const char *funcName, uint64_t *vendorNS)
 {
     __EGLdisplayInfo *dpyInfo = NULL;
     EGLint errorCode = EGL_SUCCESS;
     EGLBoolean anyVendorSuccess = EGL_FALSE;
     struct glvnd_list *vendorList;
+    int attribCount = GetCacheableAttribCount(attrib_list);
+    int generation = __eglGetDisplayGeneration();
 
-    vendorList = __eglLoadVendors();
+    if (attribCount >= 0) {
+        EGLDisplay dpy = LookupCachedDisplay(platform, native_display,
+                attrib_list, attribCount);
+        if (dpy != EGL_NO_DISPLAY) {
+            __eglSetError(EGL_SUCCESS);
+            return dpy;
+        }
+    }
+
+    vendorList = __eglLoadVendorsForPlatform(platform);
     if (glvnd_list_is_empty(vendorList)) {
         // If there are no vendor libraries, then no platforms are supported.
         __eglReportError(EGL_BAD_PARAMETER, funcName, __eglGetThreadLabel(),
@@ -294,13 +663,16 @@ static EGLDisplay GetPlatformDisplayCommon(EGLenum platform,
         EGLDisplay dpy;
 
         __EGLvendorInfo *vendor = __eglGetVendorFromDevice(dev);
+        uint64_t vendorStart;
         if (vendor == NULL) {
             __eglReportError(EGL_BAD_PARAMETER, funcName, __eglGetThreadLabel(),
                     "Invalid EGLDevice handle %p", dev);
             return EGL_NO_DISPLAY;
         }
 
+        vendorStart = __glDispatchWinsysTimeBegin();
         dpy = vendor->eglvc.getPlatformDisplay(platform, native_display, attrib_list);
+        *vendorNS += __glDispatchWinsysTimeSince(vendorStart);
         if (dpy == EGL_NO_DISPLAY) {
             return EGL_NO_DISPLAY;
         }
@@ -323,24 +695,47 @@ static EGLDisplay GetPlatformDisplayCommon(EGLenum platform,
     // succeed. Maybe just require vendors to only use WARN or INFO level
     // messages, and then report an error later on based on the error code?
     if (dpyInfo == NULL) {
+        __EGLvendorInfo *lastVendor = LookupPlatformVendor(platform, native_display);
         __EGLvendorInfo *vendor;
-        glvnd_list_for_each_entry(vendor, vendorList, entry) {
-            EGLDisplay dpy = vendor->eglvc.getPlatformDisplay(platform, native_display, attrib_list);
-            if (dpy != EGL_NO_DISPLAY) {
-                dpyInfo = __eglAddDisplay(dpy, vendor);
-                break;
-            } else {
-                EGLint vendorError = vendor->staticDispatch.getError();
-                if (vendorError == EGL_SUCCESS) {
-                    anyVendorSuccess = EGL_TRUE;
-                } else if (errorCode == EGL_SUCCESS) {
-                    errorCode = vendorError;
-               }
+        EGLBoolean found = EGL_FALSE;
+        int pass;
+
+        for (pass=0; pass<3 && !found; pass++) {
+            glvnd_list_for_each_entry(vendor, vendorList, entry) {
+                EGLDisplay dpy;
+                uint64_t vendorStart;
+
+                if (!IsVendorInPass(vendor, pass, lastVendor, platform)) {
+                    continue;
+                }
+
+                vendorStart = __glDispatchWinsysTimeBegin();
+                dpy = vendor->eglvc.getPlatformDisplay(platform, native_display, attrib_list);
+                *vendorNS += __glDispatchWinsysTimeSince(vendorStart);
+                if (dpy != EGL_NO_DISPLAY) {
+                    dpyInfo = __eglAddDisplay(dpy, vendor);
+                    if (vendor != lastVendor) {
+                        SetPlatformVendor(platform, native_display, vendor);
+                    }
+                    found = EGL_TRUE;
+                    break;
+                } else {
+                    EGLint vendorError = vendor->staticDispatch.getError();
+                    if (vendorError == EGL_SUCCESS) {
+                        anyVendorSuccess = EGL_TRUE;
+                    } else if (errorCode == EGL_SUCCESS) {
+                        errorCode = vendorError;
+                   }
+                }
             }
         }
     }
     if (dpyInfo != NULL) {
         // We got a valid EGLDisplay, so the function succeeded.
+        if (attribCount >= 0) {
+            AddCachedDisplay(platform, native_display, attrib_list,
+                    attribCount, dpyInfo->dpy, generation);
+        }
         __eglSetError(EGL_SUCCESS);
         return dpyInfo->dpy;
     } else {
@@ -360,6 +755,28 @@ static EGLDisplay GetPlatformDisplayCommon(EGLenum platform,
     }
 }
 
+/*!
+ * Looks up or creates an EGLDisplay for eglGetDisplay, eglGetPlatformDisplay,
+ * and eglGetPlatformDisplayEXT.
+ *
+ * All three are counted as eglGetPlatformDisplay for __GLVND_WINSYS_TIMES.
+ * Loading the vendor libraries the first time counts as libglvnd's time.
+ */
+static EGLDisplay GetPlatformDisplayCommon(EGLenum platform,
+        void *native_display, const EGLAttrib *attrib_list,
+        const char *funcName)
+{
+    uint64_t start = __glDispatchWinsysTimeBegin();
+    uint64_t vendorNS = 0;
+    EGLDisplay dpy;
+
+    dpy = GetPlatformDisplayInternal(platform, native_display, attrib_list,
+            funcName, &vendorNS);
+    __glDispatchWinsysTimeEnd(GLDISPATCH_WINSYS_EGL_GET_PLATFORM_DISPLAY,
+            start, vendorNS);
+    return dpy;
+}
+
 PUBLIC EGLDisplay EGLAPIENTRY eglGetDisplay(EGLNativeDisplayType display_id)
 {
     EGLenum platform = EGL_NONE;
@@ -368,7 +785,7 @@ PUBLIC EGLDisplay EGLAPIENTRY eglGetDisplay(EGLNativeDisplayType display_id)
     __eglEntrypointCommon();
 
     // First, see if the user specified a platform to use.
-    name = getenv("EGL_PLATFORM");
+    name = glvndGetEnv("EGL_PLATFORM");
     if (name != NULL && name[0] != '\x00') {
         int i;
 
@@ -497,44 +914,42 @@ PUBLIC EGLBoolean EGLAPIENTRY eglBindAPI(EGLenum api)
         return EGL_FALSE;
     }
 
-    // Note: We do not call into the vendor library here. The vendor is
-    // responsible for looking up the current API instead.
-
     state = __eglGetCurrentThreadAPIState(EGL_TRUE);
     if (state == NULL) {
         // Probably out of memory. Not much else we can do here.
         return EGL_FALSE;
     }
     state->currentClientApi = api;
-    glvnd_list_for_each_entry(vendor, vendorList, entry) {
-        if (vendor->staticDispatch.bindAPI != NULL) {
-            vendor->staticDispatch.bindAPI(api);
-        }
-    }
+
+    // Each vendor is told about the new API when it's next used on this
+    // thread, in __eglNotifyVendorAPI. The current vendor might be used
+    // without looking up a display, though, so tell it now.
+    state->apiNotifiedVendors = 0;
+    __eglNotifyVendorAPI(state, __eglGetCurrentVendor());
     return EGL_TRUE;
 }
 
 PUBLIC EGLenum EGLAPIENTRY eglQueryAPI(void)
 {
-    __eglEntrypointCommon();
+    CurrentStateEntrypointCommon();
     return __eglQueryAPI();
 }
 
 PUBLIC EGLDisplay EGLAPIENTRY eglGetCurrentDisplay(void)
 {
-    __eglEntrypointCommon();
+    CurrentStateEntrypointCommon();
     return __eglGetCurrentDisplay();
 }
 
 PUBLIC EGLContext EGLAPIENTRY eglGetCurrentContext(void)
 {
-    __eglEntrypointCommon();
+    CurrentStateEntrypointCommon();
     return __eglGetCurrentContext();
 }
 
 PUBLIC EGLSurface EGLAPIENTRY eglGetCurrentSurface(EGLint readdraw)
 {
-    __eglEntrypointCommon();
+    CurrentStateEntrypointCommon();
     if (readdraw != EGL_DRAW && readdraw != EGL_READ) {
         __eglReportError(EGL_BAD_PARAMETER, "eglGetCurrentSurface", __eglGetThreadLabel(),
                 "Invalid enum 0x%04x\n", readdraw);
@@ -542,9 +957,10 @@ PUBLIC EGLSurface EGLAPIENTRY eglGetCurrentSurface(EGLint readdraw)
     return __eglGetCurrentSurface(readdraw);
 }
 
-static EGLBoolean InternalLoseCurrent(void)
+static EGLBoolean InternalLoseCurrent(uint64_t *vendorNS)
 {
     __EGLdispatchThreadState *apiState = __eglGetCurrentAPIState();
+    uint64_t vendorStart;
     EGLBoolean ret;
 
     if (apiState == NULL) {
@@ -552,9 +968,11 @@ static EGLBoolean InternalLoseCurrent(void)
     }
 
     __eglSetLastVendor(apiState->currentVendor);
+    vendorStart = __glDispatchWinsysTimeBegin();
     ret = apiState->currentVendor->staticDispatch.makeCurrent(
             apiState->currentDisplay->dpy,
             EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    *vendorNS += __glDispatchWinsysTimeSince(vendorStart);
     if (!ret) {
         return EGL_FALSE;
     }
@@ -576,24 +994,30 @@ static EGLBoolean InternalLoseCurrent(void)
  *
  * If it fails, then it will leave \p apiState unmodified. It's up to the
  * vendor library to ensure that the old context is still current in that case.
+ *
+ * The time spent in the vendor library is added to \p vendorNS.
  */
 static EGLBoolean InternalMakeCurrentVendor(
         __EGLdisplayInfo *dpy, EGLSurface draw, EGLSurface read,
         EGLContext context,
         __EGLdispatchThreadState *apiState,
-        __EGLvendorInfo *vendor)
+        __EGLvendorInfo *vendor, uint64_t *vendorNS)
 {
+    uint64_t vendorStart;
     EGLBoolean ret;
 
     assert(apiState->currentVendor == vendor);
 
     __eglSetLastVendor(dpy->vendor);
+    vendorStart = __glDispatchWinsysTimeBegin();
     ret = dpy->vendor->staticDispatch.makeCurrent(dpy->dpy, draw, read, context);
+    *vendorNS += __glDispatchWinsysTimeSince(vendorStart);
     if (ret) {
         apiState->currentDisplay = dpy;
         apiState->currentDraw = draw;
         apiState->currentRead = read;
         apiState->currentContext = context;
+        __glDispatchSetCurrentInfo(dpy->dpy, context);
     }
 
     return ret;
@@ -612,9 +1036,10 @@ static EGLBoolean InternalMakeCurrentVendor(
 static EGLBoolean InternalMakeCurrentDispatch(
         __EGLdisplayInfo *dpy, EGLSurface draw, EGLSurface read,
         EGLContext context,
-        __EGLvendorInfo *vendor)
+        __EGLvendorInfo *vendor, uint64_t *vendorNS)
 {
     __EGLdispatchThreadState *apiState;
+    __GLdispatchTable *dispatch;
     EGLBoolean ret;
 
     assert(__eglGetCurrentAPIState() == NULL);
@@ -624,17 +1049,19 @@ static EGLBoolean InternalMakeCurrentDispatch(
         return EGL_FALSE;
     }
 
+    dispatch = __eglGetContextDispatchTable(vendor, dpy->dpy, context);
     ret = __glDispatchMakeCurrent(
         &apiState->glas,
-        vendor->glDispatch,
+        dispatch,
         vendor->vendorID,
         (vendor->patchSupported ? &vendor->patchCallbacks : NULL)
     );
 
     if (ret) {
         apiState->currentVendor = vendor;
+        apiState->currentDispatch = dispatch;
         ret = InternalMakeCurrentVendor(dpy, draw, read, context,
-                apiState, vendor);
+                apiState, vendor, vendorNS);
         if (!ret) {
             __glDispatchLoseCurrent();
         }
@@ -647,8 +1074,70 @@ static EGLBoolean InternalMakeCurrentDispatch(
     return ret;
 }
 
-PUBLIC EGLBoolean EGLAPIENTRY eglMakeCurrent(EGLDisplay dpy,
-        EGLSurface draw, EGLSurface read, EGLContext context)
+/**
+ * Switches from a current context with one vendor to a context with a
+ * different vendor.
+ *
+ * This releases the old vendor's context, and then uses
+ * \c __glDispatchSwitchCurrent to change the dispatch table, so that
+ * libGLdispatch doesn't have to go through an intermediate state with no
+ * current context.
+ *
+ * If this function fails after releasing the old context, then it will leave
+ * the thread with no current context, the same as InternalMakeCurrentDispatch.
+ */
+static EGLBoolean InternalSwitchCurrentDispatch(
+        __EGLdisplayInfo *dpy, EGLSurface draw, EGLSurface read,
+        EGLContext context,
+        __EGLdispatchThreadState *apiState,
+        __EGLvendorInfo *vendor, uint64_t *vendorNS)
+{
+    __GLdispatchTable *dispatch;
+    uint64_t vendorStart;
+    EGLBoolean ret;
+
+    __eglSetLastVendor(apiState->currentVendor);
+    vendorStart = __glDispatchWinsysTimeBegin();
+    ret = apiState->currentVendor->staticDispatch.makeCurrent(
+            apiState->currentDisplay->dpy,
+            EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    *vendorNS += __glDispatchWinsysTimeSince(vendorStart);
+    if (!ret) {
+        return EGL_FALSE;
+    }
+
+    dispatch = __eglGetContextDispatchTable(vendor, dpy->dpy, context);
+    ret = __glDispatchSwitchCurrent(
+        &apiState->glas,
+        dispatch,
+        vendor->vendorID,
+        (vendor->patchSupported ? &vendor->patchCallbacks : NULL)
+    );
+
+    if (ret) {
+        apiState->currentVendor = vendor;
+        apiState->currentDispatch = dispatch;
+        ret = InternalMakeCurrentVendor(dpy, draw, read, context,
+                apiState, vendor, vendorNS);
+        if (!ret) {
+            __glDispatchLoseCurrent();
+        }
+    }
+
+    if (!ret) {
+        __eglDestroyAPIState(apiState);
+    }
+
+    return ret;
+}
+
+/**
+ * Implements eglMakeCurrent. The time spent in the vendor libraries is added
+ * to \p vendorNS.
+ */
+static EGLBoolean MakeCurrentInternal(EGLDisplay dpy,
+        EGLSurface draw, EGLSurface read, EGLContext context,
+        uint64_t *vendorNS)
 {
     __GLdispatchThreadState *glas;
     __EGLdispatchThreadState *apiState;
@@ -662,7 +1151,16 @@ PUBLIC EGLBoolean EGLAPIENTRY eglMakeCurrent(EGLDisplay dpy,
 
     // According to the EGL spec, the display handle must be valid, even if
     // the context is NULL.
-    newDpy = __eglLookupDisplay(dpy);
+    //
+    // Most of the time, the display will be the same as the current one, so
+    // check that before looking it up in the hashtable.
+    apiState = __eglGetCurrentAPIState();
+    if (apiState != NULL && apiState->currentDisplay != NULL
+            && apiState->currentDisplay->dpy == dpy) {
+        newDpy = apiState->currentDisplay;
+    } else {
+        newDpy = __eglLookupDisplay(dpy);
+    }
     if (newDpy == NULL) {
         __eglReportError(EGL_BAD_DISPLAY, "eglMakeCurrent", NULL,
                 "Invalid display %p", dpy);
@@ -675,7 +1173,7 @@ PUBLIC EGLBoolean EGLAPIENTRY eglMakeCurrent(EGLDisplay dpy,
         return EGL_FALSE;
     }
 
-    glas = __glDispatchGetCurrentThreadState();
+    glas = __glDispatchGetCurrentThreadStateInline();
     if (glas != NULL) {
         if (glas->tag != GLDISPATCH_API_EGL) {
             // Another API (probably GLX) already has a current context. Just
@@ -726,25 +1224,45 @@ PUBLIC EGLBoolean EGLAPIENTRY eglMakeCurrent(EGLDisplay dpy,
     if (oldVendor == newVendor) {
         /*
          * We're switching between two contexts that use the same vendor. That
-         * means the dispatch table is also the same, which is the only thing
-         * that libGLdispatch cares about. Call into the vendor library to
-         * switch contexts, but don't call into libGLdispatch.
+         * means the dispatch table is usually the same, which is the only
+         * thing that libGLdispatch cares about. Call into the vendor library
+         * to switch contexts, and only call into libGLdispatch if the vendor
+         * picked a different dispatch table for the new context.
          */
+        __GLdispatchTable *dispatch = __eglGetContextDispatchTable(newVendor,
+                newDpy->dpy, context);
+
         ret = InternalMakeCurrentVendor(newDpy, draw, read, context,
-                apiState, newVendor);
+                apiState, newVendor, vendorNS);
+        if (ret && dispatch != apiState->currentDispatch) {
+            ret = __glDispatchSwitchCurrent(&apiState->glas, dispatch,
+                    newVendor->vendorID,
+                    (newVendor->patchSupported ? &newVendor->patchCallbacks : NULL));
+            if (ret) {
+                apiState->currentDispatch = dispatch;
+            } else {
+                // libGLdispatch has already dropped the old dispatch table,
+                // so release the context in the vendor library, too.
+                uint64_t vendorStart = __glDispatchWinsysTimeBegin();
+                newVendor->staticDispatch.makeCurrent(newDpy->dpy,
+                        EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+                *vendorNS += __glDispatchWinsysTimeSince(vendorStart);
+                __eglDestroyAPIState(apiState);
+            }
+        }
     } else if (newVendor == NULL) {
         /*
          * We have a current context and we're releasing it.
          */
         assert(context == EGL_NO_CONTEXT);
-        ret = InternalLoseCurrent();
+        ret = InternalLoseCurrent(vendorNS);
     } else if (oldVendor == NULL) {
         /*
          * We don't have a current context, so we only need to make the new one
          * current.
          */
         ret = InternalMakeCurrentDispatch(newDpy, draw, read, context,
-                newVendor);
+                newVendor, vendorNS);
     } else {
         /*
          * We're switching between contexts with different vendors.
@@ -755,35 +1273,211 @@ PUBLIC EGLBoolean EGLAPIENTRY eglMakeCurrent(EGLDisplay dpy,
          * all agree on what the current context is.
          *
          * To do that, we'll first release the current context, and then make
-         * the new context current.
+         * the new context current. libGLdispatch switches directly from the
+         * old dispatch table to the new one, without going through the
+         * no-context state in between.
+         */
+        uint64_t slowOpStart = __glDispatchSlowOpBegin();
+        ret = InternalSwitchCurrentDispatch(newDpy, draw, read, context,
+                apiState, newVendor, vendorNS);
+        __glDispatchSlowOpEnd(slowOpStart, "MakeCurrent (vendor switch)",
+                NULL, newVendor->vendorID);
+        /*
+         * Ideally, we should try to restore the old context if we fail,
+         * but we need to deal with the case where the old context was
+         * flagged for deletion, and thus is now deleted. We don't want to
+         * pass an invalid context to the vendor library.
+         *
+         * We could avoid that using a current context hashtable like GLX
+         * has. That would allow us to restore the old context when it
+         * still exists, but we'd still be left with no context if it was
+         * deleted.
+         *
+         * Note that GLX also needs that hashtable to keep its
+         * context-to-screen mapping up to date, but EGL doesn't need to
+         * keep track of contexts at all yet.
+         *
+         * Once we add support for OpenVG, though, then we'll need to keep
+         * track of data for every context, not just the current ones. At
+         * that point, we'll be able to use that to track context deletion
+         * as well.
          */
-        ret = InternalLoseCurrent();
-        if (ret) {
-            ret = InternalMakeCurrentDispatch(newDpy, draw, read, context,
-                    newVendor);
-            /*
-             * Ideally, we should try to restore the old context if we fail,
-             * but we need to deal with the case where the old context was
-             * flagged for deletion, and thus is now deleted. We don't want to
-             * pass an invalid context to the vendor library.
-             *
-             * We could avoid that using a current context hashtable like GLX
-             * has. That would allow us to restore the old context when it
-             * still exists, but we'd still be left with no context if it was
-             * deleted.
-             *
-             * Note that GLX also needs that hashtable to keep its
-             * context-to-screen mapping up to date, but EGL doesn't need to
-             * keep track of contexts at all yet.
-             *
-             * Once we add support for OpenVG, though, then we'll need to keep
-             * track of data for every context, not just the current ones. At
-             * that point, we'll be able to use that to track context deletion
-             * as well.
-             */
+    }
+
+    return ret;
+}
+
+PUBLIC EGLBoolean EGLAPIENTRY eglMakeCurrent(EGLDisplay dpy,
+        EGLSurface draw, EGLSurface read, EGLContext context)
+{
+    uint64_t start = __glDispatchWinsysTimeBegin();
+    uint64_t vendorNS = 0;
+    EGLBoolean ret;
+
+    ret = MakeCurrentInternal(dpy, draw, read, context, &vendorNS);
+    __glDispatchWinsysTimeEnd(GLDISPATCH_WINSYS_EGL_MAKE_CURRENT, start,
+            vendorNS);
+    return ret;
+}
+
+/*
+ * Takes the vendor's context off of the calling thread for
+ * eglPushCurrentGLVND. If the vendor can detach its current state, then that
+ * saves a full release and make current in the vendor library.
+ */
+static EGLBoolean SuspendVendorCurrent(__EGLdispatchThreadState *apiState)
+{
+    __EGLvendorInfo *vendor = apiState->currentVendor;
+
+    __eglSetLastVendor(vendor);
+    if (vendor->eglvc.detachCurrent != NULL && vendor->eglvc.attachCurrent != NULL) {
+        return vendor->eglvc.detachCurrent(&apiState->vendorState);
+    }
+    return vendor->staticDispatch.makeCurrent(apiState->currentDisplay->dpy,
+            EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+}
+
+/*
+ * Undoes SuspendVendorCurrent.
+ */
+static EGLBoolean ResumeVendorCurrent(__EGLdispatchThreadState *apiState)
+{
+    __EGLvendorInfo *vendor = apiState->currentVendor;
+
+    __eglSetLastVendor(vendor);
+    if (vendor->eglvc.detachCurrent != NULL && vendor->eglvc.attachCurrent != NULL) {
+        if (!vendor->eglvc.attachCurrent(apiState->vendorState)) {
+            return EGL_FALSE;
+        }
+        apiState->vendorState = NULL;
+        return EGL_TRUE;
+    }
+    return vendor->staticDispatch.makeCurrent(apiState->currentDisplay->dpy,
+            apiState->currentDraw, apiState->currentRead,
+            apiState->currentContext);
+}
+
+PUBLIC int eglPushCurrentGLVND(void)
+{
+    __EGLThreadAPIState *threadState;
+    __GLdispatchThreadState *glas;
+    __EGLdispatchThreadState *apiState;
+
+    __eglEntrypointCommon();
+
+    threadState = __eglGetCurrentThreadAPIState(EGL_TRUE);
+    if (threadState == NULL) {
+        __eglReportError(EGL_BAD_ALLOC, "eglPushCurrentGLVND", NULL,
+                "Can't allocate the thread state");
+        return 0;
+    }
+
+    glas = __glDispatchGetCurrentThreadStateInline();
+    if (glas != NULL && glas->tag != GLDISPATCH_API_EGL) {
+        __eglReportError(EGL_BAD_ACCESS, "eglPushCurrentGLVND", NULL,
+                "Another window API already has a current context");
+        return 0;
+    }
+
+    if (glas != NULL) {
+        apiState = (__EGLdispatchThreadState *) glas;
+        if (!SuspendVendorCurrent(apiState)) {
+            return 0;
         }
+        __glDispatchSuspendCurrent();
+    } else {
+        // Push an empty entry, so that the pop knows to leave the thread
+        // with no current context.
+        apiState = __eglCreateAPIState();
+        if (apiState == NULL) {
+            __eglReportError(EGL_BAD_ALLOC, "eglPushCurrentGLVND", NULL,
+                    "Can't allocate the thread state");
+            return 0;
+        }
+    }
+
+    apiState->pushedNext = threadState->pushedState;
+    threadState->pushedState = apiState;
+    return 1;
+}
+
+PUBLIC int eglPopCurrentGLVND(void)
+{
+    __EGLThreadAPIState *threadState;
+    __GLdispatchThreadState *glas;
+    __EGLdispatchThreadState *apiState;
+    uint64_t vendorNS = 0;
+
+    __eglEntrypointCommon();
+
+    threadState = __eglGetCurrentThreadAPIState(EGL_FALSE);
+    if (threadState == NULL || threadState->pushedState == NULL) {
+        __eglReportError(EGL_BAD_ACCESS, "eglPopCurrentGLVND", NULL,
+                "No context was pushed on this thread");
+        return 0;
+    }
+
+    glas = __glDispatchGetCurrentThreadStateInline();
+    if (glas != NULL && glas->tag != GLDISPATCH_API_EGL) {
+        __eglReportError(EGL_BAD_ACCESS, "eglPopCurrentGLVND", NULL,
+                "Another window API already has a current context");
+        return 0;
+    }
+    if (!InternalLoseCurrent(&vendorNS)) {
+        return 0;
+    }
+
+    apiState = threadState->pushedState;
+    threadState->pushedState = apiState->pushedNext;
+    apiState->pushedNext = NULL;
+
+    if (apiState->currentVendor == NULL) {
+        __eglDestroyAPIState(apiState);
+        return 1;
+    }
+
+    if (!ResumeVendorCurrent(apiState)) {
+        __glDispatchDiscardSuspended(&apiState->glas);
+        __eglDestroyAPIState(apiState);
+        return 0;
+    }
+
+    if (!__glDispatchResumeCurrent(&apiState->glas)) {
+        apiState->currentVendor->staticDispatch.makeCurrent(
+                apiState->currentDisplay->dpy,
+                EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        __eglDestroyAPIState(apiState);
+        __eglReportError(EGL_BAD_ACCESS, "eglPopCurrentGLVND", NULL,
+                "Can't restore the dispatch table for the context");
+        return 0;
     }
 
+    return 1;
+}
+
+/*
+ * This is the same as the generated stub, except that it's timed for
+ * __GLVND_WINSYS_TIMES.
+ */
+PUBLIC EGLBoolean EGLAPIENTRY eglSwapBuffers(EGLDisplay dpy, EGLSurface surface)
+{
+    typedef EGLBoolean (EGLAPIENTRY * pfn_eglSwapBuffers) (EGLDisplay dpy, EGLSurface surface);
+    uint64_t start = __glDispatchWinsysTimeBegin();
+    uint64_t vendorNS = 0;
+    EGLBoolean ret = EGL_FALSE;
+    pfn_eglSwapBuffers ptr_eglSwapBuffers;
+
+    GLDISPATCH_TRACE(2, GLDISPATCH_TRACE_SWAP, GLDISPATCH_API_EGL, surface);
+    ptr_eglSwapBuffers = (pfn_eglSwapBuffers)
+        __eglDispatchFetchByDisplay(dpy, __EGL_DISPATCH_eglSwapBuffers);
+
+    if (ptr_eglSwapBuffers != NULL) {
+        uint64_t vendorStart = __glDispatchWinsysTimeBegin();
+        ret = ptr_eglSwapBuffers(dpy, surface);
+        vendorNS = __glDispatchWinsysTimeSince(vendorStart);
+    }
+    __glDispatchWinsysTimeEnd(GLDISPATCH_WINSYS_EGL_SWAP_BUFFERS, start,
+            vendorNS);
     return ret;
 }
 
@@ -793,7 +1487,9 @@ PUBLIC EGLBoolean EGLAPIENTRY eglReleaseThread(void)
     if (threadState != NULL) {
         __EGLdispatchThreadState *apiState = __eglGetCurrentAPIState();
         __EGLvendorInfo *currentVendor = NULL;
-        struct glvnd_list *vendorList = __eglLoadVendors();
+        // A vendor that hasn't been loaded yet can't have any per-thread
+        // state, so there's no need to load the rest of them here.
+        struct glvnd_list *vendorList = __eglGetLoadedVendors();
         __EGLvendorInfo *vendor;
 
         if (apiState != NULL) {
@@ -927,16 +1623,21 @@ PUBLIC const char *EGLAPIENTRY eglQueryString(EGLDisplay dpy, EGLint name)
 
     if (dpy == EGL_NO_DISPLAY) {
         if (name == EGL_EXTENSIONS) {
-            const char *ret;
+            char *ret = glvndAtomicLoadAcquirePtr((void * volatile *) &clientExtensionString);
+
+            if (ret != NULL) {
+                return ret;
+            }
 
             if (glvnd_list_is_empty(__eglLoadVendors())) {
                 return "";
             }
             __glvndPthreadFuncs.mutex_lock(&clientExtensionStringMutex);
-            if (clientExtensionString == NULL) {
-                clientExtensionString = GetClientExtensionString();
-            }
             ret = clientExtensionString;
+            if (ret == NULL) {
+                ret = GetClientExtensionString();
+                glvndAtomicStoreReleasePtr((void * volatile *) &clientExtensionString, ret);
+            }
             __glvndPthreadFuncs.mutex_unlock(&clientExtensionStringMutex);
 
             return ret;
@@ -962,6 +1663,9 @@ PUBLIC const char *EGLAPIENTRY eglQueryString(EGLDisplay dpy, EGLint name)
 EGLBoolean EGLAPIENTRY eglQueryDevicesEXT(EGLint max_devices,
         EGLDeviceEXT *devices, EGLint *num_devices)
 {
+    const __EGLdeviceInfo *deviceList;
+    EGLint deviceCount;
+
     __eglEntrypointCommon();
 
     if (num_devices == NULL || (max_devices <= 0 && devices != NULL)) {
@@ -970,74 +1674,71 @@ EGLBoolean EGLAPIENTRY eglQueryDevicesEXT(EGLint max_devices,
         return EGL_FALSE;
     }
 
-    __eglInitDeviceList();
+    // Check the vendors again every time, so that we'll pick up any devices
+    // that were added since the last call.
+    __eglRefreshDeviceList();
+    deviceList = __eglGetDeviceList(&deviceCount);
 
     if (devices != NULL) {
         EGLint i;
 
-        *num_devices = (max_devices < __eglDeviceCount ? max_devices : __eglDeviceCount);
+        *num_devices = (max_devices < deviceCount ? max_devices : deviceCount);
         for (i = 0; i < *num_devices; i++) {
-            devices[i] = __eglDeviceList[i].handle;
+            devices[i] = deviceList[i].handle;
         }
     } else {
-        *num_devices = __eglDeviceCount;
+        *num_devices = deviceCount;
     }
     return EGL_TRUE;
 }
 
-// TODO: The function hash is the same as in GLX. It should go into a common
-// file.
-typedef struct {
-    char *procName;
-    __eglMustCastToProperFunctionPointerType addr;
-    UT_hash_handle hh;
-} __EGLprocAddressHash;
-
-static DEFINE_INITIALIZED_LKDHASH(__EGLprocAddressHash, __eglProcAddressHash);
+static int CompareDispatchFuncName(const void *key, const void *elem)
+{
+    return strcmp((const char *) key, *((const char * const *) elem));
+}
 
-static void CacheProcAddress(const char *procName,
-        __eglMustCastToProperFunctionPointerType addr)
+/*!
+ * Looks up a function in the generated list of functions that libEGL knows
+ * about. The list is sorted by name at build time, and never changes, so this
+ * doesn't need any locking.
+ */
+static __eglMustCastToProperFunctionPointerType LookupDispatchFunc(const char *procName)
 {
-    size_t nameLen = strlen(procName);
-    __EGLprocAddressHash *pEntry;
-
-    LKDHASH_WRLOCK(__eglProcAddressHash);
-
-    HASH_FIND(hh, _LH(__eglProcAddressHash), procName,
-              nameLen, pEntry);
-    if (pEntry == NULL) {
-        pEntry = malloc(sizeof(*pEntry) + nameLen + 1);
-        if (pEntry != NULL) {
-            pEntry->procName = (char *) (pEntry + 1);
-            memcpy(pEntry->procName, procName, nameLen + 1);
-            pEntry->addr = addr;
-            HASH_ADD_KEYPTR(hh, _LH(__eglProcAddressHash), pEntry->procName,
-                            nameLen, pEntry);
-        }
+    const char * const *name = bsearch(procName, __EGL_DISPATCH_FUNC_NAMES,
+            __EGL_DISPATCH_FUNC_COUNT, sizeof(__EGL_DISPATCH_FUNC_NAMES[0]),
+            CompareDispatchFuncName);
+
+    if (name != NULL) {
+        return __EGL_DISPATCH_FUNCS[name - __EGL_DISPATCH_FUNC_NAMES];
     } else {
-        assert(pEntry->addr == addr);
+        return NULL;
     }
-    LKDHASH_UNLOCK(__eglProcAddressHash);
 }
 
-static __eglMustCastToProperFunctionPointerType GetCachedProcAddress(const char *procName)
+PUBLIC int eglPreinitializeGLVND(unsigned int flags)
 {
-    /*
-     * If this is the first time GetProcAddress has been called,
-     * initialize the hash table with locally-exported functions.
-     */
-    __EGLprocAddressHash *pEntry = NULL;
+    struct glvnd_list *vendorList;
+    __EGLvendorInfo *vendor;
 
-    LKDHASH_RDLOCK(__eglProcAddressHash);
-    HASH_FIND(hh, _LH(__eglProcAddressHash), procName,
-              strlen(procName), pEntry);
-    LKDHASH_UNLOCK(__eglProcAddressHash);
+    __eglThreadInitialize();
 
-    if (pEntry) {
-        return pEntry->addr;
+    if (flags & GLVND_PREINIT_LOAD_VENDORS) {
+        vendorList = __eglLoadVendors();
+    } else {
+        vendorList = __eglGetLoadedVendors();
     }
 
-    return NULL;
+    if (flags & GLVND_PREINIT_POPULATE_DISPATCH) {
+        glvnd_list_for_each_entry(vendor, vendorList, entry) {
+            __glDispatchPopulateTable(vendor->glDispatch);
+        }
+    }
+
+    if (flags & GLVND_PREINIT_PREFAULT) {
+        __glDispatchPrewarm();
+    }
+
+    return !glvnd_list_is_empty(vendorList);
 }
 
 PUBLIC __eglMustCastToProperFunctionPointerType EGLAPIENTRY eglGetProcAddress(const char *procName)
@@ -1045,13 +1746,17 @@ PUBLIC __eglMustCastToProperFunctionPointerType EGLAPIENTRY eglGetProcAddress(co
     __eglMustCastToProperFunctionPointerType addr = NULL;
 
     __eglEntrypointCommon();
+    GLDISPATCH_TRACE_PROC(2, GLDISPATCH_API_EGL, procName);
 
     /*
-     * Easy case: First check if we already know this address from
-     * a previous GetProcAddress() call or by virtue of being a function
-     * exported by libEGL.
+     * Easy case: First check if this is a function exported by libEGL, or if
+     * we already know this address from a previous GetProcAddress() call.
      */
-    addr = GetCachedProcAddress(procName);
+    addr = LookupDispatchFunc(procName);
+    if (addr) {
+        return addr;
+    }
+    addr = (__eglMustCastToProperFunctionPointerType) __glvndProcAddressCacheLookup(procName);
     if (addr) {
         return addr;
     }
@@ -1068,132 +1773,92 @@ PUBLIC __eglMustCastToProperFunctionPointerType EGLAPIENTRY eglGetProcAddress(co
         addr = NULL;
     }
     if (addr != NULL) {
-        CacheProcAddress(procName, addr);
+        __glvndProcAddressCacheAdd(procName, (void *) addr);
     }
 
     return addr;
 }
 
 
-// TODO: Move the Atomic* functions to a common file.
-int AtomicIncrement(int volatile *val)
+PUBLIC int eglGetProcAddressesGLVND(const char * const *procNames,
+        GLVNDproc *procs, int count)
 {
-#if defined(HAVE_SYNC_INTRINSICS)
-    return __sync_add_and_fetch(val, 1);
-#elif defined(USE_X86_ASM) || defined(USE_X86_64_ASM)
-    int result;
-    int delta = 1;
+    const char **glNames;
+    __GLdispatchProc *glProcs;
+    int *glIndices;
+    int numGL = 0;
+    int numFound = 0;
+    int i;
 
-    __asm __volatile__ ("lock; xaddl %0, %1"
-                        : "=r" (result), "=m" (*val)
-                        : "0" (delta), "m" (*val));
-
-    return result + delta;
-#else
-#error "Not implemented"
-#endif
-}
-
-int AtomicSwap(int volatile *val, int newVal)
-{
-#if defined(HAVE_SYNC_INTRINSICS)
-    return __sync_lock_test_and_set(val, newVal);
-#elif defined(USE_X86_ASM) || defined(USE_X86_64_ASM)
-    int result;
-
-    __asm __volatile__ ("xchgl %0, %1"
-                        : "=r" (result), "=m" (*val)
-                        : "0" (newVal), "m" (*val));
-
-    return result;
-#else
-#error "Not implemented"
-#endif
-}
-
-int AtomicCompareAndSwap(int volatile *val, int oldVal, int newVal)
-{
-#if defined(HAVE_SYNC_INTRINSICS)
-    return __sync_val_compare_and_swap(val, oldVal, newVal);
-#elif defined(USE_X86_ASM) || defined(USE_X86_64_ASM)
-    int result;
-
-    __asm __volatile__ ("lock; cmpxchgl %2, %1"
-                        : "=a" (result), "=m" (*val)
-                        : "r" (newVal), "m" (*val), "0" (oldVal));
-
-    return result;
-#else
-#error "Not implemented"
-#endif
-}
-
-int AtomicDecrementClampAtZero(int volatile *val)
-{
-    int oldVal, newVal;
+    __eglEntrypointCommon();
 
-    oldVal = *val;
-    newVal = oldVal;
+    if (count <= 0) {
+        return 0;
+    }
 
-    do {
-        if (oldVal <= 0) {
-            assert(oldVal == 0);
-        } else {
-            newVal = oldVal - 1;
-            if (newVal < 0) {
-                newVal = 0;
+    glNames = malloc(count * (sizeof(const char *)
+                + sizeof(__GLdispatchProc) + sizeof(int)));
+    if (glNames == NULL) {
+        for (i=0; i<count; i++) {
+            procs[i] = eglGetProcAddress(procNames[i]);
+            if (procs[i] != NULL) {
+                numFound++;
             }
-            oldVal = AtomicCompareAndSwap(val, oldVal, newVal);
         }
-    } while ((oldVal > 0) && (newVal != oldVal - 1));
-
-    return newVal;
-}
-
-static void __eglResetOnFork(void);
-
-/*
- * Perform checks that need to occur when entering any EGL entrypoint.
- * Currently, this only detects whether a fork occurred since the last
- * entrypoint was called, and performs recovery as needed.
- */
-void CheckFork(void)
-{
-    volatile static int g_threadsInCheck = 0;
-    volatile static int g_lastPid = -1;
-
-    int lastPid;
-    int pid = getpid();
-
-    AtomicIncrement(&g_threadsInCheck);
-
-    lastPid = AtomicSwap(&g_lastPid, pid);
+        return numFound;
+    }
+    glProcs = (__GLdispatchProc *) (glNames + count);
+    glIndices = (int *) (glProcs + count);
 
-    if ((lastPid != -1) &&
-        (lastPid != pid)) {
+    /*
+     * Handle everything that eglGetProcAddress could find without going
+     * through libGLdispatch, and collect the OpenGL functions so that
+     * libGLdispatch can look them all up with a single lock.
+     */
+    for (i=0; i<count; i++) {
+        const char *procName = procNames[i];
+        __eglMustCastToProperFunctionPointerType addr = LookupDispatchFunc(procName);
 
-        DBG_PRINTF(0, "Fork detected\n");
+        if (addr == NULL) {
+            addr = (__eglMustCastToProperFunctionPointerType) __glvndProcAddressCacheLookup(procName);
+        }
+        if (addr == NULL) {
+            if (procName[0] == 'e' && procName[1] == 'g' && procName[2] == 'l') {
+                addr = __eglGetEGLDispatchAddress(procName);
+                if (addr != NULL) {
+                    __glvndProcAddressCacheAdd(procName, (void *) addr);
+                }
+            } else if (procName[0] == 'g' && procName[1] == 'l') {
+                glNames[numGL] = procName;
+                glIndices[numGL] = i;
+                numGL++;
+            }
+        }
+        procs[i] = (GLVNDproc) addr;
+    }
 
-        __eglResetOnFork();
+    if (numGL > 0) {
+        __glDispatchGetProcAddresses(glNames, glProcs, numGL);
+        for (i=0; i<numGL; i++) {
+            if (glProcs[i] != NULL) {
+                __glvndProcAddressCacheAdd(glNames[i], (void *) glProcs[i]);
+            }
+            procs[glIndices[i]] = (GLVNDproc) glProcs[i];
+        }
+    }
+    free(glNames);
 
-        // Force g_threadsInCheck to 0 to unblock other threads waiting here.
-        g_threadsInCheck = 0;
-    } else {
-        AtomicDecrementClampAtZero(&g_threadsInCheck);
-        while (g_threadsInCheck > 0) {
-            // Wait for other threads to finish checking for a fork.
-            //
-            // If a fork happens while g_threadsInCheck > 0 the _first_ thread
-            // to enter __eglThreadInitialize() will see the fork, handle it, and force
-            // g_threadsInCheck to 0, unblocking any other threads stuck here.
-            sched_yield();
+    for (i=0; i<count; i++) {
+        if (procs[i] != NULL) {
+            numFound++;
         }
     }
+    return numFound;
 }
 
 void __eglThreadInitialize(void)
 {
-    CheckFork();
+    glvndCheckFork();
     __glDispatchCheckMultithreaded();
 }
 
@@ -1202,15 +1867,25 @@ static void __eglAPITeardown(EGLBoolean doReset)
     __eglCurrentTeardown(doReset);
 
     if (doReset) {
-        /*
-         * XXX: We should be able to get away with just resetting the proc address
-         * hash lock, and not throwing away cached addresses.
-         */
-        __glvndPthreadFuncs.rwlock_init(&__eglProcAddressHash.lock, NULL);
+        // The native display to platform mappings are still valid in the
+        // child, so keep them and just reset the locks.
+        __glvndHashMapReset(&__eglNativePlatformHash);
+        __glvndPthreadFuncs.mutex_init(&platformVendorMutex, NULL);
+        __glvndPthreadFuncs.mutex_init(&displayCacheMutex, NULL);
+    } else {
+        __glvndHashMapTeardown(&__eglNativePlatformHash, NULL, NULL, EGL_FALSE);
+        platformVendorCount = 0;
+        displayCacheCount = 0;
+        displayCacheNext = 0;
+    }
+
+    if (doReset) {
+        // The cached proc addresses are still valid in the child, so this
+        // only resets the locks.
+        __glvndProcAddressCacheReset();
+        __glvndPthreadFuncs.mutex_init(&clientExtensionStringMutex, NULL);
     } else {
-        LKDHASH_TEARDOWN(__EGLprocAddressHash,
-                         __eglProcAddressHash, NULL,
-                         NULL, EGL_FALSE);
+        __glvndProcAddressCacheCleanup();
 
         free(clientExtensionString);
         clientExtensionString = NULL;
@@ -1219,6 +1894,8 @@ static void __eglAPITeardown(EGLBoolean doReset)
 
 static void __eglResetOnFork(void)
 {
+    DBG_PRINTF(0, "Fork detected\n");
+
     /* Reset all EGL API state */
     __eglAPITeardown(EGL_TRUE);
 
@@ -1243,6 +1920,11 @@ void _init(void)
     /* Initialize GLdispatch; this will also initialize our pthreads imports */
     __glDispatchInit();
     glvndSetupPthreads();
+    glvndLockProfilingInit();
+
+    __glDispatchRegisterLockStats("EGL", "nativePlatformHash",
+            __eglNativePlatformHash.lockStats, GLVND_HASHMAP_LOCK_COUNT);
+    __glDispatchRegisterMemStats("EGL", glvndMemStats);
 
     // Set up the mapping code, and populate the getprocaddress hashtable.
     __eglMappingInit();
@@ -1250,7 +1932,8 @@ void _init(void)
     __eglCurrentInit();
     __eglInitVendors();
 
-    /* TODO install fork handlers using __register_atfork */
+    glvndForkInit(__eglResetOnFork);
+    glvndFastExitInit((const void *) __eglResetOnFork);
 
     DBG_PRINTF(0, "Loading EGL...\n");
 
@@ -1263,19 +1946,29 @@ void _fini(void)
 #endif
 {
     /* Check for a fork before going further. */
-    CheckFork();
+    glvndCheckFork();
 
     /*
      * If libEGL owns the current API state, lose current
      * in GLdispatch before going further.
      */
     __GLdispatchThreadState *glas =
-        __glDispatchGetCurrentThreadState();
+        __glDispatchGetCurrentThreadStateInline();
 
     if (glas && glas->tag == GLDISPATCH_API_EGL) {
         __glDispatchLoseCurrent();
     }
 
+    __glDispatchUnregisterLockStats("EGL");
+
+    if (glvndFastExitEnabled()) {
+        // libEGL.so is pinned, so the process is exiting. Leave everything
+        // else for the OS to clean up.
+        __glDispatchUnregisterMemStats("EGL");
+        __glDispatchFini();
+        return;
+    }
+
     /* Tear down all EGL API state */
     __eglAPITeardown(EGL_FALSE);
 
@@ -1284,6 +1977,9 @@ void _fini(void)
 
     __eglTeardownVendors();
 
+    __glvndHashMapFini();
+    __glDispatchUnregisterMemStats("EGL");
+
     /* Tear down GLdispatch if necessary */
     __glDispatchFini();
 }
@@ -31,75 +31,11 @@
 #define __LIB_EGL_ABI_PRIV__
 
 /*
- * This is a wrapper around libeglabi which defines each vendor's static
- * dispatch table.  Logically this could differ from the API imports provided
- * by the vendor, though in practice they are one and the same.
+ * This is a wrapper around libeglabi. Each vendor's static dispatch table,
+ * __EGLdispatchTableStatic, is defined in libeglabi.h, since a vendor library
+ * can hand it over as a whole.
  */
 
 #include "glvnd/libeglabi.h"
 
-/*!
- * This structure stores function pointers for all functions defined in EGL 1.5.
- */
-typedef struct __EGLdispatchTableStaticRec {
-    EGLBoolean (* initialize) (EGLDisplay dpy, EGLint *major, EGLint *minor);
-
-    EGLBoolean (* chooseConfig) (EGLDisplay dpy, const EGLint *attrib_list, EGLConfig *configs, EGLint config_size, EGLint *num_config);
-    EGLBoolean (* copyBuffers) (EGLDisplay dpy, EGLSurface surface, EGLNativePixmapType target);
-    EGLContext (* createContext) (EGLDisplay dpy, EGLConfig config, EGLContext share_context, const EGLint *attrib_list);
-    EGLSurface (* createPbufferSurface) (EGLDisplay dpy, EGLConfig config, const EGLint *attrib_list);
-    EGLSurface (* createPixmapSurface) (EGLDisplay dpy, EGLConfig config, EGLNativePixmapType pixmap, const EGLint *attrib_list);
-    EGLSurface (* createWindowSurface) (EGLDisplay dpy, EGLConfig config, EGLNativeWindowType win, const EGLint *attrib_list);
-    EGLBoolean (* destroyContext) (EGLDisplay dpy, EGLContext ctx);
-    EGLBoolean (* destroySurface) (EGLDisplay dpy, EGLSurface surface);
-    EGLBoolean (* getConfigAttrib) (EGLDisplay dpy, EGLConfig config, EGLint attribute, EGLint *value);
-    EGLBoolean (* getConfigs) (EGLDisplay dpy, EGLConfig *configs, EGLint config_size, EGLint *num_config);
-    EGLBoolean (* makeCurrent) (EGLDisplay dpy, EGLSurface draw, EGLSurface read, EGLContext ctx);
-    EGLBoolean (* queryContext) (EGLDisplay dpy, EGLContext ctx, EGLint attribute, EGLint *value);
-    const char *(* queryString) (EGLDisplay dpy, EGLint name);
-    EGLBoolean (* querySurface) (EGLDisplay dpy, EGLSurface surface, EGLint attribute, EGLint *value);
-    EGLBoolean (* swapBuffers) (EGLDisplay dpy, EGLSurface surface);
-    EGLBoolean (* terminate) (EGLDisplay dpy);
-    EGLBoolean (* waitGL) (void);
-    EGLBoolean (* waitNative) (EGLint engine);
-    EGLBoolean (* bindTexImage) (EGLDisplay dpy, EGLSurface surface, EGLint buffer);
-    EGLBoolean (* releaseTexImage) (EGLDisplay dpy, EGLSurface surface, EGLint buffer);
-    EGLBoolean (* surfaceAttrib) (EGLDisplay dpy, EGLSurface surface, EGLint attribute, EGLint value);
-    EGLBoolean (* swapInterval) (EGLDisplay dpy, EGLint interval);
-
-    EGLBoolean (* bindAPI) (EGLenum api);
-    EGLSurface (* createPbufferFromClientBuffer) (EGLDisplay dpy, EGLenum buftype, EGLClientBuffer buffer, EGLConfig config, const EGLint *attrib_list);
-    EGLBoolean (* releaseThread) (void);
-    EGLBoolean (* waitClient) (void);
-
-    EGLint (* getError) (void);
-
-#if 0
-    EGLDisplay (* getCurrentDisplay) (void);
-    EGLSurface (* getCurrentSurface) (EGLint readdraw);
-    EGLDisplay (* getDisplay) (EGLNativeDisplayType display_id);
-    EGLContext (* getCurrentContext) (void);
-#endif
-
-    // EGL 1.5 functions. A vendor library is not requires to implement these.
-    EGLSync (* createSync) (EGLDisplay dpy, EGLenum type, const EGLAttrib *attrib_list);
-    EGLBoolean (* destroySync) (EGLDisplay dpy, EGLSync sync);
-    EGLint (* clientWaitSync) (EGLDisplay dpy, EGLSync sync, EGLint flags, EGLTime timeout);
-    EGLBoolean (* getSyncAttrib) (EGLDisplay dpy, EGLSync sync, EGLint attribute, EGLAttrib *value);
-    EGLImage (* createImage) (EGLDisplay dpy, EGLContext ctx, EGLenum target, EGLClientBuffer buffer, const EGLAttrib *attrib_list);
-    EGLBoolean (* destroyImage) (EGLDisplay dpy, EGLImage image);
-    EGLSurface (* createPlatformWindowSurface) (EGLDisplay dpy, EGLConfig config, void *native_window, const EGLAttrib *attrib_list);
-    EGLSurface (* createPlatformPixmapSurface) (EGLDisplay dpy, EGLConfig config, void *native_pixmap, const EGLAttrib *attrib_list);
-    EGLBoolean (* waitSync) (EGLDisplay dpy, EGLSync sync, EGLint flags);
-    //EGLDisplay (* getPlatformDisplay) (EGLenum platform, void *native_display, const EGLAttrib *attrib_list);
-
-    // Extension functions that libEGL cares about.
-    EGLBoolean (* queryDevicesEXT) (EGLint max_devices, EGLDeviceEXT *devices, EGLint *num_devices);
-
-
-    EGLint (* debugMessageControlKHR) (EGLDEBUGPROCKHR callback, const EGLAttrib *attrib_list);
-    EGLBoolean (* queryDebugKHR) (EGLint attribute, EGLAttrib* value);
-    EGLint (* labelObjectKHR) (EGLDisplay display, EGLenum objectType, EGLObjectKHR object, EGLLabelKHR label);
-} __EGLdispatchTableStatic;
-
 #endif
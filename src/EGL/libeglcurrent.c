@@ -1,22 +1,83 @@
 #include "libeglcurrent.h"
 
+#include <string.h>
+
 #include "glvnd_pthread.h"
-#include "lkdhash.h"
+#include "glvnd_atomic.h"
 
 static void OnDispatchThreadDestroyed(__GLdispatchThreadState *state);
+static void OnAPIStateCacheDestroyed(void *data);
+static void ResetThreadState(__EGLThreadAPIState *threadState);
+
+#if !defined(GLDISPATCH_USE_TLS)
 static void OnThreadDestroyed(void *data);
 
 static __EGLThreadAPIState *CreateThreadState(void);
 static void DestroyThreadState(__EGLThreadAPIState *threadState);
+#endif
 
 /**
- * A list of current __EGLdispatchThreadState structures. This is used so that we can
- * clean up at process termination or after a fork.
+ * A list of current __EGLdispatchThreadState structures, including the ones
+ * in apiStateCacheKey. This is used so that we can clean up at process
+ * termination or after a fork.
  */
 static struct glvnd_list currentAPIStateList;
-static struct glvnd_list currentThreadStateList;
+
+/**
+ * __EGLdispatchThreadState structures that were released by eglMakeCurrent,
+ * so that the next eglMakeCurrent can reuse one instead of calling calloc.
+ * Like currentAPIStateList, this is protected by currentStateListMutex.
+ */
+static struct glvnd_list freeAPIStateList;
 static glvnd_mutex_t currentStateListMutex = PTHREAD_MUTEX_INITIALIZER;
+static glvnd_lock_stats_t currentStateListMutexStats;
+
+/**
+ * The __EGLdispatchThreadState that each thread used for its last current
+ * context, if it doesn't have one now.
+ *
+ * An app that releases and re-binds its context every frame would otherwise
+ * move a struct between currentAPIStateList and freeAPIStateList each time.
+ * A cached struct stays in currentAPIStateList, so reusing it doesn't need
+ * currentStateListMutex.
+ */
+static glvnd_key_t apiStateCacheKey;
+
+#if defined(GLDISPATCH_USE_TLS)
+/*
+ * With TLS, each thread's __EGLThreadAPIState is just a TLS variable, so
+ * setting the error code or last vendor doesn't need a getspecific call, and
+ * a new thread doesn't have to allocate anything.
+ *
+ * currentThreadStateValid keeps track of whether the thread has "created" its
+ * state yet, so that __eglGetCurrentThreadAPIState(EGL_FALSE) still returns
+ * NULL for a thread that hasn't set anything.
+ */
+static __thread __EGLThreadAPIState currentThreadState
+    __attribute__((tls_model("initial-exec")));
+static __thread EGLBoolean currentThreadStateValid
+    __attribute__((tls_model("initial-exec"))) = EGL_FALSE;
+#else
+/*
+ * Without TLS, each thread's state is allocated and stored with
+ * setspecific. The allocations go in a list so that we can free them at
+ * teardown.
+ *
+ * That list is only ever pushed onto, without a lock. When a thread exits,
+ * its record is just marked as unused, and the next thread that needs one
+ * claims it with a compare-and-swap. That way, a thread pool that keeps
+ * starting and stopping threads doesn't need a global lock or a malloc for
+ * each thread.
+ */
+typedef struct __EGLThreadAPIStateRecordRec {
+    __EGLThreadAPIState state; /* Must be the first entry! */
+    int volatile inUse;
+    struct __EGLThreadAPIStateRecordRec *next;
+} __EGLThreadAPIStateRecord;
+
+static __EGLThreadAPIStateRecord * volatile threadStateRecords = NULL;
 static glvnd_key_t threadStateKey;
+#endif
 
 EGLenum __eglQueryAPI(void)
 {
@@ -79,49 +140,130 @@ EGLSurface __eglGetCurrentSurface(EGLint readDraw)
 void __eglCurrentInit(void)
 {
     glvnd_list_init(&currentAPIStateList);
-    glvnd_list_init(&currentThreadStateList);
+    glvnd_list_init(&freeAPIStateList);
+    __glDispatchRegisterLockStats("EGL", "currentStateListMutex",
+            &currentStateListMutexStats, 1);
+    __glvndPthreadFuncs.key_create(&apiStateCacheKey, OnAPIStateCacheDestroyed);
+#if !defined(GLDISPATCH_USE_TLS)
     __glvndPthreadFuncs.key_create(&threadStateKey, OnThreadDestroyed);
+#endif
 }
 
 void __eglCurrentTeardown(EGLBoolean doReset)
 {
+    // The cached states are in currentAPIStateList, so this frees them, too.
+    // After a fork, the calling thread is the only one left with a cache
+    // entry to clear.
+    __glvndPthreadFuncs.setspecific(apiStateCacheKey, NULL);
     while (!glvnd_list_is_empty(&currentAPIStateList)) {
         __EGLdispatchThreadState *apiState = glvnd_list_first_entry(
                 &currentAPIStateList, __EGLdispatchThreadState, entry);
-        __eglDestroyAPIState(apiState);
+        __eglFreeAPIState(apiState);
+    }
+    while (!glvnd_list_is_empty(&freeAPIStateList)) {
+        __EGLdispatchThreadState *apiState = glvnd_list_first_entry(
+                &freeAPIStateList, __EGLdispatchThreadState, entry);
+        glvnd_list_del(&apiState->entry);
+        free(apiState);
     }
 
-    while (!glvnd_list_is_empty(&currentThreadStateList)) {
-        __EGLThreadAPIState *threadState = glvnd_list_first_entry(
-                &currentThreadStateList, __EGLThreadAPIState, entry);
-        DestroyThreadState(threadState);
+#if defined(GLDISPATCH_USE_TLS)
+    // We can only get to the calling thread's state here, but that's the only
+    // thread that's left after a fork.
+    __eglDestroyCurrentThreadAPIState();
+#else
+    __glvndPthreadFuncs.setspecific(threadStateKey, NULL);
+    if (doReset) {
+        // After a fork, the calling thread is the only one left, so every
+        // record is free.
+        __EGLThreadAPIStateRecord *rec;
+        for (rec = threadStateRecords; rec != NULL; rec = rec->next) {
+            rec->inUse = 0;
+        }
+    } else {
+        while (threadStateRecords != NULL) {
+            __EGLThreadAPIStateRecord *next = threadStateRecords->next;
+            free(threadStateRecords);
+            threadStateRecords = next;
+        }
     }
+#endif
 
     if (doReset) {
         __glvndPthreadFuncs.mutex_init(&currentStateListMutex, NULL);
+    } else {
+        __glvndPthreadFuncs.key_delete(apiStateCacheKey);
     }
 }
 
-__EGLThreadAPIState *CreateThreadState(void)
+void ResetThreadState(__EGLThreadAPIState *threadState)
 {
-    __EGLThreadAPIState *threadState = calloc(1, sizeof(__EGLThreadAPIState));
-    if (threadState == NULL) {
-        return NULL;
-    }
-
+    memset(threadState, 0, sizeof(*threadState));
     threadState->lastError = EGL_SUCCESS;
     threadState->lastVendor = NULL;
 
     // TODO: If no vendor library supports GLES, then we should initialize this
     // to EGL_NONE.
     threadState->currentClientApi = EGL_OPENGL_ES_API;
+    threadState->apiNotifiedVendors = ~0U;
+}
 
-    __glvndPthreadFuncs.mutex_lock(&currentStateListMutex);
-    glvnd_list_add(&threadState->entry, &currentThreadStateList);
-    __glvndPthreadFuncs.mutex_unlock(&currentStateListMutex);
+#if defined(GLDISPATCH_USE_TLS)
 
-    __glvndPthreadFuncs.setspecific(threadStateKey, threadState);
-    return threadState;
+__EGLThreadAPIState *__eglGetCurrentThreadAPIState(EGLBoolean create)
+{
+    if (likely(currentThreadStateValid)) {
+        return &currentThreadState;
+    } else if (create) {
+        ResetThreadState(&currentThreadState);
+        currentThreadStateValid = EGL_TRUE;
+        return &currentThreadState;
+    } else {
+        return NULL;
+    }
+}
+
+void __eglDestroyCurrentThreadAPIState(void)
+{
+    __eglFreeCachedAPIState();
+    if (currentThreadStateValid) {
+        currentThreadStateValid = EGL_FALSE;
+        ResetThreadState(&currentThreadState);
+    }
+}
+
+#else // defined(GLDISPATCH_USE_TLS)
+
+__EGLThreadAPIState *CreateThreadState(void)
+{
+    __EGLThreadAPIStateRecord *rec;
+
+    // Look for a record that an exited thread has given up.
+    for (rec = glvndAtomicLoadAcquirePtr((void * volatile *) &threadStateRecords);
+            rec != NULL; rec = rec->next) {
+        if (rec->inUse == 0 && glvndAtomicCompareExchange(&rec->inUse, 0, 1)) {
+            break;
+        }
+    }
+
+    if (rec == NULL) {
+        void *head;
+
+        rec = malloc(sizeof(__EGLThreadAPIStateRecord));
+        if (rec == NULL) {
+            return NULL;
+        }
+        rec->inUse = 1;
+        do {
+            head = glvndAtomicLoadAcquirePtr((void * volatile *) &threadStateRecords);
+            rec->next = head;
+        } while (!glvndAtomicCompareExchangePtr((void * volatile *) &threadStateRecords, head, rec));
+    }
+
+    ResetThreadState(&rec->state);
+
+    __glvndPthreadFuncs.setspecific(threadStateKey, &rec->state);
+    return &rec->state;
 }
 
 __EGLThreadAPIState *__eglGetCurrentThreadAPIState(EGLBoolean create)
@@ -136,17 +278,16 @@ __EGLThreadAPIState *__eglGetCurrentThreadAPIState(EGLBoolean create)
 void DestroyThreadState(__EGLThreadAPIState *threadState)
 {
     if (threadState != NULL) {
-        __glvndPthreadFuncs.mutex_lock(&currentStateListMutex);
-        glvnd_list_del(&threadState->entry);
-        __glvndPthreadFuncs.mutex_unlock(&currentStateListMutex);
-
-        free(threadState);
+        __EGLThreadAPIStateRecord *rec = (__EGLThreadAPIStateRecord *) threadState;
+        glvndAtomicStoreRelease(&rec->inUse, 0);
     }
 }
 
 void __eglDestroyCurrentThreadAPIState(void)
 {
     __EGLThreadAPIState *threadState = __glvndPthreadFuncs.getspecific(threadStateKey);
+
+    __eglFreeCachedAPIState();
     if (threadState != NULL) {
         __glvndPthreadFuncs.setspecific(threadStateKey, NULL);
         DestroyThreadState(threadState);
@@ -159,25 +300,72 @@ void OnThreadDestroyed(void *data)
     DestroyThreadState(threadState);
 }
 
+#endif // defined(GLDISPATCH_USE_TLS)
+
+static GLboolean OnDispatchThreadMigrate(__GLdispatchThreadState *state,
+        GLboolean attach)
+{
+    __EGLdispatchThreadState *eglState = (__EGLdispatchThreadState *) state;
+    const __EGLapiImports *imports;
+
+    if (eglState->currentVendor == NULL) {
+        return GL_FALSE;
+    }
+    imports = &eglState->currentVendor->eglvc;
+    if (imports->detachCurrent == NULL || imports->attachCurrent == NULL) {
+        return GL_FALSE;
+    }
+    if (attach) {
+        if (!imports->attachCurrent(eglState->vendorState)) {
+            return GL_FALSE;
+        }
+        eglState->vendorState = NULL;
+        return GL_TRUE;
+    } else {
+        return (imports->detachCurrent(&eglState->vendorState) ? GL_TRUE : GL_FALSE);
+    }
+}
+
 __EGLdispatchThreadState *__eglCreateAPIState(void)
 {
-    __EGLdispatchThreadState *apiState = calloc(1, sizeof(__EGLdispatchThreadState));
-    if (apiState == NULL) {
-        return NULL;
+    __EGLdispatchThreadState *apiState = (__EGLdispatchThreadState *)
+        __glvndPthreadFuncs.getspecific(apiStateCacheKey);
+
+    if (apiState != NULL) {
+        __glvndPthreadFuncs.setspecific(apiStateCacheKey, NULL);
+        memset(&apiState->glas, 0, sizeof(apiState->glas));
+    } else {
+        glvndProfiledMutexLock(&currentStateListMutex, &currentStateListMutexStats);
+        if (!glvnd_list_is_empty(&freeAPIStateList)) {
+            apiState = glvnd_list_first_entry(&freeAPIStateList,
+                    __EGLdispatchThreadState, entry);
+            glvnd_list_del(&apiState->entry);
+            memset(apiState, 0, sizeof(*apiState));
+        } else {
+            apiState = calloc(1, sizeof(__EGLdispatchThreadState));
+        }
+        if (apiState != NULL) {
+            glvnd_list_add(&apiState->entry, &currentAPIStateList);
+        }
+        __glvndPthreadFuncs.mutex_unlock(&currentStateListMutex);
+
+        if (apiState == NULL) {
+            return NULL;
+        }
     }
 
     apiState->glas.tag = GLDISPATCH_API_EGL;
     apiState->glas.threadDestroyedCallback = OnDispatchThreadDestroyed;
+    apiState->glas.migrateCallback = OnDispatchThreadMigrate;
 
     apiState->currentDisplay = NULL;
     apiState->currentDraw = EGL_NO_SURFACE;
     apiState->currentRead = EGL_NO_SURFACE;
     apiState->currentContext = EGL_NO_CONTEXT;
     apiState->currentVendor = NULL;
-
-    __glvndPthreadFuncs.mutex_lock(&currentStateListMutex);
-    glvnd_list_add(&apiState->entry, &currentAPIStateList);
-    __glvndPthreadFuncs.mutex_unlock(&currentStateListMutex);
+    apiState->currentDispatch = NULL;
+    apiState->vendorState = NULL;
+    apiState->pushedNext = NULL;
 
     return apiState;
 }
@@ -185,17 +373,43 @@ __EGLdispatchThreadState *__eglCreateAPIState(void)
 void __eglDestroyAPIState(__EGLdispatchThreadState *apiState)
 {
     if (apiState != NULL) {
-        __glvndPthreadFuncs.mutex_lock(&currentStateListMutex);
+        if (__glvndPthreadFuncs.getspecific(apiStateCacheKey) == NULL) {
+            __glvndPthreadFuncs.setspecific(apiStateCacheKey, apiState);
+        } else {
+            __eglFreeAPIState(apiState);
+        }
+    }
+}
+
+void __eglFreeAPIState(__EGLdispatchThreadState *apiState)
+{
+    if (apiState != NULL) {
+        glvndProfiledMutexLock(&currentStateListMutex, &currentStateListMutexStats);
         glvnd_list_del(&apiState->entry);
+        glvnd_list_add(&apiState->entry, &freeAPIStateList);
         __glvndPthreadFuncs.mutex_unlock(&currentStateListMutex);
+    }
+}
 
-        free(apiState);
+void __eglFreeCachedAPIState(void)
+{
+    __EGLdispatchThreadState *apiState = (__EGLdispatchThreadState *)
+        __glvndPthreadFuncs.getspecific(apiStateCacheKey);
+
+    if (apiState != NULL) {
+        __glvndPthreadFuncs.setspecific(apiStateCacheKey, NULL);
+        __eglFreeAPIState(apiState);
     }
 }
 
+static void OnAPIStateCacheDestroyed(void *data)
+{
+    __eglFreeAPIState((__EGLdispatchThreadState *) data);
+}
+
 void OnDispatchThreadDestroyed(__GLdispatchThreadState *state)
 {
     __EGLdispatchThreadState *eglState = (__EGLdispatchThreadState *) state;
-    __eglDestroyAPIState(eglState);
+    __eglFreeAPIState(eglState);
 }
 
@@ -36,7 +36,6 @@
 #include "libeglabipriv.h"
 #include "libeglmapping.h"
 #include "GLdispatch.h"
-#include "lkdhash.h"
 #include "glvnd_list.h"
 
 /*!
@@ -57,6 +56,17 @@ typedef struct __EGLdispatchThreadStateRec {
     EGLContext currentContext;
     __EGLvendorInfo *currentVendor;
 
+    // The dispatch table that was passed to libGLdispatch. This is usually
+    // the vendor's default table, but a vendor can select a different one for
+    // each context.
+    __GLdispatchTable *currentDispatch;
+
+    // The vendor's saved state while the thread state is detached or pushed.
+    void *vendorState;
+
+    // The next state down in the stack for eglPushCurrentGLVND.
+    struct __EGLdispatchThreadStateRec *pushedNext;
+
     struct glvnd_list entry;
 } __EGLdispatchThreadState;
 
@@ -76,9 +86,39 @@ typedef struct __EGLThreadAPIStateRec {
      */
     EGLenum currentClientApi;
 
+    /*!
+     * A bit for each vendor (by \c __EGLvendorInfo::apiIndex) that has been
+     * told about \c currentClientApi on this thread.
+     *
+     * eglBindAPI clears this, and \c __eglNotifyVendorAPI tells each vendor
+     * about the new API the first time that it's used on this thread, so
+     * that switching APIs doesn't call into every vendor. All of the bits are
+     * set until the first eglBindAPI call, since every vendor starts out
+     * with EGL_OPENGL_ES_API.
+     */
+    uint32_t apiNotifiedVendors;
+
     EGLLabelKHR label;
 
-    struct glvnd_list entry;
+    /*!
+     * A one-entry cache for __eglLookupDisplay, so that a thread that keeps
+     * using the same display doesn't have to take the display hashtable lock
+     * each time.
+     *
+     * \c cachedDisplayGeneration is compared against a counter that changes
+     * whenever a display is removed from the hashtable.
+     */
+    EGLDisplay cachedDisplay;
+    __EGLdisplayInfo *cachedDisplayInfo;
+    int cachedDisplayGeneration;
+
+    /*!
+     * The top of the stack for eglPushCurrentGLVND and eglPopCurrentGLVND.
+     *
+     * Each entry is a suspended \c __EGLdispatchThreadState. An entry with
+     * a NULL \c currentVendor means that there was no current context.
+     */
+    __EGLdispatchThreadState *pushedState;
 } __EGLThreadAPIState;
 
 void __eglCurrentInit(void);
@@ -88,7 +128,8 @@ void __eglCurrentTeardown(EGLBoolean doReset);
  * Returns the \c __EGLThreadAPIState structure for the current thread.
  *
  * \param create If \p create is true, then a new \c __EGLThreadAPIState struct
- * will be allocated if the current thread doesn't already have one.
+ * will be created if the current thread doesn't already have one. With TLS,
+ * that's just a TLS variable, so it doesn't allocate anything.
  *
  * \return A pointer to the current thread's \c __EGLThreadAPIState, or NULL if
  * the current thread doesn't have one yet.
@@ -100,12 +141,40 @@ __EGLThreadAPIState *__eglGetCurrentThreadAPIState(EGLBoolean create);
  */
 void __eglDestroyCurrentThreadAPIState(void);
 
+/*!
+ * Tells \p vendor about the client API from the last eglBindAPI call on this
+ * thread, if it hasn't been told already. This should be called before
+ * libEGL calls into a vendor on behalf of the thread.
+ *
+ * \p state may be NULL, in which case the thread never called eglBindAPI.
+ */
+static inline void __eglNotifyVendorAPI(__EGLThreadAPIState *state,
+        __EGLvendorInfo *vendor)
+{
+    uint32_t bit;
+
+    if (likely(state == NULL || vendor == NULL
+                || state->apiNotifiedVendors == ~0U)) {
+        return;
+    }
+
+    // A vendor without a bit is told every time.
+    bit = (vendor->apiIndex >= 0 ? (1U << vendor->apiIndex) : 0);
+    if ((state->apiNotifiedVendors & bit) != 0) {
+        return;
+    }
+    state->apiNotifiedVendors |= bit;
+    if (vendor->staticDispatch.bindAPI != NULL) {
+        vendor->staticDispatch.bindAPI(state->currentClientApi);
+    }
+}
+
 /*!
  * Returns the current thread's \c __EGLdispatchThreadState structure, if it has one.
  */
 static inline __EGLdispatchThreadState *__eglGetCurrentAPIState(void)
 {
-    __GLdispatchThreadState *glas = __glDispatchGetCurrentThreadState();
+    __GLdispatchThreadState *glas = __glDispatchGetCurrentThreadStateInline();
     if (unlikely(!glas ||
                  (glas->tag != GLDISPATCH_API_EGL))) {
         return NULL;
@@ -114,9 +183,31 @@ static inline __EGLdispatchThreadState *__eglGetCurrentAPIState(void)
     }
 }
 
+/*!
+ * Returns a new \c __EGLdispatchThreadState for the calling thread. This
+ * reuses the one that the thread released last, if there is one.
+ */
 __EGLdispatchThreadState *__eglCreateAPIState(void);
+
+/*!
+ * Releases an \c __EGLdispatchThreadState from the calling thread, after it
+ * loses current. The struct is kept for the thread's next
+ * \c __eglCreateAPIState call if the thread doesn't have one cached already.
+ */
 void __eglDestroyAPIState(__EGLdispatchThreadState *state);
 
+/*!
+ * Releases an \c __EGLdispatchThreadState without caching it. This is for
+ * a state that might not belong to the calling thread.
+ */
+void __eglFreeAPIState(__EGLdispatchThreadState *state);
+
+/*!
+ * Releases the calling thread's cached \c __EGLdispatchThreadState, if it has
+ * one.
+ */
+void __eglFreeCachedAPIState(void);
+
 EGLenum __eglQueryAPI(void);
 __EGLvendorInfo *__eglGetCurrentVendor(void);
 EGLContext __eglGetCurrentContext(void);
@@ -36,6 +36,7 @@
 #include <EGL/eglext.h>
 
 #include "glvnd_pthread.h"
+#include "glvnd_atomic.h"
 #include "libeglmapping.h"
 #include "libeglcurrent.h"
 #include "utils_misc.h"
@@ -54,6 +55,16 @@ static EGLDEBUGPROCKHR debugCallback = NULL;
 static unsigned int debugTypeEnabled = __EGL_DEBUG_BIT_CRITICAL | __EGL_DEBUG_BIT_ERROR;
 static glvnd_rwlock_t debugLock = GLVND_RWLOCK_INITIALIZER;
 
+/*!
+ * The message types that would actually go to a callback. This is
+ * \c debugTypeEnabled if there's a callback, or zero if there isn't.
+ *
+ * It's written while holding \c debugLock, but __eglDebugReport reads it
+ * without the lock, so that reporting a message that nothing would see is
+ * just a load and a branch.
+ */
+static int volatile debugTypeReported = 0;
+
 static inline unsigned int DebugBitFromType(EGLenum type)
 {
     assert(type >= EGL_DEBUG_MSG_CRITICAL_KHR &&
@@ -97,9 +108,11 @@ EGLint eglDebugMessageControlKHR(EGLDEBUGPROCKHR callback,
     if (callback != NULL) {
         debugCallback = callback;
         debugTypeEnabled = newEnabled;
+        glvndAtomicStoreRelease(&debugTypeReported, (int) newEnabled);
     } else {
         debugCallback = NULL;
         debugTypeEnabled = __EGL_DEBUG_BIT_CRITICAL | __EGL_DEBUG_BIT_ERROR;
+        glvndAtomicStoreRelease(&debugTypeReported, 0);
     }
 
     // Call into each vendor library.
@@ -228,11 +241,13 @@ void __eglDebugReport(EGLenum error, const char *command, EGLint type, EGLLabelK
 {
     EGLDEBUGPROCKHR callback = NULL;
 
-    __glvndPthreadFuncs.rwlock_rdlock(&debugLock);
-    if (debugTypeEnabled & DebugBitFromType(type)) {
-        callback = debugCallback;
+    if (glvndAtomicLoadAcquire(&debugTypeReported) & DebugBitFromType(type)) {
+        __glvndPthreadFuncs.rwlock_rdlock(&debugLock);
+        if (debugTypeEnabled & DebugBitFromType(type)) {
+            callback = debugCallback;
+        }
+        __glvndPthreadFuncs.rwlock_unlock(&debugLock);
     }
-    __glvndPthreadFuncs.rwlock_unlock(&debugLock);
 
     if (callback != NULL) {
         char *buf = NULL;
@@ -29,6 +29,9 @@
 
 #include <pthread.h>
 #include <string.h>
+#include <stdint.h>
+#include <assert.h>
+#include <sys/types.h>
 
 #if defined(HASH_DEBUG)
 # include <stdio.h>
@@ -37,37 +40,149 @@
 #include "libeglcurrent.h"
 #include "libeglmapping.h"
 #include "glvnd_pthread.h"
+#include "glvnd_atomic.h"
+#include "glvnd_list.h"
 #include "egldispatchstubs.h"
+#include "g_egldispatchstubs.h"
+#include "g_egldispatchhash.h"
 #include "utils_misc.h"
 #include "trace.h"
-
-#include "lkdhash.h"
+#include "glvnd_memstats.h"
+#include "proc_address_cache.h"
 
 static glvnd_mutex_t dispatchIndexMutex = GLVND_MUTEX_INITIALIZER;
 
-__EGLdeviceInfo *__eglDeviceList = NULL;
-__EGLdeviceInfo *__eglDeviceHash = NULL;
-int __eglDeviceCount = 0;
+/*!
+ * The number of dispatch indices used by the EGL functions in
+ * \c __EGL_DISPATCH_FUNC_NAMES. Those are allocated first, so they're always
+ * the indices from 0 to staticDispatchIndexCount - 1.
+ */
+static int staticDispatchIndexCount = 0;
+
+/*!
+ * The EGL dispatch functions, along with a hash table of their names that's
+ * generated at build time.
+ */
+static const __GLVNDwinsysDispatchStaticList staticDispatchList = {
+    __EGL_DISPATCH_COUNT,
+    __EGL_DISPATCH_FUNC_NAMES,
+    __EGL_DISPATCH_FUNCS,
+    __EGL_DISPATCH_HASH_SEEDS,
+    __EGL_DISPATCH_HASH_SEED_COUNT,
+    __EGL_DISPATCH_HASH_SLOTS,
+};
+
+/**
+ * A snapshot of the EGLDeviceEXT handles from every vendor.
+ *
+ * \c __eglRefreshDeviceList replaces the current snapshot whenever a vendor
+ * reports a device that isn't in it yet. Devices are never removed, so that a
+ * handle that the app got from an earlier snapshot keeps working. The old
+ * snapshots are kept in the \c retired list until teardown, since another
+ * thread might still be looking at one.
+ */
+typedef struct __EGLdeviceListRec {
+    struct __EGLdeviceListRec *retired;
+    __EGLdeviceInfo *hash;
+    EGLint count;
+    __EGLdeviceInfo devices[];
+} __EGLdeviceList;
+
+static __EGLdeviceList * volatile deviceList = NULL;
+static glvnd_mutex_t deviceListMutex = GLVND_MUTEX_INITIALIZER;
 static glvnd_once_t deviceListInitOnce = GLVND_ONCE_INIT;
 
+static void FreeDeviceLists(void);
+
 /****************************************************************************/
 
-typedef struct __EGLdisplayInfoHashRec {
+typedef struct __EGLdisplayInfoEntryRec {
     __EGLdisplayInfo info;
-    UT_hash_handle hh;
-} __EGLdisplayInfoHash;
 
-static DEFINE_INITIALIZED_LKDHASH(__EGLdisplayInfoHash, __eglDisplayInfoHash);
+    /**
+     * Every entry that was ever allocated is kept in this list, so that it can
+     * be freed at teardown. See __eglFreeDisplay.
+     */
+    struct glvnd_list entry;
+} __EGLdisplayInfoEntry;
+
+/**
+ * An open-addressed hashtable of __EGLdisplayInfoEntry pointers, keyed by the
+ * EGLDisplay handle.
+ *
+ * Lookups don't take any lock. A slot goes from NULL to an entry, and
+ * possibly from there to DISPLAY_TABLE_TOMBSTONE, but never back, so a reader
+ * can always stop at the first empty slot. Anything that modifies the table
+ * must hold \c displayTableMutex.
+ *
+ * When the table fills up, a new one is allocated and published in its place.
+ * The old table is kept around until teardown, since another thread could
+ * still be reading it.
+ */
+typedef struct __EGLdisplayTableRec {
+    struct __EGLdisplayTableRec *retired;
+    size_t size;
+    size_t used;
+    void * volatile slots[];
+} __EGLdisplayTable;
+
+#define DISPLAY_TABLE_INITIAL_SIZE 16
+#define DISPLAY_TABLE_TOMBSTONE ((void *) &displayTableTombstone)
+
+static char displayTableTombstone;
+static __EGLdisplayTable * volatile displayTable = NULL;
+static struct glvnd_list displayEntryList;
+static glvnd_mutex_t displayTableMutex = GLVND_MUTEX_INITIALIZER;
+static glvnd_lock_stats_t displayTableMutexStats;
+
+/**
+ * Incremented whenever an entry is removed from the display table, which
+ * invalidates each thread's cached display in __eglLookupDisplay. This is
+ * only modified while holding \c displayTableMutex.
+ */
+static int volatile displayInfoGeneration = 1;
+
+/**
+ * Incremented whenever a vendor is added to the vendor list, so that
+ * __eglGetEGLDispatchAddress knows to ask the vendors again about any function
+ * that it couldn't find before. This is only modified while holding
+ * \c dispatchIndexMutex.
+ */
+static int volatile vendorListGeneration = 1;
+
+/**
+ * The number of dispatch indices that every vendor has been told about with
+ * setDispatchIndex. __eglGetEGLDispatchAddress can return the dispatch
+ * function for any of these without taking \c dispatchIndexMutex. This is
+ * only modified while holding \c dispatchIndexMutex.
+ */
+static int volatile publishedIndexCount = 0;
 
 __eglMustCastToProperFunctionPointerType __eglGetEGLDispatchAddress(const char *procName)
 {
     struct glvnd_list *vendorList = __eglLoadVendors();
     __EGLvendorInfo *vendor;
     __eglMustCastToProperFunctionPointerType addr = NULL;
+    int generation;
     int index;
 
+    // Applications often look up the same unsupported functions over and
+    // over, so remember which ones no vendor has.
+    if (__glvndProcAddressCacheIsMiss(procName,
+                glvndAtomicLoadAcquire(&vendorListGeneration))) {
+        return NULL;
+    }
+
+    // Most lookups are for functions that already have a dispatch index.
+    index = __glvndWinsysDispatchFindIndex(procName);
+    if (index >= 0 && index < glvndAtomicLoadAcquire(&publishedIndexCount)) {
+        return (__eglMustCastToProperFunctionPointerType) __glvndWinsysDispatchGetDispatch(index);
+    }
+
     __glvndPthreadFuncs.mutex_lock(&dispatchIndexMutex);
+    generation = vendorListGeneration;
 
+    // Another thread might have added the function since we checked.
     index = __glvndWinsysDispatchFindIndex(procName);
     if (index >= 0) {
         addr = (__eglMustCastToProperFunctionPointerType) __glvndWinsysDispatchGetDispatch(index);
@@ -88,15 +203,52 @@ __eglMustCastToProperFunctionPointerType __eglGetEGLDispatchAddress(const char *
             glvnd_list_for_each_entry(vendor, vendorList, entry) {
                 vendor->eglvc.setDispatchIndex(procName, index);
             }
+            glvndAtomicStoreRelease(&publishedIndexCount, index + 1);
         } else {
             addr = NULL;
         }
+    } else {
+        __glvndProcAddressCacheAddMiss(procName, generation);
     }
 
     __glvndPthreadFuncs.mutex_unlock(&dispatchIndexMutex);
     return addr;
 }
 
+void __eglAddLateVendor(struct glvnd_list *prev, __EGLvendorInfo *vendor)
+{
+    struct glvnd_list *next = prev->next;
+    const char **names;
+    int count;
+    int i;
+
+    __glvndPthreadFuncs.mutex_lock(&dispatchIndexMutex);
+
+    names = NULL;
+    if (vendor->eglvc.setDispatchIndexBulk != NULL) {
+        names = __glvndWinsysDispatchGetNames(&count);
+    }
+    if (names != NULL) {
+        vendor->eglvc.setDispatchIndexBulk(names, 0, count);
+        free(names);
+    } else {
+        count = __glvndWinsysDispatchGetCount();
+        for (i=0; i<count; i++) {
+            vendor->eglvc.setDispatchIndex(__glvndWinsysDispatchGetName(i), i);
+        }
+    }
+
+    // Fill in the new entry's own links first, so that a thread walking the
+    // list forward will either skip the new vendor or see all of it.
+    vendor->entry.next = next;
+    vendor->entry.prev = prev;
+    glvndAtomicStoreReleasePtr((void * volatile *) &prev->next, &vendor->entry);
+    next->prev = &vendor->entry;
+    glvndAtomicStoreRelease(&vendorListGeneration, vendorListGeneration + 1);
+
+    __glvndPthreadFuncs.mutex_unlock(&dispatchIndexMutex);
+}
+
 __eglMustCastToProperFunctionPointerType __eglFetchDispatchEntry(
         __EGLvendorInfo *vendor, int index)
 {
@@ -109,12 +261,16 @@ __eglMustCastToProperFunctionPointerType __eglFetchDispatchEntry(
         return addr;
     }
 
+    if (vendor->staticDispatchResolved && index >= 0 && index < staticDispatchIndexCount) {
+        // We already asked the vendor for every EGL dispatch function when it
+        // was loaded, so the vendor doesn't support this one.
+        return NULL;
+    }
+
     // Not seen before by this vendor: query the vendor for the right
     // address to use.
 
-    __glvndPthreadFuncs.mutex_lock(&dispatchIndexMutex);
     procName = __glvndWinsysDispatchGetName(index);
-    __glvndPthreadFuncs.mutex_unlock(&dispatchIndexMutex);
 
     if (procName == NULL) {
         // Not a valid function index.
@@ -132,6 +288,25 @@ __eglMustCastToProperFunctionPointerType __eglFetchDispatchEntry(
     return addr;
 }
 
+void __eglResolveVendorDispatch(__EGLvendorInfo *vendor)
+{
+    int i;
+
+    for (i=0; i<__EGL_DISPATCH_FUNC_COUNT; i++) {
+        int index = __EGL_DISPATCH_FUNC_INDICES[i];
+        void *addr = vendor->eglvc.getProcAddress(__EGL_DISPATCH_FUNC_NAMES[i]);
+
+        if (addr != NULL) {
+            if (__glvndWinsysVendorDispatchAddFunc(vendor->dynDispatch, index, addr) != 0) {
+                // We couldn't record everything, so fall back to looking up
+                // functions on demand.
+                return;
+            }
+        }
+    }
+    vendor->staticDispatchResolved = EGL_TRUE;
+}
+
 __EGLvendorInfo *__eglGetVendorFromDisplay(EGLDisplay dpy)
 {
     __EGLdisplayInfo *dpyInfo = __eglLookupDisplay(dpy);
@@ -142,22 +317,103 @@ __EGLvendorInfo *__eglGetVendorFromDisplay(EGLDisplay dpy)
     }
 }
 
+static size_t DisplayHash(EGLDisplay dpy)
+{
+    uintptr_t val = (uintptr_t) dpy;
+
+    // The handles are usually heap pointers, so the low bits don't tell us
+    // much.
+    val ^= val >> 17;
+    val *= (uintptr_t) 0x9e3779b97f4a7c15ULL;
+    val ^= val >> 29;
+    return (size_t) val;
+}
+
 /**
- * Allocates and initializes a __EGLdisplayInfoHash structure.
+ * Looks up a display in a table, without taking any locks.
  *
- * The caller is responsible for adding the structure to the hashtable.
+ * \return The slot for \p dpy, or the empty slot where it would go, or -1 if
+ * it's not in the table and the table is full.
+ */
+static ssize_t FindDisplaySlot(__EGLdisplayTable *table, EGLDisplay dpy)
+{
+    size_t mask = table->size - 1;
+    size_t index = DisplayHash(dpy) & mask;
+    size_t i;
+
+    for (i=0; i<table->size; i++) {
+        __EGLdisplayInfoEntry *pEntry = (__EGLdisplayInfoEntry *)
+            glvndAtomicLoadAcquirePtr(&table->slots[index]);
+        if (pEntry == NULL) {
+            return index;
+        }
+        if (pEntry != DISPLAY_TABLE_TOMBSTONE && pEntry->info.dpy == dpy) {
+            return index;
+        }
+        index = (index + 1) & mask;
+    }
+    return -1;
+}
+
+/**
+ * Replaces the display table with a larger one.
+ *
+ * The caller must hold \c displayTableMutex.
+ */
+static EGLBoolean GrowDisplayTable(void)
+{
+    __EGLdisplayTable *oldTable = displayTable;
+    __EGLdisplayTable *newTable;
+    size_t size = DISPLAY_TABLE_INITIAL_SIZE;
+    size_t i;
+
+    if (oldTable != NULL) {
+        size = oldTable->size * 2;
+    }
+
+    newTable = (__EGLdisplayTable *) calloc(1,
+            sizeof(*newTable) + size * sizeof(newTable->slots[0]));
+    if (newTable == NULL) {
+        return EGL_FALSE;
+    }
+    glvndMemStatsAlloc(GLVND_MEM_DISPLAY,
+            sizeof(*newTable) + size * sizeof(newTable->slots[0]));
+    newTable->size = size;
+    newTable->retired = oldTable;
+
+    if (oldTable != NULL) {
+        for (i=0; i<oldTable->size; i++) {
+            __EGLdisplayInfoEntry *pEntry = (__EGLdisplayInfoEntry *) oldTable->slots[i];
+            if (pEntry != NULL && pEntry != DISPLAY_TABLE_TOMBSTONE) {
+                ssize_t slot = FindDisplaySlot(newTable, pEntry->info.dpy);
+                assert(slot >= 0);
+                newTable->slots[slot] = pEntry;
+                newTable->used++;
+            }
+        }
+    }
+
+    glvndAtomicStoreReleasePtr((void * volatile *) &displayTable, newTable);
+    return EGL_TRUE;
+}
+
+/**
+ * Allocates and initializes a __EGLdisplayInfoEntry structure.
+ *
+ * The caller is responsible for adding the structure to the table.
  *
  * \param dpy The display connection.
- * \return A newly-allocated __EGLdisplayInfoHash structure, or NULL on error.
+ * \return A newly-allocated __EGLdisplayInfoEntry structure, or NULL on error.
  */
-static __EGLdisplayInfoHash *InitDisplayInfoEntry(EGLDisplay dpy, __EGLvendorInfo *vendor)
+static __EGLdisplayInfoEntry *InitDisplayInfoEntry(EGLDisplay dpy, __EGLvendorInfo *vendor)
 {
-    __EGLdisplayInfoHash *pEntry;
+    __EGLdisplayInfoEntry *pEntry;
 
-    pEntry = (__EGLdisplayInfoHash *) calloc(1, sizeof(*pEntry));
+    pEntry = (__EGLdisplayInfoEntry *) calloc(1, sizeof(*pEntry));
     if (pEntry == NULL) {
         return NULL;
     }
+    glvndMemStatsAlloc(GLVND_MEM_DISPLAY, sizeof(*pEntry));
 
     pEntry->info.dpy = dpy;
     pEntry->info.vendor = vendor;
@@ -167,17 +423,41 @@ static __EGLdisplayInfoHash *InitDisplayInfoEntry(EGLDisplay dpy, __EGLvendorInf
 
 __EGLdisplayInfo *__eglLookupDisplay(EGLDisplay dpy)
 {
-    __EGLdisplayInfoHash *pEntry = NULL;
+    __EGLdisplayTable *table;
+    __EGLdisplayInfoEntry *pEntry = NULL;
+    __EGLThreadAPIState *threadState;
+    int generation;
+    ssize_t slot;
 
     if (dpy == EGL_NO_DISPLAY) {
         return NULL;
     }
 
-    LKDHASH_RDLOCK(__eglDisplayInfoHash);
-    HASH_FIND_PTR(_LH(__eglDisplayInfoHash), &dpy, pEntry);
-    LKDHASH_UNLOCK(__eglDisplayInfoHash);
+    generation = displayInfoGeneration;
+    threadState = __eglGetCurrentThreadAPIState(EGL_FALSE);
+    if (threadState != NULL && threadState->cachedDisplay == dpy
+            && threadState->cachedDisplayGeneration == generation) {
+        __eglNotifyVendorAPI(threadState, threadState->cachedDisplayInfo->vendor);
+        return threadState->cachedDisplayInfo;
+    }
+
+    table = (__EGLdisplayTable *) glvndAtomicLoadAcquirePtr(
+            (void * volatile *) &displayTable);
+    if (table == NULL) {
+        return NULL;
+    }
+    slot = FindDisplaySlot(table, dpy);
+    if (slot >= 0) {
+        pEntry = (__EGLdisplayInfoEntry *) glvndAtomicLoadAcquirePtr(&table->slots[slot]);
+    }
 
     if (pEntry != NULL) {
+        if (threadState != NULL) {
+            threadState->cachedDisplay = dpy;
+            threadState->cachedDisplayInfo = &pEntry->info;
+            threadState->cachedDisplayGeneration = generation;
+            __eglNotifyVendorAPI(threadState, pEntry->info.vendor);
+        }
         return &pEntry->info;
     } else {
         return NULL;
@@ -186,22 +466,42 @@ __EGLdisplayInfo *__eglLookupDisplay(EGLDisplay dpy)
 
 __EGLdisplayInfo *__eglAddDisplay(EGLDisplay dpy, __EGLvendorInfo *vendor)
 {
-    __EGLdisplayInfoHash *pEntry = NULL;
+    __EGLdisplayInfoEntry *pEntry = NULL;
+    ssize_t slot = -1;
 
     if (dpy == EGL_NO_DISPLAY) {
         return NULL;
     }
 
-    LKDHASH_WRLOCK(__eglDisplayInfoHash);
-    HASH_FIND_PTR(_LH(__eglDisplayInfoHash), &dpy, pEntry);
+    glvndProfiledMutexLock(&displayTableMutex, &displayTableMutexStats);
+    if (displayTable != NULL) {
+        slot = FindDisplaySlot(displayTable, dpy);
+        if (slot >= 0) {
+            pEntry = (__EGLdisplayInfoEntry *) displayTable->slots[slot];
+        }
+    }
+
     if (pEntry == NULL) {
-        pEntry = InitDisplayInfoEntry(dpy, vendor);
-        if (pEntry != NULL) {
-            HASH_ADD_PTR(_LH(__eglDisplayInfoHash), info.dpy, pEntry);
+        // Keep the table at most half full, counting tombstones.
+        if (displayTable == NULL || (displayTable->used + 1) * 2 > displayTable->size) {
+            if (GrowDisplayTable()) {
+                slot = FindDisplaySlot(displayTable, dpy);
+            } else {
+                slot = -1;
+            }
+        }
+
+        if (slot >= 0) {
+            pEntry = InitDisplayInfoEntry(dpy, vendor);
+            if (pEntry != NULL) {
+                glvnd_list_add(&pEntry->entry, &displayEntryList);
+                displayTable->used++;
+                glvndAtomicStoreReleasePtr(&displayTable->slots[slot], pEntry);
+            }
         }
     }
 
-    LKDHASH_UNLOCK(__eglDisplayInfoHash);
+    __glvndPthreadFuncs.mutex_unlock(&displayTableMutex);
     if (pEntry != NULL && pEntry->info.vendor == vendor) {
         return &pEntry->info;
     } else {
@@ -209,36 +509,71 @@ __EGLdisplayInfo *__eglAddDisplay(EGLDisplay dpy, __EGLvendorInfo *vendor)
     }
 }
 
+int __eglGetDisplayGeneration(void)
+{
+    return displayInfoGeneration;
+}
+
 void __eglFreeDisplay(EGLDisplay dpy)
 {
-    __EGLdisplayInfoHash *pEntry = NULL;
+    ssize_t slot;
+
+    glvndProfiledMutexLock(&displayTableMutex, &displayTableMutexStats);
+    if (displayTable != NULL) {
+        slot = FindDisplaySlot(displayTable, dpy);
+        if (slot >= 0 && displayTable->slots[slot] != NULL) {
+            // Another thread might still be looking at the entry, so leave it
+            // in displayEntryList, and free it during teardown.
+            glvndAtomicStoreReleasePtr(&displayTable->slots[slot],
+                    DISPLAY_TABLE_TOMBSTONE);
+            displayInfoGeneration++;
+        }
+    }
+    __glvndPthreadFuncs.mutex_unlock(&displayTableMutex);
+}
 
-    LKDHASH_WRLOCK(__eglDisplayInfoHash);
-    HASH_FIND_PTR(_LH(__eglDisplayInfoHash), &dpy, pEntry);
-    if (pEntry != NULL) {
-        HASH_DEL(_LH(__eglDisplayInfoHash), pEntry);
+/**
+ * Frees the display table and every display entry.
+ */
+static void FreeDisplayTable(void)
+{
+    __EGLdisplayTable *table = displayTable;
+
+    while (table != NULL) {
+        __EGLdisplayTable *next = table->retired;
+        glvndMemStatsFree(GLVND_MEM_DISPLAY,
+                sizeof(*table) + table->size * sizeof(table->slots[0]));
+        free(table);
+        table = next;
     }
-    LKDHASH_UNLOCK(__eglDisplayInfoHash);
+    displayTable = NULL;
 
-    if (pEntry != NULL) {
+    while (!glvnd_list_is_empty(&displayEntryList)) {
+        __EGLdisplayInfoEntry *pEntry = glvnd_list_first_entry(
+                &displayEntryList, __EGLdisplayInfoEntry, entry);
+        glvnd_list_del(&pEntry->entry);
+        glvndMemStatsFree(GLVND_MEM_DISPLAY, sizeof(*pEntry));
         free(pEntry);
     }
+    displayInfoGeneration++;
 }
 
 void __eglMappingInit(void)
 {
     int i;
+    glvnd_list_init(&displayEntryList);
     __eglInitDispatchStubs(&__eglExportsTable);
+    __glDispatchRegisterLockStats("EGL", "displayTableMutex",
+            &displayTableMutexStats, 1);
+
+    // The static list doesn't need to allocate or copy anything, and it gives
+    // each function the same index as in __EGL_DISPATCH_FUNC_NAMES.
+    __glvndWinsysDispatchSetStaticList(&staticDispatchList);
     for (i=0; i<__EGL_DISPATCH_FUNC_COUNT; i++) {
-        int index = __glvndWinsysDispatchAllocIndex(
-                __EGL_DISPATCH_FUNC_NAMES[i],
-                __EGL_DISPATCH_FUNCS[i]);
-        if (index < 0) {
-            fprintf(stderr, "Could not allocate dispatch index array\n");
-            abort();
-        }
-        __EGL_DISPATCH_FUNC_INDICES[i] = index;
+        __EGL_DISPATCH_FUNC_INDICES[i] = i;
     }
+    staticDispatchIndexCount = __EGL_DISPATCH_FUNC_COUNT;
+    glvndAtomicStoreRelease(&publishedIndexCount, staticDispatchIndexCount);
 }
 
 void __eglMappingTeardown(EGLBoolean doReset)
@@ -254,22 +589,28 @@ void __eglMappingTeardown(EGLBoolean doReset)
          * reset the corresponding locks.
          */
         __glvndPthreadFuncs.mutex_init(&dispatchIndexMutex, NULL);
-        __glvndPthreadFuncs.rwlock_init(&__eglDisplayInfoHash.lock, NULL);
+        __glvndPthreadFuncs.mutex_init(&displayTableMutex, NULL);
+        __glvndPthreadFuncs.mutex_init(&deviceListMutex, NULL);
     } else {
         /* Tear down all hashtables used in this file */
-        LKDHASH_TEARDOWN(__EGLdisplayInfoHash,
-                         __eglDisplayInfoHash, NULL, NULL, EGL_FALSE);
+        FreeDisplayTable();
+        FreeDeviceLists();
 
+       glvndAtomicStoreRelease(&publishedIndexCount, 0);
        __glvndWinsysDispatchCleanup();
     }
 }
 
-static EGLBoolean AddVendorDevices(__EGLvendorInfo *vendor)
+/*!
+ * Queries the devices from a vendor, and adds them to the end of \p found.
+ */
+static EGLBoolean QueryVendorDevices(__EGLvendorInfo *vendor,
+        __EGLdeviceInfo **found, EGLint *foundCount)
 {
     EGLDeviceEXT *devices = NULL;
+    __EGLdeviceInfo *newFound;
     EGLint count = 0;
-    __EGLdeviceInfo *newDevList;
-    EGLint i, j;
+    EGLint i;
 
     if (!vendor->supportsDevice) {
         return EGL_TRUE;
@@ -292,58 +633,119 @@ static EGLBoolean AddVendorDevices(__EGLvendorInfo *vendor)
         return EGL_FALSE;
     }
 
-    newDevList = (__EGLdeviceInfo *) realloc(__eglDeviceList,
-            (__eglDeviceCount + count) * sizeof(__EGLdeviceInfo));
-    if (newDevList == NULL) {
+    newFound = (__EGLdeviceInfo *) realloc(*found,
+            (*foundCount + count) * sizeof(__EGLdeviceInfo));
+    if (newFound == NULL) {
         free(devices);
         return EGL_FALSE;
     }
-    __eglDeviceList = newDevList;
+    *found = newFound;
 
     for (i=0; i<count; i++) {
-        // Make sure we haven't already gotten a device with this handle.
-        EGLBoolean found = EGL_FALSE;
-        for (j=0; j<__eglDeviceCount; j++) {
-            if (__eglDeviceList[j].handle == devices[i]) {
-                found = EGL_TRUE;
-                break;
-            }
+        newFound[*foundCount].handle = devices[i];
+        newFound[*foundCount].vendor = vendor;
+        (*foundCount)++;
+    }
+    free(devices);
+
+    return EGL_TRUE;
+}
+
+/*!
+ * Builds a new device list with everything in \p oldList, plus any devices in
+ * \p found that aren't in it yet.
+ *
+ * \return The new list, or NULL if there aren't any new devices or on
+ * allocation failure.
+ */
+static __EGLdeviceList *MergeDeviceList(__EGLdeviceList *oldList,
+        const __EGLdeviceInfo *found, EGLint foundCount)
+{
+    __EGLdeviceList *newList;
+    EGLint oldCount = (oldList != NULL ? oldList->count : 0);
+    EGLint newCount = 0;
+    EGLint i;
+
+    // Check for new devices first, so that we don't have to allocate
+    // anything in the common case where nothing has changed.
+    for (i=0; i<foundCount; i++) {
+        __EGLdeviceInfo *dev = NULL;
+        if (oldList != NULL) {
+            HASH_FIND_PTR(oldList->hash, &found[i].handle, dev);
         }
+        if (dev == NULL) {
+            newCount++;
+        }
+    }
+    if (newCount == 0 && oldList != NULL) {
+        return NULL;
+    }
+
+    newList = (__EGLdeviceList *) malloc(sizeof(__EGLdeviceList)
+            + (oldCount + newCount) * sizeof(__EGLdeviceInfo));
+    if (newList == NULL) {
+        return NULL;
+    }
+    newList->retired = oldList;
+    newList->hash = NULL;
+    newList->count = 0;
+
+    for (i=0; i<oldCount; i++) {
+        __EGLdeviceInfo *dev = &newList->devices[newList->count++];
+        dev->handle = oldList->devices[i].handle;
+        dev->vendor = oldList->devices[i].vendor;
+        HASH_ADD_PTR(newList->hash, handle, dev);
+    }
 
-        if (!found) {
-            __eglDeviceList[__eglDeviceCount].handle = devices[i];
-            __eglDeviceList[__eglDeviceCount].vendor = vendor;
-            __eglDeviceCount++;
+    // The hashtable is built as we go, so that a device that more than one
+    // vendor reports only shows up once.
+    for (i=0; i<foundCount; i++) {
+        __EGLdeviceInfo *dev;
+        HASH_FIND_PTR(newList->hash, &found[i].handle, dev);
+        if (dev == NULL) {
+            dev = &newList->devices[newList->count++];
+            dev->handle = found[i].handle;
+            dev->vendor = found[i].vendor;
+            HASH_ADD_PTR(newList->hash, handle, dev);
         }
     }
-    free(devices);
 
-    return EGL_TRUE;
+    return newList;
 }
 
-void InitDeviceListInternal(void)
+void __eglRefreshDeviceList(void)
 {
     struct glvnd_list *vendorList = __eglLoadVendors();
     __EGLvendorInfo *vendor;
-    EGLint i;
+    __EGLdeviceInfo *found = NULL;
+    EGLint foundCount = 0;
+    __EGLdeviceList *newList;
 
-    __eglDeviceList = NULL;
-    __eglDeviceHash = NULL;
-    __eglDeviceCount = 0;
+    __glvndPthreadFuncs.mutex_lock(&deviceListMutex);
 
     glvnd_list_for_each_entry(vendor, vendorList, entry) {
-        if (!AddVendorDevices(vendor)) {
-            free(__eglDeviceList);
-            __eglDeviceList = NULL;
-            __eglDeviceCount = 0;
-            return;
+        if (!QueryVendorDevices(vendor, &found, &foundCount)) {
+            // Keep whatever list we had before.
+            goto done;
         }
     }
 
-    // Build a hashtable for the devices.
-    for (i=0; i<__eglDeviceCount; i++) {
-        __EGLdeviceInfo *dev = &__eglDeviceList[i];
-        HASH_ADD_PTR(__eglDeviceHash, handle, dev);
+    newList = MergeDeviceList(deviceList, found, foundCount);
+    if (newList != NULL) {
+        glvndAtomicStoreReleasePtr((void * volatile *) &deviceList, newList);
+    }
+
+done:
+    __glvndPthreadFuncs.mutex_unlock(&deviceListMutex);
+    free(found);
+}
+
+static void InitDeviceListInternal(void)
+{
+    // If eglQueryDevicesEXT already built the list, then there's nothing else
+    // to do here.
+    if (glvndAtomicLoadAcquirePtr((void * volatile *) &deviceList) == NULL) {
+        __eglRefreshDeviceList();
     }
 }
 
@@ -352,13 +754,44 @@ void __eglInitDeviceList(void)
     __glvndPthreadFuncs.once(&deviceListInitOnce, InitDeviceListInternal);
 }
 
+const __EGLdeviceInfo *__eglGetDeviceList(EGLint *deviceCount)
+{
+    __EGLdeviceList *list = (__EGLdeviceList *)
+        glvndAtomicLoadAcquirePtr((void * volatile *) &deviceList);
+
+    if (list != NULL) {
+        *deviceCount = list->count;
+        return list->devices;
+    } else {
+        *deviceCount = 0;
+        return NULL;
+    }
+}
+
+static void FreeDeviceLists(void)
+{
+    __EGLdeviceList *list = deviceList;
+
+    while (list != NULL) {
+        __EGLdeviceList *next = list->retired;
+        HASH_CLEAR(hh, list->hash);
+        free(list);
+        list = next;
+    }
+    deviceList = NULL;
+}
+
 __EGLvendorInfo *__eglGetVendorFromDevice(EGLDeviceEXT dev)
 {
-    __EGLdeviceInfo *devInfo;
+    __EGLdeviceList *list;
+    __EGLdeviceInfo *devInfo = NULL;
 
     __eglInitDeviceList();
 
-    HASH_FIND_PTR(__eglDeviceHash, &dev, devInfo);
+    list = (__EGLdeviceList *) glvndAtomicLoadAcquirePtr((void * volatile *) &deviceList);
+    if (list != NULL) {
+        HASH_FIND_PTR(list->hash, &dev, devInfo);
+    }
     if (devInfo != NULL) {
         return devInfo->vendor;
     } else {
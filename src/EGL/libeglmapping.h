@@ -33,7 +33,10 @@
 #include "glvnd_pthread.h"
 #include "libeglabipriv.h"
 #include "GLdispatch.h"
-#include "lkdhash.h"
+#include "glvnd_hash.h"
+
+#define HASH_FUNCTION GLVND_UTHASH_FUNCTION
+#include "uthash.h"
 #include "libeglvendor.h"
 
 /*!
@@ -54,10 +57,6 @@ typedef struct __EGLdeviceInfoRec {
     UT_hash_handle hh;
 } __EGLdeviceInfo;
 
-extern __EGLdeviceInfo *__eglDeviceList;
-extern __EGLdeviceInfo *__eglDeviceHash;
-extern int __eglDeviceCount;
-
 void __eglThreadInitialize(void);
 
 /*!
@@ -68,17 +67,31 @@ void __eglMappingInit(void);
 /*!
  * Initializes the EGLDeviceEXT list and hashtable.
  *
- * This function must be called before trying to access the \c __eglDeviceList
- * array.
+ * This function must be called before calling \c __eglGetDeviceList.
  */
 void __eglInitDeviceList(void);
 
+/*!
+ * Queries the devices from every vendor again, and adds any new ones to the
+ * device list.
+ *
+ * Devices are never removed from the list, so a handle from an earlier call
+ * to \c __eglGetDeviceList stays valid.
+ */
+void __eglRefreshDeviceList(void);
+
 /*!
  * This handles freeing all mapping state during library teardown
  * or resetting locks on fork recovery.
  */
 void __eglMappingTeardown(EGLBoolean doReset);
 
+/*!
+ * Returns the current snapshot of the device list.
+ *
+ * The returned array stays valid until libEGL is torn down, even if another
+ * thread refreshes the list.
+ */
 const __EGLdeviceInfo *__eglGetDeviceList(EGLint *deviceCount);
 
 /*!
@@ -103,6 +116,12 @@ __EGLdisplayInfo *__eglAddDisplay(EGLDisplay dpy, __EGLvendorInfo *vendor);
  */
 void __eglFreeDisplay(EGLDisplay dpy);
 
+/*!
+ * Returns a counter that changes whenever a display is removed, so that a
+ * cached EGLDisplay handle can be checked without looking it up again.
+ */
+int __eglGetDisplayGeneration(void);
+
 __EGLvendorInfo *__eglGetVendorFromDisplay(EGLDisplay dpy);
 
 /*!
@@ -112,8 +131,29 @@ __EGLvendorInfo *__eglGetVendorFromDisplay(EGLDisplay dpy);
  */
 __eglMustCastToProperFunctionPointerType __eglGetEGLDispatchAddress(const char *procName);
 
+/*!
+ * Adds a vendor library that was loaded after the vendor list was first
+ * populated.
+ *
+ * This tells the vendor about every dispatch index that has been assigned so
+ * far, and then inserts it into the vendor list after \p prev. Both happen
+ * while holding the same lock as \c __eglGetEGLDispatchAddress, so the vendor
+ * can't miss an index that's assigned in between.
+ *
+ * Other threads may walk the vendor list without a lock, so the vendor
+ * structure must be fully initialized before calling this.
+ */
+void __eglAddLateVendor(struct glvnd_list *prev, __EGLvendorInfo *vendor);
+
 __eglMustCastToProperFunctionPointerType __eglFetchDispatchEntry(__EGLvendorInfo *vendor, int index);
 
+/*!
+ * Looks up every function in \c __EGL_DISPATCH_FUNC_NAMES from a vendor and
+ * stores them in the vendor's dispatch table, so that
+ * \c __eglFetchDispatchEntry never has to call into the vendor for them.
+ */
+void __eglResolveVendorDispatch(__EGLvendorInfo *vendor);
+
 __EGLvendorInfo *__eglGetVendorFromDevice(EGLDeviceEXT dev);
 
 void __eglSetError(EGLint errorCode);
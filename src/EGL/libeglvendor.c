@@ -9,66 +9,312 @@
 #include <unistd.h>
 #include <fnmatch.h>
 #include <dirent.h>
+#include <fcntl.h>
+#include <time.h>
 
 #include "glvnd_pthread.h"
+#include "glvnd_atomic.h"
+#include "glvnd_probe.h"
+#include "glvnd_memstats.h"
+#include "glvnd_hash.h"
 #include "libeglcurrent.h"
 #include "libeglmapping.h"
+#include "libeglvendorcache.h"
 #include "utils_misc.h"
 #include "glvnd_list.h"
-#include "cJSON.h"
+#include "glvnd_json.h"
 #include "egldispatchstubs.h"
 
 #define FILE_FORMAT_VERSION_MAJOR 1
-#define FILE_FORMAT_VERSION_MINOR 0
+#define FILE_FORMAT_VERSION_MINOR 2
+
+/*!
+ * The config file format version to record in the vendor config cache, so
+ * that a cache that was written by an older libEGL isn't used.
+ */
+#define CACHE_FORMAT_VERSION ((FILE_FORMAT_VERSION_MAJOR << 16) | FILE_FORMAT_VERSION_MINOR)
+
+/*!
+ * The maximum number of threads to use to read config files when
+ * __EGL_VENDOR_LIBRARY_PREFETCH is set.
+ */
+#define PREFETCH_MAX_THREADS 4
+
+/*!
+ * The block size for each vendor's arena. This is enough for the vendor
+ * structure and its first EGL dispatch table.
+ */
+#define VENDOR_ARENA_BLOCK_SIZE 2048
+
+/*!
+ * Maps the platform names that can show up in a config file to their enums.
+ */
+static const struct {
+    const char *name;
+    EGLenum platform;
+} PLATFORM_NAMES[] = {
+    { "device", EGL_PLATFORM_DEVICE_EXT },
+    { "gbm", EGL_PLATFORM_GBM_KHR },
+    { "surfaceless", EGL_PLATFORM_SURFACELESS_MESA },
+    { "wayland", EGL_PLATFORM_WAYLAND_KHR },
+    { "x11", EGL_PLATFORM_X11_KHR },
+};
 
 static void LoadVendors(void);
 static void TeardownVendor(__EGLvendorInfo *vendor);
 static __EGLvendorInfo *LoadVendor(const char *filename);
 
-static void LoadVendorsFromConfigDir(const char *dirName);
-static __EGLvendorInfo *LoadVendorFromConfigFile(const char *filename);
-static cJSON *ReadJSONFile(const char *filename);
+static void AddVendorConfigFile(__EGLvendorConfigList *list, char *filename);
+static void AddVendorConfigsFromDir(__EGLvendorConfigList *list, const char *dirName);
+static EGLBoolean ReadVendorConfigFile(const char *filename, __EGLvendorConfig *config);
+static void FreeVendorConfig(__EGLvendorConfig *config);
+static void TakeVendorConfig(__EGLvendorInfo *vendor, __EGLvendorConfig *config);
+static void LoadDeferredVendors(EGLenum platform);
+static void PrefetchVendorConfigs(__EGLvendorConfigList *list);
+static void InitClientExtensionHash(void);
 
 static glvnd_once_t loadVendorsOnceControl = GLVND_ONCE_INIT;
 static struct glvnd_list __eglVendorList;
 
+/// The next value for \c __EGLvendorInfo::apiIndex.
+static int nextVendorAPIIndex = 0;
+
+/*!
+ * The vendors that haven't been loaded yet because nothing has asked for one
+ * of their platforms. These are only modified while holding
+ * \c deferredVendorMutex.
+ */
+static __EGLvendorConfig *deferredVendors = NULL;
+static int deferredVendorCount = 0;
+static glvnd_mutex_t deferredVendorMutex = GLVND_MUTEX_INITIALIZER;
+
+/*!
+ * The number of entries in \c deferredVendors that haven't been loaded. This
+ * lets \c __eglLoadVendors skip the mutex once every vendor is loaded.
+ */
+static int volatile deferredVendorsRemaining = 0;
+
+/*!
+ * If true, then look up each vendor's EGL dispatch functions the first time
+ * they're called, instead of when the vendor is loaded. This is set with
+ * __EGL_LAZY_DISPATCH.
+ */
+static EGLBoolean lazyDispatch = EGL_FALSE;
+
 void LoadVendors(void)
 {
+    __EGLvendorConfigList list = {};
     const char *env = NULL;
+    const char *cachePath = NULL;
     char **tokens;
+    char **dirs = NULL;
+    EGLBoolean cached = EGL_FALSE;
+    time_t startTime = 0;
     int i;
 
+    env = glvndGetEnv("__EGL_LAZY_DISPATCH");
+    if (env != NULL && atoi(env) != 0) {
+        lazyDispatch = EGL_TRUE;
+    }
+    env = NULL;
+
     // First, check to see if a list of vendors was specified.
     if (getuid() == geteuid() && getgid() == getegid()) {
-        env = getenv("__EGL_VENDOR_LIBRARY_FILENAMES");
+        env = glvndGetEnv("__EGL_VENDOR_LIBRARY_FILENAMES");
     }
     if (env != NULL) {
         tokens = SplitString(env, NULL, ":");
         if (tokens != NULL) {
             for (i=0; tokens[i] != NULL; i++) {
-                LoadVendorFromConfigFile(tokens[i]);
+                AddVendorConfigFile(&list, strdup(tokens[i]));
             }
             free(tokens);
         }
-        return;
+    } else {
+        // We didn't get a list of vendors, so look through the vendor config
+        // directories.
+        if (getuid() == geteuid() && getgid() == getegid()) {
+            env = glvndGetEnv("__EGL_VENDOR_LIBRARY_DIRS");
+        }
+        if (env == NULL) {
+            env = DEFAULT_EGL_VENDOR_CONFIG_DIRS;
+        }
+
+        dirs = SplitString(env, NULL, ":");
+        if (dirs != NULL) {
+            if (getuid() == geteuid() && getgid() == getegid()) {
+                cachePath = glvndGetEnv("__EGL_VENDOR_CONFIG_CACHE");
+                if (cachePath != NULL && cachePath[0] == '\0') {
+                    cachePath = NULL;
+                }
+            }
+            GLDISPATCH_TRACE(1, GLDISPATCH_TRACE_PHASE_BEGIN,
+                    GLDISPATCH_PHASE_CONFIG_SCAN, GLDISPATCH_API_EGL);
+            if (cachePath != NULL) {
+                cached = __eglReadVendorConfigCache(cachePath, dirs,
+                        CACHE_FORMAT_VERSION, &list);
+            }
+
+            if (!cached) {
+                startTime = time(NULL);
+                for (i=0; dirs[i] != NULL; i++) {
+                    AddVendorConfigsFromDir(&list, dirs[i]);
+                }
+            }
+            GLDISPATCH_TRACE(1, GLDISPATCH_TRACE_PHASE_END,
+                    GLDISPATCH_PHASE_CONFIG_SCAN, GLDISPATCH_API_EGL);
+        }
     }
 
-    // We didn't get a list of vendors, so look through the vendor config
-    // directories.
-    if (getuid() == geteuid() && getgid() == getegid()) {
-        env = getenv("__EGL_VENDOR_LIBRARY_DIRS");
+    if (list.count == 0) {
+        goto done;
     }
-    if (env == NULL) {
-        env = DEFAULT_EGL_VENDOR_CONFIG_DIRS;
+
+    if (!cached) {
+        list.configs = (__EGLvendorConfig *) calloc(list.count, sizeof(__EGLvendorConfig));
+        if (list.configs == NULL) {
+            goto done;
+        }
+
+        env = NULL;
+        if (getuid() == geteuid() && getgid() == getegid()) {
+            env = glvndGetEnv("__EGL_VENDOR_LIBRARY_PREFETCH");
+        }
+        GLDISPATCH_TRACE(1, GLDISPATCH_TRACE_PHASE_BEGIN,
+                GLDISPATCH_PHASE_CONFIG_PARSE, GLDISPATCH_API_EGL);
+        if (env != NULL && atoi(env) != 0) {
+            PrefetchVendorConfigs(&list);
+        } else {
+            for (i=0; i<list.count; i++) {
+                ReadVendorConfigFile(list.filenames[i], &list.configs[i]);
+            }
+        }
+        GLDISPATCH_TRACE(1, GLDISPATCH_TRACE_PHASE_END,
+                GLDISPATCH_PHASE_CONFIG_PARSE, GLDISPATCH_API_EGL);
+
+        if (cachePath != NULL) {
+            __eglWriteVendorConfigCache(cachePath, dirs, CACHE_FORMAT_VERSION,
+                    &list, startTime);
+        }
     }
 
-    tokens = SplitString(env, NULL, ":");
-    if (tokens != NULL) {
-        for (i=0; tokens[i] != NULL; i++) {
-            LoadVendorsFromConfigDir(tokens[i]);
+    // Load the vendors themselves in order, since that determines their
+    // priority. Any vendor that lists its platforms is set aside instead, to
+    // be loaded by LoadDeferredVendors.
+    for (i=0; i<list.count; i++) {
+        __EGLvendorConfig *config = &list.configs[i];
+        __EGLvendorInfo *vendor;
+
+        config->priority = i;
+        if (config->libraryPath == NULL) {
+            continue;
+        }
+
+        if (config->platformCount > 0) {
+            if (deferredVendors == NULL) {
+                deferredVendors = (__EGLvendorConfig *) malloc(list.count * sizeof(__EGLvendorConfig));
+            }
+            if (deferredVendors != NULL) {
+                deferredVendors[deferredVendorCount++] = *config;
+                memset(config, 0, sizeof(*config));
+                continue;
+            }
+        }
+
+        vendor = LoadVendor(config->libraryPath);
+        if (vendor != NULL) {
+            TakeVendorConfig(vendor, config);
+            glvnd_list_append(&vendor->entry, &__eglVendorList);
         }
-        free(tokens);
     }
+    deferredVendorsRemaining = deferredVendorCount;
+
+done:
+    for (i=0; i<list.count; i++) {
+        free(list.filenames[i]);
+        if (list.configs != NULL) {
+            FreeVendorConfig(&list.configs[i]);
+        }
+    }
+    free(list.filenames);
+    free(list.configs);
+    free(dirs);
+}
+
+/*!
+ * Loads any deferred vendors that support \p platform, or every deferred
+ * vendor if \p platform is \c EGL_NONE.
+ */
+static void LoadDeferredVendors(EGLenum platform)
+{
+    int i, j;
+
+    __glvndPthreadFuncs.mutex_lock(&deferredVendorMutex);
+
+    for (i=0; i<deferredVendorCount; i++) {
+        __EGLvendorConfig *config = &deferredVendors[i];
+        __EGLvendorInfo *vendor;
+        struct glvnd_list *prev;
+        __EGLvendorInfo *other;
+        EGLBoolean match = (platform == EGL_NONE);
+
+        if (config->libraryPath == NULL) {
+            // We've already loaded this one, or tried to.
+            continue;
+        }
+        for (j=0; j<config->platformCount && !match; j++) {
+            if (config->platforms[j] == platform) {
+                match = EGL_TRUE;
+            }
+        }
+        if (!match) {
+            continue;
+        }
+
+        vendor = LoadVendor(config->libraryPath);
+        if (vendor != NULL) {
+            // Find where the vendor would have gone if we'd loaded it up
+            // front.
+            TakeVendorConfig(vendor, config);
+            prev = &__eglVendorList;
+            glvnd_list_for_each_entry(other, &__eglVendorList, entry) {
+                if (other->priority > vendor->priority) {
+                    break;
+                }
+                prev = &other->entry;
+            }
+            __eglAddLateVendor(prev, vendor);
+        }
+
+        FreeVendorConfig(config);
+        glvndAtomicStoreRelease(&deferredVendorsRemaining, deferredVendorsRemaining - 1);
+    }
+
+    __glvndPthreadFuncs.mutex_unlock(&deferredVendorMutex);
+}
+
+/*!
+ * Adds a file to a vendor config list. This takes ownership of \p filename.
+ */
+static void AddVendorConfigFile(__EGLvendorConfigList *list, char *filename)
+{
+    if (filename == NULL) {
+        fprintf(stderr, "ERROR: Could not allocate vendor library path name\n");
+        return;
+    }
+
+    if (list->count == list->allocCount) {
+        int newSize = (list->allocCount > 0 ? list->allocCount * 2 : 8);
+        char **newList = (char **) realloc(list->filenames, newSize * sizeof(char *));
+        if (newList == NULL) {
+            free(filename);
+            return;
+        }
+        list->filenames = newList;
+        list->allocCount = newSize;
+    }
+
+    list->filenames[list->count++] = filename;
 }
 
 static int ScandirFilter(const struct dirent *ent)
@@ -93,7 +339,7 @@ static int CompareFilenames(const struct dirent **ent1, const struct dirent **en
     return strcmp((*ent1)->d_name, (*ent2)->d_name);
 }
 
-void LoadVendorsFromConfigDir(const char *dirName)
+void AddVendorConfigsFromDir(__EGLvendorConfigList *list, const char *dirName)
 {
     struct dirent **entries = NULL;
     size_t dirnameLen;
@@ -117,24 +363,136 @@ void LoadVendorsFromConfigDir(const char *dirName)
 
     for (i=0; i<count; i++) {
         char *path = NULL;
-        if (glvnd_asprintf(&path, "%s%s%s", dirName, pathSep, entries[i]->d_name) > 0) {
-            LoadVendorFromConfigFile(path);
-            free(path);
-        } else {
-            fprintf(stderr, "ERROR: Could not allocate vendor library path name\n");
+        if (glvnd_asprintf(&path, "%s%s%s", dirName, pathSep, entries[i]->d_name) <= 0) {
+            path = NULL;
         }
+        AddVendorConfigFile(list, path);
         free(entries[i]);
     }
 
     free(entries);
 }
 
+typedef struct __EGLvendorPrefetchStateRec {
+    __EGLvendorConfigList *list;
+    glvnd_mutex_t mutex;
+    int next;
+} __EGLvendorPrefetchState;
+
+/*!
+ * Asks the kernel to start reading a vendor library into the page cache, so
+ * that the dlopen call in LoadVendor doesn't have to wait for it.
+ *
+ * This only works for absolute paths. Figuring out where a bare filename would
+ * come from means duplicating dlopen's search logic, so those are left alone.
+ */
+static void PrefetchVendorLibrary(const char *libraryPath)
+{
+#if defined(POSIX_FADV_WILLNEED)
+    int fd;
+
+    if (libraryPath[0] != '/') {
+        return;
+    }
+
+    fd = open(libraryPath, O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+        posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+        close(fd);
+    }
+#endif
+}
+
+static void *PrefetchThreadProc(void *param)
+{
+    __EGLvendorPrefetchState *state = (__EGLvendorPrefetchState *) param;
+
+    while (1) {
+        int index;
+
+        __glvndPthreadFuncs.mutex_lock(&state->mutex);
+        index = state->next++;
+        __glvndPthreadFuncs.mutex_unlock(&state->mutex);
+
+        if (index >= state->list->count) {
+            break;
+        }
+
+        // Each thread only writes to its own slots in configs, so this
+        // doesn't need the mutex.
+        if (ReadVendorConfigFile(state->list->filenames[index], &state->list->configs[index])) {
+            PrefetchVendorLibrary(state->list->configs[index].libraryPath);
+        }
+    }
+    return NULL;
+}
+
+/*!
+ * Reads every config file in \p list, and starts prefetching the vendor
+ * libraries, using a few worker threads.
+ *
+ * This fills in \c list->configs. The vendors themselves are still
+ * loaded afterward, on the calling thread and in order.
+ */
+static void PrefetchVendorConfigs(__EGLvendorConfigList *list)
+{
+    __EGLvendorPrefetchState state;
+    glvnd_thread_t threads[PREFETCH_MAX_THREADS];
+    int threadCount = 0;
+    int i;
+
+    state.list = list;
+    state.next = 0;
+    __glvndPthreadFuncs.mutex_init(&state.mutex, NULL);
+
+    // If we don't have real threads, then the calling thread will just end up
+    // doing all of the work below.
+    if (!__glvndPthreadFuncs.is_singlethreaded) {
+        int maxThreads = list->count - 1;
+        if (maxThreads > PREFETCH_MAX_THREADS) {
+            maxThreads = PREFETCH_MAX_THREADS;
+        }
+        for (threadCount=0; threadCount<maxThreads; threadCount++) {
+            if (__glvndPthreadFuncs.create(&threads[threadCount], NULL,
+                        PrefetchThreadProc, &state) != 0) {
+                break;
+            }
+        }
+    }
+
+    PrefetchThreadProc(&state);
+
+    for (i=0; i<threadCount; i++) {
+        __glvndPthreadFuncs.join(threads[i], NULL);
+    }
+    __glvndPthreadFuncs.mutex_destroy(&state.mutex);
+}
+
 void __eglInitVendors(void)
 {
     glvnd_list_init(&__eglVendorList);
+    InitClientExtensionHash();
 }
 
 struct glvnd_list *__eglLoadVendors(void)
+{
+    __glvndPthreadFuncs.once(&loadVendorsOnceControl, LoadVendors);
+    if (glvndAtomicLoadAcquire(&deferredVendorsRemaining) > 0) {
+        LoadDeferredVendors(EGL_NONE);
+    }
+    return &__eglVendorList;
+}
+
+struct glvnd_list *__eglLoadVendorsForPlatform(EGLenum platform)
+{
+    __glvndPthreadFuncs.once(&loadVendorsOnceControl, LoadVendors);
+    if (glvndAtomicLoadAcquire(&deferredVendorsRemaining) > 0) {
+        LoadDeferredVendors(platform);
+    }
+    return &__eglVendorList;
+}
+
+struct glvnd_list *__eglGetLoadedVendors(void)
 {
     __glvndPthreadFuncs.once(&loadVendorsOnceControl, LoadVendors);
     return &__eglVendorList;
@@ -144,12 +502,21 @@ void __eglTeardownVendors(void)
 {
     __EGLvendorInfo *vendor;
     __EGLvendorInfo *vendorTemp;
+    int i;
 
     glvnd_list_for_each_entry_safe(vendor, vendorTemp, &__eglVendorList, entry) {
         glvnd_list_del(&vendor->entry);
         __glDispatchForceUnpatch(vendor->vendorID);
         TeardownVendor(vendor);
     }
+
+    for (i=0; i<deferredVendorCount; i++) {
+        FreeVendorConfig(&deferredVendors[i]);
+    }
+    free(deferredVendors);
+    deferredVendors = NULL;
+    deferredVendorCount = 0;
+    deferredVendorsRemaining = 0;
 }
 
 const __EGLapiExports __eglExportsTable = {
@@ -168,9 +535,16 @@ const __EGLapiExports __eglExportsTable = {
 
 void TeardownVendor(__EGLvendorInfo *vendor)
 {
+    int i;
+
     if (vendor->glDispatch) {
         __glDispatchDestroyTable(vendor->glDispatch);
     }
+    for (i=1; i<__EGL_DISPATCH_VARIANT_COUNT; i++) {
+        if (vendor->dispatchVariants[i].table != NULL) {
+            __glDispatchDestroyTable(vendor->dispatchVariants[i].table);
+        }
+    }
 
     /* Clean up the dynamic dispatch table */
     if (vendor->dynDispatch != NULL) {
@@ -182,19 +556,30 @@ void TeardownVendor(__EGLvendorInfo *vendor)
         dlclose(vendor->dlhandle);
     }
 
-    free(vendor);
+    free(vendor->preferredPlatforms);
+
+    // This also frees the vendor structure itself.
+    __glvndArenaDestroy(vendor->arena);
 }
 
 static GLboolean LookupVendorEntrypoints(__EGLvendorInfo *vendor)
 {
     memset(&vendor->staticDispatch, 0, sizeof(vendor->staticDispatch));
 
+    // If the vendor can hand over its whole table, then we only need to look
+    // up whatever it left out by name.
+    if (vendor->eglvc.getStaticDispatch != NULL) {
+        vendor->eglvc.getStaticDispatch(&vendor->staticDispatch);
+    }
+
     // TODO: A lot of these should be implemented (and probably generated) as
     // normal EGL dispatch functions, instead of having to special-case them.
 
 #define LOADENTRYPOINT(ptr, name) do { \
-    vendor->staticDispatch.ptr = vendor->eglvc.getProcAddress(name); \
-    if (vendor->staticDispatch.ptr == NULL) { return GL_FALSE; } \
+    if (vendor->staticDispatch.ptr == NULL) { \
+        vendor->staticDispatch.ptr = vendor->eglvc.getProcAddress(name); \
+        if (vendor->staticDispatch.ptr == NULL) { return GL_FALSE; } \
+    } \
     } while(0)
 
     LOADENTRYPOINT(initialize,                    "eglInitialize"                    );
@@ -228,7 +613,9 @@ static GLboolean LookupVendorEntrypoints(__EGLvendorInfo *vendor)
 
     // The remaining functions here are optional.
 #define LOADENTRYPOINT(ptr, name) \
-    vendor->staticDispatch.ptr = vendor->eglvc.getProcAddress(name);
+    if (vendor->staticDispatch.ptr == NULL) { \
+        vendor->staticDispatch.ptr = vendor->eglvc.getProcAddress(name); \
+    }
 
     LOADENTRYPOINT(bindAPI,                       "eglBindAPI"                       );
     LOADENTRYPOINT(createSync,                    "eglCreateSync"                    );
@@ -250,12 +637,89 @@ static GLboolean LookupVendorEntrypoints(__EGLvendorInfo *vendor)
     return GL_TRUE;
 }
 
+/*!
+ * If the vendor has an array of its OpenGL functions in our slot order, then
+ * hands it to the dispatch table, so that it doesn't have to look up each
+ * function by name.
+ */
+static void SetVendorStaticFuncs(__EGLvendorInfo *vendor)
+{
+    const void * const *funcs;
+    uint32_t layoutHash;
+    int count = 0;
+
+    if (vendor->eglvc.getGLStaticFuncs == NULL) {
+        return;
+    }
+    layoutHash = __glDispatchGetTableLayout(NULL);
+    funcs = vendor->eglvc.getGLStaticFuncs(layoutHash, &count);
+    if (funcs != NULL) {
+        __glDispatchSetTableStaticFuncs(vendor->glDispatch, layoutHash, funcs, count);
+    }
+}
+
 static void *VendorGetProcAddressCallback(const char *procName, void *param)
 {
     __EGLvendorInfo *vendor = (__EGLvendorInfo *) param;
     return vendor->eglvc.getProcAddress(procName);
 }
 
+static void VendorGetProcAddressBulkCallback(const char * const *procNames,
+        void **procs, int count, void *param)
+{
+    __EGLvendorInfo *vendor = (__EGLvendorInfo *) param;
+    vendor->eglvc.getProcAddressBulk(procNames, procs, count);
+}
+
+static void *VariantGetProcAddressCallback(const char *procName, void *param)
+{
+    __EGLdispatchVariant *dv = (__EGLdispatchVariant *) param;
+    return dv->vendor->eglvc.getVariantProcAddress(dv->variant, procName);
+}
+
+__GLdispatchTable *__eglGetContextDispatchTable(__EGLvendorInfo *vendor,
+        EGLDisplay dpy, EGLContext context)
+{
+    __EGLdispatchVariant *dv;
+    __GLdispatchTable *table;
+    int variant;
+
+    if (vendor->eglvc.getContextDispatchVariant == NULL) {
+        return vendor->glDispatch;
+    }
+
+    variant = vendor->eglvc.getContextDispatchVariant(dpy, context);
+    if (variant <= 0 || variant >= __EGL_DISPATCH_VARIANT_COUNT) {
+        return vendor->glDispatch;
+    }
+
+    dv = &vendor->dispatchVariants[variant];
+    table = (__GLdispatchTable *) glvndAtomicLoadAcquirePtr((void * volatile *) &dv->table);
+    if (table == NULL) {
+        // Two threads could get here at the same time. Whichever one loses
+        // the race just throws its table away.
+        __GLdispatchTable *newTable = __glDispatchCreateTable(
+                VariantGetProcAddressCallback, dv);
+        char tag[32];
+
+        if (newTable == NULL) {
+            // The default table still works, it's just not as specialized.
+            return vendor->glDispatch;
+        }
+        snprintf(tag, sizeof(tag), "egl-variant%d", variant);
+        __glDispatchSetTableVendor(newTable, vendor->dlhandle, tag);
+        if (glvndAtomicCompareExchangePtr((void * volatile *) &dv->table,
+                    NULL, newTable)) {
+            table = newTable;
+        } else {
+            __glDispatchDestroyTable(newTable);
+            table = (__GLdispatchTable *) glvndAtomicLoadAcquirePtr(
+                    (void * volatile *) &dv->table);
+        }
+    }
+    return table;
+}
+
 static EGLBoolean CheckFormatVersion(const char *versionStr)
 {
     int major, minor, rev;
@@ -286,135 +750,431 @@ static EGLBoolean CheckFormatVersion(const char *versionStr)
     return EGL_TRUE;
 }
 
-static __EGLvendorInfo *LoadVendorFromConfigFile(const char *filename)
+/*!
+ * Looks up a platform name from a config file.
+ *
+ * The name can be one of the names in \c PLATFORM_NAMES, or a number, which
+ * lets a vendor list a platform enum that libEGL doesn't know about.
+ *
+ * \return The platform enum, or EGL_NONE if \p name isn't recognized.
+ */
+static EGLenum LookupPlatformName(const char *name)
 {
-    __EGLvendorInfo *vendor = NULL;
-    cJSON *root;
-    cJSON *node;
-    cJSON *icdNode;
-    const char *libraryPath;
+    unsigned long value;
+    char *end;
+    size_t i;
 
-    root = ReadJSONFile(filename);
-    if (root == NULL) {
-        goto done;
+    for (i=0; i<ARRAY_LEN(PLATFORM_NAMES); i++) {
+        if (strcmp(name, PLATFORM_NAMES[i].name) == 0) {
+            return PLATFORM_NAMES[i].platform;
+        }
     }
 
-    node = cJSON_GetObjectItem(root, "file_format_version");
-    if (node == NULL || node->type != cJSON_String) {
-        goto done;
+    value = strtoul(name, &end, 0);
+    if (end != name && *end == '\0' && value != 0 && value <= 0xFFFFFFFF) {
+        return (EGLenum) value;
     }
-    if (!CheckFormatVersion(node->valuestring)) {
-        goto done;
+    return EGL_NONE;
+}
+
+/*!
+ * Reads the optional list of platforms from the ICD object of a config file.
+ *
+ * If the list contains a platform that we don't recognize, then we can't tell
+ * when the vendor might be needed, so that's treated the same as not having a
+ * list at all.
+ *
+ * \return EGL_FALSE if the platform list is malformed.
+ */
+static EGLBoolean ReadVendorPlatforms(const __GLVNDjsonReader *listReader,
+        __EGLvendorConfig *config)
+{
+    __GLVNDjsonReader reader;
+    __GLVNDjsonString item;
+    char name[64];
+    int count;
+    int ret;
+    int i;
+
+    if (listReader == NULL) {
+        return EGL_TRUE;
     }
 
-    icdNode = cJSON_GetObjectItem(root, "ICD");
-    if (icdNode == NULL || icdNode->type != cJSON_Object) {
-        goto done;
+    // Count the elements first, so that we can allocate the array.
+    reader = *listReader;
+    if (!__glvndJsonBeginArray(&reader)) {
+        return EGL_FALSE;
+    }
+    count = 0;
+    while ((ret = __glvndJsonNextElement(&reader)) > 0) {
+        if (!__glvndJsonReadString(&reader, &item)) {
+            return EGL_FALSE;
+        }
+        count++;
+    }
+    if (ret < 0) {
+        return EGL_FALSE;
+    }
+    if (count <= 0) {
+        return EGL_TRUE;
     }
 
-    node = cJSON_GetObjectItem(icdNode, "library_path");
-    if (node == NULL || node->type != cJSON_String) {
-        goto done;
+    config->platforms = (EGLenum *) malloc(count * sizeof(EGLenum));
+    if (config->platforms == NULL) {
+        // We can still load the vendor, just not lazily.
+        return EGL_TRUE;
     }
-    libraryPath = node->valuestring;
-    vendor = LoadVendor(libraryPath);
 
-done:
-    if (root != NULL) {
-        cJSON_Delete(root);
+    reader = *listReader;
+    __glvndJsonBeginArray(&reader);
+    for (i=0; i<count; i++) {
+        __glvndJsonNextElement(&reader);
+        __glvndJsonReadString(&reader, &item);
+        ret = __glvndJsonDecodeString(&item, name, sizeof(name));
+        if (ret >= 0 && (size_t) ret < sizeof(name)) {
+            config->platforms[i] = LookupPlatformName(name);
+        } else {
+            config->platforms[i] = EGL_NONE;
+        }
+        if (config->platforms[i] == EGL_NONE) {
+            free(config->platforms);
+            config->platforms = NULL;
+            return EGL_TRUE;
+        }
     }
-    if (vendor != NULL) {
-        glvnd_list_append(&vendor->entry, &__eglVendorList);
+    config->platformCount = count;
+    return EGL_TRUE;
+}
+
+/*!
+ * Reads the optional list of preferred platforms from the ICD object of a
+ * config file.
+ *
+ * Unlike the \c platforms key, this is only a hint, so any platform names that
+ * we don't recognize are just skipped.
+ *
+ * \return EGL_FALSE if the list is malformed.
+ */
+static EGLBoolean ReadVendorPreferredPlatforms(const __GLVNDjsonReader *listReader,
+        __EGLvendorConfig *config)
+{
+    __GLVNDjsonReader reader;
+    __GLVNDjsonString item;
+    char name[64];
+    int count;
+    int ret;
+
+    if (listReader == NULL) {
+        return EGL_TRUE;
     }
-    return vendor;
+
+    reader = *listReader;
+    if (!__glvndJsonBeginArray(&reader)) {
+        return EGL_FALSE;
+    }
+    count = 0;
+    while ((ret = __glvndJsonNextElement(&reader)) > 0) {
+        if (!__glvndJsonReadString(&reader, &item)) {
+            return EGL_FALSE;
+        }
+        count++;
+    }
+    if (ret < 0) {
+        return EGL_FALSE;
+    }
+    if (count <= 0) {
+        return EGL_TRUE;
+    }
+
+    config->preferredPlatforms = (EGLenum *) malloc(count * sizeof(EGLenum));
+    if (config->preferredPlatforms == NULL) {
+        return EGL_TRUE;
+    }
+
+    reader = *listReader;
+    __glvndJsonBeginArray(&reader);
+    while (__glvndJsonNextElement(&reader) > 0) {
+        EGLenum platform = EGL_NONE;
+
+        __glvndJsonReadString(&reader, &item);
+        ret = __glvndJsonDecodeString(&item, name, sizeof(name));
+        if (ret >= 0 && (size_t) ret < sizeof(name)) {
+            platform = LookupPlatformName(name);
+        }
+        if (platform != EGL_NONE) {
+            config->preferredPlatforms[config->preferredPlatformCount++] = platform;
+        }
+    }
+    return EGL_TRUE;
+}
+
+static void FreeVendorConfig(__EGLvendorConfig *config)
+{
+    free(config->libraryPath);
+    free(config->platforms);
+    free(config->preferredPlatforms);
+    config->libraryPath = NULL;
+    config->platforms = NULL;
+    config->platformCount = 0;
+    config->preferredPlatforms = NULL;
+    config->preferredPlatformCount = 0;
+}
+
+/*!
+ * Copies the information from a config file that we still need once a vendor
+ * is loaded.
+ */
+static void TakeVendorConfig(__EGLvendorInfo *vendor, __EGLvendorConfig *config)
+{
+    vendor->priority = config->priority;
+    vendor->preferredPlatforms = config->preferredPlatforms;
+    vendor->preferredPlatformCount = config->preferredPlatformCount;
+    config->preferredPlatforms = NULL;
+    config->preferredPlatformCount = 0;
+}
+
+EGLBoolean __eglVendorPrefersPlatform(const __EGLvendorInfo *vendor, EGLenum platform)
+{
+    int i;
+
+    for (i=0; i<vendor->preferredPlatformCount; i++) {
+        if (vendor->preferredPlatforms[i] == platform) {
+            return EGL_TRUE;
+        }
+    }
+    return EGL_FALSE;
+}
+
+/*!
+ * Reads the members of the ICD object that we care about.
+ *
+ * Each of the optional platform lists is returned as a copy of the reader at
+ * the start of the list, or NULL if the list isn't there. Keys are
+ * case-insensitive, and only the first copy of a key counts.
+ *
+ * \return EGL_TRUE on success, or EGL_FALSE if the object is malformed or
+ * doesn't have a library path.
+ */
+static EGLBoolean ReadVendorICDObject(__GLVNDjsonReader *reader,
+        __GLVNDjsonString *libraryPath,
+        __GLVNDjsonReader *platforms, const __GLVNDjsonReader **platformsPtr,
+        __GLVNDjsonReader *preferred, const __GLVNDjsonReader **preferredPtr)
+{
+    __GLVNDjsonString key;
+    EGLBoolean haveLibraryPath = EGL_FALSE;
+    int ret;
+
+    *platformsPtr = NULL;
+    *preferredPtr = NULL;
+
+    if (!__glvndJsonBeginObject(reader)) {
+        return EGL_FALSE;
+    }
+    while ((ret = __glvndJsonNextMember(reader, &key)) > 0) {
+        if (!haveLibraryPath && __glvndJsonStringEquals(&key, "library_path")) {
+            if (!__glvndJsonReadString(reader, libraryPath)) {
+                return EGL_FALSE;
+            }
+            haveLibraryPath = EGL_TRUE;
+            continue;
+        }
+
+        if (*platformsPtr == NULL && __glvndJsonStringEquals(&key, "platforms")) {
+            *platforms = *reader;
+            *platformsPtr = platforms;
+        } else if (*preferredPtr == NULL && __glvndJsonStringEquals(&key, "preferred_platforms")) {
+            *preferred = *reader;
+            *preferredPtr = preferred;
+        }
+        if (!__glvndJsonSkipValue(reader)) {
+            return EGL_FALSE;
+        }
+    }
+    return (ret == 0 && haveLibraryPath);
 }
 
-static cJSON *ReadJSONFile(const char *filename)
+/*!
+ * Reads a vendor config file.
+ *
+ * The file is mapped and read in place, and the only things that get copied
+ * out of it are the library path and the platform lists.
+ *
+ * \return EGL_TRUE on success, or EGL_FALSE if the file couldn't be read or
+ * isn't valid.
+ */
+static EGLBoolean ReadVendorConfigFile(const char *filename, __EGLvendorConfig *config)
 {
-    FILE *in = NULL;
-    char *buf = NULL;
-    cJSON *root = NULL;
-    struct stat st;
+    __GLVNDjsonFile file;
+    __GLVNDjsonReader reader;
+    __GLVNDjsonReader icdReader;
+    __GLVNDjsonReader platforms, preferred;
+    const __GLVNDjsonReader *platformsPtr = NULL;
+    const __GLVNDjsonReader *preferredPtr = NULL;
+    __GLVNDjsonString key;
+    __GLVNDjsonString version;
+    __GLVNDjsonString libraryPath;
+    EGLBoolean haveVersion = EGL_FALSE;
+    EGLBoolean haveICD = EGL_FALSE;
+    char versionStr[32];
+    int ret;
+
+    if (__glvndJsonMapFile(filename, &file) != 0) {
+        return EGL_FALSE;
+    }
+    __glvndJsonReaderInit(&reader, file.data, file.size);
 
-    in = fopen(filename, "r");
-    if (in == NULL) {
+    // Go through the whole top-level object, so that a syntax error anywhere
+    // in the file is caught.
+    if (!__glvndJsonBeginObject(&reader)) {
         goto done;
     }
+    while ((ret = __glvndJsonNextMember(&reader, &key)) > 0) {
+        if (!haveVersion && __glvndJsonStringEquals(&key, "file_format_version")) {
+            if (!__glvndJsonReadString(&reader, &version)) {
+                goto done;
+            }
+            haveVersion = EGL_TRUE;
+            continue;
+        }
 
-    if (fstat(fileno(in), &st) != 0) {
+        if (!haveICD && __glvndJsonStringEquals(&key, "ICD")) {
+            icdReader = reader;
+            haveICD = EGL_TRUE;
+        }
+        if (!__glvndJsonSkipValue(&reader)) {
+            goto done;
+        }
+    }
+    if (ret != 0 || !haveVersion || !haveICD) {
         goto done;
     }
 
-    buf = (char *) malloc(st.st_size + 1);
-    if (buf == NULL) {
+    if (__glvndJsonDecodeString(&version, versionStr, sizeof(versionStr)) < 0) {
+        goto done;
+    }
+    if (!CheckFormatVersion(versionStr)) {
         goto done;
     }
 
-    if (fread(buf, st.st_size, 1, in) != 1) {
+    if (!ReadVendorICDObject(&icdReader, &libraryPath,
+                &platforms, &platformsPtr, &preferred, &preferredPtr)) {
         goto done;
     }
-    buf[st.st_size] = '\0';
 
-    root = cJSON_Parse(buf);
+    if (ReadVendorPlatforms(platformsPtr, config)
+            && ReadVendorPreferredPlatforms(preferredPtr, config)) {
+        config->libraryPath = __glvndJsonCopyString(&libraryPath);
+        if (config->libraryPath == NULL) {
+            FreeVendorConfig(config);
+        }
+    }
 
 done:
-    if (in != NULL) {
-        fclose(in);
+    __glvndJsonUnmapFile(&file);
+    return (config->libraryPath != NULL);
+}
+
+/*!
+ * Flags for the client extensions that libEGL cares about in a vendor.
+ */
+enum {
+    CLIENT_EXT_DEVICE = 0x01,
+    CLIENT_EXT_PLATFORM_DEVICE = 0x02,
+    CLIENT_EXT_PLATFORM_GBM = 0x04,
+    CLIENT_EXT_PLATFORM_WAYLAND = 0x08,
+    CLIENT_EXT_PLATFORM_X11 = 0x10,
+};
+
+static const struct {
+    const char *name;
+    unsigned int flag;
+} KNOWN_CLIENT_EXTENSIONS[] = {
+    { "EGL_EXT_device_base", CLIENT_EXT_DEVICE },
+    { "EGL_EXT_device_enumeration", CLIENT_EXT_DEVICE },
+    { "EGL_EXT_platform_device", CLIENT_EXT_PLATFORM_DEVICE },
+    { "EGL_MESA_platform_gbm", CLIENT_EXT_PLATFORM_GBM },
+    { "EGL_KHR_platform_gbm", CLIENT_EXT_PLATFORM_GBM },
+    { "EGL_EXT_platform_wayland", CLIENT_EXT_PLATFORM_WAYLAND },
+    { "EGL_KHR_platform_wayland", CLIENT_EXT_PLATFORM_WAYLAND },
+    { "EGL_EXT_platform_x11", CLIENT_EXT_PLATFORM_X11 },
+    { "EGL_KHR_platform_x11", CLIENT_EXT_PLATFORM_X11 },
+};
+
+/*!
+ * An open-addressed hashtable of \c KNOWN_CLIENT_EXTENSIONS, so that
+ * \c CheckVendorExtensionString can go through a vendor's extension string
+ * once, instead of searching it again for each extension. Each slot holds an
+ * index into \c KNOWN_CLIENT_EXTENSIONS plus one, or zero if it's empty.
+ *
+ * This is filled in by \c __eglInitVendors.
+ */
+#define CLIENT_EXT_HASH_SIZE 32
+static unsigned char clientExtensionHash[CLIENT_EXT_HASH_SIZE];
+
+static void InitClientExtensionHash(void)
+{
+    size_t i;
+
+    memset(clientExtensionHash, 0, sizeof(clientExtensionHash));
+    for (i=0; i<ARRAY_LEN(KNOWN_CLIENT_EXTENSIONS); i++) {
+        const char *name = KNOWN_CLIENT_EXTENSIONS[i].name;
+        unsigned int slot = glvndHashString(name) & (CLIENT_EXT_HASH_SIZE - 1);
+
+        while (clientExtensionHash[slot] != 0) {
+            slot = (slot + 1) & (CLIENT_EXT_HASH_SIZE - 1);
+        }
+        clientExtensionHash[slot] = (unsigned char) (i + 1);
     }
-    if (buf != NULL) {
-        free(buf);
+}
+
+/*!
+ * Returns the \c CLIENT_EXT_* flag for an extension name, or zero if it's not
+ * one that we care about.
+ */
+static unsigned int LookupClientExtension(const char *name, size_t len)
+{
+    unsigned int slot = glvndHashFNV1a(name, len) & (CLIENT_EXT_HASH_SIZE - 1);
+
+    while (clientExtensionHash[slot] != 0) {
+        int index = clientExtensionHash[slot] - 1;
+        const char *known = KNOWN_CLIENT_EXTENSIONS[index].name;
+
+        if (strncmp(known, name, len) == 0 && known[len] == '\0') {
+            return KNOWN_CLIENT_EXTENSIONS[index].flag;
+        }
+        slot = (slot + 1) & (CLIENT_EXT_HASH_SIZE - 1);
     }
-    return root;
+    return 0;
 }
 
 static void CheckVendorExtensionString(__EGLvendorInfo *vendor, const char *str)
 {
-    static const char NAME_DEVICE_BASE[] = "EGL_EXT_device_base";
-    static const char NAME_DEVICE_ENUM[] = "EGL_EXT_device_enumeration";
-    static const char NAME_PLATFORM_DEVICE[] = "EGL_EXT_platform_device";
-    static const char NAME_MESA_PLATFORM_GBM[] = "EGL_MESA_platform_gbm";
-    static const char NAME_KHR_PLATFORM_GBM[] = "EGL_KHR_platform_gbm";
-    static const char NAME_EXT_PLATFORM_WAYLAND[] = "EGL_EXT_platform_wayland";
-    static const char NAME_KHR_PLATFORM_WAYLAND[] = "EGL_KHR_platform_wayland";
-    static const char NAME_EXT_PLATFORM_X11[] = "EGL_EXT_platform_x11";
-    static const char NAME_KHR_PLATFORM_X11[] = "EGL_KHR_platform_x11";
+    const char *tok = str;
+    size_t len = 0;
+    unsigned int flags = 0;
 
     if (str == NULL || str[0] == '\x00') {
         return;
     }
 
-    if (!vendor->supportsDevice) {
-        if (IsTokenInString(str, NAME_DEVICE_BASE, sizeof(NAME_DEVICE_BASE) - 1, " ")
-                || IsTokenInString(str, NAME_DEVICE_ENUM, sizeof(NAME_DEVICE_ENUM) - 1, " ")) {
-            vendor->supportsDevice = EGL_TRUE;
-        }
+    while (FindNextStringToken(&tok, &len, " ")) {
+        flags |= LookupClientExtension(tok, len);
     }
 
-    if (!vendor->supportsPlatformDevice) {
-        if (IsTokenInString(str, NAME_PLATFORM_DEVICE, sizeof(NAME_PLATFORM_DEVICE) - 1, " ")) {
-            vendor->supportsPlatformDevice = EGL_TRUE;
-        }
+    if (flags & CLIENT_EXT_DEVICE) {
+        vendor->supportsDevice = EGL_TRUE;
     }
-
-    if (!vendor->supportsPlatformGbm) {
-        if (IsTokenInString(str, NAME_MESA_PLATFORM_GBM, sizeof(NAME_MESA_PLATFORM_GBM) - 1, " ")
-                || IsTokenInString(str, NAME_KHR_PLATFORM_GBM, sizeof(NAME_KHR_PLATFORM_GBM) - 1, " ")) {
-            vendor->supportsPlatformGbm = EGL_TRUE;
-        }
+    if (flags & CLIENT_EXT_PLATFORM_DEVICE) {
+        vendor->supportsPlatformDevice = EGL_TRUE;
     }
-
-    if (!vendor->supportsPlatformWayland) {
-        if (IsTokenInString(str, NAME_EXT_PLATFORM_WAYLAND, sizeof(NAME_EXT_PLATFORM_WAYLAND) - 1, " ")
-                || IsTokenInString(str, NAME_KHR_PLATFORM_WAYLAND, sizeof(NAME_KHR_PLATFORM_WAYLAND) - 1, " ")) {
-            vendor->supportsPlatformWayland = EGL_TRUE;
-        }
+    if (flags & CLIENT_EXT_PLATFORM_GBM) {
+        vendor->supportsPlatformGbm = EGL_TRUE;
     }
-
-    if (!vendor->supportsPlatformX11) {
-        if (IsTokenInString(str, NAME_EXT_PLATFORM_X11, sizeof(NAME_EXT_PLATFORM_X11) - 1, " ")
-                || IsTokenInString(str, NAME_KHR_PLATFORM_X11, sizeof(NAME_KHR_PLATFORM_X11) - 1, " ")) {
-            vendor->supportsPlatformX11 = EGL_TRUE;
-        }
+    if (flags & CLIENT_EXT_PLATFORM_WAYLAND) {
+        vendor->supportsPlatformWayland = EGL_TRUE;
+    }
+    if (flags & CLIENT_EXT_PLATFORM_X11) {
+        vendor->supportsPlatformX11 = EGL_TRUE;
     }
 }
 
@@ -442,15 +1202,29 @@ static __EGLvendorInfo *LoadVendor(const char *filename)
     __PFNEGLMAINPROC eglMainProc;
     __EGLvendorInfo *vendor = NULL;
     __EGLvendorInfo *otherVendor;
+    __GLVNDarena *arena;
+    uint64_t slowOpStart = __glDispatchSlowOpBegin();
     int i;
 
-    // Allocate the vendor structure, plus enough room for a copy of its name.
-    vendor = (__EGLvendorInfo *) calloc(1, sizeof(__EGLvendorInfo));
+    arena = __glvndArenaCreate(VENDOR_ARENA_BLOCK_SIZE, GLVND_MEM_VENDOR);
+    if (arena == NULL) {
+        return NULL;
+    }
+    vendor = (__EGLvendorInfo *) __glvndArenaAlloc(arena, sizeof(__EGLvendorInfo));
     if (vendor == NULL) {
+        __glvndArenaDestroy(arena);
         return NULL;
     }
+    vendor->arena = arena;
 
+    GLDISPATCH_TRACE(1, GLDISPATCH_TRACE_PHASE_BEGIN,
+            GLDISPATCH_PHASE_DLOPEN, GLDISPATCH_API_EGL);
+    GLVND_PROBE2(vendor_dlopen_begin, GLDISPATCH_API_EGL, filename);
     vendor->dlhandle = dlopen(filename, RTLD_LAZY);
+    GLVND_PROBE3(vendor_dlopen_end, GLDISPATCH_API_EGL, filename,
+            vendor->dlhandle);
+    GLDISPATCH_TRACE(1, GLDISPATCH_TRACE_PHASE_END,
+            GLDISPATCH_PHASE_DLOPEN, GLDISPATCH_API_EGL);
     if (vendor->dlhandle == NULL) {
         goto fail;
     }
@@ -467,11 +1241,15 @@ static __EGLvendorInfo *LoadVendor(const char *filename)
         goto fail;
     }
 
+    GLDISPATCH_TRACE(1, GLDISPATCH_TRACE_PHASE_BEGIN,
+            GLDISPATCH_PHASE_VENDOR_MAIN, GLDISPATCH_API_EGL);
     if (!(*eglMainProc)(EGL_VENDOR_ABI_VERSION,
                               &__eglExportsTable,
                               vendor, &vendor->eglvc)) {
         goto fail;
     }
+    GLDISPATCH_TRACE(1, GLDISPATCH_TRACE_PHASE_END,
+            GLDISPATCH_PHASE_VENDOR_MAIN, GLDISPATCH_API_EGL);
 
     // Make sure all the required functions are there.
     if (vendor->eglvc.getPlatformDisplay == NULL
@@ -482,18 +1260,24 @@ static __EGLvendorInfo *LoadVendor(const char *filename)
         goto fail;
     }
 
-    if (vendor->eglvc.isPatchSupported != NULL
-            && vendor->eglvc.initiatePatch != NULL) {
+    if ((vendor->eglvc.isPatchSupported != NULL
+                && vendor->eglvc.initiatePatch != NULL)
+            || vendor->eglvc.initiatePatchTargets != NULL) {
         vendor->patchCallbacks.isPatchSupported = vendor->eglvc.isPatchSupported;
         vendor->patchCallbacks.initiatePatch = vendor->eglvc.initiatePatch;
         vendor->patchCallbacks.releasePatch = vendor->eglvc.releasePatch;
         vendor->patchCallbacks.threadAttach = vendor->eglvc.patchThreadAttach;
+        vendor->patchCallbacks.initiatePatchTargets = vendor->eglvc.initiatePatchTargets;
         vendor->patchSupported = EGL_TRUE;
     }
 
+    GLDISPATCH_TRACE(1, GLDISPATCH_TRACE_PHASE_BEGIN,
+            GLDISPATCH_PHASE_LOOKUP, GLDISPATCH_API_EGL);
     if (!LookupVendorEntrypoints(vendor)) {
         goto fail;
     }
+    GLDISPATCH_TRACE(1, GLDISPATCH_TRACE_PHASE_END,
+            GLDISPATCH_PHASE_LOOKUP, GLDISPATCH_API_EGL);
 
     vendor->supportsGL = vendor->eglvc.getSupportsAPI(EGL_OPENGL_API);
     vendor->supportsGLES = vendor->eglvc.getSupportsAPI(EGL_OPENGL_ES_API);
@@ -504,11 +1288,33 @@ static __EGLvendorInfo *LoadVendor(const char *filename)
     vendor->vendorID = __glDispatchNewVendorID();
     assert(vendor->vendorID >= 0);
 
-    // TODO: Allow per-context dispatch tables?
-    vendor->glDispatch = __glDispatchCreateTable(VendorGetProcAddressCallback, vendor);
+    // Indices aren't reused, so that a thread's apiNotifiedVendors can't
+    // mistake a new vendor for one that it already told about the API.
+    if (nextVendorAPIIndex < 32) {
+        vendor->apiIndex = nextVendorAPIIndex++;
+    } else {
+        vendor->apiIndex = -1;
+    }
+
+    vendor->glDispatch = __glDispatchCreateTableBulk(VendorGetProcAddressCallback,
+            (vendor->eglvc.getProcAddressBulk != NULL ? VendorGetProcAddressBulkCallback : NULL),
+            vendor);
     if (!vendor->glDispatch) {
         goto fail;
     }
+    __glDispatchSetTableVendor(vendor->glDispatch, vendor->dlhandle, "egl");
+    SetVendorStaticFuncs(vendor);
+
+    if (vendor->eglvc.getContextDispatchVariant != NULL
+            && vendor->eglvc.getVariantProcAddress != NULL) {
+        for (i=1; i<__EGL_DISPATCH_VARIANT_COUNT; i++) {
+            vendor->dispatchVariants[i].vendor = vendor;
+            vendor->dispatchVariants[i].variant = i;
+        }
+    } else {
+        vendor->eglvc.getContextDispatchVariant = NULL;
+        vendor->eglvc.getVariantProcAddress = NULL;
+    }
 
     CheckVendorExtensions(vendor);
 
@@ -516,22 +1322,37 @@ static __EGLvendorInfo *LoadVendor(const char *filename)
     // This is called before trying to look up any vendor-supplied EGL dispatch
     // functions, so we only need to add the EGL dispatch functions that are
     // defined in libEGL itself.
-    vendor->dynDispatch = __glvndWinsysVendorDispatchCreate();
+    vendor->dynDispatch = __glvndWinsysVendorDispatchCreate(vendor->arena);
     if (!vendor->dynDispatch) {
         goto fail;
     }
-    for (i=0; i<__EGL_DISPATCH_FUNC_COUNT; i++) {
-        vendor->eglvc.setDispatchIndex(
-                __EGL_DISPATCH_FUNC_NAMES[i],
-                __EGL_DISPATCH_FUNC_INDICES[i]);
+    if (vendor->eglvc.setDispatchIndexBulk != NULL) {
+        // The functions in __EGL_DISPATCH_FUNC_NAMES always get the first
+        // indices, in the same order. See __eglMappingInit.
+        vendor->eglvc.setDispatchIndexBulk(__EGL_DISPATCH_FUNC_NAMES,
+                0, __EGL_DISPATCH_FUNC_COUNT);
+    } else {
+        for (i=0; i<__EGL_DISPATCH_FUNC_COUNT; i++) {
+            vendor->eglvc.setDispatchIndex(
+                    __EGL_DISPATCH_FUNC_NAMES[i],
+                    __EGL_DISPATCH_FUNC_INDICES[i]);
+        }
+    }
+    if (!lazyDispatch) {
+        __eglResolveVendorDispatch(vendor);
     }
 
+    GLDISPATCH_TRACE(1, GLDISPATCH_TRACE_VENDOR_LOAD,
+            GLDISPATCH_API_EGL, vendor->vendorID);
+    GLVND_PROBE2(vendor_load, GLDISPATCH_API_EGL, vendor->vendorID);
+    __glDispatchSlowOpEnd(slowOpStart, "LoadVendor", filename, vendor->vendorID);
     return vendor;
 
 fail:
     if (vendor != NULL) {
         TeardownVendor(vendor);
     }
+    __glDispatchSlowOpEnd(slowOpStart, "LoadVendor (failed)", filename, 0);
     return NULL;
 }
 
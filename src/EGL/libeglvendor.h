@@ -3,23 +3,47 @@
 
 #include "libeglabipriv.h"
 #include "GLdispatch.h"
-#include "lkdhash.h"
 #include "glvnd_list.h"
 #include "winsys_dispatch.h"
 
 extern const __EGLapiExports __eglExportsTable;
 
+/*!
+ * One of the extra dispatch tables that a vendor can select with
+ * \c getContextDispatchVariant. The table is created the first time a
+ * context with that variant is made current.
+ */
+typedef struct __EGLdispatchVariantRec {
+    __EGLvendorInfo *vendor;
+    int variant;
+    __GLdispatchTable * volatile table;
+} __EGLdispatchVariant;
+
 /*!
  * Structure containing relevant per-vendor information.
  */
 struct __EGLvendorInfoRec {
     int vendorID; //< unique GLdispatch ID
+
+    /// This vendor's bit in \c __EGLThreadAPIState::apiNotifiedVendors, or
+    /// -1 if the vendor doesn't get one.
+    int apiIndex;
     void *dlhandle; //< shared library handle
+
+    /// The arena that this structure and the vendor's other data are
+    /// allocated from.
+    __GLVNDarena *arena;
+
     __GLVNDwinsysVendorDispatch *dynDispatch;
 
-    // TODO: Should this have a separate dispatch table for GL and GLES?
     __GLdispatchTable *glDispatch; //< GL dispatch table
 
+    /*!
+     * The vendor's other dispatch tables, indexed by variant. Element 0 is
+     * unused, since variant 0 is \c glDispatch.
+     */
+    __EGLdispatchVariant dispatchVariants[__EGL_DISPATCH_VARIANT_COUNT];
+
     __EGLapiImports eglvc;
     __EGLdispatchTableStatic staticDispatch; //< static EGL dispatch table
 
@@ -35,9 +59,45 @@ struct __EGLvendorInfoRec {
     EGLBoolean supportsPlatformX11;
     EGLBoolean supportsPlatformWayland;
 
+    /*!
+     * True if every function in \c __EGL_DISPATCH_FUNC_NAMES was looked up
+     * and stored in \c dynDispatch when the vendor was loaded. If so, then a
+     * missing entry means the vendor doesn't support that function.
+     */
+    EGLBoolean staticDispatchResolved;
+
+    /*!
+     * The position of this vendor's config file in the search order. This is
+     * used to keep \c __eglVendorList sorted when a vendor is loaded late.
+     */
+    int priority;
+
+    /*!
+     * The platforms that the vendor's config file asked to be tried first
+     * for. See \c __eglVendorPrefersPlatform.
+     */
+    EGLenum *preferredPlatforms;
+    int preferredPlatformCount;
+
     struct glvnd_list entry;
 };
 
+/*!
+ * Returns true if \p vendor's config file listed \p platform in its
+ * \c preferred_platforms key.
+ */
+EGLBoolean __eglVendorPrefersPlatform(const __EGLvendorInfo *vendor, EGLenum platform);
+
+/*!
+ * Returns the dispatch table to use for \p context.
+ *
+ * If the vendor doesn't provide the \c getContextDispatchVariant callback,
+ * or if it selects the default variant, then this returns
+ * \c vendor->glDispatch.
+ */
+__GLdispatchTable *__eglGetContextDispatchTable(__EGLvendorInfo *vendor,
+        EGLDisplay dpy, EGLContext context);
+
 void __eglInitVendors(void);
 void __eglTeardownVendors(void);
 
@@ -48,4 +108,24 @@ void __eglTeardownVendors(void);
  */
 struct glvnd_list *__eglLoadVendors(void);
 
+/**
+ * Loads the vendor libraries that might support \p platform.
+ *
+ * This is the same as \c __eglLoadVendors, except that a vendor whose config
+ * file lists the platforms that it supports won't be loaded unless
+ * \p platform is one of them. Any vendor loaded this way is inserted into the
+ * vendor list in the same position that \c __eglLoadVendors would have put it.
+ *
+ * \return A linked list of __EGLvendorInfo structs.
+ */
+struct glvnd_list *__eglLoadVendorsForPlatform(EGLenum platform);
+
+/**
+ * Returns the vendor libraries that have been loaded so far, without loading
+ * any others.
+ *
+ * \return A linked list of __EGLvendorInfo structs.
+ */
+struct glvnd_list *__eglGetLoadedVendors(void);
+
 #endif // LIBEGLVENDOR_H
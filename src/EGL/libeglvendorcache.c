@@ -0,0 +1,484 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+#include "libeglvendorcache.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+#include "utils_misc.h"
+
+/*!
+ * The version number of the cache file layout. This must be incremented
+ * whenever the layout changes.
+ */
+#define CACHE_VERSION 2
+
+static const char CACHE_MAGIC[8] = { 'G', 'L', 'V', 'N', 'D', 'E', 'V', 'C' };
+
+/*!
+ * The information from stat() that's used to tell whether a file or directory
+ * has changed.
+ */
+typedef struct __EGLcacheStatInfoRec {
+    uint8_t exists;
+    uint64_t dev;
+    uint64_t ino;
+    uint64_t size;
+    int64_t mtime;
+    int64_t ctime;
+} __EGLcacheStatInfo;
+
+typedef struct __EGLcacheReaderRec {
+    const unsigned char *data;
+    size_t size;
+    size_t pos;
+    EGLBoolean error;
+} __EGLcacheReader;
+
+typedef struct __EGLcacheWriterRec {
+    unsigned char *data;
+    size_t size;
+    size_t allocSize;
+    EGLBoolean error;
+} __EGLcacheWriter;
+
+static void GetStatInfo(const char *path, __EGLcacheStatInfo *info)
+{
+    struct stat st;
+
+    memset(info, 0, sizeof(*info));
+    if (stat(path, &st) == 0) {
+        info->exists = 1;
+        info->dev = (uint64_t) st.st_dev;
+        info->ino = (uint64_t) st.st_ino;
+        info->size = (uint64_t) st.st_size;
+        info->mtime = (int64_t) st.st_mtime;
+        info->ctime = (int64_t) st.st_ctime;
+    }
+}
+
+static EGLBoolean StatInfoMatches(const char *path, const __EGLcacheStatInfo *info)
+{
+    __EGLcacheStatInfo current;
+
+    GetStatInfo(path, &current);
+    return (current.exists == info->exists
+            && current.dev == info->dev
+            && current.ino == info->ino
+            && current.size == info->size
+            && current.mtime == info->mtime
+            && current.ctime == info->ctime);
+}
+
+/*!
+ * Returns true if \p path was modified at or after \p startTime. We allow for
+ * one extra second, since file timestamps can lag behind time().
+ */
+static EGLBoolean IsRecentlyModified(const char *path, time_t startTime)
+{
+    __EGLcacheStatInfo info;
+
+    GetStatInfo(path, &info);
+    if (!info.exists) {
+        return EGL_FALSE;
+    }
+    return (info.mtime >= (int64_t) startTime - 1
+            || info.ctime >= (int64_t) startTime - 1);
+}
+
+static void ReadBytes(__EGLcacheReader *reader, void *dest, size_t len)
+{
+    if (reader->error || len > reader->size - reader->pos) {
+        reader->error = EGL_TRUE;
+        memset(dest, 0, len);
+        return;
+    }
+    memcpy(dest, reader->data + reader->pos, len);
+    reader->pos += len;
+}
+
+static uint8_t ReadU8(__EGLcacheReader *reader)
+{
+    uint8_t value;
+    ReadBytes(reader, &value, sizeof(value));
+    return value;
+}
+
+static uint32_t ReadU32(__EGLcacheReader *reader)
+{
+    uint32_t value;
+    ReadBytes(reader, &value, sizeof(value));
+    return value;
+}
+
+/*!
+ * Reads a string from the cache file.
+ *
+ * \return A pointer to the string within the cache file, or NULL on error.
+ */
+static const char *ReadString(__EGLcacheReader *reader)
+{
+    uint32_t len = ReadU32(reader);
+    const char *str;
+
+    if (reader->error || len >= reader->size - reader->pos
+            || reader->data[reader->pos + len] != '\0') {
+        reader->error = EGL_TRUE;
+        return NULL;
+    }
+    str = (const char *) (reader->data + reader->pos);
+    reader->pos += len + 1;
+    return str;
+}
+
+static void ReadStatInfo(__EGLcacheReader *reader, __EGLcacheStatInfo *info)
+{
+    info->exists = ReadU8(reader);
+    ReadBytes(reader, &info->dev, sizeof(info->dev));
+    ReadBytes(reader, &info->ino, sizeof(info->ino));
+    ReadBytes(reader, &info->size, sizeof(info->size));
+    ReadBytes(reader, &info->mtime, sizeof(info->mtime));
+    ReadBytes(reader, &info->ctime, sizeof(info->ctime));
+}
+
+static void WriteBytes(__EGLcacheWriter *writer, const void *src, size_t len)
+{
+    if (writer->error) {
+        return;
+    }
+    if (len > writer->allocSize - writer->size) {
+        size_t newSize = (writer->allocSize > 0 ? writer->allocSize : 4096);
+        unsigned char *newData;
+
+        while (len > newSize - writer->size) {
+            newSize *= 2;
+        }
+        newData = (unsigned char *) realloc(writer->data, newSize);
+        if (newData == NULL) {
+            writer->error = EGL_TRUE;
+            return;
+        }
+        writer->data = newData;
+        writer->allocSize = newSize;
+    }
+    memcpy(writer->data + writer->size, src, len);
+    writer->size += len;
+}
+
+static void WriteU8(__EGLcacheWriter *writer, uint8_t value)
+{
+    WriteBytes(writer, &value, sizeof(value));
+}
+
+static void WriteU32(__EGLcacheWriter *writer, uint32_t value)
+{
+    WriteBytes(writer, &value, sizeof(value));
+}
+
+static void WriteString(__EGLcacheWriter *writer, const char *str)
+{
+    size_t len = strlen(str);
+    WriteU32(writer, (uint32_t) len);
+    WriteBytes(writer, str, len + 1);
+}
+
+static void WriteStatInfo(__EGLcacheWriter *writer, const __EGLcacheStatInfo *info)
+{
+    WriteU8(writer, info->exists);
+    WriteBytes(writer, &info->dev, sizeof(info->dev));
+    WriteBytes(writer, &info->ino, sizeof(info->ino));
+    WriteBytes(writer, &info->size, sizeof(info->size));
+    WriteBytes(writer, &info->mtime, sizeof(info->mtime));
+    WriteBytes(writer, &info->ctime, sizeof(info->ctime));
+}
+
+static void FreeConfigList(__EGLvendorConfigList *list)
+{
+    int i;
+
+    for (i=0; i<list->count; i++) {
+        free(list->filenames[i]);
+        free(list->configs[i].libraryPath);
+        free(list->configs[i].platforms);
+        free(list->configs[i].preferredPlatforms);
+    }
+    free(list->filenames);
+    free(list->configs);
+    memset(list, 0, sizeof(*list));
+}
+
+/*!
+ * Parses the contents of a cache file, and checks whether it's up to date.
+ */
+static EGLBoolean ParseVendorConfigCache(__EGLcacheReader *reader,
+        char * const *dirs, unsigned int formatVersion,
+        __EGLvendorConfigList *list)
+{
+    char magic[sizeof(CACHE_MAGIC)];
+    __EGLcacheStatInfo info;
+    uint32_t count;
+    uint32_t i, j;
+
+    ReadBytes(reader, magic, sizeof(magic));
+    if (reader->error || memcmp(magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0) {
+        return EGL_FALSE;
+    }
+    if (ReadU32(reader) != CACHE_VERSION || ReadU32(reader) != formatVersion) {
+        return EGL_FALSE;
+    }
+
+    // Check the list of directories. If a config file has been added or
+    // removed, then its directory's timestamps will have changed.
+    count = ReadU32(reader);
+    for (i=0; i<count; i++) {
+        const char *dirName = ReadString(reader);
+        ReadStatInfo(reader, &info);
+        if (reader->error || dirs[i] == NULL || strcmp(dirName, dirs[i]) != 0) {
+            return EGL_FALSE;
+        }
+        if (!StatInfoMatches(dirName, &info)) {
+            return EGL_FALSE;
+        }
+    }
+    if (dirs[count] != NULL) {
+        return EGL_FALSE;
+    }
+
+    count = ReadU32(reader);
+    if (reader->error || count > (reader->size - reader->pos) / sizeof(uint32_t)) {
+        return EGL_FALSE;
+    }
+    if (count == 0) {
+        return EGL_TRUE;
+    }
+
+    list->filenames = (char **) calloc(count, sizeof(char *));
+    list->configs = (__EGLvendorConfig *) calloc(count, sizeof(__EGLvendorConfig));
+    if (list->filenames == NULL || list->configs == NULL) {
+        return EGL_FALSE;
+    }
+    list->allocCount = count;
+
+    for (i=0; i<count; i++) {
+        __EGLvendorConfig *config = &list->configs[i];
+        const char *filename = ReadString(reader);
+
+        ReadStatInfo(reader, &info);
+        if (reader->error || !StatInfoMatches(filename, &info)) {
+            return EGL_FALSE;
+        }
+
+        list->filenames[i] = strdup(filename);
+        list->count++;
+        if (list->filenames[i] == NULL) {
+            return EGL_FALSE;
+        }
+
+        if (ReadU8(reader)) {
+            const char *libraryPath = ReadString(reader);
+            uint32_t platformCount = ReadU32(reader);
+
+            if (reader->error || platformCount > (reader->size - reader->pos) / sizeof(uint32_t)) {
+                return EGL_FALSE;
+            }
+            config->libraryPath = strdup(libraryPath);
+            if (config->libraryPath == NULL) {
+                return EGL_FALSE;
+            }
+
+            if (platformCount > 0) {
+                config->platforms = (EGLenum *) malloc(platformCount * sizeof(EGLenum));
+                if (config->platforms == NULL) {
+                    return EGL_FALSE;
+                }
+                for (j=0; j<platformCount; j++) {
+                    config->platforms[j] = (EGLenum) ReadU32(reader);
+                }
+                config->platformCount = platformCount;
+            }
+
+            platformCount = ReadU32(reader);
+            if (reader->error || platformCount > (reader->size - reader->pos) / sizeof(uint32_t)) {
+                return EGL_FALSE;
+            }
+            if (platformCount > 0) {
+                config->preferredPlatforms = (EGLenum *) malloc(platformCount * sizeof(EGLenum));
+                if (config->preferredPlatforms == NULL) {
+                    return EGL_FALSE;
+                }
+                for (j=0; j<platformCount; j++) {
+                    config->preferredPlatforms[j] = (EGLenum) ReadU32(reader);
+                }
+                config->preferredPlatformCount = platformCount;
+            }
+        }
+    }
+
+    return !reader->error;
+}
+
+EGLBoolean __eglReadVendorConfigCache(const char *cachePath,
+        char * const *dirs, unsigned int formatVersion,
+        __EGLvendorConfigList *list)
+{
+    __EGLcacheReader reader = {};
+    EGLBoolean success = EGL_FALSE;
+    void *data = MAP_FAILED;
+    struct stat st;
+    int fd;
+
+    fd = open(cachePath, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return EGL_FALSE;
+    }
+
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        goto done;
+    }
+
+    data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+        goto done;
+    }
+
+    reader.data = (const unsigned char *) data;
+    reader.size = st.st_size;
+    success = ParseVendorConfigCache(&reader, dirs, formatVersion, list);
+
+done:
+    if (!success) {
+        FreeConfigList(list);
+    }
+    if (data != MAP_FAILED) {
+        munmap(data, st.st_size);
+    }
+    close(fd);
+    return success;
+}
+
+void __eglWriteVendorConfigCache(const char *cachePath,
+        char * const *dirs, unsigned int formatVersion,
+        const __EGLvendorConfigList *list, time_t startTime)
+{
+    __EGLcacheWriter writer = {};
+    __EGLcacheStatInfo info;
+    char *tempPath = NULL;
+    size_t written;
+    int fd = -1;
+    int count;
+    int i, j;
+
+    for (i=0; dirs[i] != NULL; i++) {
+        if (IsRecentlyModified(dirs[i], startTime)) {
+            return;
+        }
+    }
+    for (i=0; i<list->count; i++) {
+        if (IsRecentlyModified(list->filenames[i], startTime)) {
+            return;
+        }
+    }
+
+    WriteBytes(&writer, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    WriteU32(&writer, CACHE_VERSION);
+    WriteU32(&writer, formatVersion);
+
+    for (count=0; dirs[count] != NULL; count++) {
+    }
+    WriteU32(&writer, count);
+    for (i=0; i<count; i++) {
+        GetStatInfo(dirs[i], &info);
+        WriteString(&writer, dirs[i]);
+        WriteStatInfo(&writer, &info);
+    }
+
+    WriteU32(&writer, list->count);
+    for (i=0; i<list->count; i++) {
+        const __EGLvendorConfig *config = &list->configs[i];
+
+        GetStatInfo(list->filenames[i], &info);
+        WriteString(&writer, list->filenames[i]);
+        WriteStatInfo(&writer, &info);
+
+        if (config->libraryPath != NULL) {
+            WriteU8(&writer, 1);
+            WriteString(&writer, config->libraryPath);
+            WriteU32(&writer, config->platformCount);
+            for (j=0; j<config->platformCount; j++) {
+                WriteU32(&writer, config->platforms[j]);
+            }
+            WriteU32(&writer, config->preferredPlatformCount);
+            for (j=0; j<config->preferredPlatformCount; j++) {
+                WriteU32(&writer, config->preferredPlatforms[j]);
+            }
+        } else {
+            WriteU8(&writer, 0);
+        }
+    }
+
+    if (writer.error) {
+        goto done;
+    }
+
+    // Write to a temporary file and then rename it, so that another process
+    // can't see a partially-written cache.
+    if (glvnd_asprintf(&tempPath, "%s.XXXXXX", cachePath) < 0) {
+        tempPath = NULL;
+        goto done;
+    }
+    fd = mkstemp(tempPath);
+    if (fd < 0) {
+        goto done;
+    }
+
+    written = 0;
+    while (written < writer.size) {
+        ssize_t ret = write(fd, writer.data + written, writer.size - written);
+        if (ret <= 0) {
+            break;
+        }
+        written += ret;
+    }
+    if (close(fd) != 0 || written != writer.size
+            || rename(tempPath, cachePath) != 0) {
+        unlink(tempPath);
+    }
+
+done:
+    free(tempPath);
+    free(writer.data);
+}
@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+#ifndef LIBEGLVENDORCACHE_H
+#define LIBEGLVENDORCACHE_H
+
+#include <time.h>
+#include <EGL/egl.h>
+
+/*!
+ * \file
+ *
+ * An optional on-disk cache of the vendor config files that LoadVendors finds
+ * in the vendor config directories.
+ *
+ * The cache records the contents of every config file, along with enough
+ * information from stat() about each directory and file to tell whether any
+ * of them have changed. When the cache is up to date, libEGL can skip
+ * scanning the directories and parsing the JSON files.
+ */
+
+/*!
+ * The contents of a vendor config file.
+ */
+typedef struct __EGLvendorConfigRec {
+    /*!
+     * The library path, or NULL if the file couldn't be read or isn't valid.
+     */
+    char *libraryPath;
+
+    /*!
+     * The platforms that the vendor says it supports, or NULL if the config
+     * file doesn't say. A vendor that lists its platforms isn't loaded until
+     * something asks for one of them.
+     */
+    EGLenum *platforms;
+    int platformCount;
+
+    /*!
+     * The platforms that the vendor should be tried first for, or NULL if the
+     * config file doesn't list any.
+     */
+    EGLenum *preferredPlatforms;
+    int preferredPlatformCount;
+
+    /*!
+     * The position of the config file in the search order.
+     */
+    int priority;
+} __EGLvendorConfig;
+
+/*!
+ * The list of vendor config files to load, in order.
+ */
+typedef struct __EGLvendorConfigListRec {
+    char **filenames;
+
+    /*!
+     * The contents of each config file.
+     */
+    __EGLvendorConfig *configs;
+
+    int count;
+    int allocCount;
+} __EGLvendorConfigList;
+
+/*!
+ * Reads the vendor config list from a cache file.
+ *
+ * This fails if the cache file is missing or malformed, if it was written for
+ * a different list of directories or a different \p formatVersion, or if any
+ * of the directories or config files have changed since it was written.
+ *
+ * \param cachePath The path to the cache file.
+ * \param dirs A NULL-terminated array of the vendor config directories.
+ * \param formatVersion The version of the config file format that libEGL
+ *      understands.
+ * \param[out] list Receives the config files. This must be empty, and is left
+ *      empty on failure.
+ * \return EGL_TRUE if \p list was filled in from the cache.
+ */
+EGLBoolean __eglReadVendorConfigCache(const char *cachePath,
+        char * const *dirs, unsigned int formatVersion,
+        __EGLvendorConfigList *list);
+
+/*!
+ * Writes the vendor config list to a cache file.
+ *
+ * The file is written to a temporary file and then renamed, so a process
+ * reading the cache at the same time will either see the old version or the
+ * new one.
+ *
+ * Nothing is written if any of the directories or config files were modified
+ * at or after \p startTime, since in that case the cache can't tell whether
+ * \p list is from before or after the change.
+ *
+ * \param cachePath The path to the cache file.
+ * \param dirs A NULL-terminated array of the vendor config directories.
+ * \param formatVersion The version of the config file format that libEGL
+ *      understands.
+ * \param list The config files, as read from \p dirs.
+ * \param startTime The time when libEGL started scanning \p dirs.
+ */
+void __eglWriteVendorConfigCache(const char *cachePath,
+        char * const *dirs, unsigned int formatVersion,
+        const __EGLvendorConfigList *list, time_t startTime);
+
+#endif // LIBEGLVENDORCACHE_H
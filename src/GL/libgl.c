@@ -45,11 +45,19 @@ void __attribute__((constructor)) __libGLInit(void)
 void _init(void)
 #endif
 {
+    const int *slots;
+    int slotCount;
+
     __glDispatchInit();
 
     // Register these entrypoints with GLdispatch so they can be overwritten at
     // runtime
     patchStubId = __glDispatchRegisterStubCallbacks(stub_get_patch_callbacks());
+
+    // Tell GLdispatch which functions these entrypoints need, so that it
+    // doesn't have to look up every function for each vendor.
+    slots = stub_get_public_slots(&slotCount);
+    __glDispatchRegisterStubSlots(slots, slotCount);
 }
 
 #if defined(USE_ATTRIBUTE_CONSTRUCTOR)
@@ -29,6 +29,8 @@
 
 #include "glvnd_genentry.h"
 #include "utils_misc.h"
+#include "glvnd_hash.h"
+#include "GLdispatch.h"
 
 #include <string.h>
 #include <stdint.h>
@@ -45,10 +47,109 @@
 #define GLX_STUBS_COUNT
 #include "g_glx_dispatch_stub_list.h"
 
+/*
+ * If we run out of the static stubs, then on x86-64, we generate more of
+ * them at runtime, RUNTIME_BLOCK_COUNT at a time. Each runtime stub jumps
+ * through its own slot in the block's function array.
+ */
+#if defined(USE_X86_64_ASM) && !defined(__ILP32__)
+#define USE_RUNTIME_STUBS 1
+#define RUNTIME_STUB_SIZE 16
+#define RUNTIME_BLOCK_COUNT 256
+
+/*
+ * If the __GLX_DIRECT_ENTRYPOINTS environment variable is set, then once an
+ * entrypoint's dispatch function is filled in, glvndUpdateEntrypoints
+ * rewrites the start of the stub to a jmp straight to it, which saves a load
+ * and an indirect branch on every call.
+ *
+ * The jmp only replaces the first 5 bytes of the stub, and it's written with
+ * a single 8-byte store, so a thread that's running the stub at the same time
+ * sees either the old code or the new code. A thread that's already past the
+ * first instruction still finishes the old stub, which jumps to the same
+ * function.
+ *
+ * A rel32 jmp can only reach 2GB, so any dispatch function that's farther
+ * away than that just keeps the indirect jump.
+ */
+#define USE_DIRECT_STUBS 1
+#define DIRECT_JMP_SIZE 5
+#endif
+
+#if defined(USE_DIRECT_STUBS)
+/*
+ * The static stubs go in their own page-aligned section so that we can
+ * change their protection without touching any other code.
+ */
+#if !defined(GLDISPATCH_PAGE_SIZE)
+#define GLDISPATCH_PAGE_SIZE 4096
+#endif
+#define STUB_SECTION_ALIGN GLDISPATCH_PAGE_SIZE
+#define STUB_SECTION_BEGIN ".section glxwtext,\"ax\",@progbits\n"
+#define STUB_SECTION_END ".text\n"
+#else
+#define STUB_SECTION_ALIGN STUB_SIZE
+#define STUB_SECTION_BEGIN ""
+#define STUB_SECTION_END ""
+#endif
+
+#define INITIAL_NAME_HASH_SIZE 64
+
+typedef struct {
+    /// The name, from libGLdispatch's string pool.
+    const char *name;
+    unsigned int hash;
+
+#if defined(USE_DIRECT_STUBS)
+    /// Non-zero if the stub has been rewritten to jump straight to its
+    /// function. This is -1 while UpdateDirectStubRange is changing it.
+    int isDirect;
+#endif
+} GLVNDentrypointName;
+
+#if defined(USE_RUNTIME_STUBS)
+typedef struct {
+    GLVNDentrypointStub functions[RUNTIME_BLOCK_COUNT];
+    unsigned char *code;
+} GLVNDentrypointBlock;
+
+static GLVNDentrypointBlock **runtimeBlocks = NULL;
+static int runtimeBlockCount = 0;
+#endif
+
 static GLVNDentrypointStub entrypointFunctions[GENERATED_ENTRYPOINT_MAX];
-static char *entrypointNames[GENERATED_ENTRYPOINT_MAX] = {};
+static GLVNDentrypointName *entrypointNames = NULL;
+static int entrypointNameAllocCount = 0;
 static int entrypointCount = 0;
 
+/*
+ * The number of entrypoints that still point to DefaultDispatchFunc, so that
+ * glvndUpdateEntrypoints can skip the list once they've all been filled in.
+ */
+static int unresolvedCount = 0;
+
+/*
+ * An open-addressed hashtable of (index + 1) into entrypointNames, keyed by
+ * the function name. A zero means an empty slot. The size is always a power
+ * of two and at least twice the number of entrypoints.
+ */
+static int *entrypointNameHash = NULL;
+static int entrypointNameHashSize = 0;
+
+#if defined(USE_DIRECT_STUBS)
+/*
+ * Non-zero if __GLX_DIRECT_ENTRYPOINTS is set, or -1 if we haven't checked
+ * yet.
+ */
+static int directStubsEnabled = -1;
+
+/*
+ * A copy of the static stubs from before we first changed them, so that
+ * glvndFreeEntrypoints can put them back.
+ */
+static unsigned char *savedStaticStubs = NULL;
+#endif
+
 extern char glx_entrypoint_start[];
 extern char glx_entrypoint_end[];
 
@@ -97,6 +198,23 @@ extern char glx_entrypoint_end[];
     "ldr x16, [x16, #:lo12:(entrypointFunctions + " slot "*8)]\n" \
     "br x16\n"
 
+#elif defined(USE_RISCV64_ASM)
+
+#define STUB_SIZE 16
+#define STUB_ASM_ARCH(slot) \
+    "1:\n" \
+    "auipc t1, %pcrel_hi(entrypointFunctions + " slot "*8)\n" \
+    "ld t1, %pcrel_lo(1b)(t1)\n" \
+    "jr t1\n"
+
+#elif defined(USE_LOONGARCH64_ASM)
+
+#define STUB_SIZE 16
+#define STUB_ASM_ARCH(slot) \
+    "pcalau12i $t0, %pc_hi20(entrypointFunctions + " slot "*8)\n" \
+    "ld.d $t0, $t0, %pc_lo12(entrypointFunctions + " slot "*8)\n" \
+    "jr $t0\n"
+
 #elif defined(USE_PPC64_ASM) && defined(_CALL_ELF) && (_CALL_ELF == 2)
 
 #define STUB_SIZE 32
@@ -121,9 +239,10 @@ extern char glx_entrypoint_end[];
     "glx_entrypoint_stub_" slot ":\n" \
     STUB_ASM_ARCH(slot)
 
-__asm__(".globl glx_entrypoint_start\n"
+__asm__(STUB_SECTION_BEGIN
+        ".globl glx_entrypoint_start\n"
         ".hidden glx_entrypoint_start\n"
-        ".balign " U_STRINGIFY(STUB_SIZE) "\n" \
+        ".balign " U_STRINGIFY(STUB_SECTION_ALIGN) "\n" \
         "glx_entrypoint_start:\n"
 
 #define GLX_STUBS_ASM
@@ -131,8 +250,9 @@ __asm__(".globl glx_entrypoint_start\n"
 
         ".globl glx_entrypoint_end\n"
         ".hidden glx_entrypoint_end\n"
-        ".balign " U_STRINGIFY(STUB_SIZE) "\n" \
+        ".balign " U_STRINGIFY(STUB_SECTION_ALIGN) "\n" \
         "glx_entrypoint_end:\n"
+        STUB_SECTION_END
 );
 
 static void *DefaultDispatchFunc(void)
@@ -143,56 +263,534 @@ static void *DefaultDispatchFunc(void)
 
 static GLVNDentrypointStub GetEntrypointStub(int index)
 {
+#if defined(USE_RUNTIME_STUBS)
+    if (index >= GENERATED_ENTRYPOINT_MAX) {
+        index -= GENERATED_ENTRYPOINT_MAX;
+        return (GLVNDentrypointStub) (runtimeBlocks[index / RUNTIME_BLOCK_COUNT]->code
+                + (index % RUNTIME_BLOCK_COUNT) * RUNTIME_STUB_SIZE);
+    }
+#endif
     return (GLVNDentrypointStub) (glx_entrypoint_start + (index * STUB_SIZE));
 }
 
-GLVNDentrypointStub glvndGenerateEntrypoint(const char *procName)
+static int GetEntrypointStubSize(int index)
+{
+#if defined(USE_RUNTIME_STUBS)
+    if (index >= GENERATED_ENTRYPOINT_MAX) {
+        return RUNTIME_STUB_SIZE;
+    }
+#endif
+    return STUB_SIZE;
+}
+
+/**
+ * Returns the function pointer that an entrypoint jumps through.
+ */
+static GLVNDentrypointStub *GetEntrypointFunction(int index)
+{
+#if defined(USE_RUNTIME_STUBS)
+    if (index >= GENERATED_ENTRYPOINT_MAX) {
+        index -= GENERATED_ENTRYPOINT_MAX;
+        return &runtimeBlocks[index / RUNTIME_BLOCK_COUNT]->functions[index % RUNTIME_BLOCK_COUNT];
+    }
+#endif
+    return &entrypointFunctions[index];
+}
+
+#if defined(USE_RUNTIME_STUBS)
+/**
+ * Writes the code for a block of runtime stubs to \p code.
+ */
+static void WriteRuntimeStubs(GLVNDentrypointBlock *block, unsigned char *code)
 {
     int i;
 
-    for (i=0; i<entrypointCount; i++) {
-        if (strcmp(procName, entrypointNames[i]) == 0) {
+    for (i=0; i<RUNTIME_BLOCK_COUNT; i++) {
+        unsigned char *stub = code + i * RUNTIME_STUB_SIZE;
+        uint64_t addr = (uint64_t) (uintptr_t) &block->functions[i];
+
+        // movabs $addr, %rax
+        stub[0] = 0x48;
+        stub[1] = 0xb8;
+        memcpy(stub + 2, &addr, sizeof(addr));
+        // jmp *(%rax)
+        stub[10] = 0xff;
+        stub[11] = 0x20;
+        memset(stub + 12, 0xcc, RUNTIME_STUB_SIZE - 12);
+    }
+}
+
+/**
+ * Allocates the read/exec pages for a block of runtime stubs and fills them
+ * in.
+ *
+ * If memfd_create is available, then this writes the stubs through a
+ * writable mapping of a memfd, and then maps the same memfd again as
+ * read/exec, the same way that libGLdispatch patches its entrypoints. No
+ * mapping is ever both writable and executable, and no mapping ever goes
+ * from writable to executable, so this still works on kernels that enforce
+ * W^X. Otherwise, this writes to an anonymous mapping and then makes it
+ * read/exec.
+ */
+static unsigned char *MapRuntimeCode(GLVNDentrypointBlock *block)
+{
+    size_t size = RUNTIME_BLOCK_COUNT * RUNTIME_STUB_SIZE;
+    void *code;
+
+#if defined(HAVE_MEMFD_CREATE)
+    int fd = memfd_create("glvnd-glx-entrypoints", MFD_CLOEXEC);
+    if (fd >= 0) {
+        code = MAP_FAILED;
+        if (ftruncate(fd, size) == 0) {
+            void *writable = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                    MAP_SHARED, fd, 0);
+            if (writable != MAP_FAILED) {
+                WriteRuntimeStubs(block, writable);
+                code = mmap(NULL, size, PROT_READ | PROT_EXEC, MAP_SHARED, fd, 0);
+                munmap(writable, size);
+            }
+        }
+        close(fd);
+        if (code != MAP_FAILED) {
+            return code;
+        }
+    }
+#endif
+
+    code = mmap(NULL, size, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (code == MAP_FAILED) {
+        return NULL;
+    }
+    WriteRuntimeStubs(block, code);
+    if (mprotect(code, size, PROT_READ | PROT_EXEC) != 0) {
+        munmap(code, size);
+        return NULL;
+    }
+    return code;
+}
+
+/**
+ * Generates another block of runtime stubs.
+ */
+static int AddRuntimeBlock(void)
+{
+    GLVNDentrypointBlock **newBlocks;
+    GLVNDentrypointBlock *block;
+    int i;
+
+    newBlocks = realloc(runtimeBlocks, (runtimeBlockCount + 1) * sizeof(GLVNDentrypointBlock *));
+    if (newBlocks == NULL) {
+        return 0;
+    }
+    runtimeBlocks = newBlocks;
+
+    block = malloc(sizeof(GLVNDentrypointBlock));
+    if (block == NULL) {
+        return 0;
+    }
+
+    for (i=0; i<RUNTIME_BLOCK_COUNT; i++) {
+        block->functions[i] = NULL;
+    }
+
+    block->code = MapRuntimeCode(block);
+    if (block->code == NULL) {
+        free(block);
+        return 0;
+    }
+
+    runtimeBlocks[runtimeBlockCount++] = block;
+    return 1;
+}
+
+static void FreeRuntimeBlocks(void)
+{
+    int i;
+
+    for (i=0; i<runtimeBlockCount; i++) {
+        munmap(runtimeBlocks[i]->code, RUNTIME_BLOCK_COUNT * RUNTIME_STUB_SIZE);
+        free(runtimeBlocks[i]);
+    }
+    free(runtimeBlocks);
+    runtimeBlocks = NULL;
+    runtimeBlockCount = 0;
+}
+#endif // defined(USE_RUNTIME_STUBS)
+
+#if defined(USE_DIRECT_STUBS)
+static int DirectStubsEnabled(void)
+{
+    if (directStubsEnabled < 0) {
+        const char *env = glvndGetEnv("__GLX_DIRECT_ENTRYPOINTS");
+        directStubsEnabled = (env != NULL && atoi(env) != 0);
+    }
+    return directStubsEnabled;
+}
+
+/**
+ * Keeps track of a range of stubs that we're changing.
+ *
+ * Like libGLdispatch's entrypoint patching, if memfd_create is available,
+ * then the changes go to a writable copy in a new memfd, which then gets
+ * mapped as read/exec on top of the stubs. Otherwise, the stubs are made
+ * writable with mprotect(2) while we change them.
+ */
+typedef struct {
+    unsigned char *start;
+    size_t size;
+
+    /// Where the changes should be written to.
+    unsigned char *write;
+    int fd;
+} GLVNDstubPatch;
+
+static int BeginStubPatch(GLVNDstubPatch *patch, unsigned char *start, size_t size)
+{
+    long pageSize = sysconf(_SC_PAGESIZE);
+
+    if (pageSize <= 0 || ((uintptr_t) start) % pageSize != 0 || size % pageSize != 0) {
+        return 0;
+    }
+
+    patch->start = start;
+    patch->size = size;
+    patch->fd = -1;
+
+#if defined(HAVE_MEMFD_CREATE)
+    patch->fd = memfd_create("glvnd-glx-entrypoints", MFD_CLOEXEC);
+    if (patch->fd >= 0) {
+        if (ftruncate(patch->fd, size) == 0) {
+            void *scratch = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                    MAP_SHARED, patch->fd, 0);
+            if (scratch != MAP_FAILED) {
+                memcpy(scratch, start, size);
+                patch->write = scratch;
+                return 1;
+            }
+        }
+        close(patch->fd);
+        patch->fd = -1;
+    }
+#endif
+
+    if (mprotect(start, size, PROT_READ | PROT_WRITE | PROT_EXEC) != 0) {
+        return 0;
+    }
+    patch->write = start;
+    return 1;
+}
+
+/**
+ * Finishes changing the stubs.
+ *
+ * \return Non-zero on success, or zero if the changes were dropped.
+ */
+static int FinishStubPatch(GLVNDstubPatch *patch)
+{
+#if defined(HAVE_MEMFD_CREATE)
+    if (patch->fd >= 0) {
+        int success = (mmap(patch->start, patch->size, PROT_READ | PROT_EXEC,
+                    MAP_SHARED | MAP_FIXED, patch->fd, 0) != MAP_FAILED);
+        munmap(patch->write, patch->size);
+        close(patch->fd);
+        return success;
+    }
+#endif
+
+    mprotect(patch->start, patch->size, PROT_READ | PROT_EXEC);
+    return 1;
+}
+
+/**
+ * Rewrites a stub to jump straight to \p target.
+ *
+ * \param write The address to write the new code to.
+ * \param stub The address that the stub will run from.
+ * \return Non-zero on success, or zero if \p target is too far away.
+ */
+static int WriteDirectJump(unsigned char *write, const unsigned char *stub,
+        GLVNDentrypointStub target)
+{
+    intptr_t disp = ((intptr_t) target) - ((intptr_t) stub + DIRECT_JMP_SIZE);
+    int32_t disp32 = (int32_t) disp;
+    uint64_t code;
+
+    if ((intptr_t) disp32 != disp) {
+        return 0;
+    }
+
+    // jmp rel32, leaving the rest of the old code as it is.
+    memcpy(&code, write, sizeof(code));
+    ((unsigned char *) &code)[0] = 0xe9;
+    memcpy(((unsigned char *) &code) + 1, &disp32, sizeof(disp32));
+
+    // An aligned 8-byte store is atomic on x86-64, so we only need to keep
+    // the compiler from splitting or reordering it.
+    assert(((uintptr_t) write) % sizeof(uint64_t) == 0);
+    __asm__ __volatile__("" : : : "memory");
+    *((uint64_t volatile *) write) = code;
+    __asm__ __volatile__("" : : : "memory");
+    return 1;
+}
+
+/**
+ * Rewrites any resolved stubs from \p first to \p last - 1 that aren't
+ * direct yet. All of those stubs must be in the same block of code, starting
+ * at \p start.
+ */
+static void UpdateDirectStubRange(int first, int last, unsigned char *start,
+        size_t size)
+{
+    GLVNDstubPatch patch;
+    int success;
+    int i;
+
+    for (i=first; i<last; i++) {
+        if (!entrypointNames[i].isDirect
+                && *GetEntrypointFunction(i) != (GLVNDentrypointStub) DefaultDispatchFunc) {
+            break;
+        }
+    }
+    if (i >= last) {
+        return;
+    }
+
+    if (!BeginStubPatch(&patch, start, size)) {
+        return;
+    }
+    for (; i<last; i++) {
+        GLVNDentrypointStub func = *GetEntrypointFunction(i);
+        unsigned char *stub = (unsigned char *) GetEntrypointStub(i);
+
+        if (!entrypointNames[i].isDirect
+                && func != (GLVNDentrypointStub) DefaultDispatchFunc
+                && WriteDirectJump(patch.write + (stub - start), stub, func)) {
+            entrypointNames[i].isDirect = -1;
+        }
+    }
+
+    // If we couldn't map in the new stubs, then the old ones are still there,
+    // and they still work.
+    success = FinishStubPatch(&patch);
+    for (i=first; i<last; i++) {
+        if (entrypointNames[i].isDirect < 0) {
+            entrypointNames[i].isDirect = success;
+        }
+    }
+}
+
+static void UpdateDirectStubs(void)
+{
+    int count = (entrypointCount < GENERATED_ENTRYPOINT_MAX
+            ? entrypointCount : GENERATED_ENTRYPOINT_MAX);
+    size_t staticSize = glx_entrypoint_end - glx_entrypoint_start;
+    int i;
+
+    if (count > 0 && savedStaticStubs == NULL) {
+        savedStaticStubs = malloc(staticSize);
+        if (savedStaticStubs == NULL) {
+            return;
+        }
+        memcpy(savedStaticStubs, glx_entrypoint_start, staticSize);
+    }
+    UpdateDirectStubRange(0, count, (unsigned char *) glx_entrypoint_start,
+            staticSize);
+
+    for (i=0; i<runtimeBlockCount; i++) {
+        int first = GENERATED_ENTRYPOINT_MAX + i * RUNTIME_BLOCK_COUNT;
+        int last = first + RUNTIME_BLOCK_COUNT;
+
+        if (last > entrypointCount) {
+            last = entrypointCount;
+        }
+        UpdateDirectStubRange(first, last, runtimeBlocks[i]->code,
+                RUNTIME_BLOCK_COUNT * RUNTIME_STUB_SIZE);
+    }
+}
+
+/**
+ * Puts the static stubs back the way that they started.
+ */
+static void RestoreStaticStubs(void)
+{
+    GLVNDstubPatch patch;
+
+    if (savedStaticStubs != NULL) {
+        size_t size = glx_entrypoint_end - glx_entrypoint_start;
+        if (BeginStubPatch(&patch, (unsigned char *) glx_entrypoint_start, size)) {
+            memcpy(patch.write, savedStaticStubs, size);
+            FinishStubPatch(&patch);
+        }
+        free(savedStaticStubs);
+        savedStaticStubs = NULL;
+    }
+}
+#endif // defined(USE_DIRECT_STUBS)
+
+/**
+ * Returns non-zero if there's a stub available for another entrypoint,
+ * generating more stubs if needed.
+ */
+static int ReserveEntrypointStub(void)
+{
+    if (entrypointCount < GENERATED_ENTRYPOINT_MAX) {
+        return 1;
+    }
+#if defined(USE_RUNTIME_STUBS)
+    if (entrypointCount < GENERATED_ENTRYPOINT_MAX + runtimeBlockCount * RUNTIME_BLOCK_COUNT) {
+        return 1;
+    }
+    return AddRuntimeBlock();
+#else
+    return 0;
+#endif
+}
+
+/**
+ * Returns the slot in entrypointNameHash for a name, which is either the slot
+ * that holds it or the empty slot where it would go.
+ */
+static int FindEntrypointHashSlot(const char *name, unsigned int hash)
+{
+    int mask = entrypointNameHashSize - 1;
+    int slot = (int) (hash & mask);
+
+    while (entrypointNameHash[slot] != 0) {
+        const GLVNDentrypointName *entry = &entrypointNames[entrypointNameHash[slot] - 1];
+        if (entry->hash == hash && strcmp(entry->name, name) == 0) {
+            break;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+static int GrowEntrypointNameHash(void)
+{
+    int *oldHash = entrypointNameHash;
+    int oldSize = entrypointNameHashSize;
+    int newSize = (oldSize > 0 ? oldSize * 2 : INITIAL_NAME_HASH_SIZE);
+    int i;
+
+    entrypointNameHash = calloc(newSize, sizeof(int));
+    if (entrypointNameHash == NULL) {
+        entrypointNameHash = oldHash;
+        return 0;
+    }
+    entrypointNameHashSize = newSize;
+
+    for (i=0; i<oldSize; i++) {
+        if (oldHash[i] != 0) {
+            const GLVNDentrypointName *entry = &entrypointNames[oldHash[i] - 1];
+            entrypointNameHash[FindEntrypointHashSlot(entry->name, entry->hash)] = oldHash[i];
+        }
+    }
+    free(oldHash);
+    return 1;
+}
+
+GLVNDentrypointStub glvndGenerateEntrypoint(const char *procName)
+{
+    unsigned int hash = glvndHashString(procName);
+    int slot;
+
+    if (entrypointNameHash != NULL) {
+        slot = FindEntrypointHashSlot(procName, hash);
+        if (entrypointNameHash[slot] != 0) {
             // We already generated this function, so return it.
-            return GetEntrypointStub(i);
+            return GetEntrypointStub(entrypointNameHash[slot] - 1);
         }
     }
 
-    if (entrypointCount >= GENERATED_ENTRYPOINT_MAX) {
+    if (!ReserveEntrypointStub()) {
         return NULL;
     }
 
-    entrypointNames[entrypointCount] = strdup(procName);
-    if (entrypointNames[entrypointCount] == NULL) {
+    if ((entrypointCount + 1) * 2 > entrypointNameHashSize) {
+        if (!GrowEntrypointNameHash()) {
+            return NULL;
+        }
+    }
+
+    if (entrypointCount == entrypointNameAllocCount) {
+        GLVNDentrypointName *newNames;
+        int newSize = (entrypointNameAllocCount > 0 ? entrypointNameAllocCount * 2
+                : INITIAL_NAME_HASH_SIZE);
+
+        newNames = realloc(entrypointNames, newSize * sizeof(GLVNDentrypointName));
+        if (newNames == NULL) {
+            return NULL;
+        }
+        entrypointNames = newNames;
+        entrypointNameAllocCount = newSize;
+    }
+
+    entrypointNames[entrypointCount].name = __glDispatchInternString(procName);
+    if (entrypointNames[entrypointCount].name == NULL) {
         return NULL;
     }
+    entrypointNames[entrypointCount].hash = hash;
+#if defined(USE_DIRECT_STUBS)
+    entrypointNames[entrypointCount].isDirect = 0;
+#endif
+
+    slot = FindEntrypointHashSlot(procName, hash);
+    assert(entrypointNameHash[slot] == 0);
+    entrypointNameHash[slot] = entrypointCount + 1;
 
-    entrypointFunctions[entrypointCount] = (GLVNDentrypointStub) DefaultDispatchFunc;
+    *GetEntrypointFunction(entrypointCount) = (GLVNDentrypointStub) DefaultDispatchFunc;
+    __glDispatchRegisterStubSymbol((const void *) GetEntrypointStub(entrypointCount),
+            GetEntrypointStubSize(entrypointCount), entrypointNames[entrypointCount].name);
     entrypointCount++;
+    unresolvedCount++;
     return GetEntrypointStub(entrypointCount - 1);
 }
 
 void glvndFreeEntrypoints(void)
 {
     int i;
+
+#if defined(USE_DIRECT_STUBS)
+    RestoreStaticStubs();
+#endif
     for (i=0; i<entrypointCount; i++) {
-        free(entrypointNames[i]);
-        entrypointNames[i] = NULL;
-        entrypointFunctions[i] = NULL;
+        *GetEntrypointFunction(i) = NULL;
     }
+    free(entrypointNames);
+    entrypointNames = NULL;
+    entrypointNameAllocCount = 0;
     entrypointCount = 0;
+    unresolvedCount = 0;
+
+    free(entrypointNameHash);
+    entrypointNameHash = NULL;
+    entrypointNameHashSize = 0;
+
+#if defined(USE_RUNTIME_STUBS)
+    FreeRuntimeBlocks();
+#endif
 }
 
 void glvndUpdateEntrypoints(GLVNDentrypointUpdateCallback callback, void *param)
 {
     int i;
-    for (i=0; i<entrypointCount; i++) {
-        if (entrypointFunctions[i] == (GLVNDentrypointStub) DefaultDispatchFunc) {
-            GLVNDentrypointStub addr = callback(entrypointNames[i], param);
+    for (i=0; i<entrypointCount && unresolvedCount > 0; i++) {
+        GLVNDentrypointStub *func = GetEntrypointFunction(i);
+        if (*func == (GLVNDentrypointStub) DefaultDispatchFunc) {
+            GLVNDentrypointStub addr = callback(entrypointNames[i].name, param);
             if (addr != NULL) {
-                entrypointFunctions[i] = addr;
+                *func = addr;
+                unresolvedCount--;
             }
         }
     }
+
+#if defined(USE_DIRECT_STUBS)
+    if (DirectStubsEnabled()) {
+        UpdateDirectStubs();
+    }
+#endif
 }
 
 #else // defined(USE_DISPATCH_ASM)
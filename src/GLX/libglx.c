@@ -31,6 +31,7 @@
 #include <X11/Xlibint.h>
 #include <X11/Xproto.h>
 #include <dlfcn.h>
+#include <stdint.h>
 #include <string.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -38,6 +39,7 @@
 #include "libglxthread.h"
 #include "libglxabipriv.h"
 #include "libglxmapping.h"
+#include "libglxproto.h"
 #include "libglxcurrent.h"
 #include "utils_misc.h"
 #include "trace.h"
@@ -45,12 +47,16 @@
 #include "libglxgl.h"
 #include "glvnd_list.h"
 #include "app_error_check.h"
+#include "glvnd_fork.h"
+#include "glvnd_exit.h"
+#include "glvnd_atomic.h"
+#include "proc_address_cache.h"
+#include "glvnd_hashmap.h"
+#include "glvnd_memstats.h"
+#include "glvnd/glvnd.h"
 
-#include "lkdhash.h"
 
 /* current version numbers */
-#define GLX_MAJOR_VERSION 1
-#define GLX_MINOR_VERSION 4
 #define GLX_VERSION_STRING "1.4"
 
 /*
@@ -64,6 +70,7 @@
 #endif
 
 static glvnd_mutex_t clientStringLock = GLVND_MUTEX_INITIALIZER;
+static glvnd_lock_stats_t clientStringLockStats;
 
 /**
  * This structure keeps track of a rendering context.
@@ -74,17 +81,45 @@ static glvnd_mutex_t clientStringLock = GLVND_MUTEX_INITIALIZER;
 struct __GLXcontextInfoRec {
     GLXContext context;
     __GLXvendorInfo *vendor;
+
+    /**
+     * The display that the context was created or imported on. This is only
+     * used to clean up the context when the display is closed.
+     */
+    Display *dpy;
+
     int currentCount;
+
+    /**
+     * The number of CommonMakeCurrent calls that are using this context
+     * without holding the context's lock. The structure won't be freed
+     * while this is non-zero, even if the context is deleted.
+     */
+    int pinCount;
     Bool deleted;
-    UT_hash_handle hh;
-};
 
-static __GLXcontextInfo *glxContextHash = NULL;
+    /**
+     * The vendor's answer to glXIsDirect, or -1 if it hasn't been asked yet.
+     * A context can't change between direct and indirect, so this is set at
+     * most once, with a release store.
+     */
+    int volatile isDirect;
+
+    /**
+     * The ID that this context was imported from with glXImportContextEXT,
+     * or \c None.
+     */
+    GLXContextID importedID;
+};
 
 /**
- * The mutex used to protect the \c glxContextHash hash. Any thread must
- * take this mutex before it accesses the \c glxContextHash, or before it
- * modifies any field in a __GLXcontextInfo structure.
+ * The map from GLXContext handles to __GLXcontextInfo structures.
+ *
+ * A thread must lock a context's key with \c LockContextInfo before it adds or
+ * removes the context, or before it modifies any field in its
+ * __GLXcontextInfo structure. Looking up the vendor only needs a read section,
+ * so threads which are creating, destroying, or looking up different contexts
+ * don't have to wait for each other.
  *
  * Note that a \c __GLXcontextInfo struct will stay valid for as long as a context
  * is. That is, it's only freed when the context is deleted and no longer
@@ -92,20 +127,40 @@ static __GLXcontextInfo *glxContextHash = NULL;
  *
  * Also note that the \c context and \c vendor values are never modified for
  * the life of the structure. Thus, it's safe to access them for the current
- * thread's current context without having to take the \c glxContextHashLock
- * mutex.
+ * thread's current context without having to take any lock.
+ *
+ * The locks are not held while calling into a vendor library or into
+ * libGLdispatch, so that threads which are making different contexts current
+ * don't have to wait for each other.
  */
-static glvnd_mutex_t glxContextHashLock;
+static __GLVNDhashMap glxContextHash = GLVND_HASHMAP_INITIALIZER(free);
 
 /**
- * A list of current __GLXThreadState structures. This is used so that we can
- * clean up at process termination or after a fork.
+ * A list of every __GLXThreadState structure, including the ones in
+ * threadStateCacheKey. This is used so that we can clean up at process
+ * termination or after a fork.
  */
 static struct glvnd_list currentThreadStateList;
-static glvnd_mutex_t currentThreadStateListMutex = GLVND_MUTEX_INITIALIZER;
+static glvnd_adaptive_mutex_t currentThreadStateListMutex = GLVND_ADAPTIVE_MUTEX_INITIALIZER;
+
+/**
+ * Holds each thread's __GLXThreadState while it doesn't have a current
+ * context, so that the next glXMakeCurrent can reuse it. A cached state stays
+ * in currentThreadStateList, so releasing and re-acquiring a context doesn't
+ * allocate anything or take currentThreadStateListMutex.
+ */
+static glvnd_key_t threadStateCacheKey;
+
+/**
+ * The top of each thread's stack for glXPushCurrentGLVND. Each entry is a
+ * suspended __GLXThreadState, linked through pushedNext. An entry with a NULL
+ * currentContext means that there was no current context.
+ */
+static glvnd_key_t pushedStateKey;
 
 static __GLXThreadState *CreateThreadState(__GLXvendorInfo *vendor);
 static void DestroyThreadState(__GLXThreadState *threadState);
+static void FreeThreadState(__GLXThreadState *threadState);
 
 /*!
  * Updates the current context.
@@ -113,8 +168,7 @@ static void DestroyThreadState(__GLXThreadState *threadState);
  * If the old context was flagged for deletion and is no longer current to any
  * thread, then it will also remove the context from the context hashtable.
  *
- * \note glxContextHashLock must be locked before calling this
- * function.
+ * This function takes the contexts' locks in glxContextHash.
  *
  * \param[in] newCtxInfo The new context to make current, or \c NULL to just
  * release the current context.
@@ -123,11 +177,19 @@ static void DestroyThreadState(__GLXThreadState *threadState);
  */
 static void UpdateCurrentContext(__GLXcontextInfo *newCtxInfo, __GLXcontextInfo *oldCtxInfo);
 
+/**
+ * Locks or unlocks the entry in \c glxContextHash for a context.
+ *
+ * A thread should only hold one context's lock at a time.
+ */
+static void LockContextInfo(GLXContext context);
+static void UnlockContextInfo(GLXContext context);
+
 /**
  * Removes and frees an entry from the glxContextHash table.
  *
- * The caller must take the \c glxContextHashLock mutex before calling this
- * function.
+ * The caller must lock the context with \c LockContextInfo before calling
+ * this function.
  *
  * \param ctx The context to free.
  */
@@ -141,6 +203,12 @@ static void FreeContextInfo(__GLXcontextInfo *ctx);
  */
 static void CheckContextDeleted(__GLXcontextInfo *ctx);
 
+/**
+ * If \p context was imported, then removes its context ID from the display's
+ * cache. After the context is destroyed, the server can reuse the ID.
+ */
+static void ForgetImportedContext(Display *dpy, GLXContext context);
+
 static void __glXSendError(Display *dpy, unsigned char errorCode,
         XID resourceID, unsigned char minorCode, Bool coreX11error);
 
@@ -150,6 +218,11 @@ static void __glXSendError(Display *dpy, unsigned char errorCode,
  * This function will call __glXThreadInitialize and then look up the vendor
  * for a drawable.
  *
+ * If \p draw is the calling thread's current draw or read drawable on the
+ * same display, then it must belong to the current vendor, so this skips the
+ * display and drawable lookups. That covers glXSwapBuffers on the window that
+ * the thread is drawing to, which most applications call every frame.
+ *
  * If it can't find a vendor for the drawable, then it will call __glXSendError
  * to generate an error.
  *
@@ -171,7 +244,15 @@ static __GLXvendorInfo *CommonDispatchDrawable(Display *dpy, GLXDrawable draw,
     __GLXvendorInfo *vendor = NULL;
 
     if (draw != None) {
+        __GLXThreadState *threadState;
+
         __glXThreadInitialize();
+
+        threadState = __glXGetCurrentThreadState();
+        if (threadState != NULL && threadState->currentDisplay == dpy
+                && (draw == threadState->currentDraw || draw == threadState->currentRead)) {
+            return threadState->currentVendor;
+        }
         vendor = __glXVendorFromDrawable(dpy, draw);
     }
     if (vendor == NULL) {
@@ -328,113 +409,54 @@ PUBLIC void glXDestroyContext(Display *dpy, GLXContext context)
 
     vendor = CommonDispatchContext(dpy, context, X_GLXDestroyContext);
     if (vendor != NULL) {
+        ForgetImportedContext(dpy, context);
         __glXRemoveVendorContextMapping(dpy, context);
         vendor->staticDispatch.destroyContext(dpy, context);
     }
 }
 
-static Bool __glXIsDirect(Display *dpy, __GLXdisplayInfo *dpyInfo, GLXContextID context)
-{
-    xGLXIsDirectReq *req;
-    xGLXIsDirectReply reply;
-
-    assert(dpyInfo->glxSupported);
-
-    LockDisplay(dpy);
-
-    GetReq(GLXIsDirect, req);
-    req->reqType = dpyInfo->glxMajorOpcode;
-    req->glxCode = X_GLXIsDirect;
-    req->context = context;
-    _XReply(dpy, (xReply *) &reply, 0, False);
-
-    UnlockDisplay(dpy);
-    SyncHandle();
-
-    return reply.isDirect;
-}
-
 /**
- * Finds the screen number for a context, using the context's XID. This
- * function sends the request directly, so it doesn't rely on any vendor
- * library.
- *
- * Adapted from Mesa's glXImportContextEXT implementation.
+ * Records the ID that a context was imported from, so that it can be
+ * forgotten when the context is freed.
  */
-static int __glXGetScreenForContextID(Display *dpy, __GLXdisplayInfo *dpyInfo,
-        GLXContextID contextID)
+static void SetContextImportedID(GLXContext context, GLXContextID contextID)
 {
-    xGLXQueryContextReply reply;
-    int *propList;
-    int majorVersion, minorVersion;
-    int screen = -1;
-    int i;
-
-    assert(dpyInfo->glxSupported);
-
-    // Check the version number so that we know which request to send.
-    if (!glXQueryVersion(dpy, &majorVersion, &minorVersion)) {
-        return -1;
-    }
-
-    /* Send the glXQueryContextInfoEXT request */
-    LockDisplay(dpy);
-
-    if (majorVersion > 1 || minorVersion >= 3) {
-        xGLXQueryContextReq *req;
-
-        GetReq(GLXQueryContext, req);
-
-        req->reqType = dpyInfo->glxMajorOpcode;
-        req->glxCode = X_GLXQueryContext;
-        req->context = contextID;
-    } else {
-        xGLXVendorPrivateReq *vpreq;
-        xGLXQueryContextInfoEXTReq *req;
+    __GLXcontextInfo *ctxInfo;
 
-        GetReqExtra(GLXVendorPrivate,
-                sz_xGLXQueryContextInfoEXTReq - sz_xGLXVendorPrivateReq,
-                vpreq);
-        req = (xGLXQueryContextInfoEXTReq *) vpreq;
-        req->reqType = dpyInfo->glxMajorOpcode;
-        req->glxCode = X_GLXVendorPrivateWithReply;
-        req->vendorCode = X_GLXvop_QueryContextInfoEXT;
-        req->context = contextID;
+    LockContextInfo(context);
+    ctxInfo = (__GLXcontextInfo *) __glvndHashMapFind(&glxContextHash,
+            &context, sizeof(context));
+    if (ctxInfo != NULL) {
+        ctxInfo->importedID = contextID;
     }
+    UnlockContextInfo(context);
+}
 
-    _XReply(dpy, (xReply *) &reply, 0, False);
-
-    if (reply.n <= 0) {
-        UnlockDisplay(dpy);
-        SyncHandle();
-        return -1;
-    }
+static void ForgetImportedContext(Display *dpy, GLXContext context)
+{
+    __GLXcontextInfo *ctxInfo;
+    GLXContextID contextID = None;
 
-    propList = malloc(reply.n * 8);
-    if (propList == NULL) {
-        UnlockDisplay(dpy);
-        SyncHandle();
-        return -1;
+    __glvndHashMapReadBegin();
+    ctxInfo = (__GLXcontextInfo *) __glvndHashMapFind(&glxContextHash,
+            &context, sizeof(context));
+    if (ctxInfo != NULL) {
+        contextID = ctxInfo->importedID;
     }
-    _XRead(dpy, (char *) propList, reply.n * 8);
+    __glvndHashMapReadEnd();
 
-    UnlockDisplay(dpy);
-    SyncHandle();
-
-    for (i=0; i<reply.n; i++) {
-        int *prop = &propList[i * 2];
-        if (prop[0] == GLX_SCREEN) {
-            screen = prop[1];
-            break;
+    if (contextID != None) {
+        __GLXdisplayInfo *dpyInfo = __glXLookupDisplay(dpy);
+        if (dpyInfo != NULL) {
+            __glXRemoveImportedContext(dpyInfo, contextID);
         }
     }
-    free(propList);
-    return screen;
 }
 
 static GLXContext glXImportContextEXT(Display *dpy, GLXContextID contextID)
 {
     __GLXdisplayInfo *dpyInfo;
+    Bool isDirect;
     int screen;
     __GLXvendorInfo *vendor;
 
@@ -452,21 +474,26 @@ static GLXContext glXImportContextEXT(Display *dpy, GLXContextID contextID)
     *
     * If contextID is None, generate BadContext on the client-side.  Other
     * sorts of invalid contexts will be detected by the server in the
-    * __glXIsDirect call.
+    * __glXQueryContextInfo call.
     */
     if (contextID == None) {
         __glXSendError(dpy, GLXBadContext, contextID, X_GLXIsDirect, False);
         return NULL;
     }
 
-    if (__glXIsDirect(dpy, dpyInfo, contextID)) {
-        return NULL;
+    // The server's answers for a context ID are cached, so that importing
+    // the same context again doesn't need any round trips. The cached entry
+    // is removed when an imported context is freed or destroyed.
+    if (!__glXLookupImportedContext(dpyInfo, contextID, &isDirect, &screen)) {
+        // Find the screen number for the context. We can't rely on a vendor
+        // library yet, so send the requests manually.
+        if (!__glXQueryContextInfo(dpyInfo, contextID, &isDirect, &screen)) {
+            return NULL;
+        }
+        __glXAddImportedContext(dpyInfo, contextID, isDirect, screen);
     }
 
-    // Find the screen number for the context. We can't rely on a vendor
-    // library yet, so send the request manually.
-    screen = __glXGetScreenForContextID(dpy, dpyInfo, contextID);
-    if (screen < 0) {
+    if (isDirect || screen < 0) {
         return NULL;
     }
 
@@ -477,6 +504,8 @@ static GLXContext glXImportContextEXT(Display *dpy, GLXContextID contextID)
         if (__glXAddVendorContextMapping(dpy, context, vendor) != 0) {
             vendor->staticDispatch.freeContextEXT(dpy, context);
             context = NULL;
+        } else if (context != NULL) {
+            SetContextImportedID(context, contextID);
         }
         return context;
     } else {
@@ -492,6 +521,7 @@ static void glXFreeContextEXT(Display *dpy, GLXContext context)
 
     vendor = __glXVendorFromContext(context);
     if (vendor != NULL && vendor->staticDispatch.freeContextEXT != NULL) {
+        ForgetImportedContext(dpy, context);
         __glXRemoveVendorContextMapping(dpy, context);
         vendor->staticDispatch.freeContextEXT(dpy, context);
     }
@@ -543,11 +573,24 @@ PUBLIC int glXGetConfig(Display *dpy, XVisualInfo *vis, int attrib, int *value)
     }
 }
 
-PUBLIC GLXContext glXGetCurrentContext(void)
+/**
+ * Returns the current thread state for the glXGetCurrent* functions.
+ *
+ * Those functions only look at the calling thread's state, so they skip the
+ * rest of \c __glXThreadInitialize. They still check for a fork, though, so
+ * that a child process doesn't see its parent's current context before the
+ * fork handling has cleared it. That check is just a load and compare unless
+ * the process has actually forked.
+ */
+static __GLXThreadState *GetCurrentThreadStateForQuery(void)
 {
-    __glXThreadInitialize();
+    glvndCheckFork();
+    return __glXGetCurrentThreadState();
+}
 
-    __GLXThreadState *threadState = __glXGetCurrentThreadState();
+PUBLIC GLXContext glXGetCurrentContext(void)
+{
+    __GLXThreadState *threadState = GetCurrentThreadStateForQuery();
     if (threadState != NULL) {
         // The current thread has a thread state pointer if and only if it has a
         // current context, and the currentContext pointer is assigned before
@@ -562,9 +605,7 @@ PUBLIC GLXContext glXGetCurrentContext(void)
 
 PUBLIC GLXDrawable glXGetCurrentDrawable(void)
 {
-    __glXThreadInitialize();
-
-    __GLXThreadState *threadState = __glXGetCurrentThreadState();
+    __GLXThreadState *threadState = GetCurrentThreadStateForQuery();
     if (threadState != NULL) {
         return threadState->currentDraw;
     } else {
@@ -574,9 +615,7 @@ PUBLIC GLXDrawable glXGetCurrentDrawable(void)
 
 PUBLIC GLXDrawable glXGetCurrentReadDrawable(void)
 {
-    __glXThreadInitialize();
-
-    __GLXThreadState *threadState = __glXGetCurrentThreadState();
+    __GLXThreadState *threadState = GetCurrentThreadStateForQuery();
     if (threadState != NULL) {
         return threadState->currentRead;
     } else {
@@ -586,9 +625,7 @@ PUBLIC GLXDrawable glXGetCurrentReadDrawable(void)
 
 PUBLIC Display *glXGetCurrentDisplay(void)
 {
-    __glXThreadInitialize();
-
-    __GLXThreadState *threadState = __glXGetCurrentThreadState();
+    __GLXThreadState *threadState = GetCurrentThreadStateForQuery();
     if (threadState != NULL) {
         return threadState->currentDisplay;
     } else {
@@ -611,12 +648,73 @@ __GLXvendorInfo *__glXGetCurrentDynDispatch(void)
 
 PUBLIC Bool glXIsDirect(Display *dpy, GLXContext context)
 {
-    __GLXvendorInfo *vendor = CommonDispatchContext(dpy, context, X_GLXIsDirect);
-    if (vendor != NULL) {
-        return vendor->staticDispatch.isDirect(dpy, context);
-    } else {
+    __GLXcontextInfo *ctxInfo;
+    __GLXvendorInfo *vendor = NULL;
+    int isDirect = -1;
+    Bool ret;
+
+    // A context can't change between direct and indirect, so only ask the
+    // vendor once per context.
+    if (context != NULL) {
+        __glXThreadInitialize();
+
+        __glvndHashMapReadBegin();
+        ctxInfo = (__GLXcontextInfo *) __glvndHashMapFind(&glxContextHash,
+                &context, sizeof(context));
+        if (ctxInfo != NULL) {
+            vendor = ctxInfo->vendor;
+            isDirect = glvndAtomicLoadAcquire(&ctxInfo->isDirect);
+        }
+        __glvndHashMapReadEnd();
+    }
+    if (vendor == NULL) {
+        __glXSendError(dpy, GLXBadContext, 0, X_GLXIsDirect, False);
         return False;
     }
+    if (isDirect >= 0) {
+        return isDirect;
+    }
+
+    ret = vendor->staticDispatch.isDirect(dpy, context) ? True : False;
+
+    LockContextInfo(context);
+    ctxInfo = (__GLXcontextInfo *) __glvndHashMapFind(&glxContextHash,
+            &context, sizeof(context));
+    if (ctxInfo != NULL && ctxInfo->vendor == vendor) {
+        glvndAtomicStoreRelease(&ctxInfo->isDirect, ret);
+    }
+    UnlockContextInfo(context);
+
+    return ret;
+}
+
+/**
+ * Removes every context that belongs to a display that's being closed.
+ *
+ * Closing the display destroys its contexts in the server, so the app can't
+ * use or destroy them after this. A context that's still current or pinned
+ * in another thread is marked as deleted instead, and is freed when that
+ * thread releases it.
+ *
+ * This takes every lock in glxContextHash once, rather than locking each
+ * context separately.
+ */
+static void SweepDisplayContexts(Display *dpy)
+{
+    __GLVNDhashMapIter iter;
+    const void *key;
+    void *value;
+
+    __glvndHashMapLockAll(&glxContextHash);
+    __glvndHashMapIterInit(&glxContextHash, &iter);
+    while (__glvndHashMapIterNext(&iter, &key, &value)) {
+        __GLXcontextInfo *ctxInfo = (__GLXcontextInfo *) value;
+        if (ctxInfo->dpy == dpy) {
+            ctxInfo->deleted = True;
+            CheckContextDeleted(ctxInfo);
+        }
+    }
+    __glvndHashMapUnlockAll(&glxContextHash);
 }
 
 void __glXDisplayClosed(__GLXdisplayInfo *dpyInfo)
@@ -628,13 +726,11 @@ void __glXDisplayClosed(__GLXdisplayInfo *dpyInfo)
         // Clear out the current context, but don't call into the vendor
         // library or do anything that might require a valid display.
         __glDispatchLoseCurrent();
-        __glvndPthreadFuncs.mutex_lock(&glxContextHashLock);
         UpdateCurrentContext(NULL, threadState->currentContext);
-        __glvndPthreadFuncs.mutex_unlock(&glxContextHashLock);
         DestroyThreadState(threadState);
     }
 
-    __glvndPthreadFuncs.mutex_lock(&currentThreadStateListMutex);
+    glvndAdaptiveMutexLock(&currentThreadStateListMutex);
     glvnd_list_for_each_entry(threadState, &currentThreadStateList, entry) {
         /*
          * Stub out any references to this display in any other thread states.
@@ -643,7 +739,9 @@ void __glXDisplayClosed(__GLXdisplayInfo *dpyInfo)
             threadState->currentDisplay = NULL;
         }
     }
-    __glvndPthreadFuncs.mutex_unlock(&currentThreadStateListMutex);
+    glvndAdaptiveMutexUnlock(&currentThreadStateListMutex);
+
+    SweepDisplayContexts(dpyInfo->dpy);
 }
 
 static void ThreadDestroyed(__GLdispatchThreadState *threadState)
@@ -651,37 +749,104 @@ static void ThreadDestroyed(__GLdispatchThreadState *threadState)
     __GLXThreadState *glxState = (__GLXThreadState *) threadState;
 
     // Clear out the current context.
-    __glvndPthreadFuncs.mutex_lock(&glxContextHashLock);
     UpdateCurrentContext(NULL, glxState->currentContext);
-    __glvndPthreadFuncs.mutex_unlock(&glxContextHashLock);
 
-    // Free the thread state struct.
-    DestroyThreadState(glxState);
+    // The thread is exiting, so there's no point in caching the struct.
+    FreeThreadState(glxState);
+}
+
+static GLboolean MigrateThreadState(__GLdispatchThreadState *threadState,
+        GLboolean attach)
+{
+    __GLXThreadState *glxState = (__GLXThreadState *) threadState;
+    const __GLXapiImports *imports = glxState->currentVendor->glxvc;
+
+    if (imports->detachCurrent == NULL || imports->attachCurrent == NULL) {
+        return GL_FALSE;
+    }
+    if (attach) {
+        if (!imports->attachCurrent(glxState->vendorState)) {
+            return GL_FALSE;
+        }
+        glxState->vendorState = NULL;
+        return GL_TRUE;
+    } else {
+        return (imports->detachCurrent(&glxState->vendorState) ? GL_TRUE : GL_FALSE);
+    }
+}
+
+static void OnThreadStateCacheDestroyed(void *data)
+{
+    FreeThreadState((__GLXThreadState *) data);
+}
+
+static void OnPushedStatesDestroyed(void *data)
+{
+    __GLXThreadState *threadState = (__GLXThreadState *) data;
+
+    // The thread exited without popping everything it pushed.
+    while (threadState != NULL) {
+        __GLXThreadState *next = threadState->pushedNext;
+        __glDispatchDiscardSuspended(&threadState->glas);
+        UpdateCurrentContext(NULL, threadState->currentContext);
+        FreeThreadState(threadState);
+        threadState = next;
+    }
 }
 
 static __GLXThreadState *CreateThreadState(__GLXvendorInfo *vendor)
 {
-    __GLXThreadState *threadState = calloc(1, sizeof(*threadState));
+    __GLXThreadState *threadState = (__GLXThreadState *)
+        __glvndPthreadFuncs.getspecific(threadStateCacheKey);
 
-    assert(threadState);
+    if (threadState != NULL) {
+        __glvndPthreadFuncs.setspecific(threadStateCacheKey, NULL);
+    } else {
+        threadState = malloc(sizeof(*threadState));
+        if (threadState == NULL) {
+            return NULL;
+        }
+
+        glvndAdaptiveMutexLock(&currentThreadStateListMutex);
+        glvnd_list_add(&threadState->entry, &currentThreadStateList);
+        glvndAdaptiveMutexUnlock(&currentThreadStateListMutex);
+    }
 
+    memset(&threadState->glas, 0, sizeof(threadState->glas));
     threadState->glas.tag = GLDISPATCH_API_GLX;
     threadState->glas.threadDestroyedCallback = ThreadDestroyed;
+    threadState->glas.migrateCallback = MigrateThreadState;
     threadState->currentVendor = vendor;
-
-    __glvndPthreadFuncs.mutex_lock(&currentThreadStateListMutex);
-    glvnd_list_add(&threadState->entry, &currentThreadStateList);
-    __glvndPthreadFuncs.mutex_unlock(&currentThreadStateListMutex);
+    threadState->currentDisplay = NULL;
+    threadState->currentDraw = None;
+    threadState->currentRead = None;
+    threadState->currentContext = NULL;
+    threadState->vendorState = NULL;
+    threadState->pushedNext = NULL;
 
     return threadState;
 }
 
+/**
+ * Releases the calling thread's \c __GLXThreadState after it loses current.
+ *
+ * The struct goes into threadStateCacheKey if that's empty, and is freed
+ * otherwise.
+ */
 static void DestroyThreadState(__GLXThreadState *threadState)
 {
-    // Free the thread state struct.
-    __glvndPthreadFuncs.mutex_lock(&currentThreadStateListMutex);
+    if (__glvndPthreadFuncs.getspecific(threadStateCacheKey) == NULL) {
+        __glvndPthreadFuncs.setspecific(threadStateCacheKey, threadState);
+    } else {
+        FreeThreadState(threadState);
+    }
+}
+
+static void FreeThreadState(__GLXThreadState *threadState)
+{
+    glvndAdaptiveMutexLock(&currentThreadStateListMutex);
     glvnd_list_del(&threadState->entry);
-    __glvndPthreadFuncs.mutex_unlock(&currentThreadStateListMutex);
+    glvndAdaptiveMutexUnlock(&currentThreadStateListMutex);
 
     free(threadState);
 }
@@ -694,43 +859,50 @@ static void DestroyThreadState(__GLXThreadState *threadState)
 void __glXRemoveVendorContextMapping(Display *dpy, GLXContext context)
 {
     __GLXcontextInfo *ctxInfo;
-    __glvndPthreadFuncs.mutex_lock(&glxContextHashLock);
 
-    HASH_FIND_PTR(glxContextHash, &context, ctxInfo);
+    LockContextInfo(context);
+    ctxInfo = (__GLXcontextInfo *) __glvndHashMapFind(&glxContextHash,
+            &context, sizeof(context));
     if (ctxInfo != NULL) {
         ctxInfo->deleted = True;
         CheckContextDeleted(ctxInfo);
     }
-    __glvndPthreadFuncs.mutex_unlock(&glxContextHashLock);
+    UnlockContextInfo(context);
 }
 
 int __glXAddVendorContextMapping(Display *dpy, GLXContext context, __GLXvendorInfo *vendor)
 {
     __GLXcontextInfo *ctxInfo;
+    int ret = 0;
 
-    __glvndPthreadFuncs.mutex_lock(&glxContextHashLock);
+    LockContextInfo(context);
 
-    HASH_FIND_PTR(glxContextHash, &context, ctxInfo);
+    ctxInfo = (__GLXcontextInfo *) __glvndHashMapFind(&glxContextHash,
+            &context, sizeof(context));
     if (ctxInfo == NULL) {
         ctxInfo = (__GLXcontextInfo *) malloc(sizeof(__GLXcontextInfo));
-        if (ctxInfo == NULL) {
-            __glvndPthreadFuncs.mutex_unlock(&glxContextHashLock);
-            return -1;
-        }
-        ctxInfo->context = context;
-        ctxInfo->vendor = vendor;
-        ctxInfo->currentCount = 0;
-        ctxInfo->deleted = False;
-        HASH_ADD_PTR(glxContextHash, context, ctxInfo);
-    } else {
-        if (ctxInfo->vendor != vendor) {
-            __glvndPthreadFuncs.mutex_unlock(&glxContextHashLock);
-            return -1;
+        if (ctxInfo != NULL) {
+            ctxInfo->context = context;
+            ctxInfo->vendor = vendor;
+            ctxInfo->dpy = dpy;
+            ctxInfo->currentCount = 0;
+            ctxInfo->pinCount = 0;
+            ctxInfo->deleted = False;
+            ctxInfo->isDirect = -1;
+            ctxInfo->importedID = None;
+            if (!__glvndHashMapInsert(&glxContextHash, &context, sizeof(context), ctxInfo)) {
+                free(ctxInfo);
+                ret = -1;
+            }
+        } else {
+            ret = -1;
         }
+    } else if (ctxInfo->vendor != vendor) {
+        ret = -1;
     }
 
-    __glvndPthreadFuncs.mutex_unlock(&glxContextHashLock);
-    return 0;
+    UnlockContextInfo(context);
+    return ret;
 }
 
 __GLXvendorInfo *__glXVendorFromContext(GLXContext context)
@@ -738,21 +910,35 @@ __GLXvendorInfo *__glXVendorFromContext(GLXContext context)
     __GLXcontextInfo *ctxInfo;
     __GLXvendorInfo *vendor = NULL;
 
-    __glvndPthreadFuncs.mutex_lock(&glxContextHashLock);
-    HASH_FIND_PTR(glxContextHash, &context, ctxInfo);
+    __glvndHashMapReadBegin();
+    ctxInfo = (__GLXcontextInfo *) __glvndHashMapFind(&glxContextHash,
+            &context, sizeof(context));
     if (ctxInfo != NULL) {
         vendor = ctxInfo->vendor;
     }
-    __glvndPthreadFuncs.mutex_unlock(&glxContextHashLock);
+    __glvndHashMapReadEnd();
 
     return vendor;
 }
 
+static void LockContextInfo(GLXContext context)
+{
+    __glvndHashMapLock(&glxContextHash, &context, sizeof(context));
+}
+
+static void UnlockContextInfo(GLXContext context)
+{
+    __glvndHashMapUnlock(&glxContextHash, &context, sizeof(context));
+}
+
+/**
+ * Removes a context from the hashtable. The structure itself is freed once
+ * no other thread could still be looking at it.
+ */
 static void FreeContextInfo(__GLXcontextInfo *ctx)
 {
     if (ctx != NULL) {
-        HASH_DELETE(hh, glxContextHash, ctx);
-        free(ctx);
+        __glvndHashMapRemove(&glxContextHash, &ctx->context, sizeof(ctx->context));
     }
 }
 
@@ -762,18 +948,39 @@ static void UpdateCurrentContext(__GLXcontextInfo *newCtxInfo, __GLXcontextInfo
         return;
     }
     if (newCtxInfo != NULL) {
+        LockContextInfo(newCtxInfo->context);
         newCtxInfo->currentCount++;
+        UnlockContextInfo(newCtxInfo->context);
     }
     if (oldCtxInfo != NULL) {
+        GLXContext oldContext = oldCtxInfo->context;
+        LockContextInfo(oldContext);
         assert(oldCtxInfo->currentCount > 0);
         oldCtxInfo->currentCount--;
         CheckContextDeleted(oldCtxInfo);
+        UnlockContextInfo(oldContext);
+    }
+}
+
+/**
+ * Releases a reference that CommonMakeCurrent took to a context, and frees the
+ * context if it was deleted in the meantime.
+ */
+static void UnpinContextInfo(__GLXcontextInfo *ctx)
+{
+    if (ctx != NULL) {
+        GLXContext context = ctx->context;
+        LockContextInfo(context);
+        assert(ctx->pinCount > 0);
+        ctx->pinCount--;
+        CheckContextDeleted(ctx);
+        UnlockContextInfo(context);
     }
 }
 
 static void CheckContextDeleted(__GLXcontextInfo *ctx)
 {
-    if (ctx->deleted && ctx->currentCount == 0) {
+    if (ctx->deleted && ctx->currentCount == 0 && ctx->pinCount == 0) {
         FreeContextInfo(ctx);
     }
 }
@@ -825,16 +1032,19 @@ static void NotifyXError(Display *dpy, unsigned char errorCode,
     __glXSendError(dpy, errorCode, resourceID, minorCode, coreX11error);
 }
 
-static Bool InternalLoseCurrent(void)
+static Bool InternalLoseCurrent(uint64_t *vendorNS)
 {
     __GLXThreadState *threadState = __glXGetCurrentThreadState();
+    uint64_t vendorStart;
     Bool ret;
 
     if (threadState == NULL) {
         return True;
     }
 
+    vendorStart = __glDispatchWinsysTimeBegin();
     ret = threadState->currentVendor->staticDispatch.makeCurrent(threadState->currentDisplay, None, NULL);
+    *vendorNS += __glDispatchWinsysTimeSince(vendorStart);
     if (!ret) {
         return False;
     }
@@ -860,17 +1070,21 @@ static Bool InternalLoseCurrent(void)
  *
  * If it fails, then it will leave \p threadState unmodified. It's up to the
  * vendor library to ensure that the old context is still current in that case.
+ *
+ * The time spent in the vendor library is added to \p vendorNS.
  */
 static Bool InternalMakeCurrentVendor(
         Display *dpy, GLXDrawable draw, GLXDrawable read,
         __GLXcontextInfo *ctxInfo, char callerOpcode,
         __GLXThreadState *threadState,
-        __GLXvendorInfo *vendor)
+        __GLXvendorInfo *vendor, uint64_t *vendorNS)
 {
+    uint64_t vendorStart;
     Bool ret;
 
     assert(threadState->currentVendor == vendor);
 
+    vendorStart = __glDispatchWinsysTimeBegin();
     if (callerOpcode == X_GLXMakeCurrent && draw == read) {
         ret = vendor->staticDispatch.makeCurrent(dpy, draw, ctxInfo->context);
     } else {
@@ -879,12 +1093,14 @@ static Bool InternalMakeCurrentVendor(
                                                     read,
                                                     ctxInfo->context);
     }
+    *vendorNS += __glDispatchWinsysTimeSince(vendorStart);
 
     if (ret) {
         threadState->currentDisplay = dpy;
         threadState->currentDraw = draw;
         threadState->currentRead = read;
         threadState->currentContext = ctxInfo;
+        __glDispatchSetCurrentInfo(dpy, ctxInfo->context);
     }
 
     return ret;
@@ -903,7 +1119,7 @@ static Bool InternalMakeCurrentVendor(
 static Bool InternalMakeCurrentDispatch(
         Display *dpy, GLXDrawable draw, GLXDrawable read,
         __GLXcontextInfo *ctxInfo, char callerOpcode,
-        __GLXvendorInfo *vendor)
+        __GLXvendorInfo *vendor, uint64_t *vendorNS)
 {
     __GLXThreadState *threadState;
     Bool ret;
@@ -928,7 +1144,7 @@ static Bool InternalMakeCurrentDispatch(
     if (ret) {
         // Call into the vendor library.
         ret = InternalMakeCurrentVendor(dpy, draw, read, ctxInfo, callerOpcode,
-                threadState, vendor);
+                threadState, vendor, vendorNS);
         if (!ret) {
             __glDispatchLoseCurrent();
         }
@@ -944,10 +1160,12 @@ static Bool InternalMakeCurrentDispatch(
 
 /**
  * A common function to handle glXMakeCurrent and glXMakeContextCurrent.
+ *
+ * The time spent in the vendor libraries is added to \p vendorNS.
  */
-static Bool CommonMakeCurrent(Display *dpy, GLXDrawable draw,
+static Bool CommonMakeCurrentInternal(Display *dpy, GLXDrawable draw,
                                   GLXDrawable read, GLXContext context,
-                                  char callerOpcode)
+                                  char callerOpcode, uint64_t *vendorNS)
 {
     __GLXThreadState *threadState;
     __GLXvendorInfo *oldVendor, *newVendor;
@@ -977,7 +1195,7 @@ static Bool CommonMakeCurrent(Display *dpy, GLXDrawable draw,
         }
     } else {
         // We might have a non-GLX context current...
-        __GLdispatchThreadState *glas = __glDispatchGetCurrentThreadState();
+        __GLdispatchThreadState *glas = __glDispatchGetCurrentThreadStateInline();
         if (glas != NULL && glas->tag != GLDISPATCH_API_GLX) {
             NotifyXError(dpy, BadAccess, 0, callerOpcode, True, NULL);
             return False;
@@ -1014,20 +1232,28 @@ static Bool CommonMakeCurrent(Display *dpy, GLXDrawable draw,
         return True;
     }
 
-    __glvndPthreadFuncs.mutex_lock(&glxContextHashLock);
-
     if (context != NULL) {
         // Look up the new display. This will ensure that we keep track of it
         // and get a callback when it's closed.
         if (__glXLookupDisplay(dpy) == NULL) {
-            __glvndPthreadFuncs.mutex_unlock(&glxContextHashLock);
             return False;
         }
 
-        HASH_FIND_PTR(glxContextHash, &context, newCtxInfo);
-        if (newCtxInfo == NULL) {
-            __glvndPthreadFuncs.mutex_unlock(&glxContextHashLock);
+        /*
+         * Look up the new context, and pin it so that it stays valid even if
+         * another thread deletes it while we're calling into the vendor
+         * library. The rest of this function runs without holding the
+         * context's lock.
+         */
+        LockContextInfo(context);
+        newCtxInfo = (__GLXcontextInfo *) __glvndHashMapFind(&glxContextHash,
+                &context, sizeof(context));
+        if (newCtxInfo != NULL) {
+            newCtxInfo->pinCount++;
+        }
+        UnlockContextInfo(context);
 
+        if (newCtxInfo == NULL) {
             /*
              * We can run into this corner case if a GLX client calls
              * glXDestroyContext() on a current context, loses current to this
@@ -1055,7 +1281,7 @@ static Bool CommonMakeCurrent(Display *dpy, GLXDrawable draw,
          * switch contexts, but don't call into libGLdispatch.
          */
         ret = InternalMakeCurrentVendor(dpy, draw, read, newCtxInfo, callerOpcode,
-                threadState, newVendor);
+                threadState, newVendor, vendorNS);
         if (ret) {
             UpdateCurrentContext(newCtxInfo, oldCtxInfo);
         }
@@ -1064,7 +1290,7 @@ static Bool CommonMakeCurrent(Display *dpy, GLXDrawable draw,
          * We have a current context and we're releasing it.
          */
         assert(context == NULL);
-        ret = InternalLoseCurrent();
+        ret = InternalLoseCurrent(vendorNS);
 
     } else if (oldVendor == NULL) {
         /*
@@ -1072,7 +1298,7 @@ static Bool CommonMakeCurrent(Display *dpy, GLXDrawable draw,
          * current.
          */
         ret = InternalMakeCurrentDispatch(dpy, draw, read, newCtxInfo, callerOpcode,
-                newVendor);
+                newVendor, vendorNS);
     } else {
         /*
          * We're switching between contexts with different vendors.
@@ -1087,16 +1313,23 @@ static Bool CommonMakeCurrent(Display *dpy, GLXDrawable draw,
          */
 
         // First, check to see if calling InternalLoseCurrent is going to
-        // destroy the old context.
+        // destroy the old context. Either way, pin the old context so that
+        // we can still safely look at it after releasing it.
         Bool canRestoreOldContext = True;
+        uint64_t slowOpStart;
+        LockContextInfo(oldCtxInfo->context);
         if (oldCtxInfo->deleted && oldCtxInfo->currentCount == 1) {
             canRestoreOldContext = False;
         }
-        ret = InternalLoseCurrent();
+        oldCtxInfo->pinCount++;
+        UnlockContextInfo(oldCtxInfo->context);
+
+        slowOpStart = __glDispatchSlowOpBegin();
+        ret = InternalLoseCurrent(vendorNS);
 
         if (ret) {
             ret = InternalMakeCurrentDispatch(dpy, draw, read, newCtxInfo, callerOpcode,
-                    newVendor);
+                    newVendor, vendorNS);
             if (!ret && canRestoreOldContext) {
                 /*
                  * Try to restore the old context. Note that this can fail if
@@ -1105,12 +1338,31 @@ static Bool CommonMakeCurrent(Display *dpy, GLXDrawable draw,
                  * should at least still be in a consistent state.
                  */
                 InternalMakeCurrentDispatch(oldDpy, oldDraw, oldRead, oldCtxInfo,
-                        callerOpcode, oldVendor);
+                        callerOpcode, oldVendor, vendorNS);
             }
         }
+        __glDispatchSlowOpEnd(slowOpStart, "MakeCurrent (vendor switch)",
+                newVendor->name, newVendor->vendorID);
+        UnpinContextInfo(oldCtxInfo);
     }
 
-    __glvndPthreadFuncs.mutex_unlock(&glxContextHashLock);
+    UnpinContextInfo(newCtxInfo);
+    return ret;
+}
+
+static Bool CommonMakeCurrent(Display *dpy, GLXDrawable draw,
+                                  GLXDrawable read, GLXContext context,
+                                  char callerOpcode)
+{
+    uint64_t start = __glDispatchWinsysTimeBegin();
+    uint64_t vendorNS = 0;
+    Bool ret;
+
+    ret = CommonMakeCurrentInternal(dpy, draw, read, context, callerOpcode,
+            &vendorNS);
+    __glDispatchWinsysTimeEnd((callerOpcode == X_GLXMakeContextCurrent
+                ? GLDISPATCH_WINSYS_GLX_MAKE_CONTEXT_CURRENT
+                : GLDISPATCH_WINSYS_GLX_MAKE_CURRENT), start, vendorNS);
     return ret;
 }
 
@@ -1125,16 +1377,148 @@ PUBLIC Bool glXMakeContextCurrent(Display *dpy, GLXDrawable draw,
     return CommonMakeCurrent(dpy, draw, read, context, X_GLXMakeContextCurrent);
 }
 
+/*
+ * Takes the vendor's context off of the calling thread for
+ * glXPushCurrentGLVND. If the vendor can detach its current state, then that
+ * saves a full release and make current in the vendor library.
+ */
+static Bool SuspendVendorCurrent(__GLXThreadState *threadState)
+{
+    __GLXvendorInfo *vendor = threadState->currentVendor;
+
+    if (vendor->glxvc->detachCurrent != NULL && vendor->glxvc->attachCurrent != NULL) {
+        return vendor->glxvc->detachCurrent(&threadState->vendorState);
+    }
+    return vendor->staticDispatch.makeCurrent(threadState->currentDisplay, None, NULL);
+}
+
+/*
+ * Undoes SuspendVendorCurrent.
+ */
+static Bool ResumeVendorCurrent(__GLXThreadState *threadState)
+{
+    __GLXvendorInfo *vendor = threadState->currentVendor;
+
+    if (vendor->glxvc->detachCurrent != NULL && vendor->glxvc->attachCurrent != NULL) {
+        if (!vendor->glxvc->attachCurrent(threadState->vendorState)) {
+            return False;
+        }
+        threadState->vendorState = NULL;
+        return True;
+    }
+    if (threadState->currentDraw == threadState->currentRead) {
+        return vendor->staticDispatch.makeCurrent(threadState->currentDisplay,
+                threadState->currentDraw, threadState->currentContext->context);
+    } else {
+        return vendor->staticDispatch.makeContextCurrent(threadState->currentDisplay,
+                threadState->currentDraw, threadState->currentRead,
+                threadState->currentContext->context);
+    }
+}
+
+PUBLIC int glXPushCurrentGLVND(void)
+{
+    __GLdispatchThreadState *glas;
+    __GLXThreadState *threadState;
+
+    __glXThreadInitialize();
+
+    glas = __glDispatchGetCurrentThreadStateInline();
+    if (glas != NULL && glas->tag != GLDISPATCH_API_GLX) {
+        return 0;
+    }
+
+    if (glas != NULL) {
+        // The context stays in the current context map while it's pushed, so
+        // glXDestroyContext won't free it before it's popped.
+        threadState = (__GLXThreadState *) glas;
+        if (!SuspendVendorCurrent(threadState)) {
+            return 0;
+        }
+        __glDispatchSuspendCurrent();
+    } else {
+        // Push an empty entry, so that the pop knows to leave the thread with
+        // no current context.
+        threadState = CreateThreadState(NULL);
+        if (threadState == NULL) {
+            return 0;
+        }
+    }
+
+    threadState->pushedNext = (__GLXThreadState *)
+        __glvndPthreadFuncs.getspecific(pushedStateKey);
+    __glvndPthreadFuncs.setspecific(pushedStateKey, threadState);
+    return 1;
+}
+
+PUBLIC int glXPopCurrentGLVND(void)
+{
+    __GLdispatchThreadState *glas;
+    __GLXThreadState *threadState;
+    uint64_t vendorNS = 0;
+
+    __glXThreadInitialize();
+
+    threadState = (__GLXThreadState *) __glvndPthreadFuncs.getspecific(pushedStateKey);
+    if (threadState == NULL) {
+        return 0;
+    }
+
+    glas = __glDispatchGetCurrentThreadStateInline();
+    if (glas != NULL && glas->tag != GLDISPATCH_API_GLX) {
+        return 0;
+    }
+    if (!InternalLoseCurrent(&vendorNS)) {
+        return 0;
+    }
+
+    __glvndPthreadFuncs.setspecific(pushedStateKey, threadState->pushedNext);
+    threadState->pushedNext = NULL;
+
+    if (threadState->currentContext == NULL) {
+        DestroyThreadState(threadState);
+        return 1;
+    }
+
+    if (!ResumeVendorCurrent(threadState)) {
+        __glDispatchDiscardSuspended(&threadState->glas);
+        UpdateCurrentContext(NULL, threadState->currentContext);
+        DestroyThreadState(threadState);
+        return 0;
+    }
+
+    if (!__glDispatchResumeCurrent(&threadState->glas)) {
+        threadState->currentVendor->staticDispatch.makeCurrent(
+                threadState->currentDisplay, None, NULL);
+        UpdateCurrentContext(NULL, threadState->currentContext);
+        DestroyThreadState(threadState);
+        return 0;
+    }
+
+    return 1;
+}
+
 PUBLIC Bool glXQueryExtension(Display *dpy, int *error_base, int *event_base)
 {
     __glXThreadInitialize();
 
     /*
      * There isn't enough information to dispatch to a vendor's
-     * implementation, so handle the request here.
+     * implementation, so handle the request here. The answer is recorded
+     * when the display is first looked up, so this doesn't need a round
+     * trip.
      */
+    __GLXdisplayInfo *dpyInfo = __glXLookupDisplay(dpy);
     int major, event, error;
-    Bool ret = XQueryExtension(dpy, "GLX", &major, &event, &error);
+    Bool ret;
+
+    if (dpyInfo != NULL) {
+        ret = dpyInfo->glxSupported;
+        event = dpyInfo->glxFirstEvent;
+        error = dpyInfo->glxFirstError;
+    } else {
+        ret = XQueryExtension(dpy, "GLX", &major, &event, &error);
+    }
     if (ret) {
         if (error_base) {
             *error_base = error;
@@ -1153,50 +1537,28 @@ PUBLIC Bool glXQueryVersion(Display *dpy, int *major, int *minor)
 
     /*
      * There isn't enough information to dispatch to a vendor's
-     * implementation, so handle the request here.
-     *
-     * Adapted from mesa's
-     *
-     * gallium/state_trackers/egl/x11/glxinit.c:QueryVersion()
-     *
-     * TODO: Mesa's GLX state tracker uses xcb-glx rather than Xlib to perform
-     * the query. Should we do the same here?
+     * implementation, so handle the request here. The server's version is
+     * only queried once per display, so this usually doesn't need a round
+     * trip.
      */
-    xGLXQueryVersionReq *req;
-    xGLXQueryVersionReply reply;
     __GLXdisplayInfo *dpyInfo = NULL;
-    Bool ret;
 
     dpyInfo = __glXLookupDisplay(dpy);
     if (dpyInfo == NULL || !dpyInfo->glxSupported) {
         return False;
     }
 
-    LockDisplay(dpy);
-    GetReq(GLXQueryVersion, req);
-    req->reqType = dpyInfo->glxMajorOpcode;
-    req->glxCode = X_GLXQueryVersion;
-    req->majorVersion = GLX_MAJOR_VERSION;
-    req->minorVersion = GLX_MINOR_VERSION;
-
-    ret = _XReply(dpy, (xReply *)&reply, 0, False);
-    UnlockDisplay(dpy);
-    SyncHandle();
-
-    if (!ret) {
-        return False;
-    }
-
-    if (reply.majorVersion != GLX_MAJOR_VERSION) {
-        /* Server does not support same major as client */
+    __glXQueryServerInfo(dpyInfo);
+    if (dpyInfo->glxMajorVersion != GLX_MAJOR_VERSION) {
+        /* Server does not support same major as client, or the query failed */
         return False;
     }
 
     if (major) {
-        *major = reply.majorVersion;
+        *major = dpyInfo->glxMajorVersion;
     }
     if (minor) {
-        *minor = reply.minorVersion;
+        *minor = dpyInfo->glxMinorVersion;
     }
 
     return True;
@@ -1205,11 +1567,20 @@ PUBLIC Bool glXQueryVersion(Display *dpy, int *major, int *minor)
 
 PUBLIC void glXSwapBuffers(Display *dpy, GLXDrawable drawable)
 {
-    __GLXvendorInfo *vendor = CommonDispatchDrawable(dpy, drawable,
+    uint64_t start = __glDispatchWinsysTimeBegin();
+    uint64_t vendorNS = 0;
+    __GLXvendorInfo *vendor;
+
+    GLDISPATCH_TRACE(2, GLDISPATCH_TRACE_SWAP, GLDISPATCH_API_GLX, drawable);
+    vendor = CommonDispatchDrawable(dpy, drawable,
             X_GLXSwapBuffers, GLXBadDrawable, False);
     if (vendor != NULL) {
+        uint64_t vendorStart = __glDispatchWinsysTimeBegin();
         vendor->staticDispatch.swapBuffers(dpy, drawable);
+        vendorNS = __glDispatchWinsysTimeSince(vendorStart);
     }
+    __glDispatchWinsysTimeEnd(GLDISPATCH_WINSYS_GLX_SWAP_BUFFERS, start,
+            vendorNS);
 }
 
 
@@ -1252,14 +1623,24 @@ PUBLIC void glXWaitX(void)
 static const char **GetVendorClientStrings(Display *dpy, int name)
 {
     int num_screens = XScreenCount(dpy);
-    const char **result = malloc(num_screens * sizeof(const char *));
+    const char **result;
+    __GLXvendorInfo **vendors;
     int screen;
+
+    // Allocate the vendor and string arrays together.
+    result = malloc(num_screens * (sizeof(const char *) + sizeof(__GLXvendorInfo *)));
     if (result == NULL) {
         return NULL;
     }
+    vendors = (__GLXvendorInfo **) (result + num_screens);
+
+    if (__glXLookupVendorsForAllScreens(dpy, vendors) != 0) {
+        free(result);
+        return NULL;
+    }
 
     for (screen = 0; screen < num_screens; screen++) {
-        __GLXvendorInfo *vendor = __glXLookupVendorByScreen(dpy, screen);
+        __GLXvendorInfo *vendor = vendors[screen];
         if (vendor != NULL) {
             result[screen] = vendor->staticDispatch.getClientString(dpy, name);
         } else {
@@ -1389,6 +1770,7 @@ PUBLIC const char *glXGetClientString(Display *dpy, int name)
     int screen;
     int index = name - 1;
     const char **vendorStrings = NULL;
+    char *merged;
 
     if (dpy == NULL) {
         return GetClientStringNoVendor(name);
@@ -1416,9 +1798,18 @@ PUBLIC const char *glXGetClientString(Display *dpy, int name)
         return NULL;
     }
 
-    __glvndPthreadFuncs.mutex_lock(&clientStringLock);
+    // Once the merged string is published, it never changes, so repeat calls
+    // don't need the lock.
+    merged = (char *) glvndAtomicLoadAcquirePtr(
+            (void * volatile *) &dpyInfo->clientStrings[index]);
+    if (merged != NULL) {
+        return merged;
+    }
+
+    glvndProfiledMutexLock(&clientStringLock, &clientStringLockStats);
 
-    if (dpyInfo->clientStrings[index] != NULL) {
+    merged = dpyInfo->clientStrings[index];
+    if (merged != NULL) {
         goto done;
     }
 
@@ -1427,38 +1818,37 @@ PUBLIC const char *glXGetClientString(Display *dpy, int name)
         goto done;
     }
 
-    dpyInfo->clientStrings[index] = strdup(vendorStrings[0]);
-    if (dpyInfo->clientStrings[index] == NULL) {
-        goto done;
-    }
-    for (screen = 1; screen < num_screens; screen++) {
+    merged = strdup(vendorStrings[0]);
+    for (screen = 1; screen < num_screens && merged != NULL; screen++) {
         if (name == GLX_VENDOR) {
             char *newBuf;
-            if (glvnd_asprintf(&newBuf, "%s, %s", dpyInfo->clientStrings[index], vendorStrings[screen]) < 0) {
+            if (glvnd_asprintf(&newBuf, "%s, %s", merged, vendorStrings[screen]) < 0) {
                 newBuf = NULL;
             }
-            free(dpyInfo->clientStrings[index]);
-            dpyInfo->clientStrings[index] = newBuf;
+            free(merged);
+            merged = newBuf;
         } else if (name == GLX_VERSION) {
-            dpyInfo->clientStrings[index] = MergeVersionStrings(dpyInfo->clientStrings[index], vendorStrings[screen]);
+            merged = MergeVersionStrings(merged, vendorStrings[screen]);
         } else if (name == GLX_EXTENSIONS) {
-            dpyInfo->clientStrings[index] = UnionExtensionStrings(dpyInfo->clientStrings[index], vendorStrings[screen]);
+            merged = UnionExtensionStrings(merged, vendorStrings[screen]);
         } else {
             assert(!"Can't happen: Invalid string name");
-            free(dpyInfo->clientStrings[index]);
-            dpyInfo->clientStrings[index] = NULL;
-        }
-        if (dpyInfo->clientStrings[index] == NULL) {
-            goto done;
+            free(merged);
+            merged = NULL;
         }
     }
 
+    if (merged != NULL) {
+        glvndMemStatsAlloc(GLVND_MEM_CLIENT_STRING, strlen(merged) + 1);
+        glvndAtomicStoreReleasePtr((void * volatile *) &dpyInfo->clientStrings[index], merged);
+    }
+
 done:
     __glvndPthreadFuncs.mutex_unlock(&clientStringLock);
     if (vendorStrings != NULL) {
         free(vendorStrings);
     }
-    return dpyInfo->clientStrings[index];
+    return merged;
 }
 
 PUBLIC const char *glXQueryServerString(Display *dpy, int screen, int name)
@@ -1482,33 +1872,58 @@ PUBLIC const char *glXQueryExtensionsString(Display *dpy, int screen)
     }
 }
 
-PUBLIC GLXFBConfig *glXChooseFBConfig(Display *dpy, int screen,
-                                      const int *attrib_list, int *nelements)
+/**
+ * Common function for glXChooseFBConfig and glXGetFBConfigs.
+ *
+ * If the vendor allows it, this checks the display's config cache first, and
+ * caches whatever the vendor returns. The configs in a cached result have
+ * already been added to the config table, so a hit doesn't add them again.
+ */
+static GLXFBConfig *CommonGetFBConfigs(Display *dpy, int screen, Bool choose,
+                                       const int *attrib_list, int *nelements)
 {
     __GLXvendorInfo *vendor = __glXGetDynDispatch(dpy, screen);
-    if (vendor != NULL) {
-        GLXFBConfig *fbconfigs =
-            vendor->staticDispatch.chooseFBConfig(dpy, screen, attrib_list, nelements);
+    GLXFBConfig *fbconfigs;
+    unsigned int generation = 0;
+    Bool cacheable = False;
 
+    if (vendor == NULL) {
+        return NULL;
+    }
+
+    if (vendor->glxvc->isFBConfigCacheable != NULL
+            && vendor->glxvc->isFBConfigCacheable(dpy, screen)) {
+        fbconfigs = __glXLookupCachedFBConfigs(dpy, screen, choose,
+                attrib_list, nelements, &generation);
         if (fbconfigs != NULL) {
-            int i;
-            Bool success = True;
-            for (i = 0; i < *nelements; i++) {
-                if (__glXAddVendorFBConfigMapping(dpy, fbconfigs[i], vendor) != 0) {
-                    success = False;
-                    break;
-                }
-            }
-            if (!success) {
-                XFree(fbconfigs);
-                fbconfigs = NULL;
-                *nelements = 0;
-            }
+            return fbconfigs;
         }
-        return fbconfigs;
+        cacheable = True;
+    }
+
+    if (choose) {
+        fbconfigs = vendor->staticDispatch.chooseFBConfig(dpy, screen, attrib_list, nelements);
     } else {
-        return NULL;
+        fbconfigs = vendor->staticDispatch.getFBConfigs(dpy, screen, nelements);
+    }
+
+    if (fbconfigs != NULL) {
+        if (__glXAddVendorFBConfigMappings(dpy, fbconfigs, *nelements, vendor) != 0) {
+            XFree(fbconfigs);
+            fbconfigs = NULL;
+            *nelements = 0;
+        } else if (cacheable) {
+            __glXAddCachedFBConfigs(dpy, screen, choose, attrib_list,
+                    fbconfigs, *nelements, generation);
+        }
     }
+    return fbconfigs;
+}
+
+PUBLIC GLXFBConfig *glXChooseFBConfig(Display *dpy, int screen,
+                                      const int *attrib_list, int *nelements)
+{
+    return CommonGetFBConfigs(dpy, screen, True, attrib_list, nelements);
 }
 
 
@@ -1606,28 +2021,7 @@ PUBLIC int glXGetFBConfigAttrib(Display *dpy, GLXFBConfig config,
 
 PUBLIC GLXFBConfig *glXGetFBConfigs(Display *dpy, int screen, int *nelements)
 {
-    __GLXvendorInfo *vendor = __glXGetDynDispatch(dpy, screen);
-    if (vendor != NULL) {
-        GLXFBConfig *fbconfigs = vendor->staticDispatch.getFBConfigs(dpy, screen, nelements);
-        if (fbconfigs != NULL) {
-            int i;
-            Bool success = True;
-            for (i = 0; i < *nelements; i++) {
-                if (__glXAddVendorFBConfigMapping(dpy, fbconfigs[i], vendor) != 0) {
-                    success = False;
-                    break;
-                }
-            }
-            if (!success) {
-                XFree(fbconfigs);
-                fbconfigs = NULL;
-                *nelements = 0;
-            }
-        }
-        return fbconfigs;
-    } else {
-        return NULL;
-    }
+    return CommonGetFBConfigs(dpy, screen, False, NULL, nelements);
 }
 
 
@@ -1685,6 +2079,10 @@ PUBLIC void glXSelectEvent(Display *dpy, GLXDrawable draw, unsigned long event_m
     }
 }
 
+/*
+ * Note that this list must be sorted by name (using strcmp), because
+ * glXGetProcAddress does a binary search on it.
+ */
 const __GLXlocalDispatchFunction LOCAL_GLX_DISPATCH_FUNCTIONS[] =
 {
 #define LOCAL_FUNC_TABLE_ENTRY(func) \
@@ -1693,6 +2091,7 @@ const __GLXlocalDispatchFunction LOCAL_GLX_DISPATCH_FUNCTIONS[] =
         LOCAL_FUNC_TABLE_ENTRY(glXChooseVisual)
         LOCAL_FUNC_TABLE_ENTRY(glXCopyContext)
         LOCAL_FUNC_TABLE_ENTRY(glXCreateContext)
+        LOCAL_FUNC_TABLE_ENTRY(glXCreateContextAttribsARB)
         LOCAL_FUNC_TABLE_ENTRY(glXCreateGLXPixmap)
         LOCAL_FUNC_TABLE_ENTRY(glXCreateNewContext)
         LOCAL_FUNC_TABLE_ENTRY(glXCreatePbuffer)
@@ -1703,6 +2102,7 @@ const __GLXlocalDispatchFunction LOCAL_GLX_DISPATCH_FUNCTIONS[] =
         LOCAL_FUNC_TABLE_ENTRY(glXDestroyPbuffer)
         LOCAL_FUNC_TABLE_ENTRY(glXDestroyPixmap)
         LOCAL_FUNC_TABLE_ENTRY(glXDestroyWindow)
+        LOCAL_FUNC_TABLE_ENTRY(glXFreeContextEXT)
         LOCAL_FUNC_TABLE_ENTRY(glXGetClientString)
         LOCAL_FUNC_TABLE_ENTRY(glXGetConfig)
         LOCAL_FUNC_TABLE_ENTRY(glXGetCurrentContext)
@@ -1715,6 +2115,7 @@ const __GLXlocalDispatchFunction LOCAL_GLX_DISPATCH_FUNCTIONS[] =
         LOCAL_FUNC_TABLE_ENTRY(glXGetProcAddressARB)
         LOCAL_FUNC_TABLE_ENTRY(glXGetSelectedEvent)
         LOCAL_FUNC_TABLE_ENTRY(glXGetVisualFromFBConfig)
+        LOCAL_FUNC_TABLE_ENTRY(glXImportContextEXT)
         LOCAL_FUNC_TABLE_ENTRY(glXIsDirect)
         LOCAL_FUNC_TABLE_ENTRY(glXMakeContextCurrent)
         LOCAL_FUNC_TABLE_ENTRY(glXMakeCurrent)
@@ -1729,68 +2130,33 @@ const __GLXlocalDispatchFunction LOCAL_GLX_DISPATCH_FUNCTIONS[] =
         LOCAL_FUNC_TABLE_ENTRY(glXUseXFont)
         LOCAL_FUNC_TABLE_ENTRY(glXWaitGL)
         LOCAL_FUNC_TABLE_ENTRY(glXWaitX)
-
-        LOCAL_FUNC_TABLE_ENTRY(glXImportContextEXT)
-        LOCAL_FUNC_TABLE_ENTRY(glXFreeContextEXT)
-        LOCAL_FUNC_TABLE_ENTRY(glXCreateContextAttribsARB)
 #undef LOCAL_FUNC_TABLE_ENTRY
     { NULL, NULL }
 };
 
-typedef struct {
-    GLubyte *procName;
-    __GLXextFuncPtr addr;
-    UT_hash_handle hh;
-} __GLXprocAddressHash;
-
-static DEFINE_INITIALIZED_LKDHASH(__GLXprocAddressHash, __glXProcAddressHash);
-
-/*
- * This function is called externally by the libGL wrapper library to
- * retrieve libGLX entrypoints.
- */
-static __GLXextFuncPtr __glXGetCachedProcAddress(const GLubyte *procName)
+static int CompareLocalDispatchFunction(const void *key, const void *elem)
 {
-    /*
-     * If this is the first time GetProcAddress has been called,
-     * initialize the hash table with locally-exported functions.
-     */
-    __GLXprocAddressHash *pEntry = NULL;
-
-    LKDHASH_RDLOCK(__glXProcAddressHash);
-    HASH_FIND(hh, _LH(__glXProcAddressHash), procName,
-              strlen((const char *)procName), pEntry);
-    LKDHASH_UNLOCK(__glXProcAddressHash);
-
-    if (pEntry) {
-        return pEntry->addr;
-    }
-
-    return NULL;
+    return strcmp((const char *) key,
+            ((const __GLXlocalDispatchFunction *) elem)->name);
 }
 
-static void cacheProcAddress(const GLubyte *procName, __GLXextFuncPtr addr)
+/*!
+ * Looks up a function that libGLX itself implements. This doesn't need any
+ * locking, since LOCAL_GLX_DISPATCH_FUNCTIONS never changes.
+ */
+static __GLXextFuncPtr LookupLocalDispatchFunction(const GLubyte *procName)
 {
-    size_t nameLen = strlen((const char *) procName);
-    __GLXprocAddressHash *pEntry;
+    const __GLXlocalDispatchFunction *func = bsearch(procName,
+            LOCAL_GLX_DISPATCH_FUNCTIONS,
+            ARRAY_LEN(LOCAL_GLX_DISPATCH_FUNCTIONS) - 1,
+            sizeof(LOCAL_GLX_DISPATCH_FUNCTIONS[0]),
+            CompareLocalDispatchFunction);
 
-    LKDHASH_WRLOCK(__glXProcAddressHash);
-
-    HASH_FIND(hh, _LH(__glXProcAddressHash), procName,
-              nameLen, pEntry);
-    if (pEntry == NULL) {
-        pEntry = malloc(sizeof(*pEntry) + nameLen + 1);
-        if (pEntry != NULL) {
-            pEntry->procName = (GLubyte *) (pEntry + 1);
-            memcpy(pEntry->procName, procName, nameLen + 1);
-            pEntry->addr = addr;
-            HASH_ADD_KEYPTR(hh, _LH(__glXProcAddressHash), pEntry->procName,
-                            nameLen, pEntry);
-        }
+    if (func != NULL) {
+        return func->addr;
     } else {
-        assert(pEntry->addr == addr);
+        return NULL;
     }
-    LKDHASH_UNLOCK(__glXProcAddressHash);
 }
 
 PUBLIC __GLXextFuncPtr glXGetProcAddressARB(const GLubyte *procName)
@@ -1805,13 +2171,17 @@ PUBLIC __GLXextFuncPtr glXGetProcAddress(const GLubyte *procName)
     __GLXextFuncPtr addr = NULL;
 
     __glXThreadInitialize();
+    GLDISPATCH_TRACE_PROC(2, GLDISPATCH_API_GLX, procName);
 
     /*
-     * Easy case: First check if we already know this address from
-     * a previous GetProcAddress() call or by virtue of being a function
-     * exported by libGLX.
+     * Easy case: First check if this is a function exported by libGLX, or if
+     * we already know this address from a previous GetProcAddress() call.
      */
-    addr = __glXGetCachedProcAddress(procName);
+    addr = LookupLocalDispatchFunction(procName);
+    if (addr) {
+        return addr;
+    }
+    addr = (__GLXextFuncPtr) __glvndProcAddressCacheLookup((const char *) procName);
     if (addr) {
         return addr;
     }
@@ -1825,138 +2195,106 @@ PUBLIC __GLXextFuncPtr glXGetProcAddress(const GLubyte *procName)
 
     /* Store the resulting proc address. */
     if (addr) {
-        cacheProcAddress(procName, addr);
+        __glvndProcAddressCacheAdd((const char *) procName, (void *) addr);
     }
 
     return addr;
 }
 
-PUBLIC __GLXextFuncPtr __glXGLLoadGLXFunction(const char *name,
-        __GLXextFuncPtr *ptr, glvnd_mutex_t *mutex)
+PUBLIC int glXGetProcAddressesGLVND(const char * const *procNames,
+        GLVNDproc *procs, int count)
 {
-    __GLXextFuncPtr func;
+    const char **glNames;
+    __GLdispatchProc *glProcs;
+    int *glIndices;
+    int numGL = 0;
+    int numFound = 0;
+    int i;
 
-    __glvndPthreadFuncs.mutex_lock(mutex);
+    __glXThreadInitialize();
 
-    func = *ptr;
-    if (func == NULL) {
-        func = glXGetProcAddress((const GLubyte *) name);
-        *ptr = func;
+    if (count <= 0) {
+        return 0;
     }
 
-    __glvndPthreadFuncs.mutex_unlock(mutex);
-    return func;
-}
-
-int AtomicIncrement(int volatile *val)
-{
-#if defined(HAVE_SYNC_INTRINSICS)
-    return __sync_add_and_fetch(val, 1);
-#elif defined(USE_X86_ASM) || defined(USE_X86_64_ASM)
-    int result;
-    int delta = 1;
-
-    __asm __volatile__ ("lock; xaddl %0, %1"
-                        : "=r" (result), "=m" (*val)
-                        : "0" (delta), "m" (*val));
-
-    return result + delta;
-#else
-#error "Not implemented"
-#endif
-}
-
-int AtomicSwap(int volatile *val, int newVal)
-{
-#if defined(HAVE_SYNC_INTRINSICS)
-    return __sync_lock_test_and_set(val, newVal);
-#elif defined(USE_X86_ASM) || defined(USE_X86_64_ASM)
-    int result;
-
-    __asm __volatile__ ("xchgl %0, %1"
-                        : "=r" (result), "=m" (*val)
-                        : "0" (newVal), "m" (*val));
-
-    return result;
-#else
-#error "Not implemented"
-#endif
-}
-
-int AtomicCompareAndSwap(int volatile *val, int oldVal, int newVal)
-{
-#if defined(HAVE_SYNC_INTRINSICS)
-    return __sync_val_compare_and_swap(val, oldVal, newVal);
-#elif defined(USE_X86_ASM) || defined(USE_X86_64_ASM)
-    int result;
-
-    __asm __volatile__ ("lock; cmpxchgl %2, %1"
-                        : "=a" (result), "=m" (*val)
-                        : "r" (newVal), "m" (*val), "0" (oldVal));
-
-    return result;
-#else
-#error "Not implemented"
-#endif
-}
+    glNames = malloc(count * (sizeof(const char *)
+                + sizeof(__GLdispatchProc) + sizeof(int)));
+    if (glNames == NULL) {
+        for (i=0; i<count; i++) {
+            procs[i] = glXGetProcAddress((const GLubyte *) procNames[i]);
+            if (procs[i] != NULL) {
+                numFound++;
+            }
+        }
+        return numFound;
+    }
+    glProcs = (__GLdispatchProc *) (glNames + count);
+    glIndices = (int *) (glProcs + count);
 
-int AtomicDecrementClampAtZero(int volatile *val)
-{
-    int oldVal, newVal;
+    /*
+     * Handle everything that glXGetProcAddress could find without going
+     * through libGLdispatch, and collect the rest so that libGLdispatch can
+     * look them all up with a single lock.
+     */
+    for (i=0; i<count; i++) {
+        const GLubyte *procName = (const GLubyte *) procNames[i];
+        __GLXextFuncPtr addr = LookupLocalDispatchFunction(procName);
 
-    oldVal = *val;
-    newVal = oldVal;
+        if (addr == NULL) {
+            addr = (__GLXextFuncPtr) __glvndProcAddressCacheLookup((const char *) procName);
+        }
+        if (addr == NULL) {
+            if (procName[0] == 'g' && procName[1] == 'l' && procName[2] == 'X') {
+                addr = __glXGetGLXDispatchAddress(procName);
+                if (addr != NULL) {
+                    __glvndProcAddressCacheAdd((const char *) procName, (void *) addr);
+                }
+            } else {
+                glNames[numGL] = procNames[i];
+                glIndices[numGL] = i;
+                numGL++;
+            }
+        }
+        procs[i] = (GLVNDproc) addr;
+    }
 
-    do {
-        if (oldVal <= 0) {
-            assert(oldVal == 0);
-        } else {
-            newVal = oldVal - 1;
-            oldVal = AtomicCompareAndSwap(val, oldVal, newVal);
+    if (numGL > 0) {
+        __glDispatchGetProcAddresses(glNames, glProcs, numGL);
+        for (i=0; i<numGL; i++) {
+            if (glProcs[i] != NULL) {
+                __glvndProcAddressCacheAdd(glNames[i], (void *) glProcs[i]);
+            }
+            procs[glIndices[i]] = (GLVNDproc) glProcs[i];
         }
-    } while ((oldVal > 0) && (newVal != oldVal - 1));
+    }
+    free(glNames);
 
-    return newVal;
+    for (i=0; i<count; i++) {
+        if (procs[i] != NULL) {
+            numFound++;
+        }
+    }
+    return numFound;
 }
 
-static void __glXResetOnFork(void);
-
-/*!
- * Checks to see if a fork occurred since the last GLX entrypoint was called,
- * and performs recovery if needed.
- */
-static void CheckFork(void)
+PUBLIC __GLXextFuncPtr __glXGLLoadGLXFunction(const char *name,
+        __GLXextFuncPtr *ptr, glvnd_mutex_t *mutex)
 {
-    volatile static int g_threadsInCheck = 0;
-    volatile static int g_lastPid = -1;
-
-    int lastPid;
-    int pid = getpid();
-
-    AtomicIncrement(&g_threadsInCheck);
-
-    lastPid = AtomicSwap(&g_lastPid, pid);
-
-    if ((lastPid != -1) &&
-        (lastPid != pid)) {
+    __GLXextFuncPtr func;
 
-        DBG_PRINTF(0, "Fork detected\n");
+    __glvndPthreadFuncs.mutex_lock(mutex);
 
-        __glXResetOnFork();
+    func = *ptr;
+    if (func == NULL) {
+        func = glXGetProcAddress((const GLubyte *) name);
 
-        // Force g_threadsInCheck to 0 to unblock other threads waiting here.
-        g_threadsInCheck = 0;
-    } else {
-        AtomicDecrementClampAtZero(&g_threadsInCheck);
-        while (g_threadsInCheck > 0) {
-            // Wait for other threads to finish checking for a fork.
-            //
-            // If a fork happens while g_threadsInCheck > 0 the _first_ thread
-            // to enter __glXThreadInitialize() will see the fork, handle it, and force
-            // g_threadsInCheck to 0, unblocking any other threads stuck here.
-            sched_yield();
-        }
+        // libGL's stubs check the pointer without taking the mutex, so make
+        // sure that anything the lookup did is visible before the pointer is.
+        glvndAtomicStoreReleasePtr((void * volatile *) ptr, (void *) func);
     }
+
+    __glvndPthreadFuncs.mutex_unlock(mutex);
+    return func;
 }
 
 /*!
@@ -1965,55 +2303,215 @@ static void CheckFork(void)
  */
 void __glXThreadInitialize(void)
 {
-    CheckFork();
+    glvndCheckFork();
     __glDispatchCheckMultithreaded();
 }
 
 static void __glXAPITeardown(Bool doReset)
 {
     __GLXThreadState *threadState, *threadStateTemp;
-    __GLXcontextInfo *currContext, *currContextTemp;
 
+    // This frees the cached thread states, too. After a fork, the calling
+    // thread is the only one left with a cache entry to clear.
+    __glvndPthreadFuncs.setspecific(threadStateCacheKey, NULL);
+    __glvndPthreadFuncs.setspecific(pushedStateKey, NULL);
     glvnd_list_for_each_entry_safe(threadState, threadStateTemp, &currentThreadStateList, entry) {
         glvnd_list_del(&threadState->entry);
         free(threadState);
     }
 
     if (doReset) {
-        /*
-         * XXX: We should be able to get away with just resetting the proc address
-         * hash lock, and not throwing away cached addresses.
-         */
-        __glvndPthreadFuncs.rwlock_init(&__glXProcAddressHash.lock, NULL);
-        __glvndPthreadFuncs.mutex_init(&currentThreadStateListMutex, NULL);
-
-        HASH_ITER(hh, glxContextHash, currContext, currContextTemp) {
+        // The cached proc addresses are still valid in the child, so this
+        // only resets the locks.
+        __glvndProcAddressCacheReset();
+        glvndAdaptiveMutexInit(&currentThreadStateListMutex);
+
+        __GLVNDhashMapIter iter;
+        void *value;
+
+        __glvndHashMapReset(&glxContextHash);
+        __glvndHashMapLockAll(&glxContextHash);
+        __glvndHashMapIterInit(&glxContextHash, &iter);
+        while (__glvndHashMapIterNext(&iter, NULL, &value)) {
+            __GLXcontextInfo *currContext = (__GLXcontextInfo *) value;
             currContext->currentCount = 0;
+            currContext->pinCount = 0;
             CheckContextDeleted(currContext);
         }
+        __glvndHashMapUnlockAll(&glxContextHash);
     } else {
-        LKDHASH_TEARDOWN(__GLXprocAddressHash,
-                         __glXProcAddressHash, NULL, NULL, False);
+        __glvndProcAddressCacheCleanup();
 
         /*
          * It's possible that another thread could be blocked in a
          * glXMakeCurrent call here, especially if an Xlib I/O error occurred.
-         * In that case, the other thead will be holding the context hash lock,
+         * In that case, the other thead could be holding a context hash lock,
          * so we'd deadlock if we tried to wait for it here. Instead, clean up
-         * if the lock is available, but don't try to wait if it isn't.
+         * each context if its lock is available, but don't try to wait if it
+         * isn't.
          */
-        if (__glvndPthreadFuncs.mutex_trylock(&glxContextHashLock) == 0) {
-            HASH_ITER(hh, glxContextHash, currContext, currContextTemp) {
-                FreeContextInfo(currContext);
+        __glvndHashMapTryTeardown(&glxContextHash, NULL, NULL);
+    }
+}
+
+/*
+ * State for the vendor libraries listed in __GLX_PRELOAD_VENDORS. Those are
+ * loaded on a separate thread, so that the first GLX call on a screen doesn't
+ * have to wait for the dlopen and __glx_Main calls.
+ *
+ * The preload thread checks preloadState.cancelled before it loads each
+ * vendor. The thread pins libGLX.so with RTLD_NODELETE, so the destructor
+ * only runs at process exit, where it's safe to wait for the thread.
+ */
+typedef struct __GLXpreloadStateRec {
+    glvnd_thread_t thread;
+    int threadStarted;
+    int volatile cancelled;
+    char *names;
+} __GLXpreloadState;
+
+static __GLXpreloadState preloadState = {
+    GLVND_THREAD_NULL_INIT, 0, 0, NULL
+};
+
+static const char PRELOAD_VENDOR_SEPARATORS[] = ", ";
+
+static void PreloadVendors(char *names)
+{
+    char *saveptr = NULL;
+    char *name;
+
+    for (name = strtok_r(names, PRELOAD_VENDOR_SEPARATORS, &saveptr);
+            name != NULL;
+            name = strtok_r(NULL, PRELOAD_VENDOR_SEPARATORS, &saveptr)) {
+        if (glvndAtomicLoadAcquire(&preloadState.cancelled)) {
+            break;
+        }
+
+        DBG_PRINTF(10, "Preloading vendor \"%s\"\n", name);
+        __glXLookupVendorByName(name);
+    }
+}
+
+static void *PreloadVendorsThread(void *param)
+{
+    PreloadVendors((char *) param);
+    return NULL;
+}
+
+/*!
+ * Starts loading the vendors listed in __GLX_PRELOAD_VENDORS.
+ *
+ * The preload thread needs libGLX.so to be pinned. Otherwise, a dlclose
+ * could run our destructor while the loader lock is held, and then the
+ * preload thread could be stuck in dlopen while we wait for it. If we can't
+ * pin libGLX.so or create a thread, then this just loads them synchronously.
+ */
+static void StartPreloadVendors(void)
+{
+    const char *env = glvndGetEnv("__GLX_PRELOAD_VENDORS");
+
+    if (env == NULL || env[0] == '\0') {
+        return;
+    }
+
+    preloadState.names = strdup(env);
+    if (preloadState.names == NULL) {
+        return;
+    }
+
+    if (!__glvndPthreadFuncs.is_singlethreaded
+            && glvndPinLibrary((const void *) StartPreloadVendors)
+            && __glvndPthreadFuncs.create(&preloadState.thread, NULL,
+                PreloadVendorsThread, preloadState.names) == 0) {
+        preloadState.threadStarted = 1;
+    } else {
+        PreloadVendors(preloadState.names);
+    }
+}
+
+PUBLIC int glXPreinitializeGLVND(Display *dpy, unsigned int flags)
+{
+    int success = 1;
+
+    __glXThreadInitialize();
+
+    if (flags & GLVND_PREINIT_LOAD_VENDORS) {
+        const char *env = glvndGetEnv("__GLX_PRELOAD_VENDORS");
+
+        // The preload thread might still be working through this list.
+        // Loading a vendor that's already loaded or being loaded just waits
+        // for it, so go through the list here too, so that everything is
+        // loaded by the time we return.
+        if (env != NULL && env[0] != '\0') {
+            char *names = strdup(env);
+            if (names != NULL) {
+                char *saveptr = NULL;
+                char *name;
+
+                for (name = strtok_r(names, PRELOAD_VENDOR_SEPARATORS, &saveptr);
+                        name != NULL;
+                        name = strtok_r(NULL, PRELOAD_VENDOR_SEPARATORS, &saveptr)) {
+                    if (__glXLookupVendorByName(name) == NULL) {
+                        success = 0;
+                    }
+                }
+                free(names);
+            } else {
+                success = 0;
             }
-            assert(glxContextHash == NULL);
-            __glvndPthreadFuncs.mutex_unlock(&glxContextHashLock);
         }
+
+        if (dpy != NULL) {
+            __GLXvendorInfo **vendors = (__GLXvendorInfo **)
+                malloc(ScreenCount(dpy) * sizeof(__GLXvendorInfo *));
+            int screen;
+
+            if (vendors != NULL && __glXLookupVendorsForAllScreens(dpy, vendors) == 0) {
+                for (screen = 0; screen < ScreenCount(dpy); screen++) {
+                    if (vendors[screen] == NULL) {
+                        success = 0;
+                    }
+                }
+            } else {
+                success = 0;
+            }
+            free(vendors);
+        }
+    }
+
+    if (flags & GLVND_PREINIT_POPULATE_DISPATCH) {
+        __glXPopulateVendorDispatchTables();
+    }
+
+    if (flags & GLVND_PREINIT_PREFAULT) {
+        __glDispatchPrewarm();
+    }
+
+    return success;
+}
+
+/*!
+ * Stops the preload thread before we tear anything down.
+ *
+ * If the thread is in the middle of loading a vendor, then this waits for it
+ * to finish that vendor.
+ */
+static void StopPreloadVendors(void)
+{
+    if (preloadState.threadStarted) {
+        glvndAtomicStoreRelease(&preloadState.cancelled, 1);
+        __glvndPthreadFuncs.join(preloadState.thread, NULL);
+        preloadState.threadStarted = 0;
     }
+    free(preloadState.names);
+    preloadState.names = NULL;
 }
 
 static void __glXResetOnFork(void)
 {
+    DBG_PRINTF(0, "Fork detected\n");
+
     /* Reset GLdispatch */
     __glDispatchReset();
 
@@ -2022,6 +2520,9 @@ static void __glXResetOnFork(void)
 
     /* Reset all mapping state */
     __glXMappingTeardown(True);
+
+    /* The preload thread doesn't exist in the child process. */
+    preloadState.threadStarted = 0;
 }
 
 PUBLIC const __glXGLCoreFunctions __GLXGL_CORE_FUNCTIONS = {
@@ -2072,8 +2573,6 @@ void __attribute__ ((constructor)) __glXInit(void)
 void _init(void)
 #endif
 {
-    glvnd_mutexattr_t mutexAttribs;
-
     if (__glDispatchGetABIVersion() != GLDISPATCH_ABI_VERSION) {
         fprintf(stderr, "libGLdispatch ABI version is incompatible with libGLX.\n");
         abort();
@@ -2083,21 +2582,19 @@ void _init(void)
     __glDispatchInit();
     glvndSetupPthreads();
     glvndAppErrorCheckInit();
+    glvndLockProfilingInit();
 
     glvnd_list_init(&currentThreadStateList);
+    __glvndPthreadFuncs.key_create(&threadStateCacheKey, OnThreadStateCacheDestroyed);
+    __glvndPthreadFuncs.key_create(&pushedStateKey, OnPushedStatesDestroyed);
 
-    /*
-     * glxContextHashLock must be a recursive mutex, because we'll have it
-     * locked when we call into the vendor library's glXMakeCurrent
-     * implementation. If the vendor library generates an X error, then that
-     * will often result in a call to exit. In that case, the teardown code
-     * will try to lock the mutex again so that it can clean up the current
-     * context list.
-     */
-    __glvndPthreadFuncs.mutexattr_init(&mutexAttribs);
-    __glvndPthreadFuncs.mutexattr_settype(&mutexAttribs, PTHREAD_MUTEX_RECURSIVE);
-    __glvndPthreadFuncs.mutex_init(&glxContextHashLock, &mutexAttribs);
-    __glvndPthreadFuncs.mutexattr_destroy(&mutexAttribs);
+    __glDispatchRegisterLockStats("GLX", "clientStringLock",
+            &clientStringLockStats, 1);
+    __glDispatchRegisterLockStats("GLX", "currentThreadStateListMutex",
+            &currentThreadStateListMutex.stats, 1);
+    __glDispatchRegisterLockStats("GLX", "glxContextHash",
+            glxContextHash.lockStats, GLVND_HASHMAP_LOCK_COUNT);
+    __glDispatchRegisterMemStats("GLX", glvndMemStats);
 
     __glXMappingInit();
 
@@ -2106,14 +2603,17 @@ void _init(void)
          * Check if we need to pre-load any vendors specified via environment
          * variable.
          */
-        const char *preloadedVendor = getenv("__GLX_VENDOR_LIBRARY_NAME");
+        const char *preloadedVendor = glvndGetEnv("__GLX_VENDOR_LIBRARY_NAME");
 
         if (preloadedVendor) {
             __glXLookupVendorByName(preloadedVendor);
         }
     }
 
-    /* TODO install fork handlers using __register_atfork */
+    StartPreloadVendors();
+
+    glvndForkInit(__glXResetOnFork);
+    glvndFastExitInit((const void *) __glXResetOnFork);
 
     DBG_PRINTF(0, "Loading GLX...\n");
 
@@ -2132,25 +2632,50 @@ void _fini(void)
      */
 
     /* Check for a fork before going further. */
-    CheckFork();
+    glvndCheckFork();
 
     /*
      * If libGLX owns the current thread state, lose current
      * in GLdispatch before going further.
      */
     __GLdispatchThreadState *glas =
-        __glDispatchGetCurrentThreadState();
+        __glDispatchGetCurrentThreadStateInline();
 
     if (glas && glas->tag == GLDISPATCH_API_GLX) {
         __glDispatchLoseCurrent();
     }
 
+    glvndAppErrorCheckFini();
+    __glDispatchUnregisterLockStats("GLX");
+
+    StopPreloadVendors();
+
+    if (glvndFastExitEnabled()) {
+        // libGLX.so is pinned, so the only way to get here is from a process
+        // exit, and there's no point in freeing anything.
+        __glDispatchUnregisterMemStats("GLX");
+        __glDispatchFini();
+        return;
+    }
+
+    DBG_CODE({
+        glvnd_lock_stats_t stats;
+        glvndAdaptiveMutexGetStats(&currentThreadStateListMutex, &stats);
+        DBG_PRINTF(10, "Thread state list lock: %lu acquired, %lu spun, %lu parked\n",
+                stats.acquired, stats.spun, stats.parked);
+    });
+
     /* Tear down all GLX API state */
     __glXAPITeardown(False);
+    __glvndPthreadFuncs.key_delete(threadStateCacheKey);
+    __glvndPthreadFuncs.key_delete(pushedStateKey);
 
     /* Tear down all mapping state */
     __glXMappingTeardown(False);
 
+    __glvndHashMapFini();
+    __glDispatchUnregisterMemStats("GLX");
+
     /* Tear down GLdispatch if necessary */
     __glDispatchFini();
 }
@@ -36,7 +36,6 @@
 #include "libglxabipriv.h"
 #include "libglxmapping.h"
 #include "GLdispatch.h"
-#include "lkdhash.h"
 #include "glvnd_list.h"
 
 typedef struct __GLXcontextInfoRec __GLXcontextInfo;
@@ -61,6 +60,12 @@ typedef struct __GLXThreadStateRec {
     GLXDrawable currentRead;
     __GLXcontextInfo *currentContext;
 
+    /// The vendor's saved state while the thread state is detached or pushed.
+    void *vendorState;
+
+    /// The next state down in the stack for glXPushCurrentGLVND.
+    struct __GLXThreadStateRec *pushedNext;
+
     struct glvnd_list entry;
 } __GLXThreadState;
 
@@ -72,7 +77,7 @@ typedef struct __GLXThreadStateRec {
  */
 static inline __GLXThreadState *__glXGetCurrentThreadState(void)
 {
-    __GLdispatchThreadState *glas = __glDispatchGetCurrentThreadState();
+    __GLdispatchThreadState *glas = __glDispatchGetCurrentThreadStateInline();
     if (unlikely(!glas ||
                  (glas->tag != GLDISPATCH_API_GLX))) {
         return NULL;
@@ -59,7 +59,9 @@ typedef struct {
  *
  * To avoid problems with multiple threads trying to load the same function at
  * the same time, __glXGLLoadGLXFunction will lock \p mutex before it tries to
- * read or write \p ptr.
+ * read or write \p ptr. It stores the function with a release, so the caller
+ * can check \p ptr with an acquire load first and skip the call entirely if
+ * it's already set.
  *
  * Also see src/generate/gen_libgl_glxstubs.py for where this is used.
  *
@@ -32,6 +32,8 @@
 #include <pthread.h>
 #include <dlfcn.h>
 #include <string.h>
+#include <stdint.h>
+#include <time.h>
 
 #if defined(HASH_DEBUG)
 # include <stdio.h>
@@ -41,12 +43,16 @@
 #include "libglxmapping.h"
 #include "libglxthread.h"
 #include "libglxproto.h"
+#include "libglxvendorcache.h"
 #include "utils_misc.h"
 #include "glvnd_genentry.h"
 #include "trace.h"
 #include "winsys_dispatch.h"
 
-#include "lkdhash.h"
+#include "glvnd_atomic.h"
+#include "glvnd_probe.h"
+#include "glvnd_memstats.h"
+#include "glvnd_list.h"
 
 #define _GNU_SOURCE 1
 
@@ -69,13 +75,57 @@
 
 #define GLX_EXTENSION_NAME "GLX"
 
+/*!
+ * How long to remember that the server said an XID isn't a valid drawable,
+ * in milliseconds.
+ *
+ * An XID that's invalid now could become valid later if someone creates a
+ * window with it, and we wouldn't find out about that. The timeout only needs
+ * to be long enough to keep an app that keeps calling a GLX function with a
+ * bad drawable from sending a request each time.
+ */
+#define XID_MISS_TIMEOUT_MS 1000
+
+/*!
+ * The maximum number of invalid XIDs to remember for each display.
+ */
+#define XID_MISS_MAX_COUNT 64
+
+/*!
+ * The number of low XID bits that are indexed by each radix root.
+ *
+ * An X server hands each client a base and a mask for its resource IDs, and
+ * Xlib and XCB hand out IDs within that range by counting up from the base.
+ * The mask is at least 18 bits wide for a server that allows 2048 clients,
+ * so the bits above it pick the root, and the low bits almost always start
+ * from zero.
+ */
+#define XID_RADIX_LOW_BITS 18
+
+/*!
+ * The number of low XID bits that are indexed by each radix leaf. The rest of
+ * the low bits index the root's array of leaves.
+ */
+#define XID_RADIX_LEAF_BITS 8
+
+#define XID_RADIX_LEAF_SIZE (1 << XID_RADIX_LEAF_BITS)
+#define XID_RADIX_ROOT_SIZE (1 << (XID_RADIX_LOW_BITS - XID_RADIX_LEAF_BITS))
+
+/*!
+ * The block size for each vendor's arena. This is enough for the vendor
+ * structure and its first GLX dispatch table.
+ */
+#define VENDOR_ARENA_BLOCK_SIZE 2048
+
 /****************************************************************************/
 
 /**
- * __glXVendorNameHash is a hash table mapping a vendor name to vendor info.
+ * __glXVendorNameHash is a hash table mapping a vendor name to
+ * __GLXvendorNameHash entries.
  *
- * Note that the lock for the vendor name hashtable is also used to control
- * access to the GLX dispatch index list and the generated GLX dispatch stubs.
+ * Looking up a vendor only needs a read section. Entries are only added while
+ * holding \c vendorNameLock for writing, and they're never removed until
+ * \c __glXMappingTeardown.
  */
 typedef struct __GLXvendorNameHashRec {
     __GLXvendorInfo vendor;
@@ -87,26 +137,132 @@ typedef struct __GLXvendorNameHashRec {
      */
     __GLXapiImports imports;
     __GLdispatchPatchCallbacks patchCallbacks;
-
-    UT_hash_handle hh;
 } __GLXvendorNameHash;
 
-static DEFINE_INITIALIZED_LKDHASH(__GLXvendorNameHash, __glXVendorNameHash);
+static __GLVNDhashMap __glXVendorNameHash = GLVND_HASHMAP_INITIALIZER(NULL);
+
+/**
+ * The lock for adding a vendor library to \c __glXVendorNameHash. This is also
+ * used to control access to the GLX dispatch index list and the generated GLX
+ * dispatch stubs.
+ *
+ * Every glXGetProcAddress call for a function that a vendor hasn't looked up
+ * yet takes a read lock, so this prefers writers. Otherwise, loading a vendor
+ * or generating a new stub could wait for a long time behind other threads.
+ * None of the read sections take it again.
+ */
+static glvnd_rwlock_t vendorNameLock = GLVND_RWLOCK_INITIALIZER;
+static glvnd_lock_stats_t vendorNameLockStats;
+
+/**
+ * Maps each name from a vendor's \c getDispatchProcNames list to the first
+ * vendor that listed it. The values are \c __GLXvendorInfo pointers, which
+ * \c __glXVendorNameHash owns. Entries are only added while holding
+ * \c vendorNameLock for writing.
+ */
+static __GLVNDhashMap dispatchNameHash = GLVND_HASHMAP_INITIALIZER(NULL);
+
+/**
+ * A vendor library that a thread is in the middle of loading.
+ *
+ * The loading thread holds \c lock until the vendor has either been added to
+ * \c __glXVendorNameHash or failed to load. Any other thread that needs the
+ * same vendor waits by locking it, so it only blocks on that one vendor.
+ */
+typedef struct __GLXvendorLoadingRec {
+    char *name;
+    glvnd_mutex_t lock;
+
+    /// Protected by vendorLoadingMutex.
+    int refCount;
+    struct glvnd_list entry;
+} __GLXvendorLoading;
+
+/**
+ * The vendors that are being loaded. This is protected by
+ * \c vendorLoadingMutex, which is never held while loading a vendor.
+ */
+static struct glvnd_list vendorLoadingList = { &vendorLoadingList, &vendorLoadingList };
+static glvnd_mutex_t vendorLoadingMutex = GLVND_MUTEX_INITIALIZER;
 
 typedef struct __GLXdisplayInfoHashRec {
     __GLXdisplayInfo info;
-    UT_hash_handle hh;
 } __GLXdisplayInfoHash;
 
-static DEFINE_INITIALIZED_LKDHASH(__GLXdisplayInfoHash, __glXDisplayInfoHash);
+/**
+ * A map of Display pointers to __GLXdisplayInfoHash entries. The map doesn't
+ * own the entries, since they're freed as soon as the display is closed.
+ */
+static __GLVNDhashMap __glXDisplayInfoHash = GLVND_HASHMAP_INITIALIZER(NULL);
+
+/**
+ * Incremented whenever an entry is removed from \c __glXDisplayInfoHash,
+ * which invalidates each thread's cached display in \c __glXLookupDisplay.
+ * This is only modified while holding the display's lock in
+ * \c __glXDisplayInfoHash.
+ */
+static int volatile displayInfoGeneration = 0;
+
+#if defined(GLDISPATCH_USE_TLS)
+/**
+ * The last display that this thread looked up. Most threads only ever use
+ * one display, so this lets \c __glXLookupDisplay skip the hashtable and its
+ * lock.
+ */
+typedef struct {
+    Display *dpy;
+    __GLXdisplayInfo *dpyInfo;
+    int generation;
+} __GLXdisplayInfoCache;
 
+static __thread __GLXdisplayInfoCache cachedDisplayInfo
+    __attribute__((tls_model("initial-exec"))) = { NULL, NULL, 0 };
+#endif
+
+/**
+ * An entry in a display's XID map. These are never modified once they're
+ * added, so that a reader can't see a vendor and expiration time from two
+ * different updates. Changing an XID's mapping replaces its entry.
+ */
 struct __GLXvendorXIDMappingHashRec {
-    XID xid;
+    /**
+     * The vendor for the XID, or NULL if the server said that the XID isn't a
+     * valid drawable.
+     */
     __GLXvendorInfo *vendor;
-    UT_hash_handle hh;
+
+    /**
+     * If \c vendor is NULL, then the time (from GetTimeMS) after which we
+     * should ask the server about this XID again.
+     */
+    uint64_t missExpireTime;
+};
+
+/**
+ * A leaf in a display's radix index of XIDs. Each slot is the vendor for one
+ * XID, or NULL.
+ */
+typedef struct __GLXxidRadixLeafRec {
+    __GLXvendorInfo * volatile vendors[XID_RADIX_LEAF_SIZE];
+} __GLXxidRadixLeaf;
+
+/**
+ * The root of a display's radix index, for every XID with the same bits
+ * above \c XID_RADIX_LOW_BITS.
+ *
+ * The roots and leaves are allocated when the first XID that needs them is
+ * added, published with a compare-and-swap, and then kept until the display
+ * is freed. A slot is only changed while holding the XID's lock in
+ * \c __GLXdisplayInfo::xids.
+ */
+struct __GLXxidRadixRootRec {
+    XID base;
+    __GLXxidRadixLeaf * volatile leaves[XID_RADIX_ROOT_SIZE];
 };
 
 static __GLXextFuncPtr __glXFetchDispatchEntry(__GLXvendorInfo *vendor, int index);
+static void FreeXIDRadix(__GLXdisplayInfo *dpyInfo);
+static void FreeFBConfigCache(__GLXdisplayInfo *dpyInfo);
 
 static const __GLXapiExports glxExportsTable = {
     .getDynDispatch = __glXGetDynDispatch,
@@ -127,6 +283,8 @@ static const __GLXapiExports glxExportsTable = {
     .addVendorDrawableMapping = __glXAddVendorDrawableMapping,
     .removeVendorDrawableMapping = __glXRemoveVendorDrawableMapping,
     .vendorFromDrawable = __glXVendorFromDrawable,
+
+    .invalidateFBConfigCache = __glXInvalidateFBConfigCache,
 };
 
 /*!
@@ -145,8 +303,10 @@ __GLXextFuncPtr __glXGetGLXDispatchAddress(const GLubyte *procName)
 {
     int index;
     __GLXextFuncPtr addr = NULL;
+    __GLXvendorInfo *vendor;
     Bool isGLX;
-    __GLXvendorNameHash *pEntry, *tmp;
+    __GLVNDhashMapIter iter;
+    void *value;
 
     /*
      * Note that if a GLX extension function doesn't depend on calling any
@@ -169,25 +329,39 @@ __GLXextFuncPtr __glXGetGLXDispatchAddress(const GLubyte *procName)
     // generally shouldn't happen, because we cache the results of
     // glXGetProcAddress.
 
-    // The vendor name hashtable's lock is also used for the dispatch index
-    // list and the generated GLX entrypoints.
-    LKDHASH_WRLOCK(__glXVendorNameHash);
+    // The vendor name lock is also used for the dispatch index list and the
+    // generated GLX entrypoints.
+    glvndProfiledRWLockWrite(&vendorNameLock, &vendorNameLockStats);
     index = __glvndWinsysDispatchFindIndex((const char *) procName);
     if (index >= 0) {
         addr = (__GLXextFuncPtr) __glvndWinsysDispatchGetDispatch(index);
 
-        LKDHASH_UNLOCK(__glXVendorNameHash);
+        __glvndPthreadFuncs.rwlock_unlock(&vendorNameLock);
         return addr;
     }
 
+    __glvndHashMapReadBegin();
+
     // We haven't seen this function before, so we need to find or generate a
     // dispatch stub.
 
-    // First, look for a GLX dispatch function from any vendor.
-    HASH_ITER(hh, _LH(__glXVendorNameHash), pEntry, tmp) {
-        addr = pEntry->vendor.glxvc->getDispatchAddress((const GLubyte *) procName);
-        if (addr != NULL) {
-            break;
+    // First, check whether a vendor listed this function in
+    // getDispatchProcNames. If so, we only need to ask that one vendor.
+    vendor = (__GLXvendorInfo *) __glvndHashMapFind(&dispatchNameHash,
+            procName, strlen((const char *) procName));
+    if (vendor != NULL) {
+        addr = vendor->glxvc->getDispatchAddress(procName);
+    }
+
+    // Otherwise, look for a GLX dispatch function from any vendor.
+    if (addr == NULL) {
+        __glvndHashMapIterInit(&__glXVendorNameHash, &iter);
+        while (__glvndHashMapIterNext(&iter, NULL, &value)) {
+            __GLXvendorNameHash *pEntry = (__GLXvendorNameHash *) value;
+            addr = pEntry->vendor.glxvc->getDispatchAddress((const GLubyte *) procName);
+            if (addr != NULL) {
+                break;
+            }
         }
     }
 
@@ -197,7 +371,9 @@ __GLXextFuncPtr __glXGetGLXDispatchAddress(const GLubyte *procName)
         // Look to see if any vendor provides an implementation function. If
         // it does, then that means this is really a GL function that happens
         // to start with "glX".
-        HASH_ITER(hh, _LH(__glXVendorNameHash), pEntry, tmp) {
+        __glvndHashMapIterInit(&__glXVendorNameHash, &iter);
+        while (__glvndHashMapIterNext(&iter, NULL, &value)) {
+            __GLXvendorNameHash *pEntry = (__GLXvendorNameHash *) value;
             addr = pEntry->vendor.glxvc->getProcAddress((const GLubyte *) procName);
             if (addr != NULL) {
                 break;
@@ -223,7 +399,9 @@ __GLXextFuncPtr __glXGetGLXDispatchAddress(const GLubyte *procName)
     if (addr != NULL && isGLX) {
         index = __glvndWinsysDispatchAllocIndex((const char *) procName, addr);
         if (index >= 0) {
-            HASH_ITER(hh, _LH(__glXVendorNameHash), pEntry, tmp) {
+            __glvndHashMapIterInit(&__glXVendorNameHash, &iter);
+            while (__glvndHashMapIterNext(&iter, NULL, &value)) {
+                __GLXvendorNameHash *pEntry = (__GLXvendorNameHash *) value;
                 pEntry->vendor.glxvc->setDispatchIndex(procName, index);
             }
         } else {
@@ -231,7 +409,8 @@ __GLXextFuncPtr __glXGetGLXDispatchAddress(const GLubyte *procName)
         }
     }
 
-    LKDHASH_UNLOCK(__glXVendorNameHash);
+    __glvndHashMapReadEnd();
+    __glvndPthreadFuncs.rwlock_unlock(&vendorNameLock);
 
     return addr;
 }
@@ -268,9 +447,9 @@ __GLXextFuncPtr __glXFetchDispatchEntry(__GLXvendorInfo *vendor,
     // Not seen before by this vendor: query the vendor for the right
     // address to use.
 
-    LKDHASH_RDLOCK(__glXVendorNameHash);
+    glvndProfiledRWLockRead(&vendorNameLock, &vendorNameLockStats);
     procName = (const GLubyte *) __glvndWinsysDispatchGetName(index);
-    LKDHASH_UNLOCK(__glXVendorNameHash);
+    __glvndPthreadFuncs.rwlock_unlock(&vendorNameLock);
 
     // This should have a valid entry point associated with it.
     if (procName == NULL) {
@@ -303,9 +482,9 @@ static char *ConstructVendorLibraryFilename(const char *vendorName)
     return filename;
 }
 
-static void CleanupVendorNameEntry(void *unused,
-                                   __GLXvendorNameHash *pEntry)
+static void CleanupVendorNameEntry(void *unused, void *value)
 {
+    __GLXvendorNameHash *pEntry = (__GLXvendorNameHash *) value;
     __GLXvendorInfo *vendor = &pEntry->vendor;
     if (vendor->glDispatch != NULL) {
         __glDispatchDestroyTable(vendor->glDispatch);
@@ -323,11 +502,31 @@ static void CleanupVendorNameEntry(void *unused,
     }
 }
 
+static void FreeVendorNameEntry(void *unused, void *value)
+{
+    __GLXvendorNameHash *pEntry = (__GLXvendorNameHash *) value;
+
+    CleanupVendorNameEntry(unused, value);
+
+    // This also frees pEntry itself.
+    __glvndArenaDestroy(pEntry->vendor.arena);
+}
+
 static GLboolean LookupVendorEntrypoints(__GLXvendorInfo *vendor)
 {
+    memset(&vendor->staticDispatch, 0, sizeof(vendor->staticDispatch));
+
+    // If the vendor can hand over its whole table, then we only need to look
+    // up whatever it left out by name.
+    if (vendor->glxvc->getStaticDispatch != NULL) {
+        vendor->glxvc->getStaticDispatch(&vendor->staticDispatch);
+    }
+
 #define LOADENTRYPOINT(ptr, name) do { \
-    vendor->staticDispatch.ptr = vendor->glxvc->getProcAddress((const GLubyte *) name); \
-    if (vendor->staticDispatch.ptr == NULL) { return GL_FALSE; } \
+    if (vendor->staticDispatch.ptr == NULL) { \
+        vendor->staticDispatch.ptr = vendor->glxvc->getProcAddress((const GLubyte *) name); \
+        if (vendor->staticDispatch.ptr == NULL) { return GL_FALSE; } \
+    } \
     } while(0)
 
     LOADENTRYPOINT(chooseVisual,          "glXChooseVisual"         );
@@ -366,7 +565,9 @@ static GLboolean LookupVendorEntrypoints(__GLXvendorInfo *vendor)
 
     // These functions are optional.
 #define LOADENTRYPOINT(ptr, name) do { \
-    vendor->staticDispatch.ptr = vendor->glxvc->getProcAddress((const GLubyte *) name); \
+    if (vendor->staticDispatch.ptr == NULL) { \
+        vendor->staticDispatch.ptr = vendor->glxvc->getProcAddress((const GLubyte *) name); \
+    } \
     } while(0)
     LOADENTRYPOINT(importContextEXT,            "glXImportContextEXT"           );
     LOADENTRYPOINT(freeContextEXT,              "glXFreeContextEXT"             );
@@ -376,336 +577,732 @@ static GLboolean LookupVendorEntrypoints(__GLXvendorInfo *vendor)
     return GL_TRUE;
 }
 
+/*!
+ * If the vendor has an array of its OpenGL functions in our slot order, then
+ * hands it to the dispatch table, so that it doesn't have to look up each
+ * function by name.
+ */
+static void SetVendorStaticFuncs(__GLXvendorInfo *vendor)
+{
+    const void * const *funcs;
+    uint32_t layoutHash;
+    int count = 0;
+
+    if (vendor->glxvc->getGLStaticFuncs == NULL) {
+        return;
+    }
+    layoutHash = __glDispatchGetTableLayout(NULL);
+    funcs = vendor->glxvc->getGLStaticFuncs(layoutHash, &count);
+    if (funcs != NULL) {
+        __glDispatchSetTableStaticFuncs(vendor->glDispatch, layoutHash, funcs, count);
+    }
+}
+
 static void *VendorGetProcAddressCallback(const char *procName, void *param)
 {
     __GLXvendorInfo *vendor = (__GLXvendorInfo *) param;
     return vendor->glxvc->getProcAddress((const GLubyte *) procName);
 }
 
-__GLXvendorInfo *__glXLookupVendorByName(const char *vendorName)
+/*!
+ * Loads a vendor library and fills in a new \c __GLXvendorNameHash for it.
+ *
+ * This doesn't add the vendor to \c __glXVendorNameHash, and it's called
+ * without holding \c vendorNameLock, so that a slow dlopen doesn't block
+ * other threads.
+ *
+ * \return The new entry, or NULL on failure.
+ */
+static __GLXvendorNameHash *LoadVendor(const char *vendorName, size_t vendorNameLen)
 {
     __GLXvendorNameHash *pEntry = NULL;
-    Bool locked = False;
-    size_t vendorNameLen;
+    __GLXvendorInfo *vendor;
+    __GLVNDarena *arena;
+    __PFNGLXMAINPROC glxMainProc;
+    char *filename;
+    Bool success;
 
-    // We'll use the vendor name to construct a DSO name, so make sure it
-    // doesn't contain any '/' characters.
-    if (strchr(vendorName, '/') != NULL) {
+    arena = __glvndArenaCreate(VENDOR_ARENA_BLOCK_SIZE, GLVND_MEM_VENDOR);
+    if (arena == NULL) {
         return NULL;
     }
-
-    vendorNameLen = strlen(vendorName);
-
-    LKDHASH_RDLOCK(__glXVendorNameHash);
-    HASH_FIND(hh, _LH(__glXVendorNameHash), vendorName, vendorNameLen, pEntry);
-
-    LKDHASH_UNLOCK(__glXVendorNameHash);
-
+    pEntry = __glvndArenaAlloc(arena, sizeof(*pEntry) + vendorNameLen + 1);
     if (!pEntry) {
-        LKDHASH_WRLOCK(__glXVendorNameHash);
-        locked = True;
-        // Do another lookup to check uniqueness
-        HASH_FIND(hh, _LH(__glXVendorNameHash), vendorName, vendorNameLen, pEntry);
-        if (!pEntry) {
-            __GLXvendorInfo *vendor;
-            __PFNGLXMAINPROC glxMainProc;
-            char *filename;
-            int i, count;
-            Bool success;
-
-            // Previously unseen vendor. dlopen() the new vendor and add it to the
-            // hash table.
-            pEntry = calloc(1, sizeof(*pEntry) + vendorNameLen + 1);
-            if (!pEntry) {
-                goto fail;
-            }
-            vendor = &pEntry->vendor;
-
-            vendor->glxvc = &pEntry->imports;
-            vendor->name = (char *) (pEntry + 1);
-            memcpy(vendor->name, vendorName, vendorNameLen + 1);
-
-            filename = ConstructVendorLibraryFilename(vendorName);
-            if (filename) {
-                vendor->dlhandle = dlopen(filename, RTLD_LAZY);
-            }
-            free(filename);
-            if (vendor->dlhandle == NULL) {
-                goto fail;
-            }
-
-            glxMainProc = dlsym(vendor->dlhandle, __GLX_MAIN_PROTO_NAME);
-            if (!glxMainProc) {
-                goto fail;
-            }
-
-            vendor->vendorID = __glDispatchNewVendorID();
-            assert(vendor->vendorID >= 0);
-
-            vendor->glDispatch = (__GLdispatchTable *)
-                __glDispatchCreateTable(
-                    VendorGetProcAddressCallback,
-                    vendor
-                );
-            if (!vendor->glDispatch) {
-                goto fail;
-            }
-
-            /* Initialize the dynamic dispatch table */
-            vendor->dynDispatch = __glvndWinsysVendorDispatchCreate();
-            if (vendor->dynDispatch == NULL) {
-                goto fail;
-            }
-
-            success = (*glxMainProc)(GLX_VENDOR_ABI_VERSION,
-                                      &glxExportsTable,
-                                      vendor, &pEntry->imports);
-            if (!success) {
-                goto fail;
-            }
+        __glvndArenaDestroy(arena);
+        return NULL;
+    }
+    vendor = &pEntry->vendor;
+    vendor->arena = arena;
+
+    vendor->glxvc = &pEntry->imports;
+    vendor->name = (char *) (pEntry + 1);
+    memcpy(vendor->name, vendorName, vendorNameLen + 1);
+
+    filename = ConstructVendorLibraryFilename(vendorName);
+    if (filename) {
+        GLDISPATCH_TRACE(1, GLDISPATCH_TRACE_PHASE_BEGIN,
+                GLDISPATCH_PHASE_DLOPEN, GLDISPATCH_API_GLX);
+        GLVND_PROBE2(vendor_dlopen_begin, GLDISPATCH_API_GLX, vendor->name);
+        vendor->dlhandle = dlopen(filename, RTLD_LAZY);
+        GLVND_PROBE3(vendor_dlopen_end, GLDISPATCH_API_GLX, vendor->name,
+                vendor->dlhandle);
+        GLDISPATCH_TRACE(1, GLDISPATCH_TRACE_PHASE_END,
+                GLDISPATCH_PHASE_DLOPEN, GLDISPATCH_API_GLX);
+    }
+    free(filename);
+    if (vendor->dlhandle == NULL) {
+        goto fail;
+    }
 
-            // Make sure all the required functions are there.
-            if (pEntry->imports.isScreenSupported == NULL
-                    || pEntry->imports.getProcAddress == NULL
-                    || pEntry->imports.getDispatchAddress == NULL
-                    || pEntry->imports.setDispatchIndex == NULL)
-            {
-                goto fail;
-            }
+    glxMainProc = dlsym(vendor->dlhandle, __GLX_MAIN_PROTO_NAME);
+    if (!glxMainProc) {
+        goto fail;
+    }
 
-            if (!LookupVendorEntrypoints(vendor)) {
-                goto fail;
-            }
+    vendor->vendorID = __glDispatchNewVendorID();
+    assert(vendor->vendorID >= 0);
 
-            // Check to see whether this vendor library can support entrypoint
-            // patching.
-            if (pEntry->imports.isPatchSupported != NULL
-                    && pEntry->imports.initiatePatch != NULL) {
-                pEntry->patchCallbacks.isPatchSupported = pEntry->imports.isPatchSupported;
-                pEntry->patchCallbacks.initiatePatch = pEntry->imports.initiatePatch;
-                pEntry->patchCallbacks.releasePatch = pEntry->imports.releasePatch;
-                pEntry->patchCallbacks.threadAttach = pEntry->imports.patchThreadAttach;
-                pEntry->vendor.patchCallbacks = &pEntry->patchCallbacks;
-            }
+    vendor->glDispatch = (__GLdispatchTable *)
+        __glDispatchCreateTable(
+            VendorGetProcAddressCallback,
+            vendor
+        );
+    if (!vendor->glDispatch) {
+        goto fail;
+    }
+    __glDispatchSetTableVendor(vendor->glDispatch, vendor->dlhandle, "glx");
 
-            HASH_ADD_KEYPTR(hh, _LH(__glXVendorNameHash), vendor->name,
-                            strlen(vendor->name), pEntry);
+    /* Initialize the dynamic dispatch table */
+    vendor->dynDispatch = __glvndWinsysVendorDispatchCreate(vendor->arena);
+    if (vendor->dynDispatch == NULL) {
+        goto fail;
+    }
 
-            // Look up the dispatch functions for any GLX extensions that we
-            // generated entrypoints for.
-            glvndUpdateEntrypoints(GLXEntrypointUpdateCallback, vendor);
+    GLDISPATCH_TRACE(1, GLDISPATCH_TRACE_PHASE_BEGIN,
+            GLDISPATCH_PHASE_VENDOR_MAIN, GLDISPATCH_API_GLX);
+    success = (*glxMainProc)(GLX_VENDOR_ABI_VERSION,
+                              &glxExportsTable,
+                              vendor, &pEntry->imports);
+    if (!success) {
+        goto fail;
+    }
+    GLDISPATCH_TRACE(1, GLDISPATCH_TRACE_PHASE_END,
+            GLDISPATCH_PHASE_VENDOR_MAIN, GLDISPATCH_API_GLX);
+
+    // Make sure all the required functions are there.
+    if (pEntry->imports.isScreenSupported == NULL
+            || pEntry->imports.getProcAddress == NULL
+            || pEntry->imports.getDispatchAddress == NULL
+            || pEntry->imports.setDispatchIndex == NULL)
+    {
+        goto fail;
+    }
 
-            // Tell the vendor the index of all of the GLX dispatch stubs.
-            count = __glvndWinsysDispatchGetCount();
-            for (i=0; i<count; i++) {
-                const char *procName = __glvndWinsysDispatchGetName(i);
-                vendor->glxvc->setDispatchIndex((const GLubyte *) procName, i);
-            }
-        }
-        LKDHASH_UNLOCK(__glXVendorNameHash);
+    GLDISPATCH_TRACE(1, GLDISPATCH_TRACE_PHASE_BEGIN,
+            GLDISPATCH_PHASE_LOOKUP, GLDISPATCH_API_GLX);
+    if (!LookupVendorEntrypoints(vendor)) {
+        goto fail;
+    }
+    SetVendorStaticFuncs(vendor);
+    GLDISPATCH_TRACE(1, GLDISPATCH_TRACE_PHASE_END,
+            GLDISPATCH_PHASE_LOOKUP, GLDISPATCH_API_GLX);
+
+    // Check to see whether this vendor library can support entrypoint
+    // patching.
+    if ((pEntry->imports.isPatchSupported != NULL
+                && pEntry->imports.initiatePatch != NULL)
+            || pEntry->imports.initiatePatchTargets != NULL) {
+        pEntry->patchCallbacks.isPatchSupported = pEntry->imports.isPatchSupported;
+        pEntry->patchCallbacks.initiatePatch = pEntry->imports.initiatePatch;
+        pEntry->patchCallbacks.releasePatch = pEntry->imports.releasePatch;
+        pEntry->patchCallbacks.threadAttach = pEntry->imports.patchThreadAttach;
+        pEntry->patchCallbacks.initiatePatchTargets = pEntry->imports.initiatePatchTargets;
+        pEntry->vendor.patchCallbacks = &pEntry->patchCallbacks;
     }
 
-    return &pEntry->vendor;
+    return pEntry;
 
 fail:
-    if (locked) {
-        LKDHASH_UNLOCK(__glXVendorNameHash);
-    }
-    if (pEntry != NULL) {
-        CleanupVendorNameEntry(NULL, pEntry);
-        free(pEntry);
-    }
+    FreeVendorNameEntry(NULL, pEntry);
     return NULL;
 }
 
-__GLXvendorInfo *__glXLookupVendorByScreen(Display *dpy, const int screen)
+/*!
+ * Adds the names from a vendor's \c getDispatchProcNames list to
+ * \c dispatchNameHash. If another vendor already listed a name, then that
+ * vendor keeps it.
+ *
+ * The caller must hold \c vendorNameLock for writing. If we can't add a name,
+ * then \c __glXGetGLXDispatchAddress will just find it the slow way.
+ */
+static void AddDispatchProcNames(__GLXvendorInfo *vendor)
 {
-    __GLXvendorInfo *vendor = NULL;
-    __GLXdisplayInfo *dpyInfo;
+    const char * const *names;
+    int i;
 
-    if (screen < 0 || screen >= ScreenCount(dpy)) {
-        return NULL;
+    if (vendor->glxvc->getDispatchProcNames == NULL) {
+        return;
     }
-
-    dpyInfo = __glXLookupDisplay(dpy);
-    if (dpyInfo == NULL) {
-        return NULL;
+    names = vendor->glxvc->getDispatchProcNames();
+    if (names == NULL) {
+        return;
     }
 
-    __glvndPthreadFuncs.rwlock_rdlock(&dpyInfo->vendorLock);
-    vendor = dpyInfo->vendors[screen];
-    __glvndPthreadFuncs.rwlock_unlock(&dpyInfo->vendorLock);
+    for (i=0; names[i] != NULL; i++) {
+        size_t len = strlen(names[i]);
 
-    if (vendor != NULL) {
-        return vendor;
+        __glvndHashMapLock(&dispatchNameHash, names[i], len);
+        if (__glvndHashMapFind(&dispatchNameHash, names[i], len) == NULL) {
+            __glvndHashMapInsert(&dispatchNameHash, names[i], len, vendor);
+        }
+        __glvndHashMapUnlock(&dispatchNameHash, names[i], len);
     }
+}
 
-    __glvndPthreadFuncs.rwlock_wrlock(&dpyInfo->vendorLock);
-    vendor = dpyInfo->vendors[screen];
+/*!
+ * Adds a vendor from \c LoadVendor to \c __glXVendorNameHash, and tells it
+ * about the GLX dispatch stubs.
+ *
+ * This is done while holding \c vendorNameLock for writing, so that
+ * \c __glXGetGLXDispatchAddress can't add a dispatch index in between.
+ *
+ * \return True on success. On failure, the caller still owns \p pEntry.
+ */
+static Bool PublishVendor(__GLXvendorNameHash *pEntry, size_t vendorNameLen)
+{
+    __GLXvendorInfo *vendor = &pEntry->vendor;
+    const char **names;
+    int i, count;
+    Bool success;
+
+    glvndProfiledRWLockWrite(&vendorNameLock, &vendorNameLockStats);
+
+    __glvndHashMapLock(&__glXVendorNameHash, vendor->name, vendorNameLen);
+    success = __glvndHashMapInsert(&__glXVendorNameHash, vendor->name,
+            vendorNameLen, pEntry);
+    __glvndHashMapUnlock(&__glXVendorNameHash, vendor->name, vendorNameLen);
+    if (!success) {
+        __glvndPthreadFuncs.rwlock_unlock(&vendorNameLock);
+        return False;
+    }
 
-    if (!vendor) {
-        /*
-         * If we have specified a vendor library, use that. Otherwise,
-         * try to lookup the vendor based on the current screen.
-         */
-        char envName[40];
-        const char *specifiedVendorName;
+    AddDispatchProcNames(vendor);
 
-        snprintf(envName, sizeof(envName), "__GLX_FORCE_VENDOR_LIBRARY_%d", screen);
-        specifiedVendorName = getenv(envName);
+    // Look up the dispatch functions for any GLX extensions that we
+    // generated entrypoints for.
+    glvndUpdateEntrypoints(GLXEntrypointUpdateCallback, vendor);
 
-        if (specifiedVendorName == NULL) {
-            specifiedVendorName = getenv("__GLX_VENDOR_LIBRARY_NAME");
+    // Tell the vendor the index of all of the GLX dispatch stubs.
+    names = NULL;
+    if (vendor->glxvc->setDispatchIndexBulk != NULL) {
+        names = __glvndWinsysDispatchGetNames(&count);
+    }
+    if (names != NULL) {
+        vendor->glxvc->setDispatchIndexBulk((const GLubyte * const *) names, 0, count);
+        free(names);
+    } else {
+        count = __glvndWinsysDispatchGetCount();
+        for (i=0; i<count; i++) {
+            const char *procName = __glvndWinsysDispatchGetName(i);
+            vendor->glxvc->setDispatchIndex((const GLubyte *) procName, i);
         }
+    }
 
-        if (specifiedVendorName) {
-            vendor = __glXLookupVendorByName(specifiedVendorName);
-        }
+    __glvndPthreadFuncs.rwlock_unlock(&vendorNameLock);
 
-        if (!vendor) {
-            if (dpyInfo->libglvndExtensionSupported) {
-                char *queriedVendorNames =
-                    __glXQueryServerString(dpyInfo, screen, GLX_VENDOR_NAMES_EXT);
-                if (queriedVendorNames != NULL) {
-                    char *name, *saveptr;
-                    for (name = strtok_r(queriedVendorNames, " ", &saveptr);
-                            name != NULL;
-                            name = strtok_r(NULL, " ", &saveptr)) {
-                        vendor = __glXLookupVendorByName(name);
-
-                        // Make sure that the vendor library can support this screen.
-                        if (vendor != NULL && !vendor->glxvc->isScreenSupported(dpy, screen)) {
-                            vendor = NULL;
-                        }
-
-                        if (vendor != NULL) {
-                            break;
-                        }
-                    }
-                    free(queriedVendorNames);
-                }
-            }
-        }
+    GLDISPATCH_TRACE(1, GLDISPATCH_TRACE_VENDOR_LOAD,
+            GLDISPATCH_API_GLX, vendor->vendorID);
+    GLVND_PROBE2(vendor_load, GLDISPATCH_API_GLX, vendor->vendorID);
+    return True;
+}
 
-        if (!vendor) {
-            vendor = __glXLookupVendorByName(FALLBACK_VENDOR_NAME);
-        }
+static __GLXvendorNameHash *FindVendorNameEntry(const char *vendorName,
+        size_t vendorNameLen)
+{
+    __GLXvendorNameHash *pEntry;
 
-        dpyInfo->vendors[screen] = vendor;
-    }
-    __glvndPthreadFuncs.rwlock_unlock(&dpyInfo->vendorLock);
+    __glvndHashMapReadBegin();
+    pEntry = (__GLXvendorNameHash *) __glvndHashMapFind(&__glXVendorNameHash,
+            vendorName, vendorNameLen);
+    __glvndHashMapReadEnd();
+    return pEntry;
+}
 
-    DBG_PRINTF(10, "Found vendor \"%s\" for screen %d\n",
-               (vendor != NULL ? vendor->name : "NULL"), screen);
+static __GLXvendorLoading *FindVendorLoading(const char *vendorName)
+{
+    __GLXvendorLoading *loading;
 
-    return vendor;
+    glvnd_list_for_each_entry(loading, &vendorLoadingList, entry) {
+        if (strcmp(loading->name, vendorName) == 0) {
+            return loading;
+        }
+    }
+    return NULL;
 }
 
-__GLXvendorInfo *__glXGetDynDispatch(Display *dpy, const int screen)
+static void ReleaseVendorLoading(__GLXvendorLoading *loading)
 {
-    __glXThreadInitialize();
+    Bool last;
 
-    __GLXvendorInfo *vendor = __glXLookupVendorByScreen(dpy, screen);
-    return vendor;
+    __glvndPthreadFuncs.mutex_lock(&vendorLoadingMutex);
+    last = (--loading->refCount == 0);
+    __glvndPthreadFuncs.mutex_unlock(&vendorLoadingMutex);
+
+    if (last) {
+        __glvndPthreadFuncs.mutex_destroy(&loading->lock);
+        free(loading);
+    }
 }
 
-/**
- * Allocates and initializes a __GLXdisplayInfoHash structure.
- *
- * The caller is responsible for adding the structure to the hashtable.
- *
- * \param dpy The display connection.
- * \return A newly-allocated __GLXdisplayInfoHash structure, or NULL on error.
- */
-static __GLXdisplayInfoHash *InitDisplayInfoEntry(Display *dpy)
+__GLXvendorInfo *__glXLookupVendorByName(const char *vendorName)
 {
-    __GLXdisplayInfoHash *pEntry;
-    size_t size;
-    int eventBase;
+    __GLXvendorNameHash *pEntry = NULL;
+    __GLXvendorLoading *loading;
+    size_t vendorNameLen;
+    uint64_t slowOpStart;
 
-    size = sizeof(*pEntry) + ScreenCount(dpy) * sizeof(__GLXvendorInfo *);
-    pEntry = (__GLXdisplayInfoHash *) malloc(size);
-    if (pEntry == NULL) {
+    // We'll use the vendor name to construct a DSO name, so make sure it
+    // doesn't contain any '/' characters.
+    if (strchr(vendorName, '/') != NULL) {
         return NULL;
     }
 
-    memset(pEntry, 0, size);
-    pEntry->info.dpy = dpy;
-    pEntry->info.vendors = (__GLXvendorInfo **) (pEntry + 1);
+    vendorNameLen = strlen(vendorName);
 
-    LKDHASH_INIT(pEntry->info.xidVendorHash);
-    __glvndPthreadFuncs.rwlock_init(&pEntry->info.vendorLock, NULL);
+    pEntry = FindVendorNameEntry(vendorName, vendorNameLen);
+    if (pEntry != NULL) {
+        return &pEntry->vendor;
+    }
 
-    // Check whether the server supports the GLX extension, and record the
-    // major opcode if it does.
-    pEntry->info.glxSupported = XQueryExtension(dpy, GLX_EXTENSION_NAME,
-            &pEntry->info.glxMajorOpcode, &eventBase,
-            &pEntry->info.glxFirstError);
+    __glvndPthreadFuncs.mutex_lock(&vendorLoadingMutex);
 
-    if (pEntry->info.glxSupported) {
-        int screen;
-
-        // Check to see if the server supports the GLX_EXT_libglvnd extension.
-        // Note that it has to be supported on every screen to use it.
-        pEntry->info.libglvndExtensionSupported = True;
-        for (screen = 0;
-                screen < ScreenCount(dpy) && pEntry->info.libglvndExtensionSupported;
-                screen++) {
-            char *extensions = __glXQueryServerString(&pEntry->info, screen, GLX_EXTENSIONS);
-            if (extensions != NULL) {
-                if (!IsTokenInString(extensions, GLX_EXT_LIBGLVND_NAME,
-                            strlen(GLX_EXT_LIBGLVND_NAME), " ")) {
-                    pEntry->info.libglvndExtensionSupported = False;
-                }
-                free(extensions);
-            } else {
-                pEntry->info.libglvndExtensionSupported = False;
-            }
-        }
+    // Check again, in case another thread finished loading the vendor
+    // before we got the lock.
+    pEntry = FindVendorNameEntry(vendorName, vendorNameLen);
+    if (pEntry != NULL) {
+        __glvndPthreadFuncs.mutex_unlock(&vendorLoadingMutex);
+        return &pEntry->vendor;
     }
 
-    return pEntry;
-}
+    loading = FindVendorLoading(vendorName);
+    if (loading != NULL) {
+        // Another thread is already loading this vendor. Its lock is held
+        // until the load is finished, so wait for that, and then use
+        // whatever it found.
+        loading->refCount++;
+        __glvndPthreadFuncs.mutex_unlock(&vendorLoadingMutex);
 
-/**
- * Frees a __GLXdisplayInfoHash structure.
- *
- * The caller is responsible for removing the structure from the hashtable.
- *
- * \param unused Ingored. Needed for the uthash teardown function.
- * \param pEntry The structure to free.
- */
-static void CleanupDisplayInfoEntry(void *unused, __GLXdisplayInfoHash *pEntry)
-{
-    int i;
+        __glvndPthreadFuncs.mutex_lock(&loading->lock);
+        __glvndPthreadFuncs.mutex_unlock(&loading->lock);
+        ReleaseVendorLoading(loading);
 
-    if (pEntry == NULL) {
-        return;
+        pEntry = FindVendorNameEntry(vendorName, vendorNameLen);
+        return (pEntry != NULL ? &pEntry->vendor : NULL);
     }
 
-    for (i=0; i<GLX_CLIENT_STRING_LAST_ATTRIB; i++) {
-        free(pEntry->info.clientStrings[i]);
+    loading = malloc(sizeof(*loading) + vendorNameLen + 1);
+    if (loading == NULL) {
+        __glvndPthreadFuncs.mutex_unlock(&vendorLoadingMutex);
+        return NULL;
     }
+    loading->name = (char *) (loading + 1);
+    memcpy(loading->name, vendorName, vendorNameLen + 1);
+    loading->refCount = 1;
+    __glvndPthreadFuncs.mutex_init(&loading->lock, NULL);
+    __glvndPthreadFuncs.mutex_lock(&loading->lock);
+    glvnd_list_add(&loading->entry, &vendorLoadingList);
+    __glvndPthreadFuncs.mutex_unlock(&vendorLoadingMutex);
+
+    // Previously unseen vendor. Load it without holding any global lock, so
+    // that other threads can still look up other vendors and dispatch
+    // functions in the meantime.
+    slowOpStart = __glDispatchSlowOpBegin();
+    pEntry = LoadVendor(vendorName, vendorNameLen);
+    if (pEntry != NULL && !PublishVendor(pEntry, vendorNameLen)) {
+        FreeVendorNameEntry(NULL, pEntry);
+        pEntry = NULL;
+    }
+    __glDispatchSlowOpEnd(slowOpStart,
+            (pEntry != NULL ? "LoadVendor" : "LoadVendor (failed)"),
+            vendorName, (pEntry != NULL ? pEntry->vendor.vendorID : 0));
+
+    __glvndPthreadFuncs.mutex_lock(&vendorLoadingMutex);
+    glvnd_list_del(&loading->entry);
+    __glvndPthreadFuncs.mutex_unlock(&vendorLoadingMutex);
+    __glvndPthreadFuncs.mutex_unlock(&loading->lock);
+    ReleaseVendorLoading(loading);
 
-    LKDHASH_TEARDOWN(__GLXvendorXIDMappingHash,
-                     pEntry->info.xidVendorHash, NULL, NULL, False);
+    return (pEntry != NULL ? &pEntry->vendor : NULL);
 }
 
-static int OnDisplayClosed(Display *dpy, XExtCodes *codes)
+void __glXQueryServerInfo(__GLXdisplayInfo *dpyInfo)
 {
-    __GLXdisplayInfoHash *pEntry = NULL;
+    Display *dpy = dpyInfo->dpy;
+    char **extensions;
+    int screen;
 
-    LKDHASH_WRLOCK(__glXDisplayInfoHash);
-
-    HASH_FIND_PTR(_LH(__glXDisplayInfoHash), &dpy, pEntry);
-    if (pEntry != NULL) {
-        __glXDisplayClosed(&pEntry->info);
-        HASH_DEL(_LH(__glXDisplayInfoHash), pEntry);
+    if (glvndAtomicLoadAcquire(&dpyInfo->serverInfoQueried)) {
+        return;
     }
-    LKDHASH_UNLOCK(__glXDisplayInfoHash);
 
-    CleanupDisplayInfoEntry(NULL, pEntry);
-    free(pEntry);
+    __glvndPthreadFuncs.mutex_lock(&dpyInfo->serverInfoLock);
+    if (dpyInfo->serverInfoQueried || !dpyInfo->glxSupported) {
+        glvndAtomicStoreRelease(&dpyInfo->serverInfoQueried, 1);
+        __glvndPthreadFuncs.mutex_unlock(&dpyInfo->serverInfoLock);
+        return;
+    }
+
+    // Check to see if the server supports the GLX_EXT_libglvnd extension.
+    // Note that it has to be supported on every screen to use it. The
+    // server's GLX version comes back in the same round trip.
+    dpyInfo->libglvndExtensionSupported = False;
+    extensions = (char **) calloc(ScreenCount(dpy), sizeof(char *));
+    if (extensions != NULL) {
+        __glXQueryServerVersionAndStrings(dpyInfo, GLX_EXTENSIONS,
+                extensions, &dpyInfo->glxMajorVersion,
+                &dpyInfo->glxMinorVersion);
+        dpyInfo->libglvndExtensionSupported = True;
+        for (screen = 0; screen < ScreenCount(dpy); screen++) {
+            if (extensions[screen] == NULL || !IsTokenInString(extensions[screen],
+                        GLX_EXT_LIBGLVND_NAME, strlen(GLX_EXT_LIBGLVND_NAME), " ")) {
+                dpyInfo->libglvndExtensionSupported = False;
+            }
+            free(extensions[screen]);
+        }
+        free(extensions);
+    }
+
+    glvndAtomicStoreRelease(&dpyInfo->serverInfoQueried, 1);
+    __glvndPthreadFuncs.mutex_unlock(&dpyInfo->serverInfoLock);
+}
+
+/*!
+ * Figures out which vendor to use for a screen.
+ *
+ * The caller must hold \c dpyInfo->vendorLock for writing, and is
+ * responsible for storing the result in \c dpyInfo->vendors.
+ */
+static __GLXvendorInfo *ResolveVendorForScreen(Display *dpy,
+        __GLXdisplayInfo *dpyInfo, int screen)
+{
+    __GLXvendorInfo *vendor = NULL;
+    char envName[40];
+    const char *specifiedVendorName;
+
+    /*
+     * If we have specified a vendor library, use that. Otherwise,
+     * try to lookup the vendor based on the current screen.
+     */
+    snprintf(envName, sizeof(envName), "__GLX_FORCE_VENDOR_LIBRARY_%d", screen);
+    specifiedVendorName = glvndGetEnv(envName);
+
+    if (specifiedVendorName == NULL) {
+        specifiedVendorName = glvndGetEnv("__GLX_VENDOR_LIBRARY_NAME");
+    }
+
+    if (specifiedVendorName) {
+        vendor = __glXLookupVendorByName(specifiedVendorName);
+    }
+
+    if (!vendor) {
+        // If another process already found the vendor for this screen, then
+        // we can skip the server query and the isScreenSupported checks.
+        if (!dpyInfo->vendorCacheRead) {
+            __glXReadVendorScreenCache(dpy, dpyInfo->cachedVendorNames);
+            dpyInfo->vendorCacheRead = True;
+        }
+        if (dpyInfo->cachedVendorNames[screen] != NULL) {
+            vendor = __glXLookupVendorByName(dpyInfo->cachedVendorNames[screen]);
+        }
+    }
+
+    if (!vendor) {
+        __glXQueryServerInfo(dpyInfo);
+        if (dpyInfo->libglvndExtensionSupported) {
+            // Fetch the vendor names for every screen in one round trip,
+            // since an app that uses one screen will probably use the
+            // others too.
+            if (!dpyInfo->vendorNamesQueried) {
+                __glXQueryServerStringAllScreens(dpyInfo,
+                        GLX_VENDOR_NAMES_EXT, dpyInfo->vendorNames);
+                dpyInfo->vendorNamesQueried = True;
+            }
+
+            if (dpyInfo->vendorNames[screen] != NULL) {
+                char *queriedVendorNames = dpyInfo->vendorNames[screen];
+                char *name, *saveptr;
+
+                // We only need each screen's names once, so we can
+                // tokenize the string in place.
+                dpyInfo->vendorNames[screen] = NULL;
+                for (name = strtok_r(queriedVendorNames, " ", &saveptr);
+                        name != NULL;
+                        name = strtok_r(NULL, " ", &saveptr)) {
+                    vendor = __glXLookupVendorByName(name);
+
+                    // Make sure that the vendor library can support this screen.
+                    if (vendor != NULL && !vendor->glxvc->isScreenSupported(dpy, screen)) {
+                        vendor = NULL;
+                    }
+
+                    if (vendor != NULL) {
+                        break;
+                    }
+                }
+                free(queriedVendorNames);
+
+                if (vendor != NULL) {
+                    free(dpyInfo->cachedVendorNames[screen]);
+                    dpyInfo->cachedVendorNames[screen] = strdup(vendor->name);
+                    __glXWriteVendorScreenCache(dpy, dpyInfo->cachedVendorNames);
+                }
+            }
+        }
+    }
+
+    if (!vendor) {
+        vendor = __glXLookupVendorByName(FALLBACK_VENDOR_NAME);
+    }
+
+    DBG_PRINTF(10, "Found vendor \"%s\" for screen %d\n",
+               (vendor != NULL ? vendor->name : "NULL"), screen);
+
+    return vendor;
+}
+
+/*!
+ * Looks up the vendor for a screen, given the display's \c __GLXdisplayInfo.
+ *
+ * The caller must make sure that \p screen is valid.
+ */
+static __GLXvendorInfo *LookupVendorByScreenInfo(Display *dpy,
+        __GLXdisplayInfo *dpyInfo, int screen)
+{
+    __GLXvendorInfo *vendor;
+
+    // A screen's vendor never changes once it's set, so if we've already
+    // found it, we don't need to take the lock.
+    vendor = (__GLXvendorInfo *) glvndAtomicLoadAcquirePtr(
+            (void * volatile *) &dpyInfo->vendors[screen]);
+    if (vendor != NULL) {
+        return vendor;
+    }
+
+    __glvndPthreadFuncs.rwlock_wrlock(&dpyInfo->vendorLock);
+    vendor = dpyInfo->vendors[screen];
+    if (!vendor) {
+        vendor = ResolveVendorForScreen(dpy, dpyInfo, screen);
+        glvndAtomicStoreReleasePtr((void * volatile *) &dpyInfo->vendors[screen], vendor);
+    }
+    __glvndPthreadFuncs.rwlock_unlock(&dpyInfo->vendorLock);
+
+    return vendor;
+}
+
+__GLXvendorInfo *__glXLookupVendorByScreen(Display *dpy, const int screen)
+{
+    __GLXdisplayInfo *dpyInfo;
+
+    if (screen < 0 || screen >= ScreenCount(dpy)) {
+        return NULL;
+    }
+
+    dpyInfo = __glXLookupDisplay(dpy);
+    if (dpyInfo == NULL) {
+        return NULL;
+    }
+
+    return LookupVendorByScreenInfo(dpy, dpyInfo, screen);
+}
+
+int __glXLookupVendorsForAllScreens(Display *dpy, __GLXvendorInfo **vendors)
+{
+    __GLXdisplayInfo *dpyInfo;
+    int screenCount = ScreenCount(dpy);
+    int allFound = 1;
+    int screen;
+
+    dpyInfo = __glXLookupDisplay(dpy);
+    if (dpyInfo == NULL) {
+        return -1;
+    }
+
+    for (screen = 0; screen < screenCount; screen++) {
+        vendors[screen] = (__GLXvendorInfo *) glvndAtomicLoadAcquirePtr(
+                (void * volatile *) &dpyInfo->vendors[screen]);
+        if (vendors[screen] == NULL) {
+            allFound = 0;
+        }
+    }
+    if (allFound) {
+        return 0;
+    }
+
+    // Resolve every remaining screen with one lock. The first screen that
+    // needs it will fetch the vendor names for every screen in a single
+    // round trip, and each vendor library is only loaded once no matter how
+    // many screens use it.
+    __glvndPthreadFuncs.rwlock_wrlock(&dpyInfo->vendorLock);
+    for (screen = 0; screen < screenCount; screen++) {
+        vendors[screen] = dpyInfo->vendors[screen];
+        if (vendors[screen] == NULL) {
+            vendors[screen] = ResolveVendorForScreen(dpy, dpyInfo, screen);
+            glvndAtomicStoreReleasePtr((void * volatile *) &dpyInfo->vendors[screen],
+                    vendors[screen]);
+        }
+    }
+    __glvndPthreadFuncs.rwlock_unlock(&dpyInfo->vendorLock);
+
+    return 0;
+}
+
+void __glXPopulateVendorDispatchTables(void)
+{
+    __GLVNDhashMapIter iter;
+    __GLdispatchTable **tables;
+    void *value;
+    int count = 0;
+    int i;
+
+    // Collect the tables first, so that we aren't holding vendorNameLock
+    // while the vendors look up their functions. Vendors aren't unloaded
+    // until libGLX is torn down, so the tables stay valid.
+    glvndProfiledRWLockRead(&vendorNameLock, &vendorNameLockStats);
+    __glvndHashMapReadBegin();
+    tables = (__GLdispatchTable **) malloc(
+            __glvndHashMapCount(&__glXVendorNameHash) * sizeof(__GLdispatchTable *));
+    if (tables != NULL) {
+        __glvndHashMapIterInit(&__glXVendorNameHash, &iter);
+        while (__glvndHashMapIterNext(&iter, NULL, &value)) {
+            __GLXvendorNameHash *pEntry = (__GLXvendorNameHash *) value;
+            tables[count++] = pEntry->vendor.glDispatch;
+        }
+    }
+    __glvndHashMapReadEnd();
+    __glvndPthreadFuncs.rwlock_unlock(&vendorNameLock);
+
+    for (i=0; i<count; i++) {
+        __glDispatchPopulateTable(tables[i]);
+    }
+    free(tables);
+}
+
+__GLXvendorInfo *__glXGetDynDispatch(Display *dpy, const int screen)
+{
+    __glXThreadInitialize();
+
+    __GLXvendorInfo *vendor = __glXLookupVendorByScreen(dpy, screen);
+    return vendor;
+}
+
+/**
+ * Allocates and initializes a __GLXdisplayInfoHash structure.
+ *
+ * The caller is responsible for adding the structure to the hashtable.
+ *
+ * \param dpy The display connection.
+ * \return A newly-allocated __GLXdisplayInfoHash structure, or NULL on error.
+ */
+static __GLXdisplayInfoHash *InitDisplayInfoEntry(Display *dpy)
+{
+    __GLXdisplayInfoHash *pEntry;
+    size_t size;
+
+    size = sizeof(*pEntry) + ScreenCount(dpy) * (sizeof(__GLXvendorInfo *) + 2 * sizeof(char *));
+    pEntry = (__GLXdisplayInfoHash *) malloc(size);
+    if (pEntry == NULL) {
+        return NULL;
+    }
+    glvndMemStatsAlloc(GLVND_MEM_DISPLAY, size);
+
+    memset(pEntry, 0, size);
+    pEntry->info.dpy = dpy;
+    pEntry->info.vendors = (__GLXvendorInfo * volatile *) (pEntry + 1);
+    pEntry->info.vendorNames = (char **) (pEntry->info.vendors + ScreenCount(dpy));
+    pEntry->info.cachedVendorNames = pEntry->info.vendorNames + ScreenCount(dpy);
+
+    __glvndHashMapInit(&pEntry->info.xids, free);
+    __glvndHashMapInit(&pEntry->info.importedContexts, NULL);
+    __glvndPthreadFuncs.rwlock_init(&pEntry->info.vendorLock, NULL);
+    __glvndPthreadFuncs.mutex_init(&pEntry->info.serverInfoLock, NULL);
+    glvnd_list_init(&pEntry->info.fbconfigCache);
+    __glvndPthreadFuncs.mutex_init(&pEntry->info.fbconfigCacheLock, NULL);
+
+    // Check whether the server supports the GLX extension, and record the
+    // opcode, error, and event bases if it does. Everything else waits for
+    // __glXQueryServerInfo.
+    pEntry->info.glxSupported = XQueryExtension(dpy, GLX_EXTENSION_NAME,
+            &pEntry->info.glxMajorOpcode, &pEntry->info.glxFirstEvent,
+            &pEntry->info.glxFirstError);
+
+    return pEntry;
+}
+
+/**
+ * Frees a __GLXdisplayInfoHash structure.
+ *
+ * The caller is responsible for removing the structure from the hashtable.
+ *
+ * \param unused Ingored. Needed for the hashtable teardown function.
+ * \param value The structure to free.
+ */
+static void CleanupDisplayInfoEntry(void *unused, void *value)
+{
+    __GLXdisplayInfoHash *pEntry = (__GLXdisplayInfoHash *) value;
+    int i;
+
+    if (pEntry == NULL) {
+        return;
+    }
+
+    for (i=0; i<GLX_CLIENT_STRING_LAST_ATTRIB; i++) {
+        if (pEntry->info.clientStrings[i] != NULL) {
+            glvndMemStatsFree(GLVND_MEM_CLIENT_STRING,
+                    strlen(pEntry->info.clientStrings[i]) + 1);
+            free(pEntry->info.clientStrings[i]);
+        }
+    }
+    for (i=0; i<ScreenCount(pEntry->info.dpy); i++) {
+        free(pEntry->info.vendorNames[i]);
+        free(pEntry->info.cachedVendorNames[i]);
+    }
+
+    __glvndHashMapTeardown(&pEntry->info.xids, NULL, NULL, 0);
+    __glvndHashMapTeardown(&pEntry->info.importedContexts, NULL, NULL, 0);
+    FreeXIDRadix(&pEntry->info);
+    FreeFBConfigCache(&pEntry->info);
+}
+
+static void FreeDisplayInfoEntry(void *unused, void *value)
+{
+    __GLXdisplayInfoHash *pEntry = (__GLXdisplayInfoHash *) value;
+
+    if (pEntry == NULL) {
+        return;
+    }
+
+    CleanupDisplayInfoEntry(unused, value);
+    glvndMemStatsFree(GLVND_MEM_DISPLAY, sizeof(*pEntry) + ScreenCount(pEntry->info.dpy)
+            * (sizeof(__GLXvendorInfo *) + 2 * sizeof(char *)));
+    free(value);
+}
+
+static int OnDisplayClosed(Display *dpy, XExtCodes *codes)
+{
+    __GLXdisplayInfoHash *pEntry = NULL;
+
+    __glvndHashMapLock(&__glXDisplayInfoHash, &dpy, sizeof(dpy));
+
+    pEntry = (__GLXdisplayInfoHash *) __glvndHashMapFind(&__glXDisplayInfoHash,
+            &dpy, sizeof(dpy));
+    if (pEntry != NULL) {
+        __glXDisplayClosed(&pEntry->info);
+        __glvndHashMapRemove(&__glXDisplayInfoHash, &dpy, sizeof(dpy));
+        glvndAtomicStoreRelease(&displayInfoGeneration, displayInfoGeneration + 1);
+    }
+    __glvndHashMapUnlock(&__glXDisplayInfoHash, &dpy, sizeof(dpy));
+
+    FreeDisplayInfoEntry(NULL, pEntry);
 
     return 0;
 }
@@ -714,16 +1311,32 @@ __GLXdisplayInfo *__glXLookupDisplay(Display *dpy)
 {
     __GLXdisplayInfoHash *pEntry = NULL;
     __GLXdisplayInfoHash *foundEntry = NULL;
+#if defined(GLDISPATCH_USE_TLS)
+    int generation;
+#endif
 
     if (dpy == NULL) {
         return NULL;
     }
 
-    LKDHASH_RDLOCK(__glXDisplayInfoHash);
-    HASH_FIND_PTR(_LH(__glXDisplayInfoHash), &dpy, pEntry);
-    LKDHASH_UNLOCK(__glXDisplayInfoHash);
+#if defined(GLDISPATCH_USE_TLS)
+    generation = glvndAtomicLoadAcquire(&displayInfoGeneration);
+    if (cachedDisplayInfo.dpy == dpy && cachedDisplayInfo.generation == generation) {
+        return cachedDisplayInfo.dpyInfo;
+    }
+#endif
+
+    __glvndHashMapReadBegin();
+    pEntry = (__GLXdisplayInfoHash *) __glvndHashMapFind(&__glXDisplayInfoHash,
+            &dpy, sizeof(dpy));
+    __glvndHashMapReadEnd();
 
     if (pEntry != NULL) {
+#if defined(GLDISPATCH_USE_TLS)
+        cachedDisplayInfo.dpy = dpy;
+        cachedDisplayInfo.dpyInfo = &pEntry->info;
+        cachedDisplayInfo.generation = generation;
+#endif
         return &pEntry->info;
     }
 
@@ -735,123 +1348,512 @@ __GLXdisplayInfo *__glXLookupDisplay(Display *dpy)
         return NULL;
     }
 
-    LKDHASH_WRLOCK(__glXDisplayInfoHash);
-    HASH_FIND_PTR(_LH(__glXDisplayInfoHash), &dpy, foundEntry);
+    __glvndHashMapLock(&__glXDisplayInfoHash, &dpy, sizeof(dpy));
+    foundEntry = (__GLXdisplayInfoHash *) __glvndHashMapFind(&__glXDisplayInfoHash,
+            &dpy, sizeof(dpy));
     if (foundEntry == NULL) {
         XExtCodes *extCodes = XAddExtension(dpy);
-        if (extCodes == NULL) {
-            CleanupDisplayInfoEntry(NULL, pEntry);
-            free(pEntry);
-            LKDHASH_UNLOCK(__glXDisplayInfoHash);
+        if (extCodes == NULL || !__glvndHashMapInsert(&__glXDisplayInfoHash,
+                    &dpy, sizeof(dpy), pEntry)) {
+            FreeDisplayInfoEntry(NULL, pEntry);
+            __glvndHashMapUnlock(&__glXDisplayInfoHash, &dpy, sizeof(dpy));
             return NULL;
         }
 
         XESetCloseDisplay(dpy, extCodes->extension, OnDisplayClosed);
-        HASH_ADD_PTR(_LH(__glXDisplayInfoHash), info.dpy, pEntry);
     } else {
         // Another thread already created the hashtable entry.
-        CleanupDisplayInfoEntry(NULL, pEntry);
-        free(pEntry);
+        FreeDisplayInfoEntry(NULL, pEntry);
         pEntry = foundEntry;
     }
-    LKDHASH_UNLOCK(__glXDisplayInfoHash);
+    __glvndHashMapUnlock(&__glXDisplayInfoHash, &dpy, sizeof(dpy));
 
     return &pEntry->info;
 }
 
+/*!
+ * The most context IDs that we'll remember on one display. If an app imports
+ * more contexts than this, then the cache is emptied and starts over.
+ *
+ * Each value in \c importedContexts is a bit for whether the context is
+ * direct, and then the screen number plus one.
+ */
+#define IMPORTED_CONTEXT_MAX_COUNT 1024
+
+Bool __glXLookupImportedContext(__GLXdisplayInfo *dpyInfo,
+        GLXContextID contextID, Bool *isDirect, int *screen)
+{
+    intptr_t value;
+
+    __glvndHashMapReadBegin();
+    value = (intptr_t) __glvndHashMapFind(&dpyInfo->importedContexts,
+            &contextID, sizeof(contextID));
+    __glvndHashMapReadEnd();
+
+    if (value == 0) {
+        return False;
+    }
+    *isDirect = (value & 1) ? True : False;
+    *screen = (int) (value >> 1) - 1;
+    return True;
+}
+
+void __glXAddImportedContext(__GLXdisplayInfo *dpyInfo, GLXContextID contextID,
+        Bool isDirect, int screen)
+{
+    void *value = (void *) ((((intptr_t) screen + 1) << 1) | (isDirect ? 1 : 0));
+
+    if (value == NULL) {
+        // An indirect context with an unknown screen isn't worth recording.
+        return;
+    }
+
+    if (__glvndHashMapCount(&dpyInfo->importedContexts) >= IMPORTED_CONTEXT_MAX_COUNT) {
+        __glvndHashMapClear(&dpyInfo->importedContexts);
+    }
+
+    __glvndHashMapLock(&dpyInfo->importedContexts, &contextID, sizeof(contextID));
+    __glvndHashMapReplace(&dpyInfo->importedContexts, &contextID, sizeof(contextID),
+            value);
+    __glvndHashMapUnlock(&dpyInfo->importedContexts, &contextID, sizeof(contextID));
+}
+
+void __glXRemoveImportedContext(__GLXdisplayInfo *dpyInfo, GLXContextID contextID)
+{
+    __glvndHashMapLock(&dpyInfo->importedContexts, &contextID, sizeof(contextID));
+    __glvndHashMapRemove(&dpyInfo->importedContexts, &contextID, sizeof(contextID));
+    __glvndHashMapUnlock(&dpyInfo->importedContexts, &contextID, sizeof(contextID));
+}
+
 /****************************************************************************/
 /*
- * Define two hashtables to store the mappings for GLXFBConfig and GLXContext
- * handles to vendor libraries.
+ * The mapping from GLXFBConfig handles to vendor libraries.
+ *
+ * This is an open-addressed hashtable, and each slot holds a config and its
+ * vendor. Lookups don't take any lock. A slot's config goes from NULL to a
+ * handle and then never changes, so a reader can always stop at the first
+ * empty slot. Removing a config only sets the vendor to NULL. Anything that
+ * modifies the table must hold \c fbconfigTableMutex.
  *
- * The same functions are used to access both tables.
+ * Since the slots are part of the table, adding a config doesn't need to
+ * allocate anything unless the table has to grow. When it does, a new table
+ * is published in its place, and the old one is kept around until teardown,
+ * since another thread could still be reading it.
  */
 
 typedef struct {
-    GLXFBConfig config;
-    __GLXvendorInfo *vendor;
-    UT_hash_handle hh;
-} __GLXvendorConfigMappingHash;
+    void * volatile config;
+    void * volatile vendor;
+} __GLXvendorConfigMapping;
+
+typedef struct __GLXvendorConfigTableRec {
+    struct __GLXvendorConfigTableRec *retired;
+    size_t size;
+    size_t used;
+    __GLXvendorConfigMapping slots[];
+} __GLXvendorConfigTable;
+
+#define FBCONFIG_TABLE_INITIAL_SIZE 256
+
+static __GLXvendorConfigTable * volatile fbconfigTable = NULL;
+static glvnd_mutex_t fbconfigTableMutex = GLVND_MUTEX_INITIALIZER;
+
+static size_t FBConfigHash(GLXFBConfig config)
+{
+    uintptr_t val = (uintptr_t) config;
+
+    // The handles are usually heap pointers, so the low bits don't tell us
+    // much.
+    val ^= val >> 17;
+    val *= (uintptr_t) 0x9e3779b97f4a7c15ULL;
+    val ^= val >> 29;
+    return (size_t) val;
+}
+
+/**
+ * Looks up a config in a table, without taking any locks.
+ *
+ * The table must be less than full, which the writers guarantee.
+ *
+ * \return The slot for \p config, or the empty slot where it would go.
+ */
+static __GLXvendorConfigMapping *FindFBConfigSlot(__GLXvendorConfigTable *table,
+        GLXFBConfig config)
+{
+    size_t mask = table->size - 1;
+    size_t index = FBConfigHash(config) & mask;
+
+    while (1) {
+        void *slotConfig = glvndAtomicLoadAcquirePtr(&table->slots[index].config);
+        if (slotConfig == NULL || slotConfig == (void *) config) {
+            return &table->slots[index];
+        }
+        index = (index + 1) & mask;
+    }
+}
+
+/**
+ * Makes sure that the table has room for \p count more configs, replacing it
+ * with a larger one if needed.
+ *
+ * The caller must hold \c fbconfigTableMutex.
+ */
+static Bool ReserveFBConfigSlots(int count)
+{
+    __GLXvendorConfigTable *oldTable = fbconfigTable;
+    __GLXvendorConfigTable *newTable;
+    size_t size = FBCONFIG_TABLE_INITIAL_SIZE;
+    size_t needed = (size_t) count;
+    size_t i;
+
+    // Keep the table at most half full, counting removed configs.
+    if (oldTable != NULL) {
+        needed += oldTable->used;
+        if (needed * 2 <= oldTable->size) {
+            return True;
+        }
+        size = oldTable->size;
+    }
+    while (needed * 2 > size) {
+        size *= 2;
+    }
+
+    newTable = (__GLXvendorConfigTable *) calloc(1,
+            sizeof(*newTable) + size * sizeof(newTable->slots[0]));
+    if (newTable == NULL) {
+        return False;
+    }
+    newTable->size = size;
+    newTable->retired = oldTable;
+
+    if (oldTable != NULL) {
+        for (i=0; i<oldTable->size; i++) {
+            __GLXvendorConfigMapping *oldSlot = &oldTable->slots[i];
+            if (oldSlot->config != NULL && oldSlot->vendor != NULL) {
+                __GLXvendorConfigMapping *newSlot = FindFBConfigSlot(newTable, oldSlot->config);
+                newSlot->config = oldSlot->config;
+                newSlot->vendor = oldSlot->vendor;
+                newTable->used++;
+            }
+        }
+    }
+
+    glvndAtomicStoreReleasePtr((void * volatile *) &fbconfigTable, newTable);
+    return True;
+}
 
-static DEFINE_LKDHASH(__GLXvendorConfigMappingHash, fbconfigHashtable);
+/**
+ * Adds a config to the table. The caller must hold \c fbconfigTableMutex and
+ * have reserved a slot for it.
+ */
+static int AddFBConfigLocked(GLXFBConfig config, __GLXvendorInfo *vendor)
+{
+    __GLXvendorConfigMapping *slot = FindFBConfigSlot(fbconfigTable, config);
+
+    if (slot->config == NULL) {
+        slot->vendor = vendor;
+        fbconfigTable->used++;
+        glvndAtomicStoreReleasePtr(&slot->config, config);
+    } else if (slot->vendor == NULL) {
+        glvndAtomicStoreReleasePtr(&slot->vendor, vendor);
+    } else if (slot->vendor != vendor) {
+        // Any GLXContext or GLXFBConfig handles must be unique to a single
+        // vendor at a time. If we get two different vendors, then there's
+        // either a bug in libGLX or in at least one of the vendor libraries.
+        return -1;
+    }
+    return 0;
+}
 
 int __glXAddVendorFBConfigMapping(Display *dpy, GLXFBConfig config, __GLXvendorInfo *vendor)
 {
-    __GLXvendorConfigMappingHash *pEntry;
+    return __glXAddVendorFBConfigMappings(dpy, &config, 1, vendor);
+}
 
-    if (config == NULL) {
+int __glXAddVendorFBConfigMappings(Display *dpy, const GLXFBConfig *configs,
+        int count, __GLXvendorInfo *vendor)
+{
+    int ret = 0;
+    int i;
+
+    if (count <= 0) {
         return 0;
     }
 
     if (vendor == NULL) {
+        for (i=0; i<count; i++) {
+            if (configs[i] != NULL) {
+                return -1;
+            }
+        }
+        return 0;
+    }
+
+    __glvndPthreadFuncs.mutex_lock(&fbconfigTableMutex);
+
+    if (!ReserveFBConfigSlots(count)) {
+        __glvndPthreadFuncs.mutex_unlock(&fbconfigTableMutex);
         return -1;
     }
 
-    LKDHASH_WRLOCK(fbconfigHashtable);
+    for (i=0; i<count && ret == 0; i++) {
+        if (configs[i] != NULL) {
+            ret = AddFBConfigLocked(configs[i], vendor);
+        }
+    }
 
-    HASH_FIND_PTR(_LH(fbconfigHashtable), &config, pEntry);
+    __glvndPthreadFuncs.mutex_unlock(&fbconfigTableMutex);
+    return ret;
+}
 
-    if (pEntry == NULL) {
-        pEntry = malloc(sizeof(*pEntry));
-        if (pEntry == NULL) {
-            LKDHASH_UNLOCK(fbconfigHashtable);
-            return -1;
+void __glXRemoveVendorFBConfigMapping(Display *dpy, GLXFBConfig config)
+{
+    if (config == NULL) {
+        return;
+    }
+
+    __glvndPthreadFuncs.mutex_lock(&fbconfigTableMutex);
+    if (fbconfigTable != NULL) {
+        __GLXvendorConfigMapping *slot = FindFBConfigSlot(fbconfigTable, config);
+        if (slot->config != NULL) {
+            glvndAtomicStoreReleasePtr(&slot->vendor, NULL);
         }
-        pEntry->config = config;
-        pEntry->vendor = vendor;
-        HASH_ADD_PTR(_LH(fbconfigHashtable), config, pEntry);
-    } else {
-        // Any GLXContext or GLXFBConfig handles must be unique to a single
-        // vendor at a time. If we get two different vendors, then there's
-        // either a bug in libGLX or in at least one of the vendor libraries.
-        if (pEntry->vendor != vendor) {
-            LKDHASH_UNLOCK(fbconfigHashtable);
-            return -1;
+    }
+    __glvndPthreadFuncs.mutex_unlock(&fbconfigTableMutex);
+
+    // A cached glXGetFBConfigs result might include the config, and a cache
+    // hit doesn't add its configs back to the table.
+    if (dpy != NULL) {
+        __glXInvalidateFBConfigCache(dpy, -1);
+    }
+}
+
+/**
+ * The number of results that each display keeps in its
+ * glXGetFBConfigs/glXChooseFBConfig cache.
+ */
+#define FBCONFIG_CACHE_MAX_ENTRIES 32
+
+/**
+ * The longest attribute list, in ints, that the cache will keep. Anything
+ * longer than that is almost certainly not going to be repeated.
+ */
+#define FBCONFIG_CACHE_MAX_ATTRIBS 256
+
+typedef struct __GLXfbconfigCacheEntryRec {
+    struct glvnd_list entry;
+    int screen;
+
+    /// The length of the attribute list, not counting the terminating None,
+    /// or -1 for glXGetFBConfigs.
+    int attribCount;
+    int configCount;
+    int *attribs;
+    GLXFBConfig *configs;
+} __GLXfbconfigCacheEntry;
+
+/**
+ * Returns the length of a glXChooseFBConfig attribute list, not counting the
+ * terminating None, or -1 for glXGetFBConfigs. Returns -2 if the list is too
+ * long to cache.
+ */
+static int GetFBConfigCacheAttribCount(Bool choose, const int *attribs)
+{
+    int count = 0;
+
+    if (!choose) {
+        return -1;
+    }
+    if (attribs == NULL) {
+        return 0;
+    }
+    while (attribs[count] != None) {
+        count += 2;
+        if (count > FBCONFIG_CACHE_MAX_ATTRIBS) {
+            return -2;
         }
     }
+    return count;
+}
 
-    LKDHASH_UNLOCK(fbconfigHashtable);
-    return 0;
+static size_t GetFBConfigCacheEntrySize(const __GLXfbconfigCacheEntry *cacheEntry)
+{
+    int attribCount = (cacheEntry->attribCount > 0 ? cacheEntry->attribCount : 0);
+    return sizeof(*cacheEntry) + attribCount * sizeof(int)
+        + cacheEntry->configCount * sizeof(GLXFBConfig);
 }
 
-void __glXRemoveVendorFBConfigMapping(Display *dpy, GLXFBConfig config)
+static void FreeFBConfigCacheEntry(__GLXfbconfigCacheEntry *cacheEntry)
 {
-    __GLXvendorConfigMappingHash *pEntry;
+    glvnd_list_del(&cacheEntry->entry);
+    glvndMemStatsFree(GLVND_MEM_DISPLAY, GetFBConfigCacheEntrySize(cacheEntry));
+    free(cacheEntry);
+}
 
-    if (config == NULL) {
+/**
+ * Frees every entry in a display's config cache. The caller must hold
+ * \c dpyInfo->fbconfigCacheLock, or otherwise be the only thread using the
+ * display.
+ */
+static void FreeFBConfigCache(__GLXdisplayInfo *dpyInfo)
+{
+    __GLXfbconfigCacheEntry *cacheEntry, *tmp;
+
+    glvnd_list_for_each_entry_safe(cacheEntry, tmp, &dpyInfo->fbconfigCache, entry) {
+        FreeFBConfigCacheEntry(cacheEntry);
+    }
+    dpyInfo->fbconfigCacheCount = 0;
+}
+
+GLXFBConfig *__glXLookupCachedFBConfigs(Display *dpy, int screen, Bool choose,
+        const int *attribs, int *nelements, unsigned int *generation)
+{
+    __GLXdisplayInfo *dpyInfo = __glXLookupDisplay(dpy);
+    __GLXfbconfigCacheEntry *cacheEntry;
+    GLXFBConfig *configs = NULL;
+    int attribCount = GetFBConfigCacheAttribCount(choose, attribs);
+
+    *generation = 0;
+    if (dpyInfo == NULL) {
+        return NULL;
+    }
+
+    __glvndPthreadFuncs.mutex_lock(&dpyInfo->fbconfigCacheLock);
+    *generation = dpyInfo->fbconfigCacheGeneration;
+    if (attribCount < -1) {
+        __glvndPthreadFuncs.mutex_unlock(&dpyInfo->fbconfigCacheLock);
+        return NULL;
+    }
+
+    glvnd_list_for_each_entry(cacheEntry, &dpyInfo->fbconfigCache, entry) {
+        if (cacheEntry->screen == screen
+                && cacheEntry->attribCount == attribCount
+                && (attribCount <= 0 || memcmp(cacheEntry->attribs, attribs,
+                        attribCount * sizeof(int)) == 0)) {
+            // The caller frees the array with XFree, so it has to be a copy.
+            configs = malloc(cacheEntry->configCount * sizeof(GLXFBConfig));
+            if (configs != NULL) {
+                memcpy(configs, cacheEntry->configs,
+                        cacheEntry->configCount * sizeof(GLXFBConfig));
+                *nelements = cacheEntry->configCount;
+                glvnd_list_del(&cacheEntry->entry);
+                glvnd_list_add(&cacheEntry->entry, &dpyInfo->fbconfigCache);
+            }
+            break;
+        }
+    }
+    __glvndPthreadFuncs.mutex_unlock(&dpyInfo->fbconfigCacheLock);
+
+    return configs;
+}
+
+void __glXAddCachedFBConfigs(Display *dpy, int screen, Bool choose,
+        const int *attribs, const GLXFBConfig *configs, int count,
+        unsigned int generation)
+{
+    __GLXdisplayInfo *dpyInfo;
+    __GLXfbconfigCacheEntry *cacheEntry;
+    int attribCount = GetFBConfigCacheAttribCount(choose, attribs);
+    size_t size;
+
+    if (attribCount < -1 || configs == NULL || count <= 0) {
+        return;
+    }
+    dpyInfo = __glXLookupDisplay(dpy);
+    if (dpyInfo == NULL) {
         return;
     }
 
-    LKDHASH_WRLOCK(fbconfigHashtable);
+    size = sizeof(*cacheEntry) + (attribCount > 0 ? attribCount : 0) * sizeof(int)
+        + count * sizeof(GLXFBConfig);
+    cacheEntry = (__GLXfbconfigCacheEntry *) malloc(size);
+    if (cacheEntry == NULL) {
+        return;
+    }
+    cacheEntry->screen = screen;
+    cacheEntry->attribCount = attribCount;
+    cacheEntry->configCount = count;
+    cacheEntry->configs = (GLXFBConfig *) (cacheEntry + 1);
+    cacheEntry->attribs = (int *) (cacheEntry->configs + count);
+    memcpy(cacheEntry->configs, configs, count * sizeof(GLXFBConfig));
+    if (attribCount > 0) {
+        memcpy(cacheEntry->attribs, attribs, attribCount * sizeof(int));
+    }
 
-    HASH_FIND_PTR(_LH(fbconfigHashtable), &config, pEntry);
+    __glvndPthreadFuncs.mutex_lock(&dpyInfo->fbconfigCacheLock);
+    if (dpyInfo->fbconfigCacheGeneration != generation) {
+        __glvndPthreadFuncs.mutex_unlock(&dpyInfo->fbconfigCacheLock);
+        free(cacheEntry);
+        return;
+    }
 
-    if (pEntry != NULL) {
-        HASH_DELETE(hh, _LH(fbconfigHashtable), pEntry);
-        free(pEntry);
+    glvndMemStatsAlloc(GLVND_MEM_DISPLAY, size);
+    glvnd_list_add(&cacheEntry->entry, &dpyInfo->fbconfigCache);
+    if (++dpyInfo->fbconfigCacheCount > FBCONFIG_CACHE_MAX_ENTRIES) {
+        FreeFBConfigCacheEntry(glvnd_list_last_entry(&dpyInfo->fbconfigCache,
+                    __GLXfbconfigCacheEntry, entry));
+        dpyInfo->fbconfigCacheCount--;
     }
+    __glvndPthreadFuncs.mutex_unlock(&dpyInfo->fbconfigCacheLock);
+}
 
-    LKDHASH_UNLOCK(fbconfigHashtable);
+void __glXInvalidateFBConfigCache(Display *dpy, int screen)
+{
+    __GLXdisplayInfo *dpyInfo = __glXLookupDisplay(dpy);
+    __GLXfbconfigCacheEntry *cacheEntry, *tmp;
+
+    if (dpyInfo == NULL) {
+        return;
+    }
+
+    __glvndPthreadFuncs.mutex_lock(&dpyInfo->fbconfigCacheLock);
+    dpyInfo->fbconfigCacheGeneration++;
+    glvnd_list_for_each_entry_safe(cacheEntry, tmp, &dpyInfo->fbconfigCache, entry) {
+        if (screen < 0 || cacheEntry->screen == screen) {
+            FreeFBConfigCacheEntry(cacheEntry);
+            dpyInfo->fbconfigCacheCount--;
+        }
+    }
+    __glvndPthreadFuncs.mutex_unlock(&dpyInfo->fbconfigCacheLock);
 }
 
 __GLXvendorInfo *__glXVendorFromFBConfig(Display *dpy, GLXFBConfig config)
 {
-    __GLXvendorConfigMappingHash *pEntry;
-    __GLXvendorInfo *vendor = NULL;
+    __GLXvendorConfigTable *table;
+    __GLXvendorConfigMapping *slot;
 
     __glXThreadInitialize();
 
-    LKDHASH_RDLOCK(fbconfigHashtable);
+    if (config == NULL) {
+        return NULL;
+    }
 
-    HASH_FIND_PTR(_LH(fbconfigHashtable), &config, pEntry);
+    table = (__GLXvendorConfigTable *) glvndAtomicLoadAcquirePtr(
+            (void * volatile *) &fbconfigTable);
+    if (table == NULL) {
+        return NULL;
+    }
 
-    if (pEntry != NULL) {
-        vendor = pEntry->vendor;
+    slot = FindFBConfigSlot(table, config);
+    if (slot->config == NULL) {
+        return NULL;
     }
+    return (__GLXvendorInfo *) glvndAtomicLoadAcquirePtr(&slot->vendor);
+}
 
-    LKDHASH_UNLOCK(fbconfigHashtable);
+/**
+ * Frees the config table, along with any retired tables.
+ */
+static void FreeFBConfigTable(void)
+{
+    __GLXvendorConfigTable *table = fbconfigTable;
 
-    return vendor;
+    while (table != NULL) {
+        __GLXvendorConfigTable *next = table->retired;
+        free(table);
+        table = next;
+    }
+    fbconfigTable = NULL;
 }
 
 
@@ -859,12 +1861,229 @@ __GLXvendorInfo *__glXVendorFromFBConfig(Display *dpy, GLXFBConfig config)
 /****************************************************************************/
 /*
  * __GLXvendorXIDMappingHash is a hash table which maps XIDs to vendors.
+ * Most drawables go in a radix index instead (see __GLXxidRadixRoot), and the
+ * hash table holds the rest, along with the XIDs that aren't drawables.
  */
 
 
+static uint64_t GetTimeMS(void)
+{
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0) {
+        return 0;
+    }
+    return ((uint64_t) ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+}
+
+/*!
+ * Returns the radix slot for \p xid, or NULL if it doesn't have one.
+ *
+ * If \p create is true, then this allocates the root and leaf for the slot
+ * if they don't exist yet. It can still return NULL if every root is taken
+ * by another base, or if it runs out of memory.
+ */
+static __GLXvendorInfo * volatile *GetXIDRadixSlot(__GLXdisplayInfo *dpyInfo,
+        XID xid, Bool create)
+{
+    XID base = xid >> XID_RADIX_LOW_BITS;
+    unsigned int low = xid & ((1U << XID_RADIX_LOW_BITS) - 1);
+    __GLXxidRadixRoot *root = NULL;
+    __GLXxidRadixLeaf *leaf;
+    int i;
+
+    for (i=0; i<GLX_XID_RADIX_BASE_COUNT; i++) {
+        root = (__GLXxidRadixRoot *) glvndAtomicLoadAcquirePtr(
+                (void * volatile *) &dpyInfo->xidRadix[i]);
+        if (root == NULL) {
+            __GLXxidRadixRoot *newRoot;
+
+            if (!create) {
+                return NULL;
+            }
+            newRoot = (__GLXxidRadixRoot *) calloc(1, sizeof(*newRoot));
+            if (newRoot == NULL) {
+                return NULL;
+            }
+            newRoot->base = base;
+            if (glvndAtomicCompareExchangePtr((void * volatile *) &dpyInfo->xidRadix[i],
+                        NULL, newRoot)) {
+                glvndMemStatsAlloc(GLVND_MEM_DISPLAY, sizeof(*newRoot));
+                root = newRoot;
+            } else {
+                // Another thread added a root first, which might be for the
+                // same base.
+                free(newRoot);
+                root = (__GLXxidRadixRoot *) glvndAtomicLoadAcquirePtr(
+                        (void * volatile *) &dpyInfo->xidRadix[i]);
+            }
+        }
+        if (root->base == base) {
+            break;
+        }
+        root = NULL;
+    }
+    if (root == NULL) {
+        return NULL;
+    }
+
+    leaf = (__GLXxidRadixLeaf *) glvndAtomicLoadAcquirePtr(
+            (void * volatile *) &root->leaves[low >> XID_RADIX_LEAF_BITS]);
+    if (leaf == NULL) {
+        __GLXxidRadixLeaf *newLeaf;
+
+        if (!create) {
+            return NULL;
+        }
+        newLeaf = (__GLXxidRadixLeaf *) calloc(1, sizeof(*newLeaf));
+        if (newLeaf == NULL) {
+            return NULL;
+        }
+        if (glvndAtomicCompareExchangePtr(
+                    (void * volatile *) &root->leaves[low >> XID_RADIX_LEAF_BITS],
+                    NULL, newLeaf)) {
+            glvndMemStatsAlloc(GLVND_MEM_DISPLAY, sizeof(*newLeaf));
+            leaf = newLeaf;
+        } else {
+            free(newLeaf);
+            leaf = (__GLXxidRadixLeaf *) glvndAtomicLoadAcquirePtr(
+                    (void * volatile *) &root->leaves[low >> XID_RADIX_LEAF_BITS]);
+        }
+    }
+
+    return &leaf->vendors[low & (XID_RADIX_LEAF_SIZE - 1)];
+}
+
+static __GLXvendorInfo *LookupXIDRadix(__GLXdisplayInfo *dpyInfo, XID xid)
+{
+    __GLXvendorInfo * volatile *slot = GetXIDRadixSlot(dpyInfo, xid, False);
+
+    if (slot == NULL) {
+        return NULL;
+    }
+    return (__GLXvendorInfo *) glvndAtomicLoadAcquirePtr((void * volatile *) slot);
+}
+
+static void FreeXIDRadix(__GLXdisplayInfo *dpyInfo)
+{
+    int i, j;
+
+    for (i=0; i<GLX_XID_RADIX_BASE_COUNT; i++) {
+        __GLXxidRadixRoot *root = dpyInfo->xidRadix[i];
+        if (root == NULL) {
+            continue;
+        }
+        for (j=0; j<XID_RADIX_ROOT_SIZE; j++) {
+            if (root->leaves[j] != NULL) {
+                glvndMemStatsFree(GLVND_MEM_DISPLAY, sizeof(__GLXxidRadixLeaf));
+                free(root->leaves[j]);
+            }
+        }
+        glvndMemStatsFree(GLVND_MEM_DISPLAY, sizeof(*root));
+        free(root);
+        dpyInfo->xidRadix[i] = NULL;
+    }
+}
+
+static void AddXIDMissCount(__GLXdisplayInfo *dpyInfo, int delta)
+{
+    int old;
+    do {
+        old = glvndAtomicLoadAcquire(&dpyInfo->xidMissCount);
+    } while (!glvndAtomicCompareExchange(&dpyInfo->xidMissCount, old, old + delta));
+}
+
+/*!
+ * Removes every entry that records an invalid XID.
+ *
+ * An app that hits as many invalid drawables as \c XID_MISS_MAX_COUNT is
+ * unusual enough that we don't need anything smarter.
+ */
+static void EvictXIDMisses(__GLXdisplayInfo *dpyInfo)
+{
+    __GLVNDhashMapIter iter;
+    const void *key;
+    void *value;
+    int removed = 0;
+
+    __glvndHashMapLockAll(&dpyInfo->xids);
+    __glvndHashMapIterInit(&dpyInfo->xids, &iter);
+    while (__glvndHashMapIterNext(&iter, &key, &value)) {
+        __GLXvendorXIDMappingHash *pEntry = (__GLXvendorXIDMappingHash *) value;
+        if (pEntry->vendor == NULL) {
+            __glvndHashMapRemove(&dpyInfo->xids, key, sizeof(XID));
+            removed++;
+        }
+    }
+    AddXIDMissCount(dpyInfo, -removed);
+    __glvndHashMapUnlockAll(&dpyInfo->xids);
+}
+
+/*!
+ * Replaces the entry for an XID.
+ *
+ * The caller must hold the XID's lock.
+ *
+ * \return Non-zero on success, or zero if we couldn't allocate the entry. On
+ * failure, the old entry is left in place.
+ */
+static int ReplaceXIDEntry(__GLXdisplayInfo *dpyInfo, XID xid,
+        __GLXvendorInfo *vendor, uint64_t missExpireTime)
+{
+    __GLXvendorXIDMappingHash *pEntry = malloc(sizeof(*pEntry));
+
+    if (pEntry == NULL) {
+        return 0;
+    }
+    pEntry->vendor = vendor;
+    pEntry->missExpireTime = missExpireTime;
+
+    if (!__glvndHashMapReplace(&dpyInfo->xids, &xid, sizeof(xid), pEntry)) {
+        free(pEntry);
+        return 0;
+    }
+    return 1;
+}
+
+/*!
+ * Records that the server said \p xid isn't a valid drawable.
+ */
+static void AddXIDMiss(__GLXdisplayInfo *dpyInfo, XID xid)
+{
+    __GLXvendorXIDMappingHash *pEntry;
+    uint64_t now = GetTimeMS();
+
+    if (xid == None) {
+        return;
+    }
+
+    if (glvndAtomicLoadAcquire(&dpyInfo->xidMissCount) >= XID_MISS_MAX_COUNT) {
+        // Make room by throwing out every miss that we've recorded.
+        EvictXIDMisses(dpyInfo);
+    }
+
+    __glvndHashMapLock(&dpyInfo->xids, &xid, sizeof(xid));
+
+    pEntry = (__GLXvendorXIDMappingHash *) __glvndHashMapFind(&dpyInfo->xids,
+            &xid, sizeof(xid));
+    if (LookupXIDRadix(dpyInfo, xid) != NULL) {
+        // Like a mapping in the hashtable, a known drawable is left alone.
+    } else if (pEntry == NULL) {
+        if (ReplaceXIDEntry(dpyInfo, xid, NULL, now + XID_MISS_TIMEOUT_MS)) {
+            AddXIDMissCount(dpyInfo, 1);
+        }
+    } else if (pEntry->vendor == NULL) {
+        ReplaceXIDEntry(dpyInfo, xid, NULL, now + XID_MISS_TIMEOUT_MS);
+    }
+
+    __glvndHashMapUnlock(&dpyInfo->xids, &xid, sizeof(xid));
+}
+
 static int AddVendorXIDMapping(Display *dpy, __GLXdisplayInfo *dpyInfo, XID xid, __GLXvendorInfo *vendor)
 {
     __GLXvendorXIDMappingHash *pEntry = NULL;
+    __GLXvendorInfo * volatile *slot;
+    int ret = 0;
 
     if (xid == None) {
         return 0;
@@ -874,51 +2093,77 @@ static int AddVendorXIDMapping(Display *dpy, __GLXdisplayInfo *dpyInfo, XID xid,
         return -1;
     }
 
-    LKDHASH_WRLOCK(dpyInfo->xidVendorHash);
+    __glvndHashMapLock(&dpyInfo->xids, &xid, sizeof(xid));
 
-    HASH_FIND(hh, _LH(dpyInfo->xidVendorHash), &xid, sizeof(xid), pEntry);
+    pEntry = (__GLXvendorXIDMappingHash *) __glvndHashMapFind(&dpyInfo->xids,
+            &xid, sizeof(xid));
+    slot = GetXIDRadixSlot(dpyInfo, xid, True);
 
-    if (pEntry == NULL) {
-        pEntry = malloc(sizeof(*pEntry));
-        if (pEntry == NULL) {
-            LKDHASH_UNLOCK(dpyInfo->xidVendorHash);
-            return -1;
+    if (slot != NULL && (pEntry == NULL || pEntry->vendor == NULL)) {
+        __GLXvendorInfo *oldVendor = (__GLXvendorInfo *) *slot;
+
+        if (oldVendor == NULL) {
+            glvndAtomicStoreReleasePtr((void * volatile *) slot, vendor);
+            if (pEntry != NULL) {
+                // Drop the record of the XID being invalid, since it's a
+                // drawable now.
+                AddXIDMissCount(dpyInfo, -1);
+                __glvndHashMapRemove(&dpyInfo->xids, &xid, sizeof(xid));
+            }
+        } else if (oldVendor != vendor) {
+            ret = -1;
+        }
+    } else if (pEntry == NULL) {
+        if (!ReplaceXIDEntry(dpyInfo, xid, vendor, 0)) {
+            ret = -1;
+        }
+    } else if (pEntry->vendor == NULL) {
+        // The XID was invalid the last time we checked, but now it's been
+        // created as a drawable.
+        if (ReplaceXIDEntry(dpyInfo, xid, vendor, 0)) {
+            AddXIDMissCount(dpyInfo, -1);
+        } else {
+            ret = -1;
         }
-        pEntry->xid = xid;
-        pEntry->vendor = vendor;
-        HASH_ADD(hh, _LH(dpyInfo->xidVendorHash), xid, sizeof(xid), pEntry);
     } else {
         // Like GLXContext and GLXFBConfig handles, any GLXDrawables must map
         // to a single vendor library.
         if (pEntry->vendor != vendor) {
-            LKDHASH_UNLOCK(dpyInfo->xidVendorHash);
-            return -1;
+            ret = -1;
         }
     }
 
-    LKDHASH_UNLOCK(dpyInfo->xidVendorHash);
-    return 0;
+    __glvndHashMapUnlock(&dpyInfo->xids, &xid, sizeof(xid));
+    return ret;
 }
 
 
 static void RemoveVendorXIDMapping(Display *dpy, __GLXdisplayInfo *dpyInfo, XID xid)
 {
     __GLXvendorXIDMappingHash *pEntry;
+    __GLXvendorInfo * volatile *slot;
 
     if (xid == None) {
         return;
     }
 
-    LKDHASH_WRLOCK(dpyInfo->xidVendorHash);
+    __glvndHashMapLock(&dpyInfo->xids, &xid, sizeof(xid));
 
-    HASH_FIND(hh, _LH(dpyInfo->xidVendorHash), &xid, sizeof(xid), pEntry);
+    slot = GetXIDRadixSlot(dpyInfo, xid, False);
+    if (slot != NULL) {
+        glvndAtomicStoreReleasePtr((void * volatile *) slot, NULL);
+    }
 
+    pEntry = (__GLXvendorXIDMappingHash *) __glvndHashMapFind(&dpyInfo->xids,
+            &xid, sizeof(xid));
     if (pEntry != NULL) {
-        HASH_DELETE(hh, _LH(dpyInfo->xidVendorHash), pEntry);
-        free(pEntry);
+        if (pEntry->vendor == NULL) {
+            AddXIDMissCount(dpyInfo, -1);
+        }
+        __glvndHashMapRemove(&dpyInfo->xids, &xid, sizeof(xid));
     }
 
-    LKDHASH_UNLOCK(dpyInfo->xidVendorHash);
+    __glvndHashMapUnlock(&dpyInfo->xids, &xid, sizeof(xid));
 }
 
 
@@ -927,20 +2172,38 @@ static void VendorFromXID(Display *dpy, __GLXdisplayInfo *dpyInfo, XID xid,
 {
     __GLXvendorXIDMappingHash *pEntry;
     __GLXvendorInfo *vendor = NULL;
+    uint64_t missExpireTime = 0;
+    Bool found = False;
 
-    LKDHASH_RDLOCK(dpyInfo->xidVendorHash);
-
-    HASH_FIND(hh, _LH(dpyInfo->xidVendorHash), &xid, sizeof(xid), pEntry);
+    vendor = LookupXIDRadix(dpyInfo, xid);
+    if (vendor != NULL) {
+        if (retVendor != NULL) {
+            *retVendor = vendor;
+        }
+        return;
+    }
 
+    __glvndHashMapReadBegin();
+    pEntry = (__GLXvendorXIDMappingHash *) __glvndHashMapFind(&dpyInfo->xids,
+            &xid, sizeof(xid));
     if (pEntry) {
         vendor = pEntry->vendor;
-        LKDHASH_UNLOCK(dpyInfo->xidVendorHash);
-    } else {
-        LKDHASH_UNLOCK(dpyInfo->xidVendorHash);
+        missExpireTime = pEntry->missExpireTime;
+        found = True;
+    }
+    __glvndHashMapReadEnd();
+
+    if (found && vendor == NULL && GetTimeMS() >= missExpireTime) {
+        found = False;
+    }
 
+    if (!found) {
+        __glXQueryServerInfo(dpyInfo);
         if (dpyInfo->libglvndExtensionSupported) {
             int screen = __glXGetDrawableScreen(dpyInfo, xid);
-            if (screen >= 0 && screen < ScreenCount(dpy)) {
+            if (screen < 0) {
+                AddXIDMiss(dpyInfo, xid);
+            } else if (screen < ScreenCount(dpy)) {
                 vendor = __glXLookupVendorByScreen(dpy, screen);
                 if (vendor != NULL) {
                     // Note that if this fails, it's not necessarily a problem.
@@ -961,6 +2224,12 @@ int __glXAddVendorDrawableMapping(Display *dpy, GLXDrawable drawable, __GLXvendo
 {
     __GLXdisplayInfo *dpyInfo = __glXLookupDisplay(dpy);
     if (dpyInfo != NULL) {
+        __glXQueryServerInfo(dpyInfo);
+        if (!dpyInfo->libglvndExtensionSupported) {
+            // __glXVendorFromDrawable never looks at the mapping in this
+            // case, so don't bother recording it.
+            return 0;
+        }
         return AddVendorXIDMapping(dpy, dpyInfo, drawable, vendor);
     } else {
         return -1;
@@ -984,11 +2253,16 @@ __GLXvendorInfo *__glXVendorFromDrawable(Display *dpy, GLXDrawable drawable)
     __GLXdisplayInfo *dpyInfo = __glXLookupDisplay(dpy);
     __GLXvendorInfo *vendor = NULL;
     if (dpyInfo != NULL) {
+        __glXQueryServerInfo(dpyInfo);
         if (dpyInfo->libglvndExtensionSupported) {
             VendorFromXID(dpy, dpyInfo, drawable, &vendor);
         } else {
-            // We'll use the same vendor for every screen in this case.
-            vendor = __glXLookupVendorByScreen(dpy, 0);
+            // Without GLX_EXT_libglvnd, we use screen 0's vendor for every
+            // drawable on the display, so there's no need to look up or
+            // record the drawable at all. We've already got dpyInfo, so go
+            // straight to the vendor array instead of looking up the display
+            // again.
+            vendor = LookupVendorByScreenInfo(dpy, dpyInfo, 0);
         }
     }
 
@@ -999,10 +2273,22 @@ void __glXMappingInit(void)
 {
     int i;
 
+    glvndRWLockInitWriterPreferred(&vendorNameLock);
     __glvndWinsysDispatchInit();
 
+    __glDispatchRegisterLockStats("GLX", "vendorNameLock",
+            &vendorNameLockStats, 1);
+    __glDispatchRegisterLockStats("GLX", "vendorNameHash",
+            __glXVendorNameHash.lockStats, GLVND_HASHMAP_LOCK_COUNT);
+    __glDispatchRegisterLockStats("GLX", "displayInfoHash",
+            __glXDisplayInfoHash.lockStats, GLVND_HASHMAP_LOCK_COUNT);
+
     // Add all of the GLX dispatch stubs that are defined in libGLX itself.
     for (i=0; LOCAL_GLX_DISPATCH_FUNCTIONS[i].name != NULL; i++) {
+        // glXGetProcAddress does a binary search on this list.
+        assert(i == 0 || strcmp(LOCAL_GLX_DISPATCH_FUNCTIONS[i - 1].name,
+                    LOCAL_GLX_DISPATCH_FUNCTIONS[i].name) < 0);
+
         // TODO: Is there any way to recover from a malloc failure here?
         __glvndWinsysDispatchAllocIndex(
                 LOCAL_GLX_DISPATCH_FUNCTIONS[i].name,
@@ -1018,7 +2304,8 @@ void __glXMappingTeardown(Bool doReset)
 {
 
     if (doReset) {
-        __GLXdisplayInfoHash *dpyInfoEntry, *dpyInfoTmp;
+        __GLVNDhashMapIter iter;
+        void *value;
 
         /*
          * If we're just doing fork recovery, we don't actually want to unload
@@ -1027,41 +2314,61 @@ void __glXMappingTeardown(Bool doReset)
          * tries using pointers/XIDs that were created in the parent).  Just
          * reset the corresponding locks.
          */
-        __glvndPthreadFuncs.rwlock_init(&fbconfigHashtable.lock, NULL);
-        __glvndPthreadFuncs.rwlock_init(&__glXVendorNameHash.lock, NULL);
-        __glvndPthreadFuncs.rwlock_init(&__glXDisplayInfoHash.lock, NULL);
-
-        HASH_ITER(hh, _LH(__glXDisplayInfoHash), dpyInfoEntry, dpyInfoTmp) {
-            __glvndPthreadFuncs.rwlock_init(&dpyInfoEntry->info.xidVendorHash.lock, NULL);
+        __glvndPthreadFuncs.mutex_init(&fbconfigTableMutex, NULL);
+        glvndRWLockInitWriterPreferred(&vendorNameLock);
+        __glvndHashMapReset(&__glXVendorNameHash);
+        __glvndHashMapReset(&dispatchNameHash);
+
+        // Any vendor that another thread was loading will never finish, so
+        // forget about it. The next lookup will load it again.
+        __glvndPthreadFuncs.mutex_init(&vendorLoadingMutex, NULL);
+        glvnd_list_init(&vendorLoadingList);
+        __glvndHashMapReset(&__glXDisplayInfoHash);
+
+        __glvndHashMapReadBegin();
+        __glvndHashMapIterInit(&__glXDisplayInfoHash, &iter);
+        while (__glvndHashMapIterNext(&iter, NULL, &value)) {
+            __GLXdisplayInfoHash *dpyInfoEntry = (__GLXdisplayInfoHash *) value;
+            __glvndHashMapReset(&dpyInfoEntry->info.xids);
+            __glvndHashMapReset(&dpyInfoEntry->info.importedContexts);
             __glvndPthreadFuncs.rwlock_init(&dpyInfoEntry->info.vendorLock, NULL);
+            __glvndPthreadFuncs.mutex_init(&dpyInfoEntry->info.serverInfoLock, NULL);
+            __glvndPthreadFuncs.mutex_init(&dpyInfoEntry->info.fbconfigCacheLock, NULL);
         }
+        __glvndHashMapReadEnd();
     } else {
-        __GLXvendorNameHash *pEntry, *tmp;
+        __GLVNDhashMapIter iter;
+        void *value;
 
         /* Tear down all hashtables used in this file */
         __glvndWinsysDispatchCleanup();
 
         // If a GLX vendor library has patched the OpenGL entrypoints, then
         // unpatch them before we unload the vendors.
-        LKDHASH_RDLOCK(__glXVendorNameHash);
-        HASH_ITER(hh, _LH(__glXVendorNameHash), pEntry, tmp) {
+        glvndProfiledRWLockRead(&vendorNameLock, &vendorNameLockStats);
+        __glvndHashMapReadBegin();
+        __glvndHashMapIterInit(&__glXVendorNameHash, &iter);
+        while (__glvndHashMapIterNext(&iter, NULL, &value)) {
+            __GLXvendorNameHash *pEntry = (__GLXvendorNameHash *) value;
             __glDispatchForceUnpatch(pEntry->vendor.vendorID);
         }
-        LKDHASH_UNLOCK(__glXVendorNameHash);
+        __glvndHashMapReadEnd();
+        __glvndPthreadFuncs.rwlock_unlock(&vendorNameLock);
 
-        LKDHASH_TEARDOWN(__GLXvendorConfigMappingHash,
-                         fbconfigHashtable, NULL, NULL, False);
+        __glvndPthreadFuncs.mutex_lock(&fbconfigTableMutex);
+        FreeFBConfigTable();
+        __glvndPthreadFuncs.mutex_unlock(&fbconfigTableMutex);
 
-        LKDHASH_TEARDOWN(__GLXdisplayInfoHash,
-                         __glXDisplayInfoHash, CleanupDisplayInfoEntry,
-                         NULL, False);
+        __glvndHashMapTeardown(&__glXDisplayInfoHash, FreeDisplayInfoEntry,
+                NULL, False);
+        displayInfoGeneration++;
+        __glvndHashMapTeardown(&dispatchNameHash, NULL, NULL, False);
         /*
          * This implicitly unloads vendor libraries that were loaded when
          * they were added to this hashtable.
          */
-        LKDHASH_TEARDOWN(__GLXvendorNameHash,
-                         __glXVendorNameHash, CleanupVendorNameEntry,
-                         NULL, False);
+        __glvndHashMapTeardown(&__glXVendorNameHash, FreeVendorNameEntry,
+                NULL, False);
 
         /* Free any generated entrypoints */
         glvndFreeEntrypoints();
@@ -32,8 +32,9 @@
 
 #include "libglxabipriv.h"
 #include "GLdispatch.h"
-#include "lkdhash.h"
+#include "glvnd_hashmap.h"
 #include "winsys_dispatch.h"
+#include "glvnd_list.h"
 
 #define GLX_CLIENT_STRING_LAST_ATTRIB GLX_EXTENSIONS
 
@@ -45,6 +46,10 @@ struct __GLXvendorInfoRec {
     char *name; //< name of the vendor
     void *dlhandle; //< shared library handle
 
+    /// The arena that this structure and the vendor's other data are
+    /// allocated from.
+    __GLVNDarena *arena;
+
     /// dynamic GLX dispatch table
     __GLVNDwinsysVendorDispatch *dynDispatch;
 
@@ -56,6 +61,13 @@ struct __GLXvendorInfoRec {
 };
 
 typedef struct __GLXvendorXIDMappingHashRec __GLXvendorXIDMappingHash;
+typedef struct __GLXxidRadixRootRec __GLXxidRadixRoot;
+
+/*!
+ * The number of XID bases (usually one for each X client) that each display
+ * keeps a radix index for. See \c __GLXdisplayInfo::xidRadix.
+ */
+#define GLX_XID_RADIX_BASE_COUNT 4
 
 /*!
  * Structure containing per-display information.
@@ -63,26 +75,108 @@ typedef struct __GLXvendorXIDMappingHashRec __GLXvendorXIDMappingHash;
 typedef struct __GLXdisplayInfoRec {
     Display *dpy;
 
+    /**
+     * The merged glXGetClientString strings for a multi-screen display.
+     *
+     * Each string is built while holding the client string lock, and then
+     * published with a release store. It never changes after that, so
+     * glXGetClientString can return it without taking the lock.
+     */
     char *clientStrings[GLX_CLIENT_STRING_LAST_ATTRIB];
 
     /**
      * An array of vendors for each screen.
      *
      * Do not access this directly. Instead, call \c __glXLookupVendorByScreen.
+     *
+     * Each entry is set at most once, while holding \c vendorLock for
+     * writing, and is published with a release store. That way,
+     * \c __glXLookupVendorByScreen can read an entry that's already set
+     * without taking the lock.
      */
-    __GLXvendorInfo **vendors;
+    __GLXvendorInfo * volatile *vendors;
     glvnd_rwlock_t vendorLock;
 
-    DEFINE_LKDHASH(__GLXvendorXIDMappingHash, xidVendorHash);
+    /**
+     * The GLX_VENDOR_NAMES_EXT string for each screen.
+     *
+     * These are queried for every screen at once, the first time that
+     * \c __glXLookupVendorByScreen needs one. This is only accessed while
+     * holding \c vendorLock for writing.
+     */
+    char **vendorNames;
+    Bool vendorNamesQueried;
+
+    /**
+     * The vendor name for each screen from the on-disk cache, if it's
+     * enabled. See libglxvendorcache.h. This is only accessed while holding
+     * \c vendorLock for writing.
+     */
+    char **cachedVendorNames;
+    Bool vendorCacheRead;
+
+    /**
+     * The XID to vendor mappings for drawables. The values are
+     * __GLXvendorXIDMappingHash structures, which the map owns.
+     */
+    __GLVNDhashMap xids;
+
+    /**
+     * A radix index for the XID to vendor mappings of drawables, for each of
+     * the first few XID bases that show up. A mapping whose base has a root
+     * here is stored in the index instead of \c xids, so that looking it up
+     * is a couple of loads, without a hash or a lock. \c xids still holds the
+     * invalid XIDs and the mappings for any other bases.
+     */
+    __GLXxidRadixRoot * volatile xidRadix[GLX_XID_RADIX_BASE_COUNT];
+
+    /// The number of entries in \c xids that record an invalid XID.
+    int volatile xidMissCount;
 
     /// True if the server supports the GLX extension.
     Bool glxSupported;
 
-    /// The major opcode for GLX, if it's supported.
+    /// The major opcode, first error, and first event for GLX, if it's
+    /// supported. These are what glXQueryExtension returns.
     int glxMajorOpcode;
     int glxFirstError;
+    int glxFirstEvent;
 
+    /**
+     * The GLX version that the server sent back for GLXQueryVersion, and
+     * whether every screen supports GLX_EXT_libglvnd.
+     *
+     * These aren't queried until something needs them, since an app that
+     * picks a vendor with __GLX_VENDOR_LIBRARY_NAME might never need them.
+     * Call \c __glXQueryServerInfo before reading any of these. The version
+     * is zero if the query failed.
+     */
+    int glxMajorVersion;
+    int glxMinorVersion;
     Bool libglvndExtensionSupported;
+
+    /// Non-zero once the fields above are filled in.
+    int volatile serverInfoQueried;
+    glvnd_mutex_t serverInfoLock;
+
+    /**
+     * What the server said about the context IDs that have been passed to
+     * glXImportContextEXT. See \c __glXLookupImportedContext.
+     */
+    __GLVNDhashMap importedContexts;
+
+    /**
+     * The cached glXGetFBConfigs and glXChooseFBConfig results, most recently
+     * used first, for vendors that allow it. See
+     * \c __glXLookupCachedFBConfigs.
+     *
+     * This is only accessed while holding \c fbconfigCacheLock. The
+     * generation is incremented each time the cache is invalidated.
+     */
+    struct glvnd_list fbconfigCache;
+    int fbconfigCacheCount;
+    unsigned int fbconfigCacheGeneration;
+    glvnd_mutex_t fbconfigCacheLock;
 } __GLXdisplayInfo;
 
 typedef struct __GLXlocalDispatchFunctionRec {
@@ -92,7 +186,7 @@ typedef struct __GLXlocalDispatchFunctionRec {
 
 /*!
  * A NULL-termianted list of GLX dispatch functions that are implemented in
- * libGLX instead of in any vendor library.
+ * libGLX instead of in any vendor library, sorted by name.
  */
 extern const __GLXlocalDispatchFunction LOCAL_GLX_DISPATCH_FUNCTIONS[];
 
@@ -103,6 +197,15 @@ extern const __GLXlocalDispatchFunction LOCAL_GLX_DISPATCH_FUNCTIONS[];
  */
 __GLXvendorInfo *__glXGetDynDispatch(Display *dpy, const int screen);
 
+/*!
+ * Fills in the server's GLX version and \c libglvndExtensionSupported for a
+ * display, if they haven't been yet.
+ *
+ * The version and the GLX_EXTENSIONS string for every screen are all fetched
+ * in a single round trip.
+ */
+void __glXQueryServerInfo(__GLXdisplayInfo *dpyInfo);
+
 /*!
  * Various functions to manage mappings used to determine the screen
  * of a particular GLX call.
@@ -112,9 +215,53 @@ void __glXRemoveVendorContextMapping(Display *dpy, GLXContext context);
 __GLXvendorInfo *__glXVendorFromContext(GLXContext context);
 
 int __glXAddVendorFBConfigMapping(Display *dpy, GLXFBConfig config, __GLXvendorInfo *vendor);
+
+/**
+ * Adds mappings for an array of configs, such as the ones returned by
+ * glXChooseFBConfig, all with the same lock. NULL configs are skipped.
+ *
+ * \return Zero on success, or -1 if any config couldn't be added.
+ */
+int __glXAddVendorFBConfigMappings(Display *dpy, const GLXFBConfig *configs,
+        int count, __GLXvendorInfo *vendor);
+
 void __glXRemoveVendorFBConfigMapping(Display *dpy, GLXFBConfig config);
 __GLXvendorInfo *__glXVendorFromFBConfig(Display *dpy, GLXFBConfig config);
 
+/**
+ * Looks up a cached result from glXGetFBConfigs or glXChooseFBConfig.
+ *
+ * \param dpy The display connection.
+ * \param screen The screen number.
+ * \param choose True for glXChooseFBConfig, False for glXGetFBConfigs.
+ * \param attribs The attribute list for glXChooseFBConfig, which may be NULL.
+ * \param[out] nelements Returns the number of configs.
+ * \param[out] generation Returns the cache generation, which the caller
+ * passes to \c __glXAddCachedFBConfigs on a miss.
+ * \return A copy of the configs, which the caller frees with XFree, or NULL
+ * if there's no cached result.
+ */
+GLXFBConfig *__glXLookupCachedFBConfigs(Display *dpy, int screen, Bool choose,
+        const int *attribs, int *nelements, unsigned int *generation);
+
+/**
+ * Caches a result from glXGetFBConfigs or glXChooseFBConfig, after its
+ * configs have been added with \c __glXAddVendorFBConfigMappings.
+ *
+ * Nothing is cached if the cache was invalidated since
+ * \c __glXLookupCachedFBConfigs returned \p generation, since the vendor
+ * might have returned the old configs.
+ */
+void __glXAddCachedFBConfigs(Display *dpy, int screen, Bool choose,
+        const int *attribs, const GLXFBConfig *configs, int count,
+        unsigned int generation);
+
+/**
+ * Throws away the cached glXGetFBConfigs and glXChooseFBConfig results for a
+ * screen, or for every screen if \p screen is -1.
+ */
+void __glXInvalidateFBConfigCache(Display *dpy, int screen);
+
 int __glXAddVendorDrawableMapping(Display *dpy, GLXDrawable drawable, __GLXvendorInfo *vendor);
 void __glXRemoveVendorDrawableMapping(Display *dpy, GLXDrawable drawable);
 __GLXvendorInfo *__glXVendorFromDrawable(Display *dpy, GLXDrawable drawable);
@@ -128,12 +275,58 @@ __GLXextFuncPtr __glXGetGLXDispatchAddress(const GLubyte *procName);
 __GLXvendorInfo *__glXLookupVendorByName(const char *vendorName);
 __GLXvendorInfo *__glXLookupVendorByScreen(Display *dpy, const int screen);
 
+/*!
+ * Looks up the vendor for every screen on a display at once.
+ *
+ * This is equivalent to calling \c __glXLookupVendorByScreen for each screen,
+ * but it only takes the display's vendor lock once for all of the screens
+ * that haven't been resolved yet.
+ *
+ * \param dpy The display connection.
+ * \param[out] vendors Returns the vendor for each screen. This must have room
+ * for \c ScreenCount(dpy) elements.
+ * \return Zero on success, or -1 on error.
+ */
+int __glXLookupVendorsForAllScreens(Display *dpy, __GLXvendorInfo **vendors);
+
+/*!
+ * Fills in the OpenGL dispatch table of every vendor that's been loaded so
+ * far. This is used for glXPreinitializeGLVND.
+ */
+void __glXPopulateVendorDispatchTables(void);
+
 /*!
  * Looks up the __GLXdisplayInfo structure for a display, creating it if
  * necessary.
  */
 __GLXdisplayInfo *__glXLookupDisplay(Display *dpy);
 
+/*!
+ * Looks up what was recorded for a context ID with
+ * \c __glXAddImportedContext.
+ *
+ * \param dpyInfo The display connection.
+ * \param contextID The context ID.
+ * \param[out] isDirect Returns whether the context is direct.
+ * \param[out] screen Returns the context's screen, or -1 for a direct
+ * context.
+ * \return True if the context ID was found.
+ */
+Bool __glXLookupImportedContext(__GLXdisplayInfo *dpyInfo,
+        GLXContextID contextID, Bool *isDirect, int *screen);
+
+/*!
+ * Records whether a context ID is direct and which screen it's on, so that
+ * importing the same context again doesn't have to ask the server.
+ */
+void __glXAddImportedContext(__GLXdisplayInfo *dpyInfo, GLXContextID contextID,
+        Bool isDirect, int screen);
+
+/*!
+ * Forgets a context ID after the context is freed or destroyed.
+ */
+void __glXRemoveImportedContext(__GLXdisplayInfo *dpyInfo, GLXContextID contextID);
+
 /*!
  * This is called to perform any context-related cleanup when a display is
  * closed.
@@ -28,11 +28,334 @@
  */
 #include <X11/Xlibint.h>
 
+#if defined(HAVE_X11_XCB)
+#include <X11/Xlib-xcb.h>
+#include <xcb/xcbext.h>
+#include <sys/uio.h>
+#endif
+
 #include "libglxproto.h"
 
 #include <GL/glx.h>
 #include <GL/glxproto.h>
 
+/*!
+ * The number of attribute pairs that __glXGetDrawableScreen can read without
+ * allocating a buffer. Servers currently send fewer than ten.
+ */
+#define DRAWABLE_ATTRIBS_STACK_COUNT 32
+
+
+#if defined(HAVE_X11_XCB)
+
+/*
+ * These versions send libGLX's own requests through XCB instead of Xlib.
+ *
+ * XCB does its own locking, so none of these functions take the Xlib display
+ * lock, and they can send several requests before waiting for any of the
+ * replies. An app thread that's blocked in Xlib (waiting on XNextEvent, for
+ * example) doesn't keep libGLX from sending a request, and libGLX doesn't
+ * keep the app's other threads out of Xlib while it waits for a reply.
+ */
+
+/*!
+ * Sends a GLX request through XCB, without waiting for the reply.
+ *
+ * \param dpyInfo The display connection.
+ * \param req The request. XCB fills in the major opcode and the length, so
+ * the caller only needs to fill in the GLX opcode and the request data.
+ * \param size The size of the request in bytes.
+ * \param checked If True, then an error from the server will be returned to
+ * \c WaitReply. Otherwise, errors go to the X error handler.
+ * \return The sequence number to pass to \c WaitReply, or zero on failure.
+ */
+static unsigned int SendRequest(__GLXdisplayInfo *dpyInfo, void *req,
+        size_t size, Bool checked)
+{
+    xcb_protocol_request_t xcbReq = {};
+    // xcb_send_request needs two spare elements ahead of the request.
+    struct iovec parts[3];
+
+    xcbReq.count = 1;
+    xcbReq.ext = NULL;
+    xcbReq.opcode = dpyInfo->glxMajorOpcode;
+    xcbReq.isvoid = 0;
+
+    parts[2].iov_base = req;
+    parts[2].iov_len = size;
+
+    return xcb_send_request(XGetXCBConnection(dpyInfo->dpy),
+            checked ? XCB_REQUEST_CHECKED : 0, &parts[2], &xcbReq);
+}
+
+/*!
+ * Waits for the reply to a request from \c SendRequest.
+ *
+ * \return The reply, followed by any additional data, or \c NULL if the
+ * server sent an error. The caller must free the reply using \c free.
+ */
+static void *WaitReply(__GLXdisplayInfo *dpyInfo, unsigned int sequence)
+{
+    xcb_generic_error_t *error = NULL;
+    void *reply;
+
+    if (sequence == 0) {
+        return NULL;
+    }
+
+    reply = xcb_wait_for_reply(XGetXCBConnection(dpyInfo->dpy), sequence, &error);
+    free(error);
+    return reply;
+}
+
+/*!
+ * Throws away the reply to a request from \c SendRequest.
+ */
+static void DiscardReply(__GLXdisplayInfo *dpyInfo, unsigned int sequence)
+{
+    if (sequence != 0) {
+        xcb_discard_reply(XGetXCBConnection(dpyInfo->dpy), sequence);
+    }
+}
+
+static unsigned int SendQueryServerString(__GLXdisplayInfo *dpyInfo, int screen, int name)
+{
+    xGLXQueryServerStringReq req = {};
+
+    req.glxCode = X_GLXQueryServerString;
+    req.length = sz_xGLXQueryServerStringReq >> 2;
+    req.screen = screen;
+    req.name = name;
+    return SendRequest(dpyInfo, &req, sz_xGLXQueryServerStringReq, True);
+}
+
+/*!
+ * Waits for the reply to a GLXQueryServerString request, and returns the
+ * string.
+ */
+static char *WaitQueryServerString(__GLXdisplayInfo *dpyInfo, unsigned int sequence)
+{
+    xGLXSingleReply *reply = (xGLXSingleReply *) WaitReply(dpyInfo, sequence);
+    size_t length;
+
+    if (reply == NULL) {
+        return NULL;
+    }
+
+    // Move the string to the start of the buffer, so that the caller can
+    // free it without knowing about the reply.
+    length = reply->length * 4;
+    if (length == 0) {
+        free(reply);
+        return NULL;
+    }
+    memmove(reply, reply + 1, length);
+    return (char *) reply;
+}
+
+char *__glXQueryServerString(__GLXdisplayInfo *dpyInfo, int screen, int name)
+{
+    if (!dpyInfo->glxSupported) {
+        return NULL;
+    }
+    return WaitQueryServerString(dpyInfo,
+            SendQueryServerString(dpyInfo, screen, name));
+}
+
+/*!
+ * Sends a GLXQueryServerString request for every screen, and optionally a
+ * GLXQueryVersion request ahead of them, and then waits for all of the
+ * replies at once.
+ *
+ * \return True if \p major and \p minor were filled in.
+ */
+static Bool QueryServerStrings(__GLXdisplayInfo *dpyInfo, int name, char **results,
+        int *major, int *minor)
+{
+    int screenCount = ScreenCount(dpyInfo->dpy);
+    unsigned int stackSequences[8];
+    unsigned int *sequences = stackSequences;
+    unsigned int versionSequence = 0;
+    Bool versionReceived = False;
+    int screen;
+
+    memset(results, 0, screenCount * sizeof(char *));
+    if (!dpyInfo->glxSupported || screenCount <= 0) {
+        return False;
+    }
+
+    if (screenCount > (int) (sizeof(stackSequences) / sizeof(stackSequences[0]))) {
+        sequences = (unsigned int *) malloc(screenCount * sizeof(unsigned int));
+        if (sequences == NULL) {
+            return False;
+        }
+    }
+
+    if (major != NULL) {
+        xGLXQueryVersionReq req = {};
+
+        req.glxCode = X_GLXQueryVersion;
+        req.length = sz_xGLXQueryVersionReq >> 2;
+        req.majorVersion = GLX_MAJOR_VERSION;
+        req.minorVersion = GLX_MINOR_VERSION;
+        versionSequence = SendRequest(dpyInfo, &req, sz_xGLXQueryVersionReq, True);
+    }
+    for (screen = 0; screen < screenCount; screen++) {
+        sequences[screen] = SendQueryServerString(dpyInfo, screen, name);
+    }
+
+    if (major != NULL) {
+        xGLXQueryVersionReply *reply = (xGLXQueryVersionReply *)
+            WaitReply(dpyInfo, versionSequence);
+        if (reply != NULL) {
+            *major = reply->majorVersion;
+            *minor = reply->minorVersion;
+            versionReceived = True;
+            free(reply);
+        }
+    }
+    for (screen = 0; screen < screenCount; screen++) {
+        results[screen] = WaitQueryServerString(dpyInfo, sequences[screen]);
+    }
+
+    if (sequences != stackSequences) {
+        free(sequences);
+    }
+    return versionReceived;
+}
+
+void __glXQueryServerStringAllScreens(__GLXdisplayInfo *dpyInfo, int name, char **results)
+{
+    QueryServerStrings(dpyInfo, name, results, NULL, NULL);
+}
+
+Bool __glXQueryServerVersionAndStrings(__GLXdisplayInfo *dpyInfo, int name,
+        char **results, int *major, int *minor)
+{
+    return QueryServerStrings(dpyInfo, name, results, major, minor);
+}
+
+int __glXGetDrawableScreen(__GLXdisplayInfo *dpyInfo, GLXDrawable drawable)
+{
+    xGLXGetDrawableAttributesReq req = {};
+    xGLXGetDrawableAttributesReply *reply;
+    const int *attribs;
+    unsigned int numAttribs;
+    unsigned int i;
+    int screen = 0;
+
+    if (drawable == None) {
+        return -1;
+    }
+    if (!dpyInfo->glxSupported) {
+        return 0;
+    }
+
+    req.glxCode = X_GLXGetDrawableAttributes;
+    req.length = sz_xGLXGetDrawableAttributesReq >> 2;
+    req.drawable = drawable;
+    reply = (xGLXGetDrawableAttributesReply *) WaitReply(dpyInfo,
+            SendRequest(dpyInfo, &req, sz_xGLXGetDrawableAttributesReq, True));
+    if (reply == NULL) {
+        return -1;
+    }
+
+    // The attributes follow the reply in the same buffer.
+    attribs = (const int *) (reply + 1);
+    numAttribs = reply->numAttribs;
+    if (numAttribs > reply->length / 2) {
+        numAttribs = reply->length / 2;
+    }
+    for (i=0; i<numAttribs; i++) {
+        if (attribs[i * 2] == GLX_SCREEN) {
+            screen = attribs[i * 2 + 1];
+            break;
+        }
+    }
+
+    free(reply);
+    return screen;
+}
+
+Bool __glXQueryContextInfo(__GLXdisplayInfo *dpyInfo, GLXContextID contextID,
+        Bool *isDirect, int *screen)
+{
+    xGLXIsDirectReq directReq = {};
+    xGLXIsDirectReply *directReply;
+    xGLXQueryContextReply *contextReply;
+    unsigned int directSequence;
+    unsigned int contextSequence = 0;
+    int i;
+
+    assert(dpyInfo->glxSupported);
+
+    // Send both requests before waiting for either reply, so that an
+    // indirect context only takes one round trip. An error from GLXIsDirect
+    // goes to the X error handler, as if the vendor library had sent it, but
+    // the second request is checked so that a bad context only reports one
+    // error.
+    directReq.glxCode = X_GLXIsDirect;
+    directReq.length = sz_xGLXIsDirectReq >> 2;
+    directReq.context = contextID;
+    directSequence = SendRequest(dpyInfo, &directReq, sz_xGLXIsDirectReq, False);
+
+    // Check the version number so that we know which request to send.
+    __glXQueryServerInfo(dpyInfo);
+    if (dpyInfo->glxMajorVersion == GLX_MAJOR_VERSION) {
+        if (dpyInfo->glxMinorVersion >= 3) {
+            xGLXQueryContextReq req = {};
+
+            req.glxCode = X_GLXQueryContext;
+            req.length = sz_xGLXQueryContextReq >> 2;
+            req.context = contextID;
+            contextSequence = SendRequest(dpyInfo, &req, sz_xGLXQueryContextReq, True);
+        } else {
+            xGLXQueryContextInfoEXTReq req = {};
+
+            req.glxCode = X_GLXVendorPrivateWithReply;
+            req.length = sz_xGLXQueryContextInfoEXTReq >> 2;
+            req.vendorCode = X_GLXvop_QueryContextInfoEXT;
+            req.context = contextID;
+            contextSequence = SendRequest(dpyInfo, &req, sz_xGLXQueryContextInfoEXTReq, True);
+        }
+    }
+
+    directReply = (xGLXIsDirectReply *) WaitReply(dpyInfo, directSequence);
+    if (directReply == NULL) {
+        DiscardReply(dpyInfo, contextSequence);
+        return False;
+    }
+    *isDirect = (directReply->isDirect != 0);
+    free(directReply);
+
+    *screen = -1;
+    if (*isDirect) {
+        DiscardReply(dpyInfo, contextSequence);
+        return True;
+    }
+
+    contextReply = (xGLXQueryContextReply *) WaitReply(dpyInfo, contextSequence);
+    if (contextReply != NULL) {
+        // The attribute pairs follow the reply in the same buffer.
+        const int *propList = (const int *) (contextReply + 1);
+        unsigned int count = contextReply->n;
+
+        if (count > contextReply->length / 2) {
+            count = contextReply->length / 2;
+        }
+        for (i=0; i<(int) count; i++) {
+            if (propList[i * 2] == GLX_SCREEN) {
+                *screen = propList[i * 2 + 1];
+                break;
+            }
+        }
+        free(contextReply);
+    }
+    return True;
+}
+
+#else // defined(HAVE_X11_XCB)
+
 /*!
  * Reads a reply from the server, including any additional data.
  *
@@ -125,12 +448,159 @@ char *__glXQueryServerString(__GLXdisplayInfo *dpyInfo, int screen, int name)
 
     return ret;
 }
+/*!
+ * State for the async handler used in \c __glXQueryServerStringAllScreens.
+ */
+typedef struct QueryServerStringStateRec {
+    /// The sequence number of the first request.
+    unsigned long firstSequence;
+
+    /// The sequence number of the last request that the handler should
+    /// process. The last request itself is read with ReadReply instead.
+    unsigned long lastSequence;
+
+    char **results;
+
+    /// If this isn't NULL, then a GLXQueryVersion request was sent first,
+    /// and the handler copies its reply here.
+    xGLXQueryVersionReply *versionReply;
+    unsigned long versionSequence;
+    Bool versionReceived;
+} QueryServerStringState;
+
+/*!
+ * An async handler that collects the replies to all but the last of the
+ * requests from \c QueryServerStrings.
+ */
+static Bool QueryServerStringHandler(Display *dpy, xReply *rep, char *buf, int len, XPointer data)
+{
+    QueryServerStringState *state = (QueryServerStringState *) data;
+    unsigned long sequence = dpy->last_request_read;
+    char *str = NULL;
+    int length;
+
+    if (state->versionReply != NULL && sequence == state->versionSequence) {
+        if (rep->generic.type != X_Error) {
+            _XGetAsyncReply(dpy, (char *) state->versionReply, rep, buf, len,
+                    0, False);
+            state->versionReceived = True;
+        }
+        return True;
+    }
+
+    if (sequence < state->firstSequence || sequence > state->lastSequence) {
+        return False;
+    }
+
+    if (rep->generic.type == X_Error) {
+        // Leave the result as NULL, and don't report the error.
+        return True;
+    }
+
+    length = rep->generic.length * 4;
+    if (length > 0) {
+        str = malloc(length);
+    }
+    // If str is NULL, then this just discards the data.
+    _XGetAsyncData(dpy, str, buf, len, SIZEOF(xReply), length, length);
+
+    state->results[sequence - state->firstSequence] = str;
+    return True;
+}
+
+/*!
+ * Sends a GLXQueryServerString request for every screen, and optionally a
+ * GLXQueryVersion request ahead of them, and then waits for all of the
+ * replies at once.
+ *
+ * \return True if \p versionReply was filled in.
+ */
+static Bool QueryServerStrings(__GLXdisplayInfo *dpyInfo, int name, char **results,
+        xGLXQueryVersionReply *versionReply)
+{
+    Display *dpy = dpyInfo->dpy;
+    int screenCount = ScreenCount(dpy);
+    xGLXQueryServerStringReq *req;
+    xGLXSingleReply rep;
+    QueryServerStringState state;
+    _XAsyncHandler async;
+    int screen;
+
+    memset(results, 0, screenCount * sizeof(char *));
+    if (!dpyInfo->glxSupported || screenCount <= 0) {
+        return False;
+    }
+
+    LockDisplay(dpy);
+
+    state.versionReply = versionReply;
+    state.versionReceived = False;
+    if (versionReply != NULL) {
+        xGLXQueryVersionReq *versionReq;
+
+        GetReq(GLXQueryVersion, versionReq);
+        versionReq->reqType = dpyInfo->glxMajorOpcode;
+        versionReq->glxCode = X_GLXQueryVersion;
+        versionReq->majorVersion = GLX_MAJOR_VERSION;
+        versionReq->minorVersion = GLX_MINOR_VERSION;
+        state.versionSequence = dpy->request;
+    }
+
+    for (screen = 0; screen < screenCount; screen++) {
+        GetReq(GLXQueryServerString, req);
+        req->reqType = dpyInfo->glxMajorOpcode;
+        req->glxCode = X_GLXQueryServerString;
+        req->screen = screen;
+        req->name = name;
+        if (screen == 0) {
+            state.firstSequence = dpy->request;
+        }
+    }
+
+    state.lastSequence = dpy->request - 1;
+    state.results = results;
+    async.next = dpy->async_handlers;
+    async.handler = QueryServerStringHandler;
+    async.data = (XPointer) &state;
+    dpy->async_handlers = &async;
+
+    ReadReply(dpyInfo, (xReply *) &rep, (void **) &results[screenCount - 1]);
+
+    DeqAsyncHandler(dpy, &async);
+
+    UnlockDisplay(dpy);
+    SyncHandle();
+
+    return state.versionReceived;
+}
+
+void __glXQueryServerStringAllScreens(__GLXdisplayInfo *dpyInfo, int name, char **results)
+{
+    QueryServerStrings(dpyInfo, name, results, NULL);
+}
+
+Bool __glXQueryServerVersionAndStrings(__GLXdisplayInfo *dpyInfo, int name,
+        char **results, int *major, int *minor)
+{
+    xGLXQueryVersionReply reply;
+
+    if (!QueryServerStrings(dpyInfo, name, results, &reply)) {
+        return False;
+    }
+    *major = reply.majorVersion;
+    *minor = reply.minorVersion;
+    return True;
+}
+
 int __glXGetDrawableScreen(__GLXdisplayInfo *dpyInfo, GLXDrawable drawable)
 {
     Display *dpy = dpyInfo->dpy;
     xGLXGetDrawableAttributesReq *req;
     xGLXGetDrawableAttributesReply rep;
-    int *attribs = NULL;
+    int stackAttribs[DRAWABLE_ATTRIBS_STACK_COUNT * 2];
+    int *attribs = stackAttribs;
+    unsigned int numAttribs = 0;
+    int screen = -1;
     Status st;
 
     if (drawable == None) {
@@ -147,27 +617,166 @@ int __glXGetDrawableScreen(__GLXdisplayInfo *dpyInfo, GLXDrawable drawable)
     req->glxCode = X_GLXGetDrawableAttributes;
     req->drawable = drawable;
 
-    st = ReadReply(dpyInfo, (xReply *) &rep, (void **) &attribs);
+    // Read the reply data ourselves, so that we can use a buffer on the stack
+    // in the common case instead of allocating one.
+    st = ReadReply(dpyInfo, (xReply *) &rep, NULL);
+    if (st == Success) {
+        unsigned long length = rep.length * 4;
+
+        if (length > sizeof(stackAttribs)) {
+            attribs = (int *) malloc(length);
+        }
+        if (attribs != NULL) {
+            _XRead(dpy, (char *) attribs, length);
+            numAttribs = rep.numAttribs;
+            if (numAttribs > length / (2 * sizeof(int))) {
+                numAttribs = length / (2 * sizeof(int));
+            }
+        } else {
+            _XEatData(dpy, length);
+            st = -1;
+        }
+    }
 
     UnlockDisplay(dpy);
     SyncHandle();
 
     if (st == Success) {
-        int screen = 0;
         unsigned int i;
 
-        if (attribs != NULL) {
-            for (i=0; i<rep.numAttribs; i++) {
-                if (attribs[i * 2] == GLX_SCREEN) {
-                    screen = attribs[i * 2 + 1];
-                    break;
-                }
+        screen = 0;
+        for (i=0; i<numAttribs; i++) {
+            if (attribs[i * 2] == GLX_SCREEN) {
+                screen = attribs[i * 2 + 1];
+                break;
             }
-            free(attribs);
         }
-        return screen;
+    }
+
+    if (attribs != stackAttribs) {
+        free(attribs);
+    }
+    return screen;
+}
+
+/**
+ * Sends a GLXIsDirect request.
+ *
+ * \return 1 if the context is direct, 0 if it's indirect, or -1 if the
+ * request failed.
+ */
+static int IsDirect(__GLXdisplayInfo *dpyInfo, GLXContextID context)
+{
+    Display *dpy = dpyInfo->dpy;
+    xGLXIsDirectReq *req;
+    xGLXIsDirectReply reply;
+    Status ret;
+
+    LockDisplay(dpy);
+
+    GetReq(GLXIsDirect, req);
+    req->reqType = dpyInfo->glxMajorOpcode;
+    req->glxCode = X_GLXIsDirect;
+    req->context = context;
+    ret = _XReply(dpy, (xReply *) &reply, 0, False);
+
+    UnlockDisplay(dpy);
+    SyncHandle();
+
+    if (!ret) {
+        return -1;
+    }
+    return (reply.isDirect ? 1 : 0);
+}
+
+/**
+ * Finds the screen number for a context, using the context's XID.
+ *
+ * Adapted from Mesa's glXImportContextEXT implementation.
+ */
+static int GetScreenForContextID(__GLXdisplayInfo *dpyInfo, GLXContextID contextID)
+{
+    Display *dpy = dpyInfo->dpy;
+    xGLXQueryContextReply reply;
+    int *propList;
+    int screen = -1;
+    int i;
+
+    // Check the version number so that we know which request to send.
+    __glXQueryServerInfo(dpyInfo);
+    if (dpyInfo->glxMajorVersion != GLX_MAJOR_VERSION) {
+        return -1;
+    }
+
+    /* Send the glXQueryContextInfoEXT request */
+    LockDisplay(dpy);
+
+    if (dpyInfo->glxMinorVersion >= 3) {
+        xGLXQueryContextReq *req;
+
+        GetReq(GLXQueryContext, req);
+
+        req->reqType = dpyInfo->glxMajorOpcode;
+        req->glxCode = X_GLXQueryContext;
+        req->context = contextID;
     } else {
+        xGLXVendorPrivateReq *vpreq;
+        xGLXQueryContextInfoEXTReq *req;
+
+        GetReqExtra(GLXVendorPrivate,
+                sz_xGLXQueryContextInfoEXTReq - sz_xGLXVendorPrivateReq,
+                vpreq);
+        req = (xGLXQueryContextInfoEXTReq *) vpreq;
+        req->reqType = dpyInfo->glxMajorOpcode;
+        req->glxCode = X_GLXVendorPrivateWithReply;
+        req->vendorCode = X_GLXvop_QueryContextInfoEXT;
+        req->context = contextID;
+    }
+
+    _XReply(dpy, (xReply *) &reply, 0, False);
+
+    if (reply.n <= 0) {
+        UnlockDisplay(dpy);
+        SyncHandle();
         return -1;
     }
+
+    propList = malloc(reply.n * 8);
+    if (propList == NULL) {
+        UnlockDisplay(dpy);
+        SyncHandle();
+        return -1;
+    }
+    _XRead(dpy, (char *) propList, reply.n * 8);
+
+    UnlockDisplay(dpy);
+    SyncHandle();
+
+    for (i=0; i<reply.n; i++) {
+        int *prop = &propList[i * 2];
+        if (prop[0] == GLX_SCREEN) {
+            screen = prop[1];
+            break;
+        }
+    }
+    free(propList);
+    return screen;
+}
+
+Bool __glXQueryContextInfo(__GLXdisplayInfo *dpyInfo, GLXContextID contextID,
+        Bool *isDirect, int *screen)
+{
+    int ret;
+
+    assert(dpyInfo->glxSupported);
+
+    ret = IsDirect(dpyInfo, contextID);
+    if (ret < 0) {
+        return False;
+    }
+    *isDirect = (ret != 0);
+    *screen = (*isDirect ? -1 : GetScreenForContextID(dpyInfo, contextID));
+    return True;
 }
 
+#endif // defined(HAVE_X11_XCB)
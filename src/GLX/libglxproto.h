@@ -32,6 +32,10 @@
 
 /*!
  * Functions to handle various GLX protocol requests.
+ *
+ * If libGLX was built with x11-xcb, then these send their requests through
+ * XCB instead of Xlib, so they don't hold the Xlib display lock while they
+ * wait for a reply.
  */
 
 #include "libglxmapping.h"
@@ -42,6 +46,10 @@
 
 #define GLX_EXT_LIBGLVND_NAME "GLX_EXT_libglvnd"
 
+/* The GLX version that libGLX sends in a GLXQueryVersion request. */
+#define GLX_MAJOR_VERSION 1
+#define GLX_MINOR_VERSION 4
+
 /*!
  * Sends a glXQueryServerString request. If an error occurs, then it will
  * return \c NULL, but won't call the X error handler.
@@ -54,6 +62,39 @@
  */
 char *__glXQueryServerString(__GLXdisplayInfo *dpyInfo, int screen, int name);
 
+/*!
+ * Sends a glXQueryServerString request for every screen.
+ *
+ * This sends all of the requests before waiting for any replies, so it only
+ * takes one round trip no matter how many screens there are.
+ *
+ * As with \c __glXQueryServerString, errors are not sent to the X error
+ * handler.
+ *
+ * \param dpyInfo The display connection.
+ * \param name The name enum to request.
+ * \param[out] results An array with one element for each screen. Each
+ * element receives the string for that screen, or \c NULL on error. The
+ * caller must free each string using \c free.
+ */
+void __glXQueryServerStringAllScreens(__GLXdisplayInfo *dpyInfo, int name, char **results);
+
+/*!
+ * The same as \c __glXQueryServerStringAllScreens, but this also sends a
+ * GLXQueryVersion request in the same round trip.
+ *
+ * \param dpyInfo The display connection.
+ * \param name The name enum to request.
+ * \param[out] results Receives the string for each screen.
+ * \param[out] major Receives the server's major version.
+ * \param[out] minor Receives the server's minor version.
+ * \return True if the server replied to the version request. If it didn't,
+ * then \p major and \p minor are left unchanged, but \p results is still
+ * filled in.
+ */
+Bool __glXQueryServerVersionAndStrings(__GLXdisplayInfo *dpyInfo, int name,
+        char **results, int *major, int *minor);
+
 /*!
  * Looks up the screen number for a drawable.
  *
@@ -68,4 +109,20 @@ char *__glXQueryServerString(__GLXdisplayInfo *dpyInfo, int screen, int name);
  */
 int __glXGetDrawableScreen(__GLXdisplayInfo *dpyInfo, GLXDrawable drawable);
 
+/*!
+ * Finds out whether a context is direct, and if it isn't, which screen it's
+ * on. This is used for glXImportContextEXT.
+ *
+ * An error from the GLXIsDirect request is sent to the X error handler.
+ *
+ * \param dpyInfo The display connection.
+ * \param contextID The context to look up.
+ * \param[out] isDirect Returns True if the context is direct.
+ * \param[out] screen Returns the screen number of an indirect context, or -1
+ * for a direct context or if the server didn't send a screen number.
+ * \return False if the GLXIsDirect request failed.
+ */
+Bool __glXQueryContextInfo(__GLXdisplayInfo *dpyInfo, GLXContextID contextID,
+        Bool *isDirect, int *screen);
+
 #endif // LIBGLXPROTO_H
@@ -0,0 +1,262 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+#include "libglxvendorcache.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+
+#include "utils_misc.h"
+#include "glvnd_hash.h"
+
+/*!
+ * The first line of every cache file. The number must be incremented
+ * whenever the layout changes.
+ */
+#define CACHE_MAGIC "GLVND-GLX-VENDORS 1\n"
+
+/*!
+ * The largest cache file that will be read. Real files are much smaller.
+ */
+#define CACHE_MAX_SIZE 65536
+
+/*!
+ * Returns the cache directory, or NULL if the cache isn't enabled.
+ */
+static const char *GetCacheDir(void)
+{
+    const char *dir;
+
+    if (getuid() != geteuid() || getgid() != getegid()) {
+        return NULL;
+    }
+
+    dir = glvndGetEnv("__GLX_VENDOR_SCREEN_CACHE");
+    if (dir == NULL || dir[0] == '\0') {
+        return NULL;
+    }
+    return dir;
+}
+
+/*!
+ * Builds the header that identifies the server that a cache file is for.
+ *
+ * Everything that the file depends on is in the header, so a file left over
+ * from a different server, or from a different version of this one, won't
+ * match.
+ *
+ * \param dpy The display connection.
+ * \param dir The cache directory.
+ * \param[out] path Receives the path to the cache file.
+ * \return The header, or NULL on failure. The caller must free both strings.
+ */
+static char *GetCacheHeader(Display *dpy, const char *dir, char **path)
+{
+    char *header;
+    const char *ptr;
+    int lines = 0;
+
+    if (glvnd_asprintf(&header, CACHE_MAGIC "%s\n%s\n%d\n%d\n",
+                DisplayString(dpy), ServerVendor(dpy), VendorRelease(dpy),
+                ScreenCount(dpy)) < 0) {
+        return NULL;
+    }
+
+    // The display name and server vendor come from outside libGLX, so make
+    // sure that they're a single line each.
+    for (ptr = header; *ptr != '\0'; ptr++) {
+        if (*ptr == '\n') {
+            lines++;
+        }
+    }
+    if (lines != 5) {
+        free(header);
+        return NULL;
+    }
+
+    if (glvnd_asprintf(path, "%s/glvnd-glx-vendors-%08x", dir,
+                (unsigned int) glvndHashString(header)) < 0) {
+        free(header);
+        return NULL;
+    }
+    return header;
+}
+
+/*!
+ * Returns true if a vendor name can go in a cache file.
+ *
+ * A vendor name is used to build a library filename, so it can't contain a
+ * slash anyway. It also has to fit on one line.
+ */
+static Bool IsValidVendorName(const char *name, size_t len)
+{
+    return (len > 0 && memchr(name, '\n', len) == NULL
+            && memchr(name, '/', len) == NULL);
+}
+
+Bool __glXReadVendorScreenCache(Display *dpy, char **names)
+{
+    const char *dir = GetCacheDir();
+    char *path = NULL;
+    char *header = NULL;
+    char *data = NULL;
+    size_t size = 0;
+    size_t headerLen;
+    const char *ptr;
+    const char *end;
+    Bool success = False;
+    int screen;
+    int fd;
+
+    memset(names, 0, ScreenCount(dpy) * sizeof(char *));
+    if (dir == NULL) {
+        return False;
+    }
+
+    header = GetCacheHeader(dpy, dir, &path);
+    if (header == NULL) {
+        return False;
+    }
+
+    fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        goto done;
+    }
+    data = malloc(CACHE_MAX_SIZE);
+    if (data != NULL) {
+        while (size < CACHE_MAX_SIZE) {
+            ssize_t ret = read(fd, data + size, CACHE_MAX_SIZE - size);
+            if (ret <= 0) {
+                break;
+            }
+            size += ret;
+        }
+    }
+    close(fd);
+    if (data == NULL || size >= CACHE_MAX_SIZE) {
+        goto done;
+    }
+
+    headerLen = strlen(header);
+    if (size < headerLen || memcmp(data, header, headerLen) != 0) {
+        goto done;
+    }
+
+    // After the header, there's one line for each screen, with the vendor
+    // name or an empty line if the vendor isn't known.
+    ptr = data + headerLen;
+    end = data + size;
+    for (screen = 0; screen < ScreenCount(dpy); screen++) {
+        const char *eol = memchr(ptr, '\n', end - ptr);
+        if (eol == NULL) {
+            goto done;
+        }
+        if (eol > ptr) {
+            if (!IsValidVendorName(ptr, eol - ptr)) {
+                goto done;
+            }
+            names[screen] = strndup(ptr, eol - ptr);
+        }
+        ptr = eol + 1;
+    }
+    success = True;
+
+done:
+    if (!success) {
+        for (screen = 0; screen < ScreenCount(dpy); screen++) {
+            free(names[screen]);
+            names[screen] = NULL;
+        }
+    }
+    free(data);
+    free(header);
+    free(path);
+    return success;
+}
+
+void __glXWriteVendorScreenCache(Display *dpy, char * const *names)
+{
+    const char *dir = GetCacheDir();
+    char *path = NULL;
+    char *tempPath = NULL;
+    char *header = NULL;
+    FILE *fp = NULL;
+    Bool success;
+    int screen;
+    int fd;
+
+    if (dir == NULL) {
+        return;
+    }
+
+    header = GetCacheHeader(dpy, dir, &path);
+    if (header == NULL) {
+        return;
+    }
+
+    // Write to a temporary file and then rename it, so that another process
+    // can't see a partially-written cache.
+    if (glvnd_asprintf(&tempPath, "%s.XXXXXX", path) < 0) {
+        tempPath = NULL;
+        goto done;
+    }
+    fd = mkstemp(tempPath);
+    if (fd < 0) {
+        goto done;
+    }
+    fp = fdopen(fd, "w");
+    if (fp == NULL) {
+        close(fd);
+        unlink(tempPath);
+        goto done;
+    }
+
+    fputs(header, fp);
+    for (screen = 0; screen < ScreenCount(dpy); screen++) {
+        const char *name = names[screen];
+        if (name != NULL && IsValidVendorName(name, strlen(name))) {
+            fputs(name, fp);
+        }
+        fputc('\n', fp);
+    }
+
+    success = !ferror(fp);
+    if (fclose(fp) != 0 || !success || rename(tempPath, path) != 0) {
+        unlink(tempPath);
+    }
+
+done:
+    free(tempPath);
+    free(header);
+    free(path);
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+#ifndef LIBGLXVENDORCACHE_H
+#define LIBGLXVENDORCACHE_H
+
+#include <X11/Xlib.h>
+
+/*!
+ * \file
+ *
+ * An optional on-disk cache of which vendor library each screen of an X
+ * server uses.
+ *
+ * Figuring out a screen's vendor normally takes a GLX_VENDOR_NAMES_EXT query
+ * and an isScreenSupported call to each vendor that the server lists. When
+ * many processes connect to the same X server, the cache lets every process
+ * after the first one skip all of that and load the vendor by name.
+ *
+ * The cache is enabled by setting __GLX_VENDOR_SCREEN_CACHE to a directory,
+ * such as $XDG_RUNTIME_DIR. Each display gets its own file in that
+ * directory. The file records the display name and the server's vendor string
+ * and release number. If any of those don't match, then the file is ignored
+ * and overwritten.
+ */
+
+/*!
+ * Reads the cached vendor names for every screen of a display.
+ *
+ * \param dpy The display connection.
+ * \param[out] names An array with one element for each screen. Each element
+ * receives the cached vendor name for that screen, or \c NULL if there isn't
+ * one. The caller must free each name using \c free.
+ * \return True if the cache is enabled and a matching file was found.
+ */
+Bool __glXReadVendorScreenCache(Display *dpy, char **names);
+
+/*!
+ * Writes the vendor names for every screen of a display to the cache.
+ *
+ * The file is written to a temporary file and then renamed, so a process
+ * reading the cache at the same time will either see the old version or the
+ * new one.
+ *
+ * This does nothing if the cache isn't enabled.
+ *
+ * \param dpy The display connection.
+ * \param names An array with one element for each screen. A \c NULL element
+ * means that the vendor for that screen isn't known yet.
+ */
+void __glXWriteVendorScreenCache(Display *dpy, char * const *names);
+
+#endif // LIBGLXVENDORCACHE_H
@@ -27,9 +27,13 @@
  * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
  */
 
+#include <stdint.h>
 #include <string.h>
 #include <pthread.h>
 #include <dlfcn.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
 
 #include "trace.h"
 #include "glvnd_list.h"
@@ -37,25 +41,64 @@
 #include "GLdispatchPrivate.h"
 #include "stub.h"
 #include "glvnd_pthread.h"
+#include "glvnd_atomic.h"
+#include "glvnd_probe.h"
+#include "glvnd_memstats.h"
+#include "string_pool.h"
 #include "app_error_check.h"
+#include "glvnd_exit.h"
+#include "glvnd/glvnd.h"
 
 /*
  * Global current dispatch table list. We need this to fix up all current
  * dispatch tables whenever GetProcAddress() is called on a new function.
- * Accesses to this need to be protected by the dispatch lock.
+ *
+ * A table is added the first time it's made current, and stays in the list
+ * until it's destroyed, even if it isn't current anymore. That way, every
+ * table in the list stays filled in, and making it current again only has to
+ * update its reference count. Accesses to this need to be protected by the
+ * dispatch lock.
  */
 static struct glvnd_list currentDispatchList;
 
+/*
+ * The number of stubs that have been filled in to every current dispatch
+ * table. __glDispatchGetProcAddress can return any stub below this index
+ * without taking the dispatch lock. This is only modified while holding the
+ * dispatch lock.
+ */
+static int volatile publishedStubCount;
+
 /*
  * Number of clients using GLdispatch.
  */
 static int clientRefcount;
 
 /*
- * The number of current contexts that GLdispatch is aware of
+ * The number of current contexts that GLdispatch is aware of. This is updated
+ * with atomic operations, so that switching between tables in the current
+ * dispatch list doesn't need the dispatch lock.
+ */
+static int volatile numCurrentContexts;
+
+/*
+ * Counters for __glDispatchGetStatistics. These are only modified while
+ * holding the dispatch lock.
  */
-static int numCurrentContexts;
+static int numDispatchTables;
+static uint64_t slotsResolvedCount;
+static uint64_t patchCount;
+static uint64_t unpatchCount;
+static uint64_t patchTimeUS;
 
+/*
+ * The most recent reason that a vendor's patch was refused, for
+ * __glDispatchGetConfig. These are only modified while holding the dispatch
+ * lock.
+ */
+static int lastPatchRefusal = GLDISPATCH_PATCH_REFUSED_NONE;
+static int lastPatchRefusalVendorID;
+static uint64_t patchRefusalCount;
 /**
  * Private data for each API state.
  */
@@ -68,8 +111,31 @@ typedef struct __GLdispatchThreadStatePrivateRec {
 
     /// The current (high-level) __GLdispatch table
     __GLdispatchTable *dispatch;
+
+    /// The patch callbacks that were passed in with \c dispatch, so that
+    /// __glDispatchResumeCurrent can make it current again.
+    const __GLdispatchPatchCallbacks *patchCb;
+
+    /// True if this state belongs to the pinned vendor. A pinned state isn't
+    /// counted in numCurrentContexts.
+    GLboolean pinned;
+
+    /// The handles from __glDispatchSetCurrentInfo, and the vendor context
+    /// while the state is detached, so that __glDispatchAttachCurrent can
+    /// restore them on another thread.
+    const void *display;
+    const void *context;
+    const void *vendorContext;
 } __GLdispatchThreadStatePrivate;
 
+/*
+ * Holds a private data structure that isn't in use for each thread. A make
+ * current after a lose current reuses it instead of calling malloc. This is a
+ * per-thread key instead of a shared list so that it doesn't need the
+ * dispatch lock.
+ */
+static glvnd_key_t freeThreadStateKey;
+
 /*
  * List of valid extension procs which have been assigned prototypes. At make
  * current time, if the new context's generation is out-of-date, we iterate
@@ -109,8 +175,30 @@ static int firstUnusedVendorID = 1;
  */
 static glvnd_key_t threadContextKey;
 
+#if defined(GLDISPATCH_USE_TLS)
+/*
+ * A copy of the value in threadContextKey, which libGLX and libEGL can read
+ * directly. The key is still needed so that ThreadDestroyed gets called.
+ */
+__thread __GLdispatchThreadState *__glDispatchCurrentThreadStateTLS
+    __attribute__((tls_model("initial-exec"))) = NULL;
+
+/*
+ * The record that __glDispatchGetCurrentInfo returns. This uses the
+ * initial-exec model like __glDispatchCurrentThreadStateTLS, so that reading
+ * it from a signal handler doesn't need to call into the dynamic linker.
+ */
+static __thread volatile GLVNDcurrentInfo currentInfo
+    __attribute__((tls_model("initial-exec")));
+#endif
+
 static void SetCurrentThreadState(__GLdispatchThreadState *threadState);
 static void ThreadDestroyed(void *data);
+static void InitLazyDispatch(void);
+static void InitSparseDispatch(void);
+static void InitPinVendor(void);
+static void InitPrewarm(void);
+static void PrewarmDispatchTable(__GLdispatchTable *dispatch);
 static int RegisterStubCallbacks(const __GLdispatchStubPatchCallbacks *callbacks);
 
 
@@ -118,35 +206,190 @@ static int RegisterStubCallbacks(const __GLdispatchStubPatchCallbacks *callbacks
  * The vendor ID of the current "owner" of the entrypoint code.  0 if
  * we are using the default libglvnd stubs.
  */
-static int stubOwnerVendorID;
+static int volatile stubOwnerVendorID;
 
 /*
  * The current set of patch callbacks being used, or NULL if using the
  * default libglvnd entrypoints.
  */
-static const __GLdispatchPatchCallbacks *stubCurrentPatchCb;
+static const __GLdispatchPatchCallbacks * volatile stubCurrentPatchCb;
+
+/*
+ * Incremented before and after PatchEntrypoints changes the entrypoints, so
+ * it's odd while a change is in progress. MakeCurrentFast uses this to check
+ * that the entrypoints didn't change while it was making a context current
+ * without the dispatch lock.
+ */
+static int volatile patchSequence;
+
+/*
+ * True if new dispatch tables should be populated lazily. This is set from
+ * the __GLVND_LAZY_DISPATCH environment variable.
+ */
+static GLboolean lazyDispatchEnabled = GL_FALSE;
+
+/*
+ * True if the __GLVND_PIN_VENDOR environment variable is set.
+ *
+ * In that case, the first vendor that makes a context current gets pinned for
+ * the rest of the process: the entrypoints are patched for it once, and each
+ * of its dispatch tables stays in currentDispatchList for good. After that,
+ * making one of its contexts current or losing current doesn't have to take
+ * the dispatch lock, and any other vendor fails to make current.
+ */
+static GLboolean pinVendorEnabled = GL_FALSE;
+
+/*
+ * How much PrewarmDispatchTable does. This is set from the
+ * __GLVND_PREWARM_DISPATCH environment variable, or by __glDispatchPrewarm.
+ *
+ * At 1, the first time a dispatch table is filled in, we fault in the pages
+ * of the table, the entrypoints, and the vendor's functions, so that the
+ * first frame doesn't have to. At 2, we also try to lock the table and the
+ * entrypoints in memory.
+ */
+static int prewarmLevel = 0;
+
+/*
+ * The value of patchSequence the last time PrewarmStubs ran, or -1 if it
+ * hasn't yet. Patching can replace the pages of the entrypoints, so they have
+ * to be faulted in again after that.
+ */
+static int prewarmStubSequence = -1;
+
+/*
+ * Which GLDISPATCH_STUB_FLAVOR_* the dispatch stubs use. This is set in
+ * __glDispatchOnLoadInit.
+ */
+static int stubFlavor = GLDISPATCH_STUB_FLAVOR_TSD;
+
+/*
+ * The pinned vendor ID, or zero if no vendor has been pinned yet. This is
+ * only written with the dispatch lock held.
+ */
+static int volatile pinnedVendorID = 0;
+
+/*
+ * The number of dispatch tables with the pinned flag set. When the last one
+ * is destroyed, the vendor is unpinned.
+ */
+static int pinnedTableCount = 0;
+
+/*
+ * With app error checking, RestoreEntrypointsForErrorCheck only restores the
+ * entrypoints once every errorCheckRestoreInterval releases, counting them in
+ * errorCheckReleaseCount. The interval starts at 1 and doubles after each
+ * restore, up to MAX_ERROR_CHECK_RESTORE_INTERVAL. Both are only accessed with
+ * the dispatch lock held.
+ */
+#define MAX_ERROR_CHECK_RESTORE_INTERVAL 64
+static int errorCheckRestoreInterval = 1;
+static int errorCheckReleaseCount = 0;
+
+/*
+ * Tracks which dispatch table slots anything can call, so that
+ * FixupDispatchTable can skip looking up the rest.
+ *
+ * For each slot, neededSlots holds the value of neededSlotGeneration when
+ * something first registered that slot, or zero if nothing has yet. A
+ * dispatch table records the generation that it was last filled in at, so it
+ * only has to look for slots that are newer than that.
+ *
+ * This is NULL if every slot should be filled in, which is the case with lazy
+ * dispatch, or if __GLVND_SPARSE_DISPATCH is set to 0.
+ */
+static int *neededSlots = NULL;
+static int neededSlotCount = 0;
+static int neededSlotGeneration = 0;
 
 static glvnd_thread_t firstThreadId = GLVND_THREAD_NULL_INIT;
 static int isMultiThreaded = 0;
 
+/*
+ * This is incremented whenever something changes that each thread has to be
+ * told about in __glDispatchCheckMultithreaded, which currently means a
+ * change to the patch callbacks. This is only modified while holding the
+ * dispatch lock.
+ */
+static int volatile threadAttachGeneration = 1;
+
+/*
+ * The value of threadAttachGeneration the last time the current thread went
+ * through the locked path in __glDispatchCheckMultithreaded, or zero if it
+ * hasn't yet.
+ */
+#if defined(GLDISPATCH_USE_TLS)
+static __thread int threadAttachGenerationSeen
+    __attribute__((tls_model("initial-exec"))) = 0;
+#else
+static glvnd_key_t threadAttachGenerationKey;
+#endif
+
+/*
+ * Incremented every time the current thread's dispatch table changes. See
+ * __glDispatchGetCurrentGeneration.
+ */
+#if defined(GLDISPATCH_USE_TLS)
+static __thread unsigned long currentGeneration
+    __attribute__((tls_model("initial-exec"))) = 0;
+#else
+static glvnd_key_t currentGenerationKey;
+#endif
+
 /*
  * The dispatch lock. This should be taken around any code that manipulates the
  * above global variables or makes calls to _glapi_get_proc_offset() or
  * _glapi_get_proc_offset().
+ *
+ * This is a plain mutex, not an adaptive one. It's held across calls into a
+ * vendor's getProcAddress callback, dispatch table fixups, and entrypoint
+ * patching, all of which can take far longer than it's worth spinning for.
  */
 struct {
     glvnd_mutex_t lock;
+    glvnd_lock_stats_t stats;
     int isLocked;
-} dispatchLock = { GLVND_MUTEX_INITIALIZER, 0 };
+} dispatchLock = { GLVND_MUTEX_INITIALIZER, { 0, 0, 0, 0 }, 0 };
 
 static inline void LockDispatch(void)
 {
-    __glvndPthreadFuncs.mutex_lock(&dispatchLock.lock);
+    if (__glvndPthreadFuncs.mutex_trylock(&dispatchLock.lock) == 0) {
+        dispatchLock.stats.acquired++;
+    } else if (glvndLockProfiling) {
+        glvndProfiledMutexLockSlow(&dispatchLock.lock, &dispatchLock.stats);
+    } else {
+        __glvndPthreadFuncs.mutex_lock(&dispatchLock.lock);
+        dispatchLock.stats.acquired++;
+        dispatchLock.stats.parked++;
+    }
     dispatchLock.isLocked = 1;
 }
 
+/*
+ * Copies the counters from __glDispatchGetStatistics into the shared memory
+ * statistics. The caller must hold the dispatch lock.
+ */
+static void PublishShmStats(void)
+{
+    int staticCount = _glapi_get_static_stub_count();
+
+    GLDISPATCH_SHM_STATS_SET(tableCount, numDispatchTables);
+    GLDISPATCH_SHM_STATS_SET(patchOwnerVendorID, stubOwnerVendorID);
+    GLDISPATCH_SHM_STATS_SET(patchCount, patchCount);
+    GLDISPATCH_SHM_STATS_SET(unpatchCount, unpatchCount);
+    GLDISPATCH_SHM_STATS_SET(patchTimeUS, patchTimeUS);
+    GLDISPATCH_SHM_STATS_SET(lockAcquired, dispatchLock.stats.acquired);
+    GLDISPATCH_SHM_STATS_SET(lockContended, dispatchLock.stats.parked);
+    GLDISPATCH_SHM_STATS_SET(lockWaitNS, dispatchLock.stats.waitNS);
+    GLDISPATCH_SHM_STATS_SET(dynamicStubCount, _glapi_get_stub_count() - staticCount);
+    GLDISPATCH_SHM_STATS_SET(dynamicStubMax, _glapi_get_max_stub_count() - staticCount);
+}
+
 static inline void UnlockDispatch(void)
 {
+    if (__glDispatchShmStats != NULL) {
+        PublishShmStats();
+    }
     dispatchLock.isLocked = 0;
     __glvndPthreadFuncs.mutex_unlock(&dispatchLock.lock);
 }
@@ -158,8 +401,20 @@ int __glDispatchGetABIVersion(void)
     return GLDISPATCH_ABI_VERSION;
 }
 
+PUBLIC int __glDispatchGetStubFlavor(void)
+{
+    return stubFlavor;
+}
+
 #if defined(USE_ATTRIBUTE_CONSTRUCTOR)
-void __attribute__ ((constructor)) __glDispatchOnLoadInit(void)
+/*
+ * When libGLdispatch is linked into an executable as a static archive, its
+ * constructor would otherwise run in link order, which can be after the
+ * constructors of libEGL or libOpenGL that call __glDispatchInit. The
+ * priority makes it run first. In a shared library, it only changes the
+ * order within libGLdispatch itself.
+ */
+void __attribute__ ((constructor(101))) __glDispatchOnLoadInit(void)
 #else
 void _init(void)
 #endif
@@ -167,7 +422,48 @@ void _init(void)
     // Here, we only initialize the pthreads imports. Everything else we'll
     // deal with in __glDispatchInit.
     glvndSetupPthreads();
+
+    // This has to happen before anything touches the current dispatch table,
+    // so that it can tell whether it's in static TLS.
+#if defined(GLDISPATCH_USE_TLS)
+    stubFlavor = GLDISPATCH_STUB_FLAVOR_TLS;
+#else
+    if (_glapi_init_static_tls()) {
+        stubFlavor = GLDISPATCH_STUB_FLAVOR_STATIC_TLS;
+    }
+#endif
     glvndAppErrorCheckInit();
+
+    // Pick the no-op functions now, so that the common case where error
+    // reporting is disabled doesn't have to check for it on every call.
+    _glapi_init_noop(glvndAppErrorCheckGetReportEnabled());
+
+    __glDispatchTraceInit();
+    __glDispatchCallCountInit();
+    __glDispatchLockStatsInit();
+    __glDispatchMemStatsInit();
+    __glDispatchSlowOpsInit();
+    __glDispatchWinsysTimesInit();
+    __glDispatchSymbolMapInit();
+    __glDispatchShmStatsInit();
+}
+
+static void FiniReports(void);
+
+#if defined(USE_ATTRIBUTE_CONSTRUCTOR)
+void __attribute__ ((destructor)) __glDispatchOnExitFini(void)
+#else
+void _fini(void)
+#endif
+{
+    // In the fast exit mode, libGLdispatch is pinned, so this only runs at
+    // process exit, after the destructors of the libraries that use it.
+    // Everything else is left for the OS to clean up.
+    if (glvndFastExitEnabled()) {
+        LockDispatch();
+        FiniReports();
+        UnlockDispatch();
+    }
 }
 
 void __glDispatchInit(void)
@@ -178,6 +474,11 @@ void __glDispatchInit(void)
         // Initialize the GLAPI layer.
         _glapi_init();
         __glvndPthreadFuncs.key_create(&threadContextKey, ThreadDestroyed);
+        __glvndPthreadFuncs.key_create(&freeThreadStateKey, free);
+#if !defined(GLDISPATCH_USE_TLS)
+        __glvndPthreadFuncs.key_create(&threadAttachGenerationKey, NULL);
+        __glvndPthreadFuncs.key_create(&currentGenerationKey, NULL);
+#endif
 
         glvnd_list_init(&extProcList);
         glvnd_list_init(&currentDispatchList);
@@ -185,6 +486,27 @@ void __glDispatchInit(void)
 
         // Register GLdispatch's static entrypoints for rewriting
         localDispatchStubId = RegisterStubCallbacks(stub_get_patch_callbacks());
+
+        glvndAtomicStoreRelease(&publishedStubCount, _glapi_get_stub_count());
+
+        InitLazyDispatch();
+        InitSparseDispatch();
+        InitPinVendor();
+        InitPrewarm();
+        __glDispatchSharedTablesInit();
+        __glDispatchNumaInit();
+        __glDispatchLayersInit();
+        __glDispatchRegisterLockStats("GLdispatch", "dispatchLock",
+                &dispatchLock.stats, 1);
+        __glDispatchRegisterMemStats("GLdispatch", glvndMemStats);
+        __glDispatchPrelinkInit();
+
+        // In the fast exit mode, keep a reference to ourselves, so that
+        // __glDispatchFini never tears anything down. The destructor writes
+        // out the reports instead.
+        if (glvndFastExitInit((const void *) __glDispatchInit)) {
+            clientRefcount++;
+        }
     }
 
     clientRefcount++;
@@ -207,190 +529,1094 @@ static void noop_func(void)
     // nop
 }
 
-static void DispatchCurrentRef(__GLdispatchTable *dispatch)
+/*
+ * Adds a table to currentDispatchList, if it isn't there already. The table
+ * must already be filled in.
+ */
+static void RegisterCurrentTable(__GLdispatchTable *dispatch, int vendorID)
 {
     CheckDispatchLocked();
-    dispatch->currentThreads++;
-    if (dispatch->currentThreads == 1) {
+    if (!dispatch->registered) {
+        dispatch->vendorID = vendorID;
         glvnd_list_add(&dispatch->entry, &currentDispatchList);
+        glvndAtomicStoreRelease(&dispatch->registered, 1);
     }
 }
 
-static void DispatchCurrentUnref(__GLdispatchTable *dispatch)
+static void UnregisterCurrentTable(__GLdispatchTable *dispatch)
 {
     CheckDispatchLocked();
-    dispatch->currentThreads--;
-    if (dispatch->currentThreads == 0) {
+    if (dispatch->registered) {
         glvnd_list_del(&dispatch->entry);
+        glvndAtomicStoreRelease(&dispatch->registered, 0);
     }
-    assert(dispatch->currentThreads >= 0);
 }
 
 /*
- * Fix up a dispatch table. Calls to this function must be protected by the
- * dispatch lock.
+ * Since a table stays in currentDispatchList after its last reference goes
+ * away, these don't need the dispatch lock.
  */
-static GLboolean FixupDispatchTable(__GLdispatchTable *dispatch)
+static void DispatchCurrentRef(__GLdispatchTable *dispatch)
 {
-    DBG_PRINTF(20, "dispatch=%p\n", dispatch);
-    CheckDispatchLocked();
-
-    void **tbl;
-    int count = _glapi_get_stub_count();
-    int i;
-
-    if (dispatch->table == NULL) {
-        dispatch->table = (struct _glapi_table *)
-            calloc(1, _glapi_get_dispatch_table_size() * sizeof(void *));
-        if (dispatch->table == NULL) {
-            return GL_FALSE;
-        }
-    }
-
-    tbl = (void **)dispatch->table;
-    for (i=dispatch->stubsPopulated; i<count; i++) {
-        const char *name = _glapi_get_proc_name(i);
-        void *procAddr;
-
-        assert(name != NULL);
+    assert(dispatch->registered);
+    glvndAtomicAdd(&dispatch->currentThreads, 1);
+}
 
-        procAddr = (void*)(*dispatch->getProcAddress)(
-            name, dispatch->getProcAddressParam);
-        tbl[i] = procAddr ? procAddr : (void *)noop_func;
-    }
-    dispatch->stubsPopulated = count;
+static void DispatchCurrentUnref(__GLdispatchTable *dispatch)
+{
+    int count = glvndAtomicAdd(&dispatch->currentThreads, -1);
+    assert(count >= 0);
+    (void) count;
+}
 
-    return GL_TRUE;
+static inline GLboolean SlotIsNeeded(int slot)
+{
+    return (neededSlots == NULL || slot >= neededSlotCount
+            || glvndAtomicLoadAcquire(&neededSlots[slot]) != 0);
 }
 
-PUBLIC __GLdispatchProc __glDispatchGetProcAddress(const char *procName)
+/*
+ * Marks each slot in \p slots as needed. Returns GL_TRUE if any of them
+ * weren't needed before, in which case the current dispatch tables have to
+ * be fixed up.
+ */
+static GLboolean MarkSlotsNeeded(const int *slots, int count)
 {
-    int prevCount;
-    _glapi_proc addr;
+    GLboolean changed = GL_FALSE;
+    int i;
 
-    /*
-     * We need to lock the dispatch before calling into glapi in order to
-     * prevent races when retrieving the entrypoint stub.
-     */
-    LockDispatch();
-    prevCount = _glapi_get_stub_count();
-    addr = _glapi_get_proc_address(procName);
-    if (addr != NULL && prevCount != _glapi_get_stub_count()) {
-        __GLdispatchTable *curDispatch;
+    CheckDispatchLocked();
 
-        /*
-         * Fixup any current dispatch tables to contain the right pointer
-         * to this proc.
-         */
-        glvnd_list_for_each_entry(curDispatch, &currentDispatchList, entry) {
-            // Sanity check: Every current dispatch table must have already
-            // been allocated. That's important because it means
-            // FixupDispatchTable can't fail.
-            assert(curDispatch->table != NULL);
-            FixupDispatchTable(curDispatch);
-        }
+    if (neededSlots == NULL) {
+        return GL_FALSE;
     }
-    UnlockDispatch();
 
-    return addr;
+    for (i=0; i<count; i++) {
+        int slot = slots[i];
+        if (slot >= 0 && slot < neededSlotCount && neededSlots[slot] == 0) {
+            if (!changed) {
+                neededSlotGeneration++;
+                changed = GL_TRUE;
+            }
+            glvndAtomicStoreRelease(&neededSlots[slot], neededSlotGeneration);
+        }
+    }
+    return changed;
 }
 
-PUBLIC __GLdispatchTable *__glDispatchCreateTable(
-        __GLgetProcAddressCallback getProcAddress, void *param)
+static void *LookupSlot(__GLdispatchTable *dispatch, int slot)
 {
-    __GLdispatchTable *dispatch = calloc(1, sizeof(__GLdispatchTable));
-    if (dispatch == NULL) {
-        return NULL;
-    }
+    const char *name = _glapi_get_proc_name(slot);
+    void *procAddr;
 
-    dispatch->getProcAddress = getProcAddress;
-    dispatch->getProcAddressParam = param;
+    assert(name != NULL);
 
-    return dispatch;
+    procAddr = (void*)(*dispatch->getProcAddress)(
+        name, dispatch->getProcAddressParam);
+    return procAddr ? procAddr : (void *)noop_func;
 }
 
-PUBLIC void __glDispatchDestroyTable(__GLdispatchTable *dispatch)
+/*
+ * Fills in any slots before \p end that were skipped the last time this
+ * table was fixed up, but have been registered since then.
+ */
+static GLboolean FixupNewlyNeededSlots(__GLdispatchTable *dispatch, int end)
 {
-    /*
-     * XXX: Technically, dispatch->currentThreads should be 0 if we're calling
-     * into this function, but buggy apps may unload libGLX without losing
-     * current, in which case this won't be true when the dispatch table
-     * is destroyed.
-     */
-    LockDispatch();
-    free(dispatch->table);
-    free(dispatch);
-    UnlockDispatch();
-}
+    void **tbl = (void **) dispatch->table;
+    int i;
 
-static int CurrentEntrypointsSafeToUse(int vendorID)
-{
     CheckDispatchLocked();
-    return !stubOwnerVendorID || (vendorID == stubOwnerVendorID);
+
+    if (neededSlots == NULL || dispatch->slotGeneration == neededSlotGeneration) {
+        return GL_TRUE;
+    }
+
+    // Slots copied from the vendor's static functions were never skipped.
+    for (i=dispatch->staticFuncCount; i<end && i<neededSlotCount; i++) {
+        if (neededSlots[i] > dispatch->slotGeneration) {
+            if (!__glDispatchTableMakeWritable(dispatch, i, i + 1)) {
+                return GL_FALSE;
+            }
+            tbl[i] = LookupSlot(dispatch, i);
+            slotsResolvedCount++;
+        }
+    }
+    return GL_TRUE;
 }
 
-static inline int PatchingIsDisabledByEnvVar(void)
+/*
+ * Does the same thing as FixupDispatchTableBulk, but only looks up the slots
+ * that are needed. The rest are set to a no-op function.
+ */
+static GLboolean FixupDispatchTableBulkSparse(__GLdispatchTable *dispatch,
+        void **tbl, int first, int count)
 {
-    static GLboolean inited = GL_FALSE;
-    static GLboolean disallowPatch = GL_FALSE;
+    const char **names;
+    void **procs;
+    int *slots;
+    int numNeeded = 0;
+    int i;
 
-    CheckDispatchLocked();
+    names = malloc((count - first) * (sizeof(const char *) + sizeof(void *) + sizeof(int)));
+    if (names == NULL) {
+        return GL_FALSE;
+    }
+    procs = (void **) (names + (count - first));
+    slots = (int *) (procs + (count - first));
+
+    for (i=first; i<count; i++) {
+        if (SlotIsNeeded(i)) {
+            names[numNeeded] = _glapi_get_proc_name(i);
+            assert(names[numNeeded] != NULL);
+            procs[numNeeded] = NULL;
+            slots[numNeeded] = i;
+            numNeeded++;
+        }
+        tbl[i] = (void *) noop_func;
+    }
 
-    if (!inited) {
-        char *disallowPatchStr = getenv("__GLVND_DISALLOW_PATCHING");
-        if (disallowPatchStr) {
-            disallowPatch = atoi(disallowPatchStr);
-        } else if (glvndAppErrorCheckGetEnabled()) {
-            // Entrypoint rewriting means skipping the dispatch table in
-            // libGLdispatch, which would disable checking for calling OpenGL
-            // functions without a context.
-            disallowPatch = GL_TRUE;
+    if (numNeeded > 0) {
+        dispatch->getProcAddressBulk(names, procs, numNeeded,
+                dispatch->getProcAddressParam);
+        for (i=0; i<numNeeded; i++) {
+            if (procs[i] != NULL) {
+                tbl[slots[i]] = procs[i];
+            }
         }
-        inited = GL_TRUE;
     }
 
-    return disallowPatch;
+    free(names);
+    return GL_TRUE;
 }
 
-static inline int ContextIsCurrentInAnyOtherThread(void)
+/*
+ * Fills in the missing entries in a dispatch table using the vendor's bulk
+ * lookup callback. Returns GL_FALSE if we couldn't allocate the name list, in
+ * which case the caller should fall back to looking up each function.
+ */
+static GLboolean FixupDispatchTableBulk(__GLdispatchTable *dispatch,
+        void **tbl, int count)
 {
-    int thisThreadsContext = !!__glDispatchGetCurrentThreadState();
-    int otherContexts;
+    const char **names;
+    int first = dispatch->stubsPopulated;
+    int i;
 
     CheckDispatchLocked();
 
-    otherContexts = (numCurrentContexts - thisThreadsContext);
-    assert(otherContexts >= 0);
+    if (count <= first) {
+        return GL_TRUE;
+    }
 
-    return !!otherContexts;
+    if (neededSlots != NULL) {
+        return FixupDispatchTableBulkSparse(dispatch, tbl, first, count);
+    }
+
+    names = malloc((count - first) * sizeof(const char *));
+    if (names == NULL) {
+        return GL_FALSE;
+    }
+    for (i=first; i<count; i++) {
+        names[i - first] = _glapi_get_proc_name(i);
+        assert(names[i - first] != NULL);
+    }
+
+    memset(&tbl[first], 0, (count - first) * sizeof(void *));
+    dispatch->getProcAddressBulk(names, &tbl[first], count - first,
+            dispatch->getProcAddressParam);
+    free(names);
+
+    for (i=first; i<count; i++) {
+        if (tbl[i] == NULL) {
+            tbl[i] = (void *) noop_func;
+        }
+    }
+    return GL_TRUE;
 }
 
-static int PatchingIsSafe(void)
+/*
+ * Fills in the entries for any overflow stubs, which are past the end of the
+ * static and dynamic slots.
+ */
+static GLboolean FixupDispatchTableOverflow(__GLdispatchTable *dispatch,
+        int slotCount, int count)
 {
+    int first = dispatch->stubsPopulated;
+    int i;
+
     CheckDispatchLocked();
 
-    /*
-     * Can only patch entrypoints on supported TLS access models
-     */
-    if (glvnd_list_is_empty(&dispatchStubList)) {
-        return 0;
+    if (first < slotCount) {
+        first = slotCount;
     }
-
-    if (PatchingIsDisabledByEnvVar()) {
-        return 0;
+    if (count <= first) {
+        return GL_TRUE;
     }
 
-    if (ContextIsCurrentInAnyOtherThread()) {
-        return 0;
+    // The chunk pointers are after the last slot, and they might be on a
+    // shared page, too.
+    if (!__glDispatchTableMakeWritable(dispatch, slotCount,
+                _glapi_get_dispatch_table_size())) {
+        return GL_FALSE;
     }
 
-    return 1;
-}
-
-typedef struct __GLdispatchStubCallbackRec {
-    __GLdispatchStubPatchCallbacks callbacks;
-    int id;
-    GLboolean isPatched;
+    for (i=first; i<count; i++) {
+        void **entry = _glapi_get_table_overflow_entry(dispatch->table, i);
+        const char *name = _glapi_get_proc_name(i);
+        void *procAddr;
+
+        if (entry == NULL) {
+            return GL_FALSE;
+        }
+        assert(name != NULL);
+
+        // Overflow stubs don't have lazy trampolines, so always look up the
+        // function here.
+        procAddr = (void*)(*dispatch->getProcAddress)(
+            name, dispatch->getProcAddressParam);
+        *entry = procAddr ? procAddr : (void *)noop_func;
+        slotsResolvedCount++;
+    }
+    return GL_TRUE;
+}
+
+/*
+ * Allocates the memory for a dispatch table, if it doesn't have any yet.
+ */
+static GLboolean AllocDispatchTable(__GLdispatchTable *dispatch)
+{
+    CheckDispatchLocked();
+
+    if (dispatch->table == NULL) {
+        dispatch->table = __glDispatchAllocTableMemory(dispatch);
+        if (dispatch->table == NULL) {
+            return GL_FALSE;
+        }
+        _glapi_init_table_overflow(dispatch->table);
+    }
+    return GL_TRUE;
+}
+
+/*
+ * Does the work for FixupDispatchTable.
+ */
+static GLboolean FixupDispatchTableInternal(__GLdispatchTable *dispatch)
+{
+    DBG_PRINTF(20, "dispatch=%p\n", dispatch);
+    CheckDispatchLocked();
+
+    void **tbl;
+    int first = dispatch->stubsPopulated;
+    int count = _glapi_get_stub_count();
+    int slotCount = _glapi_get_dispatch_table_slot_count();
+    int directCount = (count < slotCount ? count : slotCount);
+    __GLdispatchPrelink *prelink = NULL;
+    int i;
+
+    if (!AllocDispatchTable(dispatch)) {
+        return GL_FALSE;
+    }
+
+    if (dispatch->stubsPopulated >= count
+            && dispatch->slotGeneration == neededSlotGeneration) {
+        // PrefetchDispatchTable might have filled in the table already.
+        PrewarmDispatchTable(dispatch);
+        return GL_TRUE;
+    }
+
+    GLDISPATCH_TRACE(1, GLDISPATCH_TRACE_PHASE_BEGIN, GLDISPATCH_PHASE_FIXUP, 0);
+    GLVND_PROBE1(fixup_begin, dispatch);
+    if (!FixupDispatchTableOverflow(dispatch, slotCount, count)) {
+        goto fail;
+    }
+
+    if (!dispatch->lazy && !FixupNewlyNeededSlots(dispatch,
+                (first < directCount ? first : directCount))) {
+        goto fail;
+    }
+    dispatch->slotGeneration = neededSlotGeneration;
+
+    // If any of the entries that we're about to fill in are on a page that's
+    // shared with another dispatch table, then copy that page first.
+    if (!__glDispatchTableMakeWritable(dispatch, dispatch->stubsPopulated, directCount)) {
+        goto fail;
+    }
+
+    tbl = (void **)dispatch->table;
+    if (dispatch->lazy) {
+        // Point each new slot at its resolver trampoline. The real function
+        // gets looked up in ResolveLazySlot the first time it's called.
+        for (i=dispatch->stubsPopulated; i<directCount; i++) {
+            tbl[i] = (void *) entry_get_lazy_trampoline(i);
+            assert(tbl[i] != NULL);
+        }
+        dispatch->stubsPopulated = count;
+        GLDISPATCH_TRACE(1, GLDISPATCH_TRACE_PHASE_END, GLDISPATCH_PHASE_FIXUP, 0);
+        GLDISPATCH_TRACE(1, GLDISPATCH_TRACE_FIXUP, dispatch, count - first);
+        GLVND_PROBE2(fixup_end, dispatch, count - first);
+        PrewarmDispatchTable(dispatch);
+        return GL_TRUE;
+    }
+
+    // If the vendor handed over its static functions, then just copy them.
+    if (dispatch->stubsPopulated == 0 && dispatch->staticFuncs != NULL) {
+        int staticCount = (dispatch->staticFuncCount < directCount
+                ? dispatch->staticFuncCount : directCount);
+        for (i=0; i<staticCount; i++) {
+            tbl[i] = (dispatch->staticFuncs[i] != NULL
+                    ? (void *) dispatch->staticFuncs[i] : (void *) noop_func);
+        }
+        dispatch->stubsPopulated = staticCount;
+    }
+
+    // The first time a table is filled in, try to copy the static slots from
+    // the on-disk cache. Anything that the cache doesn't have still gets
+    // looked up below.
+    if (dispatch->stubsPopulated == 0) {
+        prelink = __glDispatchPrelinkOpen(dispatch);
+    }
+    if (prelink != NULL) {
+        int prelinked = __glDispatchPrelinkFill(prelink, tbl, directCount,
+                (void *) noop_func);
+        for (i=0; i<prelinked; i++) {
+            if (tbl[i] == NULL) {
+                tbl[i] = (SlotIsNeeded(i) ? LookupSlot(dispatch, i) : (void *) noop_func);
+            }
+        }
+        dispatch->stubsPopulated = prelinked;
+    }
+
+    if (dispatch->getProcAddressBulk == NULL
+            || !FixupDispatchTableBulk(dispatch, tbl, directCount)) {
+        for (i=dispatch->stubsPopulated; i<directCount; i++) {
+            if (SlotIsNeeded(i)) {
+                tbl[i] = LookupSlot(dispatch, i);
+            } else {
+                tbl[i] = (void *) noop_func;
+            }
+        }
+    }
+    if (first < directCount) {
+        slotsResolvedCount += directCount - first;
+    }
+    dispatch->stubsPopulated = count;
+    GLDISPATCH_TRACE(1, GLDISPATCH_TRACE_PHASE_END, GLDISPATCH_PHASE_FIXUP, 0);
+    GLDISPATCH_TRACE(1, GLDISPATCH_TRACE_FIXUP, dispatch, count - first);
+    GLVND_PROBE2(fixup_end, dispatch, count - first);
+
+    if (prelink != NULL) {
+        __glDispatchPrelinkClose(prelink, tbl, directCount);
+    }
+
+    // Now that the table is filled in, share any pages that are the same as
+    // in another table.
+    __glDispatchShareTablePages(dispatch);
+    __glDispatchNumaUpdateReplicas(dispatch);
+    PrewarmDispatchTable(dispatch);
+
+    return GL_TRUE;
+
+fail:
+    // Close out the trace phase and probe, so that every begin has an end.
+    GLDISPATCH_TRACE(1, GLDISPATCH_TRACE_PHASE_END, GLDISPATCH_PHASE_FIXUP, 0);
+    GLVND_PROBE2(fixup_end, dispatch, 0);
+    return GL_FALSE;
+}
+
+/*
+ * Fix up a dispatch table. Calls to this function must be protected by the
+ * dispatch lock.
+ */
+static GLboolean FixupDispatchTable(__GLdispatchTable *dispatch)
+{
+    uint64_t slowOpStart = __glDispatchSlowOpBegin();
+    uint64_t shmStart = __glDispatchShmStatsTimeBegin();
+    int populated = dispatch->stubsPopulated;
+    int slotGeneration = dispatch->slotGeneration;
+    GLboolean ret = FixupDispatchTableInternal(dispatch);
+
+    __glDispatchSlowOpEndTable(slowOpStart, "FixupDispatchTable", dispatch);
+
+    // Most calls find the table already filled in, so only count the ones
+    // that had something to do.
+    if (dispatch->stubsPopulated != populated
+            || dispatch->slotGeneration != slotGeneration) {
+        GLDISPATCH_SHM_STATS_ADD(fixupCount, 1);
+        GLDISPATCH_SHM_STATS_ADD(fixupTimeNS, __glDispatchShmStatsTimeSince(shmStart));
+    }
+    return ret;
+}
+
+/*
+ * Looks up the functions for a dispatch table that hasn't been filled in yet,
+ * without holding the dispatch lock.
+ *
+ * The first FixupDispatchTable call for a vendor can make thousands of
+ * getProcAddress calls, and every other thread's MakeCurrent, LoseCurrent,
+ * and GetProcAddress call would have to wait for it. Instead, this takes a
+ * snapshot of the stubs while holding the lock, looks them up into a private
+ * buffer without it, and then copies them into the table. If any stubs or
+ * needed slots were added in the meantime, then the FixupDispatchTable call
+ * after this picks up only those.
+ *
+ * This is only an optimization. If anything goes wrong, or if another thread
+ * filled in the table first, then the results are just thrown away. The
+ * caller must not hold the dispatch lock.
+ */
+static void PrefetchDispatchTable(__GLdispatchTable *dispatch)
+{
+    const char **names;
+    void **procs;
+    int *slots;
+    int count, slotCount, generation;
+    int numNeeded = 0;
+    uint64_t slowOpStart;
+    uint64_t shmStart;
+    int i;
+
+    LockDispatch();
+
+    // Lazy tables don't look anything up here, and a table with a cache file
+    // or the vendor's static functions is cheap to fill in anyway. The
+    // layers' getProcAddress callbacks expect the dispatch lock to be held,
+    // so skip any table with layers, too.
+    if (dispatch->lazy || dispatch->stubsPopulated != 0 || dispatch->prefetching
+            || dispatch->layerNext != NULL || dispatch->staticFuncs != NULL
+            || (dispatch->vendorHandle != NULL && __glDispatchPrelinkIsEnabled())) {
+        UnlockDispatch();
+        return;
+    }
+
+    count = _glapi_get_stub_count();
+    slotCount = _glapi_get_dispatch_table_slot_count();
+    if (count > slotCount) {
+        count = slotCount;
+    }
+    generation = neededSlotGeneration;
+
+    names = malloc(count * (sizeof(const char *) + sizeof(void *) + sizeof(int)));
+    if (names == NULL) {
+        UnlockDispatch();
+        return;
+    }
+    procs = (void **) (names + count);
+    slots = (int *) (procs + count);
+
+    for (i=0; i<count; i++) {
+        if (SlotIsNeeded(i)) {
+            names[numNeeded] = _glapi_get_proc_name(i);
+            assert(names[numNeeded] != NULL);
+            procs[numNeeded] = NULL;
+            slots[numNeeded] = i;
+            numNeeded++;
+        }
+    }
+    dispatch->prefetching = GL_TRUE;
+    UnlockDispatch();
+
+    slowOpStart = __glDispatchSlowOpBegin();
+    shmStart = __glDispatchShmStatsTimeBegin();
+    GLDISPATCH_TRACE(1, GLDISPATCH_TRACE_PHASE_BEGIN, GLDISPATCH_PHASE_FIXUP, 0);
+    if (dispatch->getProcAddressBulk != NULL) {
+        dispatch->getProcAddressBulk(names, procs, numNeeded,
+                dispatch->getProcAddressParam);
+    } else {
+        for (i=0; i<numNeeded; i++) {
+            procs[i] = (*dispatch->getProcAddress)(names[i],
+                    dispatch->getProcAddressParam);
+        }
+    }
+    GLDISPATCH_TRACE(1, GLDISPATCH_TRACE_PHASE_END, GLDISPATCH_PHASE_FIXUP, 0);
+    __glDispatchSlowOpEndTable(slowOpStart, "PrefetchDispatchTable", dispatch);
+
+    LockDispatch();
+    dispatch->prefetching = GL_FALSE;
+    if (dispatch->stubsPopulated == 0 && AllocDispatchTable(dispatch)
+            && __glDispatchTableMakeWritable(dispatch, 0, count)) {
+        void **tbl = (void **) dispatch->table;
+
+        for (i=0; i<count; i++) {
+            tbl[i] = (void *) noop_func;
+        }
+        for (i=0; i<numNeeded; i++) {
+            if (procs[i] != NULL) {
+                tbl[slots[i]] = procs[i];
+            }
+        }
+        slotsResolvedCount += count;
+        dispatch->stubsPopulated = count;
+        dispatch->slotGeneration = generation;
+        GLDISPATCH_TRACE(1, GLDISPATCH_TRACE_FIXUP, dispatch, count);
+        GLDISPATCH_SHM_STATS_ADD(fixupCount, 1);
+        GLDISPATCH_SHM_STATS_ADD(fixupTimeNS, __glDispatchShmStatsTimeSince(shmStart));
+
+        // FixupDispatchTable won't do anything else if no stubs were added
+        // in the meantime, so finish the same way that it would.
+        __glDispatchShareTablePages(dispatch);
+        __glDispatchNumaUpdateReplicas(dispatch);
+    }
+    UnlockDispatch();
+
+    free(names);
+}
+
+__GLdispatchTable *__glDispatchGetCurrentTable(void)
+{
+    __GLdispatchThreadState *threadState = __glDispatchGetCurrentThreadState();
+
+    if (threadState != NULL && threadState->priv != NULL) {
+        return threadState->priv->dispatch;
+    }
+    return NULL;
+}
+
+/*
+ * Called from a lazy resolver trampoline the first time a function is called
+ * through a lazily populated dispatch table. This looks up the real function,
+ * stores it in the current dispatch table, and returns it so that the
+ * trampoline can jump to it.
+ */
+static mapi_func ResolveLazySlot(int slot)
+{
+    __GLdispatchThreadState *threadState = __glDispatchGetCurrentThreadState();
+    mapi_func func = (mapi_func) noop_func;
+
+    if (threadState != NULL && threadState->priv != NULL
+            && threadState->priv->dispatch != NULL) {
+        __GLdispatchTable *dispatch = threadState->priv->dispatch;
+        void **tbl;
+
+        LockDispatch();
+        tbl = (void **) dispatch->table;
+
+        // Another thread with the same dispatch table may have resolved this
+        // slot already.
+        if (tbl[slot] == (void *) entry_get_lazy_trampoline(slot)) {
+            const char *name = _glapi_get_proc_name(slot);
+            void *procAddr;
+
+            assert(name != NULL);
+            procAddr = (*dispatch->getProcAddress)(name,
+                    dispatch->getProcAddressParam);
+            tbl[slot] = procAddr ? procAddr : (void *) noop_func;
+            slotsResolvedCount++;
+        }
+        func = (mapi_func) tbl[slot];
+        UnlockDispatch();
+    }
+
+    return func;
+}
+
+static void InitLazyDispatch(void)
+{
+    const char *env = glvndGetEnv("__GLVND_LAZY_DISPATCH");
+
+    CheckDispatchLocked();
+
+    lazyDispatchEnabled = GL_FALSE;
+    if (env != NULL && atoi(env) != 0) {
+        entry_set_lazy_resolve_callback(ResolveLazySlot);
+
+        // The trampolines aren't available on every architecture.
+        if (entry_get_lazy_trampoline(0) != NULL) {
+            lazyDispatchEnabled = GL_TRUE;
+        }
+    }
+}
+
+static void InitPinVendor(void)
+{
+    const char *env = glvndGetEnv("__GLVND_PIN_VENDOR");
+
+    CheckDispatchLocked();
+
+    pinVendorEnabled = (env != NULL && atoi(env) != 0);
+    pinnedVendorID = 0;
+    pinnedTableCount = 0;
+}
+
+static void InitSparseDispatch(void)
+{
+    const char *env = glvndGetEnv("__GLVND_SPARSE_DISPATCH");
+
+    CheckDispatchLocked();
+
+    // With lazy dispatch, a slot doesn't cost anything until it's called, so
+    // there's no reason to filter them here.
+    if (lazyDispatchEnabled || (env != NULL && atoi(env) == 0)) {
+        return;
+    }
+
+    neededSlotCount = _glapi_get_dispatch_table_slot_count();
+    neededSlots = calloc(neededSlotCount, sizeof(int));
+    if (neededSlots == NULL) {
+        neededSlotCount = 0;
+    }
+}
+
+static void FixupCurrentDispatchTables(void)
+{
+    __GLdispatchTable *curDispatch;
+
+    CheckDispatchLocked();
+
+    glvnd_list_for_each_entry(curDispatch, &currentDispatchList, entry) {
+        // Sanity check: Every current dispatch table must have already
+        // been allocated. That's important because it means
+        // FixupDispatchTable can't fail.
+        assert(curDispatch->table != NULL);
+        FixupDispatchTable(curDispatch);
+    }
+    __glDispatchCallCountUpdateTables();
+}
+
+PUBLIC void __glDispatchRegisterStubSlots(const int *slots, int count)
+{
+    LockDispatch();
+    if (MarkSlotsNeeded(slots, count)) {
+        FixupCurrentDispatchTables();
+    }
+    UnlockDispatch();
+}
+
+PUBLIC __GLdispatchProc __glDispatchGetProcAddress(const char *procName)
+{
+    int prevCount;
+    int index;
+    _glapi_proc addr;
+
+    /*
+     * Most lookups are for functions that already have a stub. If the stub is
+     * already in every current dispatch table, then we can return it without
+     * taking the lock.
+     */
+    addr = _glapi_find_proc_address(procName, &index);
+    if (addr != NULL && index < glvndAtomicLoadAcquire(&publishedStubCount)
+            && SlotIsNeeded(index)) {
+        return addr;
+    }
+
+    /*
+     * We need to lock the dispatch before calling into glapi in order to
+     * prevent races when retrieving the entrypoint stub.
+     */
+    LockDispatch();
+    prevCount = _glapi_get_stub_count();
+    addr = _glapi_get_proc_address(procName);
+    if (addr != NULL) {
+        GLboolean changed = (prevCount != _glapi_get_stub_count());
+
+        if (changed) {
+            __glDispatchSymbolMapAddStubs(prevCount, _glapi_get_stub_count());
+        }
+
+        // Anything that the application can look up has to be filled in,
+        // even if none of the client libraries exports it.
+        if (_glapi_find_proc_address(procName, &index) != NULL
+                && MarkSlotsNeeded(&index, 1)) {
+            changed = GL_TRUE;
+        }
+
+        /*
+         * Fixup any current dispatch tables to contain the right pointer
+         * to this proc.
+         */
+        if (changed) {
+            FixupCurrentDispatchTables();
+        }
+    }
+    glvndAtomicStoreRelease(&publishedStubCount, _glapi_get_stub_count());
+    UnlockDispatch();
+
+    return addr;
+}
+
+PUBLIC void __glDispatchGetProcAddresses(const char * const *procNames,
+        __GLdispatchProc *procs, int count)
+{
+    GLboolean changed = GL_FALSE;
+    int numMissing = 0;
+    int prevCount;
+    int index;
+    int i;
+
+    // Fill in everything that already has a published stub without locking,
+    // the same as __glDispatchGetProcAddress.
+    for (i=0; i<count; i++) {
+        _glapi_proc addr = _glapi_find_proc_address(procNames[i], &index);
+        if (addr != NULL && index < glvndAtomicLoadAcquire(&publishedStubCount)
+                && SlotIsNeeded(index)) {
+            procs[i] = addr;
+        } else {
+            procs[i] = NULL;
+            numMissing++;
+        }
+    }
+    if (numMissing == 0) {
+        return;
+    }
+
+    LockDispatch();
+    prevCount = _glapi_get_stub_count();
+    for (i=0; i<count; i++) {
+        if (procs[i] != NULL) {
+            continue;
+        }
+        procs[i] = _glapi_get_proc_address(procNames[i]);
+        if (procs[i] != NULL
+                && _glapi_find_proc_address(procNames[i], &index) != NULL
+                && MarkSlotsNeeded(&index, 1)) {
+            changed = GL_TRUE;
+        }
+    }
+
+    // Any new stubs only have to be added to the current dispatch tables
+    // once, no matter how many of them there are.
+    if (changed || prevCount != _glapi_get_stub_count()) {
+        __glDispatchSymbolMapAddStubs(prevCount, _glapi_get_stub_count());
+        FixupCurrentDispatchTables();
+    }
+    glvndAtomicStoreRelease(&publishedStubCount, _glapi_get_stub_count());
+    UnlockDispatch();
+}
+
+PUBLIC const char *__glDispatchInternString(const char *str)
+{
+    return __glvndStringPoolIntern(str);
+}
+
+PUBLIC uint32_t __glDispatchInternedStringHash(const char *str)
+{
+    return __glvndStringPoolGetHash(str);
+}
+
+PUBLIC __GLdispatchProc __glDispatchGetPublicStub(int slot)
+{
+    return _glapi_get_public_stub(slot);
+}
+
+PUBLIC unsigned long __glDispatchGetCurrentGeneration(void)
+{
+#if defined(GLDISPATCH_USE_TLS)
+    return currentGeneration;
+#else
+    return (unsigned long) (uintptr_t) __glvndPthreadFuncs.getspecific(currentGenerationKey);
+#endif
+}
+
+static void IncrementCurrentGeneration(void)
+{
+#if defined(GLDISPATCH_USE_TLS)
+    currentGeneration++;
+#else
+    __glvndPthreadFuncs.setspecific(currentGenerationKey,
+            (void *) (uintptr_t) (__glDispatchGetCurrentGeneration() + 1));
+#endif
+}
+
+PUBLIC __GLdispatchProc __glDispatchGetCurrentProc(const char *procName,
+        unsigned long *generation)
+{
+    __GLdispatchThreadState *threadState = __glDispatchGetCurrentThreadState();
+    __GLdispatchProc func;
+    void **tbl;
+    int index;
+
+    if (generation != NULL) {
+        *generation = __glDispatchGetCurrentGeneration();
+    }
+    if (threadState == NULL || threadState->priv == NULL
+            || threadState->priv->dispatch == NULL) {
+        return NULL;
+    }
+
+    // This makes sure that the function has a slot, and that the slot is
+    // filled in for every current dispatch table.
+    if (__glDispatchGetProcAddress(procName) == NULL
+            || _glapi_find_proc_address(procName, &index) == NULL) {
+        return NULL;
+    }
+
+    tbl = (void **) threadState->priv->dispatch->table;
+    if (index >= (int) _glapi_get_dispatch_table_slot_count()) {
+        void **entry = _glapi_get_table_overflow_entry(
+                threadState->priv->dispatch->table, index);
+        return (entry != NULL ? (__GLdispatchProc) *entry : NULL);
+    }
+
+    func = (__GLdispatchProc) tbl[index];
+    if ((mapi_func) func == entry_get_lazy_trampoline(index)) {
+        func = (__GLdispatchProc) ResolveLazySlot(index);
+    }
+    return func;
+}
+
+PUBLIC GLboolean __glDispatchGetCallCount(int index, const char **name,
+        uint64_t *count)
+{
+    GLboolean ret = GL_FALSE;
+
+    LockDispatch();
+    if (__glDispatchCallCountEnabled() && index >= 0
+            && index < _glapi_get_stub_count()
+            && index < (int) _glapi_get_dispatch_table_slot_count()) {
+        *name = _glapi_get_proc_name(index);
+        *count = __glDispatchCallCountGet(index);
+        ret = GL_TRUE;
+    }
+    UnlockDispatch();
+
+    return ret;
+}
+
+PUBLIC __GLdispatchTable *__glDispatchCreateTable(
+        __GLgetProcAddressCallback getProcAddress, void *param)
+{
+    return __glDispatchCreateTableBulk(getProcAddress, NULL, param);
+}
+
+PUBLIC __GLdispatchTable *__glDispatchCreateTableBulk(
+        __GLgetProcAddressCallback getProcAddress,
+        __GLgetProcAddressBulkCallback getProcAddressBulk,
+        void *param)
+{
+    __GLdispatchTable *dispatch = calloc(1, sizeof(__GLdispatchTable));
+    if (dispatch == NULL) {
+        return NULL;
+    }
+    glvndMemStatsAlloc(GLVND_MEM_DISPATCH_TABLE, sizeof(__GLdispatchTable));
+
+    dispatch->getProcAddress = getProcAddress;
+    dispatch->getProcAddressBulk = getProcAddressBulk;
+    dispatch->getProcAddressParam = param;
+    dispatch->lazy = lazyDispatchEnabled;
+
+    LockDispatch();
+    __glDispatchLayersInitTable(dispatch);
+    numDispatchTables++;
+    UnlockDispatch();
+
+    return dispatch;
+}
+
+PUBLIC void __glDispatchSetTableVendor(__GLdispatchTable *dispatch,
+        void *vendorHandle, const char *tag)
+{
+    char *tagCopy;
+
+    // A cache file would have the layers' functions in it, so don't cache a
+    // table with layers.
+    if (vendorHandle == NULL || dispatch->layerNext != NULL
+            || !__glDispatchPrelinkIsValidTag(tag)) {
+        return;
+    }
+    tagCopy = strdup(tag);
+    if (tagCopy == NULL) {
+        return;
+    }
+
+    LockDispatch();
+    free(dispatch->vendorTag);
+    dispatch->vendorHandle = vendorHandle;
+    dispatch->vendorTag = tagCopy;
+    UnlockDispatch();
+}
+
+PUBLIC uint32_t __glDispatchGetTableLayout(int *staticCount)
+{
+    if (staticCount != NULL) {
+        *staticCount = _glapi_get_static_stub_count();
+    }
+    return _glapi_get_static_layout_hash();
+}
+
+PUBLIC GLboolean __glDispatchSetTableStaticFuncs(__GLdispatchTable *dispatch,
+        uint32_t layoutHash, const void * const *funcs, int count)
+{
+    GLboolean ret = GL_FALSE;
+
+    if (funcs == NULL || count <= 0
+            || layoutHash != _glapi_get_static_layout_hash()) {
+        return GL_FALSE;
+    }
+    if (count > (int) _glapi_get_static_stub_count()) {
+        count = _glapi_get_static_stub_count();
+    }
+
+    LockDispatch();
+    // The layers have to wrap each function when it's looked up, so a table
+    // with layers still has to look up everything.
+    if (dispatch->stubsPopulated == 0 && !dispatch->prefetching
+            && dispatch->layerNext == NULL) {
+        dispatch->staticFuncs = funcs;
+        dispatch->staticFuncCount = count;
+        // Every static function is already known, so there's nothing for a
+        // lazy table to put off.
+        dispatch->lazy = GL_FALSE;
+        ret = GL_TRUE;
+    }
+    UnlockDispatch();
+
+    return ret;
+}
+
+PUBLIC void __glDispatchDestroyTable(__GLdispatchTable *dispatch)
+{
+    /*
+     * XXX: Technically, dispatch->currentThreads should be 0 if we're calling
+     * into this function, but buggy apps may unload libGLX without losing
+     * current, in which case this won't be true when the dispatch table
+     * is destroyed.
+     */
+    LockDispatch();
+    if (dispatch->pinned) {
+        DispatchCurrentUnref(dispatch);
+        if (--pinnedTableCount == 0) {
+            glvndAtomicStoreRelease(&pinnedVendorID, 0);
+        }
+    }
+    UnregisterCurrentTable(dispatch);
+    if (dispatch->table != NULL) {
+        _glapi_free_table_overflow(dispatch->table);
+    }
+    __glDispatchNumaFreeReplicas(dispatch);
+    __glDispatchFreeTableMemory(dispatch);
+    __glDispatchLayersFreeTable(dispatch);
+    free(dispatch->vendorTag);
+    free(dispatch);
+    glvndMemStatsFree(GLVND_MEM_DISPATCH_TABLE, sizeof(__GLdispatchTable));
+    numDispatchTables--;
+    UnlockDispatch();
+}
+
+static int CurrentEntrypointsSafeToUse(int vendorID)
+{
+    CheckDispatchLocked();
+    return !stubOwnerVendorID || (vendorID == stubOwnerVendorID);
+}
+
+/*
+ * Returns one of the GLDISPATCH_PATCH_DISABLED_* values.
+ */
+static int GetPatchDisabledReason(void)
+{
+    static GLboolean inited = GL_FALSE;
+    static int disabledReason = GLDISPATCH_PATCH_DISABLED_NONE;
+
+    CheckDispatchLocked();
+
+    if (!inited) {
+        const char *disallowPatchStr = glvndGetEnv("__GLVND_DISALLOW_PATCHING");
+        // Entrypoint rewriting means skipping the dispatch table in
+        // libGLdispatch, which would hide the calls from the call counters
+        // and the layers. App error checking still works, since the default
+        // entrypoints are restored when no context is current (see
+        // RestoreEntrypointsForErrorCheck).
+        if (disallowPatchStr) {
+            if (atoi(disallowPatchStr)) {
+                disabledReason = GLDISPATCH_PATCH_DISABLED_ENV_VAR;
+            }
+        } else if (__glDispatchCallCountEnabled()) {
+            disabledReason = GLDISPATCH_PATCH_DISABLED_CALL_COUNTS;
+        } else if (__glDispatchLayersEnabled()) {
+            disabledReason = GLDISPATCH_PATCH_DISABLED_LAYERS;
+        }
+        inited = GL_TRUE;
+    }
+
+    return disabledReason;
+}
+
+static inline int ContextIsCurrentInAnyOtherThread(void)
+{
+    int thisThreadsContext = !!__glDispatchGetCurrentThreadState();
+    int otherContexts;
+
+    CheckDispatchLocked();
+
+    otherContexts = (glvndAtomicLoadAcquire(&numCurrentContexts) - thisThreadsContext);
+    assert(otherContexts >= 0);
+
+    return !!otherContexts;
+}
+
+static int ContextFromOtherVendorIsCurrent(int vendorID)
+{
+    __GLdispatchTable *dispatch;
+
+    CheckDispatchLocked();
+
+    // Every current table is in currentDispatchList, since a table is
+    // registered before its first reference.
+    glvnd_list_for_each_entry(dispatch, &currentDispatchList, entry) {
+        if (dispatch->vendorID != vendorID
+                && glvndAtomicLoadAcquire(&dispatch->currentThreads) > 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Returns true if the given patch callbacks only change the entrypoints
+ * through PatchSetStubTarget. A NULL pointer means the default entrypoints.
+ */
+static inline int PatchUsesTargets(const __GLdispatchPatchCallbacks *patchCb)
+{
+    return (patchCb == NULL || patchCb->initiatePatchTargets != NULL);
+}
+
+/*
+ * Checks whether it's safe to switch from the current patch to \p patchCb.
+ *
+ * \return GLDISPATCH_PATCH_REFUSED_NONE if it's safe, or else one of the
+ * GLDISPATCH_PATCH_REFUSED_* values.
+ */
+static int GetPatchRefusal(const __GLdispatchPatchCallbacks *patchCb,
+        int vendorID)
+{
+    CheckDispatchLocked();
+
+    /*
+     * Can only patch entrypoints on supported TLS access models
+     */
+    if (glvnd_list_is_empty(&dispatchStubList)) {
+        return GLDISPATCH_PATCH_REFUSED_NO_STUBS;
+    }
+
+    if (GetPatchDisabledReason() != GLDISPATCH_PATCH_DISABLED_NONE) {
+        return GLDISPATCH_PATCH_REFUSED_DISABLED;
+    }
+
+    if (ContextIsCurrentInAnyOtherThread()) {
+        // Another thread could be running the entrypoints, so we can only
+        // change them one jump at a time, with PatchSetStubTarget. That
+        // means that both the current and the new patch have to use it.
+        if (!PatchUsesTargets(stubCurrentPatchCb)
+                || !PatchUsesTargets(patchCb)) {
+            return GLDISPATCH_PATCH_REFUSED_OTHER_THREAD;
+        }
+
+        // We also can't point the entrypoints at one vendor while another
+        // vendor's context is current.
+        if (patchCb != NULL && ContextFromOtherVendorIsCurrent(vendorID)) {
+            return GLDISPATCH_PATCH_REFUSED_OTHER_VENDOR;
+        }
+    }
+
+    return GLDISPATCH_PATCH_REFUSED_NONE;
+}
+
+static inline int PatchingIsSafe(const __GLdispatchPatchCallbacks *patchCb,
+        int vendorID)
+{
+    return (GetPatchRefusal(patchCb, vendorID) == GLDISPATCH_PATCH_REFUSED_NONE);
+}
+
+typedef struct __GLdispatchStubCallbackRec {
+    __GLdispatchStubPatchCallbacks callbacks;
+    int id;
+    GLboolean isPatched;
 
     struct glvnd_list entry;
 } __GLdispatchStubCallback;
@@ -453,6 +1679,56 @@ void __glDispatchUnregisterStubCallbacks(int stubId)
     UnlockDispatch();
 }
 
+/*
+ * The stubs that PatchSetStubTarget is currently patching. This is only used
+ * while holding the dispatch lock.
+ */
+static __GLdispatchStubCallback *patchTargetStub;
+static int patchTargetCount;
+
+static GLboolean PatchSetStubTarget(const char *funcName, const void *target)
+{
+    CheckDispatchLocked();
+    assert(patchTargetStub != NULL);
+
+    if (!patchTargetStub->callbacks.setStubTarget(funcName, target)) {
+        return GL_FALSE;
+    }
+    patchTargetCount++;
+    return GL_TRUE;
+}
+
+/*
+ * Patches one set of stubs using the vendor's initiatePatchTargets callback.
+ */
+static GLboolean PatchStubTargets(const __GLdispatchPatchCallbacks *patchCb,
+        __GLdispatchStubCallback *stub)
+{
+    GLboolean success;
+
+    CheckDispatchLocked();
+
+    if (stub->callbacks.setStubTarget == NULL) {
+        return GL_FALSE;
+    }
+    if (!stub->callbacks.startPatch()) {
+        return GL_FALSE;
+    }
+
+    patchTargetStub = stub;
+    patchTargetCount = 0;
+    success = patchCb->initiatePatchTargets(PatchSetStubTarget);
+    patchTargetStub = NULL;
+
+    if (success && patchTargetCount > 0) {
+        stub->callbacks.finishPatch();
+        return GL_TRUE;
+    } else {
+        stub->callbacks.abortPatch();
+        return GL_FALSE;
+    }
+}
+
 void UnregisterAllStubCallbacks(void)
 {
     __GLdispatchStubCallback *curStub, *tmpStub;
@@ -467,14 +1743,21 @@ void UnregisterAllStubCallbacks(void)
 }
 
 
+static uint64_t GetTimeUS(void)
+{
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0) {
+        return 0;
+    }
+    return ((uint64_t) ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
 /*
- * Attempt to patch entrypoints with the given patch function and vendor ID.
- * If the function pointers are NULL, then this attempts to restore the default
- * libglvnd entrypoints.
- *
- * Returns 1 on success, 0 on failure.
+ * Does the work for PatchEntrypoints. The caller must have already made
+ * patchSequence odd.
  */
-static int PatchEntrypoints(
+static int UpdateEntrypoints(
    const __GLdispatchPatchCallbacks *patchCb,
    int vendorID,
    GLboolean force
@@ -483,8 +1766,24 @@ static int PatchEntrypoints(
     __GLdispatchStubCallback *stub;
     CheckDispatchLocked();
 
-    if (!force && !PatchingIsSafe()) {
-        return 0;
+    if (!force) {
+        int refusal = GetPatchRefusal(patchCb, vendorID);
+        if (refusal != GLDISPATCH_PATCH_REFUSED_NONE) {
+            if (patchCb != NULL) {
+                lastPatchRefusal = refusal;
+                lastPatchRefusalVendorID = vendorID;
+                patchRefusalCount++;
+            }
+
+            // If the entrypoints can't use this vendor's patch, but they
+            // belong to another vendor, then try to restore the default
+            // entrypoints, so that this vendor can still use them. That works
+            // if the current patch only uses PatchSetStubTarget.
+            if (!CurrentEntrypointsSafeToUse(vendorID) && PatchingIsSafe(NULL, 0)) {
+                UpdateEntrypoints(NULL, 0, GL_FALSE);
+            }
+            return 0;
+        }
     }
 
     if (patchCb == stubCurrentPatchCb) {
@@ -492,6 +1791,10 @@ static int PatchEntrypoints(
         return 1;
     }
 
+    uint64_t startTime = GetTimeUS();
+    uint64_t slowOpStart = __glDispatchSlowOpBegin();
+    GLVND_PROBE2(patch_begin, vendorID, _glapi_get_stub_count());
+
     if (stubCurrentPatchCb) {
         // Notify the previous vendor that it no longer owns these
         // entrypoints. If this is being called from a library unload,
@@ -511,13 +1814,19 @@ static int PatchEntrypoints(
 
         stubCurrentPatchCb = NULL;
         stubOwnerVendorID = 0;
+        unpatchCount++;
     }
 
     if (patchCb) {
         GLboolean anySuccess = GL_FALSE;
 
         glvnd_list_for_each_entry(stub, &dispatchStubList, entry) {
-            if (patchCb->isPatchSupported(stub->callbacks.getStubType(),
+            if (patchCb->initiatePatchTargets != NULL) {
+                stub->isPatched = PatchStubTargets(patchCb, stub);
+                if (stub->isPatched) {
+                    anySuccess = GL_TRUE;
+                }
+            } else if (patchCb->isPatchSupported(stub->callbacks.getStubType(),
                         stub->callbacks.getStubSize()))
             {
                 if (stub->callbacks.startPatch()) {
@@ -543,13 +1852,309 @@ static int PatchEntrypoints(
         if (anySuccess) {
             stubCurrentPatchCb = patchCb;
             stubOwnerVendorID = vendorID;
+            patchCount++;
         } else {
             stubCurrentPatchCb = NULL;
             stubOwnerVendorID = 0;
         }
     }
 
-    return 1;
+    // Make every thread go back through the locked path in
+    // __glDispatchCheckMultithreaded, so that the new vendor gets a
+    // threadAttach call.
+    glvndAtomicStoreRelease(&threadAttachGeneration,
+            threadAttachGeneration + 1);
+
+    patchTimeUS += GetTimeUS() - startTime;
+    DBG_PRINTF(10, "Patching entrypoints for vendor %d took %llu us\n",
+            stubOwnerVendorID,
+            (unsigned long long) (GetTimeUS() - startTime));
+    __glDispatchSlowOpEnd(slowOpStart, "PatchEntrypoints", NULL, vendorID);
+    GLDISPATCH_TRACE(1, GLDISPATCH_TRACE_PATCH, vendorID, stubOwnerVendorID);
+    GLVND_PROBE2(patch_end, vendorID, stubOwnerVendorID);
+
+    return 1;
+}
+
+/*
+ * Attempt to patch entrypoints with the given patch function and vendor ID.
+ * If the function pointers are NULL, then this attempts to restore the default
+ * libglvnd entrypoints.
+ *
+ * Returns 1 on success, 0 on failure.
+ */
+static int PatchEntrypoints(
+   const __GLdispatchPatchCallbacks *patchCb,
+   int vendorID,
+   GLboolean force
+)
+{
+    int ret;
+
+    CheckDispatchLocked();
+
+    if (!force && patchCb == stubCurrentPatchCb
+            && CurrentEntrypointsSafeToUse(vendorID)) {
+        // Nothing would change, so don't make MakeCurrentFast retry.
+        return 1;
+    }
+
+    // This has to come before PatchingIsSafe counts the current contexts.
+    // Either PatchingIsSafe sees a context from MakeCurrentFast, or
+    // MakeCurrentFast sees that patchSequence changed.
+    glvndAtomicStoreRelease(&patchSequence, patchSequence + 1);
+    glvndAtomicFence();
+
+    ret = UpdateEntrypoints(patchCb, vendorID, force);
+
+    glvndAtomicStoreRelease(&patchSequence, patchSequence + 1);
+    return ret;
+}
+
+static int GetThreadAttachGenerationSeen(void)
+{
+#if defined(GLDISPATCH_USE_TLS)
+    return threadAttachGenerationSeen;
+#else
+    return (int) (intptr_t) __glvndPthreadFuncs.getspecific(threadAttachGenerationKey);
+#endif
+}
+
+static void SetThreadAttachGenerationSeen(int generation)
+{
+#if defined(GLDISPATCH_USE_TLS)
+    threadAttachGenerationSeen = generation;
+#else
+    __glvndPthreadFuncs.setspecific(threadAttachGenerationKey,
+            (void *) (intptr_t) generation);
+#endif
+}
+
+/*
+ * Makes sure that \p vendorID is the pinned vendor and that \p dispatch is
+ * one of its pinned tables. This pins the vendor if nothing else has been
+ * pinned yet.
+ *
+ * Once a table is pinned, it stays in currentDispatchList, so
+ * FixupCurrentDispatchTables keeps it up to date and the common case here
+ * doesn't need the dispatch lock.
+ */
+static GLboolean PinVendorTable(__GLdispatchTable *dispatch, int vendorID,
+        const __GLdispatchPatchCallbacks *patchCb)
+{
+    int pinned = glvndAtomicLoadAcquire(&pinnedVendorID);
+
+    if (pinned == vendorID && glvndAtomicLoadAcquire(&dispatch->pinned)) {
+        return GL_TRUE;
+    } else if (pinned != 0 && pinned != vendorID) {
+        return GL_FALSE;
+    }
+
+    PrefetchDispatchTable(dispatch);
+
+    LockDispatch();
+    if (pinnedVendorID == 0) {
+        // Pinned contexts aren't counted in numCurrentContexts, but this
+        // is the first context from any vendor, so nothing else can be
+        // current yet. Any patching happens here and only here.
+        PatchEntrypoints(patchCb, vendorID, GL_FALSE);
+        if (!CurrentEntrypointsSafeToUse(vendorID)) {
+            UnlockDispatch();
+            return GL_FALSE;
+        }
+    } else if (pinnedVendorID != vendorID) {
+        UnlockDispatch();
+        return GL_FALSE;
+    }
+
+    if (!dispatch->pinned) {
+        if (!FixupDispatchTable(dispatch)) {
+            UnlockDispatch();
+            return GL_FALSE;
+        }
+        RegisterCurrentTable(dispatch, vendorID);
+        DispatchCurrentRef(dispatch);
+        pinnedTableCount++;
+        glvndAtomicStoreRelease(&dispatch->pinned, 1);
+    }
+    glvndAtomicStoreRelease(&pinnedVendorID, vendorID);
+    UnlockDispatch();
+
+    return GL_TRUE;
+}
+
+/**
+ * Returns a private data structure for an API state, reusing the current
+ * thread's free one if possible.
+ */
+static __GLdispatchThreadStatePrivate *AllocThreadStatePrivate(
+        __GLdispatchThreadState *threadState, __GLdispatchTable *dispatch,
+        int vendorID, const __GLdispatchPatchCallbacks *patchCb,
+        GLboolean pinned)
+{
+    __GLdispatchThreadStatePrivate *priv = (__GLdispatchThreadStatePrivate *)
+        __glvndPthreadFuncs.getspecific(freeThreadStateKey);
+
+    if (priv != NULL) {
+        __glvndPthreadFuncs.setspecific(freeThreadStateKey, NULL);
+    } else {
+        priv = (__GLdispatchThreadStatePrivate *) malloc(sizeof(__GLdispatchThreadStatePrivate));
+        if (priv == NULL) {
+            return NULL;
+        }
+    }
+
+    priv->dispatch = dispatch;
+    priv->vendorID = vendorID;
+    priv->patchCb = patchCb;
+    priv->threadState = threadState;
+    priv->pinned = pinned;
+    priv->display = NULL;
+    priv->context = NULL;
+    priv->vendorContext = NULL;
+    return priv;
+}
+
+/**
+ * Keeps a private data structure for the next AllocThreadStatePrivate call
+ * on this thread, or frees it if the thread already has one.
+ */
+static void FreeThreadStatePrivate(__GLdispatchThreadStatePrivate *priv)
+{
+    if (__glvndPthreadFuncs.getspecific(freeThreadStateKey) == NULL) {
+        __glvndPthreadFuncs.setspecific(freeThreadStateKey, priv);
+    } else {
+        free(priv);
+    }
+}
+
+/*
+ * Returns true if the entrypoints are already in the state that
+ * PatchEntrypoints would leave them in for \p patchCb and \p vendorID.
+ */
+static inline GLboolean PatchIsCurrent(const __GLdispatchPatchCallbacks *patchCb,
+        int vendorID)
+{
+    if (glvndAtomicLoadAcquirePtr((void * volatile *) &stubCurrentPatchCb) != patchCb) {
+        return GL_FALSE;
+    }
+    return (patchCb == NULL
+            || glvndAtomicLoadAcquire(&stubOwnerVendorID) == vendorID);
+}
+
+/*
+ * Counts \p dispatch as current without taking the dispatch lock.
+ *
+ * This only works if the table is already in currentDispatchList, which
+ * means it's filled in and FixupCurrentDispatchTables will keep it that way,
+ * and if the entrypoints don't need to be patched. Otherwise, the caller has
+ * to go through the locked path.
+ */
+static GLboolean MakeCurrentFast(__GLdispatchTable *dispatch, int vendorID,
+        const __GLdispatchPatchCallbacks *patchCb)
+{
+    int seq = glvndAtomicLoadAcquire(&patchSequence);
+
+    if ((seq & 1) || !glvndAtomicLoadAcquire(&dispatch->registered)
+            || !PatchIsCurrent(patchCb, vendorID)) {
+        return GL_FALSE;
+    }
+
+    DispatchCurrentRef(dispatch);
+    glvndAtomicAdd(&numCurrentContexts, 1);
+
+    // Pairs with the fence in PatchEntrypoints.
+    glvndAtomicFence();
+    if (glvndAtomicLoadAcquire(&patchSequence) != seq) {
+        glvndAtomicAdd(&numCurrentContexts, -1);
+        DispatchCurrentUnref(dispatch);
+        return GL_FALSE;
+    }
+    return GL_TRUE;
+}
+
+/*
+ * Counts \p dispatch as current, patching the entrypoints and filling in the
+ * table first if necessary. A pinned state doesn't count, but it needs the
+ * table to be pinned instead.
+ */
+static GLboolean AcquireCurrentTable(__GLdispatchTable *dispatch, int vendorID,
+        const __GLdispatchPatchCallbacks *patchCb, GLboolean pinned)
+{
+    if (pinned) {
+        return PinVendorTable(dispatch, vendorID, patchCb);
+    }
+
+    if (MakeCurrentFast(dispatch, vendorID, patchCb)) {
+        return GL_TRUE;
+    }
+
+    // Look up most of the functions for a new table before taking the lock.
+    PrefetchDispatchTable(dispatch);
+
+    // We need to fix up the dispatch table if it hasn't been
+    // initialized, or there are new dynamic entries which were
+    // added since the last time make current was called.
+    LockDispatch();
+
+    // Patch if necessary
+    PatchEntrypoints(patchCb, vendorID, GL_FALSE);
+
+    // If the current entrypoints are unsafe to use with this vendor, bail out.
+    if (!CurrentEntrypointsSafeToUse(vendorID)) {
+        UnlockDispatch();
+        return GL_FALSE;
+    }
+
+    if (!FixupDispatchTable(dispatch)) {
+        UnlockDispatch();
+        return GL_FALSE;
+    }
+
+    RegisterCurrentTable(dispatch, vendorID);
+    DispatchCurrentRef(dispatch);
+    glvndAtomicAdd(&numCurrentContexts, 1);
+
+    UnlockDispatch();
+    return GL_TRUE;
+}
+
+static GLboolean MakeCurrentInternal(__GLdispatchThreadState *threadState,
+                                     __GLdispatchTable *dispatch,
+                                     int vendorID,
+                                     const __GLdispatchPatchCallbacks *patchCb)
+{
+    __GLdispatchThreadStatePrivate *priv;
+
+    if (__glDispatchGetCurrentThreadState() != NULL) {
+        assert(!"__glDispatchMakeCurrent called with a current API state\n");
+        return GL_FALSE;
+    }
+
+    priv = AllocThreadStatePrivate(threadState, dispatch, vendorID, patchCb,
+            pinVendorEnabled);
+    if (priv == NULL) {
+        return GL_FALSE;
+    }
+
+    if (!AcquireCurrentTable(dispatch, vendorID, patchCb, priv->pinned)) {
+        FreeThreadStatePrivate(priv);
+        return GL_FALSE;
+    }
+
+    /*
+     * Update the API state with the new values.
+     */
+    threadState->priv = priv;
+
+    /*
+     * Set the current state in TLS.
+     */
+    SetCurrentThreadState(threadState);
+    __glDispatchCallCountSetCurrent(__glDispatchNumaGetTable(dispatch));
+    GLDISPATCH_TRACE(2, GLDISPATCH_TRACE_MAKE_CURRENT, vendorID, dispatch);
+
+    return GL_TRUE;
 }
 
 PUBLIC GLboolean __glDispatchMakeCurrent(__GLdispatchThreadState *threadState,
@@ -557,87 +2162,197 @@ PUBLIC GLboolean __glDispatchMakeCurrent(__GLdispatchThreadState *threadState,
                                          int vendorID,
                                          const __GLdispatchPatchCallbacks *patchCb)
 {
-    __GLdispatchThreadStatePrivate *priv;
+    GLboolean ret;
 
-    if (__glDispatchGetCurrentThreadState() != NULL) {
-        assert(!"__glDispatchMakeCurrent called with a current API state\n");
-        return GL_FALSE;
+    GLVND_PROBE1(make_current_begin, vendorID);
+    ret = MakeCurrentInternal(threadState, dispatch, vendorID, patchCb);
+    GLVND_PROBE2(make_current_end, vendorID, ret);
+    if (ret) {
+        GLDISPATCH_SHM_STATS_ADD(makeCurrentCount, 1);
     }
+    return ret;
+}
 
-    priv = (__GLdispatchThreadStatePrivate *) malloc(sizeof(__GLdispatchThreadStatePrivate));
-    if (priv == NULL) {
+/*
+ * Records a successful __glDispatchSwitchCurrent call.
+ */
+static inline void CountSwitchCurrent(int prevVendorID, int vendorID)
+{
+    GLDISPATCH_TRACE(2, GLDISPATCH_TRACE_SWITCH_CURRENT, prevVendorID, vendorID);
+    GLDISPATCH_SHM_STATS_ADD(makeCurrentCount, 1);
+    if (prevVendorID != vendorID) {
+        GLDISPATCH_SHM_STATS_ADD(vendorSwitchCount, 1);
+    }
+}
+
+PUBLIC GLboolean __glDispatchSwitchCurrent(__GLdispatchThreadState *threadState,
+                                           __GLdispatchTable *dispatch,
+                                           int vendorID,
+                                           const __GLdispatchPatchCallbacks *patchCb)
+{
+    __GLdispatchThreadStatePrivate *priv = threadState->priv;
+    int prevVendorID;
+
+    if (__glDispatchGetCurrentThreadState() != threadState || priv == NULL) {
+        assert(!"__glDispatchSwitchCurrent called without a current API state\n");
         return GL_FALSE;
     }
+    prevVendorID = priv->vendorID;
+
+    if (priv->pinned) {
+        // A pinned state was never counted as current, so there's nothing
+        // to update besides the state itself.
+        if (!PinVendorTable(dispatch, vendorID, patchCb)) {
+            SetCurrentThreadState(NULL);
+            FreeThreadStatePrivate(priv);
+            threadState->priv = NULL;
+            __glDispatchCallCountSetCurrent(NULL);
+            _glapi_set_current_vendor_context(NULL);
+            return GL_FALSE;
+        }
+        priv->dispatch = dispatch;
+        priv->vendorID = vendorID;
+        priv->patchCb = patchCb;
+        IncrementCurrentGeneration();
+        __glDispatchCallCountSetCurrent(__glDispatchNumaGetTable(dispatch));
+        CountSwitchCurrent(prevVendorID, vendorID);
+        return GL_TRUE;
+    }
+
+    if (MakeCurrentFast(dispatch, vendorID, patchCb)) {
+        glvndAtomicAdd(&numCurrentContexts, -1);
+        if (priv->dispatch != NULL) {
+            DispatchCurrentUnref(priv->dispatch);
+        }
+        priv->dispatch = dispatch;
+        priv->vendorID = vendorID;
+        priv->patchCb = patchCb;
+        IncrementCurrentGeneration();
+        __glDispatchCallCountSetCurrent(__glDispatchNumaGetTable(dispatch));
+        CountSwitchCurrent(prevVendorID, vendorID);
+        return GL_TRUE;
+    }
+
+    PrefetchDispatchTable(dispatch);
+
+    // Release the old context first, so that PatchEntrypoints doesn't count
+    // it as current.
+    SetCurrentThreadState(NULL);
+    glvndAtomicAdd(&numCurrentContexts, -1);
+    if (priv->dispatch != NULL) {
+        DispatchCurrentUnref(priv->dispatch);
+        priv->dispatch = NULL;
+    }
 
-    // We need to fix up the dispatch table if it hasn't been
-    // initialized, or there are new dynamic entries which were
-    // added since the last time make current was called.
     LockDispatch();
 
-    // Patch if necessary
     PatchEntrypoints(patchCb, vendorID, GL_FALSE);
 
-    // If the current entrypoints are unsafe to use with this vendor, bail out.
-    if (!CurrentEntrypointsSafeToUse(vendorID)) {
+    if (!CurrentEntrypointsSafeToUse(vendorID) || !FixupDispatchTable(dispatch)) {
         UnlockDispatch();
-        free(priv);
-        return GL_FALSE;
-    }
+        FreeThreadStatePrivate(priv);
 
-    if (!FixupDispatchTable(dispatch)) {
-        UnlockDispatch();
-        free(priv);
+        threadState->priv = NULL;
+        __glDispatchCallCountSetCurrent(NULL);
+        _glapi_set_current_vendor_context(NULL);
         return GL_FALSE;
     }
 
+    RegisterCurrentTable(dispatch, vendorID);
     DispatchCurrentRef(dispatch);
-    numCurrentContexts++;
+    glvndAtomicAdd(&numCurrentContexts, 1);
 
     UnlockDispatch();
 
-    /*
-     * Update the API state with the new values.
-     */
     priv->dispatch = dispatch;
     priv->vendorID = vendorID;
-    priv->threadState = threadState;
-    threadState->priv = priv;
+    priv->patchCb = patchCb;
 
-    /*
-     * Set the current state in TLS.
-     */
     SetCurrentThreadState(threadState);
-    _glapi_set_current(dispatch->table);
+    __glDispatchCallCountSetCurrent(__glDispatchNumaGetTable(dispatch));
+    CountSwitchCurrent(prevVendorID, vendorID);
 
     return GL_TRUE;
 }
 
+/*
+ * With app error checking, restores the default entrypoints once no thread
+ * has a current context.
+ *
+ * Patched entrypoints go straight to the vendor, so a GL call without a
+ * context would never reach the no-op table that reports it. Restoring them
+ * sends the calls back through the no-op table, and the next MakeCurrent
+ * patches them again. That way, the checks don't cost anything while a
+ * context is current.
+ *
+ * An app that releases and re-binds its context every frame would pay for
+ * two full patches per frame that way, though, so this backs off: the first
+ * release restores the entrypoints, and after that, the releases in between
+ * restores double up to MAX_ERROR_CHECK_RESTORE_INTERVAL. An app that keeps
+ * calling GL functions without a context still gets caught, just not on the
+ * first frame that it does it.
+ *
+ * This doesn't catch a thread that calls a GL function without a context
+ * while another thread has one, or anything while a pinned vendor owns the
+ * entrypoints.
+ */
+static void RestoreEntrypointsForErrorCheck(void)
+{
+    if (!glvndAppErrorCheckGetEnabled()
+            || glvndAtomicLoadAcquire(&numCurrentContexts) != 0
+            || glvndAtomicLoadAcquire(&pinnedVendorID) != 0) {
+        return;
+    }
+
+    LockDispatch();
+    if (stubCurrentPatchCb != NULL && numCurrentContexts == 0
+            && pinnedVendorID == 0
+            && ++errorCheckReleaseCount >= errorCheckRestoreInterval) {
+        PatchEntrypoints(NULL, 0, GL_FALSE);
+        errorCheckReleaseCount = 0;
+        if (errorCheckRestoreInterval < MAX_ERROR_CHECK_RESTORE_INTERVAL) {
+            errorCheckRestoreInterval *= 2;
+        }
+    }
+    UnlockDispatch();
+}
+
 static void LoseCurrentInternal(__GLdispatchThreadState *curThreadState,
         GLboolean threadDestroyed)
 {
-    LockDispatch();
-    // Note that we don't try to restore the default stubs here. Chances are,
-    // the next MakeCurrent will be from the same vendor, and if we leave them
-    // patched, then we won't have to go through the overhead of patching them
-    // again.
+    GLDISPATCH_TRACE(2, GLDISPATCH_TRACE_LOSE_CURRENT, 0, 0);
+    GLVND_PROBE0(lose_current_begin);
+
+    // Note that we don't try to restore the default stubs here, except for
+    // app error checking. Chances are, the next MakeCurrent will be from the
+    // same vendor, and if we leave them patched, then we won't have to go
+    // through the overhead of patching them again. The table stays in
+    // currentDispatchList, so none of this needs the lock.
 
     if (curThreadState) {
-        numCurrentContexts--;
-        if (curThreadState->priv != NULL) {
-            if (curThreadState->priv->dispatch != NULL) {
-                DispatchCurrentUnref(curThreadState->priv->dispatch);
+        __GLdispatchThreadStatePrivate *priv = curThreadState->priv;
+
+        // The pinned vendor's tables stay current, and its states aren't
+        // counted in numCurrentContexts.
+        if (priv == NULL || !priv->pinned) {
+            glvndAtomicAdd(&numCurrentContexts, -1);
+            if (priv != NULL && priv->dispatch != NULL) {
+                DispatchCurrentUnref(priv->dispatch);
             }
-
-            free(curThreadState->priv);
+        }
+        if (priv != NULL) {
+            FreeThreadStatePrivate(priv);
             curThreadState->priv = NULL;
         }
     }
-    UnlockDispatch();
 
     if (!threadDestroyed) {
         SetCurrentThreadState(NULL);
-        _glapi_set_current(NULL);
+        __glDispatchCallCountSetCurrent(NULL);
+        _glapi_set_current_vendor_context(NULL);
     }
+    RestoreEntrypointsForErrorCheck();
+    GLVND_PROBE0(lose_current_end);
 }
 
 PUBLIC void __glDispatchLoseCurrent(void)
@@ -649,6 +2364,185 @@ PUBLIC void __glDispatchLoseCurrent(void)
     LoseCurrentInternal(curThreadState, GL_FALSE);
 }
 
+PUBLIC void __glDispatchSetCurrentVendorContext(const void *context)
+{
+    _glapi_set_current_vendor_context(context);
+}
+
+PUBLIC const void *__glDispatchGetCurrentVendorContext(void)
+{
+    return _glapi_get_current_vendor_context();
+}
+
+static void UpdateCurrentInfo(int api, int vendorID,
+        const void *display, const void *context)
+{
+#if defined(GLDISPATCH_USE_TLS)
+    volatile GLVNDcurrentInfo *info = &currentInfo;
+
+    // Only a signal handler on this thread can see a partial update, so the
+    // volatile stores are enough to keep the sequence number in order.
+    info->sequence = info->sequence + 1;
+    info->api = api;
+    info->vendorID = vendorID;
+    info->display = (void *) display;
+    info->context = (void *) context;
+    info->sequence = info->sequence + 1;
+#endif
+}
+
+PUBLIC void __glDispatchSetCurrentInfo(const void *display, const void *context)
+{
+    __GLdispatchThreadState *threadState = __glDispatchGetCurrentThreadState();
+
+    _glapi_set_current_vendor_context(context);
+    if (threadState != NULL && threadState->priv != NULL) {
+        threadState->priv->display = display;
+        threadState->priv->context = context;
+        UpdateCurrentInfo(threadState->tag == GLDISPATCH_API_EGL
+                    ? GLVND_CURRENT_API_EGL : GLVND_CURRENT_API_GLX,
+                threadState->priv->vendorID, display, context);
+    }
+}
+
+/*
+ * Takes \p threadState off of the calling thread, and saves the vendor
+ * context so that RestoreThreadState can put it back. This leaves the
+ * private data and the dispatch table reference alone.
+ */
+static void DetachThreadState(__GLdispatchThreadState *threadState)
+{
+    __GLdispatchThreadStatePrivate *priv = threadState->priv;
+
+    priv->vendorContext = _glapi_get_current_vendor_context();
+    SetCurrentThreadState(NULL);
+    __glDispatchCallCountSetCurrent(NULL);
+    _glapi_set_current_vendor_context(NULL);
+    GLDISPATCH_TRACE(2, GLDISPATCH_TRACE_LOSE_CURRENT, priv->vendorID,
+            priv->dispatch);
+}
+
+/*
+ * Makes a thread state from DetachThreadState current on the calling thread.
+ */
+static void RestoreThreadState(__GLdispatchThreadState *threadState)
+{
+    __GLdispatchThreadStatePrivate *priv = threadState->priv;
+
+    SetCurrentThreadState(threadState);
+    __glDispatchCallCountSetCurrent(__glDispatchNumaGetTable(priv->dispatch));
+    _glapi_set_current_vendor_context(priv->vendorContext);
+    UpdateCurrentInfo(threadState->tag == GLDISPATCH_API_EGL
+                ? GLVND_CURRENT_API_EGL : GLVND_CURRENT_API_GLX,
+            priv->vendorID, priv->display, priv->context);
+    priv->vendorContext = NULL;
+    GLDISPATCH_TRACE(2, GLDISPATCH_TRACE_MAKE_CURRENT, priv->vendorID,
+            priv->dispatch);
+}
+
+PUBLIC void *__glDispatchDetachCurrent(void)
+{
+    __GLdispatchThreadState *threadState = __glDispatchGetCurrentThreadState();
+
+    if (threadState == NULL || threadState->priv == NULL
+            || threadState->migrateCallback == NULL) {
+        return NULL;
+    }
+
+    if (!threadState->migrateCallback(threadState, GL_FALSE)) {
+        return NULL;
+    }
+
+    // The state is still counted as current, and it keeps its reference to
+    // the dispatch table, so the entrypoints and the table stay as they are
+    // until some thread attaches it and releases it.
+    DetachThreadState(threadState);
+    return threadState;
+}
+
+PUBLIC int __glDispatchAttachCurrent(void *state)
+{
+    __GLdispatchThreadState *threadState = (__GLdispatchThreadState *) state;
+
+    if (threadState == NULL || threadState->priv == NULL
+            || threadState->migrateCallback == NULL) {
+        return 0;
+    }
+    if (__glDispatchGetCurrentThreadState() != NULL) {
+        return 0;
+    }
+
+    // This thread might not have called into libglvnd before.
+    __glDispatchCheckMultithreaded();
+
+    if (!threadState->migrateCallback(threadState, GL_TRUE)) {
+        return 0;
+    }
+
+    RestoreThreadState(threadState);
+    return 1;
+}
+
+PUBLIC __GLdispatchThreadState *__glDispatchSuspendCurrent(void)
+{
+    __GLdispatchThreadState *threadState = __glDispatchGetCurrentThreadState();
+    __GLdispatchThreadStatePrivate *priv;
+
+    if (threadState == NULL || threadState->priv == NULL) {
+        return NULL;
+    }
+    priv = threadState->priv;
+
+    // Stop counting the state as current, so that it doesn't keep another
+    // vendor from patching the entrypoints while it's suspended. The table
+    // stays in currentDispatchList, so the resume doesn't need the lock
+    // unless the entrypoints changed in the meantime.
+    if (!priv->pinned) {
+        glvndAtomicAdd(&numCurrentContexts, -1);
+        DispatchCurrentUnref(priv->dispatch);
+    }
+
+    DetachThreadState(threadState);
+    return threadState;
+}
+
+PUBLIC GLboolean __glDispatchResumeCurrent(__GLdispatchThreadState *threadState)
+{
+    __GLdispatchThreadStatePrivate *priv = threadState->priv;
+
+    if (__glDispatchGetCurrentThreadState() != NULL || priv == NULL) {
+        assert(!"__glDispatchResumeCurrent called with a current API state\n");
+        return GL_FALSE;
+    }
+
+    if (!AcquireCurrentTable(priv->dispatch, priv->vendorID, priv->patchCb,
+                priv->pinned)) {
+        __glDispatchDiscardSuspended(threadState);
+        return GL_FALSE;
+    }
+
+    RestoreThreadState(threadState);
+    return GL_TRUE;
+}
+
+PUBLIC void __glDispatchDiscardSuspended(__GLdispatchThreadState *threadState)
+{
+    if (threadState->priv != NULL) {
+        FreeThreadStatePrivate(threadState->priv);
+        threadState->priv = NULL;
+    }
+}
+
+PUBLIC const volatile GLVNDcurrentInfo *__glDispatchGetCurrentInfo(void)
+{
+#if defined(GLDISPATCH_USE_TLS)
+    return &currentInfo;
+#else
+    // Reading thread-specific data isn't async-signal-safe.
+    return NULL;
+#endif
+}
+
 PUBLIC GLboolean __glDispatchForceUnpatch(int vendorID)
 {
     GLboolean ret = GL_FALSE;
@@ -673,6 +2567,178 @@ PUBLIC GLboolean __glDispatchForceUnpatch(int vendorID)
     return ret;
 }
 
+static void InitPrewarm(void)
+{
+    const char *env = glvndGetEnv("__GLVND_PREWARM_DISPATCH");
+
+    CheckDispatchLocked();
+
+    prewarmLevel = (env != NULL ? atoi(env) : 0);
+    prewarmStubSequence = -1;
+}
+
+static void PrewarmStubs(void)
+{
+    __GLdispatchStubCallback *stub;
+
+    CheckDispatchLocked();
+
+    glvnd_list_for_each_entry(stub, &dispatchStubList, entry) {
+        if (stub->callbacks.prewarm != NULL) {
+            stub->callbacks.prewarm(prewarmLevel >= 2);
+        }
+    }
+    prewarmStubSequence = patchSequence;
+}
+
+/*
+ * Faults in the vendor's functions for a dispatch table.
+ *
+ * We don't know whether the vendor's code is readable, so instead of touching
+ * it, we just ask the kernel to map in each page, or failing that, to start
+ * reading it in.
+ */
+static void PrewarmVendorFunctions(__GLdispatchTable *dispatch)
+{
+    void **tbl = (void **) dispatch->table;
+    int count = dispatch->stubsPopulated;
+    long pageSize = sysconf(_SC_PAGESIZE);
+    uintptr_t lastPage = 0;
+    int i;
+
+    if (pageSize <= 0) {
+        return;
+    }
+    if (count > _glapi_get_dispatch_table_slot_count()) {
+        count = _glapi_get_dispatch_table_slot_count();
+    }
+
+    for (i=0; i<count; i++) {
+        uintptr_t page = ((uintptr_t) tbl[i]) & ~((uintptr_t) pageSize - 1);
+
+        // Functions that are next to each other in the table are often next
+        // to each other in the vendor library, too.
+        if (tbl[i] == NULL || tbl[i] == (void *) noop_func || page == lastPage) {
+            continue;
+        }
+        lastPage = page;
+
+#if defined(MADV_POPULATE_READ)
+        if (madvise((void *) page, pageSize, MADV_POPULATE_READ) == 0) {
+            continue;
+        }
+#endif
+        madvise((void *) page, pageSize, MADV_WILLNEED);
+    }
+}
+
+/*
+ * Faults in a dispatch table after it's filled in, along with the entrypoints
+ * and the vendor's functions. See prewarmLevel.
+ */
+static void PrewarmDispatchTable(__GLdispatchTable *dispatch)
+{
+    CheckDispatchLocked();
+
+    if (prewarmLevel <= 0) {
+        return;
+    }
+
+    if (prewarmStubSequence != patchSequence) {
+        PrewarmStubs();
+    }
+
+    if (dispatch->prewarmed || dispatch->table == NULL) {
+        return;
+    }
+    dispatch->prewarmed = GL_TRUE;
+
+    // If a page of the table gets replaced later, say because it was shared
+    // with another table and then gets written to, then the new page won't
+    // be locked. That's fine, since it'll have just been touched anyway.
+    glvnd_prefault_pages(dispatch->table,
+            _glapi_get_dispatch_table_size() * sizeof(void *),
+            prewarmLevel >= 2);
+
+    // A lazy table only points to the resolver trampolines at this point.
+    if (!dispatch->lazy) {
+        PrewarmVendorFunctions(dispatch);
+    }
+}
+
+PUBLIC void __glDispatchPrewarm(void)
+{
+    __GLdispatchTable *curDispatch;
+
+    LockDispatch();
+    if (clientRefcount > 0) {
+        if (prewarmLevel <= 0) {
+            prewarmLevel = 1;
+        }
+        PrewarmStubs();
+        glvnd_list_for_each_entry(curDispatch, &currentDispatchList, entry) {
+            PrewarmDispatchTable(curDispatch);
+        }
+    }
+    UnlockDispatch();
+}
+
+PUBLIC void __glDispatchPopulateTable(__GLdispatchTable *dispatch)
+{
+    PrefetchDispatchTable(dispatch);
+
+    LockDispatch();
+    FixupDispatchTable(dispatch);
+    UnlockDispatch();
+}
+
+PUBLIC void __glDispatchGetStatistics(__GLdispatchStats *stats)
+{
+    __GLdispatchTable *dispatch;
+    int staticCount = _glapi_get_static_stub_count();
+
+    memset(stats, 0, sizeof(*stats));
+
+    LockDispatch();
+    stats->tableCount = numDispatchTables;
+    glvnd_list_for_each_entry(dispatch, &currentDispatchList, entry) {
+        if (glvndAtomicLoadAcquire(&dispatch->currentThreads) > 0) {
+            stats->currentTableCount++;
+        }
+    }
+    stats->currentContextCount = glvndAtomicLoadAcquire(&numCurrentContexts);
+    stats->dynamicStubCount = _glapi_get_stub_count() - staticCount;
+    stats->dynamicStubMax = _glapi_get_max_stub_count() - staticCount;
+    stats->patchOwnerVendorID = stubOwnerVendorID;
+    stats->slotsResolved = slotsResolvedCount;
+    stats->patchCount = patchCount;
+    stats->unpatchCount = unpatchCount;
+    stats->patchTimeUS = patchTimeUS;
+    stats->lockAcquired = dispatchLock.stats.acquired;
+    stats->lockContended = dispatchLock.stats.parked;
+    stats->lockWaitNS = dispatchLock.stats.waitNS;
+    UnlockDispatch();
+}
+
+PUBLIC void __glDispatchGetConfig(__GLdispatchConfig *config)
+{
+    memset(config, 0, sizeof(*config));
+
+    config->entryType = GLDISPATCH_ENTRY_TYPE;
+    config->stubFlavor = stubFlavor;
+
+    LockDispatch();
+    config->patchSupported = !glvnd_list_is_empty(&dispatchStubList);
+    config->patchDisabledReason = GetPatchDisabledReason();
+    config->isMultiThreaded = isMultiThreaded;
+    config->lazyDispatch = lazyDispatchEnabled;
+    config->patchOwnerVendorID = stubOwnerVendorID;
+    config->lastPatchRefusal = lastPatchRefusal;
+    config->lastPatchRefusalVendorID = lastPatchRefusalVendorID;
+    config->patchRefusalCount = patchRefusalCount;
+    UnlockDispatch();
+}
+
 __GLdispatchThreadState *__glDispatchGetCurrentThreadState(void)
 {
     return (__GLdispatchThreadState *) __glvndPthreadFuncs.getspecific(threadContextKey);
@@ -681,6 +2747,13 @@ __GLdispatchThreadState *__glDispatchGetCurrentThreadState(void)
 void SetCurrentThreadState(__GLdispatchThreadState *threadState)
 {
     __glvndPthreadFuncs.setspecific(threadContextKey, threadState);
+#if defined(GLDISPATCH_USE_TLS)
+    __glDispatchCurrentThreadStateTLS = threadState;
+#endif
+    if (threadState == NULL) {
+        UpdateCurrentInfo(GLVND_CURRENT_API_NONE, 0, NULL, NULL);
+    }
+    IncrementCurrentGeneration();
 }
 
 /*
@@ -688,26 +2761,54 @@ void SetCurrentThreadState(__GLdispatchThreadState *threadState)
  */
 void __glDispatchReset(void)
 {
-    __GLdispatchTable *cur, *tmp;
+    __GLdispatchTable *cur;
 
     /* Reset the dispatch lock */
     __glvndPthreadFuncs.mutex_init(&dispatchLock.lock, NULL);
+    memset(&dispatchLock.stats, 0, sizeof(dispatchLock.stats));
     dispatchLock.isLocked = 0;
+    __glvndStringPoolReset();
+
+    // This has to happen before UnlockDispatch tries to publish anything.
+    __glDispatchShmStatsReset();
 
     LockDispatch();
     /*
-     * Clear out the current dispatch list.
+     * The dispatch tables are still filled in, and the entrypoints are still
+     * patched for the same vendor, so leave every table in
+     * currentDispatchList and leave the pinned vendor alone. Only the calling
+     * thread survives a fork, and it loses current below, so the only thing
+     * to clear is the count of threads using each table. A pinned table
+     * keeps the reference that the pin holds.
      */
-
-    glvnd_list_for_each_entry_safe(cur, tmp, &currentDispatchList, entry) {
-        cur->currentThreads = 0;
-        glvnd_list_del(&cur->entry);
+    glvnd_list_for_each_entry(cur, &currentDispatchList, entry) {
+        cur->currentThreads = (cur->pinned ? 1 : 0);
     }
+    numCurrentContexts = 0;
+    glvndAtomicStoreRelease(&threadAttachGeneration,
+            threadAttachGeneration + 1);
     UnlockDispatch();
 
     /* Clear GLAPI TLS entries. */
     SetCurrentThreadState(NULL);
-    _glapi_set_current(NULL);
+    __glDispatchCallCountSetCurrent(NULL);
+    GLDISPATCH_TRACE(1, GLDISPATCH_TRACE_FORK_RESET, 0, 0);
+}
+
+/*
+ * Writes out the reports that were enabled with environment variables, and
+ * frees whatever they used.
+ */
+static void FiniReports(void)
+{
+    __glDispatchCallCountFini();
+    __glDispatchLockStatsFini();
+    __glDispatchMemStatsFini();
+    __glDispatchWinsysTimesFini();
+    __glDispatchSymbolMapFini();
+    __glDispatchTraceFini();
+    __glDispatchShmStatsFini();
+    glvndAppErrorCheckFini();
 }
 
 /*
@@ -726,13 +2827,35 @@ void __glDispatchFini(void)
     clientRefcount--;
 
     if (clientRefcount == 0) {
+        FiniReports();
+
+        DBG_PRINTF(10, "Dispatch lock: %lu acquired, %lu parked\n",
+                dispatchLock.stats.acquired,
+                dispatchLock.stats.parked);
+
         /* This frees the dispatchStubList */
         UnregisterAllStubCallbacks();
 
         __glvndPthreadFuncs.key_delete(threadContextKey);
+        free(__glvndPthreadFuncs.getspecific(freeThreadStateKey));
+        __glvndPthreadFuncs.key_delete(freeThreadStateKey);
+#if !defined(GLDISPATCH_USE_TLS)
+        __glvndPthreadFuncs.key_delete(threadAttachGenerationKey);
+        __glvndPthreadFuncs.key_delete(currentGenerationKey);
+#endif
 
         // Clean up GLAPI thread state
+        glvndAtomicStoreRelease(&publishedStubCount, 0);
+        __glDispatchSharedTablesFini();
+        __glDispatchPrelinkFini();
+        __glDispatchLayersFini();
+        free(neededSlots);
+        neededSlots = NULL;
         _glapi_destroy();
+
+        // The dynamic stubs and the client libraries use the pooled names,
+        // so this has to wait until everything else is torn down.
+        __glvndStringPoolCleanup();
     }
 
     UnlockDispatch();
@@ -754,6 +2877,16 @@ void __glDispatchCheckMultithreaded(void)
             _glapi_set_current(NULL);
         }
 
+        // If this thread has already been through here since the last time
+        // the patch callbacks changed, then there's nothing else to do.
+        // Note that a new thread always starts out with a generation of zero,
+        // so it'll still take the lock below at least once, which is what
+        // the multithreading detection depends on.
+        if (GetThreadAttachGenerationSeen() ==
+                glvndAtomicLoadAcquire(&threadAttachGeneration)) {
+            return;
+        }
+
         LockDispatch();
         if (!isMultiThreaded) {
             glvnd_thread_t tid = __glvndPthreadFuncs.self();
@@ -768,6 +2901,7 @@ void __glDispatchCheckMultithreaded(void)
         if (stubCurrentPatchCb != NULL && stubCurrentPatchCb->threadAttach != NULL) {
             stubCurrentPatchCb->threadAttach();
         }
+        SetThreadAttachGenerationSeen(threadAttachGeneration);
         UnlockDispatch();
     }
 }
@@ -777,6 +2911,7 @@ void ThreadDestroyed(void *data)
     if (data != NULL) {
         __GLdispatchThreadState *threadState = (__GLdispatchThreadState *) data;
         LoseCurrentInternal(threadState, GL_TRUE);
+        __glDispatchCallCountThreadDestroyed();
 
         if (threadState->threadDestroyedCallback != NULL) {
             threadState->threadDestroyedCallback(threadState);
@@ -30,6 +30,8 @@
 #if !defined(__GL_DISPATCH_H__)
 #define __GL_DISPATCH_H__
 
+#include <stdint.h>
+
 #include "glheader.h"
 #include "compiler.h"
 #include "glvnd/GLdispatchABI.h"
@@ -58,7 +60,7 @@
  *
  * \see __glDispatchGetABIVersion
  */
-#define GLDISPATCH_ABI_VERSION 1
+#define GLDISPATCH_ABI_VERSION 4
 
 /* Namespaces for thread state */
 enum {
@@ -75,6 +77,18 @@ typedef void (*__GLdispatchProc)(void);
 
 typedef void *(*__GLgetProcAddressCallback)(const char *procName, void *param);
 
+/*!
+ * A callback to look up several functions from a vendor library at once.
+ *
+ * \param procNames An array of function names to look up.
+ * \param[out] procs Returns the address of each function, or \c NULL for any
+ *      function that the vendor doesn't support.
+ * \param count The number of elements in \p procNames and \p procs.
+ * \param param The pointer that was passed to \c __glDispatchCreateTableBulk.
+ */
+typedef void (*__GLgetProcAddressBulkCallback)(const char * const *procNames,
+        void **procs, int count, void *param);
+
 /**
  * An opaque structure used for internal thread state data.
  */
@@ -121,6 +135,27 @@ typedef struct __GLdispatchThreadStateRec {
      */
     void (*threadDestroyedCallback)(struct __GLdispatchThreadStateRec *threadState);
 
+    /*!
+     * A callback that moves the vendor library's current state between
+     * threads, for \c __glDispatchDetachCurrent and
+     * \c __glDispatchAttachCurrent.
+     *
+     * With \p attach set to \c GL_FALSE, this is called on the thread that
+     * the state is being detached from, and the vendor library should save
+     * and release its own per-thread current state. With \p attach set to
+     * \c GL_TRUE, this is called on the thread that the state is being
+     * attached to, and the vendor library should restore it.
+     *
+     * If this is NULL, then the thread state can't be migrated.
+     *
+     * \param threadState The thread state being detached or attached.
+     * \param attach \c GL_TRUE to attach, \c GL_FALSE to detach.
+     * \return \c GL_TRUE on success, or \c GL_FALSE if the vendor library
+     * can't move the state. On failure, the state stays where it was.
+     */
+    GLboolean (*migrateCallback)(struct __GLdispatchThreadStateRec *threadState,
+            GLboolean attach);
+
     /*************************************************************************
      * GLdispatch-managed variables: Modified by MakeCurrent()
      *************************************************************************/
@@ -210,6 +245,22 @@ typedef struct __GLdispatchPatchCallbacksRec {
      * \note This function may be called concurrently from multiple threads.
      */
     void (*threadAttach)(void);
+
+    /*!
+     * (OPTIONAL) Called by libglvnd to request that a vendor library point
+     * some of the top-level entrypoints directly at its own functions.
+     *
+     * If this is not \c NULL, then libGLdispatch will use it instead of
+     * \c isPatchSupported and \c initiatePatch. Since the vendor library
+     * doesn't write any code itself, libGLdispatch can patch the entrypoints
+     * even if other threads have a current context, as long as every current
+     * context belongs to the same vendor.
+     *
+     * \param setStubTarget A callback into libglvnd to change each
+     * entrypoint.
+     * \return GL_TRUE if the vendor library patched any entrypoints.
+     */
+    GLboolean (*initiatePatchTargets)(DispatchPatchSetStubTarget setStubTarget);
 } __GLdispatchPatchCallbacks;
 
 /*!
@@ -240,6 +291,10 @@ PUBLIC void __glDispatchFini(void);
 /*!
  * Called when the client library has detected a fork, and GLdispatch state
  * needs to be reset to handle the fork.
+ *
+ * This only resets the locks and the per-thread state. Dispatch tables,
+ * generated stubs, and patched entrypoints are kept, so the child doesn't
+ * have to look anything up again.
  */
 PUBLIC void __glDispatchReset(void);
 
@@ -255,6 +310,82 @@ PUBLIC int __glDispatchNewVendorID(void);
  */
 PUBLIC __GLdispatchProc __glDispatchGetProcAddress(const char *procName);
 
+/*!
+ * Looks up several dispatch stubs at once. This is the same as calling
+ * \c __glDispatchGetProcAddress for each name, but it only takes the lock
+ * once, and only updates the current dispatch tables once at the end.
+ *
+ * \param procNames The names of the functions to look up.
+ * \param[out] procs Receives the stub for each name, or NULL.
+ * \param count The number of names.
+ */
+PUBLIC void __glDispatchGetProcAddresses(const char * const *procNames,
+        __GLdispatchProc *procs, int count);
+
+/*!
+ * Returns a shared copy of a string, such as a function name.
+ *
+ * libGLdispatch keeps one copy of each distinct string for every library
+ * that uses it, so two strings returned by this are equal if and only if the
+ * pointers are equal. The string stays valid until the last client library
+ * calls \c __glDispatchFini.
+ *
+ * \return The shared string, or NULL if it couldn't be allocated.
+ */
+PUBLIC const char *__glDispatchInternString(const char *str);
+
+/*!
+ * Returns the FNV-1a hash of a string that was returned by
+ * \c __glDispatchInternString, without computing it again.
+ */
+PUBLIC uint32_t __glDispatchInternedStringHash(const char *str);
+
+/*!
+ * Returns libGLdispatch's stub for a static dispatch table slot.
+ *
+ * A client library built with --enable-shared-entrypoints exports each of its
+ * GL functions as an IFUNC that resolves to this stub, instead of carrying
+ * its own copy of the entrypoints. The dynamic linker calls those resolvers
+ * while it's still loading libraries, so this function doesn't take any locks
+ * and works before \c __glDispatchInit.
+ *
+ * \param slot The dispatch table slot.
+ * \return The stub, or NULL if \p slot isn't a static slot.
+ */
+PUBLIC __GLdispatchProc __glDispatchGetPublicStub(int slot);
+
+/*!
+ * Returns a number that changes whenever the current thread's dispatch table
+ * changes, which includes every call to \c __glDispatchMakeCurrent,
+ * \c __glDispatchSwitchCurrent, and \c __glDispatchLoseCurrent.
+ *
+ * The value is only meaningful within the current thread.
+ */
+PUBLIC unsigned long __glDispatchGetCurrentGeneration(void);
+
+/*!
+ * Returns the vendor's function for \p procName from the current thread's
+ * dispatch table, so that a caller can call it directly instead of going
+ * through a dispatch stub.
+ *
+ * The function is only valid until the current thread's dispatch table
+ * changes. A caller that holds on to it should save the value returned in
+ * \p generation, and look the function up again if
+ * \c __glDispatchGetCurrentGeneration returns a different value.
+ *
+ * Applications don't link to libGLdispatch directly, but they can find this
+ * function with dlsym.
+ *
+ * \param procName The name of the function.
+ * \param[out] generation If not NULL, returns the current value of
+ *      \c __glDispatchGetCurrentGeneration.
+ * \return The vendor's function, or NULL if no context is current or there
+ *      isn't a dispatch table slot for \p procName. If the vendor doesn't
+ *      support the function, then this returns a no-op function.
+ */
+PUBLIC __GLdispatchProc __glDispatchGetCurrentProc(const char *procName,
+        unsigned long *generation);
+
 /*!
  * Create a new dispatch table in GLdispatch. This reference hangs off the
  * client GLX or EGL context, and is passed into GLdispatch during make current.
@@ -262,7 +393,8 @@ PUBLIC __GLdispatchProc __glDispatchGetProcAddress(const char *procName);
  *
  * \param[in] getProcAddress a vendor library callback GLdispatch can use to
  * query addresses of functions from the vendor. This callback also takes
- * a pointer to caller-private data.
+ * a pointer to caller-private data. It may be called from more than one
+ * thread at a time, and without holding any libGLdispatch lock.
  * \param[in] param A pointer to pass to \p getProcAddress.
  */
 PUBLIC __GLdispatchTable *__glDispatchCreateTable(
@@ -270,6 +402,89 @@ PUBLIC __GLdispatchTable *__glDispatchCreateTable(
     void *param
 );
 
+/*!
+ * Create a new dispatch table, with an optional callback to look up functions
+ * in bulk.
+ *
+ * This works the same as \c __glDispatchCreateTable, but when GLdispatch has
+ * to fill in the dispatch table, it will pass all of the missing function
+ * names to \p getProcAddressBulk in a single call, instead of calling
+ * \p getProcAddress once for each function.
+ *
+ * \param[in] getProcAddress a vendor library callback GLdispatch can use to
+ * query addresses of functions from the vendor.
+ * \param[in] getProcAddressBulk A callback to look up an array of functions, or
+ * \c NULL to always use \p getProcAddress. Like \p getProcAddress, this may be
+ * called from more than one thread at a time.
+ * \param[in] param A pointer to pass to \p getProcAddress and
+ * \p getProcAddressBulk.
+ */
+PUBLIC __GLdispatchTable *__glDispatchCreateTableBulk(
+    __GLgetProcAddressCallback getProcAddress,
+    __GLgetProcAddressBulkCallback getProcAddressBulk,
+    void *param
+);
+
+/*!
+ * Identifies the vendor library that a dispatch table's functions come from.
+ *
+ * If the __GLVND_DISPATCH_CACHE_DIR environment variable is set, then
+ * GLdispatch uses this to cache the table's contents on disk, so that other
+ * processes can fill in the same table without looking up each function. The
+ * cache is keyed by the build ID of the vendor library, so every table that
+ * uses the same vendor library and tag must get the same function for each
+ * name.
+ *
+ * This must be called before the table is made current. Tables that this
+ * isn't called for aren't cached.
+ *
+ * \param[in] dispatch The dispatch table.
+ * \param[in] vendorHandle The vendor library's handle from dlopen.
+ * \param[in] tag A name for the table, which tells apart different tables
+ * from the same vendor library. This can only contain letters, digits, '-',
+ * and '_'.
+ */
+PUBLIC void __glDispatchSetTableVendor(__GLdispatchTable *dispatch,
+        void *vendorHandle, const char *tag);
+
+/*!
+ * Returns the layout of the static slots in a dispatch table.
+ *
+ * The static slots come first in every dispatch table, in an order that's
+ * fixed when libGLdispatch is built. The layout hash is a 32-bit FNV-1a hash
+ * of the name of each static function in slot order, with each name followed
+ * by a NUL byte.
+ *
+ * \param[out] staticCount Returns the number of static slots. This may be
+ * NULL.
+ * \return The layout hash.
+ */
+PUBLIC uint32_t __glDispatchGetTableLayout(int *staticCount);
+
+/*!
+ * Gives a dispatch table the vendor's functions for its static slots, so that
+ * GLdispatch doesn't have to look up each one by name.
+ *
+ * When GLdispatch fills in the table, it copies the first \p count static
+ * slots from \p funcs. It only calls the table's getProcAddress callbacks
+ * for the slots after that.
+ *
+ * This must be called before the table is made current.
+ *
+ * \param[in] dispatch The dispatch table.
+ * \param[in] layoutHash The layout that \p funcs is in. If this doesn't
+ * match the hash from \c __glDispatchGetTableLayout, then \p funcs is
+ * ignored.
+ * \param[in] funcs The functions in slot order. A NULL element means the
+ * vendor doesn't support that function. The array must stay valid until the
+ * table is destroyed.
+ * \param[in] count The number of elements in \p funcs. Any past the last
+ * static slot are ignored.
+ * \return GL_TRUE if the table will use \p funcs.
+ */
+PUBLIC GLboolean __glDispatchSetTableStaticFuncs(__GLdispatchTable *dispatch,
+        uint32_t layoutHash, const void * const *funcs, int count);
+
 /*!
  * Destroy a dispatch table in GLdispatch.
  */
@@ -297,6 +512,27 @@ PUBLIC GLboolean __glDispatchMakeCurrent(__GLdispatchThreadState *threadState,
                                          int vendorID,
                                          const __GLdispatchPatchCallbacks *patchCb);
 
+/*!
+ * Switches the current thread state to a different dispatch table and vendor
+ * ID, as a single operation.
+ *
+ * This does the same thing as calling \c __glDispatchLoseCurrent followed by
+ * \c __glDispatchMakeCurrent, but it only takes the dispatch lock once, and
+ * it reuses the current thread state's private data instead of freeing and
+ * allocating it again.
+ *
+ * \p threadState must be the current thread state. The window system library
+ * is responsible for releasing the old vendor's context before calling this.
+ *
+ * This returns GL_TRUE if the switch succeeded. If it fails, then the current
+ * thread is left without a thread state, as if \c __glDispatchLoseCurrent had
+ * been called.
+ */
+PUBLIC GLboolean __glDispatchSwitchCurrent(__GLdispatchThreadState *threadState,
+                                           __GLdispatchTable *dispatch,
+                                           int vendorID,
+                                           const __GLdispatchPatchCallbacks *patchCb);
+
 /*!
  * This makes the NOP dispatch table current and sets the current thread state
  * to NULL.
@@ -307,6 +543,119 @@ PUBLIC GLboolean __glDispatchMakeCurrent(__GLdispatchThreadState *threadState,
  */
 PUBLIC void __glDispatchLoseCurrent(void);
 
+/*!
+ * Detaches the current thread state from the calling thread, without
+ * releasing it, so that another thread can pick it up with
+ * \c __glDispatchAttachCurrent.
+ *
+ * This is meant for fiber and job-system schedulers, which run a task on
+ * whichever worker thread is free. The state's context stays current as far
+ * as libGLdispatch and the vendor library are concerned, so the entrypoints
+ * stay patched and the dispatch table stays registered, but the calling
+ * thread is left with the no-op dispatch table.
+ *
+ * The thread state's \c migrateCallback is called to let the window system
+ * and vendor library save their own per-thread state.
+ *
+ * \return An opaque handle to pass to \c __glDispatchAttachCurrent, or NULL
+ * if the thread has no current state or the state can't be migrated. The
+ * application must attach the handle to some thread before it releases the
+ * context or tears down the library.
+ */
+PUBLIC void *__glDispatchDetachCurrent(void);
+
+/*!
+ * Attaches a thread state that was detached with \c __glDispatchDetachCurrent
+ * to the calling thread.
+ *
+ * The calling thread must not have a current thread state.
+ *
+ * This is also declared in glvnd/glvnd.h, so it returns an int instead of a
+ * GLboolean.
+ *
+ * \return Non-zero on success. On failure, the state stays detached, and the
+ * caller can try again on another thread.
+ */
+PUBLIC int __glDispatchAttachCurrent(void *state);
+
+/*!
+ * Takes the current thread state off of the calling thread, without releasing
+ * it, so that it can be made current again with
+ * \c __glDispatchResumeCurrent.
+ *
+ * This is used to implement the push and pop functions in libGLX and libEGL.
+ * The thread state keeps its private data, dispatch table, and patch
+ * callbacks, so the resume doesn't need to allocate anything or look up the
+ * table again. The state isn't counted as current while it's suspended, so it
+ * doesn't keep another vendor from patching the entrypoints.
+ *
+ * The window system library is responsible for releasing or detaching the
+ * vendor's context.
+ *
+ * \return The suspended thread state, or NULL if the thread didn't have one.
+ */
+PUBLIC __GLdispatchThreadState *__glDispatchSuspendCurrent(void);
+
+/*!
+ * Makes a thread state from \c __glDispatchSuspendCurrent current again.
+ *
+ * The calling thread must not have a current thread state. The thread state
+ * doesn't have to be resumed on the same thread that suspended it.
+ *
+ * If the entrypoints haven't changed since the state was suspended, then
+ * this doesn't take the dispatch lock.
+ *
+ * If this fails, then the state is discarded, as if by
+ * \c __glDispatchDiscardSuspended.
+ */
+PUBLIC GLboolean __glDispatchResumeCurrent(__GLdispatchThreadState *threadState);
+
+/*!
+ * Frees the private data for a thread state from
+ * \c __glDispatchSuspendCurrent, without making it current again.
+ */
+PUBLIC void __glDispatchDiscardSuspended(__GLdispatchThreadState *threadState);
+
+/*!
+ * Sets the vendor context pointer for the current thread.
+ *
+ * libGLX and libEGL call this after a vendor library makes a context current,
+ * with the vendor's own GLXContext or EGLContext handle. The pointer is stored
+ * next to the current dispatch table, in
+ * \c _glapi_tls_Current[GLAPI_CURRENT_VENDOR_CONTEXT] (or \c _glapi_Current
+ * with the TSD stubs), so that the vendor's GL functions can find their
+ * context without a separate TLS lookup.
+ *
+ * \c __glDispatchLoseCurrent resets it to NULL.
+ */
+PUBLIC void __glDispatchSetCurrentVendorContext(const void *context);
+
+/*!
+ * Returns the pointer that was passed to
+ * \c __glDispatchSetCurrentVendorContext on the current thread.
+ *
+ * With the TSD stubs, \c _glapi_Current only holds the vendor context while
+ * the process is single-threaded, so a vendor library has to call this if
+ * that slot is NULL.
+ */
+PUBLIC const void *__glDispatchGetCurrentVendorContext(void);
+
+/*!
+ * Sets the vendor context pointer, the same as
+ * \c __glDispatchSetCurrentVendorContext, and fills in the current thread's
+ * \c GLVNDcurrentInfo record for \c __glDispatchGetCurrentInfo.
+ *
+ * libGLX and libEGL call this after a vendor library makes a context
+ * current. The API and vendor ID come from the current thread state, so this
+ * must be called after \c __glDispatchMakeCurrent or
+ * \c __glDispatchSwitchCurrent. \c __glDispatchLoseCurrent clears the
+ * record.
+ *
+ * \param display The application's Display or EGLDisplay handle.
+ * \param context The application's GLXContext or EGLContext handle.
+ */
+PUBLIC void __glDispatchSetCurrentInfo(const void *display, const void *context);
+
 /*!
  * This gets the current thread state pointer. If the pointer is \c NULL, no
  * context is current, otherwise the contents of the pointer depends on which
@@ -314,6 +663,28 @@ PUBLIC void __glDispatchLoseCurrent(void);
  */
 PUBLIC __GLdispatchThreadState *__glDispatchGetCurrentThreadState(void);
 
+#if defined(GLDISPATCH_USE_TLS)
+/*!
+ * The current thread state pointer, the same value that
+ * \c __glDispatchGetCurrentThreadState returns.
+ *
+ * This lets libGLX and libEGL look up the current context without calling
+ * into libGLdispatch. Only libGLdispatch may write to it.
+ */
+PUBLIC extern __thread __GLdispatchThreadState *__glDispatchCurrentThreadStateTLS
+    __attribute__((tls_model("initial-exec")));
+
+static inline __GLdispatchThreadState *__glDispatchGetCurrentThreadStateInline(void)
+{
+    return __glDispatchCurrentThreadStateTLS;
+}
+#else
+static inline __GLdispatchThreadState *__glDispatchGetCurrentThreadStateInline(void)
+{
+    return __glDispatchGetCurrentThreadState();
+}
+#endif
+
 /**
  * Checks to see if multiple threads are being used. This should be called
  * periodically from places like glXMakeCurrent.
@@ -329,4 +700,517 @@ PUBLIC void __glDispatchCheckMultithreaded(void);
  */
 PUBLIC GLboolean __glDispatchForceUnpatch(int vendorID);
 
+/*!
+ * The highest level of trace events that are compiled in. Level 1 covers rare
+ * events like loading a vendor or patching entrypoints, and level 2 adds
+ * per-call events like MakeCurrent. Setting this to 0 compiles out every
+ * call to \c GLDISPATCH_TRACE.
+ */
+#if !defined(GLVND_TRACE_LEVEL)
+#define GLVND_TRACE_LEVEL 2
+#endif
+
+/*!
+ * Event types for \c __glDispatchTraceEvent. Each comment lists what the two
+ * arguments are. The decoder in bin/trace-decode.py has a copy of these.
+ */
+enum {
+    GLDISPATCH_TRACE_MAKE_CURRENT = 1, // vendor ID, dispatch table
+    GLDISPATCH_TRACE_LOSE_CURRENT,     // unused
+    GLDISPATCH_TRACE_PATCH,            // requested vendor ID, resulting owner
+    GLDISPATCH_TRACE_FIXUP,            // dispatch table, entries filled in
+    GLDISPATCH_TRACE_VENDOR_LOAD,      // GLDISPATCH_API_* value, vendor ID
+    GLDISPATCH_TRACE_PHASE_BEGIN,      // GLDISPATCH_PHASE_* value, GLDISPATCH_API_* value
+    GLDISPATCH_TRACE_PHASE_END,        // GLDISPATCH_PHASE_* value, GLDISPATCH_API_* value
+    GLDISPATCH_TRACE_SWITCH_CURRENT,   // previous vendor ID, vendor ID
+    GLDISPATCH_TRACE_PROC_LOOKUP,      // GLDISPATCH_API_* value, glvndHashString of the name
+    GLDISPATCH_TRACE_SWAP,             // GLDISPATCH_API_* value, drawable or surface
+    GLDISPATCH_TRACE_FORK_RESET,       // unused
+};
+
+/*!
+ * Startup phases for \c GLDISPATCH_TRACE_PHASE_BEGIN and
+ * \c GLDISPATCH_TRACE_PHASE_END. Running bin/trace-decode.py with --phases
+ * adds up the time spent in each one.
+ */
+enum {
+    GLDISPATCH_PHASE_CONFIG_SCAN = 1, // finding the vendor config files
+    GLDISPATCH_PHASE_CONFIG_PARSE,    // reading the vendor config files
+    GLDISPATCH_PHASE_DLOPEN,          // loading a vendor library
+    GLDISPATCH_PHASE_VENDOR_MAIN,     // calling a vendor's __egl_Main or __glx_Main
+    GLDISPATCH_PHASE_LOOKUP,          // looking up a vendor's entrypoints
+    GLDISPATCH_PHASE_FIXUP,           // filling in a dispatch table (no API)
+};
+
+/*!
+ * Records a trace event in the current thread's trace buffer.
+ *
+ * Tracing is off unless the __GLVND_TRACE_FILE environment variable is set,
+ * and this does nothing but check a flag when it's off. Use
+ * \c GLDISPATCH_TRACE instead of calling this directly, so that the call is
+ * compiled out if its level is above \c GLVND_TRACE_LEVEL.
+ */
+PUBLIC void __glDispatchTraceEvent(int event, uintptr_t arg0, uintptr_t arg1);
+
+#define GLDISPATCH_TRACE(level, event, arg0, arg1) do { \
+    if ((level) <= GLVND_TRACE_LEVEL) { \
+        __glDispatchTraceEvent((event), (uintptr_t) (arg0), (uintptr_t) (arg1)); \
+    } \
+} while (0)
+
+/*!
+ * Records a \c GLDISPATCH_TRACE_PROC_LOOKUP event for a GetProcAddress call.
+ *
+ * This only hashes the name if tracing is on, so it's cheaper than calling
+ * \c __glDispatchTraceEvent with the hash. Like that, it should be called
+ * through \c GLDISPATCH_TRACE_PROC.
+ */
+PUBLIC void __glDispatchTraceProcLookup(int api, const char *procName);
+
+#define GLDISPATCH_TRACE_PROC(level, api, procName) do { \
+    if ((level) <= GLVND_TRACE_LEVEL) { \
+        __glDispatchTraceProcLookup((api), (const char *) (procName)); \
+    } \
+} while (0)
+
+/*!
+ * Writes out the trace file now.
+ *
+ * This is meant for a flight recorder (__GLVND_TRACE_FLIGHT_RECORDER), which
+ * doesn't write the file at exit. It's async-signal-safe, so it can be called
+ * from a debugger or from the application's own crash handler.
+ *
+ * \return GL_TRUE if the file was written, or GL_FALSE if tracing isn't set
+ *      up or writing the file failed.
+ */
+PUBLIC GLboolean __glDispatchDumpTrace(void);
+
+/*!
+ * Returns the number of times that a function has been called through the
+ * dispatch stubs.
+ *
+ * Call counting is only enabled if the __GLVND_CALL_COUNTS environment
+ * variable is set, and it isn't supported by every build. Calls made before
+ * a context is current, or through patched entrypoints, aren't counted.
+ *
+ * \param index The index of the dispatch stub, starting at zero.
+ * \param[out] name Returns the name of the function.
+ * \param[out] count Returns the number of calls from every thread.
+ * \return GL_TRUE on success, or GL_FALSE if call counting isn't enabled or
+ * \p index is past the last stub.
+ */
+PUBLIC GLboolean __glDispatchGetCallCount(int index, const char **name,
+        uint64_t *count);
+
+/*!
+ * How the dispatch stubs find the current dispatch table. This is returned by
+ * \c __glDispatchGetStubFlavor.
+ */
+enum {
+    /// The stubs read an initial-exec TLS variable.
+    GLDISPATCH_STUB_FLAVOR_TLS,
+
+    /// libGLdispatch was built with --enable-runtime-tls, and it was loaded
+    /// with static TLS space, so the TSD stubs were switched to read the
+    /// dispatch table from a fixed TLS offset.
+    GLDISPATCH_STUB_FLAVOR_STATIC_TLS,
+
+    /// The stubs use a global variable while the process is single-threaded,
+    /// and call into libGLdispatch after that.
+    GLDISPATCH_STUB_FLAVOR_TSD,
+};
+
+/*!
+ * Returns which of the \c GLDISPATCH_STUB_FLAVOR_* values libGLdispatch
+ * picked for its dispatch stubs.
+ *
+ * With --enable-runtime-tls, the choice is made when libGLdispatch is loaded:
+ * a process that loads it at startup gets the static TLS path, and a library
+ * that loads it late with dlopen gets the TSD path.
+ */
+PUBLIC int __glDispatchGetStubFlavor(void);
+
+/*!
+ * Faults in the dispatch stubs and every current dispatch table, along with
+ * the functions that those tables point to, so that the first calls after
+ * this don't take page faults. An app can call this during a loading screen.
+ *
+ * This also turns on the same thing for any dispatch table that gets filled
+ * in after this, as if the __GLVND_PREWARM_DISPATCH environment variable was
+ * set to 1. Setting it to 2 also locks the stubs and tables in memory.
+ */
+PUBLIC void __glDispatchPrewarm(void);
+
+/*!
+ * Fills in a dispatch table without making it current.
+ *
+ * Normally, a dispatch table is filled in the first time that it's made
+ * current. A process that's going to fork can call this ahead of time for
+ * each vendor, so that the children share the filled-in table instead of
+ * each looking up every function again.
+ */
+PUBLIC void __glDispatchPopulateTable(__GLdispatchTable *dispatch);
+
+/*!
+ * Counters returned by \c __glDispatchGetStatistics.
+ */
+typedef struct __GLdispatchStatsRec {
+    /// The number of dispatch tables that currently exist.
+    int tableCount;
+
+    /// The number of dispatch tables that are current to at least one thread.
+    int currentTableCount;
+
+    /// The number of threads with a current context. This doesn't include
+    /// contexts from a pinned vendor (see __GLVND_PIN_VENDOR).
+    int currentContextCount;
+
+    /// The number of dynamic stubs that have been generated.
+    int dynamicStubCount;
+
+    /// The most dynamic stubs that libGLdispatch can generate.
+    int dynamicStubMax;
+
+    /// The vendor ID that owns the patched entrypoints, or zero if the
+    /// entrypoints aren't patched.
+    int patchOwnerVendorID;
+
+    /// The number of dispatch table slots that have been looked up from a
+    /// vendor, in every dispatch table.
+    uint64_t slotsResolved;
+
+    /// The number of times that the entrypoints were patched for a vendor.
+    uint64_t patchCount;
+
+    /// The number of times that a vendor's patched entrypoints were restored.
+    uint64_t unpatchCount;
+
+    /// The total time spent patching and restoring entrypoints, in
+    /// microseconds.
+    uint64_t patchTimeUS;
+
+    /// The number of times that the dispatch lock was taken.
+    uint64_t lockAcquired;
+
+    /// The number of times that a thread had to wait for the dispatch lock.
+    uint64_t lockContended;
+
+    /// The total time that threads waited for the dispatch lock, in
+    /// nanoseconds. This is only counted if __GLVND_LOCK_STATS is set.
+    uint64_t lockWaitNS;
+} __GLdispatchStats;
+
+/*!
+ * Returns a snapshot of libGLdispatch's internal counters.
+ *
+ * This is meant for monitoring tools, to spot things like an application
+ * that keeps switching between vendors or one that uses up the dynamic
+ * stubs. Every counter covers the whole process, since the last time
+ * libGLdispatch was loaded.
+ */
+PUBLIC void __glDispatchGetStatistics(__GLdispatchStats *stats);
+
+/*!
+ * Why entrypoint patching is turned off for the whole process. This is
+ * returned in \c __GLdispatchConfig::patchDisabledReason.
+ */
+enum {
+    /// Patching isn't disabled.
+    GLDISPATCH_PATCH_DISABLED_NONE,
+
+    /// The __GLVND_DISALLOW_PATCHING environment variable is set.
+    GLDISPATCH_PATCH_DISABLED_ENV_VAR,
+
+    /// No longer used. App error checking (__GLVND_APP_ERROR_CHECKING) works
+    /// with patched entrypoints now, by restoring the default entrypoints
+    /// whenever no context is current.
+    GLDISPATCH_PATCH_DISABLED_APP_ERROR_CHECK,
+
+    /// Patching would hide calls from the call counters (__GLVND_CALL_COUNTS).
+    GLDISPATCH_PATCH_DISABLED_CALL_COUNTS,
+
+    /// Patching would hide calls from the dispatch layers.
+    GLDISPATCH_PATCH_DISABLED_LAYERS,
+};
+
+/*!
+ * Why libGLdispatch refused to patch the entrypoints for a vendor. This is
+ * returned in \c __GLdispatchConfig::lastPatchRefusal.
+ */
+enum {
+    /// No patch has been refused.
+    GLDISPATCH_PATCH_REFUSED_NONE,
+
+    /// None of the loaded entrypoints support patching. This is the case with
+    /// the pure C stubs, and with the TSD stubs on most architectures.
+    GLDISPATCH_PATCH_REFUSED_NO_STUBS,
+
+    /// Patching is disabled. See \c __GLdispatchConfig::patchDisabledReason.
+    GLDISPATCH_PATCH_REFUSED_DISABLED,
+
+    /// A context is current in another thread, and either the vendor's patch
+    /// or the current one doesn't support changing the entrypoints with
+    /// PatchSetStubTarget.
+    GLDISPATCH_PATCH_REFUSED_OTHER_THREAD,
+
+    /// Another vendor's context is current in another thread.
+    GLDISPATCH_PATCH_REFUSED_OTHER_VENDOR,
+};
+
+/*!
+ * How libGLdispatch was built and which dispatch paths it's using, returned
+ * by \c __glDispatchGetConfig.
+ */
+typedef struct __GLdispatchConfigRec {
+    /// The entrypoint stub type that libGLdispatch was built with, such as
+    /// "x86_64_tls", "aarch64_tsd", or "pure_c".
+    const char *entryType;
+
+    /// Which of the GLDISPATCH_STUB_FLAVOR_* values the stubs are using.
+    int stubFlavor;
+
+    /// True if at least one set of loaded entrypoints supports patching.
+    GLboolean patchSupported;
+
+    /// One of the GLDISPATCH_PATCH_DISABLED_* values.
+    int patchDisabledReason;
+
+    /// True if libGLdispatch has seen more than one thread. After that, the
+    /// TSD stubs can't use the single-threaded fast path any more.
+    GLboolean isMultiThreaded;
+
+    /// True if dispatch tables are filled in lazily (__GLVND_LAZY_DISPATCH).
+    GLboolean lazyDispatch;
+
+    /// The vendor ID that owns the patched entrypoints, or zero if the
+    /// entrypoints aren't patched.
+    int patchOwnerVendorID;
+
+    /// One of the GLDISPATCH_PATCH_REFUSED_* values, for the most recent time
+    /// that a vendor's patch was refused. This isn't reset if a later patch
+    /// succeeds.
+    int lastPatchRefusal;
+
+    /// The vendor ID whose patch was refused in \c lastPatchRefusal.
+    int lastPatchRefusalVendorID;
+
+    /// The number of times that a vendor's patch was refused.
+    uint64_t patchRefusalCount;
+} __GLdispatchConfig;
+
+/*!
+ * Reports how libGLdispatch was built and why it is or isn't using patched
+ * entrypoints, so that a support tool can tell why a process is on a slower
+ * dispatch path.
+ */
+PUBLIC void __glDispatchGetConfig(__GLdispatchConfig *config);
+
+struct _glvnd_lock_stats_t;
+
+/*!
+ * Registers a lock's contention counters for lock profiling.
+ *
+ * This does nothing unless the __GLVND_LOCK_STATS environment variable is
+ * set. The counters are written out along with every other registered lock
+ * when the last client library calls \c __glDispatchFini, or when
+ * \c __glDispatchDumpLockStats is called.
+ *
+ * \param library The name of the library that owns the lock.
+ * \param name The name of the lock.
+ * \param stats The lock's counters. If \p count is more than one, then the
+ *      counters are added together, as for the locks in a hashtable.
+ * \param count The number of elements in \p stats.
+ */
+PUBLIC void __glDispatchRegisterLockStats(const char *library,
+        const char *name, struct _glvnd_lock_stats_t *stats, int count);
+
+/*!
+ * Stops reading the counters for every lock that \p library registered.
+ *
+ * A library must call this before it's unloaded. The counts up to this
+ * point are still written out.
+ */
+PUBLIC void __glDispatchUnregisterLockStats(const char *library);
+
+/*!
+ * Writes the lock profiling counts now, instead of waiting until
+ * libGLdispatch is unloaded. This is meant to be called from a debugger.
+ */
+PUBLIC void __glDispatchDumpLockStats(void);
+
+/*!
+ * Starts timing an operation for the slow operation watchdog.
+ *
+ * This does nothing unless the __GLVND_SLOW_OP_US environment variable is
+ * set to a threshold in microseconds.
+ *
+ * \return A start time to pass to \c __glDispatchSlowOpEnd, or zero if the
+ *      watchdog is disabled.
+ */
+PUBLIC uint64_t __glDispatchSlowOpBegin(void);
+
+/*!
+ * Finishes timing an operation, and prints a message if it took at least as
+ * long as the __GLVND_SLOW_OP_US threshold.
+ *
+ * \param start The value that \c __glDispatchSlowOpBegin returned.
+ * \param op A short name for the operation.
+ * \param vendorName The name of the vendor, or NULL to print \p vendorID
+ *      instead.
+ * \param vendorID The vendor's ID from \c __glDispatchNewVendorID, or zero
+ *      if the operation isn't for a particular vendor.
+ */
+PUBLIC void __glDispatchSlowOpEnd(uint64_t start, const char *op,
+        const char *vendorName, int vendorID);
+
+/*!
+ * The window system entrypoints that libGLX and libEGL keep times for. See
+ * \c __glDispatchGetWinsysTimes.
+ */
+enum {
+    GLDISPATCH_WINSYS_GLX_MAKE_CURRENT,
+    GLDISPATCH_WINSYS_GLX_SWAP_BUFFERS,
+    GLDISPATCH_WINSYS_EGL_MAKE_CURRENT,
+    GLDISPATCH_WINSYS_EGL_SWAP_BUFFERS,
+    GLDISPATCH_WINSYS_EGL_GET_PLATFORM_DISPLAY,
+    GLDISPATCH_WINSYS_GLX_MAKE_CONTEXT_CURRENT,
+    GLDISPATCH_WINSYS_COUNT
+};
+
+/*!
+ * The latency histograms from \c __glDispatchGetWinsysHistogram have
+ * 2^GLDISPATCH_WINSYS_HISTOGRAM_SUB_BITS buckets for each power of two
+ * nanoseconds, up to 2^40 ns.
+ */
+#define GLDISPATCH_WINSYS_HISTOGRAM_SUB_BITS 3
+#define GLDISPATCH_WINSYS_HISTOGRAM_BUCKETS 304
+
+/*!
+ * Returns a timestamp for \c __glDispatchWinsysTimeSince and
+ * \c __glDispatchWinsysTimeEnd, or zero if neither the __GLVND_WINSYS_TIMES
+ * nor the __GLVND_WINSYS_HISTOGRAMS environment variable is set.
+ *
+ * A caller should call this once at the start of an entrypoint, and again
+ * right before calling into the vendor.
+ */
+PUBLIC uint64_t __glDispatchWinsysTimeBegin(void);
+
+/*!
+ * Returns the nanoseconds since \p start, or zero if \p start is zero. This
+ * is meant to time the call into the vendor.
+ */
+PUBLIC uint64_t __glDispatchWinsysTimeSince(uint64_t start);
+
+/*!
+ * Adds one call to a window system entrypoint's times.
+ *
+ * \param entry One of the GLDISPATCH_WINSYS_* values.
+ * \param start The value that \c __glDispatchWinsysTimeBegin returned at the
+ *      start of the entrypoint.
+ * \param vendorNS The part of the call that was spent in the vendor.
+ */
+PUBLIC void __glDispatchWinsysTimeEnd(int entry, uint64_t start,
+        uint64_t vendorNS);
+
+/*!
+ * Returns how long the calls to a window system entrypoint have taken, both in
+ * total and inside the vendor library. The difference is libglvnd's overhead.
+ *
+ * \param entry One of the GLDISPATCH_WINSYS_* values.
+ * \param[out] name Returns the name of the entrypoint.
+ * \param[out] calls Returns the number of calls.
+ * \param[out] totalNS Returns the total nanoseconds spent in those calls.
+ * \param[out] vendorNS Returns the nanoseconds spent in the vendor.
+ * \return GL_TRUE on success, or GL_FALSE if __GLVND_WINSYS_TIMES isn't set
+ *      or \p entry is out of range.
+ */
+PUBLIC GLboolean __glDispatchGetWinsysTimes(int entry, const char **name,
+        uint64_t *calls, uint64_t *totalNS, uint64_t *vendorNS);
+
+/*!
+ * Returns the latency histogram of a window system entrypoint, added up from
+ * every thread.
+ *
+ * \param entry One of the GLDISPATCH_WINSYS_* values.
+ * \param[out] counts An array of GLDISPATCH_WINSYS_HISTOGRAM_BUCKETS
+ *      elements, which returns the number of calls in each bucket.
+ * \return GL_TRUE on success, or GL_FALSE if __GLVND_WINSYS_HISTOGRAMS isn't
+ *      set or \p entry is out of range.
+ */
+PUBLIC GLboolean __glDispatchGetWinsysHistogram(int entry, uint64_t *counts);
+
+/*!
+ * Returns the shortest latency in a histogram bucket, in nanoseconds. Each
+ * bucket ends where the next one starts, and the last bucket also counts
+ * every call that took longer.
+ */
+PUBLIC uint64_t __glDispatchWinsysHistogramBucketNS(int bucket);
+
+/*!
+ * Writes the window system call times and histograms now, instead of waiting
+ * until libGLdispatch is unloaded. This does nothing unless
+ * __GLVND_WINSYS_TIMES or __GLVND_WINSYS_HISTOGRAMS is set.
+ */
+PUBLIC void __glDispatchDumpWinsysTimes(void);
+
+/*!
+ * Puts a name on a stub that was generated at runtime, so that profilers and
+ * debuggers can tell which function it is.
+ *
+ * This does nothing unless the __GLVND_PERF_MAP environment variable is set.
+ * libGLdispatch names its own dynamic stubs, so this is for the stubs that
+ * libGLX generates.
+ *
+ * \param addr The start of the stub's code.
+ * \param size The size of the stub's code, in bytes.
+ * \param name The name of the function that the stub is for.
+ */
+PUBLIC void __glDispatchRegisterStubSymbol(const void *addr, int size,
+        const char *name);
+
+struct _glvnd_mem_stats_t;
+
+/*!
+ * Registers a library's memory footprint counters.
+ *
+ * \param library The name of the library.
+ * \param stats The library's counters, with one element for each GLVND_MEM_*
+ *      value in glvnd_memstats.h.
+ */
+PUBLIC void __glDispatchRegisterMemStats(const char *library,
+        const struct _glvnd_mem_stats_t *stats);
+
+/*!
+ * Stops reading the counters that \p library registered, and keeps a copy of
+ * the final counts.
+ *
+ * A library should call this before it's unloaded, after it's freed
+ * everything, so that the final counts show anything that it leaked.
+ */
+PUBLIC void __glDispatchUnregisterMemStats(const char *library);
+
+/*!
+ * Returns how much memory one library is using for one kind of structure.
+ *
+ * \param index The index of the counter, starting at zero. Each registered
+ *      library has one counter for each kind of structure.
+ * \param[out] library Returns the name of the library. The string is only
+ *      valid until the last client library calls \c __glDispatchFini.
+ * \param[out] className Returns the name of the kind of structure.
+ * \param[out] count Returns the number of allocations.
+ * \param[out] bytes Returns the number of bytes allocated.
+ * \param[out] peakBytes Returns the most bytes that were allocated at once.
+ * \return GL_TRUE on success, or GL_FALSE if \p index is past the last
+ *      counter.
+ */
+PUBLIC GLboolean __glDispatchGetMemStats(int index, const char **library,
+        const char **className, int *count, int *bytes, int *peakBytes);
+
+/*!
+ * Writes the memory footprint counts now, instead of waiting until
+ * libGLdispatch is unloaded. This does nothing unless __GLVND_MEM_STATS is
+ * set.
+ */
+PUBLIC void __glDispatchDumpMemStats(void);
+
 #endif
@@ -0,0 +1,386 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+/**
+ * \file
+ *
+ * Per-function call counting.
+ *
+ * Setting __GLVND_CALL_COUNTS to a path enables counting. Each thread that
+ * makes a context current gets its own counting table from
+ * _glapi_create_count_table, which then goes in front of the real dispatch
+ * table. Since each counting table is only current on one thread, a call only
+ * costs a couple of extra instructions and an increment that no other thread
+ * writes to.
+ *
+ * The totals are written to the path, with ".<pid>" appended, when the last
+ * client library calls __glDispatchFini. Each line has a call count and the
+ * function name, sorted from most to fewest calls. __glDispatchGetCallCount
+ * returns the same totals at any time.
+ *
+ * Counting needs the x86-64 TLS stubs, so it's not available in other builds.
+ *
+ * A thread's counting table is freed when the thread exits, after its counts
+ * are added to retiredCounts. If the thread still has a context current, then
+ * the table is freed from GLdispatch's ThreadDestroyed, after the context is
+ * released, so that nothing calls through it afterward.
+ */
+
+#include "GLdispatchPrivate.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <unistd.h>
+
+#include "glvnd_pthread.h"
+
+typedef struct CallCountTableRec {
+    struct _glapi_table *table;
+
+    /*! The dispatch table that \c table currently forwards to */
+    const struct _glapi_table *target;
+
+    struct glvnd_list entry;
+} CallCountTable;
+
+typedef struct CallCountEntryRec {
+    const char *name;
+    uint64_t count;
+} CallCountEntry;
+
+static GLboolean callCountEnabled = GL_FALSE;
+static char *callCountPath = NULL;
+static glvnd_key_t callCountKey;
+
+/*!
+ * The list of every CallCountTable. This is protected by callCountLock,
+ * because threads add and update their own tables without taking the
+ * dispatch lock.
+ */
+static struct glvnd_list callCountTableList;
+static glvnd_mutex_t callCountLock = GLVND_MUTEX_INITIALIZER;
+
+/*!
+ * The totals from the counting tables of threads that have exited. This is
+ * also protected by callCountLock.
+ */
+static uint64_t *retiredCounts = NULL;
+
+static void OnCallCountThreadExit(void *data);
+
+void __glDispatchCallCountInit(void)
+{
+    const char *env;
+    struct _glapi_table *test;
+
+    // Don't let the environment pick a file to write to in a setuid program.
+    if (getuid() != geteuid() || getgid() != getegid()) {
+        return;
+    }
+
+    env = glvndGetEnv("__GLVND_CALL_COUNTS");
+    if (env == NULL || env[0] == '\0') {
+        return;
+    }
+
+    // Make sure that counting tables are supported before turning anything
+    // on.
+    test = _glapi_create_count_table();
+    if (test == NULL) {
+        return;
+    }
+    _glapi_destroy_count_table(test);
+
+    callCountPath = strdup(env);
+    retiredCounts = calloc(_glapi_get_dispatch_table_slot_count(), sizeof(uint64_t));
+    if (callCountPath == NULL || retiredCounts == NULL) {
+        free(callCountPath);
+        free(retiredCounts);
+        callCountPath = NULL;
+        retiredCounts = NULL;
+        return;
+    }
+    if (__glvndPthreadFuncs.key_create(&callCountKey, OnCallCountThreadExit) != 0) {
+        free(callCountPath);
+        free(retiredCounts);
+        callCountPath = NULL;
+        retiredCounts = NULL;
+        return;
+    }
+
+    glvnd_list_init(&callCountTableList);
+    callCountEnabled = GL_TRUE;
+}
+
+GLboolean __glDispatchCallCountEnabled(void)
+{
+    return callCountEnabled;
+}
+
+static CallCountTable *GetThreadCallCountTable(void)
+{
+    CallCountTable *countTable = (CallCountTable *)
+        __glvndPthreadFuncs.getspecific(callCountKey);
+
+    if (countTable != NULL) {
+        return countTable;
+    }
+
+    countTable = malloc(sizeof(CallCountTable));
+    if (countTable == NULL) {
+        return NULL;
+    }
+    countTable->table = _glapi_create_count_table();
+    if (countTable->table == NULL) {
+        free(countTable);
+        return NULL;
+    }
+    countTable->target = NULL;
+    if (__glvndPthreadFuncs.setspecific(callCountKey, countTable) != 0) {
+        _glapi_destroy_count_table(countTable->table);
+        free(countTable);
+        return NULL;
+    }
+
+    __glvndPthreadFuncs.mutex_lock(&callCountLock);
+    glvnd_list_add(&countTable->entry, &callCountTableList);
+    __glvndPthreadFuncs.mutex_unlock(&callCountLock);
+
+    return countTable;
+}
+
+/*!
+ * Adds a counting table's counts to retiredCounts and frees it.
+ */
+static void FreeCallCountTable(CallCountTable *countTable)
+{
+    const uint64_t *counts = _glapi_get_count_table_counts(countTable->table);
+    int slotCount = _glapi_get_dispatch_table_slot_count();
+    int i;
+
+    __glvndPthreadFuncs.mutex_lock(&callCountLock);
+    glvnd_list_del(&countTable->entry);
+    if (retiredCounts != NULL) {
+        for (i=0; i<slotCount; i++) {
+            retiredCounts[i] += counts[i];
+        }
+    }
+    __glvndPthreadFuncs.mutex_unlock(&callCountLock);
+
+    _glapi_destroy_count_table(countTable->table);
+    free(countTable);
+}
+
+static void OnCallCountThreadExit(void *data)
+{
+    CallCountTable *countTable = (CallCountTable *) data;
+
+    if (_glapi_get_current() == countTable->table) {
+        // The thread still has a context current, so ThreadDestroyed hasn't
+        // run yet. Put the table back, and let
+        // __glDispatchCallCountThreadDestroyed free it after the context is
+        // released.
+        __glvndPthreadFuncs.setspecific(callCountKey, countTable);
+        return;
+    }
+    FreeCallCountTable(countTable);
+}
+
+void __glDispatchCallCountThreadDestroyed(void)
+{
+    CallCountTable *countTable;
+
+    if (!callCountEnabled) {
+        return;
+    }
+
+    countTable = (CallCountTable *) __glvndPthreadFuncs.getspecific(callCountKey);
+    if (countTable != NULL) {
+        // LoseCurrentInternal leaves the table current when the thread is
+        // exiting, so switch to the no-op table before freeing it.
+        if (_glapi_get_current() == countTable->table) {
+            _glapi_set_current(NULL);
+        }
+        __glvndPthreadFuncs.setspecific(callCountKey, NULL);
+        FreeCallCountTable(countTable);
+    }
+}
+
+void __glDispatchCallCountSetCurrent(const struct _glapi_table *table)
+{
+    CallCountTable *countTable;
+
+    if (!callCountEnabled) {
+        _glapi_set_current(table);
+        return;
+    }
+
+    if (table == NULL) {
+        // There's nothing to count for the no-op table, but clear the target
+        // so that __glDispatchCallCountUpdateTables doesn't look at a table
+        // that might get freed.
+        _glapi_set_current(NULL);
+        countTable = (CallCountTable *) __glvndPthreadFuncs.getspecific(callCountKey);
+        if (countTable != NULL) {
+            __glvndPthreadFuncs.mutex_lock(&callCountLock);
+            countTable->target = NULL;
+            _glapi_set_count_table_target(countTable->table, NULL);
+            __glvndPthreadFuncs.mutex_unlock(&callCountLock);
+        }
+        return;
+    }
+
+    countTable = GetThreadCallCountTable();
+    if (countTable == NULL) {
+        // If we couldn't allocate a table, then this thread's calls just
+        // won't be counted.
+        _glapi_set_current(table);
+        return;
+    }
+
+    __glvndPthreadFuncs.mutex_lock(&callCountLock);
+    countTable->target = table;
+    _glapi_set_count_table_target(countTable->table, table);
+    __glvndPthreadFuncs.mutex_unlock(&callCountLock);
+
+    _glapi_set_current(countTable->table);
+}
+
+void __glDispatchCallCountUpdateTables(void)
+{
+    CallCountTable *countTable;
+
+    if (!callCountEnabled) {
+        return;
+    }
+
+    __glvndPthreadFuncs.mutex_lock(&callCountLock);
+    glvnd_list_for_each_entry(countTable, &callCountTableList, entry) {
+        if (countTable->target != NULL) {
+            _glapi_set_count_table_target(countTable->table, countTable->target);
+        }
+    }
+    __glvndPthreadFuncs.mutex_unlock(&callCountLock);
+}
+
+uint64_t __glDispatchCallCountGet(int slot)
+{
+    CallCountTable *countTable;
+    uint64_t total = 0;
+
+    if (!callCountEnabled) {
+        return 0;
+    }
+
+    // Each counter is only written by its own thread, so this might miss a
+    // few calls that are happening right now, but every read is of a whole
+    // aligned 64-bit value.
+    __glvndPthreadFuncs.mutex_lock(&callCountLock);
+    total = retiredCounts[slot];
+    glvnd_list_for_each_entry(countTable, &callCountTableList, entry) {
+        total += ((const volatile uint64_t *)
+                _glapi_get_count_table_counts(countTable->table))[slot];
+    }
+    __glvndPthreadFuncs.mutex_unlock(&callCountLock);
+
+    return total;
+}
+
+static int CompareCallCounts(const void *a, const void *b)
+{
+    const CallCountEntry *ea = (const CallCountEntry *) a;
+    const CallCountEntry *eb = (const CallCountEntry *) b;
+
+    if (ea->count != eb->count) {
+        return (ea->count > eb->count ? -1 : 1);
+    }
+    return strcmp(ea->name, eb->name);
+}
+
+void __glDispatchCallCountFini(void)
+{
+    CallCountEntry *entries;
+    char *path;
+    FILE *fp;
+    int count = _glapi_get_stub_count();
+    int slotCount = _glapi_get_dispatch_table_slot_count();
+    int numEntries = 0;
+    int i;
+
+    if (!callCountEnabled) {
+        return;
+    }
+
+    if (count > slotCount) {
+        count = slotCount;
+    }
+    entries = malloc(count * sizeof(CallCountEntry));
+    if (entries == NULL) {
+        goto done;
+    }
+    for (i=0; i<count; i++) {
+        uint64_t calls = __glDispatchCallCountGet(i);
+        if (calls != 0) {
+            entries[numEntries].name = _glapi_get_proc_name(i);
+            entries[numEntries].count = calls;
+            numEntries++;
+        }
+    }
+    qsort(entries, numEntries, sizeof(CallCountEntry), CompareCallCounts);
+
+    if (glvnd_asprintf(&path, "%s.%ld", callCountPath, (long) getpid()) < 0) {
+        free(entries);
+        goto done;
+    }
+    fp = fopen(path, "w");
+    if (fp != NULL) {
+        for (i=0; i<numEntries; i++) {
+            fprintf(fp, "%" PRIu64 " %s\n", entries[i].count, entries[i].name);
+        }
+        fclose(fp);
+    }
+
+    free(path);
+    free(entries);
+
+done:
+    // Other threads might still be calling through their counting tables, so
+    // leave those alone, but make sure that the destructor doesn't run after
+    // libGLdispatch is unloaded.
+    __glvndPthreadFuncs.key_delete(callCountKey);
+    __glvndPthreadFuncs.mutex_lock(&callCountLock);
+    callCountEnabled = GL_FALSE;
+    free(retiredCounts);
+    retiredCounts = NULL;
+    __glvndPthreadFuncs.mutex_unlock(&callCountLock);
+    free(callCountPath);
+    callCountPath = NULL;
+}
@@ -0,0 +1,404 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+/**
+ * \file
+ *
+ * Dispatch layers.
+ *
+ * A layer is a library that intercepts some of the OpenGL functions. The
+ * layer ABI is in glvnd/GLdispatchLayerABI.h.
+ *
+ * Layers are loaded once, in __glDispatchInit, from the JSON manifests listed
+ * in __GLVND_LAYER_FILENAMES, or in the directories listed in
+ * __GLVND_LAYER_DIRS. There's no default directory, since a layer is meant to
+ * be turned on for a single process.
+ *
+ * Rather than adding another table in front of the dispatch table, like the
+ * call counters do, the layers' functions go directly in the dispatch table.
+ * If any layers are loaded, then each new dispatch table's getProcAddress
+ * callback is replaced with __glDispatchLayersGetProcAddress. That looks up
+ * the vendor's function, then asks each layer, starting with the one closest
+ * to the vendor, whether it wants to intercept it. The function below each
+ * layer is saved in the table's layerNext array, where the layer can find it
+ * with getNext. A function that no layer intercepts points straight at the
+ * vendor, and if there aren't any layers, then nothing changes at all.
+ *
+ * Overflow slots aren't layered, since there's no fixed limit on them.
+ */
+
+#include "GLdispatchPrivate.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <fnmatch.h>
+#include <dlfcn.h>
+
+#include "glvnd/GLdispatchLayerABI.h"
+#include "glvnd_json.h"
+
+#define FILE_FORMAT_VERSION_MAJOR 1
+#define FILE_FORMAT_VERSION_MINOR 0
+
+typedef struct __GLdispatchLayerRec {
+    void *dlhandle;
+    __GLdispatchLayerImports imports;
+} __GLdispatchLayer;
+
+static __GLdispatchLayer *layers = NULL;
+static int layerCount = 0;
+static int layerSlotCount = 0;
+
+static __GLdispatchLayerProc GetLayerNext(int layerIndex, int slot);
+
+static const __GLdispatchLayerExports layerExports = {
+    GetLayerNext, // getNext
+};
+
+static void LayerNoop(void)
+{
+}
+
+static GLboolean CheckFormatVersion(const char *versionStr)
+{
+    int major, minor;
+    int len;
+
+    major = minor = -1;
+    len = sscanf(versionStr, "%d.%d", &major, &minor);
+    if (len < 1) {
+        return GL_FALSE;
+    }
+    if (len < 2) {
+        minor = 0;
+    }
+    return (major == FILE_FORMAT_VERSION_MAJOR
+            && minor <= FILE_FORMAT_VERSION_MINOR);
+}
+
+/*!
+ * Reads the library path from a layer manifest.
+ *
+ * \return The library path, which the caller must free, or NULL if the file
+ * couldn't be read or isn't valid.
+ */
+static char *ReadLayerConfigFile(const char *filename)
+{
+    __GLVNDjsonFile file;
+    __GLVNDjsonReader reader;
+    __GLVNDjsonReader layerReader;
+    __GLVNDjsonString key;
+    __GLVNDjsonString version;
+    __GLVNDjsonString libraryPath;
+    GLboolean haveVersion = GL_FALSE;
+    GLboolean haveLayer = GL_FALSE;
+    GLboolean haveLibraryPath = GL_FALSE;
+    char versionStr[32];
+    char *path = NULL;
+    int ret;
+
+    if (__glvndJsonMapFile(filename, &file) != 0) {
+        return NULL;
+    }
+    __glvndJsonReaderInit(&reader, file.data, file.size);
+
+    if (!__glvndJsonBeginObject(&reader)) {
+        goto done;
+    }
+    while ((ret = __glvndJsonNextMember(&reader, &key)) > 0) {
+        if (!haveVersion && __glvndJsonStringEquals(&key, "file_format_version")) {
+            if (!__glvndJsonReadString(&reader, &version)) {
+                goto done;
+            }
+            haveVersion = GL_TRUE;
+            continue;
+        }
+        if (!haveLayer && __glvndJsonStringEquals(&key, "layer")) {
+            layerReader = reader;
+            haveLayer = GL_TRUE;
+        }
+        if (!__glvndJsonSkipValue(&reader)) {
+            goto done;
+        }
+    }
+    if (ret != 0 || !haveVersion || !haveLayer) {
+        goto done;
+    }
+
+    if (__glvndJsonDecodeString(&version, versionStr, sizeof(versionStr)) < 0
+            || !CheckFormatVersion(versionStr)) {
+        goto done;
+    }
+
+    if (!__glvndJsonBeginObject(&layerReader)) {
+        goto done;
+    }
+    while ((ret = __glvndJsonNextMember(&layerReader, &key)) > 0) {
+        if (!haveLibraryPath && __glvndJsonStringEquals(&key, "library_path")) {
+            if (!__glvndJsonReadString(&layerReader, &libraryPath)) {
+                goto done;
+            }
+            haveLibraryPath = GL_TRUE;
+            continue;
+        }
+        if (!__glvndJsonSkipValue(&layerReader)) {
+            goto done;
+        }
+    }
+    if (ret == 0 && haveLibraryPath) {
+        path = __glvndJsonCopyString(&libraryPath);
+    }
+
+done:
+    __glvndJsonUnmapFile(&file);
+    return path;
+}
+
+static void LoadLayer(const char *filename)
+{
+    __GLdispatchLayer *newLayers;
+    __GLdispatchLayer *layer;
+    __PFNGLDISPATCHLAYERMAINPROC layerMain;
+    char *libraryPath;
+
+    libraryPath = ReadLayerConfigFile(filename);
+    if (libraryPath == NULL) {
+        return;
+    }
+
+    newLayers = realloc(layers, (layerCount + 1) * sizeof(__GLdispatchLayer));
+    if (newLayers == NULL) {
+        free(libraryPath);
+        return;
+    }
+    layers = newLayers;
+    layer = &layers[layerCount];
+    memset(layer, 0, sizeof(*layer));
+
+    layer->dlhandle = dlopen(libraryPath, RTLD_LAZY);
+    free(libraryPath);
+    if (layer->dlhandle == NULL) {
+        return;
+    }
+
+    layerMain = (__PFNGLDISPATCHLAYERMAINPROC)
+        dlsym(layer->dlhandle, __GLDISPATCH_LAYER_MAIN_PROTO_NAME);
+    if (layerMain == NULL
+            || !layerMain(GLDISPATCH_LAYER_ABI_VERSION, &layerExports,
+                layerCount, &layer->imports)
+            || layer->imports.getProcAddress == NULL) {
+        dlclose(layer->dlhandle);
+        return;
+    }
+
+    layerCount++;
+}
+
+static int ScandirFilter(const struct dirent *ent)
+{
+#if defined(HAVE_DIRENT_DTYPE)
+    // Ignore the entry if we know that it's not a regular file or symlink.
+    if (ent->d_type != DT_REG && ent->d_type != DT_LNK && ent->d_type != DT_UNKNOWN) {
+        return 0;
+    }
+#endif
+    return (fnmatch("*.json", ent->d_name, 0) == 0);
+}
+
+static int CompareFilenames(const struct dirent **ent1, const struct dirent **ent2)
+{
+    return strcmp((*ent1)->d_name, (*ent2)->d_name);
+}
+
+static void LoadLayersFromDir(const char *dirName)
+{
+    struct dirent **entries = NULL;
+    size_t dirnameLen;
+    const char *pathSep;
+    int count;
+    int i;
+
+    count = scandir(dirName, &entries, ScandirFilter, CompareFilenames);
+    if (count <= 0) {
+        return;
+    }
+
+    dirnameLen = strlen(dirName);
+    if (dirnameLen > 0 && dirName[dirnameLen - 1] != '/') {
+        pathSep = "/";
+    } else {
+        pathSep = "";
+    }
+
+    for (i=0; i<count; i++) {
+        char *path = NULL;
+        if (glvnd_asprintf(&path, "%s%s%s", dirName, pathSep, entries[i]->d_name) > 0) {
+            LoadLayer(path);
+            free(path);
+        }
+        free(entries[i]);
+    }
+
+    free(entries);
+}
+
+void __glDispatchLayersInit(void)
+{
+    const char *env;
+    char **tokens;
+    GLboolean isDir = GL_FALSE;
+    int i;
+
+    // Don't let the environment pick a library to load in a setuid program.
+    if (getuid() != geteuid() || getgid() != getegid()) {
+        return;
+    }
+
+    env = glvndGetEnv("__GLVND_LAYER_FILENAMES");
+    if (env == NULL) {
+        env = glvndGetEnv("__GLVND_LAYER_DIRS");
+        isDir = GL_TRUE;
+    }
+    if (env == NULL || env[0] == '\0') {
+        return;
+    }
+
+    layerSlotCount = _glapi_get_dispatch_table_slot_count();
+
+    tokens = SplitString(env, NULL, ":");
+    if (tokens != NULL) {
+        for (i=0; tokens[i] != NULL; i++) {
+            if (isDir) {
+                LoadLayersFromDir(tokens[i]);
+            } else {
+                LoadLayer(tokens[i]);
+            }
+        }
+        free(tokens);
+    }
+
+    if (layerCount == 0) {
+        free(layers);
+        layers = NULL;
+    }
+}
+
+void __glDispatchLayersFini(void)
+{
+    int i;
+
+    for (i=0; i<layerCount; i++) {
+        dlclose(layers[i].dlhandle);
+    }
+    free(layers);
+    layers = NULL;
+    layerCount = 0;
+}
+
+GLboolean __glDispatchLayersEnabled(void)
+{
+    return (layerCount > 0);
+}
+
+void __glDispatchLayersInitTable(__GLdispatchTable *dispatch)
+{
+    if (layerCount == 0) {
+        return;
+    }
+
+    dispatch->layerNext = calloc(layerCount * layerSlotCount, sizeof(void *));
+    if (dispatch->layerNext == NULL) {
+        // Without somewhere to put the next functions, this table just won't
+        // have any layers.
+        return;
+    }
+
+    dispatch->vendorGetProcAddress = dispatch->getProcAddress;
+    dispatch->vendorGetProcAddressParam = dispatch->getProcAddressParam;
+    dispatch->getProcAddress = __glDispatchLayersGetProcAddress;
+    dispatch->getProcAddressBulk = NULL;
+    dispatch->getProcAddressParam = dispatch;
+}
+
+void __glDispatchLayersFreeTable(__GLdispatchTable *dispatch)
+{
+    free(dispatch->layerNext);
+    dispatch->layerNext = NULL;
+}
+
+void *__glDispatchLayersGetProcAddress(const char *procName, void *param)
+{
+    __GLdispatchTable *dispatch = (__GLdispatchTable *) param;
+    void *proc;
+    int slot = -1;
+    int i;
+
+    proc = dispatch->vendorGetProcAddress(procName,
+            dispatch->vendorGetProcAddressParam);
+    if (proc == NULL) {
+        return NULL;
+    }
+
+    if (_glapi_find_proc_address(procName, &slot) == NULL
+            || slot < 0 || slot >= layerSlotCount) {
+        return proc;
+    }
+
+    for (i=layerCount - 1; i>=0; i--) {
+        void *layerProc;
+
+        dispatch->layerNext[i * layerSlotCount + slot] = proc;
+        layerProc = layers[i].imports.getProcAddress(procName, slot,
+                layers[i].imports.param);
+        if (layerProc != NULL) {
+            proc = layerProc;
+        }
+    }
+    return proc;
+}
+
+static __GLdispatchLayerProc GetLayerNext(int layerIndex, int slot)
+{
+    __GLdispatchTable *dispatch = __glDispatchGetCurrentTable();
+    void *proc;
+
+    if (dispatch == NULL || dispatch->layerNext == NULL
+            || layerIndex < 0 || layerIndex >= layerCount
+            || slot < 0 || slot >= layerSlotCount) {
+        return LayerNoop;
+    }
+
+    // The dispatch table's entry for this slot was stored after this one,
+    // so if the caller got here through the table, then this is filled in.
+    proc = dispatch->layerNext[layerIndex * layerSlotCount + slot];
+    return (proc != NULL ? (__GLdispatchLayerProc) proc : LayerNoop);
+}
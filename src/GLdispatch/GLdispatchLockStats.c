@@ -0,0 +1,213 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+/**
+ * \file
+ *
+ * Lock contention profiling.
+ *
+ * Setting __GLVND_LOCK_STATS to a path enables profiling. libGLdispatch,
+ * libGLX and libEGL each register their interesting locks here, and the
+ * counts from every lock are written to the path, with ".<pid>" appended,
+ * when the last client library calls __glDispatchFini.
+ * __glDispatchDumpLockStats writes the same file at any other time, so it can
+ * be called from a debugger.
+ *
+ * When a library is unloaded, it unregisters its locks, and this keeps a copy
+ * of their final counts.
+ */
+
+#include "GLdispatchPrivate.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "glvnd_pthread.h"
+#include "utils_misc.h"
+
+#define MAX_LOCK_STATS 64
+
+typedef struct LockStatsEntryRec {
+    char *library;
+    char *name;
+
+    /*! The lock's counters, or NULL after the library unregisters it. */
+    glvnd_lock_stats_t *stats;
+    int count;
+
+    /*! The totals from when the lock was unregistered. */
+    glvnd_lock_stats_t final;
+} LockStatsEntry;
+
+static char *lockStatsPath = NULL;
+
+static LockStatsEntry lockStatsEntries[MAX_LOCK_STATS];
+static int lockStatsCount = 0;
+static glvnd_mutex_t lockStatsMutex = GLVND_MUTEX_INITIALIZER;
+
+void __glDispatchLockStatsInit(void)
+{
+    const char *env;
+
+    glvndLockProfilingInit();
+    if (!glvndLockProfiling) {
+        return;
+    }
+
+    env = glvndGetEnv("__GLVND_LOCK_STATS");
+    lockStatsPath = strdup(env);
+    if (lockStatsPath == NULL) {
+        glvndLockProfiling = 0;
+    }
+}
+
+/*!
+ * Adds up the counters for an entry. The caller must hold lockStatsMutex.
+ *
+ * This reads the counters without taking the locks that they belong to, so
+ * the totals can be slightly off if another thread is using them.
+ */
+static void SumLockStats(const LockStatsEntry *entry, glvnd_lock_stats_t *total)
+{
+    int i;
+
+    if (entry->stats == NULL) {
+        *total = entry->final;
+        return;
+    }
+
+    memset(total, 0, sizeof(*total));
+    for (i=0; i<entry->count; i++) {
+        const volatile glvnd_lock_stats_t *stats = &entry->stats[i];
+        total->acquired += stats->acquired;
+        total->spun += stats->spun;
+        total->parked += stats->parked;
+        total->waitNS += stats->waitNS;
+    }
+}
+
+PUBLIC void __glDispatchRegisterLockStats(const char *library,
+        const char *name, struct _glvnd_lock_stats_t *stats, int count)
+{
+    LockStatsEntry *entry;
+
+    if (!glvndLockProfiling) {
+        return;
+    }
+
+    __glvndPthreadFuncs.mutex_lock(&lockStatsMutex);
+    if (lockStatsCount < MAX_LOCK_STATS) {
+        entry = &lockStatsEntries[lockStatsCount];
+        entry->library = strdup(library);
+        entry->name = strdup(name);
+        if (entry->library != NULL && entry->name != NULL) {
+            entry->stats = stats;
+            entry->count = count;
+            lockStatsCount++;
+        } else {
+            free(entry->library);
+            free(entry->name);
+        }
+    }
+    __glvndPthreadFuncs.mutex_unlock(&lockStatsMutex);
+}
+
+PUBLIC void __glDispatchUnregisterLockStats(const char *library)
+{
+    int i;
+
+    if (!glvndLockProfiling) {
+        return;
+    }
+
+    __glvndPthreadFuncs.mutex_lock(&lockStatsMutex);
+    for (i=0; i<lockStatsCount; i++) {
+        LockStatsEntry *entry = &lockStatsEntries[i];
+        if (entry->stats != NULL && strcmp(entry->library, library) == 0) {
+            SumLockStats(entry, &entry->final);
+            entry->stats = NULL;
+        }
+    }
+    __glvndPthreadFuncs.mutex_unlock(&lockStatsMutex);
+}
+
+PUBLIC void __glDispatchDumpLockStats(void)
+{
+    char *path;
+    FILE *fp;
+    int i;
+
+    if (!glvndLockProfiling) {
+        return;
+    }
+
+    if (glvnd_asprintf(&path, "%s.%ld", lockStatsPath, (long) getpid()) < 0) {
+        return;
+    }
+    fp = fopen(path, "w");
+    free(path);
+    if (fp == NULL) {
+        return;
+    }
+
+    fprintf(fp, "# lock,acquired,contended,spun,parked,wait_us\n");
+    __glvndPthreadFuncs.mutex_lock(&lockStatsMutex);
+    for (i=0; i<lockStatsCount; i++) {
+        const LockStatsEntry *entry = &lockStatsEntries[i];
+        glvnd_lock_stats_t total;
+
+        SumLockStats(entry, &total);
+        fprintf(fp, "%s:%s,%lu,%lu,%lu,%lu,%.3f\n", entry->library, entry->name,
+                total.acquired, total.spun + total.parked, total.spun,
+                total.parked, total.waitNS / 1000.0);
+    }
+    __glvndPthreadFuncs.mutex_unlock(&lockStatsMutex);
+    fclose(fp);
+}
+
+void __glDispatchLockStatsFini(void)
+{
+    int i;
+
+    if (!glvndLockProfiling) {
+        return;
+    }
+
+    __glDispatchDumpLockStats();
+
+    __glvndPthreadFuncs.mutex_lock(&lockStatsMutex);
+    for (i=0; i<lockStatsCount; i++) {
+        free(lockStatsEntries[i].library);
+        free(lockStatsEntries[i].name);
+    }
+    lockStatsCount = 0;
+    __glvndPthreadFuncs.mutex_unlock(&lockStatsMutex);
+}
@@ -0,0 +1,194 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+/**
+ * \file
+ *
+ * Memory footprint reporting.
+ *
+ * libGLdispatch, libGLX and libEGL each keep their own glvnd_mem_stats_t
+ * counters, and register them here. __glDispatchGetMemStats returns the
+ * counts for each library, and if __GLVND_MEM_STATS is set to a path, then
+ * they're also written to that path with ".<pid>" appended when the last
+ * client library calls __glDispatchFini.
+ *
+ * When a library is unloaded, it unregisters its counters after freeing
+ * everything, so the final counts also show anything that it leaked.
+ */
+
+#include "GLdispatchPrivate.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "glvnd_pthread.h"
+#include "glvnd_memstats.h"
+#include "utils_misc.h"
+
+#define MAX_MEM_STATS 8
+
+typedef struct MemStatsEntryRec {
+    char *library;
+
+    /*! The library's counters, or NULL after the library unregisters. */
+    const glvnd_mem_stats_t *stats;
+
+    /*! The counts from when the library was unregistered. */
+    glvnd_mem_stats_t final[GLVND_MEM_CLASS_COUNT];
+} MemStatsEntry;
+
+static char *memStatsPath = NULL;
+
+static MemStatsEntry memStatsEntries[MAX_MEM_STATS];
+static int memStatsCount = 0;
+static glvnd_mutex_t memStatsMutex = GLVND_MUTEX_INITIALIZER;
+
+void __glDispatchMemStatsInit(void)
+{
+    const char *env;
+
+    // Don't let the environment pick a file to write to in a setuid program.
+    if (getuid() != geteuid() || getgid() != getegid()) {
+        return;
+    }
+
+    env = glvndGetEnv("__GLVND_MEM_STATS");
+    if (env != NULL && env[0] != '\0') {
+        memStatsPath = strdup(env);
+    }
+}
+
+PUBLIC void __glDispatchRegisterMemStats(const char *library,
+        const struct _glvnd_mem_stats_t *stats)
+{
+    MemStatsEntry *entry;
+
+    __glvndPthreadFuncs.mutex_lock(&memStatsMutex);
+    if (memStatsCount < MAX_MEM_STATS) {
+        entry = &memStatsEntries[memStatsCount];
+        entry->library = strdup(library);
+        if (entry->library != NULL) {
+            entry->stats = stats;
+            memStatsCount++;
+        }
+    }
+    __glvndPthreadFuncs.mutex_unlock(&memStatsMutex);
+}
+
+PUBLIC void __glDispatchUnregisterMemStats(const char *library)
+{
+    int i;
+
+    __glvndPthreadFuncs.mutex_lock(&memStatsMutex);
+    for (i=0; i<memStatsCount; i++) {
+        MemStatsEntry *entry = &memStatsEntries[i];
+        if (entry->stats != NULL && strcmp(entry->library, library) == 0) {
+            memcpy(entry->final, entry->stats, sizeof(entry->final));
+            entry->stats = NULL;
+        }
+    }
+    __glvndPthreadFuncs.mutex_unlock(&memStatsMutex);
+}
+
+PUBLIC GLboolean __glDispatchGetMemStats(int index, const char **library,
+        const char **className, int *count, int *bytes, int *peakBytes)
+{
+    const MemStatsEntry *entry;
+    const glvnd_mem_stats_t *stats;
+    int memClass;
+
+    if (index < 0) {
+        return GL_FALSE;
+    }
+
+    __glvndPthreadFuncs.mutex_lock(&memStatsMutex);
+    if (index >= memStatsCount * GLVND_MEM_CLASS_COUNT) {
+        __glvndPthreadFuncs.mutex_unlock(&memStatsMutex);
+        return GL_FALSE;
+    }
+
+    entry = &memStatsEntries[index / GLVND_MEM_CLASS_COUNT];
+    memClass = index % GLVND_MEM_CLASS_COUNT;
+    stats = (entry->stats != NULL ? &entry->stats[memClass] : &entry->final[memClass]);
+
+    *library = entry->library;
+    *className = glvndMemClassName(memClass);
+    *count = stats->count;
+    *bytes = stats->bytes;
+    *peakBytes = stats->peakBytes;
+    __glvndPthreadFuncs.mutex_unlock(&memStatsMutex);
+
+    return GL_TRUE;
+}
+
+PUBLIC void __glDispatchDumpMemStats(void)
+{
+    const char *library, *className;
+    int count, bytes, peakBytes;
+    char *path;
+    FILE *fp;
+    int i;
+
+    if (memStatsPath == NULL) {
+        return;
+    }
+
+    if (glvnd_asprintf(&path, "%s.%ld", memStatsPath, (long) getpid()) < 0) {
+        return;
+    }
+    fp = fopen(path, "w");
+    free(path);
+    if (fp == NULL) {
+        return;
+    }
+
+    fprintf(fp, "# class,count,bytes,peak_bytes\n");
+    for (i=0; __glDispatchGetMemStats(i, &library, &className,
+                &count, &bytes, &peakBytes); i++) {
+        fprintf(fp, "%s:%s,%d,%d,%d\n", library, className,
+                count, bytes, peakBytes);
+    }
+    fclose(fp);
+}
+
+void __glDispatchMemStatsFini(void)
+{
+    int i;
+
+    __glDispatchDumpMemStats();
+
+    __glvndPthreadFuncs.mutex_lock(&memStatsMutex);
+    for (i=0; i<memStatsCount; i++) {
+        free(memStatsEntries[i].library);
+    }
+    memStatsCount = 0;
+    __glvndPthreadFuncs.mutex_unlock(&memStatsMutex);
+}
@@ -0,0 +1,302 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+/**
+ * \file
+ *
+ * Per-NUMA-node copies of the dispatch tables.
+ *
+ * This is only enabled if the __GLVND_NUMA_DISPATCH_TABLES environment
+ * variable is set to a non-zero value, and the system has more than one NUMA
+ * node.
+ *
+ * Once a dispatch table is filled in, it's copied into a separate read-only
+ * mapping for each node, with the memory bound to that node. When a thread
+ * makes the table current, it gets the copy for the node that it's running
+ * on, so every GL call reads the table from local memory. The original table
+ * is still used for lookups and updates. Each time it's filled in again, any
+ * changed entries are copied into the replicas.
+ *
+ * A lazily populated table gets written to every time a function gets
+ * resolved, so it doesn't get replicas.
+ *
+ * Everything except \c __glDispatchNumaGetTable must be called while holding
+ * the dispatch lock.
+ */
+
+#define _GNU_SOURCE 1
+
+#include "GLdispatchPrivate.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "glvnd_atomic.h"
+#include "glvnd_memstats.h"
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+#if defined(__linux__) && defined(SYS_getcpu) && defined(SYS_mbind)
+
+/*!
+ * The most nodes that we'll make replicas for. This keeps the node mask for
+ * mbind in a single long.
+ */
+#define MAX_NUMA_NODES ((int) (sizeof(unsigned long) * 8))
+
+/*!
+ * The mbind policy that prefers a node but can fall back to others. This is
+ * the same value as MPOL_PREFERRED in <numaif.h>, which is part of libnuma.
+ */
+#define GLVND_MPOL_PREFERRED 1
+
+/*!
+ * The replicas for a dispatch table, one for each node.
+ */
+struct __GLdispatchTableReplicasRec {
+    struct _glapi_table *tables[MAX_NUMA_NODES];
+};
+
+static GLboolean numaEnabled = GL_FALSE;
+static int numNodes;
+static size_t replicaSize;
+
+/*!
+ * Returns the number of possible NUMA nodes, or zero if we can't tell.
+ */
+static int GetNodeCount(void)
+{
+    FILE *in = fopen("/sys/devices/system/node/possible", "r");
+    char buf[64];
+    char *ptr;
+    int maxNode = -1;
+
+    if (in == NULL) {
+        return 0;
+    }
+    if (fgets(buf, sizeof(buf), in) == NULL) {
+        fclose(in);
+        return 0;
+    }
+    fclose(in);
+
+    // The file is a list of ranges, like "0-3". The highest node number is
+    // the last one in the list.
+    ptr = buf;
+    while (*ptr != '\0') {
+        if (*ptr >= '0' && *ptr <= '9') {
+            maxNode = (int) strtol(ptr, &ptr, 10);
+        } else {
+            ptr++;
+        }
+    }
+    return maxNode + 1;
+}
+
+void __glDispatchNumaInit(void)
+{
+    const char *env = glvndGetEnv("__GLVND_NUMA_DISPATCH_TABLES");
+    long pageSize;
+
+    numaEnabled = GL_FALSE;
+    if (env == NULL || atoi(env) == 0) {
+        return;
+    }
+
+    numNodes = GetNodeCount();
+    if (numNodes <= 1) {
+        return;
+    }
+    if (numNodes > MAX_NUMA_NODES) {
+        numNodes = MAX_NUMA_NODES;
+    }
+
+    pageSize = sysconf(_SC_PAGESIZE);
+    if (pageSize <= 0) {
+        return;
+    }
+    replicaSize = _glapi_get_dispatch_table_size() * sizeof(void *);
+    replicaSize = (replicaSize + pageSize - 1) & ~((size_t) pageSize - 1);
+
+    numaEnabled = GL_TRUE;
+}
+
+static struct _glapi_table *AllocReplica(int node)
+{
+    unsigned long mask = 1UL << node;
+    void *table;
+
+    table = mmap(NULL, replicaSize, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (table == MAP_FAILED) {
+        return NULL;
+    }
+
+    // The pages aren't allocated until we write to them, so this decides
+    // where they'll go. If it fails, then the replica still works, it just
+    // might not be local.
+    syscall(SYS_mbind, table, replicaSize, GLVND_MPOL_PREFERRED,
+            &mask, (unsigned long) MAX_NUMA_NODES + 1, 0);
+
+    glvndMemStatsAlloc(GLVND_MEM_DISPATCH_TABLE, replicaSize);
+    return (struct _glapi_table *) table;
+}
+
+/*!
+ * Copies the entries from \p src to \p dst that are different.
+ *
+ * Another thread could be calling through \p dst, so this writes each entry
+ * as a whole pointer.
+ */
+static void CopyReplicaEntries(void * volatile *dst, void * const *src, int count)
+{
+    int i;
+
+    for (i=0; i<count; i++) {
+        if (dst[i] != src[i]) {
+            dst[i] = src[i];
+        }
+    }
+}
+
+void __glDispatchNumaUpdateReplicas(__GLdispatchTable *dispatch)
+{
+    __GLdispatchTableReplicas *replicas = dispatch->replicas;
+    int count = _glapi_get_dispatch_table_size();
+    int node;
+
+
+    if (!numaEnabled || dispatch->lazy || dispatch->table == NULL) {
+        return;
+    }
+
+    if (replicas == NULL) {
+        replicas = calloc(1, sizeof(*replicas));
+        if (replicas == NULL) {
+            return;
+        }
+        glvndMemStatsAlloc(GLVND_MEM_DISPATCH_TABLE, sizeof(*replicas));
+    }
+
+    for (node=0; node<numNodes; node++) {
+        struct _glapi_table *table = replicas->tables[node];
+
+        if (table == NULL) {
+            table = AllocReplica(node);
+            if (table == NULL) {
+                // Threads on this node will just use the original table.
+                continue;
+            }
+        } else if (mprotect(table, replicaSize, PROT_READ | PROT_WRITE) != 0) {
+            continue;
+        }
+
+        CopyReplicaEntries((void * volatile *) table,
+                (void * const *) dispatch->table, count);
+        mprotect(table, replicaSize, PROT_READ);
+
+        // Each replica is published after it's filled in, so a thread that
+        // finds it will never see an empty table.
+        glvndAtomicStoreReleasePtr((void * volatile *) &replicas->tables[node], table);
+    }
+
+    if (dispatch->replicas == NULL) {
+        glvndAtomicStoreReleasePtr((void * volatile *) &dispatch->replicas, replicas);
+    }
+}
+
+void __glDispatchNumaFreeReplicas(__GLdispatchTable *dispatch)
+{
+    __GLdispatchTableReplicas *replicas = dispatch->replicas;
+    int node;
+
+
+    if (replicas == NULL) {
+        return;
+    }
+
+    for (node=0; node<MAX_NUMA_NODES; node++) {
+        if (replicas->tables[node] != NULL) {
+            munmap(replicas->tables[node], replicaSize);
+            glvndMemStatsFree(GLVND_MEM_DISPATCH_TABLE, replicaSize);
+        }
+    }
+    free(replicas);
+    glvndMemStatsFree(GLVND_MEM_DISPATCH_TABLE, sizeof(*replicas));
+    dispatch->replicas = NULL;
+}
+
+const struct _glapi_table *__glDispatchNumaGetTable(__GLdispatchTable *dispatch)
+{
+    __GLdispatchTableReplicas *replicas;
+    struct _glapi_table *table = NULL;
+    unsigned int cpu, node;
+
+    replicas = (__GLdispatchTableReplicas *) glvndAtomicLoadAcquirePtr(
+            (void * volatile *) &dispatch->replicas);
+    if (replicas == NULL) {
+        return dispatch->table;
+    }
+
+    // The thread could get moved to another node right after this, but
+    // that only costs some speed until the next time it makes a context
+    // current.
+    if (syscall(SYS_getcpu, &cpu, &node, NULL) == 0
+            && node < (unsigned int) MAX_NUMA_NODES) {
+        table = (struct _glapi_table *) glvndAtomicLoadAcquirePtr(
+                (void * volatile *) &replicas->tables[node]);
+    }
+    return (table != NULL ? table : dispatch->table);
+}
+
+#else // defined(__linux__) && defined(SYS_getcpu) && defined(SYS_mbind)
+
+void __glDispatchNumaInit(void)
+{
+}
+
+void __glDispatchNumaUpdateReplicas(__GLdispatchTable *dispatch)
+{
+}
+
+void __glDispatchNumaFreeReplicas(__GLdispatchTable *dispatch)
+{
+}
+
+const struct _glapi_table *__glDispatchNumaGetTable(__GLdispatchTable *dispatch)
+{
+    return dispatch->table;
+}
+
+#endif // defined(__linux__) && defined(SYS_getcpu) && defined(SYS_mbind)
@@ -0,0 +1,498 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+/**
+ * \file
+ *
+ * An on-disk cache of dispatch tables.
+ *
+ * Filling in a dispatch table means calling the vendor's getProcAddress
+ * callback for every slot, but for the same builds of libGLdispatch and the
+ * vendor library, the results only differ by where the vendor library got
+ * loaded. Setting __GLVND_DISPATCH_CACHE_DIR to a directory turns on a cache
+ * of those results, so that each process after the first one can fill in a
+ * table by adding the vendor library's load address to each cached offset.
+ *
+ * Only the tables that a client library identified with
+ * __glDispatchSetTableVendor are cached. Each cache file is named after the
+ * build IDs of libGLdispatch and the vendor library and the table's tag, and
+ * it has an entry for each static stub. An entry is the offset of the
+ * function from the vendor library's load address, or PRELINK_NULL if the
+ * vendor doesn't have that function. Any function that isn't in the vendor
+ * library itself is PRELINK_UNKNOWN, and gets looked up the normal way.
+ *
+ * Files are written to a temporary name and then renamed, so a process never
+ * sees a partly-written file. Anything that can write to the directory can
+ * control which vendor functions end up in each slot, so it should only be
+ * writable by trusted users.
+ *
+ * All of these functions must be called while holding the dispatch lock.
+ */
+
+#define _GNU_SOURCE 1
+
+#include "GLdispatchPrivate.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dlfcn.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+#if defined(HAVE_DL_ITERATE_PHDR)
+#include <link.h>
+#endif
+
+#if defined(HAVE_DL_ITERATE_PHDR)
+
+#define PRELINK_MAGIC 0x504c5647u // "GVLP"
+#define PRELINK_VERSION 1
+
+#define PRELINK_UNKNOWN ((int64_t) 0)
+#define PRELINK_NULL ((int64_t) -1)
+
+#define BUILD_ID_MAX_SIZE 64
+#define MAX_EXEC_SEGMENTS 8
+
+typedef struct PrelinkHeaderRec {
+    uint32_t magic;
+    uint32_t version;
+
+    /// The number of entries after the header.
+    uint32_t count;
+    uint32_t reserved;
+} PrelinkHeader;
+
+/*!
+ * A loaded shared library.
+ */
+typedef struct PrelinkObjectRec {
+    /// An address inside the library, which is used to find it.
+    uintptr_t addr;
+
+    /// The load address of the library, which the offsets are relative to.
+    uintptr_t base;
+
+    /// The executable segments of the library.
+    uintptr_t execStart[MAX_EXEC_SEGMENTS];
+    uintptr_t execEnd[MAX_EXEC_SEGMENTS];
+    int numExec;
+
+    /// The build ID, as a hex string. This is empty if the library doesn't
+    /// have one.
+    char buildId[BUILD_ID_MAX_SIZE * 2 + 1];
+} PrelinkObject;
+
+struct __GLdispatchPrelinkRec {
+    __GLdispatchTable *dispatch;
+    PrelinkObject vendor;
+
+    /// The path of the cache file.
+    char *path;
+
+    /// The number of static stubs, which is also the number of entries.
+    int count;
+
+    /// The cache file, or NULL if it didn't exist or wasn't valid.
+    void *map;
+    size_t mapSize;
+    const int64_t *entries;
+};
+
+static char *prelinkDir = NULL;
+static char dispatchBuildId[BUILD_ID_MAX_SIZE * 2 + 1];
+
+static void ReadBuildId(struct dl_phdr_info *info, const ElfW(Phdr) *phdr,
+        char *buildId)
+{
+    const char *ptr = (const char *) (info->dlpi_addr + phdr->p_vaddr);
+    const char *end = ptr + phdr->p_memsz;
+
+    while (ptr + sizeof(ElfW(Nhdr)) <= end) {
+        const ElfW(Nhdr) *note = (const ElfW(Nhdr) *) ptr;
+        const char *name = ptr + sizeof(ElfW(Nhdr));
+        const unsigned char *desc = (const unsigned char *)
+            (name + ((note->n_namesz + 3) & ~3));
+
+        ptr = (const char *) desc + ((note->n_descsz + 3) & ~3);
+        if (ptr > end) {
+            break;
+        }
+
+        if (note->n_type == NT_GNU_BUILD_ID && note->n_namesz == 4
+                && memcmp(name, "GNU", 4) == 0
+                && note->n_descsz > 0 && note->n_descsz <= BUILD_ID_MAX_SIZE) {
+            unsigned int i;
+            for (i=0; i<note->n_descsz; i++) {
+                sprintf(buildId + i * 2, "%02x", desc[i]);
+            }
+            return;
+        }
+    }
+}
+
+static int FindObjectCallback(struct dl_phdr_info *info, size_t size, void *param)
+{
+    PrelinkObject *obj = (PrelinkObject *) param;
+    GLboolean found = GL_FALSE;
+    int i;
+
+    for (i=0; i<info->dlpi_phnum; i++) {
+        const ElfW(Phdr) *phdr = &info->dlpi_phdr[i];
+        uintptr_t start = info->dlpi_addr + phdr->p_vaddr;
+        if (phdr->p_type == PT_LOAD && obj->addr >= start
+                && obj->addr < start + phdr->p_memsz) {
+            found = GL_TRUE;
+            break;
+        }
+    }
+    if (!found) {
+        return 0;
+    }
+
+    obj->base = info->dlpi_addr;
+    obj->numExec = 0;
+    obj->buildId[0] = '\0';
+    for (i=0; i<info->dlpi_phnum; i++) {
+        const ElfW(Phdr) *phdr = &info->dlpi_phdr[i];
+        if (phdr->p_type == PT_LOAD && (phdr->p_flags & PF_X)
+                && obj->numExec < MAX_EXEC_SEGMENTS) {
+            obj->execStart[obj->numExec] = info->dlpi_addr + phdr->p_vaddr;
+            obj->execEnd[obj->numExec] = obj->execStart[obj->numExec] + phdr->p_memsz;
+            obj->numExec++;
+        } else if (phdr->p_type == PT_NOTE && obj->buildId[0] == '\0') {
+            ReadBuildId(info, phdr, obj->buildId);
+        }
+    }
+    return 1;
+}
+
+/*!
+ * Finds the library that contains \p addr. Returns GL_FALSE if there isn't
+ * one, or if it doesn't have a build ID.
+ */
+static GLboolean FindObject(uintptr_t addr, PrelinkObject *obj)
+{
+    memset(obj, 0, sizeof(*obj));
+    obj->addr = addr;
+    if (!dl_iterate_phdr(FindObjectCallback, obj)) {
+        return GL_FALSE;
+    }
+    return (obj->buildId[0] != '\0');
+}
+
+static GLboolean IsInExecSegment(const PrelinkObject *obj, uintptr_t addr)
+{
+    int i;
+    for (i=0; i<obj->numExec; i++) {
+        if (addr >= obj->execStart[i] && addr < obj->execEnd[i]) {
+            return GL_TRUE;
+        }
+    }
+    return GL_FALSE;
+}
+
+void __glDispatchPrelinkInit(void)
+{
+    const char *env;
+    PrelinkObject self;
+
+    // Don't let the environment pick a directory to read from or write to in
+    // a setuid program.
+    if (getuid() != geteuid() || getgid() != getegid()) {
+        return;
+    }
+
+    env = glvndGetEnv("__GLVND_DISPATCH_CACHE_DIR");
+    if (env == NULL || env[0] == '\0') {
+        return;
+    }
+
+    // The slot for each static stub depends on how libGLdispatch was built,
+    // so its build ID goes in the file name, too.
+    if (!FindObject((uintptr_t) __glDispatchPrelinkInit, &self)) {
+        return;
+    }
+    strcpy(dispatchBuildId, self.buildId);
+    prelinkDir = strdup(env);
+}
+
+void __glDispatchPrelinkFini(void)
+{
+    free(prelinkDir);
+    prelinkDir = NULL;
+}
+
+GLboolean __glDispatchPrelinkIsValidTag(const char *tag)
+{
+    const char *ptr;
+
+    if (tag[0] == '\0' || strlen(tag) > 32) {
+        return GL_FALSE;
+    }
+    for (ptr = tag; *ptr != '\0'; ptr++) {
+        if (!((*ptr >= 'a' && *ptr <= 'z') || (*ptr >= 'A' && *ptr <= 'Z')
+                    || (*ptr >= '0' && *ptr <= '9') || *ptr == '-' || *ptr == '_')) {
+            return GL_FALSE;
+        }
+    }
+    return GL_TRUE;
+}
+
+static void LoadCacheFile(__GLdispatchPrelink *prelink)
+{
+    const PrelinkHeader *header;
+    const int64_t *entries;
+    struct stat st;
+    void *map;
+    int fd;
+    int i;
+
+    fd = open(prelink->path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return;
+    }
+    if (fstat(fd, &st) != 0 || st.st_size != (off_t)
+            (sizeof(PrelinkHeader) + prelink->count * sizeof(int64_t))) {
+        close(fd);
+        return;
+    }
+    map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return;
+    }
+
+    header = (const PrelinkHeader *) map;
+    entries = (const int64_t *) (header + 1);
+    if (header->magic != PRELINK_MAGIC || header->version != PRELINK_VERSION
+            || header->count != (uint32_t) prelink->count) {
+        munmap(map, st.st_size);
+        return;
+    }
+
+    // Make sure that every function is in executable code in the vendor
+    // library, so that a bad file can't point a slot anywhere else.
+    for (i=0; i<prelink->count; i++) {
+        if (entries[i] != PRELINK_UNKNOWN && entries[i] != PRELINK_NULL
+                && (entries[i] < 0 || !IsInExecSegment(&prelink->vendor,
+                        prelink->vendor.base + (uintptr_t) entries[i]))) {
+            munmap(map, st.st_size);
+            return;
+        }
+    }
+
+    prelink->map = map;
+    prelink->mapSize = st.st_size;
+    prelink->entries = entries;
+}
+
+GLboolean __glDispatchPrelinkIsEnabled(void)
+{
+    return (prelinkDir != NULL);
+}
+
+__GLdispatchPrelink *__glDispatchPrelinkOpen(__GLdispatchTable *dispatch)
+{
+    __GLdispatchPrelink *prelink;
+    struct link_map *lm = NULL;
+
+    if (prelinkDir == NULL || dispatch->vendorHandle == NULL) {
+        return NULL;
+    }
+
+    prelink = calloc(1, sizeof(__GLdispatchPrelink));
+    if (prelink == NULL) {
+        return NULL;
+    }
+    prelink->dispatch = dispatch;
+    prelink->count = _glapi_get_static_stub_count();
+
+    // The dynamic section is always inside one of the library's segments, so
+    // use it to find the rest of the library.
+    if (dlinfo(dispatch->vendorHandle, RTLD_DI_LINKMAP, &lm) != 0 || lm == NULL
+            || !FindObject((uintptr_t) lm->l_ld, &prelink->vendor)) {
+        free(prelink);
+        return NULL;
+    }
+
+    if (glvnd_asprintf(&prelink->path, "%s/%s-%s-%s", prelinkDir,
+                dispatchBuildId, prelink->vendor.buildId,
+                dispatch->vendorTag) < 0) {
+        free(prelink);
+        return NULL;
+    }
+
+    LoadCacheFile(prelink);
+    return prelink;
+}
+
+int __glDispatchPrelinkFill(__GLdispatchPrelink *prelink, void **tbl,
+        int count, void *noopFunc)
+{
+    int i;
+
+    if (prelink->entries == NULL) {
+        return 0;
+    }
+    if (count > prelink->count) {
+        count = prelink->count;
+    }
+
+    for (i=0; i<count; i++) {
+        int64_t entry = prelink->entries[i];
+        if (entry == PRELINK_UNKNOWN) {
+            tbl[i] = NULL;
+        } else if (entry == PRELINK_NULL) {
+            tbl[i] = noopFunc;
+        } else {
+            tbl[i] = (void *) (prelink->vendor.base + (uintptr_t) entry);
+        }
+    }
+    return count;
+}
+
+static int64_t GetEntry(__GLdispatchPrelink *prelink, void *func)
+{
+    if (func == NULL) {
+        return PRELINK_NULL;
+    } else if (IsInExecSegment(&prelink->vendor, (uintptr_t) func)) {
+        return (int64_t) ((uintptr_t) func - prelink->vendor.base);
+    } else {
+        return PRELINK_UNKNOWN;
+    }
+}
+
+static void WriteCacheFile(__GLdispatchPrelink *prelink, void * const *tbl)
+{
+    __GLdispatchTable *dispatch = prelink->dispatch;
+    PrelinkHeader header;
+    int64_t *entries;
+    char *tempPath = NULL;
+    size_t size;
+    int fd;
+    int i;
+
+    size = prelink->count * sizeof(int64_t);
+    entries = malloc(size);
+    if (entries == NULL) {
+        return;
+    }
+
+    for (i=0; i<prelink->count; i++) {
+        entries[i] = GetEntry(prelink, tbl[i]);
+        if (entries[i] == PRELINK_UNKNOWN) {
+            // The slot is either a function from some other library, or the
+            // no-op function because it was skipped or because the vendor
+            // doesn't have it. Look it up again to tell which.
+            const char *name = _glapi_get_proc_name(i);
+            assert(name != NULL);
+            entries[i] = GetEntry(prelink, dispatch->getProcAddress(name,
+                        dispatch->getProcAddressParam));
+        }
+    }
+
+    memset(&header, 0, sizeof(header));
+    header.magic = PRELINK_MAGIC;
+    header.version = PRELINK_VERSION;
+    header.count = prelink->count;
+
+    if (glvnd_asprintf(&tempPath, "%s.XXXXXX", prelink->path) < 0) {
+        free(entries);
+        return;
+    }
+    fd = mkstemp(tempPath);
+    if (fd >= 0) {
+        GLboolean success = (write(fd, &header, sizeof(header)) == sizeof(header)
+                && write(fd, entries, size) == (ssize_t) size
+                && fchmod(fd, 0644) == 0);
+        close(fd);
+        if (!success || rename(tempPath, prelink->path) != 0) {
+            unlink(tempPath);
+        }
+    }
+    free(tempPath);
+    free(entries);
+}
+
+void __glDispatchPrelinkClose(__GLdispatchPrelink *prelink, void * const *tbl,
+        int count)
+{
+    if (prelink->entries == NULL && count >= prelink->count) {
+        WriteCacheFile(prelink, tbl);
+    }
+    if (prelink->map != NULL) {
+        munmap(prelink->map, prelink->mapSize);
+    }
+    free(prelink->path);
+    free(prelink);
+}
+
+#else // defined(HAVE_DL_ITERATE_PHDR)
+
+void __glDispatchPrelinkInit(void)
+{
+}
+
+void __glDispatchPrelinkFini(void)
+{
+}
+
+GLboolean __glDispatchPrelinkIsValidTag(const char *tag)
+{
+    return GL_FALSE;
+}
+
+GLboolean __glDispatchPrelinkIsEnabled(void)
+{
+    return GL_FALSE;
+}
+
+__GLdispatchPrelink *__glDispatchPrelinkOpen(__GLdispatchTable *dispatch)
+{
+    return NULL;
+}
+
+int __glDispatchPrelinkFill(__GLdispatchPrelink *prelink, void **tbl,
+        int count, void *noopFunc)
+{
+    return 0;
+}
+
+void __glDispatchPrelinkClose(__GLdispatchPrelink *prelink, void * const *tbl,
+        int count)
+{
+}
+
+#endif // defined(HAVE_DL_ITERATE_PHDR)
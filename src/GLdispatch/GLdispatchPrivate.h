@@ -36,13 +36,37 @@
 #include "entry.h"
 #include "utils_misc.h"
 
+/*!
+ * Tracks which pages of a dispatch table are shared with other tables.
+ */
+typedef struct __GLdispatchTablePagesRec __GLdispatchTablePages;
+typedef struct __GLdispatchTableReplicasRec __GLdispatchTableReplicas;
+
+/*!
+ * A dispatch table's entry in the on-disk dispatch table cache.
+ */
+typedef struct __GLdispatchPrelinkRec __GLdispatchPrelink;
+
 /*!
  * Private dispatch table structure. This is used by GLdispatch for tracking
  * and updating dispatch tables.
  */
 struct __GLdispatchTableRec {
-    /*! Number of threads this dispatch is current on */
-    int currentThreads;
+    /*!
+     * Number of threads this dispatch is current on. This is updated with
+     * atomic operations, without the dispatch lock.
+     */
+    int volatile currentThreads;
+
+    /*!
+     * Non-zero if this table is in the current dispatch list. A table is
+     * added the first time it's made current, and stays in the list until
+     * it's destroyed.
+     */
+    int volatile registered;
+
+    /*! The vendor ID that this table was first made current with */
+    int vendorID;
 
     /*!
      * The number of dispatch table entries that have been populated. This is
@@ -52,13 +76,494 @@ struct __GLdispatchTableRec {
 
     /*! Saved vendor library callbacks */
     __GLgetProcAddressCallback getProcAddress;
+    __GLgetProcAddressBulkCallback getProcAddressBulk;
     void *getProcAddressParam;
 
+    /*!
+     * If true, then new slots in the dispatch table start out pointing to the
+     * lazy resolver trampolines, and each function is only looked up the
+     * first time it's called.
+     */
+    GLboolean lazy;
+
+    /*!
+     * The value of neededSlotGeneration in GLdispatch.c when this table was
+     * last filled in. Any slots that were registered after that still need
+     * to be looked up.
+     */
+    int slotGeneration;
+
+    /*!
+     * True while a thread is looking up the functions for this table in
+     * PrefetchDispatchTable without holding the dispatch lock.
+     */
+    GLboolean prefetching;
+
+    /*!
+     * True if PrewarmDispatchTable has faulted in this table. See
+     * \c __GLVND_PREWARM_DISPATCH in GLdispatch.c.
+     */
+    GLboolean prewarmed;
+
+    /*!
+     * The vendor's functions for the first \c staticFuncCount slots, from
+     * \c __glDispatchSetTableStaticFuncs, or NULL.
+     */
+    const void * const *staticFuncs;
+    int staticFuncCount;
+
     /*! The real dispatch table */
     struct _glapi_table *table;
 
+    /*!
+     * The page-sharing state for \c table, or NULL if the table was
+     * allocated with calloc and isn't shared.
+     */
+    __GLdispatchTablePages *pages;
+
+    /*!
+     * The per-node copies of \c table, or NULL if there aren't any. See
+     * GLdispatchNuma.c.
+     */
+    __GLdispatchTableReplicas * volatile replicas;
+
+    /*!
+     * The vendor library and tag from \c __glDispatchSetTableVendor, or NULL
+     * if the table shouldn't be cached on disk.
+     */
+    void *vendorHandle;
+    char *vendorTag;
+
+    /*!
+     * Non-zero if this table belongs to the pinned vendor and has been added
+     * to the current dispatch list for good. See \c __GLVND_PIN_VENDOR in
+     * GLdispatch.c.
+     */
+    int volatile pinned;
+
+    /*!
+     * If any dispatch layers are loaded, then \c getProcAddress is
+     * \c __glDispatchLayersGetProcAddress, and these are the vendor's
+     * callback and parameter. See GLdispatchLayers.c.
+     */
+    __GLgetProcAddressCallback vendorGetProcAddress;
+    void *vendorGetProcAddressParam;
+
+    /*!
+     * The function below each layer for each slot, or NULL if this table
+     * doesn't have any layers. The entry for a layer and slot is at
+     * (layerIndex * slotCount + slot).
+     */
+    void **layerNext;
+
     /*! List handle */
     struct glvnd_list entry;
 };
 
+/*!
+ * Initializes the dispatch table page sharing.
+ *
+ * Sharing is off unless the __GLVND_SHARE_DISPATCH_TABLES environment variable
+ * is set to a non-zero value.
+ */
+void __glDispatchSharedTablesInit(void);
+
+/*!
+ * Cleans up the dispatch table page sharing.
+ */
+void __glDispatchSharedTablesFini(void);
+
+/*!
+ * Allocates the memory for a dispatch table, which will be filled with zeroes.
+ */
+struct _glapi_table *__glDispatchAllocTableMemory(__GLdispatchTable *dispatch);
+
+/*!
+ * Frees the memory for a dispatch table.
+ */
+void __glDispatchFreeTableMemory(__GLdispatchTable *dispatch);
+
+/*!
+ * Makes the entries from \p first to \p count - 1 in a dispatch table
+ * writable. Any shared pages in that range are replaced with a private copy.
+ */
+GLboolean __glDispatchTableMakeWritable(__GLdispatchTable *dispatch,
+        int first, int count);
+
+/*!
+ * Looks for pages of a dispatch table that are identical to the same page in
+ * another table, and shares them.
+ */
+void __glDispatchShareTablePages(__GLdispatchTable *dispatch);
+
+/*!
+ * Sets up the per-NUMA-node dispatch table replicas.
+ *
+ * Replicas are off unless the __GLVND_NUMA_DISPATCH_TABLES environment
+ * variable is set to a non-zero value.
+ */
+void __glDispatchNumaInit(void);
+
+/*!
+ * Creates or updates the per-node replicas of a dispatch table. This is
+ * called after the table is filled in.
+ */
+void __glDispatchNumaUpdateReplicas(__GLdispatchTable *dispatch);
+
+/*!
+ * Frees the per-node replicas of a dispatch table.
+ */
+void __glDispatchNumaFreeReplicas(__GLdispatchTable *dispatch);
+
+/*!
+ * Returns the copy of a dispatch table to make current on the calling
+ * thread. That's the replica for the thread's NUMA node if there is one, or
+ * the table itself otherwise.
+ *
+ * This doesn't need the dispatch lock.
+ */
+const struct _glapi_table *__glDispatchNumaGetTable(__GLdispatchTable *dispatch);
+
+/*!
+ * Sets up the on-disk dispatch table cache.
+ *
+ * This reads the __GLVND_DISPATCH_CACHE_DIR environment variable.
+ */
+void __glDispatchPrelinkInit(void);
+
+/*!
+ * Cleans up the on-disk dispatch table cache. This is called when the last
+ * client library is finished with libGLdispatch.
+ */
+void __glDispatchPrelinkFini(void);
+
+/*!
+ * Returns true if \p tag can be used in the name of a cache file.
+ */
+GLboolean __glDispatchPrelinkIsValidTag(const char *tag);
+
+/*!
+ * Looks up the cache file for a dispatch table, before the table is filled in
+ * for the first time.
+ *
+ * \return The cache entry, or NULL if the table can't be cached.
+ */
+__GLdispatchPrelink *__glDispatchPrelinkOpen(__GLdispatchTable *dispatch);
+
+/*!
+ * Returns true if the on-disk dispatch table cache is enabled.
+ */
+GLboolean __glDispatchPrelinkIsEnabled(void);
+
+/*!
+ * Fills in a dispatch table from the cache file.
+ *
+ * Each function that the cache doesn't know about is set to NULL, and has to
+ * be looked up the normal way. Each function that the vendor doesn't have is
+ * set to \p noopFunc.
+ *
+ * \param prelink The cache entry from \c __glDispatchPrelinkOpen.
+ * \param tbl The dispatch table.
+ * \param count The number of slots to fill in.
+ * \param noopFunc The no-op function.
+ * \return The number of slots that were filled in, or zero if there wasn't a
+ * valid cache file.
+ */
+int __glDispatchPrelinkFill(__GLdispatchPrelink *prelink, void **tbl,
+        int count, void *noopFunc);
+
+/*!
+ * Frees a cache entry after the dispatch table is filled in. If there wasn't
+ * a valid cache file, then this writes one from the table.
+ *
+ * \param prelink The cache entry from \c __glDispatchPrelinkOpen.
+ * \param tbl The dispatch table, with every slot filled in.
+ * \param count The number of slots in \p tbl that were filled in.
+ */
+void __glDispatchPrelinkClose(__GLdispatchPrelink *prelink, void * const *tbl,
+        int count);
+
+/*!
+ * Sets up event tracing.
+ *
+ * This reads the __GLVND_TRACE_* environment variables, and installs the
+ * fatal signal handlers for a flight recorder. It's called once, when
+ * libGLdispatch is loaded.
+ */
+void __glDispatchTraceInit(void);
+
+/*!
+ * Writes out any trace events that haven't been written yet, unless tracing
+ * is a flight recorder, and removes the signal handlers. This is called when
+ * the last client library is finished with libGLdispatch.
+ */
+void __glDispatchTraceFini(void);
+
+/*!
+ * Sets up call counting.
+ *
+ * This reads the __GLVND_CALL_COUNTS environment variable. It's called once,
+ * when libGLdispatch is loaded.
+ */
+void __glDispatchCallCountInit(void);
+
+/*!
+ * Returns true if call counting is enabled.
+ */
+GLboolean __glDispatchCallCountEnabled(void);
+
+/*!
+ * Makes a dispatch table current on this thread.
+ *
+ * If call counting is enabled, then this makes the thread's counting table
+ * current instead, and points it at \p table. Otherwise, this is the same as
+ * \c _glapi_set_current.
+ */
+void __glDispatchCallCountSetCurrent(const struct _glapi_table *table);
+
+/*!
+ * Frees the calling thread's counting table. This is called from
+ * ThreadDestroyed, after the thread's context has been released.
+ */
+void __glDispatchCallCountThreadDestroyed(void);
+
+/*!
+ * Updates every counting table after new overflow chunks have been allocated
+ * in any dispatch table. The caller must hold the dispatch lock.
+ */
+void __glDispatchCallCountUpdateTables(void);
+
+/*!
+ * Returns the total number of calls to a dispatch slot from every thread.
+ */
+uint64_t __glDispatchCallCountGet(int slot);
+
+/*!
+ * Writes out the call counts. This is called when the last client library is
+ * finished with libGLdispatch, with the dispatch lock held.
+ */
+void __glDispatchCallCountFini(void);
+
+/*!
+ * Returns the dispatch table that's current on the calling thread, or NULL if
+ * there isn't a current context. This doesn't need the dispatch lock.
+ */
+__GLdispatchTable *__glDispatchGetCurrentTable(void);
+
+/*!
+ * Loads the dispatch layers.
+ *
+ * This reads the __GLVND_LAYER_FILENAMES and __GLVND_LAYER_DIRS environment
+ * variables. It's called from __glDispatchInit, with the dispatch lock held.
+ */
+void __glDispatchLayersInit(void);
+
+/*!
+ * Unloads the dispatch layers. This is called when the last client library
+ * is finished with libGLdispatch, with the dispatch lock held.
+ */
+void __glDispatchLayersFini(void);
+
+/*!
+ * Returns true if any dispatch layers are loaded.
+ */
+GLboolean __glDispatchLayersEnabled(void);
+
+/*!
+ * Sets up a new dispatch table to add the layers' functions when it looks up
+ * the vendor's functions. This does nothing if there aren't any layers.
+ */
+void __glDispatchLayersInitTable(__GLdispatchTable *dispatch);
+
+/*!
+ * Frees a dispatch table's layer data.
+ */
+void __glDispatchLayersFreeTable(__GLdispatchTable *dispatch);
+
+/*!
+ * The getProcAddress callback for a dispatch table with layers. This looks up
+ * the vendor's function and then asks each layer whether it wants to
+ * intercept it. It must be called with the dispatch lock held.
+ *
+ * \param param The __GLdispatchTable.
+ */
+void *__glDispatchLayersGetProcAddress(const char *procName, void *param);
+
+/*!
+ * Sets up lock profiling.
+ *
+ * This reads the __GLVND_LOCK_STATS environment variable. It's called once,
+ * when libGLdispatch is loaded.
+ */
+void __glDispatchLockStatsInit(void);
+
+/*!
+ * Writes out the lock counts and forgets every registered lock. This is
+ * called when the last client library is finished with libGLdispatch, with
+ * the dispatch lock held.
+ */
+void __glDispatchLockStatsFini(void);
+
+/*!
+ * Sets up memory footprint reporting.
+ *
+ * This reads the __GLVND_MEM_STATS environment variable. It's called once,
+ * when libGLdispatch is loaded.
+ */
+void __glDispatchMemStatsInit(void);
+
+/*!
+ * Writes out the memory counts and forgets every registered library. This is
+ * called when the last client library is finished with libGLdispatch, with
+ * the dispatch lock held.
+ */
+void __glDispatchMemStatsFini(void);
+
+/*!
+ * Sets up the slow operation watchdog.
+ *
+ * This reads the __GLVND_SLOW_OP_US environment variable. It's called once,
+ * when libGLdispatch is loaded.
+ */
+void __glDispatchSlowOpsInit(void);
+
+/*!
+ * The same as \c __glDispatchSlowOpEnd, but for an operation on a dispatch
+ * table. This finds the name of the table's vendor library itself.
+ */
+void __glDispatchSlowOpEndTable(uint64_t start, const char *op,
+        __GLdispatchTable *dispatch);
+
+/*!
+ * Sets up the window system call times.
+ *
+ * This reads the __GLVND_WINSYS_TIMES and __GLVND_WINSYS_HISTOGRAMS
+ * environment variables. It's called once, when libGLdispatch is loaded.
+ */
+void __glDispatchWinsysTimesInit(void);
+
+/*!
+ * Writes out the window system call times and histograms. This is called
+ * when the last client library is finished with libGLdispatch.
+ */
+void __glDispatchWinsysTimesFini(void);
+
+/*!
+ * Sets up the symbol map for generated stubs.
+ *
+ * This reads the __GLVND_PERF_MAP environment variable. It's called once,
+ * when libGLdispatch is loaded.
+ */
+void __glDispatchSymbolMapInit(void);
+
+/*!
+ * Names the dynamic stubs from \p first to \p last - 1, which were just
+ * generated. This is called with the dispatch lock held.
+ */
+void __glDispatchSymbolMapAddStubs(int first, int last);
+
+/*!
+ * Unregisters everything from the debugger. This is called when the last
+ * client library is finished with libGLdispatch.
+ */
+void __glDispatchSymbolMapFini(void);
+
+#define GLDISPATCH_SHM_STATS_MAGIC "GLVNDSHM"
+#define GLDISPATCH_SHM_STATS_VERSION 1
+
+/*!
+ * The layout of the shared memory statistics file. See GLdispatchShmStats.c.
+ *
+ * Every field is naturally aligned, so that a reader in another process can
+ * read each counter in one load. New counters only ever get added to the end.
+ */
+typedef struct __GLdispatchShmStatsRec {
+    /// GLDISPATCH_SHM_STATS_MAGIC, without a terminator. This is written
+    /// last, so a reader can tell whether the rest is filled in.
+    char magic[8];
+    uint32_t version;
+
+    /// The size of this structure, so that a reader can tell which counters
+    /// exist.
+    uint32_t size;
+    uint64_t pid;
+
+    /// These are updated as they happen.
+    uint64_t makeCurrentCount;
+    uint64_t vendorSwitchCount;
+    uint64_t fixupCount;
+    uint64_t fixupTimeNS;
+
+    /// These are copies of the __glDispatchGetStatistics counters, which are
+    /// updated each time the dispatch lock is released.
+    uint64_t tableCount;
+    uint64_t patchOwnerVendorID;
+    uint64_t patchCount;
+    uint64_t unpatchCount;
+    uint64_t patchTimeUS;
+    uint64_t lockAcquired;
+    uint64_t lockContended;
+    uint64_t lockWaitNS;
+    uint64_t dynamicStubCount;
+    uint64_t dynamicStubMax;
+} __GLdispatchShmStats;
+
+/*!
+ * The shared memory statistics, or NULL if they aren't enabled.
+ */
+extern __GLdispatchShmStats * volatile __glDispatchShmStats;
+
+#if defined(__ATOMIC_RELAXED)
+#define GLDISPATCH_SHM_STATS_SUPPORTED 1
+
+#define GLDISPATCH_SHM_STATS_ADD(field, delta) do { \
+    __GLdispatchShmStats *shmStats_ = __glDispatchShmStats; \
+    if (shmStats_ != NULL) { \
+        __atomic_fetch_add(&shmStats_->field, (uint64_t) (delta), __ATOMIC_RELAXED); \
+    } \
+} while (0)
+
+#define GLDISPATCH_SHM_STATS_SET(field, value) do { \
+    __GLdispatchShmStats *shmStats_ = __glDispatchShmStats; \
+    if (shmStats_ != NULL) { \
+        __atomic_store_n(&shmStats_->field, (uint64_t) (value), __ATOMIC_RELAXED); \
+    } \
+} while (0)
+#else
+#define GLDISPATCH_SHM_STATS_ADD(field, delta) do { } while (0)
+#define GLDISPATCH_SHM_STATS_SET(field, value) do { } while (0)
+#endif
+
+/*!
+ * Sets up the shared memory statistics.
+ *
+ * This reads the __GLVND_SHM_STATS environment variable. It's called once,
+ * when libGLdispatch is loaded.
+ */
+void __glDispatchShmStatsInit(void);
+
+/*!
+ * Returns a timestamp in nanoseconds for a counter in the shared memory
+ * statistics, or zero if they aren't enabled.
+ */
+uint64_t __glDispatchShmStatsTimeBegin(void);
+
+/*!
+ * Returns the nanoseconds since \p start, which came from
+ * \c __glDispatchShmStatsTimeBegin.
+ */
+uint64_t __glDispatchShmStatsTimeSince(uint64_t start);
+
+/*!
+ * Creates a new file for the child process after a fork. This is called from
+ * \c __glDispatchReset, before it takes the dispatch lock.
+ */
+void __glDispatchShmStatsReset(void);
+
+/*!
+ * Unmaps and removes the file. This is called when the last client library
+ * is finished with libGLdispatch.
+ */
+void __glDispatchShmStatsFini(void);
+
 #endif
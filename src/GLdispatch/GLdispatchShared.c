@@ -0,0 +1,488 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+/**
+ * \file
+ *
+ * Deduplication of identical dispatch table pages.
+ *
+ * This changes how every dispatch table is allocated, so it's only enabled if
+ * the __GLVND_SHARE_DISPATCH_TABLES environment variable is set to a non-zero
+ * value. Otherwise, each table is a plain calloc'ed array.
+ *
+ * Each dispatch table is allocated as its own page-aligned anonymous mapping.
+ * After a table is filled in, each page of it is compared to the same page in
+ * every other table. When two pages are identical, the contents are copied
+ * into a page of a memfd-backed pool, and that pool page is mapped read-only
+ * on top of both tables. Each table keeps the same address, so any thread
+ * that has a table current keeps using it without noticing.
+ *
+ * Before a shared page gets written to, it's copied to a new private page,
+ * which then replaces the shared mapping with mremap(2). The replacement is
+ * atomic, so any other thread sees either the old page or the new one.
+ *
+ * Pool pages are never reused or released back to the memfd, even after every
+ * table stops using them. A child process inherits the same memfd across a
+ * fork, so reusing an offset could change a page that the child still has
+ * mapped.
+ *
+ * For the memory footprint counts, a table's private pages are counted as
+ * part of the table. A pool page is counted once, for as long as any table
+ * has it mapped, even though the memfd holds onto it until it's closed.
+ *
+ * All of these functions must be called while holding the dispatch lock.
+ */
+
+#define _GNU_SOURCE 1
+
+#include "GLdispatchPrivate.h"
+
+#include <assert.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#if defined(HAVE_MEMFD_CREATE)
+#include <sys/mman.h>
+#endif
+
+#include "trace.h"
+#include "glvnd_memstats.h"
+#include "glvnd_hash.h"
+
+#if defined(HAVE_MEMFD_CREATE) && defined(MREMAP_FIXED)
+
+/*!
+ * A page in the shared pool.
+ */
+typedef struct __GLdispatchSharedPageRec {
+    /// The offset of the page in the memfd.
+    off_t offset;
+
+    /// The number of dispatch tables with this page mapped.
+    int refcount;
+} __GLdispatchSharedPage;
+
+/*!
+ * The page-sharing state for a dispatch table.
+ */
+struct __GLdispatchTablePagesRec {
+    /// The shared pool page that each page is mapped to, or NULL if the page
+    /// is private.
+    __GLdispatchSharedPage **shared;
+
+    /// A hash of the contents of each page, and whether it's all zero.
+    uint32_t *hashes;
+    GLboolean *isZero;
+
+    /// The dispatch table that this belongs to.
+    __GLdispatchTable *dispatch;
+
+    struct glvnd_list entry;
+};
+
+static GLboolean sharingEnabled = GL_FALSE;
+static size_t pageSize;
+static size_t tableSize;
+static int numTablePages;
+
+/// The list of every dispatch table that we can share pages between.
+static struct glvnd_list sharedTableList;
+
+static int poolFd = -1;
+static off_t poolSize;
+static pid_t poolPid;
+
+void __glDispatchSharedTablesInit(void)
+{
+    const char *env = glvndGetEnv("__GLVND_SHARE_DISPATCH_TABLES");
+    long size;
+
+    glvnd_list_init(&sharedTableList);
+    sharingEnabled = GL_FALSE;
+
+    // An unshared table still needs the size.
+    tableSize = _glapi_get_dispatch_table_size() * sizeof(void *);
+
+    if (env == NULL || atoi(env) == 0) {
+        return;
+    }
+
+    size = sysconf(_SC_PAGESIZE);
+    if (size <= 0) {
+        return;
+    }
+
+    pageSize = (size_t) size;
+    numTablePages = (tableSize + pageSize - 1) / pageSize;
+    sharingEnabled = GL_TRUE;
+}
+
+void __glDispatchSharedTablesFini(void)
+{
+    // Any pool pages that are still mapped stay valid after we close the
+    // file descriptor.
+    if (poolFd >= 0) {
+        close(poolFd);
+        poolFd = -1;
+    }
+    poolSize = 0;
+}
+
+static size_t GetTablePagesSize(void)
+{
+    return sizeof(__GLdispatchTablePages)
+        + numTablePages * (sizeof(__GLdispatchSharedPage *)
+                + sizeof(uint32_t) + sizeof(GLboolean));
+}
+
+struct _glapi_table *__glDispatchAllocTableMemory(__GLdispatchTable *dispatch)
+{
+    __GLdispatchTablePages *pages;
+    void *table;
+
+    if (!sharingEnabled || dispatch->lazy) {
+        // A lazy table gets written to every time a function gets resolved,
+        // so there's no point in trying to share it.
+        table = calloc(1, tableSize);
+        if (table != NULL) {
+            glvndMemStatsAlloc(GLVND_MEM_DISPATCH_TABLE, tableSize);
+        }
+        return (struct _glapi_table *) table;
+    }
+
+    pages = calloc(1, GetTablePagesSize());
+    if (pages == NULL) {
+        return NULL;
+    }
+    pages->shared = (__GLdispatchSharedPage **) (pages + 1);
+    pages->hashes = (uint32_t *) (pages->shared + numTablePages);
+    pages->isZero = (GLboolean *) (pages->hashes + numTablePages);
+
+    table = mmap(NULL, numTablePages * pageSize, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (table == MAP_FAILED) {
+        free(pages);
+        return NULL;
+    }
+
+    pages->dispatch = dispatch;
+    glvnd_list_add(&pages->entry, &sharedTableList);
+    dispatch->pages = pages;
+    glvndMemStatsAlloc(GLVND_MEM_DISPATCH_TABLE,
+            GetTablePagesSize() + numTablePages * pageSize);
+    return (struct _glapi_table *) table;
+}
+
+static void ReleaseSharedPage(__GLdispatchSharedPage *page)
+{
+    page->refcount--;
+    if (page->refcount == 0) {
+        free(page);
+        glvndMemStatsFree(GLVND_MEM_DISPATCH_TABLE,
+                sizeof(__GLdispatchSharedPage) + pageSize);
+    }
+}
+
+void __glDispatchFreeTableMemory(__GLdispatchTable *dispatch)
+{
+    __GLdispatchTablePages *pages = dispatch->pages;
+    int privateCount = numTablePages;
+    int i;
+
+    if (pages == NULL) {
+        if (dispatch->table != NULL) {
+            free(dispatch->table);
+            glvndMemStatsFree(GLVND_MEM_DISPATCH_TABLE, tableSize);
+        }
+        return;
+    }
+
+    for (i=0; i<numTablePages; i++) {
+        if (pages->shared[i] != NULL) {
+            ReleaseSharedPage(pages->shared[i]);
+            privateCount--;
+        }
+    }
+    munmap(dispatch->table, numTablePages * pageSize);
+    glvndMemStatsFree(GLVND_MEM_DISPATCH_TABLE,
+            GetTablePagesSize() + privateCount * pageSize);
+    glvnd_list_del(&pages->entry);
+    free(pages);
+    dispatch->pages = NULL;
+}
+
+static inline char *GetPageAddress(__GLdispatchTable *dispatch, int index)
+{
+    return ((char *) dispatch->table) + (index * pageSize);
+}
+
+/**
+ * Replaces a shared page with a private, writable copy.
+ */
+static GLboolean UnsharePage(__GLdispatchTable *dispatch, int index)
+{
+    __GLdispatchTablePages *pages = dispatch->pages;
+    char *addr = GetPageAddress(dispatch, index);
+    void *copy;
+
+    copy = mmap(NULL, pageSize, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (copy == MAP_FAILED) {
+        return GL_FALSE;
+    }
+    memcpy(copy, addr, pageSize);
+
+    if (mremap(copy, pageSize, pageSize, MREMAP_MAYMOVE | MREMAP_FIXED, addr) == MAP_FAILED) {
+        munmap(copy, pageSize);
+        return GL_FALSE;
+    }
+
+    ReleaseSharedPage(pages->shared[index]);
+    pages->shared[index] = NULL;
+    glvndMemStatsResize(GLVND_MEM_DISPATCH_TABLE, pageSize);
+    return GL_TRUE;
+}
+
+GLboolean __glDispatchTableMakeWritable(__GLdispatchTable *dispatch,
+        int first, int count)
+{
+    __GLdispatchTablePages *pages = dispatch->pages;
+    int firstPage, lastPage;
+    int i;
+
+    if (pages == NULL || first >= count) {
+        return GL_TRUE;
+    }
+
+    firstPage = (first * sizeof(void *)) / pageSize;
+    lastPage = ((count * sizeof(void *)) - 1) / pageSize;
+    for (i=firstPage; i<=lastPage; i++) {
+        if (pages->shared[i] != NULL) {
+            if (!UnsharePage(dispatch, i)) {
+                return GL_FALSE;
+            }
+        }
+    }
+    return GL_TRUE;
+}
+
+static void HashPage(const char *addr, uint32_t *retHash, GLboolean *retZero)
+{
+    const uint32_t *words = (const uint32_t *) addr;
+    uint32_t any = 0;
+    size_t i;
+
+    for (i=0; i<pageSize / sizeof(uint32_t); i++) {
+        any |= words[i];
+    }
+    *retZero = (any == 0);
+    *retHash = glvndHashFNV1a(addr, pageSize);
+}
+
+/**
+ * Allocates a new page in the pool and copies data into it.
+ */
+static __GLdispatchSharedPage *CreateSharedPage(const char *data)
+{
+    __GLdispatchSharedPage *page;
+    void *addr;
+
+    if (poolFd >= 0 && poolPid != getpid()) {
+        // We're in a child process, and the memfd is still shared with our
+        // parent. Leave the existing mappings alone, but start a new pool so
+        // that we don't both try to allocate the same offset.
+        close(poolFd);
+        poolFd = -1;
+    }
+    if (poolFd < 0) {
+        poolFd = memfd_create("glvnd-dispatch", MFD_CLOEXEC);
+        if (poolFd < 0) {
+            DBG_PRINTF(0, "memfd_create failed, disabling dispatch table sharing\n");
+            sharingEnabled = GL_FALSE;
+            return NULL;
+        }
+        poolSize = 0;
+        poolPid = getpid();
+    }
+
+    page = malloc(sizeof(__GLdispatchSharedPage));
+    if (page == NULL) {
+        return NULL;
+    }
+    if (ftruncate(poolFd, poolSize + pageSize) != 0) {
+        free(page);
+        return NULL;
+    }
+    page->offset = poolSize;
+    page->refcount = 0;
+    poolSize += pageSize;
+
+    addr = mmap(NULL, pageSize, PROT_READ | PROT_WRITE, MAP_SHARED,
+            poolFd, page->offset);
+    if (addr == MAP_FAILED) {
+        // The offset is still reserved, but we just won't use it.
+        free(page);
+        return NULL;
+    }
+    memcpy(addr, data, pageSize);
+    munmap(addr, pageSize);
+    glvndMemStatsAlloc(GLVND_MEM_DISPATCH_TABLE,
+            sizeof(__GLdispatchSharedPage) + pageSize);
+    return page;
+}
+
+/**
+ * Maps a shared pool page on top of a page in a dispatch table.
+ *
+ * The pool page is mapped somewhere else first, and then moved on top of the
+ * table's page with mremap(2), so that the table is never left with a hole in
+ * it, even if something fails.
+ */
+static GLboolean MapSharedPage(__GLdispatchTable *dispatch, int index,
+        __GLdispatchSharedPage *page)
+{
+    void *addr = GetPageAddress(dispatch, index);
+    void *mapping;
+
+    assert(dispatch->pages->shared[index] == NULL);
+
+    mapping = mmap(NULL, pageSize, PROT_READ, MAP_SHARED, poolFd, page->offset);
+    if (mapping == MAP_FAILED) {
+        return GL_FALSE;
+    }
+    if (mremap(mapping, pageSize, pageSize, MREMAP_MAYMOVE | MREMAP_FIXED, addr) == MAP_FAILED) {
+        munmap(mapping, pageSize);
+        return GL_FALSE;
+    }
+
+    dispatch->pages->shared[index] = page;
+    page->refcount++;
+    glvndMemStatsResize(GLVND_MEM_DISPATCH_TABLE, -(long) pageSize);
+    return GL_TRUE;
+}
+
+void __glDispatchShareTablePages(__GLdispatchTable *dispatch)
+{
+    __GLdispatchTablePages *pages = dispatch->pages;
+    int i;
+
+    if (pages == NULL || !sharingEnabled) {
+        return;
+    }
+
+    for (i=0; i<numTablePages && sharingEnabled; i++) {
+        const char *addr = GetPageAddress(dispatch, i);
+        __GLdispatchTablePages *other;
+
+        if (pages->shared[i] != NULL) {
+            // This page hasn't been modified since we last shared it.
+            continue;
+        }
+
+        HashPage(addr, &pages->hashes[i], &pages->isZero[i]);
+        if (pages->isZero[i]) {
+            // Nothing has touched this page, so it doesn't take up any
+            // memory to begin with.
+            continue;
+        }
+
+        glvnd_list_for_each_entry(other, &sharedTableList, entry) {
+            char *otherAddr;
+
+            if (other == pages || other->isZero[i]
+                    || other->hashes[i] != pages->hashes[i]) {
+                continue;
+            }
+            otherAddr = GetPageAddress(other->dispatch, i);
+            if (memcmp(addr, otherAddr, pageSize) != 0) {
+                continue;
+            }
+
+            if (other->shared[i] != NULL) {
+                MapSharedPage(dispatch, i, other->shared[i]);
+            } else {
+                __GLdispatchSharedPage *page = CreateSharedPage(addr);
+                if (page != NULL) {
+                    if (MapSharedPage(other->dispatch, i, page)) {
+                        MapSharedPage(dispatch, i, page);
+                    }
+                    if (page->refcount == 0) {
+                        free(page);
+                        glvndMemStatsFree(GLVND_MEM_DISPATCH_TABLE,
+                                sizeof(__GLdispatchSharedPage) + pageSize);
+                    }
+                }
+            }
+            break;
+        }
+    }
+}
+
+#else // defined(HAVE_MEMFD_CREATE) && defined(MREMAP_FIXED)
+
+void __glDispatchSharedTablesInit(void)
+{
+}
+
+void __glDispatchSharedTablesFini(void)
+{
+}
+
+struct _glapi_table *__glDispatchAllocTableMemory(__GLdispatchTable *dispatch)
+{
+    size_t size = _glapi_get_dispatch_table_size() * sizeof(void *);
+    void *table = calloc(1, size);
+
+    if (table != NULL) {
+        glvndMemStatsAlloc(GLVND_MEM_DISPATCH_TABLE, size);
+    }
+    return (struct _glapi_table *) table;
+}
+
+void __glDispatchFreeTableMemory(__GLdispatchTable *dispatch)
+{
+    if (dispatch->table != NULL) {
+        free(dispatch->table);
+        glvndMemStatsFree(GLVND_MEM_DISPATCH_TABLE,
+                _glapi_get_dispatch_table_size() * sizeof(void *));
+    }
+}
+
+GLboolean __glDispatchTableMakeWritable(__GLdispatchTable *dispatch,
+        int first, int count)
+{
+    return GL_TRUE;
+}
+
+void __glDispatchShareTablePages(__GLdispatchTable *dispatch)
+{
+}
+
+#endif // defined(HAVE_MEMFD_CREATE) && defined(MREMAP_FIXED)
@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+/**
+ * \file
+ *
+ * Statistics in shared memory, for monitoring tools.
+ *
+ * Setting __GLVND_SHM_STATS enables it. libGLdispatch then creates a file
+ * named glvnd-<pid>, and keeps a __GLdispatchShmStats structure in it. If the
+ * variable is set to 1, the file goes in /dev/shm. Otherwise, the variable is
+ * the directory to put it in.
+ *
+ * That way, an agent can scrape the counters from every GL process on a
+ * host, without attaching to them or needing the application to call
+ * __glDispatchGetStatistics. bin/shm-stats.py prints them.
+ *
+ * Every counter is updated with relaxed atomics, so a reader can see them
+ * change in any order, but never sees a torn value.
+ *
+ * The file is removed when libGLdispatch is torn down. If the process
+ * crashes, then the file gets left behind, so a reader should check whether
+ * the process in the pid field still exists. After a fork, the child gets a
+ * file of its own.
+ */
+
+#define _GNU_SOURCE 1
+
+#include "GLdispatchPrivate.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+
+#include "glvnd_atomic.h"
+
+#define SHM_STATS_DEFAULT_DIR "/dev/shm"
+
+__GLdispatchShmStats * volatile __glDispatchShmStats = NULL;
+
+/*!
+ * The directory for the files, or NULL if the statistics aren't enabled.
+ */
+static char *shmStatsDir = NULL;
+
+/*!
+ * The path of this process's file, so that it can be removed.
+ */
+static char *shmStatsPath = NULL;
+
+static void UnmapShmStats(void)
+{
+    __GLdispatchShmStats *stats = __glDispatchShmStats;
+
+    if (stats != NULL) {
+        __glDispatchShmStats = NULL;
+        munmap(stats, sizeof(*stats));
+    }
+}
+
+/*!
+ * The child inherits the parent's mapping, so stop using it right away.
+ * __glDispatchShmStatsReset creates the child's own file later.
+ */
+static void ShmStatsForkChild(void)
+{
+    UnmapShmStats();
+    free(shmStatsPath);
+    shmStatsPath = NULL;
+}
+
+static void CreateShmStats(void)
+{
+    __GLdispatchShmStats *stats;
+    char *path;
+    int fd;
+
+    if (glvnd_asprintf(&path, "%s/glvnd-%ld", shmStatsDir, (long) getpid()) < 0) {
+        return;
+    }
+
+    fd = open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        free(path);
+        return;
+    }
+    if (ftruncate(fd, sizeof(__GLdispatchShmStats)) != 0) {
+        close(fd);
+        unlink(path);
+        free(path);
+        return;
+    }
+    stats = mmap(NULL, sizeof(__GLdispatchShmStats), PROT_READ | PROT_WRITE,
+            MAP_SHARED, fd, 0);
+    close(fd);
+    if (stats == MAP_FAILED) {
+        unlink(path);
+        free(path);
+        return;
+    }
+
+    stats->version = GLDISPATCH_SHM_STATS_VERSION;
+    stats->size = sizeof(__GLdispatchShmStats);
+    stats->pid = (uint64_t) getpid();
+    glvndAtomicFence();
+    memcpy(stats->magic, GLDISPATCH_SHM_STATS_MAGIC, sizeof(stats->magic));
+
+    shmStatsPath = path;
+    glvndAtomicStoreReleasePtr((void * volatile *) &__glDispatchShmStats, stats);
+}
+
+void __glDispatchShmStatsInit(void)
+{
+#if defined(GLDISPATCH_SHM_STATS_SUPPORTED)
+    const char *env = glvndGetEnv("__GLVND_SHM_STATS");
+
+    if (env == NULL || env[0] == '\0' || strcmp(env, "0") == 0) {
+        return;
+    }
+
+    shmStatsDir = strdup(strcmp(env, "1") == 0 ? SHM_STATS_DEFAULT_DIR : env);
+    if (shmStatsDir == NULL) {
+        return;
+    }
+
+    pthread_atfork(NULL, NULL, ShmStatsForkChild);
+    CreateShmStats();
+#endif
+}
+
+static uint64_t GetTimeNS(void)
+{
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0) {
+        return 0;
+    }
+    return ((uint64_t) ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+uint64_t __glDispatchShmStatsTimeBegin(void)
+{
+    if (__glDispatchShmStats == NULL) {
+        return 0;
+    }
+    return GetTimeNS();
+}
+
+uint64_t __glDispatchShmStatsTimeSince(uint64_t start)
+{
+    if (start == 0) {
+        return 0;
+    }
+    return GetTimeNS() - start;
+}
+
+void __glDispatchShmStatsReset(void)
+{
+    if (shmStatsDir != NULL && __glDispatchShmStats == NULL) {
+        CreateShmStats();
+    }
+}
+
+void __glDispatchShmStatsFini(void)
+{
+    UnmapShmStats();
+    if (shmStatsPath != NULL) {
+        unlink(shmStatsPath);
+        free(shmStatsPath);
+        shmStatsPath = NULL;
+    }
+    free(shmStatsDir);
+    shmStatsDir = NULL;
+}
@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+/**
+ * \file
+ *
+ * A watchdog for slow operations.
+ *
+ * Setting __GLVND_SLOW_OP_US to a number of microseconds enables it. Loading
+ * a vendor library, filling in a dispatch table, patching the entrypoints,
+ * and switching vendors in MakeCurrent are each timed, and any that takes at
+ * least that long prints one line to stderr with the name of the operation,
+ * the vendor, and how long it took. That's meant to be left on in production,
+ * so that a startup or frame-time regression shows up in the logs.
+ *
+ * libGLX and libEGL time their own operations with
+ * \c __glDispatchSlowOpBegin and \c __glDispatchSlowOpEnd.
+ */
+
+#define _GNU_SOURCE 1
+
+#include "GLdispatchPrivate.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <dlfcn.h>
+
+#if defined(HAVE_DL_ITERATE_PHDR)
+#include <link.h>
+#endif
+
+static int slowOpsEnabled = 0;
+static uint64_t slowOpThresholdNS = 0;
+
+void __glDispatchSlowOpsInit(void)
+{
+    const char *env;
+    char *end;
+    unsigned long long us;
+
+    env = glvndGetEnv("__GLVND_SLOW_OP_US");
+    if (env == NULL || env[0] == '\0') {
+        return;
+    }
+
+    us = strtoull(env, &end, 10);
+    if (*end != '\0') {
+        return;
+    }
+    slowOpThresholdNS = ((uint64_t) us) * 1000;
+    slowOpsEnabled = 1;
+}
+
+static uint64_t GetTimeNS(void)
+{
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0) {
+        return 0;
+    }
+    return ((uint64_t) ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+PUBLIC uint64_t __glDispatchSlowOpBegin(void)
+{
+    if (!slowOpsEnabled) {
+        return 0;
+    }
+    return GetTimeNS();
+}
+
+/*!
+ * Returns the time since \p start in microseconds, or zero if the operation
+ * shouldn't be reported.
+ */
+static unsigned long long GetSlowOpTimeUS(uint64_t start)
+{
+    uint64_t elapsed;
+
+    if (!slowOpsEnabled || start == 0) {
+        return 0;
+    }
+
+    elapsed = GetTimeNS() - start;
+    if (elapsed < slowOpThresholdNS) {
+        return 0;
+    }
+    // Round up, so that a slow operation is never reported as taking zero.
+    return (unsigned long long) ((elapsed + 999) / 1000);
+}
+
+static void ReportSlowOp(const char *op, const char *vendorName, int vendorID,
+        unsigned long long us)
+{
+    // Print each report with a single call, so that reports from different
+    // threads don't get mixed together.
+    if (vendorName != NULL) {
+        fprintf(stderr, "libglvnd: slow operation: %s for vendor \"%s\" took %llu us\n",
+                op, vendorName, us);
+    } else if (vendorID != 0) {
+        fprintf(stderr, "libglvnd: slow operation: %s for vendor ID %d took %llu us\n",
+                op, vendorID, us);
+    } else {
+        fprintf(stderr, "libglvnd: slow operation: %s took %llu us\n", op, us);
+    }
+}
+
+PUBLIC void __glDispatchSlowOpEnd(uint64_t start, const char *op,
+        const char *vendorName, int vendorID)
+{
+    unsigned long long us = GetSlowOpTimeUS(start);
+
+    if (us != 0) {
+        ReportSlowOp(op, vendorName, vendorID, us);
+    }
+}
+
+void __glDispatchSlowOpEndTable(uint64_t start, const char *op,
+        __GLdispatchTable *dispatch)
+{
+    unsigned long long us = GetSlowOpTimeUS(start);
+    const char *vendorName = NULL;
+
+    if (us == 0) {
+        return;
+    }
+
+    // A table doesn't know its vendor's name, and it might not have a vendor
+    // ID yet either, so use the path of the vendor library if we can.
+#if defined(HAVE_DL_ITERATE_PHDR)
+    if (dispatch->vendorHandle != NULL) {
+        struct link_map *lm = NULL;
+        if (dlinfo(dispatch->vendorHandle, RTLD_DI_LINKMAP, &lm) == 0
+                && lm != NULL && lm->l_name != NULL && lm->l_name[0] != '\0') {
+            vendorName = lm->l_name;
+        }
+    }
+#endif
+    ReportSlowOp(op, vendorName, dispatch->vendorID, us);
+}
@@ -0,0 +1,330 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+/**
+ * \file
+ *
+ * Names the stubs that are generated at runtime, for profilers and debuggers.
+ *
+ * The dynamic stubs in libGLdispatch and the entrypoints that libGLX
+ * generates for GLX extension functions don't have a symbol of their own, so
+ * perf and gdb show them as a raw address or as an offset from whatever
+ * symbol comes before them.
+ *
+ * Setting __GLVND_PERF_MAP to a non-zero value enables this. Each stub is
+ * named as soon as it's assigned to a function, in two ways:
+ *
+ * - A "<start> <size> <name>" line is appended to /tmp/perf-<pid>.map, which
+ *   perf reads for any code that isn't backed by a file. That covers the
+ *   overflow stubs and libGLX's runtime blocks, which live in anonymous
+ *   mappings.
+ *
+ * - The stub is registered through gdb's JIT interface, as a tiny in-memory
+ *   ELF object with one function symbol. gdb uses that for any address,
+ *   including the dynamic stubs in libGLdispatch's own text. gdb finds
+ *   __jit_debug_descriptor through libGLdispatch's symbol table, so this
+ *   needs a libGLdispatch that isn't stripped, or its debug info. The
+ *   symbols aren't exported so that they don't interpose on another
+ *   library's JIT interface, like LLVM's.
+ */
+
+#define _GNU_SOURCE 1
+
+#include "GLdispatchPrivate.h"
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <dlfcn.h>
+
+#if defined(__ELF__) && defined(HAVE_DL_ITERATE_PHDR)
+#include <elf.h>
+#include <link.h>
+#define USE_GDB_JIT 1
+#endif
+
+#include "glvnd_pthread.h"
+
+static int symbolMapEnabled = 0;
+static glvnd_mutex_t symbolMapMutex = GLVND_MUTEX_INITIALIZER;
+
+#if defined(USE_GDB_JIT)
+/*
+ * These are the names and layouts that gdb looks for. See "JIT Compilation
+ * Interface" in the gdb manual.
+ */
+typedef enum {
+    JIT_NOACTION = 0,
+    JIT_REGISTER_FN,
+    JIT_UNREGISTER_FN
+} jit_actions_t;
+
+struct jit_code_entry {
+    struct jit_code_entry *next_entry;
+    struct jit_code_entry *prev_entry;
+    const char *symfile_addr;
+    uint64_t symfile_size;
+};
+
+struct jit_descriptor {
+    uint32_t version;
+    uint32_t action_flag;
+    struct jit_code_entry *relevant_entry;
+    struct jit_code_entry *first_entry;
+};
+
+void __attribute__((noinline, used)) __jit_debug_register_code(void);
+void __attribute__((noinline, used)) __jit_debug_register_code(void)
+{
+    // gdb sets a breakpoint here, so this has to stay a real function.
+    __asm__ __volatile__("");
+}
+
+struct jit_descriptor __jit_debug_descriptor __attribute__((used)) = {
+    1, JIT_NOACTION, NULL, NULL
+};
+
+enum {
+    SYMFILE_SECTION_NULL,
+    SYMFILE_SECTION_TEXT,
+    SYMFILE_SECTION_SYMTAB,
+    SYMFILE_SECTION_STRTAB,
+    SYMFILE_SECTION_SHSTRTAB,
+    SYMFILE_SECTION_COUNT
+};
+
+static const char SYMFILE_SHSTRTAB[] = "\0.text\0.symtab\0.strtab\0.shstrtab";
+
+/**
+ * The in-memory object file for one stub. The function name follows it.
+ */
+typedef struct {
+    ElfW(Ehdr) ehdr;
+    ElfW(Shdr) shdr[SYMFILE_SECTION_COUNT];
+    ElfW(Sym) sym[2];
+    char shstrtab[sizeof(SYMFILE_SHSTRTAB)];
+    char strtab[];
+} StubSymfile;
+
+typedef struct {
+    struct jit_code_entry entry;
+    StubSymfile symfile;
+} StubJitEntry;
+
+/// Our own ELF header, which the object files copy their machine type from.
+static const ElfW(Ehdr) *selfEhdr = NULL;
+
+static void InitSelfEhdr(void)
+{
+    Dl_info info;
+
+    if (dladdr((void *) __glDispatchSymbolMapInit, &info) != 0
+            && info.dli_fbase != NULL
+            && memcmp(info.dli_fbase, ELFMAG, SELFMAG) == 0) {
+        selfEhdr = (const ElfW(Ehdr) *) info.dli_fbase;
+    }
+}
+
+static void SetSection(ElfW(Shdr) *shdr, ElfW(Word) name, ElfW(Word) type,
+        ElfW(Addr) addr, size_t offset, size_t size)
+{
+    shdr->sh_name = name;
+    shdr->sh_type = type;
+    shdr->sh_addr = addr;
+    shdr->sh_offset = offset;
+    shdr->sh_size = size;
+    shdr->sh_addralign = 1;
+}
+
+/**
+ * Registers a stub with gdb. This is called with symbolMapMutex held.
+ */
+static void AddGdbJitEntry(const void *addr, int size, const char *name)
+{
+    size_t nameLen = strlen(name);
+    size_t total = sizeof(StubJitEntry) + nameLen + 2;
+    StubJitEntry *jit;
+    StubSymfile *sf;
+
+    if (selfEhdr == NULL) {
+        return;
+    }
+    jit = calloc(1, total);
+    if (jit == NULL) {
+        return;
+    }
+    sf = &jit->symfile;
+
+    // A relocatable object with a .text section that's already at the stub's
+    // address, the same way that LuaJIT describes its traces.
+    memcpy(sf->ehdr.e_ident, selfEhdr->e_ident, EI_NIDENT);
+    sf->ehdr.e_type = ET_REL;
+    sf->ehdr.e_machine = selfEhdr->e_machine;
+    sf->ehdr.e_version = EV_CURRENT;
+    sf->ehdr.e_flags = selfEhdr->e_flags;
+    sf->ehdr.e_ehsize = sizeof(ElfW(Ehdr));
+    sf->ehdr.e_shoff = offsetof(StubSymfile, shdr);
+    sf->ehdr.e_shentsize = sizeof(ElfW(Shdr));
+    sf->ehdr.e_shnum = SYMFILE_SECTION_COUNT;
+    sf->ehdr.e_shstrndx = SYMFILE_SECTION_SHSTRTAB;
+
+    SetSection(&sf->shdr[SYMFILE_SECTION_TEXT], 1, SHT_NOBITS,
+            (ElfW(Addr)) (uintptr_t) addr, 0, size);
+    sf->shdr[SYMFILE_SECTION_TEXT].sh_flags = SHF_ALLOC | SHF_EXECINSTR;
+
+    SetSection(&sf->shdr[SYMFILE_SECTION_SYMTAB], 7, SHT_SYMTAB, 0,
+            offsetof(StubSymfile, sym), sizeof(sf->sym));
+    sf->shdr[SYMFILE_SECTION_SYMTAB].sh_link = SYMFILE_SECTION_STRTAB;
+    sf->shdr[SYMFILE_SECTION_SYMTAB].sh_info = 1;
+    sf->shdr[SYMFILE_SECTION_SYMTAB].sh_entsize = sizeof(ElfW(Sym));
+
+    SetSection(&sf->shdr[SYMFILE_SECTION_STRTAB], 15, SHT_STRTAB, 0,
+            offsetof(StubSymfile, strtab), nameLen + 2);
+    SetSection(&sf->shdr[SYMFILE_SECTION_SHSTRTAB], 23, SHT_STRTAB, 0,
+            offsetof(StubSymfile, shstrtab), sizeof(SYMFILE_SHSTRTAB));
+
+    sf->sym[1].st_name = 1;
+    // ELF32_ST_INFO and ELF64_ST_INFO are the same.
+    sf->sym[1].st_info = ELF64_ST_INFO(STB_GLOBAL, STT_FUNC);
+    sf->sym[1].st_shndx = SYMFILE_SECTION_TEXT;
+    sf->sym[1].st_value = 0;
+    sf->sym[1].st_size = size;
+
+    memcpy(sf->shstrtab, SYMFILE_SHSTRTAB, sizeof(SYMFILE_SHSTRTAB));
+    memcpy(sf->strtab + 1, name, nameLen);
+
+    jit->entry.symfile_addr = (const char *) sf;
+    jit->entry.symfile_size = total - offsetof(StubJitEntry, symfile);
+    jit->entry.next_entry = __jit_debug_descriptor.first_entry;
+    if (jit->entry.next_entry != NULL) {
+        jit->entry.next_entry->prev_entry = &jit->entry;
+    }
+    __jit_debug_descriptor.first_entry = &jit->entry;
+    __jit_debug_descriptor.relevant_entry = &jit->entry;
+    __jit_debug_descriptor.action_flag = JIT_REGISTER_FN;
+    __jit_debug_register_code();
+}
+
+static void RemoveGdbJitEntries(void)
+{
+    while (__jit_debug_descriptor.first_entry != NULL) {
+        struct jit_code_entry *entry = __jit_debug_descriptor.first_entry;
+
+        __jit_debug_descriptor.first_entry = entry->next_entry;
+        if (entry->next_entry != NULL) {
+            entry->next_entry->prev_entry = NULL;
+        }
+        __jit_debug_descriptor.relevant_entry = entry;
+        __jit_debug_descriptor.action_flag = JIT_UNREGISTER_FN;
+        __jit_debug_register_code();
+        free(entry);
+    }
+    __jit_debug_descriptor.relevant_entry = NULL;
+    __jit_debug_descriptor.action_flag = JIT_NOACTION;
+}
+#endif // defined(USE_GDB_JIT)
+
+void __glDispatchSymbolMapInit(void)
+{
+    const char *env = glvndGetEnv("__GLVND_PERF_MAP");
+
+    if (env == NULL || atoi(env) == 0) {
+        return;
+    }
+    symbolMapEnabled = 1;
+#if defined(USE_GDB_JIT)
+    InitSelfEhdr();
+#endif
+}
+
+/**
+ * Appends a line to perf's map file. This is called with symbolMapMutex held.
+ *
+ * The file is opened each time, so that a forked child writes to its own
+ * file. Stubs are only generated a few times in a process's lifetime, so
+ * that doesn't cost anything that matters.
+ */
+static void AddPerfMapEntry(const void *addr, int size, const char *name)
+{
+    char path[64];
+    FILE *fp;
+
+    snprintf(path, sizeof(path), "/tmp/perf-%ld.map", (long) getpid());
+    fp = fopen(path, "a");
+    if (fp == NULL) {
+        return;
+    }
+    fprintf(fp, "%lx %x %s\n", (unsigned long) (uintptr_t) addr, size, name);
+    fclose(fp);
+}
+
+PUBLIC void __glDispatchRegisterStubSymbol(const void *addr, int size,
+        const char *name)
+{
+    if (!symbolMapEnabled || addr == NULL || size <= 0 || name == NULL) {
+        return;
+    }
+
+    __glvndPthreadFuncs.mutex_lock(&symbolMapMutex);
+    AddPerfMapEntry(addr, size, name);
+#if defined(USE_GDB_JIT)
+    AddGdbJitEntry(addr, size, name);
+#endif
+    __glvndPthreadFuncs.mutex_unlock(&symbolMapMutex);
+}
+
+void __glDispatchSymbolMapAddStubs(int first, int last)
+{
+    int i;
+
+    if (!symbolMapEnabled) {
+        return;
+    }
+
+    for (i=first; i<last; i++) {
+        int size;
+        _glapi_proc addr = _glapi_get_stub_code(i, &size);
+
+        __glDispatchRegisterStubSymbol((const void *) addr, size,
+                _glapi_get_proc_name(i));
+    }
+}
+
+void __glDispatchSymbolMapFini(void)
+{
+#if defined(USE_GDB_JIT)
+    if (symbolMapEnabled) {
+        __glvndPthreadFuncs.mutex_lock(&symbolMapMutex);
+        RemoveGdbJitEntries();
+        __glvndPthreadFuncs.mutex_unlock(&symbolMapMutex);
+    }
+#endif
+}
@@ -0,0 +1,577 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+/**
+ * \file
+ *
+ * Binary event tracing.
+ *
+ * Each thread writes fixed-size records into its own ring buffer, so
+ * recording an event doesn't take a lock or call into libc, other than to
+ * allocate the buffer the first time. Once a buffer wraps around, the oldest
+ * records are overwritten.
+ *
+ * Tracing is enabled by setting __GLVND_TRACE_FILE to a path. The buffers are
+ * written to that path, with ".<pid>" appended, when the last client library
+ * calls __glDispatchFini.
+ *
+ * If __GLVND_TRACE_SIGNAL is also set to a signal number, then tracing starts
+ * out stopped, and that signal toggles it. Starting it discards any older
+ * records, and stopping it writes out the file.
+ *
+ * __GLVND_TRACE_RECORDS sets how many records each thread's buffer holds. It's
+ * rounded up to a power of two.
+ *
+ * Setting __GLVND_TRACE_FLIGHT_RECORDER to a non-zero value makes tracing
+ * cheap enough to leave on: each buffer only keeps the last 64 records unless
+ * __GLVND_TRACE_RECORDS says otherwise, and the file isn't written at exit.
+ * Instead, it's written if the process gets a fatal signal, before passing
+ * the signal on to whatever handler was there before. It can also be written
+ * at any point by calling __glDispatchDumpTrace, from a debugger or from the
+ * application's own crash handler.
+ *
+ * The file starts with a TraceFileHeader, followed by each buffer: a
+ * TraceThreadHeader and then its records, oldest first. Everything is in the
+ * machine's native byte order. bin/trace-decode.py prints a file as text.
+ *
+ * A buffer is written out while its thread might still be recording, so a
+ * record that's being written at that moment can come out torn. Buffers are
+ * never freed, because there's no way to tell when a thread is done with
+ * one.
+ */
+
+#include "GLdispatchPrivate.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <time.h>
+#include <unistd.h>
+#include <errno.h>
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+
+#include "glvnd_pthread.h"
+#include "glvnd_atomic.h"
+#include "glvnd_hash.h"
+
+#define TRACE_FILE_MAGIC "GLVNDTRC"
+#define TRACE_FILE_VERSION 1
+
+/*!
+ * The default number of records in each thread's buffer, and the range that
+ * __GLVND_TRACE_RECORDS can pick from. These must be powers of two.
+ */
+#define TRACE_RING_SIZE_DEFAULT 4096
+#define TRACE_RING_SIZE_FLIGHT_RECORDER 64
+#define TRACE_RING_SIZE_MIN 16
+#define TRACE_RING_SIZE_MAX 65536
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize;
+
+    /*
+     * Two pairs of (timestamp, CLOCK_MONOTONIC nanoseconds), taken when
+     * tracing started and when the file was written. The decoder uses these
+     * to convert the records' timestamps to nanoseconds.
+     */
+    uint64_t startTicks;
+    uint64_t startNS;
+    uint64_t endTicks;
+    uint64_t endNS;
+} TraceFileHeader;
+
+typedef struct {
+    uint64_t threadID;
+    uint32_t recordCount;
+    uint32_t reserved;
+} TraceThreadHeader;
+
+typedef struct {
+    uint64_t timestamp;
+    uint32_t event;
+    uint32_t reserved;
+    uint64_t arg0;
+    uint64_t arg1;
+} TraceRecord;
+
+typedef struct TraceRingRec {
+    struct TraceRingRec *next;
+    uint64_t threadID;
+
+    /// The index of the next record to write.
+    int volatile head;
+    /// Non-zero if the buffer has wrapped around at least once.
+    int volatile wrapped;
+
+    TraceRecord records[];
+} TraceRing;
+
+static int volatile traceEnabled = 0;
+static int traceConfigured = 0;
+static int traceRingSize = TRACE_RING_SIZE_DEFAULT;
+static char tracePath[PATH_MAX];
+static int traceSignal = 0;
+static struct sigaction oldSignalAction;
+
+/*!
+ * The signals that make a flight recorder write out the trace file.
+ */
+static const int FATAL_SIGNALS[] = { SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT };
+#define FATAL_SIGNAL_COUNT (sizeof(FATAL_SIGNALS) / sizeof(FATAL_SIGNALS[0]))
+
+static int traceFlightRecorder = 0;
+static int fatalHandlersInstalled = 0;
+static int volatile fatalSignalHandled = 0;
+static struct sigaction oldFatalActions[FATAL_SIGNAL_COUNT];
+
+static uint64_t traceStartTicks;
+static uint64_t traceStartNS;
+
+/*!
+ * Every buffer that's been allocated, linked through TraceRing::next.
+ */
+static TraceRing * volatile traceRingList = NULL;
+
+#if defined(GLDISPATCH_USE_TLS)
+static __thread TraceRing *currentRing
+    __attribute__((tls_model("initial-exec"))) = NULL;
+#else
+static glvnd_key_t currentRingKey;
+#endif
+
+static uint64_t ReadNS(void)
+{
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0) {
+        return 0;
+    }
+    return ((uint64_t) ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+/*!
+ * Returns a timestamp for a record. On x86, this is the TSC, since reading
+ * that is several times faster than clock_gettime.
+ */
+static inline uint64_t ReadTicks(void)
+{
+#if defined(__i386__) || defined(__x86_64__)
+    return __builtin_ia32_rdtsc();
+#else
+    return ReadNS();
+#endif
+}
+
+static uint64_t GetThreadID(void)
+{
+#if defined(__linux__) && defined(SYS_gettid)
+    return (uint64_t) syscall(SYS_gettid);
+#else
+    static int volatile nextID = 1;
+    int id;
+    do {
+        id = glvndAtomicLoadAcquire(&nextID);
+    } while (!glvndAtomicCompareExchange(&nextID, id, id + 1));
+    return (uint64_t) id;
+#endif
+}
+
+static TraceRing *CreateRing(void)
+{
+    TraceRing *ring = (TraceRing *) calloc(1, sizeof(TraceRing)
+            + traceRingSize * sizeof(TraceRecord));
+    TraceRing *head;
+
+    if (ring == NULL) {
+        return NULL;
+    }
+    ring->threadID = GetThreadID();
+
+    do {
+        head = (TraceRing *) glvndAtomicLoadAcquirePtr((void * volatile *) &traceRingList);
+        ring->next = head;
+    } while (!glvndAtomicCompareExchangePtr((void * volatile *) &traceRingList, head, ring));
+
+#if defined(GLDISPATCH_USE_TLS)
+    currentRing = ring;
+#else
+    __glvndPthreadFuncs.setspecific(currentRingKey, ring);
+#endif
+    return ring;
+}
+
+PUBLIC void __glDispatchTraceEvent(int event, uintptr_t arg0, uintptr_t arg1)
+{
+    TraceRing *ring;
+    TraceRecord *rec;
+    int head;
+
+    if (__builtin_expect(!traceEnabled, 1)) {
+        return;
+    }
+
+#if defined(GLDISPATCH_USE_TLS)
+    ring = currentRing;
+#else
+    ring = (TraceRing *) __glvndPthreadFuncs.getspecific(currentRingKey);
+#endif
+    if (ring == NULL) {
+        ring = CreateRing();
+        if (ring == NULL) {
+            return;
+        }
+    }
+
+    head = ring->head;
+    rec = &ring->records[head];
+    rec->timestamp = ReadTicks();
+    rec->event = (uint32_t) event;
+    rec->arg0 = arg0;
+    rec->arg1 = arg1;
+
+    head = (head + 1) & (traceRingSize - 1);
+    if (head == 0) {
+        ring->wrapped = 1;
+    }
+    glvndAtomicStoreRelease(&ring->head, head);
+}
+
+/*!
+ * Writes a whole buffer to a file.
+ *
+ * This is called from a signal handler, so it can only use async-signal-safe
+ * functions.
+ */
+static int WriteAll(int fd, const void *data, size_t size)
+{
+    const char *ptr = (const char *) data;
+
+    while (size > 0) {
+        ssize_t ret = write(fd, ptr, size);
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return 0;
+        }
+        ptr += ret;
+        size -= ret;
+    }
+    return 1;
+}
+
+/*!
+ * Writes out every trace buffer.
+ *
+ * Like \c WriteAll, this has to be async-signal-safe, so it formats the
+ * filename itself instead of using snprintf.
+ *
+ * \return Non-zero if the whole file was written.
+ */
+static int WriteTraceFile(void)
+{
+    char path[PATH_MAX + 24];
+    char digits[24];
+    size_t len, numDigits;
+    unsigned long pid;
+    TraceFileHeader header;
+    TraceRing *ring;
+    int savedErrno = errno;
+    int success = 0;
+    int fd;
+
+    len = strlen(tracePath);
+    memcpy(path, tracePath, len);
+    path[len++] = '.';
+    pid = (unsigned long) getpid();
+    numDigits = 0;
+    do {
+        digits[numDigits++] = '0' + (pid % 10);
+        pid /= 10;
+    } while (pid != 0);
+    while (numDigits > 0) {
+        path[len++] = digits[--numDigits];
+    }
+    path[len] = '\0';
+
+    fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        errno = savedErrno;
+        return 0;
+    }
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, TRACE_FILE_MAGIC, sizeof(header.magic));
+    header.version = TRACE_FILE_VERSION;
+    header.recordSize = sizeof(TraceRecord);
+    header.startTicks = traceStartTicks;
+    header.startNS = traceStartNS;
+    header.endTicks = ReadTicks();
+    header.endNS = ReadNS();
+    if (!WriteAll(fd, &header, sizeof(header))) {
+        goto done;
+    }
+
+    for (ring = (TraceRing *) glvndAtomicLoadAcquirePtr((void * volatile *) &traceRingList);
+            ring != NULL; ring = ring->next) {
+        TraceThreadHeader threadHeader;
+        int head = glvndAtomicLoadAcquire(&ring->head);
+        int wrapped = ring->wrapped;
+
+        memset(&threadHeader, 0, sizeof(threadHeader));
+        threadHeader.threadID = ring->threadID;
+        threadHeader.recordCount = (wrapped ? traceRingSize : head);
+        if (threadHeader.recordCount == 0) {
+            continue;
+        }
+        if (!WriteAll(fd, &threadHeader, sizeof(threadHeader))) {
+            goto done;
+        }
+        if (wrapped && !WriteAll(fd, &ring->records[head],
+                    (traceRingSize - head) * sizeof(TraceRecord))) {
+            goto done;
+        }
+        if (!WriteAll(fd, ring->records, head * sizeof(TraceRecord))) {
+            goto done;
+        }
+    }
+    success = 1;
+
+done:
+    close(fd);
+    errno = savedErrno;
+    return success;
+}
+
+static void StartTracing(void)
+{
+    TraceRing *ring;
+
+    for (ring = (TraceRing *) glvndAtomicLoadAcquirePtr((void * volatile *) &traceRingList);
+            ring != NULL; ring = ring->next) {
+        ring->wrapped = 0;
+        glvndAtomicStoreRelease(&ring->head, 0);
+    }
+    traceStartTicks = ReadTicks();
+    traceStartNS = ReadNS();
+    glvndAtomicStoreRelease(&traceEnabled, 1);
+}
+
+static void TraceSignalHandler(int sig)
+{
+    if (traceEnabled) {
+        glvndAtomicStoreRelease(&traceEnabled, 0);
+        WriteTraceFile();
+    } else {
+        StartTracing();
+    }
+}
+
+/*!
+ * Writes out the trace file when a flight recorder gets a fatal signal.
+ *
+ * This puts the previous handler back, so that it gets the signal next. A
+ * fault happens again as soon as this returns, but a signal that came from
+ * kill or raise has to be sent again.
+ */
+static void TraceFatalSignalHandler(int sig, siginfo_t *info, void *context)
+{
+    int i;
+
+    if (glvndAtomicCompareExchange(&fatalSignalHandled, 0, 1)) {
+        WriteTraceFile();
+    }
+
+    for (i=0; i<FATAL_SIGNAL_COUNT; i++) {
+        if (FATAL_SIGNALS[i] == sig) {
+            sigaction(sig, &oldFatalActions[i], NULL);
+            break;
+        }
+    }
+    if (info == NULL || info->si_code <= 0) {
+        raise(sig);
+    }
+}
+
+static void InstallFatalSignalHandlers(void)
+{
+    struct sigaction sa;
+    int i;
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_sigaction = TraceFatalSignalHandler;
+    sa.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    for (i=0; i<FATAL_SIGNAL_COUNT; i++) {
+        sigaction(FATAL_SIGNALS[i], &sa, &oldFatalActions[i]);
+    }
+    fatalHandlersInstalled = 1;
+}
+
+static void RemoveFatalSignalHandlers(void)
+{
+    int i;
+
+    if (!fatalHandlersInstalled) {
+        return;
+    }
+    for (i=0; i<FATAL_SIGNAL_COUNT; i++) {
+        struct sigaction current;
+
+        // Leave alone any handler that the application installed after ours.
+        if (sigaction(FATAL_SIGNALS[i], NULL, &current) == 0
+                && (current.sa_flags & SA_SIGINFO)
+                && current.sa_sigaction == TraceFatalSignalHandler) {
+            sigaction(FATAL_SIGNALS[i], &oldFatalActions[i], NULL);
+        }
+    }
+    fatalHandlersInstalled = 0;
+}
+
+PUBLIC GLboolean __glDispatchDumpTrace(void)
+{
+    if (!traceConfigured) {
+        return GL_FALSE;
+    }
+    return (WriteTraceFile() ? GL_TRUE : GL_FALSE);
+}
+
+PUBLIC void __glDispatchTraceProcLookup(int api, const char *procName)
+{
+    // Only hash the name if the event is going to be recorded.
+    if (__builtin_expect(!traceEnabled, 1)) {
+        return;
+    }
+    __glDispatchTraceEvent(GLDISPATCH_TRACE_PROC_LOOKUP, (uintptr_t) api,
+            (uintptr_t) glvndHashString(procName));
+}
+
+/*!
+ * Reads __GLVND_TRACE_RECORDS, and rounds it up to a power of two.
+ */
+static int GetRingSize(int defaultSize)
+{
+    const char *env = glvndGetEnv("__GLVND_TRACE_RECORDS");
+    int requested, size;
+
+    if (env == NULL || env[0] == '\0') {
+        return defaultSize;
+    }
+    requested = atoi(env);
+    if (requested <= 0) {
+        return defaultSize;
+    }
+    size = TRACE_RING_SIZE_MIN;
+    while (size < requested && size < TRACE_RING_SIZE_MAX) {
+        size *= 2;
+    }
+    return size;
+}
+
+void __glDispatchTraceInit(void)
+{
+    const char *env;
+    size_t len;
+
+    // Don't let the environment pick a file to write to in a setuid program.
+    if (getuid() != geteuid() || getgid() != getegid()) {
+        return;
+    }
+
+    env = glvndGetEnv("__GLVND_TRACE_FILE");
+    if (env == NULL || env[0] == '\0') {
+        return;
+    }
+    len = strlen(env);
+    if (len >= sizeof(tracePath)) {
+        return;
+    }
+    memcpy(tracePath, env, len + 1);
+
+    env = glvndGetEnv("__GLVND_TRACE_FLIGHT_RECORDER");
+    traceFlightRecorder = (env != NULL && atoi(env) != 0);
+    traceRingSize = GetRingSize(traceFlightRecorder
+            ? TRACE_RING_SIZE_FLIGHT_RECORDER : TRACE_RING_SIZE_DEFAULT);
+
+#if !defined(GLDISPATCH_USE_TLS)
+    if (__glvndPthreadFuncs.key_create(&currentRingKey, NULL) != 0) {
+        return;
+    }
+#endif
+    traceConfigured = 1;
+
+    if (traceFlightRecorder) {
+        InstallFatalSignalHandlers();
+    }
+
+    env = glvndGetEnv("__GLVND_TRACE_SIGNAL");
+    if (env != NULL) {
+        struct sigaction sa;
+        int sig = atoi(env);
+
+        memset(&sa, 0, sizeof(sa));
+        sa.sa_handler = TraceSignalHandler;
+        sa.sa_flags = SA_RESTART;
+        sigemptyset(&sa.sa_mask);
+        if (sig > 0 && sigaction(sig, &sa, &oldSignalAction) == 0) {
+            traceSignal = sig;
+            return;
+        }
+    }
+
+    StartTracing();
+}
+
+void __glDispatchTraceFini(void)
+{
+    if (!traceConfigured) {
+        return;
+    }
+
+    if (traceSignal != 0) {
+        sigaction(traceSignal, &oldSignalAction, NULL);
+        traceSignal = 0;
+    }
+    RemoveFatalSignalHandlers();
+
+    if (traceEnabled) {
+        glvndAtomicStoreRelease(&traceEnabled, 0);
+        // A flight recorder only writes the file when something goes wrong.
+        if (!traceFlightRecorder) {
+            WriteTraceFile();
+        }
+    }
+}
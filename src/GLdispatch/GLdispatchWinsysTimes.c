@@ -0,0 +1,434 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+/**
+ * \file
+ *
+ * Splits the time in window system calls between libglvnd and the vendor.
+ *
+ * Setting __GLVND_WINSYS_TIMES to a path enables it. libGLX and libEGL time
+ * each call to a few entrypoints, along with the part of that call that's
+ * spent in the vendor library, and add both to the counters here. The
+ * difference is libglvnd's own overhead: looking up displays, contexts and
+ * vendors, taking locks, and setting up thread state.
+ *
+ * __glDispatchGetWinsysTimes returns the totals at any time, and they're
+ * written to the path, with ".<pid>" appended, when the last client library
+ * calls __glDispatchFini.
+ *
+ * The totals only give the mean, which hides the occasional slow call that
+ * causes a hitch. Setting __GLVND_WINSYS_HISTOGRAMS to a path also keeps a
+ * latency histogram for each entrypoint. The buckets are log-linear, with
+ * 2^GLDISPATCH_WINSYS_HISTOGRAM_SUB_BITS buckets for each power of two, so
+ * each bucket is within 12.5% of the latencies in it.
+ *
+ * Each thread records into a block of histograms of its own, so recording a
+ * call doesn't need a lock or an atomic read-modify-write. The blocks go on a
+ * list that's never freed. When a thread exits, another thread can take over
+ * its block, so the list only grows to the most threads that were ever
+ * recording at once. __glDispatchGetWinsysHistogram adds up every block on
+ * the list, and the histograms are written to the path, with ".<pid>"
+ * appended, along with the totals.
+ */
+
+#include "GLdispatchPrivate.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "glvnd_pthread.h"
+#include "glvnd_atomic.h"
+#include "utils_misc.h"
+
+typedef struct WinsysTimesEntryRec {
+    uint64_t calls;
+    uint64_t totalNS;
+    uint64_t vendorNS;
+} WinsysTimesEntry;
+
+typedef struct WinsysHistogramBlockRec {
+    struct WinsysHistogramBlockRec *next;
+
+    /// Non-zero while a thread is recording into this block.
+    int volatile inUse;
+
+    /// Only the thread that owns the block writes to these.
+    uint64_t counts[GLDISPATCH_WINSYS_COUNT][GLDISPATCH_WINSYS_HISTOGRAM_BUCKETS];
+} WinsysHistogramBlock;
+
+static const char * const WINSYS_TIMES_NAMES[GLDISPATCH_WINSYS_COUNT] = {
+    "glXMakeCurrent",
+    "glXSwapBuffers",
+    "eglMakeCurrent",
+    "eglSwapBuffers",
+    "eglGetPlatformDisplay",
+    "glXMakeContextCurrent",
+};
+
+static int winsysTimesEnabled = 0;
+static char *winsysTimesPath = NULL;
+static WinsysTimesEntry winsysTimes[GLDISPATCH_WINSYS_COUNT];
+
+static int winsysHistogramsEnabled = 0;
+static char *winsysHistogramsPath = NULL;
+static WinsysHistogramBlock * volatile winsysHistogramBlocks = NULL;
+static glvnd_key_t winsysHistogramKey;
+
+#if !defined(__ATOMIC_RELAXED)
+static glvnd_mutex_t winsysTimesMutex = GLVND_MUTEX_INITIALIZER;
+#endif
+
+/*
+ * Hands the exiting thread's histogram block back, so that another thread
+ * can take it over.
+ */
+static void OnHistogramThreadExit(void *data)
+{
+    WinsysHistogramBlock *block = (WinsysHistogramBlock *) data;
+    glvndAtomicStoreRelease(&block->inUse, 0);
+}
+
+/*
+ * Returns the calling thread's histogram block, taking over an unused one or
+ * allocating a new one the first time.
+ */
+static WinsysHistogramBlock *GetHistogramBlock(void)
+{
+    WinsysHistogramBlock *block;
+
+    block = (WinsysHistogramBlock *)
+        __glvndPthreadFuncs.getspecific(winsysHistogramKey);
+    if (block != NULL) {
+        return block;
+    }
+
+    for (block = (WinsysHistogramBlock *) glvndAtomicLoadAcquirePtr(
+                (void * volatile *) &winsysHistogramBlocks);
+            block != NULL; block = block->next) {
+        if (glvndAtomicCompareExchange(&block->inUse, 0, 1)) {
+            break;
+        }
+    }
+
+    if (block == NULL) {
+        WinsysHistogramBlock *head;
+
+        block = calloc(1, sizeof(WinsysHistogramBlock));
+        if (block == NULL) {
+            return NULL;
+        }
+        block->inUse = 1;
+        do {
+            head = (WinsysHistogramBlock *) glvndAtomicLoadAcquirePtr(
+                    (void * volatile *) &winsysHistogramBlocks);
+            block->next = head;
+        } while (!glvndAtomicCompareExchangePtr(
+                    (void * volatile *) &winsysHistogramBlocks, head, block));
+    }
+
+    __glvndPthreadFuncs.setspecific(winsysHistogramKey, block);
+    return block;
+}
+
+/*
+ * Returns the histogram bucket for a latency. Bucket i covers the latencies
+ * from __glDispatchWinsysHistogramBucketNS(i) up to the start of bucket i+1,
+ * and the last bucket also covers everything past it.
+ */
+static int GetHistogramBucket(uint64_t ns)
+{
+    const int subBits = GLDISPATCH_WINSYS_HISTOGRAM_SUB_BITS;
+    const int subCount = 1 << subBits;
+    int exponent;
+    int bucket;
+
+    if (ns < (uint64_t) subCount) {
+        return (int) ns;
+    }
+
+    exponent = 63 - __builtin_clzll(ns);
+    bucket = (exponent - subBits + 1) * subCount
+        + (int) ((ns >> (exponent - subBits)) & (subCount - 1));
+    if (bucket >= GLDISPATCH_WINSYS_HISTOGRAM_BUCKETS) {
+        bucket = GLDISPATCH_WINSYS_HISTOGRAM_BUCKETS - 1;
+    }
+    return bucket;
+}
+
+static void RecordHistogram(int entry, uint64_t ns)
+{
+    WinsysHistogramBlock *block = GetHistogramBlock();
+    uint64_t *count;
+
+    if (block == NULL) {
+        return;
+    }
+
+    // This thread is the only writer, so a plain load and store is enough.
+    // The store still has to be atomic so that a reader doesn't see half of
+    // it.
+    count = &block->counts[entry][GetHistogramBucket(ns)];
+#if defined(__ATOMIC_RELAXED)
+    __atomic_store_n(count, __atomic_load_n(count, __ATOMIC_RELAXED) + 1,
+            __ATOMIC_RELAXED);
+#else
+    (*(uint64_t volatile *) count)++;
+#endif
+}
+
+void __glDispatchWinsysTimesInit(void)
+{
+    const char *env;
+
+    // Don't let the environment pick a file to write to in a setuid program.
+    if (getuid() != geteuid() || getgid() != getegid()) {
+        return;
+    }
+
+    env = glvndGetEnv("__GLVND_WINSYS_TIMES");
+    if (env != NULL && env[0] != '\0') {
+        winsysTimesPath = strdup(env);
+        if (winsysTimesPath != NULL) {
+            winsysTimesEnabled = 1;
+        }
+    }
+
+    env = glvndGetEnv("__GLVND_WINSYS_HISTOGRAMS");
+    if (env != NULL && env[0] != '\0') {
+        winsysHistogramsPath = strdup(env);
+        if (winsysHistogramsPath == NULL) {
+            return;
+        }
+        if (__glvndPthreadFuncs.key_create(&winsysHistogramKey,
+                    OnHistogramThreadExit) != 0) {
+            free(winsysHistogramsPath);
+            winsysHistogramsPath = NULL;
+            return;
+        }
+        winsysHistogramsEnabled = 1;
+    }
+}
+
+static uint64_t GetTimeNS(void)
+{
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0) {
+        return 0;
+    }
+    return ((uint64_t) ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+PUBLIC uint64_t __glDispatchWinsysTimeBegin(void)
+{
+    if (!winsysTimesEnabled && !winsysHistogramsEnabled) {
+        return 0;
+    }
+    return GetTimeNS();
+}
+
+PUBLIC uint64_t __glDispatchWinsysTimeSince(uint64_t start)
+{
+    if (start == 0) {
+        return 0;
+    }
+    return GetTimeNS() - start;
+}
+
+PUBLIC void __glDispatchWinsysTimeEnd(int entry, uint64_t start,
+        uint64_t vendorNS)
+{
+    WinsysTimesEntry *times;
+    uint64_t totalNS;
+
+    if (start == 0 || entry < 0 || entry >= GLDISPATCH_WINSYS_COUNT) {
+        return;
+    }
+
+    totalNS = GetTimeNS() - start;
+    if (winsysHistogramsEnabled) {
+        RecordHistogram(entry, totalNS);
+    }
+    if (!winsysTimesEnabled) {
+        return;
+    }
+    times = &winsysTimes[entry];
+
+    // These are only read as a snapshot, so each counter can be updated on
+    // its own.
+#if defined(__ATOMIC_RELAXED)
+    __atomic_add_fetch(&times->calls, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&times->totalNS, totalNS, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&times->vendorNS, vendorNS, __ATOMIC_RELAXED);
+#else
+    __glvndPthreadFuncs.mutex_lock(&winsysTimesMutex);
+    times->calls++;
+    times->totalNS += totalNS;
+    times->vendorNS += vendorNS;
+    __glvndPthreadFuncs.mutex_unlock(&winsysTimesMutex);
+#endif
+}
+
+PUBLIC GLboolean __glDispatchGetWinsysTimes(int entry, const char **name,
+        uint64_t *calls, uint64_t *totalNS, uint64_t *vendorNS)
+{
+    const WinsysTimesEntry *times;
+
+    if (!winsysTimesEnabled || entry < 0 || entry >= GLDISPATCH_WINSYS_COUNT) {
+        return GL_FALSE;
+    }
+
+    times = &winsysTimes[entry];
+    *name = WINSYS_TIMES_NAMES[entry];
+#if defined(__ATOMIC_RELAXED)
+    *calls = __atomic_load_n(&times->calls, __ATOMIC_RELAXED);
+    *totalNS = __atomic_load_n(&times->totalNS, __ATOMIC_RELAXED);
+    *vendorNS = __atomic_load_n(&times->vendorNS, __ATOMIC_RELAXED);
+#else
+    __glvndPthreadFuncs.mutex_lock(&winsysTimesMutex);
+    *calls = times->calls;
+    *totalNS = times->totalNS;
+    *vendorNS = times->vendorNS;
+    __glvndPthreadFuncs.mutex_unlock(&winsysTimesMutex);
+#endif
+    return GL_TRUE;
+}
+
+PUBLIC uint64_t __glDispatchWinsysHistogramBucketNS(int bucket)
+{
+    const int subBits = GLDISPATCH_WINSYS_HISTOGRAM_SUB_BITS;
+    const int subCount = 1 << subBits;
+
+    if (bucket < subCount) {
+        return (uint64_t) bucket;
+    }
+    return ((uint64_t) (subCount + (bucket % subCount)))
+        << (bucket / subCount - 1);
+}
+
+PUBLIC GLboolean __glDispatchGetWinsysHistogram(int entry, uint64_t *counts)
+{
+    const WinsysHistogramBlock *block;
+    int i;
+
+    if (!winsysHistogramsEnabled || entry < 0 || entry >= GLDISPATCH_WINSYS_COUNT) {
+        return GL_FALSE;
+    }
+
+    memset(counts, 0, GLDISPATCH_WINSYS_HISTOGRAM_BUCKETS * sizeof(uint64_t));
+    for (block = (const WinsysHistogramBlock *) glvndAtomicLoadAcquirePtr(
+                (void * volatile *) &winsysHistogramBlocks);
+            block != NULL; block = block->next) {
+        for (i=0; i<GLDISPATCH_WINSYS_HISTOGRAM_BUCKETS; i++) {
+#if defined(__ATOMIC_RELAXED)
+            counts[i] += __atomic_load_n(&block->counts[entry][i], __ATOMIC_RELAXED);
+#else
+            counts[i] += *(const uint64_t volatile *) &block->counts[entry][i];
+#endif
+        }
+    }
+    return GL_TRUE;
+}
+
+static void DumpWinsysHistograms(void)
+{
+    uint64_t counts[GLDISPATCH_WINSYS_HISTOGRAM_BUCKETS];
+    char *path;
+    FILE *fp;
+    int entry, i;
+
+    if (winsysHistogramsPath == NULL) {
+        return;
+    }
+
+    if (glvnd_asprintf(&path, "%s.%ld", winsysHistogramsPath, (long) getpid()) < 0) {
+        return;
+    }
+    fp = fopen(path, "w");
+    free(path);
+    if (fp == NULL) {
+        return;
+    }
+
+    fprintf(fp, "# function,bucket_ns,calls\n");
+    for (entry=0; __glDispatchGetWinsysHistogram(entry, counts); entry++) {
+        for (i=0; i<GLDISPATCH_WINSYS_HISTOGRAM_BUCKETS; i++) {
+            if (counts[i] != 0) {
+                fprintf(fp, "%s,%llu,%llu\n", WINSYS_TIMES_NAMES[entry],
+                        (unsigned long long) __glDispatchWinsysHistogramBucketNS(i),
+                        (unsigned long long) counts[i]);
+            }
+        }
+    }
+    fclose(fp);
+}
+
+PUBLIC void __glDispatchDumpWinsysTimes(void)
+{
+    const char *name;
+    uint64_t calls, totalNS, vendorNS;
+    char *path;
+    FILE *fp;
+    int i;
+
+    DumpWinsysHistograms();
+
+    if (winsysTimesPath == NULL) {
+        return;
+    }
+
+    if (glvnd_asprintf(&path, "%s.%ld", winsysTimesPath, (long) getpid()) < 0) {
+        return;
+    }
+    fp = fopen(path, "w");
+    free(path);
+    if (fp == NULL) {
+        return;
+    }
+
+    fprintf(fp, "# function,calls,total_ns,vendor_ns,libglvnd_ns\n");
+    for (i=0; __glDispatchGetWinsysTimes(i, &name, &calls, &totalNS, &vendorNS); i++) {
+        if (calls == 0) {
+            continue;
+        }
+        fprintf(fp, "%s,%llu,%llu,%llu,%llu\n", name,
+                (unsigned long long) calls, (unsigned long long) totalNS,
+                (unsigned long long) vendorNS,
+                (unsigned long long) (totalNS > vendorNS ? totalNS - vendorNS : 0));
+    }
+    fclose(fp);
+}
+
+void __glDispatchWinsysTimesFini(void)
+{
+    __glDispatchDumpWinsysTimes();
+}
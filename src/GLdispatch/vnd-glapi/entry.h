@@ -60,11 +60,20 @@ void *entry_save_entrypoints(void);
  */
 void entry_restore_entrypoints(void *saved);
 
+/**
+ * Faults in the pages that hold the entrypoints, so that the first call to
+ * each one doesn't take a page fault.
+ *
+ * \param lock If non-zero, also try to lock the pages in memory.
+ */
+void entry_prewarm(int lock);
+
 /**
  * Called before starting entrypoint patching.
  *
- * This function will generally call mprotect(2) to make the static entrypoints
- * writable.
+ * This function will either make a writable scratch copy of the entrypoints,
+ * or call mprotect(2) to make the static entrypoints writable. Any changes
+ * should be written to the address from \c entry_get_patch_write_address.
  *
  * \return Non-zero on success, zero on failure.
  */
@@ -73,6 +82,9 @@ int entry_patch_start(void);
 /**
  * Called after the vendor library finishes patching the entrypoints.
  *
+ * If \c entry_patch_start made a scratch copy, then this swaps it in place of
+ * the entrypoints.
+ *
  * \return Non-zero on success, zero on failure.
  */
 int entry_patch_finish(void);
@@ -89,4 +101,120 @@ int entry_patch_finish(void);
  */
 void *entry_get_patch_address(int index);
 
+/**
+ * Returns the address that a vendor library should write to in order to patch
+ * an entrypoint.
+ *
+ * Between \c entry_patch_start and \c entry_patch_finish, this may be an
+ * address in a scratch copy of the entrypoints, which \c entry_patch_finish
+ * then swaps in. Any PC-relative addresses should still be calculated from
+ * \c entry_get_patch_address.
+ *
+ * \param int The index of the entrypoint to patch.
+ * \return The address to write the new code to.
+ */
+void *entry_get_patch_write_address(int index);
+
+/**
+ * Changes an entrypoint to jump directly to \p target.
+ *
+ * Unlike the code that a vendor library writes through
+ * \c entry_get_patch_address, the jump is written with a single aligned
+ * store, so this is safe to call while other threads are running the
+ * entrypoint. Calling this again replaces the target.
+ *
+ * This must be called between \c entry_patch_start and
+ * \c entry_patch_finish.
+ *
+ * \param index The index of the entrypoint to patch.
+ * \param target The function to jump to.
+ * \return Non-zero on success, or zero if the stubs don't support this.
+ */
+int entry_set_target(int index, const void *target);
+
+/**
+ * Undoes every \c entry_set_target call, using a copy of the entrypoints from
+ * \c entry_save_entrypoints.
+ *
+ * Like \c entry_set_target, this is safe to call while other threads are
+ * running the entrypoints, and it must be called between
+ * \c entry_patch_start and \c entry_patch_finish.
+ */
+void entry_restore_targets(const void *saved);
+
+/**
+ * Rewrites the stubs to read the current dispatch table from \p current,
+ * which is the calling thread's copy of a pointer at a fixed offset in static
+ * TLS.
+ *
+ * This is only supported with the x86-64 TSD stubs when libGLdispatch is
+ * built with --enable-runtime-tls. It has to be called from libGLdispatch's
+ * constructor, before any other thread can call a stub.
+ *
+ * \param current The address of the calling thread's dispatch table pointer.
+ * \return Non-zero if the stubs were rewritten.
+ */
+int entry_init_static_tls(const void **current);
+
+/**
+ * A callback to look up the real function for a dispatch table slot. This is
+ * called from the lazy resolver trampolines.
+ *
+ * \param slot The dispatch table slot that was called.
+ * \return The function to call.
+ */
+typedef mapi_func (*entry_lazy_resolve_callback)(int slot);
+
+/**
+ * Sets the callback that the lazy resolver trampolines will call.
+ */
+void entry_set_lazy_resolve_callback(entry_lazy_resolve_callback callback);
+
+/**
+ * Returns the lazy resolver trampoline for a dispatch table slot.
+ *
+ * If a dispatch table slot points to its trampoline, then the first call
+ * through that slot will call the resolver callback, and then jump to
+ * whatever function it returns.
+ *
+ * \param slot The dispatch table slot.
+ * \return The trampoline, or \c NULL if lazy resolution isn't supported or no
+ * resolver callback has been set.
+ */
+mapi_func entry_get_lazy_trampoline(int slot);
+
+/**
+ * Returns the call counting trampoline for a dispatch table slot.
+ *
+ * A counting trampoline increments that slot's counter in the current
+ * counting table, and then jumps through the same slot in the counting
+ * table's target. See \c _glapi_create_count_table.
+ *
+ * \param slot The dispatch table slot.
+ * \return The trampoline, or \c NULL if call counting isn't supported.
+ */
+mapi_func entry_get_count_trampoline(int slot);
+
+/**
+ * Returns the stub for an overflow dynamic function, generating it if
+ * necessary.
+ *
+ * An overflow stub dispatches through the chunk of overflow slots at the end
+ * of the current dispatch table, as described in table.h.
+ *
+ * If the stub doesn't exist yet, then this must be called while holding the
+ * dispatch lock.
+ *
+ * \param index The index of the stub past \c MAPI_TABLE_NUM_SLOTS.
+ * \return The stub, or \c NULL if overflow stubs aren't supported or the
+ * stub couldn't be generated.
+ */
+mapi_func entry_get_overflow(int index);
+
+/**
+ * The size in bytes of each overflow stub, or zero if overflow stubs aren't
+ * supported.
+ */
+extern const int entry_overflow_stub_size;
+
 #endif /* _ENTRY_H_ */
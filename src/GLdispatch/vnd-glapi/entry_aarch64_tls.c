@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+#include "entry.h"
+#include "entry_common.h"
+
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <assert.h>
+
+#include "glapi.h"
+#include "u_macros.h"
+#include "u_current.h"
+#include "utils_misc.h"
+#include "glvnd/GLdispatchABI.h"
+
+/*
+ * See: https://sourceware.org/binutils/docs/as/ARM-Directives.html
+ */
+
+/*
+ * The size of each dispatch stub. This is the same as the TSD stubs, so that
+ * vendor libraries can patch either one the same way.
+ */
+#define ENTRY_STUB_ALIGN 128
+#if !defined(GLDISPATCH_PAGE_SIZE)
+// Note that on aarch64, the page size could be 4K or 64K. Pick 64K, since that
+// will work in either case.
+#define GLDISPATCH_PAGE_SIZE 65536
+#endif
+
+#define STUB_ASM_ENTRY(func)                        \
+    ".balign " U_STRINGIFY(ENTRY_STUB_ALIGN) "\n\t" \
+    ".global " func "\n\t"                          \
+    ".type " func ", %function\n\t"                 \
+    func ":\n\t"
+
+/*
+ * Looks up the current dispatch table from _glapi_tls_Current, finds the stub
+ * address at the given slot, then jumps to it.
+ *
+ * _glapi_tls_Current uses the initial-exec TLS model, so its offset from
+ * tpidr_el0 is in the GOT. Unlike the TSD stubs, this never has to call
+ * _glapi_get_current, so it doesn't need to save any registers. It only uses
+ * x16 and x17, which the AAPCS64 reserves for this kind of veneer.
+ *
+ * The slot offset is loaded from a literal, since an immediate offset in an
+ * ldr instruction can't reach every slot.
+ */
+#define STUB_ASM_CODE(slot)                                      \
+    "mrs x16, tpidr_el0\n\t"                                     \
+    "adrp x17, :gottprel:_glapi_tls_Current\n\t"                 \
+    "ldr x17, [x17, #:gottprel_lo12:_glapi_tls_Current]\n\t"     \
+    "ldr x16, [x16, x17]\n\t"                                    \
+    "ldr x17, 3f\n\t"                                            \
+    "ldr x16, [x16, x17]\n\t"                                    \
+    "br x16\n\t"                                                 \
+    ".balign 8\n\t"                                              \
+    "3:\n\t"                                                     \
+    ".xword " slot " * 8\n\t" /* size of (void *) */
+
+__asm__(".section wtext,\"ax\"\n"
+        ".balign " U_STRINGIFY(GLDISPATCH_PAGE_SIZE) "\n"
+       ".globl public_entry_start\n"
+       ".hidden public_entry_start\n"
+        "public_entry_start:\n");
+
+#define MAPI_TMP_STUB_ASM_GCC
+#include "mapi_tmp.h"
+
+__asm__(".balign " U_STRINGIFY(GLDISPATCH_PAGE_SIZE) "\n"
+       ".globl public_entry_end\n"
+       ".hidden public_entry_end\n"
+        "public_entry_end:\n"
+        ".text\n\t");
+
+const int entry_type = __GLDISPATCH_STUB_AARCH64;
+const int entry_stub_size = ENTRY_STUB_ALIGN;
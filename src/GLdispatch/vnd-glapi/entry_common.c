@@ -25,6 +25,8 @@
  *    Kyle Brenneman <kbrenneman@nvidia.com>
  */
 
+#define _GNU_SOURCE 1
+
 #include "entry.h"
 #include "entry_common.h"
 
@@ -34,33 +36,262 @@
 #include <unistd.h>
 #include <assert.h>
 
+#if defined(HAVE_DL_ITERATE_PHDR)
+#include <link.h>
+#endif
+
 #include "glapi.h"
 #include "u_macros.h"
 #include "u_current.h"
 #include "utils_misc.h"
 
-static int entry_patch_mprotect(int prot)
+/*
+ * If we can, then entry_patch_start makes a scratch copy of the entrypoints,
+ * and all of the changes until entry_patch_finish go to that copy instead.
+ * entry_patch_finish then maps the copy on top of the entrypoints.
+ *
+ * That way, the entrypoints are never writable, every stub changes in a
+ * single step, and we only have to flush the instruction cache once. Each
+ * page is replaced atomically, so another thread running a stub sees either
+ * the old page or the new one, and entry_set_target still works the same way.
+ *
+ * If memfd_create is available, then the scratch copy is a writable mapping
+ * of a new memfd, and entry_patch_finish maps the same memfd again as
+ * read/exec on top of the entrypoints. No mapping is ever both writable and
+ * executable, and no mapping ever goes from writable to executable, so this
+ * still works on kernels that enforce W^X. The writable mapping is unmapped
+ * afterward and the memfd is never written to again, so a child process
+ * that shares the memfd after a fork is never affected by a later patch.
+ *
+ * Otherwise, the scratch copy is an anonymous mapping, which
+ * entry_patch_finish makes executable and moves with mremap(2).
+ *
+ * This is only used while holding the dispatch lock.
+ */
+#if defined(HAVE_MEMFD_CREATE) || defined(MREMAP_FIXED)
+#define ENTRY_USE_PATCH_SCRATCH 1
+static char *entry_patch_scratch = NULL;
+
+/*
+ * The memfd that backs entry_patch_scratch, or -1 if it's an anonymous
+ * mapping.
+ */
+static int entry_patch_scratch_fd = -1;
+#endif
+
+static void InvalidateCache(void);
+
+static size_t entry_get_size(void)
+{
+    return ((uintptr_t) public_entry_end) - ((uintptr_t) public_entry_start);
+}
+
+/*
+ * Returns the address that changes to the entrypoints should be written to.
+ */
+static char *entry_get_write_start(void)
+{
+#if defined(ENTRY_USE_PATCH_SCRATCH)
+    if (entry_patch_scratch != NULL) {
+        return entry_patch_scratch;
+    }
+#endif
+    return public_entry_start;
+}
+
+static int entry_is_page_aligned(size_t pageSize)
+{
+    return (((uintptr_t) public_entry_start) % pageSize == 0
+            && ((uintptr_t) public_entry_end) % pageSize == 0);
+}
+
+/*
+ * The range of pages that entry_patch_mprotect changes.
+ *
+ * Normally, that's just the entrypoints. The entrypoints are only aligned to
+ * GLDISPATCH_PAGE_SIZE, though, so if we're running with larger pages than
+ * that (say, a 4K build on a kernel with 16K or 64K pages), then we round out
+ * to the enclosing pages instead. That's only safe if every one of those pages
+ * belongs to the same read/exec segment as the entrypoints, since
+ * entry_patch_finish sets all of them back to read/exec.
+ *
+ * entry_protect_state is 0 until we've looked up the range, 1 if it's valid,
+ * or -1 if we can't change the protection.
+ */
+static int entry_protect_state = 0;
+static uintptr_t entry_protect_start = 0;
+static uintptr_t entry_protect_end = 0;
+
+#if defined(HAVE_DL_ITERATE_PHDR)
+static int FindEntrySegmentCallback(struct dl_phdr_info *info, size_t size, void *data)
 {
-    size_t size;
     size_t pageSize = (size_t) sysconf(_SC_PAGESIZE);
+    uintptr_t start = ((uintptr_t) public_entry_start) & ~(pageSize - 1);
+    uintptr_t end = (((uintptr_t) public_entry_end) + pageSize - 1) & ~(pageSize - 1);
+    int *found = (int *) data;
+    int valid = 0;
+    int unsafe = 0;
+    int i;
+
+    for (i=0; i<info->dlpi_phnum; i++) {
+        const ElfW(Phdr) *phdr = &info->dlpi_phdr[i];
+        uintptr_t segStart, segEnd;
+
+        if (phdr->p_type != PT_LOAD) {
+            continue;
+        }
+        segStart = info->dlpi_addr + phdr->p_vaddr;
+        segEnd = segStart + phdr->p_memsz;
+        if (((uintptr_t) public_entry_start) >= segStart
+                && ((uintptr_t) public_entry_end) <= segEnd) {
+            // This is the segment with the entrypoints. It has to be
+            // read/exec, or else we'd change its protection when we're done.
+            if ((phdr->p_flags & (PF_R | PF_W | PF_X)) != (PF_R | PF_X)) {
+                unsafe = 1;
+            }
+            valid = 1;
+        } else {
+            // Any other segment has to be entirely outside of the pages that
+            // we'd change.
+            segStart &= ~(pageSize - 1);
+            segEnd = (segEnd + pageSize - 1) & ~(pageSize - 1);
+            if (segStart < end && segEnd > start) {
+                unsafe = 1;
+            }
+        }
+    }
 
-    if (((uintptr_t) public_entry_start) % pageSize != 0
-            || ((uintptr_t) public_entry_end) % pageSize != 0) {
-        assert(((uintptr_t) public_entry_start) % pageSize == 0);
-        assert(((uintptr_t) public_entry_end) % pageSize == 0);
+    if (!valid) {
+        // The entrypoints aren't in this library.
         return 0;
     }
 
-    size = ((uintptr_t) public_entry_end) - ((uintptr_t) public_entry_start);
+    if (!unsafe) {
+        entry_protect_start = start;
+        entry_protect_end = end;
+        *found = 1;
+    } else {
+        *found = -1;
+    }
+    return 1;
+}
+#endif // defined(HAVE_DL_ITERATE_PHDR)
+
+static int entry_get_protect_range(void)
+{
+    if (entry_protect_state == 0) {
+        size_t pageSize = (size_t) sysconf(_SC_PAGESIZE);
+
+        entry_protect_state = -1;
+        if (entry_is_page_aligned(pageSize)) {
+            entry_protect_start = (uintptr_t) public_entry_start;
+            entry_protect_end = (uintptr_t) public_entry_end;
+            entry_protect_state = 1;
+        } else {
+#if defined(HAVE_DL_ITERATE_PHDR)
+            int found = 0;
+            dl_iterate_phdr(FindEntrySegmentCallback, &found);
+            if (found > 0) {
+                entry_protect_state = 1;
+            }
+#endif
+        }
+    }
+    return (entry_protect_state > 0);
+}
 
-    if (mprotect(public_entry_start, size, prot) != 0) {
+static int entry_patch_mprotect(int prot)
+{
+    if (!entry_get_protect_range()) {
+        return 0;
+    }
+
+    if (mprotect((void *) entry_protect_start,
+                entry_protect_end - entry_protect_start, prot) != 0) {
         return 0;
     }
     return 1;
 }
 
+#if defined(ENTRY_USE_PATCH_SCRATCH)
+static int entry_patch_start_scratch(void)
+{
+    size_t size = entry_get_size();
+    void *scratch;
+
+#if defined(HAVE_MEMFD_CREATE)
+    int fd = memfd_create("glvnd-entrypoints", MFD_CLOEXEC);
+    if (fd >= 0) {
+        if (ftruncate(fd, size) == 0) {
+            scratch = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (scratch != MAP_FAILED) {
+                memcpy(scratch, public_entry_start, size);
+                entry_patch_scratch = scratch;
+                entry_patch_scratch_fd = fd;
+                return 1;
+            }
+        }
+        close(fd);
+    }
+#endif
+
+#if defined(MREMAP_FIXED)
+    scratch = mmap(NULL, size, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (scratch != MAP_FAILED) {
+        memcpy(scratch, public_entry_start, size);
+        entry_patch_scratch = scratch;
+        entry_patch_scratch_fd = -1;
+        return 1;
+    }
+#endif
+
+    return 0;
+}
+
+/*
+ * Replaces the entrypoints with the scratch copy. On failure, the scratch
+ * copy is left unchanged.
+ */
+static int entry_patch_swap_scratch(char *scratch, int fd)
+{
+    size_t size = entry_get_size();
+
+#if defined(HAVE_MEMFD_CREATE)
+    if (fd >= 0) {
+        return (mmap(public_entry_start, size, PROT_READ | PROT_EXEC,
+                    MAP_SHARED | MAP_FIXED, fd, 0) != MAP_FAILED);
+    }
+#endif
+
+#if defined(MREMAP_FIXED)
+    if (mprotect(scratch, size, PROT_READ | PROT_EXEC) == 0
+            && mremap(scratch, size, size, MREMAP_MAYMOVE | MREMAP_FIXED,
+                public_entry_start) != MAP_FAILED) {
+        return 1;
+    }
+#endif
+
+    return 0;
+}
+#endif // defined(ENTRY_USE_PATCH_SCRATCH)
+
 int entry_patch_start(void)
 {
+#if defined(ENTRY_USE_PATCH_SCRATCH)
+    size_t pageSize = (size_t) sysconf(_SC_PAGESIZE);
+
+    assert(entry_patch_scratch == NULL);
+
+    // The scratch copy replaces whole pages, so it only works if the
+    // entrypoints are aligned to the page size that we're running with.
+    if (entry_is_page_aligned(pageSize)) {
+        if (entry_patch_start_scratch()) {
+            return 1;
+        }
+    }
+#endif
+
     // Set the memory protections to read/write/exec.
     // Since this only gets called when no thread has a current context, this
     // could also just be read/write, without exec, and then set it back to
@@ -71,6 +302,40 @@ int entry_patch_start(void)
 
 int entry_patch_finish(void)
 {
+#if defined(ENTRY_USE_PATCH_SCRATCH)
+    if (entry_patch_scratch != NULL) {
+        char *scratch = entry_patch_scratch;
+        int fd = entry_patch_scratch_fd;
+        size_t size = entry_get_size();
+        int swapped;
+
+        entry_patch_scratch = NULL;
+        entry_patch_scratch_fd = -1;
+
+        swapped = entry_patch_swap_scratch(scratch, fd);
+        if (!swapped) {
+            // If we can't swap in the new mapping, then fall back to copying
+            // it over the entrypoints.
+            if (entry_patch_mprotect(PROT_READ | PROT_WRITE | PROT_EXEC)) {
+                memcpy(public_entry_start, scratch, size);
+            }
+        }
+        InvalidateCache();
+
+        // With an anonymous mapping, mremap has already taken the scratch
+        // pages away, but the memfd's writable mapping is still there.
+        if (!swapped || fd >= 0) {
+            munmap(scratch, size);
+        }
+        if (fd >= 0) {
+            close(fd);
+        }
+        if (swapped) {
+            return 1;
+        }
+    }
+#endif
+
     return entry_patch_mprotect(PROT_READ | PROT_EXEC);
 }
 
@@ -79,9 +344,14 @@ void *entry_get_patch_address(int index)
     return (void *) (public_entry_start + (index * entry_stub_size));
 }
 
+void *entry_get_patch_write_address(int index)
+{
+    return (void *) (entry_get_write_start() + (index * entry_stub_size));
+}
+
 void *entry_save_entrypoints(void)
 {
-    size_t size = ((uintptr_t) public_entry_end) - ((uintptr_t) public_entry_start);
+    size_t size = entry_get_size();
     void *buf = malloc(size);
     if (buf != NULL) {
         memcpy(buf, public_entry_start, size);
@@ -89,7 +359,13 @@ void *entry_save_entrypoints(void)
     return buf;
 }
 
-#if defined(USE_ARMV7_ASM) || defined(USE_AARCH64_ASM)
+void entry_prewarm(int lock)
+{
+    glvnd_prefault_pages(public_entry_start, entry_get_size(), lock);
+}
+
+#if defined(USE_ARMV7_ASM) || defined(USE_AARCH64_ASM) \
+    || defined(USE_RISCV64_ASM) || defined(USE_LOONGARCH64_ASM)
 static void InvalidateCache(void)
 {
     // See http://community.arm.com/groups/processors/blog/2010/02/17/caches-and-self-modifying-code
@@ -129,8 +405,103 @@ static void InvalidateCache(void)
 
 void entry_restore_entrypoints(void *saved)
 {
-    size_t size = ((uintptr_t) public_entry_end) - ((uintptr_t) public_entry_start);
-    memcpy(public_entry_start, saved, size);
-    InvalidateCache();
+    char *dest = entry_get_write_start();
+
+    memcpy(dest, saved, entry_get_size());
+    if (dest == public_entry_start) {
+        InvalidateCache();
+    }
 }
 
+#if !defined(ENTRY_RUNTIME_TLS_STUBS)
+int entry_init_static_tls(const void **current)
+{
+    return 0;
+}
+#endif
+
+#if defined(USE_X86_64_ASM)
+/*
+ * On x86-64, a retargeted entrypoint starts with:
+ *
+ *   jmp *target(%rip)   (ff 25 disp32)
+ *
+ * where target is the last 8 bytes of the stub, which the stubs reserve with
+ * ENTRY_STUB_RESERVE_TARGET, or the stub's element of entry_compact_targets
+ * with the compact stubs.
+ *
+ * The jmp instruction is 6 bytes, so we write it together with the next two
+ * bytes of the original stub as a single aligned 8-byte store. The first
+ * instruction of each stub is at least 6 bytes long, so another thread
+ * running the stub will either see the original instruction or the jmp, and
+ * anything after that is unchanged. Changing the target of a stub that's
+ * already been patched is just a store to the target address.
+ */
+#define ENTRY_TARGET_JMP_SIZE 6
+
+static void entry_store_uint64(char *ptr, uint64_t value)
+{
+    // An aligned 8-byte store is atomic on x86-64, so we only need to keep
+    // the compiler from splitting or reordering it.
+    assert(((uintptr_t) ptr) % sizeof(uint64_t) == 0);
+    __asm__ __volatile__("" : : : "memory");
+    *((uint64_t volatile *) ptr) = value;
+    __asm__ __volatile__("" : : : "memory");
+}
+
+int entry_set_target(int index, const void *target)
+{
+    char *entry = (char *) entry_get_patch_write_address(index);
+#if defined(ENTRY_COMPACT_STUBS)
+    char *targetAddr = (char *) &entry_compact_targets[index];
+    int32_t disp = (int32_t) (targetAddr
+            - ((char *) entry_get_public(index) + ENTRY_TARGET_JMP_SIZE));
+#else
+    int targetOffset = entry_stub_size - sizeof(uint64_t);
+    char *targetAddr = entry + targetOffset;
+    int32_t disp = targetOffset - ENTRY_TARGET_JMP_SIZE;
+#endif
+    uint64_t code;
+
+    // Fill in the target first, so that any thread that sees the new jmp
+    // instruction will also see the target.
+    entry_store_uint64(targetAddr, (uint64_t) (uintptr_t) target);
+
+    memcpy(&code, entry, sizeof(code));
+    ((unsigned char *) &code)[0] = 0xff;
+    ((unsigned char *) &code)[1] = 0x25;
+    memcpy(((unsigned char *) &code) + 2, &disp, sizeof(disp));
+    entry_store_uint64(entry, code);
+
+    return 1;
+}
+
+void entry_restore_targets(const void *saved)
+{
+    const char *src = (const char *) saved;
+    char *start = entry_get_write_start();
+    char *end = start + entry_get_size();
+    char *entry;
+
+    // Note that this only restores the jmp instruction. Another thread might
+    // be just about to read the target address, so that has to stay valid.
+    for (entry = start; entry < end;
+            entry += entry_stub_size, src += entry_stub_size) {
+        if (memcmp(entry, src, ENTRY_TARGET_JMP_SIZE) != 0) {
+            uint64_t code;
+            memcpy(&code, src, sizeof(code));
+            entry_store_uint64(entry, code);
+        }
+    }
+}
+#else
+int entry_set_target(int index, const void *target)
+{
+    return 0;
+}
+
+void entry_restore_targets(const void *saved)
+{
+    // Nothing to do here, since entry_set_target never changes anything.
+}
+#endif
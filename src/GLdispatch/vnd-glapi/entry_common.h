@@ -34,9 +34,47 @@
  * Common code for the x86-64 TLS, x86-64 TSD, and ARMv7 entrypoint stubs.
  */
 
+#include <stdint.h>
+
 #include "entry.h"
 
 extern char public_entry_start[];
 extern char public_entry_end[];
 
+/**
+ * Reserves the last 8 bytes of a stub for the address that
+ * \c entry_set_target jumps to.
+ *
+ * This goes at the end of \c STUB_ASM_CODE, and expects \c STUB_ASM_ENTRY to
+ * define the local label "9" at the start of the stub. If the code is too long
+ * to leave room for it, then the assembler will fail with an error about
+ * moving .org backwards.
+ */
+#define ENTRY_STUB_RESERVE_TARGET(stubSize) \
+    ".org 9b + " U_STRINGIFY(stubSize) " - 8\n\t" \
+    ".quad 0"
+
+#if defined(GLDISPATCH_COMPACT_TLS_STUBS) && defined(USE_X86_64_ASM) \
+    && !defined(__ILP32__)
+/**
+ * Defined if the stubs use the 16-byte x86-64 layout from entry_x86_64_tls.c.
+ *
+ * Those stubs don't have room to reserve their own target address, so the
+ * targets for \c entry_set_target are in \c entry_compact_targets instead,
+ * one for each stub.
+ */
+#define ENTRY_COMPACT_STUBS 1
+
+extern uint64_t entry_compact_targets[];
+#endif
+
+#if defined(GLDISPATCH_RUNTIME_TLS_STUBS) && defined(USE_X86_64_ASM) \
+    && !defined(GLDISPATCH_USE_TLS) && !defined(__ILP32__)
+/**
+ * Defined if the x86-64 TSD stubs can be switched to a fixed TLS offset at
+ * load time. See \c entry_init_static_tls in entry_x86_64_tsd.c.
+ */
+#define ENTRY_RUNTIME_TLS_STUBS 1
+#endif
+
 #endif // ENTRY_COMMON_H
@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+/**
+ * \file
+ *
+ * Call counting trampolines.
+ *
+ * There's one trampoline for each slot in the dispatch table. A trampoline
+ * loads its slot number and jumps to a common handler, which increments that
+ * slot's counter in the current counting table, and then jumps through the
+ * same slot in the counting table's target. The layout of a counting table is
+ * described in table.h.
+ *
+ * The handler only uses %r10 and %r11, so it doesn't need to save any of the
+ * function's arguments.
+ *
+ * The trampolines are only implemented for x86-64 with TLS. Otherwise,
+ * entry_get_count_trampoline returns NULL, and call counting isn't available.
+ */
+
+#include "entry.h"
+
+#include <stddef.h>
+
+#include "u_macros.h"
+#include "table.h"
+
+#if defined(USE_X86_64_ASM) && defined(GLDISPATCH_USE_TLS) && !defined(__ILP32__)
+
+#define COUNT_TRAMPOLINE_SIZE 16
+
+__asm__(".text\n"
+        ".balign 16\n"
+        ".globl entry_count_trampolines\n"
+        ".hidden entry_count_trampolines\n"
+        "entry_count_trampolines:\n"
+        ".set entry_count_slot, 0\n"
+        ".rept " U_STRINGIFY(MAPI_TABLE_NUM_SLOTS) "\n"
+        "movl $entry_count_slot, %r10d\n\t"
+        "jmp entry_count_common\n\t"
+        ".balign " U_STRINGIFY(COUNT_TRAMPOLINE_SIZE) "\n"
+        ".set entry_count_slot, entry_count_slot + 1\n"
+        ".endr\n"
+
+        // On entry, %r10d has the slot number. The current dispatch table is
+        // a counting table, so the target pointer comes right after its last
+        // entry, followed by the counters.
+        "entry_count_common:\n\t"
+        "movq _glapi_tls_Current@GOTTPOFF(%rip), %r11\n\t"
+        "movq %fs:(%r11), %r11\n\t"
+        "incq (8 * " U_STRINGIFY(MAPI_TABLE_NUM_ENTRIES) " + 8)(%r11,%r10,8)\n\t"
+        "movq (8 * " U_STRINGIFY(MAPI_TABLE_NUM_ENTRIES) ")(%r11), %r11\n\t"
+        "jmp *(%r11,%r10,8)\n"
+       );
+
+extern const char entry_count_trampolines[];
+
+mapi_func entry_get_count_trampoline(int slot)
+{
+    if (slot < 0 || slot >= MAPI_TABLE_NUM_SLOTS) {
+        return NULL;
+    }
+    return (mapi_func) (entry_count_trampolines + (slot * COUNT_TRAMPOLINE_SIZE));
+}
+
+#else // defined(USE_X86_64_ASM) && defined(GLDISPATCH_USE_TLS) && !defined(__ILP32__)
+
+mapi_func entry_get_count_trampoline(int slot)
+{
+    (void) slot;
+    return NULL;
+}
+
+#endif // defined(USE_X86_64_ASM) && defined(GLDISPATCH_USE_TLS) && !defined(__ILP32__)
@@ -32,6 +32,12 @@ MAPI_GLDISPATCH_ENTRY_FILES = entry_armv7_tsd.c
 MAPI_GLDISPATCH_ENTRY_FILES += entry_common.c
 endif
 
+if GLDISPATCH_TYPE_AARCH64_TLS
+MAPI_GLDISPATCH_ENTRY_FILES = entry_aarch64_tls.c
+MAPI_GLDISPATCH_ENTRY_FILES += entry_simple_asm.c
+MAPI_GLDISPATCH_ENTRY_FILES += entry_common.c
+endif
+
 if GLDISPATCH_TYPE_AARCH64_TSD
 MAPI_GLDISPATCH_ENTRY_FILES = entry_aarch64_tsd.c
 MAPI_GLDISPATCH_ENTRY_FILES += entry_simple_asm.c
@@ -50,6 +56,30 @@ MAPI_GLDISPATCH_ENTRY_FILES += entry_simple_asm.c
 MAPI_GLDISPATCH_ENTRY_FILES += entry_common.c
 endif
 
+if GLDISPATCH_TYPE_RISCV64_TLS
+MAPI_GLDISPATCH_ENTRY_FILES = entry_riscv64_tls.c
+MAPI_GLDISPATCH_ENTRY_FILES += entry_simple_asm.c
+MAPI_GLDISPATCH_ENTRY_FILES += entry_common.c
+endif
+
+if GLDISPATCH_TYPE_RISCV64_TSD
+MAPI_GLDISPATCH_ENTRY_FILES = entry_riscv64_tsd.c
+MAPI_GLDISPATCH_ENTRY_FILES += entry_simple_asm.c
+MAPI_GLDISPATCH_ENTRY_FILES += entry_common.c
+endif
+
+if GLDISPATCH_TYPE_LOONGARCH64_TLS
+MAPI_GLDISPATCH_ENTRY_FILES = entry_loongarch64_tls.c
+MAPI_GLDISPATCH_ENTRY_FILES += entry_simple_asm.c
+MAPI_GLDISPATCH_ENTRY_FILES += entry_common.c
+endif
+
+if GLDISPATCH_TYPE_LOONGARCH64_TSD
+MAPI_GLDISPATCH_ENTRY_FILES = entry_loongarch64_tsd.c
+MAPI_GLDISPATCH_ENTRY_FILES += entry_simple_asm.c
+MAPI_GLDISPATCH_ENTRY_FILES += entry_common.c
+endif
+
 if GLDISPATCH_TYPE_PURE_C
 MAPI_GLDISPATCH_ENTRY_FILES = entry_pure_c.c
 endif
@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+/**
+ * \file
+ *
+ * Resolver trampolines for lazily populated dispatch tables.
+ *
+ * There's one trampoline for each slot in the dispatch table. A trampoline
+ * loads its slot number and jumps to a common handler, which saves the
+ * argument registers, calls the resolver callback to look up the real
+ * function, and then jumps to that function with the original arguments.
+ *
+ * The trampolines are only implemented for x86-64. On other architectures,
+ * entry_get_lazy_trampoline returns NULL and dispatch tables are always
+ * populated up front.
+ */
+
+#include "entry.h"
+
+#include <stddef.h>
+
+#include "u_macros.h"
+#include "table.h"
+
+#if defined(USE_X86_64_ASM) && !defined(__ILP32__)
+
+#define LAZY_TRAMPOLINE_SIZE 16
+
+static entry_lazy_resolve_callback lazyResolveCallback = NULL;
+
+mapi_func entry_lazy_resolve(int slot);
+
+// This is only called from the assembly below, so mark it as used. Otherwise,
+// an LTO build would throw it away.
+__attribute__((used))
+mapi_func entry_lazy_resolve(int slot)
+{
+    // The callback is set before the first dispatch table is populated, so
+    // it's always set by the time any trampoline gets called.
+    return lazyResolveCallback(slot);
+}
+
+__asm__(".text\n"
+        ".balign 16\n"
+        ".globl entry_lazy_trampolines\n"
+        ".hidden entry_lazy_trampolines\n"
+        "entry_lazy_trampolines:\n"
+        ".set entry_lazy_slot, 0\n"
+        ".rept " U_STRINGIFY(MAPI_TABLE_NUM_SLOTS) "\n"
+        "movl $entry_lazy_slot, %r11d\n\t"
+        "jmp entry_lazy_common\n\t"
+        ".balign " U_STRINGIFY(LAZY_TRAMPOLINE_SIZE) "\n"
+        ".set entry_lazy_slot, entry_lazy_slot + 1\n"
+        ".endr\n"
+
+        // On entry, %r11d has the slot number, and the stack has the return
+        // address from the original call. Save everything that might hold an
+        // argument, including %rax for varargs functions.
+        "entry_lazy_common:\n\t"
+        "pushq %rbp\n\t"
+        "movq %rsp, %rbp\n\t"
+        "subq $192, %rsp\n\t"
+        "movaps %xmm0, 0(%rsp)\n\t"
+        "movaps %xmm1, 16(%rsp)\n\t"
+        "movaps %xmm2, 32(%rsp)\n\t"
+        "movaps %xmm3, 48(%rsp)\n\t"
+        "movaps %xmm4, 64(%rsp)\n\t"
+        "movaps %xmm5, 80(%rsp)\n\t"
+        "movaps %xmm6, 96(%rsp)\n\t"
+        "movaps %xmm7, 112(%rsp)\n\t"
+        "movq %rdi, 128(%rsp)\n\t"
+        "movq %rsi, 136(%rsp)\n\t"
+        "movq %rdx, 144(%rsp)\n\t"
+        "movq %rcx, 152(%rsp)\n\t"
+        "movq %r8, 160(%rsp)\n\t"
+        "movq %r9, 168(%rsp)\n\t"
+        "movq %rax, 176(%rsp)\n\t"
+        "movl %r11d, %edi\n\t"
+        "call entry_lazy_resolve\n\t"
+        "movq %rax, %r11\n\t"
+        "movaps 0(%rsp), %xmm0\n\t"
+        "movaps 16(%rsp), %xmm1\n\t"
+        "movaps 32(%rsp), %xmm2\n\t"
+        "movaps 48(%rsp), %xmm3\n\t"
+        "movaps 64(%rsp), %xmm4\n\t"
+        "movaps 80(%rsp), %xmm5\n\t"
+        "movaps 96(%rsp), %xmm6\n\t"
+        "movaps 112(%rsp), %xmm7\n\t"
+        "movq 128(%rsp), %rdi\n\t"
+        "movq 136(%rsp), %rsi\n\t"
+        "movq 144(%rsp), %rdx\n\t"
+        "movq 152(%rsp), %rcx\n\t"
+        "movq 160(%rsp), %r8\n\t"
+        "movq 168(%rsp), %r9\n\t"
+        "movq 176(%rsp), %rax\n\t"
+        "leave\n\t"
+        "jmp *%r11\n"
+       );
+
+extern const char entry_lazy_trampolines[];
+
+void entry_set_lazy_resolve_callback(entry_lazy_resolve_callback callback)
+{
+    lazyResolveCallback = callback;
+}
+
+mapi_func entry_get_lazy_trampoline(int slot)
+{
+    if (lazyResolveCallback == NULL || slot < 0 || slot >= MAPI_TABLE_NUM_SLOTS) {
+        return NULL;
+    }
+    return (mapi_func) (entry_lazy_trampolines + (slot * LAZY_TRAMPOLINE_SIZE));
+}
+
+#else // defined(USE_X86_64_ASM) && !defined(__ILP32__)
+
+void entry_set_lazy_resolve_callback(entry_lazy_resolve_callback callback)
+{
+    (void) callback;
+}
+
+mapi_func entry_get_lazy_trampoline(int slot)
+{
+    (void) slot;
+    return NULL;
+}
+
+#endif // defined(USE_X86_64_ASM) && !defined(__ILP32__)
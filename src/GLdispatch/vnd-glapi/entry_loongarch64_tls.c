@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+#include "entry.h"
+#include "entry_common.h"
+
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <assert.h>
+
+#include "glapi.h"
+#include "u_macros.h"
+#include "u_current.h"
+#include "utils_misc.h"
+#include "glvnd/GLdispatchABI.h"
+
+/*
+ * The size of each dispatch stub. This is the same as the TSD stubs, so that
+ * vendor libraries can patch either one the same way.
+ */
+#define ENTRY_STUB_ALIGN 64
+#if !defined(GLDISPATCH_PAGE_SIZE)
+// LoongArch Linux usually uses 16K pages, but it could be 4K or 64K. Pick
+// 64K, since that will work in any case.
+#define GLDISPATCH_PAGE_SIZE 65536
+#endif
+
+#define STUB_ASM_ENTRY(func)                        \
+    ".balign " U_STRINGIFY(ENTRY_STUB_ALIGN) "\n\t" \
+    ".global " func "\n\t"                          \
+    ".type " func ", %function\n\t"                 \
+    func ":\n\t"
+
+/*
+ * Looks up the current dispatch table from _glapi_tls_Current, finds the stub
+ * address at the given slot, then jumps to it.
+ *
+ * _glapi_tls_Current uses the initial-exec TLS model, so its offset from $tp
+ * is in the GOT. This only uses $t0 and $t1, which aren't used to pass
+ * arguments, so it doesn't need to save anything.
+ *
+ * The slot offset is loaded with li.d, since the immediate offset in an ld.d
+ * instruction can't reach every slot.
+ */
+#define STUB_ASM_CODE(slot)                                        \
+    "pcalau12i $t0, %ie_pc_hi20(_glapi_tls_Current)\n\t"           \
+    "ld.d $t0, $t0, %ie_pc_lo12(_glapi_tls_Current)\n\t"           \
+    "ldx.d $t0, $t0, $tp\n\t"                                      \
+    "li.d $t1, " slot " * 8\n\t" /* size of (void *) */            \
+    "ldx.d $t0, $t0, $t1\n\t"                                      \
+    "jr $t0\n\t"
+
+__asm__(".section wtext,\"ax\"\n"
+        ".balign " U_STRINGIFY(GLDISPATCH_PAGE_SIZE) "\n"
+       ".globl public_entry_start\n"
+       ".hidden public_entry_start\n"
+        "public_entry_start:\n");
+
+#define MAPI_TMP_STUB_ASM_GCC
+#include "mapi_tmp.h"
+
+__asm__(".balign " U_STRINGIFY(GLDISPATCH_PAGE_SIZE) "\n"
+       ".globl public_entry_end\n"
+       ".hidden public_entry_end\n"
+        "public_entry_end:\n"
+        ".text\n\t");
+
+const int entry_type = __GLDISPATCH_STUB_LOONGARCH64;
+const int entry_stub_size = ENTRY_STUB_ALIGN;
@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+#include "entry.h"
+#include "entry_common.h"
+
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <assert.h>
+
+#include "glapi.h"
+#include "u_macros.h"
+#include "u_current.h"
+#include "utils_misc.h"
+#include "glvnd/GLdispatchABI.h"
+
+/*
+ * The size of each dispatch stub.
+ */
+#define ENTRY_STUB_ALIGN 64
+#if !defined(GLDISPATCH_PAGE_SIZE)
+// LoongArch Linux usually uses 16K pages, but it could be 4K or 64K. Pick
+// 64K, since that will work in any case.
+#define GLDISPATCH_PAGE_SIZE 65536
+#endif
+
+#define STUB_ASM_ENTRY(func)                        \
+    ".balign " U_STRINGIFY(ENTRY_STUB_ALIGN) "\n\t" \
+    ".global " func "\n\t"                          \
+    ".type " func ", %function\n\t"                 \
+    func ":\n\t"
+
+/*
+ * Called from a stub with the slot offset in $t1 when
+ * _glapi_Current[GLAPI_CURRENT_DISPATCH] is NULL. This calls
+ * _glapi_get_current to find the dispatch table, then jumps to the function
+ * in it.
+ *
+ * This is shared by all of the stubs, since saving the argument registers
+ * wouldn't fit in each one.
+ */
+__asm__(".text\n"
+        ".balign 16\n"
+        "loongarch64_entry_lookup_dispatch:\n\t"
+        "addi.d $sp, $sp, -96\n\t"
+        "st.d $a0, $sp, 0\n\t"
+        "st.d $a1, $sp, 8\n\t"
+        "st.d $a2, $sp, 16\n\t"
+        "st.d $a3, $sp, 24\n\t"
+        "st.d $a4, $sp, 32\n\t"
+        "st.d $a5, $sp, 40\n\t"
+        "st.d $a6, $sp, 48\n\t"
+        "st.d $a7, $sp, 56\n\t"
+        "st.d $ra, $sp, 64\n\t"
+        "st.d $t1, $sp, 72\n\t"
+        "bl _glapi_get_current\n\t"
+        "move $t0, $a0\n\t"
+        "ld.d $a0, $sp, 0\n\t"
+        "ld.d $a1, $sp, 8\n\t"
+        "ld.d $a2, $sp, 16\n\t"
+        "ld.d $a3, $sp, 24\n\t"
+        "ld.d $a4, $sp, 32\n\t"
+        "ld.d $a5, $sp, 40\n\t"
+        "ld.d $a6, $sp, 48\n\t"
+        "ld.d $a7, $sp, 56\n\t"
+        "ld.d $ra, $sp, 64\n\t"
+        "ld.d $t1, $sp, 72\n\t"
+        "addi.d $sp, $sp, 96\n\t"
+        "ldx.d $t0, $t0, $t1\n\t"
+        "jr $t0\n");
+
+/*
+ * Looks up the current dispatch table, finds the stub address at the given
+ * slot, then jumps to it.
+ *
+ * First tries to find a dispatch table in
+ * _glapi_Current[GLAPI_CURRENT_DISPATCH]. If that's NULL, then it jumps to
+ * loongarch64_entry_lookup_dispatch, which calls _glapi_get_current.
+ *
+ * This only uses $t0 and $t1, which aren't used to pass arguments.
+ */
+#define STUB_ASM_CODE(slot)                                  \
+    "pcalau12i $t0, %got_pc_hi20(_glapi_Current)\n\t"        \
+    "ld.d $t0, $t0, %got_pc_lo12(_glapi_Current)\n\t"        \
+    "ld.d $t0, $t0, 0\n\t"                                   \
+    "li.d $t1, " slot " * 8\n\t" /* size of (void *) */      \
+    "beqz $t0, 10f\n\t"                                      \
+    "ldx.d $t0, $t0, $t1\n\t"                                \
+    "jr $t0\n\t"                                             \
+    "10:\n\t"                                                \
+    "b loongarch64_entry_lookup_dispatch\n\t"
+
+__asm__(".section wtext,\"ax\"\n"
+        ".balign " U_STRINGIFY(GLDISPATCH_PAGE_SIZE) "\n"
+       ".globl public_entry_start\n"
+       ".hidden public_entry_start\n"
+        "public_entry_start:\n");
+
+#define MAPI_TMP_STUB_ASM_GCC
+#include "mapi_tmp.h"
+
+__asm__(".balign " U_STRINGIFY(GLDISPATCH_PAGE_SIZE) "\n"
+       ".globl public_entry_end\n"
+       ".hidden public_entry_end\n"
+        "public_entry_end:\n"
+        ".text\n\t");
+
+const int entry_type = __GLDISPATCH_STUB_LOONGARCH64;
+const int entry_stub_size = ENTRY_STUB_ALIGN;
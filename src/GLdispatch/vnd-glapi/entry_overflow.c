@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+/**
+ * \file
+ *
+ * Overflow stubs for dynamic functions past the static dynamic stubs.
+ *
+ * Once every dynamic stub in the static entrypoints is in use, any more
+ * dynamic stubs are generated at runtime, one block of
+ * MAPI_TABLE_OVERFLOW_CHUNK_SIZE stubs at a time. Each stub loads its index
+ * into %r11d and jumps to a common handler, which looks up the chunk for that
+ * index at the end of the current dispatch table and jumps to the function
+ * in it.
+ *
+ * A block is never changed or unmapped once it's generated, so the stubs stay
+ * valid even after the dynamic stubs are cleaned up, and a later stub with the
+ * same index just reuses it.
+ *
+ * The overflow stubs are only implemented for x86-64. On other architectures,
+ * entry_get_overflow returns NULL and the number of dynamic stubs is limited
+ * to MAPI_TABLE_NUM_DYNAMIC. There aren't any overflow stubs with
+ * GLDISPATCH_STATIC_STUBS_ONLY, either.
+ */
+
+#include "entry.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "u_macros.h"
+#include "table.h"
+#include "glvnd_atomic.h"
+
+#if defined(USE_X86_64_ASM) && !defined(__ILP32__) && !defined(GLDISPATCH_STATIC_STUBS_ONLY)
+
+#define OVERFLOW_STUB_SIZE 32
+#define OVERFLOW_BLOCK_SIZE (MAPI_TABLE_OVERFLOW_CHUNK_SIZE * OVERFLOW_STUB_SIZE)
+
+const int entry_overflow_stub_size = OVERFLOW_STUB_SIZE;
+
+// On entry, %r11d has the overflow index. Like the static stubs, this only
+// uses %rax, %r10, and %r11, so it doesn't need to save any arguments except
+// when it has to call _glapi_get_current.
+__asm__(".text\n"
+        ".balign 16\n"
+        ".globl entry_overflow_common\n"
+        ".hidden entry_overflow_common\n"
+        "entry_overflow_common:\n\t"
+#if defined(GLDISPATCH_USE_TLS)
+        "movq _glapi_tls_Current@GOTTPOFF(%rip), %rax\n\t"
+        "movq %fs:(%rax), %rax\n\t"
+#else
+        "movq _glapi_Current@GOTPCREL(%rip), %rax\n\t"
+        "movq (%rax), %rax\n\t"
+        "test %rax, %rax\n\t"
+        "jne 1f\n\t"
+        "push %rdi\n\t"
+        "push %rsi\n\t"
+        "push %rdx\n\t"
+        "push %rcx\n\t"
+        "push %r8\n\t"
+        "push %r9\n\t"
+        "push %r11\n\t"
+        "call _glapi_get_current@PLT\n\t"
+        "pop %r11\n\t"
+        "pop %r9\n\t"
+        "pop %r8\n\t"
+        "pop %rcx\n\t"
+        "pop %rdx\n\t"
+        "pop %rsi\n\t"
+        "pop %rdi\n"
+        "1:\n\t"
+#endif
+        "movl %r11d, %r10d\n\t"
+        "shrl $" U_STRINGIFY(MAPI_TABLE_OVERFLOW_CHUNK_SHIFT) ", %r10d\n\t"
+        "movq (8 * " U_STRINGIFY(MAPI_TABLE_NUM_SLOTS) ")(%rax,%r10,8), %rax\n\t"
+        "andl $(" U_STRINGIFY(MAPI_TABLE_OVERFLOW_CHUNK_SIZE) " - 1), %r11d\n\t"
+        "jmp *(%rax,%r11,8)\n"
+       );
+
+extern const char entry_overflow_common[];
+
+static char * volatile overflowBlocks[MAPI_TABLE_NUM_OVERFLOW_CHUNKS];
+
+/*
+ * Writes an overflow stub:
+ *
+ *   movl $index, %r11d         (41 bb imm32)
+ *   jmp *0(%rip)               (ff 25 00 00 00 00)
+ *   .quad entry_overflow_common
+ *
+ * The block might not be within 2GB of entry_overflow_common, so the handler
+ * address goes right after the jmp instead of in a rel32.
+ */
+static void WriteOverflowStub(unsigned char *code, int index)
+{
+    static const unsigned char MOV_R11D[] = { 0x41, 0xbb };
+    static const unsigned char JMP_RIP[] = { 0xff, 0x25, 0x00, 0x00, 0x00, 0x00 };
+    uint32_t imm = (uint32_t) index;
+    uint64_t target = (uint64_t) (uintptr_t) entry_overflow_common;
+
+    // Fill the rest of the stub with int3.
+    memset(code, 0xcc, OVERFLOW_STUB_SIZE);
+    memcpy(code, MOV_R11D, sizeof(MOV_R11D));
+    memcpy(code + 2, &imm, sizeof(imm));
+    memcpy(code + 6, JMP_RIP, sizeof(JMP_RIP));
+    memcpy(code + 12, &target, sizeof(target));
+}
+
+static char *GenerateOverflowBlock(int block)
+{
+    char *code;
+    int i;
+
+    code = mmap(NULL, OVERFLOW_BLOCK_SIZE, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (code == MAP_FAILED) {
+        return NULL;
+    }
+
+    for (i=0; i<MAPI_TABLE_OVERFLOW_CHUNK_SIZE; i++) {
+        WriteOverflowStub((unsigned char *) (code + (i * OVERFLOW_STUB_SIZE)),
+                (block * MAPI_TABLE_OVERFLOW_CHUNK_SIZE) + i);
+    }
+
+    if (mprotect(code, OVERFLOW_BLOCK_SIZE, PROT_READ | PROT_EXEC) != 0) {
+        munmap(code, OVERFLOW_BLOCK_SIZE);
+        return NULL;
+    }
+    return code;
+}
+
+mapi_func entry_get_overflow(int index)
+{
+    int block;
+    char *code;
+
+    if (index < 0 || index >= MAPI_TABLE_NUM_OVERFLOW) {
+        return NULL;
+    }
+
+    block = index / MAPI_TABLE_OVERFLOW_CHUNK_SIZE;
+    code = glvndAtomicLoadAcquirePtr((void * volatile *) &overflowBlocks[block]);
+    if (code == NULL) {
+        code = GenerateOverflowBlock(block);
+        if (code == NULL) {
+            return NULL;
+        }
+        glvndAtomicStoreReleasePtr((void * volatile *) &overflowBlocks[block], code);
+    }
+
+    return (mapi_func) (code
+            + ((index % MAPI_TABLE_OVERFLOW_CHUNK_SIZE) * OVERFLOW_STUB_SIZE));
+}
+
+#else // defined(USE_X86_64_ASM) && !defined(__ILP32__) && !defined(GLDISPATCH_STATIC_STUBS_ONLY)
+
+const int entry_overflow_stub_size = 0;
+
+mapi_func entry_get_overflow(int index)
+{
+    (void) index;
+    return NULL;
+}
+
+#endif // defined(USE_X86_64_ASM) && !defined(__ILP32__) && !defined(GLDISPATCH_STATIC_STUBS_ONLY)
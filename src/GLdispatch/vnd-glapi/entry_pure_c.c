@@ -44,6 +44,24 @@ entry_current_get(void)
 #endif
 }
 
+/*
+ * Each stub returns the result of the vendor's function, so that the
+ * compiler can turn the call into a jump. With the musttail attribute, that's
+ * guaranteed even without optimization. Otherwise, GCC and clang still do it
+ * at -O2, since the stub passes its arguments through unchanged.
+ *
+ * Note that a void stub also uses "return", which C only allows as an
+ * extension, but musttail requires it.
+ */
+#if defined(__has_attribute)
+#if __has_attribute(musttail)
+#define MAPI_TAIL_CALL __attribute__((musttail)) return
+#endif
+#endif
+#if !defined(MAPI_TAIL_CALL)
+#define MAPI_TAIL_CALL return
+#endif
+
 /* C version of the public entries */
 #define MAPI_TMP_DEFINES
 #define MAPI_TMP_PUBLIC_DECLARES
@@ -82,6 +100,12 @@ void *entry_get_patch_address(int index)
     return NULL;
 }
 
+void *entry_get_patch_write_address(int index)
+{
+    assert(!"This should never be called");
+    return NULL;
+}
+
 void *entry_save_entrypoints(void)
 {
     assert(!"This should never be called");
@@ -92,3 +116,23 @@ void entry_restore_entrypoints(void *saved)
 {
     assert(!"This should never be called");
 }
+
+void entry_prewarm(int lock)
+{
+}
+
+int entry_init_static_tls(const void **current)
+{
+    return 0;
+}
+
+int entry_set_target(int index, const void *target)
+{
+    assert(!"This should never be called");
+    return 0;
+}
+
+void entry_restore_targets(const void *saved)
+{
+    assert(!"This should never be called");
+}
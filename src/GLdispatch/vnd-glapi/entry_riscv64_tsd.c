@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+#include "entry.h"
+#include "entry_common.h"
+
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <assert.h>
+
+#include "glapi.h"
+#include "u_macros.h"
+#include "u_current.h"
+#include "utils_misc.h"
+#include "glvnd/GLdispatchABI.h"
+
+/*
+ * The size of each dispatch stub.
+ */
+#define ENTRY_STUB_ALIGN 64
+#if !defined(GLDISPATCH_PAGE_SIZE)
+#define GLDISPATCH_PAGE_SIZE 4096
+#endif
+
+#define STUB_ASM_ENTRY(func)                        \
+    ".balign " U_STRINGIFY(ENTRY_STUB_ALIGN) "\n\t" \
+    ".global " func "\n\t"                          \
+    ".type " func ", %function\n\t"                 \
+    func ":\n\t"
+
+/*
+ * Called from a stub with the slot offset in t2 when
+ * _glapi_Current[GLAPI_CURRENT_DISPATCH] is NULL. This calls
+ * _glapi_get_current to find the dispatch table, then jumps to the function
+ * in it.
+ *
+ * This is shared by all of the stubs, since saving the argument registers
+ * wouldn't fit in each one.
+ */
+__asm__(".text\n"
+        ".balign 16\n"
+        "riscv64_entry_lookup_dispatch:\n\t"
+        "addi sp, sp, -96\n\t"
+        "sd a0, 0(sp)\n\t"
+        "sd a1, 8(sp)\n\t"
+        "sd a2, 16(sp)\n\t"
+        "sd a3, 24(sp)\n\t"
+        "sd a4, 32(sp)\n\t"
+        "sd a5, 40(sp)\n\t"
+        "sd a6, 48(sp)\n\t"
+        "sd a7, 56(sp)\n\t"
+        "sd ra, 64(sp)\n\t"
+        "sd t2, 72(sp)\n\t"
+        "call _glapi_get_current\n\t"
+        "mv t1, a0\n\t"
+        "ld a0, 0(sp)\n\t"
+        "ld a1, 8(sp)\n\t"
+        "ld a2, 16(sp)\n\t"
+        "ld a3, 24(sp)\n\t"
+        "ld a4, 32(sp)\n\t"
+        "ld a5, 40(sp)\n\t"
+        "ld a6, 48(sp)\n\t"
+        "ld a7, 56(sp)\n\t"
+        "ld ra, 64(sp)\n\t"
+        "ld t2, 72(sp)\n\t"
+        "addi sp, sp, 96\n\t"
+        "add t1, t1, t2\n\t"
+        "ld t1, 0(t1)\n\t"
+        "jr t1\n");
+
+/*
+ * Looks up the current dispatch table, finds the stub address at the given
+ * slot, then jumps to it.
+ *
+ * First tries to find a dispatch table in
+ * _glapi_Current[GLAPI_CURRENT_DISPATCH]. If that's NULL, then it jumps to
+ * riscv64_entry_lookup_dispatch, which calls _glapi_get_current.
+ *
+ * This only uses t1 and t2, which aren't used to pass arguments.
+ */
+#define STUB_ASM_CODE(slot)                              \
+    "1:\n\t"                                             \
+    "auipc t1, %got_pcrel_hi(_glapi_Current)\n\t"        \
+    "ld t1, %pcrel_lo(1b)(t1)\n\t"                       \
+    "ld t1, 0(t1)\n\t"                                   \
+    "li t2, " slot " * 8\n\t" /* size of (void *) */     \
+    "beqz t1, 10f\n\t"                                   \
+    "add t1, t1, t2\n\t"                                 \
+    "ld t1, 0(t1)\n\t"                                   \
+    "jr t1\n\t"                                          \
+    "10:\n\t"                                            \
+    "tail riscv64_entry_lookup_dispatch\n\t"
+
+/*
+ * The stubs are found by index, so turn off linker relaxation, which could
+ * otherwise change their size.
+ */
+__asm__(".section wtext,\"ax\"\n"
+        ".option push\n"
+        ".option norelax\n"
+        ".balign " U_STRINGIFY(GLDISPATCH_PAGE_SIZE) "\n"
+       ".globl public_entry_start\n"
+       ".hidden public_entry_start\n"
+        "public_entry_start:\n");
+
+#define MAPI_TMP_STUB_ASM_GCC
+#include "mapi_tmp.h"
+
+__asm__(".balign " U_STRINGIFY(GLDISPATCH_PAGE_SIZE) "\n"
+       ".globl public_entry_end\n"
+       ".hidden public_entry_end\n"
+        "public_entry_end:\n"
+        ".option pop\n"
+        ".text\n\t");
+
+const int entry_type = __GLDISPATCH_STUB_RISCV64;
+const int entry_stub_size = ENTRY_STUB_ALIGN;
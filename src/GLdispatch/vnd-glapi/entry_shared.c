@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+/**
+ * \file
+ *
+ * Entrypoints for a client library built with --enable-shared-entrypoints.
+ *
+ * Instead of having its own copy of the dispatch stubs, each GL function in
+ * the library is an IFUNC that resolves to libGLdispatch's stub for the same
+ * dispatch table slot. Every client library then calls through the same
+ * stubs, and there's only one set of stubs for a vendor library to patch.
+ *
+ * Since there aren't any stubs here, the patching functions are never called.
+ * stub_get_patch_callbacks returns NULL because entry_stub_size is zero.
+ */
+
+#include "entry.h"
+#include <assert.h>
+#include <stdlib.h>
+
+#include "glapi.h"
+#include "GLdispatch.h"
+#include "glvnd/GLdispatchABI.h"
+
+#define MAPI_TMP_DEFINES
+#define MAPI_TMP_SHARED_ENTRIES
+#include "mapi_tmp.h"
+
+const int entry_type = __GLDISPATCH_STUB_UNKNOWN;
+const int entry_stub_size = 0;
+
+mapi_func
+entry_get_public(int index)
+{
+    return NULL;
+}
+
+int entry_patch_start(void)
+{
+    assert(!"This should never be called");
+    return 0;
+}
+
+int entry_patch_finish(void)
+{
+    assert(!"This should never be called");
+    return 0;
+}
+
+void *entry_get_patch_address(int index)
+{
+    assert(!"This should never be called");
+    return NULL;
+}
+
+void *entry_get_patch_write_address(int index)
+{
+    assert(!"This should never be called");
+    return NULL;
+}
+
+void *entry_save_entrypoints(void)
+{
+    assert(!"This should never be called");
+    return NULL;
+}
+
+void entry_restore_entrypoints(void *saved)
+{
+    assert(!"This should never be called");
+}
+
+void entry_prewarm(int lock)
+{
+}
+
+int entry_init_static_tls(const void **current)
+{
+    return 0;
+}
+
+int entry_set_target(int index, const void *target)
+{
+    assert(!"This should never be called");
+    return 0;
+}
+
+void entry_restore_targets(const void *saved)
+{
+    assert(!"This should never be called");
+}
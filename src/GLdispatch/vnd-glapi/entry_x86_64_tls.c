@@ -32,17 +32,47 @@
 #include <sys/mman.h>
 #include <unistd.h>
 #include <string.h>
+#include <stdint.h>
 
 #include "utils_misc.h"
 #include "u_macros.h"
 #include "glapi.h"
+#include "table.h"
 #include "glvnd/GLdispatchABI.h"
 
+#if defined(ENTRY_COMPACT_STUBS)
+#define ENTRY_STUB_ALIGN 16
+#else
 #define ENTRY_STUB_ALIGN 32
+#endif
 #if !defined(GLDISPATCH_PAGE_SIZE)
 #define GLDISPATCH_PAGE_SIZE 4096
 #endif
 
+#if defined(ENTRY_COMPACT_STUBS)
+/*
+ * With the compact layout, each stub only loads its slot number into %r11d
+ * and jumps here, which looks up the current dispatch table and jumps to the
+ * function in it. That cuts the stubs down to 16 bytes, so that the hot ones
+ * take up half as many cache lines and pages:
+ *
+ *   movl $slot, %r11d          (41 bb imm32)
+ *   jmp entry_compact_common   (e9 rel32)
+ *
+ * The first instruction is 6 bytes, so entry_set_target can still replace
+ * it with a jmp in one store. The target addresses don't fit in the stubs,
+ * so they go in entry_compact_targets.
+ */
+__asm__(".text\n"
+        ".balign 16\n"
+        "entry_compact_common:\n\t"
+        "movq _glapi_tls_Current@GOTTPOFF(%rip), %rax\n\t"
+        "movq %fs:(%rax), %rax\n\t"
+        "jmp *(%rax,%r11,8)\n");
+
+uint64_t entry_compact_targets[MAPI_TABLE_NUM_SLOTS];
+#endif // defined(ENTRY_COMPACT_STUBS)
+
 __asm__(".section wtext,\"ax\",@progbits\n");
 __asm__(".balign " U_STRINGIFY(GLDISPATCH_PAGE_SIZE) "\n"
        ".globl public_entry_start\n"
@@ -53,7 +83,8 @@ __asm__(".balign " U_STRINGIFY(GLDISPATCH_PAGE_SIZE) "\n"
     ".globl " func "\n"                                   \
     ".type " func ", @function\n"                         \
     ".balign " U_STRINGIFY(ENTRY_STUB_ALIGN) "\n" \
-    func ":"
+    func ":\n"                                             \
+    "9:"
 
 #ifdef __ILP32__
 
@@ -61,14 +92,22 @@ __asm__(".balign " U_STRINGIFY(GLDISPATCH_PAGE_SIZE) "\n"
     "movq _glapi_tls_Current@GOTTPOFF(%rip), %rax\n\t"  \
     "movl %fs:(%rax), %r11d\n\t"                          \
     "movl 4*" slot "(%r11d), %r11d\n\t"                   \
-    "jmp *%r11"
+    "jmp *%r11\n\t"                                      \
+    ENTRY_STUB_RESERVE_TARGET(ENTRY_STUB_ALIGN)
+
+#elif defined(ENTRY_COMPACT_STUBS)
+
+#define STUB_ASM_CODE(slot)                                 \
+    "movl $" slot ", %r11d\n\t"                             \
+    "jmp entry_compact_common\n\t"
 
 #else // __ILP32__
 
 #define STUB_ASM_CODE(slot)                                 \
     "movq _glapi_tls_Current@GOTTPOFF(%rip), %rax\n\t"  \
     "movq %fs:(%rax), %r11\n\t"                              \
-    "jmp *(8 * " slot ")(%r11)"
+    "jmp *(8 * " slot ")(%r11)\n\t"                          \
+    ENTRY_STUB_RESERVE_TARGET(ENTRY_STUB_ALIGN)
 
 #endif // __ILP32__
 
@@ -84,6 +123,67 @@ __asm__(".text\n");
 
 const int entry_stub_size = ENTRY_STUB_ALIGN;
 
+#if defined(GLDISPATCH_DIRECT_TLS_STUBS) && defined(USE_ATTRIBUTE_CONSTRUCTOR) \
+    && !defined(__ILP32__) && !defined(ENTRY_COMPACT_STUBS)
+/*
+ * Rewrites each stub to load the dispatch table from a fixed %fs offset.
+ *
+ * libGLdispatch is a shared library, so the assembler can't encode the TLS
+ * offset of _glapi_tls_Current directly. Instead, each stub loads it from the
+ * GOT. But _glapi_tls_Current uses the initial-exec model, so that offset
+ * can't change once the library is loaded, and we can write it into each
+ * stub. That turns the first two instructions of each stub:
+ *
+ *   movq _glapi_tls_Current@GOTTPOFF(%rip), %rax  (48 8b 05 rel32)
+ *   movq %fs:(%rax), %r11                         (64 4c 8b 18)
+ *
+ * into:
+ *
+ *   movq %fs:offset, %r11                         (64 4c 8b 1c 25 disp32)
+ *   xchg %ax, %ax                                 (66 90)
+ *
+ * The jmp instruction that follows doesn't change.
+ *
+ * If we can't make the stubs writable, then they're left alone.
+ */
+static void __attribute__((constructor)) entry_init_direct_tls(void)
+{
+    static const unsigned char GOT_LOAD[] = { 0x48, 0x8b, 0x05 };
+    static const unsigned char FS_LOAD[] = { 0x64, 0x4c, 0x8b, 0x18 };
+    static const unsigned char FS_DIRECT_LOAD[] = { 0x64, 0x4c, 0x8b, 0x1c, 0x25 };
+    static const unsigned char NOP2[] = { 0x66, 0x90 };
+    intptr_t offset;
+    int32_t disp;
+    int count = (public_entry_end - public_entry_start) / entry_stub_size;
+    int i;
+
+    __asm__("movq _glapi_tls_Current@GOTTPOFF(%%rip), %0" : "=r" (offset));
+    disp = (int32_t) offset;
+    if ((intptr_t) disp != offset) {
+        return;
+    }
+
+    if (!entry_patch_start()) {
+        return;
+    }
+
+    for (i = 0; i < count; i++) {
+        unsigned char *code = (unsigned char *) entry_get_patch_write_address(i);
+
+        if (memcmp(code, GOT_LOAD, sizeof(GOT_LOAD)) != 0
+                || memcmp(code + 7, FS_LOAD, sizeof(FS_LOAD)) != 0) {
+            continue;
+        }
+
+        memcpy(code, FS_DIRECT_LOAD, sizeof(FS_DIRECT_LOAD));
+        memcpy(code + 5, &disp, sizeof(disp));
+        memcpy(code + 9, NOP2, sizeof(NOP2));
+    }
+
+    entry_patch_finish();
+}
+#endif // GLDISPATCH_DIRECT_TLS_STUBS
+
 #ifdef __ILP32__
 
 const int entry_type = __GLDISPATCH_STUB_X32;
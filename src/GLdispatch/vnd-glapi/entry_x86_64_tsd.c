@@ -55,7 +55,8 @@ __asm__(".balign " U_STRINGIFY(GLDISPATCH_PAGE_SIZE) "\n"
     ".globl " func "\n"              \
     ".type " func ", @function\n"    \
     ".balign " U_STRINGIFY(ENTRY_STUB_ALIGN) "\n"                   \
-    func ":"
+    func ":\n"                                                       \
+    "9:"
 
 /*
  * Note that this stub does not exactly match the machine code in
@@ -87,7 +88,8 @@ __asm__(".balign " U_STRINGIFY(GLDISPATCH_PAGE_SIZE) "\n"
     "pop %rsi\n" \
     "pop %rdi\n" \
     "1:\n\t"                         \
-    "jmp *(8 * " slot ")(%rax)"
+    "jmp *(8 * " slot ")(%rax)\n\t" \
+    ENTRY_STUB_RESERVE_TARGET(ENTRY_STUB_ALIGN)
 
 #define MAPI_TMP_STUB_ASM_GCC
 #include "mapi_tmp.h"
@@ -102,3 +104,74 @@ __asm__(".text\n");
 const int entry_type = __GLDISPATCH_STUB_X86_64;
 const int entry_stub_size = ENTRY_STUB_ALIGN;
 
+
+#if defined(ENTRY_RUNTIME_TLS_STUBS)
+/*
+ * Each stub starts with:
+ *
+ *   movq _glapi_Current@GOTPCREL(%rip), %rax  (48 8b 05 rel32)
+ *   movq (%rax), %rax                         (48 8b 00)
+ *   test %rax, %rax                           (48 85 c0)
+ *   jne 1f                                    (75 rel8)
+ *
+ * The linker may turn the first instruction into a lea (48 8d 05 rel32).
+ *
+ * If the current dispatch table is in static TLS, then we can skip both
+ * _glapi_Current and the call to _glapi_get_current, and turn that into:
+ *
+ *   movq %fs:offset, %rax                     (64 48 8b 04 25 disp32)
+ *   nopl 0(%rax)                              (0f 1f 40 00)
+ *   jmp 1f                                    (eb rel8)
+ *
+ * The jmp ends up at the same address as the jne, so it keeps the same
+ * displacement.
+ */
+int entry_init_static_tls(const void **current)
+{
+    static const unsigned char GOT_LOAD[] = { 0x48, 0x8b, 0x05 };
+    static const unsigned char GOT_LEA[] = { 0x48, 0x8d, 0x05 };
+    static const unsigned char CHECK_CURRENT[] = {
+        0x48, 0x8b, 0x00, 0x48, 0x85, 0xc0, 0x75
+    };
+    static const unsigned char FS_DIRECT_LOAD[] = { 0x64, 0x48, 0x8b, 0x04, 0x25 };
+    static const unsigned char NOP4[] = { 0x0f, 0x1f, 0x40, 0x00 };
+    uintptr_t tp;
+    intptr_t offset;
+    int32_t disp;
+    int count = (public_entry_end - public_entry_start) / entry_stub_size;
+    int rewritten = 0;
+    int i;
+
+    __asm__("movq %%fs:0, %0" : "=r" (tp));
+    offset = (intptr_t) ((uintptr_t) current - tp);
+    disp = (int32_t) offset;
+    if ((intptr_t) disp != offset) {
+        return 0;
+    }
+
+    if (!entry_patch_start()) {
+        return 0;
+    }
+
+    for (i = 0; i < count; i++) {
+        unsigned char *code = (unsigned char *) entry_get_patch_write_address(i);
+
+        if ((memcmp(code, GOT_LOAD, sizeof(GOT_LOAD)) != 0
+                    && memcmp(code, GOT_LEA, sizeof(GOT_LEA)) != 0)
+                || memcmp(code + 7, CHECK_CURRENT, sizeof(CHECK_CURRENT)) != 0) {
+            continue;
+        }
+
+        memcpy(code, FS_DIRECT_LOAD, sizeof(FS_DIRECT_LOAD));
+        memcpy(code + 5, &disp, sizeof(disp));
+        memcpy(code + 9, NOP4, sizeof(NOP4));
+        code[13] = 0xeb;
+        rewritten++;
+    }
+
+    // The last page is padded out past the last stub, so not everything in
+    // the range is a stub.
+    entry_patch_finish();
+    return (rewritten > 0);
+}
+#endif // defined(ENTRY_RUNTIME_TLS_STUBS)
@@ -45,6 +45,7 @@
 #define _GLAPI_H
 
 #include <stddef.h>
+#include <stdint.h>
 #include <GL/gl.h>
 #include "u_compiler.h"
 
@@ -77,6 +78,14 @@ struct _glapi_table;
 
 enum {
     GLAPI_CURRENT_DISPATCH = 0, /* This MUST be the first entry! */
+
+    /**
+     * The vendor's handle for the current context, or NULL if there's no
+     * current context. This is part of the ABI, so a vendor library can read
+     * it from _glapi_tls_Current or _glapi_Current without a separate TLS
+     * lookup of its own. See \c __glDispatchSetCurrentVendorContext.
+     */
+    GLAPI_CURRENT_VENDOR_CONTEXT = 1,
     GLAPI_NUM_CURRENT_ENTRIES
 };
 
@@ -84,7 +93,8 @@ enum {
 #if defined (GLDISPATCH_USE_TLS)
 
 /**
- * A pointer to each thread's dispatch table.
+ * A pointer to each thread's dispatch table, followed by the rest of the
+ * GLAPI_CURRENT_* entries.
  */
 _GLAPI_EXPORT extern const __thread void *
     _glapi_tls_Current[GLAPI_NUM_CURRENT_ENTRIES]
@@ -101,7 +111,9 @@ _GLAPI_EXPORT extern const __thread void *
  * dispatch table from this variable, so that they avoid the overhead of
  * calling pthread_getspecific.
  *
- * With a multithreaded app, this variable will contain NULL.
+ * With a multithreaded app, this variable will contain NULL, and the
+ * vendor context has to be looked up with
+ * \c __glDispatchGetCurrentVendorContext instead.
  */
 _GLAPI_EXPORT extern const void *_glapi_Current[GLAPI_NUM_CURRENT_ENTRIES];
 
@@ -112,6 +124,30 @@ _GLAPI_EXPORT extern const void *_glapi_Current[GLAPI_NUM_CURRENT_ENTRIES];
 void
 _glapi_init(void);
 
+/**
+ * Picks the no-op functions to use when no dispatch table is current.
+ *
+ * This is called once when libGLdispatch is loaded, before anything else can
+ * call into the dispatch stubs.
+ *
+ * \param reportErrors If non-zero, the no-op functions will report an error.
+ */
+void
+_glapi_init_noop(int reportErrors);
+
+/**
+ * Switches the dispatch stubs to read the current dispatch table from a fixed
+ * TLS offset, if libGLdispatch was built with --enable-runtime-tls and its
+ * TLS block is in static TLS.
+ *
+ * This must be called from libGLdispatch's constructor, before anything
+ * touches the current dispatch table.
+ *
+ * \return Non-zero if the stubs now use a fixed TLS offset.
+ */
+int
+_glapi_init_static_tls(void);
+
 void
 _glapi_destroy(void);
 
@@ -141,10 +177,128 @@ _glapi_set_current(const struct _glapi_table *dispatch);
 _GLAPI_EXPORT const struct _glapi_table *
 _glapi_get_current(void);
 
+/**
+ * Sets the vendor context pointer for the current thread.
+ */
+void
+_glapi_set_current_vendor_context(const void *context);
 
+/**
+ * Returns the vendor context pointer for the current thread.
+ */
+const void *
+_glapi_get_current_vendor_context(void);
+
+
+/**
+ * Returns the size of a dispatch table, as a number of pointers.
+ *
+ * This includes the slots for the static and dynamic stubs, followed by the
+ * pointers to the chunks for any overflow stubs past those.
+ */
 unsigned int
 _glapi_get_dispatch_table_size(void);
 
+/**
+ * Returns the number of stubs that have a slot of their own in the dispatch
+ * table. Any stubs past this are overflow stubs, which go through the overflow
+ * chunks instead.
+ */
+unsigned int
+_glapi_get_dispatch_table_slot_count(void);
+
+/**
+ * Returns the number of static stubs. Those always come first in the dispatch
+ * table, and their slots are the same in every process.
+ */
+unsigned int
+_glapi_get_static_stub_count(void);
+
+/**
+ * Returns a hash of the static function names in slot order. See
+ * generate_layout_hash in gen_gldispatch_mapi.py.
+ */
+uint32_t
+_glapi_get_static_layout_hash(void);
+
+/**
+ * Returns the most stubs that can exist, including every dynamic and overflow
+ * stub.
+ */
+unsigned int
+_glapi_get_max_stub_count(void);
+
+/**
+ * Points each overflow chunk pointer in a newly allocated dispatch table at
+ * the chunk of no-op functions.
+ */
+void
+_glapi_init_table_overflow(struct _glapi_table *table);
+
+/**
+ * Returns a pointer to the entry for an overflow stub in a dispatch table.
+ *
+ * If the table doesn't have a chunk for that stub yet, then this allocates
+ * one, with every entry set to a no-op function. The caller must hold the
+ * dispatch lock, and the part of the table with the chunk pointers must be
+ * writable.
+ *
+ * \param table The dispatch table.
+ * \param offset The offset of the stub, which must be at least
+ * \c _glapi_get_dispatch_table_slot_count.
+ * \return A pointer to the entry, or \c NULL if we couldn't allocate a chunk.
+ */
+void **
+_glapi_get_table_overflow_entry(struct _glapi_table *table, int offset);
+
+/**
+ * Frees the overflow chunks of a dispatch table.
+ */
+void
+_glapi_free_table_overflow(struct _glapi_table *table);
+
+/**
+ * Allocates a call counting table.
+ *
+ * A counting table can be made current in place of a real dispatch table.
+ * Each slot points to a trampoline that increments a counter for that slot
+ * and then jumps through the same slot of the table's target, which is set
+ * with \c _glapi_set_count_table_target.
+ *
+ * The counters are incremented without any atomics or locking, so each
+ * thread should make its own counting table current.
+ *
+ * \return The new table, or \c NULL if allocation failed or call counting
+ * isn't supported with this build.
+ */
+struct _glapi_table *
+_glapi_create_count_table(void);
+
+/**
+ * Frees a counting table from \c _glapi_create_count_table.
+ */
+void
+_glapi_destroy_count_table(struct _glapi_table *table);
+
+/**
+ * Sets the dispatch table that a counting table forwards each call to.
+ *
+ * This also copies the overflow chunk pointers from \p target, so it has to
+ * be called again after any new chunks are allocated in \p target. If
+ * \p target is NULL, then the overflow stubs go to the no-op functions. The
+ * slots must not be called in that case.
+ */
+void
+_glapi_set_count_table_target(struct _glapi_table *table,
+                              const struct _glapi_table *target);
+
+/**
+ * Returns the array of call counters in a counting table. There's one
+ * counter for each slot, up to \c _glapi_get_dispatch_table_slot_count.
+ */
+const uint64_t *
+_glapi_get_count_table_counts(const struct _glapi_table *table);
+
 
 int
 _glapi_get_proc_offset(const char *funcName);
@@ -153,14 +307,50 @@ _glapi_get_proc_offset(const char *funcName);
 _glapi_proc
 _glapi_get_proc_address(const char *funcName);
 
+/**
+ * Looks up an existing stub. Unlike \c _glapi_get_proc_address, this will
+ * never generate a new dynamic stub, so it's safe to call without holding the
+ * dispatch lock.
+ *
+ * \param funcName The name of the function.
+ * \param[out] offset Returns the dispatch table offset of the stub.
+ * \return The address of the stub, or \c NULL if it doesn't exist yet.
+ */
+_glapi_proc
+_glapi_find_proc_address(const char *funcName, int *offset);
+
 
 const char *
 _glapi_get_proc_name(unsigned int offset);
 
+/**
+ * Returns the address and size of the code for the stub at a dispatch table
+ * offset, for tools that need to put a name on it.
+ *
+ * \param offset The offset of an existing stub.
+ * \param[out] size Returns the size of the stub in bytes, or zero if the
+ *      stubs are in C and don't have a fixed size.
+ * \return The address of the stub.
+ */
+_glapi_proc
+_glapi_get_stub_code(unsigned int offset, int *size);
+
+/**
+ * Returns the static stub for a dispatch table slot.
+ *
+ * This doesn't need \c _glapi_init or the dispatch lock, so it's safe to call
+ * from an IFUNC resolver while the dynamic linker is still loading things.
+ *
+ * \param slot The dispatch table slot.
+ * \return The stub, or \c NULL if \p slot isn't a static slot.
+ */
+_glapi_proc
+_glapi_get_public_stub(int slot);
+
 /**
  * Returns the total number of defined stubs. This count only includes dynamic
  * stubs that have been generated, so it will always be less than or equal to
- * the size of the dispatch table.
+ * the number of static and dynamic slots, plus the number of overflow stubs.
  */
 int _glapi_get_stub_count(void);
 
@@ -229,6 +419,30 @@ typedef struct __GLdispatchStubPatchCallbacksRec {
      */
     int (* getStubSize) (void);
 
+    /**
+     * Changes a single entrypoint to jump directly to \p target.
+     *
+     * Unlike patching through \c getPatchOffset, this is safe to use while
+     * other threads are calling the entrypoints. Like \c getPatchOffset, it
+     * must be called between \c startPatch and \c finishPatch, and
+     * \c restoreFuncs or \c abortPatch will undo it.
+     *
+     * This function is passed to
+     * __GLdispatchPatchCallbacks::initiatePatchTargets.
+     *
+     * \return GL_TRUE on success, or GL_FALSE if the entrypoint doesn't exist
+     * or can't be changed this way.
+     */
+    GLboolean (* setStubTarget) (const char *name, const void *target);
+
+    /**
+     * Faults in the pages that hold the entrypoints. See
+     * \c __glDispatchPrewarm.
+     *
+     * \param lock If GL_TRUE, also try to lock the pages in memory.
+     */
+    void (* prewarm) (GLboolean lock);
+
 } __GLdispatchStubPatchCallbacks;
 
 /*!
@@ -254,6 +468,24 @@ _GLAPI_EXPORT int __glDispatchRegisterStubCallbacks(const __GLdispatchStubPatchC
  */
 _GLAPI_EXPORT void __glDispatchUnregisterStubCallbacks(int stubId);
 
+/*!
+ * Tells GLdispatch which dispatch table slots a library's entrypoints use.
+ *
+ * GLdispatch only looks up the functions for slots that some library has
+ * registered, or that were returned from \c __glDispatchGetProcAddress. Any
+ * other slots in a dispatch table are left pointing to a no-op function,
+ * since nothing can call them.
+ *
+ * This can be called at any time, and any slots that are new are filled in
+ * for each dispatch table before the next call through it.
+ *
+ * \see stub_get_public_slots
+ *
+ * \param slots An array of dispatch table slots.
+ * \param count The number of elements in \p slots.
+ */
+_GLAPI_EXPORT void __glDispatchRegisterStubSlots(const int *slots, int count);
+
 #ifdef __cplusplus
 }
 #endif
@@ -26,11 +26,16 @@
  *    Chia-I Wu <olv@lunarg.com>
  */
 
+#include <stdlib.h>
 #include <string.h>
+#include <assert.h>
 #include "glapi.h"
 #include "u_current.h"
 #include "table.h" /* for MAPI_TABLE_NUM_SLOTS */
 #include "stub.h"
+#include "entry.h"
+#include "glvnd_atomic.h"
+#include "glvnd_memstats.h"
 
 /*
  * Global variables and _glapi_get_current are defined in
@@ -43,6 +48,25 @@ _glapi_init(void)
     u_current_init();
 }
 
+void
+_glapi_init_noop(int reportErrors)
+{
+    table_init_noop(reportErrors);
+}
+
+int
+_glapi_init_static_tls(void)
+{
+#if defined(GLDISPATCH_RUNTIME_TLS_STUBS)
+    const void **current = u_current_get_static_tls();
+
+    if (current != NULL) {
+        return entry_init_static_tls(current);
+    }
+#endif
+    return 0;
+}
+
 void
 _glapi_destroy(void)
 {
@@ -72,16 +96,163 @@ _glapi_get_current(void)
     return u_current_get();
 }
 
+void
+_glapi_set_current_vendor_context(const void *context)
+{
+    u_current_set_vendor_context(context);
+}
+
+const void *
+_glapi_get_current_vendor_context(void)
+{
+    return u_current_get_vendor_context();
+}
+
 /**
  * Return size of dispatch table struct as number of functions (or
- * slots).
+ * slots), including the overflow chunk pointers.
  */
 unsigned int
 _glapi_get_dispatch_table_size(void)
+{
+   return MAPI_TABLE_NUM_ENTRIES;
+}
+
+unsigned int
+_glapi_get_dispatch_table_slot_count(void)
 {
    return MAPI_TABLE_NUM_SLOTS;
 }
 
+unsigned int
+_glapi_get_static_stub_count(void)
+{
+   return MAPI_TABLE_NUM_STATIC;
+}
+
+uint32_t
+_glapi_get_static_layout_hash(void)
+{
+   return MAPI_TABLE_LAYOUT_HASH;
+}
+
+unsigned int
+_glapi_get_max_stub_count(void)
+{
+   return MAPI_TABLE_NUM_SLOTS + MAPI_TABLE_NUM_OVERFLOW;
+}
+
+void
+_glapi_init_table_overflow(struct _glapi_table *table)
+{
+    mapi_func *funcs = (mapi_func *) table;
+
+    memcpy(funcs + MAPI_TABLE_NUM_SLOTS, table_noop_array + MAPI_TABLE_NUM_SLOTS,
+            MAPI_TABLE_NUM_OVERFLOW_CHUNKS * sizeof(mapi_func));
+}
+
+void **
+_glapi_get_table_overflow_entry(struct _glapi_table *table, int offset)
+{
+    void * volatile *chunks = ((void * volatile *) table) + MAPI_TABLE_NUM_SLOTS;
+    int index = offset - MAPI_TABLE_NUM_SLOTS;
+    int c = index / MAPI_TABLE_OVERFLOW_CHUNK_SIZE;
+    void *noopChunk = (void *) table_noop_array[MAPI_TABLE_NUM_SLOTS + c];
+    void **chunk;
+
+    assert(index >= 0 && index < MAPI_TABLE_NUM_OVERFLOW);
+
+    chunk = (void **) chunks[c];
+    if (chunk == noopChunk) {
+        // Start with every entry pointing to a no-op function, and then fill
+        // in the chunk pointer. Another thread might already be using this
+        // table, but it can only call the overflow stubs that existed before
+        // this chunk, and none of those are in it.
+        chunk = malloc(MAPI_TABLE_OVERFLOW_CHUNK_SIZE * sizeof(void *));
+        if (chunk == NULL) {
+            return NULL;
+        }
+        memcpy(chunk, noopChunk, MAPI_TABLE_OVERFLOW_CHUNK_SIZE * sizeof(void *));
+        glvndMemStatsAlloc(GLVND_MEM_DISPATCH_TABLE,
+                MAPI_TABLE_OVERFLOW_CHUNK_SIZE * sizeof(void *));
+        glvndAtomicStoreReleasePtr(&chunks[c], chunk);
+    }
+
+    return &chunk[index % MAPI_TABLE_OVERFLOW_CHUNK_SIZE];
+}
+
+void
+_glapi_free_table_overflow(struct _glapi_table *table)
+{
+    mapi_func *funcs = (mapi_func *) table;
+    int i;
+
+    for (i=MAPI_TABLE_NUM_SLOTS; i<MAPI_TABLE_NUM_ENTRIES; i++) {
+        if (funcs[i] != table_noop_array[i]) {
+            free((void *) funcs[i]);
+            glvndMemStatsFree(GLVND_MEM_DISPATCH_TABLE,
+                    MAPI_TABLE_OVERFLOW_CHUNK_SIZE * sizeof(void *));
+        }
+    }
+}
+
+struct _glapi_table *
+_glapi_create_count_table(void)
+{
+    struct mapi_count_table *table;
+    int i;
+
+    if (entry_get_count_trampoline(0) == NULL) {
+        return NULL;
+    }
+
+    table = calloc(1, sizeof(struct mapi_count_table));
+    if (table == NULL) {
+        return NULL;
+    }
+    for (i=0; i<MAPI_TABLE_NUM_SLOTS; i++) {
+        table->entries[i] = entry_get_count_trampoline(i);
+    }
+    _glapi_init_table_overflow((struct _glapi_table *) table);
+
+    return (struct _glapi_table *) table;
+}
+
+void
+_glapi_destroy_count_table(struct _glapi_table *table)
+{
+    free(table);
+}
+
+void
+_glapi_set_count_table_target(struct _glapi_table *table,
+                              const struct _glapi_table *target)
+{
+    struct mapi_count_table *countTable = (struct mapi_count_table *) table;
+    const mapi_func *src = (const mapi_func *) target;
+    int i;
+
+    if (src == NULL) {
+        src = table_noop_array;
+    }
+
+    // The thread that this table is current on could be calling through it,
+    // so update each chunk pointer in one store.
+    for (i=MAPI_TABLE_NUM_SLOTS; i<MAPI_TABLE_NUM_ENTRIES; i++) {
+        if (countTable->entries[i] != src[i]) {
+            glvndAtomicStoreReleasePtr((void * volatile *) &countTable->entries[i],
+                    (void *) src[i]);
+        }
+    }
+    countTable->target = (const mapi_func *) target;
+}
+
+const uint64_t *
+_glapi_get_count_table_counts(const struct _glapi_table *table)
+{
+    return ((const struct mapi_count_table *) table)->counts;
+}
+
 static int
 _glapi_get_stub(const char *name, int generate)
 {
@@ -124,6 +295,19 @@ _glapi_get_proc_address(const char *funcName)
     }
 }
 
+_glapi_proc
+_glapi_find_proc_address(const char *funcName, int *offset)
+{
+    int index = _glapi_get_stub(funcName, 0);
+
+    *offset = index;
+    if (index >= 0) {
+        return stub_get_addr(index);
+    } else {
+        return NULL;
+    }
+}
+
 /**
  * Return the name of the function at the given dispatch offset.
  */
@@ -133,6 +317,25 @@ _glapi_get_proc_name(unsigned int offset)
    return stub_get_name(offset);
 }
 
+_glapi_proc
+_glapi_get_stub_code(unsigned int offset, int *size)
+{
+    *size = stub_get_size(offset);
+    return stub_get_addr(offset);
+}
+
+
+_glapi_proc
+_glapi_get_public_stub(int slot)
+{
+    // In libGLdispatch, the public stubs include every static function, so
+    // the index of each stub is the same as its slot.
+    if (slot >= 0 && slot < MAPI_TABLE_NUM_STATIC) {
+        return (_glapi_proc) entry_get_public(slot);
+    } else {
+        return NULL;
+    }
+}
 
 int _glapi_get_stub_count(void)
 {
@@ -34,37 +34,48 @@
 #include "stub.h"
 #include "table.h"
 #include "utils_misc.h"
+#include "glvnd_atomic.h"
+#include "glvnd_hash.h"
+#include "string_pool.h"
 
 #if !defined(STATIC_DISPATCH_ONLY)
 static void stub_cleanup_dynamic(void);
 #endif
 
-struct mapi_stub {
+/*!
+ * An entry in the perfect hash table for the public stubs.
+ */
+struct mapi_stub_hash {
     /*!
-     * The name of the stub function.
+     * The full hash value of the name, used to reject most misses without a
+     * string compare.
      */
-    const char *name;
+    uint32_t hash;
 
-    int slot;
+    /*!
+     * The index of the stub in public_stub_name_offsets.
+     */
+    int index;
 };
 
 static void *savedEntrypoints = NULL;
 
-/* define public_stubs */
+/*
+ * True if any entrypoints were changed with entry_set_target since the last
+ * call to stubStartPatch. Other threads may be running those entrypoints, so
+ * they have to be restored with entry_restore_targets instead of just copying
+ * savedEntrypoints back.
+ */
+static GLboolean savedEntrypointsHaveTargets = GL_FALSE;
+
+/* define public_stub_names and public_stub_name_offsets */
 #define MAPI_TMP_PUBLIC_STUBS
 #include "mapi_tmp.h"
 
-static int
-stub_compare(const void *key, const void *elem)
+static inline const char *
+public_stub_name(int index)
 {
-   const char *name = (const char *) key;
-   const struct mapi_stub *stub = (const struct mapi_stub *) elem;
-   const char *stub_name;
-
-   // Skip the "gl" prefix.
-   stub_name = stub->name + 2;
-
-   return strcmp(name, stub_name);
+    return public_stub_names + public_stub_name_offsets[index];
 }
 
 /**
@@ -73,7 +84,8 @@ stub_compare(const void *key, const void *elem)
 int
 stub_find_public(const char *name)
 {
-    const struct mapi_stub *stub;
+    const struct mapi_stub_hash *slot;
+    uint32_t h, seed;
 
     // All of the function names start with "gl", so skip that prefix when
     // comparing names.
@@ -81,10 +93,14 @@ stub_find_public(const char *name)
         name += 2;
     }
 
-    stub = (const struct mapi_stub *) bsearch(name, public_stubs,
-            ARRAY_LEN(public_stubs), sizeof(public_stubs[0]), stub_compare);
-    if (stub != NULL) {
-        return (stub - public_stubs);
+    // The generator builds a minimal perfect hash over the public stub
+    // names, so any name that's in the table will map to exactly one slot.
+    h = glvndHashString(name);
+    seed = public_stub_hash_seeds[h % PUBLIC_STUB_HASH_SEED_COUNT];
+    slot = &public_stub_hash_slots[glvndHashSlot(h, seed, ARRAY_LEN(public_stub_hash_slots))];
+
+    if (slot->hash == h && strcmp(name, public_stub_name(slot->index) + 2) == 0) {
+        return slot->index;
     } else {
         return -1;
     }
@@ -101,53 +117,185 @@ void stub_cleanup(void)
 }
 
 #if !defined(STATIC_DISPATCH_ONLY)
-static char *dynamic_stub_names[MAPI_TABLE_NUM_DYNAMIC];
-static int num_dynamic_stubs;
+
+#if !defined(GLDISPATCH_STATIC_STUBS_ONLY)
+/*
+ * The maximum number of dynamic stubs, including the overflow stubs.
+ */
+#define DYNAMIC_STUB_MAX (MAPI_TABLE_NUM_DYNAMIC + MAPI_TABLE_NUM_OVERFLOW)
+
+/*
+ * The dynamic stub names and hashes are stored in fixed-size chunks, which
+ * get allocated as they're needed.
+ */
+#define DYNAMIC_STUB_CHUNK_SIZE MAPI_TABLE_OVERFLOW_CHUNK_SIZE
+
+/*
+ * The starting size of the hash table for the dynamic stubs. The table is
+ * doubled in size whenever it would be more than half full.
+ */
+#define DYNAMIC_STUB_HASH_MIN_SIZE 256
+
+struct dynamic_stub_chunk {
+    const char *names[DYNAMIC_STUB_CHUNK_SIZE];
+    uint32_t hashes[DYNAMIC_STUB_CHUNK_SIZE];
+};
+
+/*!
+ * An open-addressing hash table of the dynamic stubs. Each element is the
+ * index of a stub plus one, or zero for an empty slot.
+ *
+ * When the table grows, the old table is kept around until the stubs are
+ * cleaned up, since another thread might still be looking through it.
+ */
+struct dynamic_stub_hash_table {
+    struct dynamic_stub_hash_table *prev;
+    int size;
+    int volatile slots[];
+};
+
+/*
+ * The dynamic stub names are only ever appended to, and num_dynamic_stubs is
+ * updated after the new name is filled in. That lets stub_find_dynamic look
+ * up existing stubs without holding the dispatch lock.
+ */
+static struct dynamic_stub_chunk *dynamic_stub_chunks[DYNAMIC_STUB_MAX / DYNAMIC_STUB_CHUNK_SIZE];
+static int volatile num_dynamic_stubs;
+
+static struct dynamic_stub_hash_table * volatile dynamic_stub_hash;
 
 void stub_cleanup_dynamic(void)
 {
     int i;
 
-    // Free the copies of the stub names.
-    for (i=0; i<num_dynamic_stubs; i++) {
-        free(dynamic_stub_names[i]);
-        dynamic_stub_names[i] = NULL;
+    while (dynamic_stub_hash != NULL) {
+        struct dynamic_stub_hash_table *prev = dynamic_stub_hash->prev;
+        free(dynamic_stub_hash);
+        dynamic_stub_hash = prev;
     }
 
+    for (i=0; i<ARRAY_LEN(dynamic_stub_chunks); i++) {
+        free(dynamic_stub_chunks[i]);
+        dynamic_stub_chunks[i] = NULL;
+    }
     num_dynamic_stubs = 0;
 }
 
+static struct dynamic_stub_chunk *
+stub_get_dynamic_chunk(int idx)
+{
+    return dynamic_stub_chunks[idx / DYNAMIC_STUB_CHUNK_SIZE];
+}
+
+/**
+ * Returns the hash table slot that a stub with the given hash should go in.
+ */
+static int
+stub_find_dynamic_hash_slot(const struct dynamic_stub_hash_table *table, uint32_t hash)
+{
+    int slot = hash % table->size;
+    while (table->slots[slot] != 0) {
+        slot = (slot + 1) % table->size;
+    }
+    return slot;
+}
+
+/**
+ * Makes sure that the hash table has room for one more stub, replacing it with
+ * a larger table if necessary.
+ */
+static GLboolean
+stub_reserve_dynamic_hash(void)
+{
+    struct dynamic_stub_hash_table *table = dynamic_stub_hash;
+    struct dynamic_stub_hash_table *newTable;
+    int size;
+    int i;
+
+    if (table != NULL && (num_dynamic_stubs + 1) * 2 <= table->size) {
+        return GL_TRUE;
+    }
+
+    size = (table != NULL ? table->size * 2 : DYNAMIC_STUB_HASH_MIN_SIZE);
+    newTable = calloc(1, sizeof(*newTable) + size * sizeof(int));
+    if (newTable == NULL) {
+        return GL_FALSE;
+    }
+    newTable->prev = table;
+    newTable->size = size;
+
+    for (i=0; i<num_dynamic_stubs; i++) {
+        uint32_t hash = stub_get_dynamic_chunk(i)->hashes[i % DYNAMIC_STUB_CHUNK_SIZE];
+        newTable->slots[stub_find_dynamic_hash_slot(newTable, hash)] = i + 1;
+    }
+
+    glvndAtomicStoreReleasePtr((void * volatile *) &dynamic_stub_hash, newTable);
+    return GL_TRUE;
+}
+
+/**
+ * Returns the address of a dynamic stub, or NULL if we can't create a stub for
+ * that index.
+ */
+static mapi_func
+stub_get_dynamic_addr(int idx)
+{
+    if (idx < MAPI_TABLE_NUM_DYNAMIC) {
+        // If the stubs are in C instead of assembly, then we can't use
+        // dynamic dispatch stubs, and entry_get_public will return NULL.
+        return entry_get_public(MAPI_TABLE_NUM_STATIC + idx);
+    } else {
+        return entry_get_overflow(idx - MAPI_TABLE_NUM_DYNAMIC);
+    }
+}
+
 /**
  * Add a dynamic stub.
  */
-int
-stub_add_dynamic(const char *name)
+static int
+stub_add_dynamic(const char *name, uint32_t hash)
 {
+   struct dynamic_stub_chunk *chunk;
    int idx;
 
    idx = num_dynamic_stubs;
-   if (idx >= MAPI_TABLE_NUM_DYNAMIC)
+   if (idx >= DYNAMIC_STUB_MAX)
       return -1;
 
-   // Make sure that we have a dispatch stub for this index. If the stubs are
-   // in C instead of assembly, then we can't use dynamic dispatch stubs, and
-   // entry_get_public will return NULL.
-   if (entry_get_public(MAPI_TABLE_NUM_STATIC + idx) == NULL) {
+   // Make sure that we have a dispatch stub for this index.
+   if (stub_get_dynamic_addr(idx) == NULL) {
        return -1;
    }
 
-   assert(dynamic_stub_names[idx] == NULL);
+   if (!stub_reserve_dynamic_hash()) {
+       return -1;
+   }
+
+   chunk = stub_get_dynamic_chunk(idx);
+   if (chunk == NULL) {
+       chunk = calloc(1, sizeof(*chunk));
+       if (chunk == NULL) {
+           return -1;
+       }
+       dynamic_stub_chunks[idx / DYNAMIC_STUB_CHUNK_SIZE] = chunk;
+   }
+
+   assert(chunk->names[idx % DYNAMIC_STUB_CHUNK_SIZE] == NULL);
 
    /*
     * name is the pointer passed to glXGetProcAddress, so the caller may free
-    * or modify it later. Allocate a copy of the name to store.
+    * or modify it later. Use the pooled copy of the name, which libGLX and
+    * libEGL share for the same function.
     */
-   dynamic_stub_names[idx] = strdup(name);
-   if (dynamic_stub_names[idx] == NULL) {
+   chunk->names[idx % DYNAMIC_STUB_CHUNK_SIZE] = __glvndStringPoolIntern(name);
+   if (chunk->names[idx % DYNAMIC_STUB_CHUNK_SIZE] == NULL) {
        return -1;
    }
+   chunk->hashes[idx % DYNAMIC_STUB_CHUNK_SIZE] = hash;
 
-   num_dynamic_stubs = idx + 1;
+   glvndAtomicStoreRelease(&num_dynamic_stubs, idx + 1);
+   glvndAtomicStoreRelease(&dynamic_stub_hash->slots[
+           stub_find_dynamic_hash_slot(dynamic_stub_hash, hash)], idx + 1);
 
    return (MAPI_TABLE_NUM_STATIC + idx);
 }
@@ -155,31 +303,64 @@ stub_add_dynamic(const char *name)
 /**
  * Return the dynamic stub with the given name.  If no such stub exists and
  * generate is true, a new stub is generated.
+ *
+ * If generate is false, then this is safe to call without the dispatch lock.
  */
 int
 stub_find_dynamic(const char *name, int generate)
 {
-    int found = -1;
-    int i;
-   
+    struct dynamic_stub_hash_table *table;
+    uint32_t hash;
+
     if (generate) {
         assert(stub_find_public(name) < 0);
     }
 
-    for (i = 0; i < num_dynamic_stubs; i++) {
-        if (strcmp(name, dynamic_stub_names[i]) == 0) {
-            found = MAPI_TABLE_NUM_STATIC + i;
-            break;
+    hash = glvndHashString(name);
+    table = glvndAtomicLoadAcquirePtr((void * volatile *) &dynamic_stub_hash);
+    if (table != NULL) {
+        int slot = hash % table->size;
+        while (1) {
+            int idx = glvndAtomicLoadAcquire(&table->slots[slot]) - 1;
+            const struct dynamic_stub_chunk *chunk;
+            if (idx < 0) {
+                break;
+            }
+            chunk = stub_get_dynamic_chunk(idx);
+            if (chunk->hashes[idx % DYNAMIC_STUB_CHUNK_SIZE] == hash
+                    && strcmp(name, chunk->names[idx % DYNAMIC_STUB_CHUNK_SIZE]) == 0) {
+                return MAPI_TABLE_NUM_STATIC + idx;
+            }
+            slot = (slot + 1) % table->size;
         }
     }
 
     /* generate a dynamic stub */
-    if (generate && found < 0) {
-        found = stub_add_dynamic(name);
+    if (generate) {
+        return stub_add_dynamic(name, hash);
     }
 
-    return found;
+    return -1;
+}
+
+#else // !defined(GLDISPATCH_STATIC_STUBS_ONLY)
+
+/*
+ * The dispatch table doesn't have any slots for dynamic stubs, so only the
+ * public stubs can be dispatched.
+ */
+void stub_cleanup_dynamic(void)
+{
+}
+
+int
+stub_find_dynamic(const char *name, int generate)
+{
+    (void) name;
+    (void) generate;
+    return -1;
 }
+#endif // !defined(GLDISPATCH_STATIC_STUBS_ONLY)
 
 /**
  * Return the name of a stub.
@@ -187,16 +368,22 @@ stub_find_dynamic(const char *name, int generate)
 const char *
 stub_get_name(int index)
 {
-    if (index < MAPI_TABLE_NUM_STATIC) {
-        return public_stubs[index].name;
-    } else {
-        return dynamic_stub_names[index - MAPI_TABLE_NUM_STATIC];
+#if !defined(GLDISPATCH_STATIC_STUBS_ONLY)
+    if (index >= MAPI_TABLE_NUM_STATIC) {
+        int idx = index - MAPI_TABLE_NUM_STATIC;
+        return stub_get_dynamic_chunk(idx)->names[idx % DYNAMIC_STUB_CHUNK_SIZE];
     }
+#endif
+    return public_stub_name(index);
 }
 
 int stub_get_count(void)
 {
-    return ARRAY_LEN(public_stubs) + num_dynamic_stubs;
+#if !defined(GLDISPATCH_STATIC_STUBS_ONLY)
+    return ARRAY_LEN(public_stub_name_offsets) + num_dynamic_stubs;
+#else
+    return ARRAY_LEN(public_stub_name_offsets);
+#endif
 }
 
 /**
@@ -205,10 +392,40 @@ int stub_get_count(void)
 mapi_func
 stub_get_addr(int index)
 {
-    return entry_get_public(index);
+    if (index < MAPI_TABLE_NUM_SLOTS) {
+        return entry_get_public(index);
+    } else {
+        return entry_get_overflow(index - MAPI_TABLE_NUM_SLOTS);
+    }
+}
+
+/**
+ * Return the size of a stub's code, in bytes.
+ */
+int
+stub_get_size(int index)
+{
+    if (index < MAPI_TABLE_NUM_SLOTS) {
+        return entry_stub_size;
+    } else {
+        return entry_overflow_stub_size;
+    }
 }
 #endif // !defined(STATIC_DISPATCH_ONLY)
 
+#if defined(STATIC_DISPATCH_ONLY)
+/* define public_stub_slots */
+#define MAPI_TMP_PUBLIC_SLOTS
+#include "mapi_tmp.h"
+
+const int *
+stub_get_public_slots(int *count)
+{
+    *count = ARRAY_LEN(public_stub_slots);
+    return public_stub_slots;
+}
+#endif // defined(STATIC_DISPATCH_ONLY)
+
 static int stub_allow_override(void)
 {
     return !!entry_stub_size;
@@ -247,7 +464,12 @@ static void stubRestoreFuncsInternal(void)
 
     assert(stub_allow_override());
 
-    entry_restore_entrypoints(savedEntrypoints);
+    if (savedEntrypointsHaveTargets) {
+        entry_restore_targets(savedEntrypoints);
+        savedEntrypointsHaveTargets = GL_FALSE;
+    } else {
+        entry_restore_entrypoints(savedEntrypoints);
+    }
     free(savedEntrypoints);
     savedEntrypoints = NULL;
 }
@@ -269,31 +491,61 @@ static void stubAbortPatch(void)
     entry_patch_finish();
 }
 
-static GLboolean stubGetPatchOffset(const char *name, void **writePtr, const void **execPtr)
+static int stubFindPatchIndex(const char *name)
 {
-    int index;
-    void *addr = NULL;
-
-    index = stub_find_public(name);
+    int index = stub_find_public(name);
 
 #if !defined(STATIC_DISPATCH_ONLY)
     if (index < 0) {
         index = stub_find_dynamic(name, 0);
     }
+
+    // The overflow stubs aren't part of the static entrypoints, so they
+    // can't be patched.
+    if (index >= MAPI_TABLE_NUM_SLOTS) {
+        index = -1;
+    }
 #endif // !defined(STATIC_DISPATCH_ONLY)
 
+    return index;
+}
+
+static GLboolean stubGetPatchOffset(const char *name, void **writePtr, const void **execPtr)
+{
+    int index;
+    void *writeAddr = NULL;
+    void *execAddr = NULL;
+
+    index = stubFindPatchIndex(name);
+
     if (index >= 0) {
-        addr = entry_get_patch_address(index);
+        writeAddr = entry_get_patch_write_address(index);
+        execAddr = entry_get_patch_address(index);
     }
 
     if (writePtr != NULL) {
-        *writePtr = addr;
+        *writePtr = writeAddr;
     }
     if (execPtr != NULL) {
-        *execPtr = addr;
+        *execPtr = execAddr;
+    }
+
+    return (execAddr != NULL ? GL_TRUE : GL_FALSE);
+}
+
+static GLboolean stubSetStubTarget(const char *name, const void *target)
+{
+    int index;
+
+    assert(savedEntrypoints != NULL);
+
+    index = stubFindPatchIndex(name);
+    if (index < 0 || !entry_set_target(index, target)) {
+        return GL_FALSE;
     }
 
-    return (addr != NULL ? GL_TRUE : GL_FALSE);
+    savedEntrypointsHaveTargets = GL_TRUE;
+    return GL_TRUE;
 }
 
 static int stubGetStubType(void)
@@ -306,6 +558,11 @@ static int stubGetStubSize(void)
     return entry_stub_size;
 }
 
+static void stubPrewarm(GLboolean lock)
+{
+    entry_prewarm(lock);
+}
+
 static const __GLdispatchStubPatchCallbacks stubPatchCallbacks =
 {
     stubStartPatch,     // startPatch
@@ -315,6 +572,8 @@ static const __GLdispatchStubPatchCallbacks stubPatchCallbacks =
     stubGetPatchOffset, // getPatchOffset
     stubGetStubType,    // getStubType
     stubGetStubSize,    // getStubSize
+    stubSetStubTarget,  // setStubTarget
+    stubPrewarm,        // prewarm
 };
 
 const __GLdispatchStubPatchCallbacks *stub_get_patch_callbacks(void)
@@ -52,9 +52,22 @@ stub_get_name(int index);
 mapi_func
 stub_get_addr(int index);
 
+int
+stub_get_size(int index);
+
 int stub_get_count(void);
 #endif // !defined(STATIC_DISPATCH_ONLY)
 
+/**
+ * Returns the dispatch table slots that this library's entrypoints use. This
+ * is passed to \c __glDispatchRegisterStubSlots.
+ *
+ * This is only available in the static stubs for libGL, libOpenGL, and the
+ * GLES libraries, not in libGLdispatch itself.
+ */
+const int *
+stub_get_public_slots(int *count);
+
 /**
  * Returns the \c __GLdispatchStubPatchCallbacks struct that should be used for
  * patching the entrypoints, or \c NULL if patching is not supported.
@@ -27,15 +27,18 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "table.h"
 #include "app_error_check.h"
 
-static void
-noop_warn(const char *name)
-{
-    glvndAppErrorCheckReportError("%s called without a current context\n", name);
-}
+/*
+ * This is a macro so that each generated no-op reporter gets its own count in
+ * glvndAppErrorCheckReportError, rather than sharing one between every
+ * function.
+ */
+#define noop_warn(name) \
+    glvndAppErrorCheckReportError("%s called without a current context\n", name)
 
 static int
 noop_generic(void)
@@ -44,7 +47,38 @@ noop_generic(void)
    return 0;
 }
 
+static int
+noop_silent(void)
+{
+   return 0;
+}
+
 /* define noop_array */
 #define MAPI_TMP_DEFINES
 #define MAPI_TMP_NOOP_ARRAY
 #include "mapi_tmp.h"
+
+void
+table_init_noop(int reportErrors)
+{
+   mapi_func noop = (mapi_func) (reportErrors ? noop_generic : noop_silent);
+   int i;
+
+   for (i = 0; i < MAPI_TABLE_NUM_SLOTS; i++) {
+      table_noop_array[i] = noop;
+   }
+#ifdef DEBUG
+   if (reportErrors) {
+      memcpy(table_noop_array, table_noop_report_array, sizeof(table_noop_report_array));
+   }
+#endif
+
+#if !defined(GLDISPATCH_STATIC_STUBS_ONLY)
+   for (i = 0; i < MAPI_TABLE_OVERFLOW_CHUNK_SIZE; i++) {
+      table_noop_overflow_chunk[i] = noop;
+   }
+   for (i = 0; i < MAPI_TABLE_NUM_OVERFLOW_CHUNKS; i++) {
+      table_noop_array[MAPI_TABLE_NUM_SLOTS + i] = (mapi_func) table_noop_overflow_chunk;
+   }
+#endif
+}
@@ -28,6 +28,8 @@
 #ifndef _TABLE_H_
 #define _TABLE_H_
 
+#include <stdint.h>
+
 #include "u_compiler.h"
 #include "entry.h"
 #include "glapi.h"
@@ -36,9 +38,55 @@
 #include "mapi_tmp.h"
 
 #define MAPI_TABLE_NUM_SLOTS (MAPI_TABLE_NUM_STATIC + MAPI_TABLE_NUM_DYNAMIC)
-#define MAPI_TABLE_SIZE (MAPI_TABLE_NUM_SLOTS * sizeof(mapi_func))
 
-extern const mapi_func table_noop_array[];
+/*
+ * With GLDISPATCH_STATIC_STUBS_ONLY, the header is generated with
+ * --static-only, so the table only has a slot for each function in the XML
+ * files.
+ */
+#if defined(GLDISPATCH_STATIC_STUBS_ONLY) \
+    && (MAPI_TABLE_NUM_DYNAMIC != 0 || MAPI_TABLE_NUM_OVERFLOW_CHUNKS != 0)
+#error "GLDISPATCH_STATIC_STUBS_ONLY requires a header generated with --static-only"
+#endif
+
+/*
+ * Any dynamic stubs past MAPI_TABLE_NUM_SLOTS are overflow stubs. Those don't
+ * have a slot of their own. Instead, the dispatch table has an array of
+ * pointers to chunks of function pointers right after the last slot, and each
+ * chunk is only allocated once a stub in it exists.
+ */
+#define MAPI_TABLE_OVERFLOW_CHUNK_SIZE (1 << MAPI_TABLE_OVERFLOW_CHUNK_SHIFT)
+#define MAPI_TABLE_NUM_OVERFLOW \
+    (MAPI_TABLE_NUM_OVERFLOW_CHUNKS * MAPI_TABLE_OVERFLOW_CHUNK_SIZE)
+
+#define MAPI_TABLE_NUM_ENTRIES (MAPI_TABLE_NUM_SLOTS + MAPI_TABLE_NUM_OVERFLOW_CHUNKS)
+#define MAPI_TABLE_SIZE (MAPI_TABLE_NUM_ENTRIES * sizeof(mapi_func))
+
+/*
+ * A call counting table starts with MAPI_TABLE_NUM_ENTRIES entries, like any
+ * other dispatch table. Each slot points to its counting trampoline, and the
+ * overflow chunk pointers are copied from the target table. That's followed
+ * by a pointer to the target table, and then a 64-bit counter for each slot.
+ * The counting trampolines depend on this layout.
+ */
+struct mapi_count_table {
+   mapi_func entries[MAPI_TABLE_NUM_ENTRIES];
+   const mapi_func *target;
+   uint64_t counts[MAPI_TABLE_NUM_SLOTS];
+};
+
+extern mapi_func table_noop_array[];
+
+/**
+ * Fills in the no-op table.
+ *
+ * By default, the no-op table uses a function that just returns zero. If
+ * \p reportErrors is non-zero, then it uses functions that report a missing
+ * current context instead. The table is empty until this is called, so that
+ * it doesn't need a relocation for each entry, which means this must be
+ * called once, before any thread can call through the no-op table.
+ */
+void table_init_noop(int reportErrors);
 
 /**
  * Get the no-op dispatch table.
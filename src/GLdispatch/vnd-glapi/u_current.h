@@ -14,6 +14,22 @@ u_current_destroy(void);
 void
 u_current_set_multithreaded(void);
 
+/**
+ * Returns the address of the calling thread's dispatch table pointer, if
+ * it's in static TLS.
+ *
+ * If it is, then the pointer is at the same offset from the thread pointer in
+ * every thread, so the dispatch stubs can read it directly instead of going
+ * through _glapi_Current or u_current_get.
+ *
+ * This has to be called from libGLdispatch's constructor, before anything
+ * else touches the current dispatch table.
+ *
+ * \return The address, or NULL if it's not in static TLS or this isn't
+ * supported.
+ */
+const void **u_current_get_static_tls(void);
+
 /**
  * Set the per-thread dispatch table pointer.
  */
@@ -24,5 +40,15 @@ void u_current_set(const struct _glapi_table *tbl);
  */
 const struct _glapi_table *u_current_get(void);
 
+/**
+ * Set the per-thread vendor context pointer.
+ */
+void u_current_set_vendor_context(const void *context);
+
+/**
+ * Return the vendor context pointer for calling thread.
+ */
+const void *u_current_get_vendor_context(void);
+
 #endif /* _U_CURRENT_H_ */
 
@@ -52,6 +52,12 @@ u_current_set_multithreaded(void)
 {
 }
 
+const void **u_current_get_static_tls(void)
+{
+   // The stubs already read _glapi_tls_Current directly.
+   return NULL;
+}
+
 void
 u_current_set(const struct _glapi_table *tbl)
 {
@@ -63,3 +69,14 @@ const struct _glapi_table *u_current_get(void)
    return (const struct _glapi_table *) _glapi_tls_Current[GLAPI_CURRENT_DISPATCH];
 }
 
+void
+u_current_set_vendor_context(const void *context)
+{
+   _glapi_tls_Current[GLAPI_CURRENT_VENDOR_CONTEXT] = context;
+}
+
+const void *u_current_get_vendor_context(void)
+{
+   return _glapi_tls_Current[GLAPI_CURRENT_VENDOR_CONTEXT];
+}
+
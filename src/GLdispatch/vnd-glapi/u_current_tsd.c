@@ -27,7 +27,11 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <assert.h>
+#if defined(__GLIBC__)
+#include <link.h>
+#endif
 
 #include "table.h"
 #include "stub.h"
@@ -38,30 +42,50 @@ const void *_glapi_Current[GLAPI_NUM_CURRENT_ENTRIES]
         (const void *) table_noop_array
       };
 
-static glvnd_key_t u_current_tsd[GLAPI_NUM_CURRENT_ENTRIES];
 static int ThreadSafe;
 
+#if defined(GLDISPATCH_TSD_USE_THREAD_LOCAL)
+/*
+ * Each thread's current dispatch table, used instead of a pthread key if the
+ * compiler supports __thread.
+ *
+ * The assembly stubs can't read this directly, since they'd need to know
+ * which TLS model the compiler picked. But once the process is multithreaded,
+ * the stubs call u_current_get, and reading a __thread variable there is much
+ * cheaper than calling pthread_getspecific through __glvndPthreadFuncs.
+ */
+static __thread const void *u_current_thread_local = (const void *) table_noop_array;
+static __thread const void *u_current_vendor_context_local = NULL;
+#else
+static glvnd_key_t u_current_tsd[GLAPI_NUM_CURRENT_ENTRIES];
+#endif
+
 void
 u_current_init(void)
 {
     int i;
     for (i = 0; i < GLAPI_NUM_CURRENT_ENTRIES; i++) {
+#if !defined(GLDISPATCH_TSD_USE_THREAD_LOCAL)
         if (__glvndPthreadFuncs.key_create(&u_current_tsd[i], NULL) != 0) {
             perror("_glthread_: failed to allocate key for thread specific data");
             abort();
         }
-        _glapi_Current[i] = (const void *) table_noop_array;
+#endif
+        _glapi_Current[i] = NULL;
     }
+    _glapi_Current[GLAPI_CURRENT_DISPATCH] = (const void *) table_noop_array;
     ThreadSafe = 0;
 }
 
 void
 u_current_destroy(void)
 {
+#if !defined(GLDISPATCH_TSD_USE_THREAD_LOCAL)
     int i;
     for (i = 0; i < GLAPI_NUM_CURRENT_ENTRIES; i++) {
         __glvndPthreadFuncs.key_delete(u_current_tsd[i]);
     }
+#endif
 }
 
 void
@@ -75,18 +99,87 @@ u_current_set_multithreaded(void)
     }
 }
 
+#if defined(GLDISPATCH_TSD_USE_THREAD_LOCAL) && defined(__GLIBC__)
+static int FindStaticTLSCallback(struct dl_phdr_info *info, size_t size, void *data)
+{
+    uintptr_t addr = (uintptr_t) &ThreadSafe;
+    int i;
+
+    for (i = 0; i < info->dlpi_phnum; i++) {
+        const ElfW(Phdr) *phdr = &info->dlpi_phdr[i];
+        uintptr_t start = info->dlpi_addr + phdr->p_vaddr;
+
+        if (phdr->p_type == PT_LOAD && addr >= start
+                && addr - start < phdr->p_memsz) {
+            // glibc only fills in dlpi_tls_data if the module's TLS block has
+            // been allocated in this thread. Nothing has touched
+            // u_current_thread_local yet, so that's only the case if the
+            // block is in static TLS.
+            *((int *) data) = (info->dlpi_tls_data != NULL);
+            return 1;
+        }
+    }
+    return 0;
+}
+#endif
+
+const void **u_current_get_static_tls(void)
+{
+#if defined(GLDISPATCH_TSD_USE_THREAD_LOCAL) && defined(__GLIBC__)
+    int isStatic = 0;
+
+    dl_iterate_phdr(FindStaticTLSCallback, &isStatic);
+    if (isStatic) {
+        return &u_current_thread_local;
+    }
+#endif
+    return NULL;
+}
+
 void u_current_set(const struct _glapi_table *tbl)
 {
+#if defined(GLDISPATCH_TSD_USE_THREAD_LOCAL)
+    u_current_thread_local = (const void *) tbl;
+#else
     if (__glvndPthreadFuncs.setspecific(u_current_tsd[GLAPI_CURRENT_DISPATCH], (void *) tbl) != 0) {
         perror("_glthread_: thread failed to set thread specific data");
         abort();
     }
+#endif
     _glapi_Current[GLAPI_CURRENT_DISPATCH] = (ThreadSafe) ? NULL : (const void *) tbl;
 }
 
 const struct _glapi_table *u_current_get(void)
 {
+#if defined(GLDISPATCH_TSD_USE_THREAD_LOCAL)
+   return (const struct _glapi_table *) ((ThreadSafe) ?
+         u_current_thread_local : _glapi_Current[GLAPI_CURRENT_DISPATCH]);
+#else
    return (const struct _glapi_table *) ((ThreadSafe) ?
          __glvndPthreadFuncs.getspecific(u_current_tsd[GLAPI_CURRENT_DISPATCH]) : _glapi_Current[GLAPI_CURRENT_DISPATCH]);
+#endif
+}
+
+void u_current_set_vendor_context(const void *context)
+{
+#if defined(GLDISPATCH_TSD_USE_THREAD_LOCAL)
+    u_current_vendor_context_local = context;
+#else
+    if (__glvndPthreadFuncs.setspecific(u_current_tsd[GLAPI_CURRENT_VENDOR_CONTEXT], (void *) context) != 0) {
+        perror("_glthread_: thread failed to set thread specific data");
+        abort();
+    }
+#endif
+    _glapi_Current[GLAPI_CURRENT_VENDOR_CONTEXT] = (ThreadSafe) ? NULL : context;
 }
 
+const void *u_current_get_vendor_context(void)
+{
+#if defined(GLDISPATCH_TSD_USE_THREAD_LOCAL)
+   return ((ThreadSafe) ?
+         u_current_vendor_context_local : _glapi_Current[GLAPI_CURRENT_VENDOR_CONTEXT]);
+#else
+   return ((ThreadSafe) ?
+         __glvndPthreadFuncs.getspecific(u_current_tsd[GLAPI_CURRENT_VENDOR_CONTEXT]) : _glapi_Current[GLAPI_CURRENT_VENDOR_CONTEXT]);
+#endif
+}
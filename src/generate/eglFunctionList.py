@@ -89,7 +89,6 @@ EGL_FUNCTIONS = (
     _eglCore("eglGetConfigs",                        "display"),
     _eglCore("eglQueryContext",                      "display"),
     _eglCore("eglQuerySurface",                      "display"),
-    _eglCore("eglSwapBuffers",                       "display"),
     _eglCore("eglWaitGL",                            "current", retval="EGL_TRUE"),
     _eglCore("eglWaitNative",                        "current", retval="EGL_TRUE"),
     _eglCore("eglTerminate",                         "display"),
@@ -102,6 +101,7 @@ EGL_FUNCTIONS = (
     _eglCore("eglGetProcAddress",                    "custom"),
     _eglCore("eglMakeCurrent",                       "custom"),
     _eglCore("eglQueryString",                       "custom"),
+    _eglCore("eglSwapBuffers",                       "custom"),
 
     # EGL_VERSION_1_1
     _eglCore("eglBindTexImage",                      "display"),
@@ -32,6 +32,12 @@ import xml.etree.cElementTree as etree
 
 MAPI_TABLE_NUM_DYNAMIC = 4096
 
+# Dynamic stubs past MAPI_TABLE_NUM_DYNAMIC are generated at runtime, and go in
+# a two-level table: the end of each dispatch table has an array of pointers
+# to chunks of (1 << MAPI_TABLE_OVERFLOW_CHUNK_SHIFT) slots each.
+MAPI_TABLE_OVERFLOW_CHUNK_SHIFT = 9
+MAPI_TABLE_NUM_OVERFLOW_CHUNKS = 64
+
 _LIBRARY_FEATURE_NAMES = {
     # libGL and libGLdiapatch both include every function.
     "gl" : None,
@@ -48,25 +54,39 @@ _LIBRARY_FEATURE_NAMES = {
     )),
 }
 
-def getFunctions(xmlFiles):
+def getFunctions(xmlFiles, hotNames=()):
     """
     Reads an XML file and returns all of the functions defined in it.
 
     xmlFile should be the path to Khronos's gl.xml file. The return value is a
-    sequence of FunctionDesc objects, ordered by slot number.
+    sequence of FunctionDesc objects, ordered by slot number. See
+    getFunctionsFromRoots for how hotNames affects the order.
     """
     roots = [ etree.parse(xmlFile).getroot() for xmlFile in xmlFiles ]
-    return getFunctionsFromRoots(roots)
+    return getFunctionsFromRoots(roots, hotNames)
+
+def getFunctionsFromRoots(roots, hotNames=()):
+    """
+    Returns all of the functions defined in a list of XML roots, ordered by
+    slot number.
 
-def getFunctionsFromRoots(roots):
+    Any functions named in hotNames come first, in the same order as in
+    hotNames, so that their slots end up next to each other in the dispatch
+    table. Any names in hotNames that aren't in the XML files are ignored.
+    The rest of the functions are sorted by name.
+    """
     functions = {}
     for root in roots:
         for func in _getFunctionList(root):
             functions[func.name] = func
-    functions = functions.values()
 
-    # Sort the function list by name.
-    functions = sorted(functions, key=lambda f: f.name)
+    hot = []
+    for name in hotNames:
+        if (name in functions):
+            hot.append(functions.pop(name))
+
+    # Sort the rest of the function list by name.
+    functions = hot + sorted(functions.values(), key=lambda f: f.name)
 
     # Assign a slot number to each function. This isn't strictly necessary,
     # since you can just look at the index in the list, but it makes it easier
@@ -76,6 +96,45 @@ def getFunctionsFromRoots(roots):
 
     return functions
 
+def readProfile(filename):
+    """
+    Reads a list of hot functions from a profile file.
+
+    Each line of the file has a function name, optionally preceded by a
+    weight, such as a call count. Blank lines and anything after a '#' are
+    ignored. The output of __GLVND_CALL_COUNTS has the same format, so it can
+    be used as a profile directly.
+
+    Returns the function names, ordered from the most frequently called
+    function to the least. Names without a weight come first, in the order
+    they appear in the file, and the rest are sorted by weight. If a name
+    appears more than once, its weights are added together. Names with a
+    weight of zero are left out.
+    """
+    unweighted = []
+    weights = collections.OrderedDict()
+    with open(filename, "r") as f:
+        for (lineNumber, line) in enumerate(f, 1):
+            fields = line.split("#", 1)[0].split()
+            if (len(fields) == 1):
+                if (fields[0] not in unweighted):
+                    unweighted.append(fields[0])
+            elif (len(fields) == 2):
+                try:
+                    weight = int(fields[0])
+                except ValueError:
+                    raise ValueError("%s:%d: Invalid weight %r"
+                            % (filename, lineNumber, fields[0]))
+                weights[fields[1]] = weights.get(fields[1], 0) + weight
+            elif (len(fields) > 2):
+                raise ValueError("%s:%d: Expected a weight and a function name"
+                        % (filename, lineNumber))
+
+    weighted = [name for name in weights
+            if (weights[name] > 0 and name not in unweighted)]
+    weighted.sort(key=lambda name: weights[name], reverse=True)
+    return unweighted + weighted
+
 def getExportNamesFromRoots(target, roots):
     """
     Goes through the <feature> tags from gl.xml and returns a set of OpenGL
@@ -102,6 +161,70 @@ def getExportNamesFromRoots(target, roots):
                 names.add(commandElem.get("name"))
     return names
 
+def nameHash(name):
+    """
+    Computes the 32-bit FNV-1a hash of a name. This must match
+    glvndHashString in src/util/glvnd_hash.h.
+    """
+    h = 0x811c9dc5
+    for c in bytearray(name.encode("ascii")):
+        h = ((h ^ c) * 0x01000193) & 0xffffffff
+    return h
+
+def hashSlot(h, seed, count):
+    """
+    Mixes a name hash with a seed value to select a slot. This must match
+    glvndHashSlot in src/util/glvnd_hash.h.
+    """
+    h = (h ^ (seed * 0x9e3779b9)) & 0xffffffff
+    h ^= h >> 16
+    h = (h * 0x85ebca6b) & 0xffffffff
+    h ^= h >> 13
+    h = (h * 0xc2b2ae35) & 0xffffffff
+    h ^= h >> 16
+    return h % count
+
+def buildPerfectHash(names):
+    """
+    Builds a minimal perfect hash for a list of names, using the "hash,
+    displace, and compress" approach.
+
+    Each name is assigned to a bucket based on its hash value. Then, starting
+    with the largest buckets, we look for a seed value for each bucket that
+    maps every name in it to an unused slot.
+
+    Returns a tuple of (seeds, slots), where seeds is the list of seed values
+    for each bucket, and slots is a list of (hash, index) pairs, with one
+    slot for each name.
+    """
+    count = len(names)
+    hashes = [nameHash(name) for name in names]
+    assert(len(set(hashes)) == count)
+
+    numBuckets = max(1, (count + 3) // 4)
+    buckets = [[] for i in range(numBuckets)]
+    for i in range(count):
+        buckets[hashes[i] % numBuckets].append(i)
+
+    seeds = [0] * numBuckets
+    slots = [None] * count
+    order = sorted(range(numBuckets), key=lambda b: len(buckets[b]), reverse=True)
+    for b in order:
+        if (len(buckets[b]) == 0):
+            break
+        for seed in range(1, 0x10000):
+            used = [hashSlot(hashes[i], seed, count) for i in buckets[b]]
+            if (len(set(used)) == len(used) and all(slots[s] is None for s in used)):
+                break
+        else:
+            raise ValueError("Can't find a perfect hash seed for bucket %d" % (b,))
+        seeds[b] = seed
+        for (i, s) in zip(buckets[b], used):
+            slots[s] = (hashes[i], i)
+
+    assert(all(s is not None for s in slots))
+    return (seeds, slots)
+
 class FunctionArg(collections.namedtuple("FunctionArg", "type name")):
     @property
     def dec(self):
@@ -17,8 +17,9 @@ import genCommon
 
 def main():
     parser = argparse.ArgumentParser()
-    parser.add_argument("target", choices=("header", "source"),
-            help="Whether to build the source or header file.")
+    parser.add_argument("target", choices=("header", "source", "hash"),
+            help="Whether to build the source or header file, or the "
+            "header with libEGL's hash table of the dispatch functions.")
     parser.add_argument("xml_files", nargs="+",
             help="The XML files with the EGL function lists.")
 
@@ -39,6 +40,8 @@ def main():
         text = generateHeader(functions)
     elif args.target == "source":
         text = generateSource(functions)
+    elif args.target == "hash":
+        text = generateHash(functions)
     sys.stdout.write(text)
 
 def fixupEglFunc(func, eglFunc):
@@ -135,6 +138,38 @@ def generateSource(functions):
 
     return text
 
+def generateHash(functions):
+    # The dispatch indices and the hash table are computed here, so any
+    # function that might be left out by the preprocessor would throw them
+    # off.
+    for (func, eglFunc) in functions:
+        if eglFunc.get("extension") is not None:
+            raise ValueError("Can't build a static hash table with conditional function %r" % (func.name,))
+
+    (seeds, slots) = genCommon.buildPerfectHash([func.name for (func, eglFunc) in functions])
+
+    text = textwrap.dedent(r"""
+    #ifndef G_EGLDISPATCH_HASH_H
+    #define G_EGLDISPATCH_HASH_H
+
+    #include "winsys_dispatch.h"
+
+    """.lstrip("\n"))
+
+    text += "#define __EGL_DISPATCH_HASH_SEED_COUNT %d\n" % (len(seeds),)
+    text += "static const unsigned short __EGL_DISPATCH_HASH_SEEDS[] = {\n"
+    for seed in seeds:
+        text += "    %d,\n" % (seed,)
+    text += "};\n\n"
+
+    text += "static const __GLVNDwinsysDispatchHashSlot __EGL_DISPATCH_HASH_SLOTS[] = {\n"
+    for (hashValue, index) in slots:
+        text += "    { 0x%08xu, %d }, // %s\n" % (hashValue, index, functions[index][0].name)
+    text += "};\n"
+
+    text += "\n#endif // G_EGLDISPATCH_HASH_H\n"
+    return text
+
 def generateGuardBegin(func, eglFunc):
     ext = eglFunc.get("extension")
     if ext is not None:
@@ -32,17 +32,44 @@
 Generates the glapi_mapi_tmp.h header file from Khronos's XML file.
 """
 
+import argparse
 import sys
 import xml.etree.cElementTree as etree
 
 import genCommon
 
 def _main():
-    target = sys.argv[1]
-    xmlFiles = sys.argv[2:]
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--profile",
+            help="A file listing the most frequently called functions. Those "
+            "functions get the first slots in the dispatch table, so that "
+            "they share as few cache lines as possible. Every library that "
+            "uses the same dispatch table must use the same profile.")
+    parser.add_argument("--static-only", action="store_true",
+            help="Don't reserve any dispatch table slots for dynamic stubs, "
+            "so that only the functions in the XML files can be dispatched. "
+            "Every library that uses the same dispatch table must use the "
+            "same setting.")
+    parser.add_argument("target",
+            choices=("gl", "gldispatch", "opengl", "glesv1", "glesv2"),
+            help="The library to generate the header for.")
+    parser.add_argument("xml_files", nargs="+",
+            help="The XML files with the OpenGL function lists.")
+    args = parser.parse_args()
 
-    roots = [ etree.parse(filename).getroot() for filename in xmlFiles ]
-    allFunctions = genCommon.getFunctionsFromRoots(roots)
+    target = args.target
+    if (args.static_only):
+        numDynamic = 0
+        numOverflowChunks = 0
+    else:
+        numDynamic = genCommon.MAPI_TABLE_NUM_DYNAMIC
+        numOverflowChunks = genCommon.MAPI_TABLE_NUM_OVERFLOW_CHUNKS
+    hotNames = ()
+    if (args.profile is not None):
+        hotNames = genCommon.readProfile(args.profile)
+
+    roots = [ etree.parse(filename).getroot() for filename in args.xml_files ]
+    allFunctions = genCommon.getFunctionsFromRoots(roots, hotNames)
 
     names = genCommon.getExportNamesFromRoots(target, roots)
     functions = [f for f in allFunctions if(f.name in names)]
@@ -63,11 +90,15 @@ typedef void (APIENTRY  *GLDEBUGPROCKHR)(GLenum source,GLenum type,GLuint id,GLe
 """.lstrip("\n"))
 
     print(generate_defines(functions))
-    print(generate_table(functions, allFunctions))
-    print(generate_noop_array(functions))
+    print(generate_table(functions, allFunctions, numDynamic, numOverflowChunks))
+    print(generate_noop_array(functions, numDynamic, numOverflowChunks))
     print(generate_public_stubs(functions))
+    print(generate_public_slots(functions))
     print(generate_public_entries(functions))
-    print(generate_stub_asm_gcc(functions, (target == "gldispatch")))
+    if (target != "gldispatch"):
+        print(generate_shared_entries(functions))
+    print(generate_stub_asm_gcc(functions,
+        (numDynamic if target == "gldispatch" else 0)))
 
 def generate_defines(functions):
     text = r"""
@@ -83,18 +114,46 @@ def generate_defines(functions):
     text += "#endif /* MAPI_TMP_DEFINES */\n"
     return text
 
-def generate_table(functions, allFunctions):
+def generate_table(functions, allFunctions, numDynamic, numOverflowChunks):
     text = "#ifdef MAPI_TMP_TABLE\n"
     text += "#define MAPI_TABLE_NUM_STATIC %d\n" % (len(allFunctions))
-    text += "#define MAPI_TABLE_NUM_DYNAMIC %d\n" % (genCommon.MAPI_TABLE_NUM_DYNAMIC,)
+    text += "#define MAPI_TABLE_NUM_DYNAMIC %d\n" % (numDynamic,)
+    text += "#define MAPI_TABLE_OVERFLOW_CHUNK_SHIFT %d\n" % (genCommon.MAPI_TABLE_OVERFLOW_CHUNK_SHIFT,)
+    text += "#define MAPI_TABLE_NUM_OVERFLOW_CHUNKS %d\n" % (numOverflowChunks,)
+    text += "#define MAPI_TABLE_LAYOUT_HASH 0x%08xu\n" % (generate_layout_hash(allFunctions),)
     text += "#undef MAPI_TMP_TABLE\n"
     text += "#endif /* MAPI_TMP_TABLE */\n"
     return text
 
-def generate_noop_array(functions):
+def generate_layout_hash(allFunctions):
+    # A 32-bit FNV-1a hash of every static function name in slot order, each
+    # followed by a NUL. A vendor library that builds its own array of
+    # functions in slot order can compute the same hash, so that
+    # libGLdispatch can tell whether the array matches its dispatch table.
+    value = 0x811c9dc5
+    for func in sorted(allFunctions, key=lambda f: f.slot):
+        for c in func.name.encode("ascii") + b"\0":
+            value = ((value ^ c) * 0x01000193) & 0xffffffff
+    return value
+
+def generate_noop_overflow():
+    # Every overflow chunk pointer in the no-op table points to the same chunk
+    # of no-op functions.
+    chunkSize = 1 << genCommon.MAPI_TABLE_OVERFLOW_CHUNK_SHIFT
+    return "static mapi_func table_noop_overflow_chunk[%d];\n\n" % (chunkSize,)
+
+def generate_noop_array(functions, numDynamic, numOverflowChunks):
+    # The no-op table gets the silent no-op function in every slot, or the
+    # reporting functions if error reporting is enabled. Either way, the table
+    # itself is left empty here, and table_init_noop fills it in when
+    # libGLdispatch is loaded, which is cheaper than a relocation for every
+    # entry.
     text = "#ifdef MAPI_TMP_NOOP_ARRAY\n"
-    text += "#ifdef DEBUG\n\n"
+    if (numOverflowChunks > 0):
+        text += generate_noop_overflow()
+    text += "mapi_func table_noop_array[%d];\n\n" % (len(functions) + numDynamic + numOverflowChunks,)
 
+    text += "#ifdef DEBUG\n\n"
     for func in functions:
         text += "static {f.rt} APIENTRY noop{f.basename}({f.decArgs})\n".format(f=func)
         text += "{\n"
@@ -108,19 +167,9 @@ def generate_noop_array(functions):
             text += "   return ({f.rt}) 0;\n".format(f=func)
         text += "}\n\n"
 
-    text += "const mapi_func table_noop_array[] = {\n"
+    text += "static const mapi_func table_noop_report_array[] = {\n"
     for func in functions:
         text += "   (mapi_func) noop{f.basename},\n".format(f=func)
-    for i in range(genCommon.MAPI_TABLE_NUM_DYNAMIC - 1):
-        text += "   (mapi_func) noop_generic,\n"
-    text += "   (mapi_func) noop_generic\n"
-    text += "};\n\n"
-    text += "#else /* DEBUG */\n\n"
-    text += "const mapi_func table_noop_array[] = {\n"
-    for i in range(len(functions) + genCommon.MAPI_TABLE_NUM_DYNAMIC - 1):
-        text += "   (mapi_func) noop_generic,\n"
-    text += "   (mapi_func) noop_generic\n"
-
     text += "};\n\n"
     text += "#endif /* DEBUG */\n"
     text += "#undef MAPI_TMP_NOOP_ARRAY\n"
@@ -130,28 +179,70 @@ def generate_noop_array(functions):
 def generate_public_stubs(functions):
     text = "#ifdef MAPI_TMP_PUBLIC_STUBS\n"
 
-    text += "static const struct mapi_stub public_stubs[] = {\n"
+    # The names are all in one string, with an offset for each one, rather
+    # than an array of pointers. A pointer would need a relocation for each
+    # function when the library is loaded.
+    text += "static const char public_stub_names[] =\n"
+    offsets = []
+    offset = 0
     for func in functions:
-        text += "   { \"%s\", %d },\n" % (func.name, func.slot)
+        text += "   \"%s\\0\"\n" % (func.name,)
+        offsets.append(offset)
+        offset += len(func.name) + 1
+    text += ";\n\n"
+
+    text += "static const unsigned int public_stub_name_offsets[] = {\n"
+    for offset in offsets:
+        text += "   %d,\n" % (offset,)
+    text += "};\n\n"
+
+    # Every name starts with "gl", and stub_find_public skips that prefix
+    # before hashing a name.
+    assert(all(func.name.startswith("gl") for func in functions))
+    (seeds, slots) = genCommon.buildPerfectHash([func.name[2:] for func in functions])
+
+    text += "#define PUBLIC_STUB_HASH_SEED_COUNT %d\n" % (len(seeds),)
+    text += "static const unsigned short public_stub_hash_seeds[] = {\n"
+    for seed in seeds:
+        text += "   %d,\n" % (seed,)
+    text += "};\n\n"
+
+    text += "static const struct mapi_stub_hash public_stub_hash_slots[] = {\n"
+    for (hashValue, index) in slots:
+        text += "   { 0x%08xu, %d },\n" % (hashValue, index)
     text += "};\n"
     text += "#undef MAPI_TMP_PUBLIC_STUBS\n"
     text += "#endif /* MAPI_TMP_PUBLIC_STUBS */\n"
     return text
 
+def generate_public_slots(functions):
+    # The dispatch table slots that this library's entrypoints use. A library
+    # registers these with libGLdispatch so that it only has to fill in those
+    # slots in each dispatch table.
+    text = "#ifdef MAPI_TMP_PUBLIC_SLOTS\n"
+    text += "static const int public_stub_slots[] = {\n"
+    for func in functions:
+        text += "   %d,\n" % (func.slot,)
+    text += "};\n"
+    text += "#undef MAPI_TMP_PUBLIC_SLOTS\n"
+    text += "#endif /* MAPI_TMP_PUBLIC_SLOTS */\n"
+    return text
+
 def generate_public_entries(functions):
     text = "#ifdef MAPI_TMP_PUBLIC_ENTRIES\n"
 
+    # Every stub ends with MAPI_TAIL_CALL, even if it doesn't return anything,
+    # so that it can jump to the vendor's function instead of calling it.
     for func in functions:
-        retStr = ("return " if func.hasReturn() else "")
         text += r"""
 GLAPI {f.rt} APIENTRY {f.name}({f.decArgs})
 {{
    const struct _glapi_table *_tbl = entry_current_get();
    mapi_func _func = ((const mapi_func *) _tbl)[{f.slot}];
-   {retStr}(({f.rt} (APIENTRY *)({f.decArgs})) _func)({f.callArgs});
+   MAPI_TAIL_CALL (({f.rt} (APIENTRY *)({f.decArgs})) _func)({f.callArgs});
 }}
 
-""".lstrip("\n").format(f=func, retStr=retStr)
+""".lstrip("\n").format(f=func)
 
     text += "\n"
     text += "static const mapi_func public_entries[] = {\n"
@@ -162,7 +253,30 @@ GLAPI {f.rt} APIENTRY {f.name}({f.decArgs})
     text += "#endif /* MAPI_TMP_PUBLIC_ENTRIES */\n"
     return text
 
-def generate_stub_asm_gcc(functions, includeDynamic):
+def generate_shared_entries(functions):
+    # Used for a client library built with --enable-shared-entrypoints. Each
+    # function is an IFUNC that resolves to libGLdispatch's stub for the same
+    # slot, so the library doesn't need any entrypoints of its own.
+    text = "#ifdef MAPI_TMP_SHARED_ENTRIES\n"
+    for func in functions:
+        text += r"""
+static void *resolve_{f.name}(void)
+{{
+   return (void *) __glDispatchGetPublicStub({f.slot});
+}}
+GLAPI {f.rt} APIENTRY {f.name}({f.decArgs})
+   __attribute__((ifunc("resolve_{f.name}")));
+""".lstrip("\n").format(f=func)
+    text += "#undef MAPI_TMP_SHARED_ENTRIES\n"
+    text += "#endif /* MAPI_TMP_SHARED_ENTRIES */\n"
+    return text
+
+def generate_stub_asm_gcc(functions, numDynamic):
+    # The stubs have to be in the same order as the public stub names, since
+    # entry_get_public finds a stub from its index. That's also slot order, so
+    # any hot functions from the profile get the first stubs, too.
+    assert(all(functions[i].slot < functions[i + 1].slot for i in range(len(functions) - 1)))
+
     text = "#ifdef MAPI_TMP_STUB_ASM_GCC\n"
     text += "__asm__(\n"
 
@@ -170,10 +284,9 @@ def generate_stub_asm_gcc(functions, includeDynamic):
         text += 'STUB_ASM_ENTRY("%s")"\\n"\n' % (func.name,)
         text += '"\\t"STUB_ASM_CODE("%d")"\\n"\n\n' % (func.slot,)
 
-    if (includeDynamic):
-        for i in range(genCommon.MAPI_TABLE_NUM_DYNAMIC):
-            text += 'STUB_ASM_ENTRY("dynamic_%04d")"\\n"\n' % (i,)
-            text += '"\\t"STUB_ASM_CODE("%d")"\\n"\n\n' % (len(functions) + i)
+    for i in range(numDynamic):
+        text += 'STUB_ASM_ENTRY("dynamic_%04d")"\\n"\n' % (i,)
+        text += '"\\t"STUB_ASM_CODE("%d")"\\n"\n\n' % (len(functions) + i)
     text += ");\n"
     text += "#undef MAPI_TMP_STUB_ASM_GCC\n"
     text += "#endif /* MAPI_TMP_STUB_ASM_GCC */\n"
@@ -29,18 +29,31 @@
 Generates the list of functions that should be exported from libOpenGL.so.
 """
 
+import argparse
 import sys
 import xml.etree.cElementTree as etree
 
 import genCommon
 
 def _main():
-    target = sys.argv[1]
-    xmlFiles = sys.argv[2:]
-    roots = [ etree.parse(filename).getroot() for filename in xmlFiles ]
-
-    names = genCommon.getExportNamesFromRoots(target, roots)
-    for name in sorted(names):
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--profile",
+            help="A file listing the most frequently called functions. Any "
+            "of those are listed first, in the same order as the profile.")
+    parser.add_argument("target",
+            choices=("gl", "gldispatch", "opengl", "glesv1", "glesv2"),
+            help="The library to list the exports for.")
+    parser.add_argument("xml_files", nargs="+",
+            help="The XML files with the OpenGL function lists.")
+    args = parser.parse_args()
+
+    roots = [ etree.parse(filename).getroot() for filename in args.xml_files ]
+
+    names = genCommon.getExportNamesFromRoots(args.target, roots)
+    hot = []
+    if (args.profile is not None):
+        hot = [name for name in genCommon.readProfile(args.profile) if (name in names)]
+    for name in hot + sorted(names.difference(hot)):
         print(name)
 
 if (__name__ == "__main__"):
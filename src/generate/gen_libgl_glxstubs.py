@@ -31,6 +31,7 @@ Generates src/GL/g_libglglxwrapper.c from Khronos's glx.xml file.
 This script generates stubs for every known extension function as well.
 """
 
+import argparse
 import sys
 import genCommon
 
@@ -107,13 +108,24 @@ def generateGLXExtensionStubFunction(func):
     return text.format(f=func, retVal=getDefaultReturnValue(func))
 
 def generateGLXCoreStubFunction(func):
-    text = "PUBLIC {f.rt} {f.name}({f.decArgs})\n"
+    # With USE_LIBGL_IFUNC, the dynamic linker binds each core function
+    # directly to libGLX's implementation, so there's no wrapper frame.
+    text = "#if defined(USE_LIBGL_IFUNC)\n"
+    text += "static void *__resolve_{f.name}(void)\n"
+    text += "{{\n"
+    text += "    return (void *) __GLXGL_CORE_FUNCTIONS.ptr_{f.name};\n"
+    text += "}}\n"
+    text += "PUBLIC {f.rt} {f.name}({f.decArgs})\n"
+    text += "    __attribute__((ifunc(\"__resolve_{f.name}\")));\n"
+    text += "#else\n"
+    text += "PUBLIC {f.rt} {f.name}({f.decArgs})\n"
     text += "{{\n"
     text += "    "
     if (func.hasReturn()):
         text += "return "
     text += "__GLXGL_CORE_FUNCTIONS.ptr_{f.name}({f.callArgs});\n"
-    text += "}}\n\n"
+    text += "}}\n"
+    text += "#endif\n\n"
     return text.format(f=func)
 
 def generateLibGLXStubs(functions):
@@ -127,10 +139,27 @@ def generateLibGLXStubs(functions):
 #include "compiler.h"
 #include "libglxgl.h"
 #include "glvnd_pthread.h"
+#include "glvnd_atomic.h"
 
-""".lstrip("\n")
+/*
+ * Once a function has been loaded, __glXGLLoadGLXFunction stores it with a
+ * release, so a stub can check for it with an acquire load and only take the
+ * mutex the first time.
+ */
+static inline __GLXextFuncPtr LoadGLXFunc(const char *name,
+        __GLXextFuncPtr *ptr, glvnd_mutex_t *mutex)
+{
+    __GLXextFuncPtr func = (__GLXextFuncPtr)
+        glvndAtomicLoadAcquirePtr((void * volatile *) ptr);
+    if (func != NULL) {
+        return func;
+    }
+    return __glXGLLoadGLXFunction(name, ptr, mutex);
+}
+
+#define LOAD_GLX_FUNC(name) LoadGLXFunc(#name, (__GLXextFuncPtr *) &__real_##name, &__mutex_##name)
 
-    text += "#define LOAD_GLX_FUNC(name) __glXGLLoadGLXFunction(#name, (__GLXextFuncPtr *) &__real_##name, &__mutex_##name)\n\n"
+""".lstrip("\n")
 
     for func in functions:
         if (func.name in _LIBGLX_FUNCTIONS):
@@ -180,7 +209,20 @@ def getDefaultReturnValue(func):
     return "0"
 
 def _main():
-    functions = genCommon.getFunctions(sys.argv[1:])
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--profile",
+            help="A file listing the most frequently called functions. The "
+            "stubs for any GLX functions in it come first, so that they end "
+            "up next to each other in libGL.so.")
+    parser.add_argument("xml_files", nargs="+",
+            help="The XML files with the GLX function lists.")
+    args = parser.parse_args()
+
+    hotNames = ()
+    if (args.profile is not None):
+        hotNames = genCommon.readProfile(args.profile)
+
+    functions = genCommon.getFunctions(args.xml_files, hotNames)
     functions = [f for f in functions if(f.name not in _SKIP_GLX_FUNCTIONS)]
 
     sys.stdout.write(generateLibGLXStubs(functions))
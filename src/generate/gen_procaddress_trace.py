@@ -0,0 +1,86 @@
+#!/usr/bin/env python
+
+# Copyright (c) 2026, NVIDIA CORPORATION.
+#
+# Permission is hereby granted, free of charge, to any person obtaining a
+# copy of this software and associated documentation files (the "Software"),
+# to deal in the Software without restriction, including without limitation
+# the rights to use, copy, modify, merge, publish, distribute, sublicense,
+# and/or sell copies of the Software, and to permit persons to whom the
+# Software is furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included
+# in all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+# THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+# FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+# DEALINGS IN THE SOFTWARE.
+
+"""
+Generates procaddress_trace.txt for benchgetprocaddress from Khronos's XML
+files. The build runs this to create the trace in the tests directory.
+
+The trace is the sequence of GetProcAddress calls that a generated loader
+like glad makes at startup: it walks each core version and then each
+extension in the order that the XML file lists them, and looks up every
+function that they require. A function that's part of several extensions
+gets looked up once for each of them, just like the real loaders do.
+
+Each line has the API that the name belongs to ("gl", "glx" or "egl") and
+the function name.
+"""
+
+import argparse
+import re
+import sys
+import xml.etree.ElementTree as etree
+
+def getLoaderNames(root, api):
+    """
+    Returns the function names that a loader would look up for one API, in
+    the order that it would look them up.
+    """
+    names = []
+    for feature in root.findall("feature"):
+        if feature.get("api") == api:
+            names.extend(_getRequiredCommands(feature))
+
+    apiPattern = re.compile(r"^(%s)$" % (api,))
+    for ext in root.find("extensions").findall("extension"):
+        supported = ext.get("supported", "").split("|")
+        if any(apiPattern.match(s) for s in supported):
+            names.extend(_getRequiredCommands(ext))
+    return names
+
+def _getRequiredCommands(elem):
+    names = []
+    for require in elem.findall("require"):
+        if require.get("api") not in (None, elem.get("api")):
+            continue
+        for cmd in require.findall("command"):
+            name = cmd.get("name")
+            if name not in names:
+                names.append(name)
+    return names
+
+def _main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("gl_xml", help="The path to gl.xml")
+    parser.add_argument("glx_xml", help="The path to glx.xml")
+    parser.add_argument("egl_xml", help="The path to egl.xml")
+    args = parser.parse_args()
+
+    print("# This file is automatically generated by gen_procaddress_trace.py.")
+    print("# Do not modify.")
+    for (api, filename) in (("gl", args.gl_xml), ("glx", args.glx_xml),
+            ("egl", args.egl_xml)):
+        root = etree.parse(filename).getroot()
+        for name in getLoaderNames(root, api):
+            print("%s %s" % (api, name))
+
+if (__name__ == "__main__"):
+    _main()
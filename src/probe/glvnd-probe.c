@@ -0,0 +1,475 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+/*!
+ * \file
+ *
+ * glvnd-probe: Reports what libglvnd costs on this machine, using the
+ * installed libraries and vendors.
+ *
+ * It loads the EGL vendors, creates a context on each EGL device (or on the
+ * default display if there aren't any), and makes it current. Along the way,
+ * it reports how long libglvnd took to find and load each vendor, how long
+ * it took to fill in each dispatch table, and how much each GL call through
+ * libOpenGL costs on top of the vendor's function. It also reports which
+ * dispatch stubs libGLdispatch is using, and whether it could patch them.
+ *
+ * The per-vendor times come from the slow operation watchdog in
+ * libGLdispatch. That has to be set up before libEGL is loaded, so the probe
+ * sets __GLVND_SLOW_OP_US and then runs itself again, with stderr sent to a
+ * temporary file that it reads back afterward.
+ *
+ * GLX isn't covered, since it would need an X server.
+ */
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GL/gl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "GLdispatch.h"
+
+/// The environment variable that tells the second run where its log and the
+/// original stderr are, as "<log fd>,<stderr fd>".
+#define PROBE_FDS_ENV "__GLVND_PROBE_FDS"
+
+#define DEFAULT_CALL_COUNT 1000000
+#define MAX_DEVICES 16
+
+static const char *SLOW_OP_PREFIX = "libglvnd: slow operation: ";
+
+static uint64_t GetTimeNS(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t) ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+static double ElapsedUS(uint64_t start)
+{
+    return (GetTimeNS() - start) / 1000.0;
+}
+
+/*!
+ * Sends stderr to a temporary file and runs the probe again with the slow
+ * operation watchdog enabled. This only returns if something failed, in
+ * which case the probe just goes on without the per-vendor times.
+ */
+static void ReExecWithSlowOps(char **argv)
+{
+    char fds[64];
+    FILE *log;
+    int savedStderr;
+
+    log = tmpfile();
+    if (log == NULL) {
+        return;
+    }
+    savedStderr = dup(STDERR_FILENO);
+    if (savedStderr < 0) {
+        fclose(log);
+        return;
+    }
+
+    snprintf(fds, sizeof(fds), "%d,%d", fileno(log), savedStderr);
+    setenv(PROBE_FDS_ENV, fds, 1);
+    setenv("__GLVND_SLOW_OP_US", "0", 1);
+
+    fflush(stderr);
+    if (dup2(fileno(log), STDERR_FILENO) >= 0) {
+        execv("/proc/self/exe", argv);
+        dup2(savedStderr, STDERR_FILENO);
+    }
+
+    fprintf(stderr, "glvnd-probe: Can't rerun the probe; per-vendor times "
+            "won't be reported.\n");
+    unsetenv(PROBE_FDS_ENV);
+    unsetenv("__GLVND_SLOW_OP_US");
+    close(savedStderr);
+    fclose(log);
+}
+
+/*!
+ * Returns the log that libglvnd is writing its slow operation reports to, and
+ * the original stderr in \p stderrFd. Returns NULL if this isn't the second
+ * run.
+ */
+static FILE *OpenSlowOpLog(int *stderrFd)
+{
+    const char *env = getenv(PROBE_FDS_ENV);
+    int logFd;
+
+    if (env == NULL || sscanf(env, "%d,%d", &logFd, stderrFd) != 2) {
+        return NULL;
+    }
+    return fdopen(logFd, "r");
+}
+
+/*!
+ * Prints the slow operation reports from libglvnd's log, and echoes anything
+ * else in it back to stderr.
+ */
+static void PrintSlowOps(FILE *log)
+{
+    char line[1024];
+    size_t prefixLen = strlen(SLOW_OP_PREFIX);
+    int found = 0;
+
+    printf("\nPer-vendor times:\n");
+    while (fgets(line, sizeof(line), log) != NULL) {
+        if (strncmp(line, SLOW_OP_PREFIX, prefixLen) != 0) {
+            fputs(line, stderr);
+            continue;
+        }
+
+        // LoadVendor covers the vendor's dlopen and its init function,
+        // FixupDispatchTable covers filling in a dispatch table the first
+        // time a context is made current, and PatchEntrypoints covers
+        // patching the entrypoints for a vendor.
+        if (strncmp(line + prefixLen, "LoadVendor", 10) == 0
+                || strncmp(line + prefixLen, "FixupDispatchTable", 18) == 0
+                || strncmp(line + prefixLen, "PatchEntrypoints", 16) == 0) {
+            printf("  %s", line + prefixLen);
+            found = 1;
+        }
+    }
+    if (!found) {
+        printf("  (none reported)\n");
+    }
+}
+
+static const char *GetStubFlavorName(int flavor)
+{
+    switch (flavor) {
+        case GLDISPATCH_STUB_FLAVOR_TLS:
+            return "TLS";
+        case GLDISPATCH_STUB_FLAVOR_STATIC_TLS:
+            return "static TLS";
+        case GLDISPATCH_STUB_FLAVOR_TSD:
+            return "TSD";
+        default:
+            return "unknown";
+    }
+}
+
+static const char *GetPatchDisabledName(int reason)
+{
+    switch (reason) {
+        case GLDISPATCH_PATCH_DISABLED_NONE:
+            return "no";
+        case GLDISPATCH_PATCH_DISABLED_ENV_VAR:
+            return "yes, by __GLVND_DISALLOW_PATCHING";
+        case GLDISPATCH_PATCH_DISABLED_APP_ERROR_CHECK:
+            return "yes, by __GLVND_APP_ERROR_CHECKING";
+        case GLDISPATCH_PATCH_DISABLED_CALL_COUNTS:
+            return "yes, by __GLVND_CALL_COUNTS";
+        case GLDISPATCH_PATCH_DISABLED_LAYERS:
+            return "yes, by the dispatch layers";
+        default:
+            return "yes";
+    }
+}
+
+static const char *GetPatchRefusalName(int refusal)
+{
+    switch (refusal) {
+        case GLDISPATCH_PATCH_REFUSED_NONE:
+            return "none";
+        case GLDISPATCH_PATCH_REFUSED_NO_STUBS:
+            return "the stubs can't be patched";
+        case GLDISPATCH_PATCH_REFUSED_DISABLED:
+            return "patching is disabled";
+        case GLDISPATCH_PATCH_REFUSED_OTHER_THREAD:
+            return "a context is current in another thread";
+        case GLDISPATCH_PATCH_REFUSED_OTHER_VENDOR:
+            return "another vendor owns the entrypoints";
+        default:
+            return "unknown";
+    }
+}
+
+static void PrintDispatchConfig(void)
+{
+    __GLdispatchConfig config;
+    __GLdispatchStats stats;
+
+    __glDispatchGetConfig(&config);
+    __glDispatchGetStatistics(&stats);
+
+    printf("\nDispatch:\n");
+    printf("  entrypoint type:    %s\n", config.entryType);
+    printf("  stub flavor:        %s\n", GetStubFlavorName(config.stubFlavor));
+    printf("  lazy dispatch:      %s\n", config.lazyDispatch ? "yes" : "no");
+    printf("  patching supported: %s\n", config.patchSupported ? "yes" : "no");
+    printf("  patching disabled:  %s\n",
+            GetPatchDisabledName(config.patchDisabledReason));
+    if (config.patchOwnerVendorID != 0) {
+        printf("  patched by:         vendor ID %d\n", config.patchOwnerVendorID);
+    } else {
+        printf("  patched by:         none\n");
+    }
+    if (config.patchRefusalCount != 0) {
+        printf("  patches refused:    %llu, last for vendor ID %d (%s)\n",
+                (unsigned long long) config.patchRefusalCount,
+                config.lastPatchRefusalVendorID,
+                GetPatchRefusalName(config.lastPatchRefusal));
+    }
+    printf("  dispatch tables:    %d\n", stats.tableCount);
+    printf("  slots resolved:     %llu\n",
+            (unsigned long long) stats.slotsResolved);
+}
+
+/*!
+ * An empty function to compare the GL calls against. It's called through a
+ * volatile pointer so that the compiler can't inline it.
+ */
+static GLenum BaselineFunc(void)
+{
+    return GL_NO_ERROR;
+}
+
+static void MeasureCallOverhead(long count)
+{
+    GLenum (* volatile baseline) (void) = BaselineFunc;
+    uint64_t start;
+    double glNS, baseNS;
+    long i;
+
+    // Warm up, so that the first call's fixup isn't counted.
+    glGetError();
+
+    start = GetTimeNS();
+    for (i = 0; i < count; i++) {
+        glGetError();
+    }
+    glNS = (double) (GetTimeNS() - start) / count;
+
+    start = GetTimeNS();
+    for (i = 0; i < count; i++) {
+        baseline();
+    }
+    baseNS = (double) (GetTimeNS() - start) / count;
+
+    printf("  glGetError:         %.2f ns/call (%ld calls)\n", glNS, count);
+    printf("  plain call:         %.2f ns/call\n", baseNS);
+    printf("  dispatch overhead:  %.2f ns/call, including the vendor's function\n",
+            glNS - baseNS);
+}
+
+/*!
+ * Creates a context on \p dpy and makes it current. Returns the context, or
+ * EGL_NO_CONTEXT if it couldn't.
+ */
+static EGLContext ProbeDisplay(EGLDisplay dpy, EGLSurface *surf)
+{
+    static const EGLint CONFIG_ATTRIBS[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_NONE
+    };
+    static const EGLint PBUFFER_ATTRIBS[] = {
+        EGL_WIDTH, 1,
+        EGL_HEIGHT, 1,
+        EGL_NONE
+    };
+    EGLint major = 0, minor = 0;
+    EGLConfig config = NULL;
+    EGLint numConfigs = 0;
+    EGLContext ctx;
+    uint64_t start;
+
+    start = GetTimeNS();
+    if (!eglInitialize(dpy, &major, &minor)) {
+        printf("  eglInitialize failed: 0x%04x\n", eglGetError());
+        return EGL_NO_CONTEXT;
+    }
+    printf("  eglInitialize:      %.1f us (EGL %d.%d)\n", ElapsedUS(start),
+            major, minor);
+
+    if (!eglBindAPI(EGL_OPENGL_API) && !eglBindAPI(EGL_OPENGL_ES_API)) {
+        printf("  No GL or GLES support\n");
+        return EGL_NO_CONTEXT;
+    }
+
+    // Without a config, the vendor has to support EGL_KHR_no_config_context.
+    if (!eglChooseConfig(dpy, CONFIG_ATTRIBS, &config, 1, &numConfigs)
+            || numConfigs < 1) {
+        config = NULL;
+    }
+
+    ctx = eglCreateContext(dpy, config, EGL_NO_CONTEXT, NULL);
+    if (ctx == EGL_NO_CONTEXT) {
+        printf("  eglCreateContext failed: 0x%04x\n", eglGetError());
+        return EGL_NO_CONTEXT;
+    }
+
+    // Try without a surface first, and fall back to a pbuffer.
+    *surf = EGL_NO_SURFACE;
+    start = GetTimeNS();
+    if (!eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, ctx)) {
+        if (config != NULL) {
+            *surf = eglCreatePbufferSurface(dpy, config, PBUFFER_ATTRIBS);
+        }
+        start = GetTimeNS();
+        if (*surf == EGL_NO_SURFACE
+                || !eglMakeCurrent(dpy, *surf, *surf, ctx)) {
+            printf("  eglMakeCurrent failed: 0x%04x\n", eglGetError());
+            eglDestroyContext(dpy, ctx);
+            return EGL_NO_CONTEXT;
+        }
+    }
+    printf("  first MakeCurrent:  %.1f us\n", ElapsedUS(start));
+    return ctx;
+}
+
+static void PrintGLString(const char *label, GLenum name)
+{
+    const GLubyte *str = glGetString(name);
+
+    printf("  %s %s\n", label, (str != NULL ? (const char *) str : "(none)"));
+}
+
+static void PrintUsage(const char *name)
+{
+    printf("Usage: %s [-n calls]\n", name);
+    printf("Reports what libglvnd costs on this machine.\n");
+    printf("  -n calls  The number of GL calls to time (default %d)\n",
+            DEFAULT_CALL_COUNT);
+}
+
+int main(int argc, char **argv)
+{
+    PFNEGLQUERYDEVICESEXTPROC ptr_eglQueryDevicesEXT;
+    EGLDeviceEXT devices[MAX_DEVICES];
+    EGLint deviceCount = 0;
+    long callCount = DEFAULT_CALL_COUNT;
+    int measured = 0;
+    FILE *log;
+    int stderrFd = -1;
+    uint64_t start;
+    double discoveryUS;
+    int opt;
+    int i;
+
+    while ((opt = getopt(argc, argv, "n:h")) != -1) {
+        switch (opt) {
+            case 'n':
+                callCount = atol(optarg);
+                if (callCount <= 0) {
+                    PrintUsage(argv[0]);
+                    return 1;
+                }
+                break;
+            default:
+                PrintUsage(argv[0]);
+                return (opt == 'h' ? 0 : 1);
+        }
+    }
+
+    log = OpenSlowOpLog(&stderrFd);
+    if (log == NULL && getenv(PROBE_FDS_ENV) == NULL) {
+        ReExecWithSlowOps(argv);
+    }
+
+    // Asking for the client extensions makes libEGL find and load every
+    // vendor.
+    start = GetTimeNS();
+    eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    discoveryUS = ElapsedUS(start);
+
+    printf("Vendors:\n");
+    printf("  discovery and load: %.1f us, for every EGL vendor\n", discoveryUS);
+
+    ptr_eglQueryDevicesEXT = (PFNEGLQUERYDEVICESEXTPROC)
+        eglGetProcAddress("eglQueryDevicesEXT");
+    if (ptr_eglQueryDevicesEXT == NULL
+            || !ptr_eglQueryDevicesEXT(MAX_DEVICES, devices, &deviceCount)) {
+        deviceCount = 0;
+    }
+
+    // Try each device, so that each vendor gets its own first MakeCurrent.
+    // If there aren't any devices, then fall back to the default display.
+    for (i = 0; i < (deviceCount > 0 ? deviceCount : 1); i++) {
+        EGLDisplay dpy;
+        EGLSurface surf = EGL_NO_SURFACE;
+        EGLContext ctx;
+
+        if (deviceCount > 0) {
+            printf("\nDevice %d:\n", i);
+            dpy = eglGetPlatformDisplay(EGL_PLATFORM_DEVICE_EXT, devices[i], NULL);
+        } else {
+            printf("\nDefault display:\n");
+            dpy = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+        }
+        if (dpy == EGL_NO_DISPLAY) {
+            printf("  No display: 0x%04x\n", eglGetError());
+            continue;
+        }
+
+        ctx = ProbeDisplay(dpy, &surf);
+        if (ctx == EGL_NO_CONTEXT) {
+            continue;
+        }
+
+        PrintGLString("GL_VENDOR:         ", GL_VENDOR);
+        PrintGLString("GL_RENDERER:       ", GL_RENDERER);
+
+        // The stub overhead is the same for every vendor, so only measure it
+        // once.
+        if (!measured) {
+            MeasureCallOverhead(callCount);
+            measured = 1;
+        }
+
+        eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        eglDestroyContext(dpy, ctx);
+        if (surf != EGL_NO_SURFACE) {
+            eglDestroySurface(dpy, surf);
+        }
+    }
+
+    PrintDispatchConfig();
+
+    if (log != NULL) {
+        // Put stderr back, so that PrintSlowOps can pass along anything else
+        // that ended up in the log.
+        fflush(stderr);
+        dup2(stderrFd, STDERR_FILENO);
+        close(stderrFd);
+        rewind(log);
+        PrintSlowOps(log);
+        fclose(log);
+    }
+
+    return (measured ? 0 : 1);
+}
@@ -32,16 +32,29 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdarg.h>
+#include <string.h>
+
+#include "glvnd_atomic.h"
+#include "utils_misc.h"
+
+#define DEFAULT_REPORT_INTERVAL 1
 
 static int errorCheckingEnabled = 0;
 static int reportAppErrorsEnabled = 0;
 static int abortOnAppError = 0;
+static int reportInterval = DEFAULT_REPORT_INTERVAL;
+
+/**
+ * Every site that has reported an error at least once. Sites are only ever
+ * added, so this is a lock-free list.
+ */
+static glvndAppErrorSite * volatile reportedSites = NULL;
 
 void glvndAppErrorCheckInit(void)
 {
     const char *env;
 
-    env = getenv("__GLVND_APP_ERROR_CHECKING");
+    env = glvndGetEnv("__GLVND_APP_ERROR_CHECKING");
     if (env != NULL) {
         errorCheckingEnabled = (atoi(env) != 0 ? 1 : 0);
         if (errorCheckingEnabled) {
@@ -50,28 +63,102 @@ void glvndAppErrorCheckInit(void)
         }
     }
 
-    env = getenv("__GLVND_ABORT_ON_APP_ERROR");
+    env = glvndGetEnv("__GLVND_ABORT_ON_APP_ERROR");
     if (env != NULL) {
         abortOnAppError = (atoi(env) != 0 ? 1 : 0);
         if (abortOnAppError) {
             reportAppErrorsEnabled = 1;
         }
     }
+
+    env = glvndGetEnv("__GLVND_APP_ERROR_REPORT_INTERVAL");
+    if (env != NULL) {
+        reportInterval = atoi(env);
+        if (reportInterval < 1) {
+            reportInterval = 1;
+        }
+    }
 }
 
-void glvndAppErrorCheckReportError(const char *format, ...)
+static void PrintMessage(const char *message, unsigned long count,
+        const char *suffix)
 {
-    if (reportAppErrorsEnabled) {
-        va_list args;
+    size_t len = strlen(message);
+
+    if (len > 0 && message[len - 1] == '\n') {
+        len--;
+    }
+    fprintf(stderr, "%.*s (%lu %s)\n", (int) len, message, count, suffix);
+}
+
+static void AddReportedSite(glvndAppErrorSite *site)
+{
+    glvndAppErrorSite *head;
+
+    do {
+        head = (glvndAppErrorSite *) glvndAtomicLoadAcquirePtr(
+                (void * volatile *) &reportedSites);
+        site->next = head;
+    } while (!glvndAtomicCompareExchangePtr((void * volatile *) &reportedSites,
+                head, site));
+}
+
+void glvndAppErrorCheckReportErrorAt(glvndAppErrorSite *site,
+        const char *format, ...)
+{
+    va_list args;
+    unsigned long count;
+
+    if (!reportAppErrorsEnabled) {
+        return;
+    }
+
+    count = glvndAtomicIncrement(&site->count);
+
+    if (count == 1) {
+        // Print the first error as-is, and keep a copy for the summary.
+        va_start(args, format);
+        vsnprintf(site->message, sizeof(site->message), format, args);
+        va_end(args);
+        AddReportedSite(site);
+
+        va_start(args, format);
+        vfprintf(stderr, format, args);
+        va_end(args);
+        fflush(stderr);
+    } else if (reportInterval == 1) {
         va_start(args, format);
         vfprintf(stderr, format, args);
         va_end(args);
         fflush(stderr);
+    } else if (count % reportInterval == 0) {
+        char message[sizeof(site->message)];
 
-        if (abortOnAppError) {
-            abort();
+        va_start(args, format);
+        vsnprintf(message, sizeof(message), format, args);
+        va_end(args);
+        PrintMessage(message, count, "times so far");
+        fflush(stderr);
+    }
+
+    if (abortOnAppError) {
+        abort();
+    }
+}
+
+void glvndAppErrorCheckFini(void)
+{
+    glvndAppErrorSite *site =
+        (glvndAppErrorSite *) glvndAtomicLoadAcquirePtr(
+                (void * volatile *) &reportedSites);
+
+    for (; site != NULL; site = site->next) {
+        unsigned long count = site->count;
+        if (count > 1) {
+            PrintMessage(site->message, count, "times in total");
         }
     }
+    fflush(stderr);
 }
 
 int glvndAppErrorCheckGetEnabled(void)
@@ -79,3 +166,7 @@ int glvndAppErrorCheckGetEnabled(void)
     return errorCheckingEnabled;
 }
 
+int glvndAppErrorCheckGetReportEnabled(void)
+{
+    return reportAppErrorsEnabled;
+}
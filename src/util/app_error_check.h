@@ -53,6 +53,13 @@
  * __GLVND_ABORT_ON_APP_ERROR: If set to 1, then libglvnd will call \c abort(3)
  * when it detects an application error. This is enabled by default if
  * __GLVND_APP_ERROR_CHECKING is enabled, but the user can manually disable it.
+ *
+ * By default, every occurrence of an error is printed. If
+ * __GLVND_APP_ERROR_REPORT_INTERVAL is set to more than 1, then each place
+ * that reports an error only prints the first occurrence, and then one line
+ * for every __GLVND_APP_ERROR_REPORT_INTERVAL occurrences after that. Either
+ * way, any errors that happened more than once are listed again with their
+ * totals in \c glvndAppErrorCheckFini.
  */
 
 /**
@@ -61,19 +68,57 @@
  */
 void glvndAppErrorCheckInit(void);
 
+/**
+ * Prints a summary of any errors that were reported more than once.
+ *
+ * Each library that reports errors keeps its own counts, so each one should
+ * call this when it's unloaded.
+ */
+void glvndAppErrorCheckFini(void);
+
+/**
+ * The state for one place that reports an error. Use
+ * \c glvndAppErrorCheckReportError instead of declaring these directly.
+ */
+typedef struct glvndAppErrorSiteRec {
+    unsigned long volatile count;
+    struct glvndAppErrorSiteRec *next;
+
+    /// The first message from this site, for the summary.
+    char message[128];
+} glvndAppErrorSite;
+
+/**
+ * Reports an application error from the given site.
+ */
+void glvndAppErrorCheckReportErrorAt(glvndAppErrorSite *site,
+        const char *format, ...) PRINTFLIKE(2, 3);
+
 /**
  * Reports an application error.
  *
  * If __GLVND_ABORT_ON_APP_ERROR is enabled, then this will also cause the
  * process to abort, so it should only be used for clear errors.
  *
+ * Each use of this macro keeps its own count of how many times it's been
+ * reported. If __GLVND_APP_ERROR_REPORT_INTERVAL is set, then repeated errors
+ * are only formatted and printed once per interval.
+ *
  * \param format A printf-style format string.
  */
-void glvndAppErrorCheckReportError(const char *format, ...) PRINTFLIKE(1, 2);
+#define glvndAppErrorCheckReportError(...) do { \
+    static glvndAppErrorSite _glvndAppErrorSite; \
+    glvndAppErrorCheckReportErrorAt(&_glvndAppErrorSite, __VA_ARGS__); \
+} while (0)
 
 /**
  * Returns non-zero if error checking is enabled.
  */
 int glvndAppErrorCheckGetEnabled(void);
 
+/**
+ * Returns non-zero if \c glvndAppErrorCheckReportError will print anything.
+ */
+int glvndAppErrorCheckGetReportEnabled(void);
+
 #endif // __APP_ERROR_CHECK_H
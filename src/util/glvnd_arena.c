@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+#include "glvnd_arena.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "glvnd_memstats.h"
+
+/*!
+ * The alignment of each allocation.
+ */
+#define ARENA_ALIGN (2 * sizeof(void *))
+
+#define ARENA_ROUND_UP(size) (((size) + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1))
+
+typedef struct __GLVNDarenaBlockRec {
+    struct __GLVNDarenaBlockRec *next;
+    size_t size;
+    size_t used;
+} __GLVNDarenaBlock;
+
+struct __GLVNDarenaRec {
+    __GLVNDarenaBlock *blocks;
+    size_t blockSize;
+    int memClass;
+};
+
+#define ARENA_BLOCK_HEADER_SIZE ARENA_ROUND_UP(sizeof(__GLVNDarenaBlock))
+
+static __GLVNDarenaBlock *AllocBlock(size_t size, int memClass)
+{
+    __GLVNDarenaBlock *block = calloc(1, ARENA_BLOCK_HEADER_SIZE + size);
+    if (block == NULL) {
+        return NULL;
+    }
+    glvndMemStatsAlloc(memClass, ARENA_BLOCK_HEADER_SIZE + size);
+    block->size = size;
+    return block;
+}
+
+static void *BlockAlloc(__GLVNDarenaBlock *block, size_t size)
+{
+    void *ptr = ((char *) block) + ARENA_BLOCK_HEADER_SIZE + block->used;
+    block->used += ARENA_ROUND_UP(size);
+    return ptr;
+}
+
+__GLVNDarena *__glvndArenaCreate(size_t blockSize, int memClass)
+{
+    __GLVNDarenaBlock *block;
+    __GLVNDarena *arena;
+
+    blockSize = ARENA_ROUND_UP(blockSize);
+    if (blockSize < ARENA_ROUND_UP(sizeof(__GLVNDarena))) {
+        blockSize = ARENA_ROUND_UP(sizeof(__GLVNDarena));
+    }
+
+    block = AllocBlock(blockSize, memClass);
+    if (block == NULL) {
+        return NULL;
+    }
+
+    arena = BlockAlloc(block, sizeof(__GLVNDarena));
+    arena->blocks = block;
+    arena->blockSize = blockSize;
+    arena->memClass = memClass;
+    return arena;
+}
+
+void *__glvndArenaAlloc(__GLVNDarena *arena, size_t size)
+{
+    __GLVNDarenaBlock *block = arena->blocks;
+    size_t rounded = ARENA_ROUND_UP(size);
+
+    if (rounded < size) {
+        return NULL;
+    }
+
+    if (block->size - block->used < rounded) {
+        if (rounded > arena->blockSize / 2) {
+            // A large allocation gets a block of its own. Put it after the
+            // current block, so that the rest of the current block can still
+            // be used.
+            block = AllocBlock(rounded, arena->memClass);
+            if (block == NULL) {
+                return NULL;
+            }
+            block->next = arena->blocks->next;
+            arena->blocks->next = block;
+        } else {
+            block = AllocBlock(arena->blockSize, arena->memClass);
+            if (block == NULL) {
+                return NULL;
+            }
+            block->next = arena->blocks;
+            arena->blocks = block;
+        }
+    }
+
+    return BlockAlloc(block, rounded);
+}
+
+void __glvndArenaDestroy(__GLVNDarena *arena)
+{
+    __GLVNDarenaBlock *block;
+    int memClass;
+
+    if (arena == NULL) {
+        return;
+    }
+
+    // The arena itself is in the last block, so save anything we need
+    // before freeing it.
+    block = arena->blocks;
+    memClass = arena->memClass;
+    while (block != NULL) {
+        __GLVNDarenaBlock *next = block->next;
+        glvndMemStatsFree(memClass, ARENA_BLOCK_HEADER_SIZE + block->size);
+        free(block);
+        block = next;
+    }
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+#if !defined(__GLVND_ARENA_H)
+#define __GLVND_ARENA_H
+
+#include <stddef.h>
+
+/*!
+ * \file
+ *
+ * A simple arena allocator, for data that lives exactly as long as some
+ * other object, like a vendor library or a display.
+ *
+ * Memory is handed out from large blocks, and nothing is freed until the
+ * whole arena is destroyed. The arena doesn't do any locking, so the caller
+ * has to serialize any allocations from the same arena.
+ */
+
+typedef struct __GLVNDarenaRec __GLVNDarena;
+
+/*!
+ * Creates a new arena.
+ *
+ * The arena's own bookkeeping is stored in its first block, so creating an
+ * arena only takes one allocation.
+ *
+ * \param blockSize The size of each block of memory. Any allocation that
+ *      doesn't fit in a block gets a block of its own.
+ * \param memClass The GLVND_MEM_* value to count the blocks under.
+ * \return The new arena, or NULL on failure.
+ */
+__GLVNDarena *__glvndArenaCreate(size_t blockSize, int memClass);
+
+/*!
+ * Allocates zero-filled memory from an arena. The memory is aligned for any
+ * type.
+ *
+ * \return The new memory, or NULL on failure.
+ */
+void *__glvndArenaAlloc(__GLVNDarena *arena, size_t size);
+
+/*!
+ * Frees an arena and everything that was allocated from it.
+ */
+void __glvndArenaDestroy(__GLVNDarena *arena);
+
+#endif // !defined(__GLVND_ARENA_H)
@@ -0,0 +1,246 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+#if !defined(__GLVND_ATOMIC_H)
+#define __GLVND_ATOMIC_H
+
+/*!
+ * \file
+ *
+ * Helper functions for publishing data between threads without a lock.
+ *
+ * A writer fills in a structure and then stores a pointer or count to it with
+ * \c glvndAtomicStoreRelease. A reader that loads that value with
+ * \c glvndAtomicLoadAcquire is then guaranteed to see everything the writer
+ * wrote before the store.
+ *
+ * Writers still need to be serialized with a lock. These functions only make
+ * it safe for readers to skip that lock. The exception is
+ * \c glvndAtomicCompareExchange and \c glvndAtomicCompareExchangePtr, which
+ * can be used for simple lock-free updates such as claiming a flag or pushing
+ * onto a list that's never popped, \c glvndAtomicIncrement,
+ * \c glvndAtomicAdd, and \c glvndAtomicFence.
+ */
+
+#if defined(__ATOMIC_ACQUIRE)
+
+static inline int glvndAtomicLoadAcquire(int volatile *ptr)
+{
+    return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+}
+
+static inline void glvndAtomicStoreRelease(int volatile *ptr, int val)
+{
+    __atomic_store_n(ptr, val, __ATOMIC_RELEASE);
+}
+
+static inline void *glvndAtomicLoadAcquirePtr(void * volatile *ptr)
+{
+    return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+}
+
+static inline void glvndAtomicStoreReleasePtr(void * volatile *ptr, void *val)
+{
+    __atomic_store_n(ptr, val, __ATOMIC_RELEASE);
+}
+
+/*!
+ * Atomically replaces \p *ptr with \p desired if it's equal to \p expected.
+ *
+ * \return Non-zero if the value was replaced.
+ */
+static inline int glvndAtomicCompareExchange(int volatile *ptr, int expected, int desired)
+{
+    return __atomic_compare_exchange_n(ptr, &expected, desired, 0,
+            __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+
+static inline int glvndAtomicCompareExchangePtr(void * volatile *ptr, void *expected, void *desired)
+{
+    return __atomic_compare_exchange_n(ptr, &expected, desired, 0,
+            __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+
+/*!
+ * Atomically adds one to \p *ptr.
+ *
+ * \return The new value.
+ */
+static inline unsigned long glvndAtomicIncrement(unsigned long volatile *ptr)
+{
+    return __atomic_add_fetch(ptr, 1, __ATOMIC_ACQ_REL);
+}
+
+/*!
+ * Atomically adds \p delta to \p *ptr.
+ *
+ * \return The new value.
+ */
+static inline int glvndAtomicAdd(int volatile *ptr, int delta)
+{
+    return __atomic_add_fetch(ptr, delta, __ATOMIC_ACQ_REL);
+}
+
+/*!
+ * A full memory barrier. Unlike the acquire and release functions, this also
+ * keeps a store from being reordered with a later load.
+ */
+static inline void glvndAtomicFence(void)
+{
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+#elif defined(HAVE_SYNC_INTRINSICS) || defined(USE_X86_ASM) || defined(USE_X86_64_ASM)
+
+#if defined(HAVE_SYNC_INTRINSICS)
+#define GLVND_MEMORY_BARRIER() __sync_synchronize()
+#else
+// x86 doesn't reorder loads with other loads or stores with other stores, so
+// we only need to keep the compiler from reordering anything.
+#define GLVND_MEMORY_BARRIER() __asm __volatile__ ("" : : : "memory")
+#endif
+
+static inline int glvndAtomicLoadAcquire(int volatile *ptr)
+{
+    int val = *ptr;
+    GLVND_MEMORY_BARRIER();
+    return val;
+}
+
+static inline void glvndAtomicStoreRelease(int volatile *ptr, int val)
+{
+    GLVND_MEMORY_BARRIER();
+    *ptr = val;
+}
+
+static inline void *glvndAtomicLoadAcquirePtr(void * volatile *ptr)
+{
+    void *val = *ptr;
+    GLVND_MEMORY_BARRIER();
+    return val;
+}
+
+static inline void glvndAtomicStoreReleasePtr(void * volatile *ptr, void *val)
+{
+    GLVND_MEMORY_BARRIER();
+    *ptr = val;
+}
+
+#if defined(HAVE_SYNC_INTRINSICS)
+static inline int glvndAtomicCompareExchange(int volatile *ptr, int expected, int desired)
+{
+    return __sync_bool_compare_and_swap(ptr, expected, desired);
+}
+
+static inline int glvndAtomicCompareExchangePtr(void * volatile *ptr, void *expected, void *desired)
+{
+    return __sync_bool_compare_and_swap(ptr, expected, desired);
+}
+
+static inline unsigned long glvndAtomicIncrement(unsigned long volatile *ptr)
+{
+    return __sync_add_and_fetch(ptr, 1);
+}
+
+static inline int glvndAtomicAdd(int volatile *ptr, int delta)
+{
+    return __sync_add_and_fetch(ptr, delta);
+}
+#else
+static inline int glvndAtomicCompareExchange(int volatile *ptr, int expected, int desired)
+{
+    int prev;
+    __asm __volatile__ ("lock; cmpxchg %2, %1"
+            : "=a" (prev), "+m" (*ptr)
+            : "r" (desired), "0" (expected)
+            : "memory");
+    return (prev == expected);
+}
+
+static inline int glvndAtomicCompareExchangePtr(void * volatile *ptr, void *expected, void *desired)
+{
+    void *prev;
+    __asm __volatile__ ("lock; cmpxchg %2, %1"
+            : "=a" (prev), "+m" (*ptr)
+            : "r" (desired), "0" (expected)
+            : "memory");
+    return (prev == expected);
+}
+
+static inline unsigned long glvndAtomicIncrement(unsigned long volatile *ptr)
+{
+    unsigned long prev = 1;
+    __asm __volatile__ ("lock; xadd %0, %1"
+            : "+r" (prev), "+m" (*ptr)
+            :
+            : "memory");
+    return prev + 1;
+}
+
+static inline int glvndAtomicAdd(int volatile *ptr, int delta)
+{
+    int prev = delta;
+    __asm __volatile__ ("lock; xaddl %0, %1"
+            : "+r" (prev), "+m" (*ptr)
+            :
+            : "memory");
+    return prev + delta;
+}
+#endif
+
+static inline void glvndAtomicFence(void)
+{
+#if defined(HAVE_SYNC_INTRINSICS)
+    __sync_synchronize();
+#elif defined(USE_X86_64_ASM)
+    __asm __volatile__ ("mfence" : : : "memory");
+#else
+    __asm __volatile__ ("lock; addl $0, (%%esp)" : : : "memory");
+#endif
+}
+
+#else
+#error "Not implemented"
+#endif
+
+/**
+ * Tells the CPU that the caller is in a spin-wait loop.
+ */
+static inline void glvndCpuRelax(void)
+{
+#if defined(__i386__) || defined(__x86_64__)
+    __asm __volatile__ ("pause" : : : "memory");
+#elif defined(__aarch64__)
+    __asm __volatile__ ("yield" : : : "memory");
+#else
+    __asm __volatile__ ("" : : : "memory");
+#endif
+}
+
+#endif // !defined(__GLVND_ATOMIC_H)
@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+#include "glvnd_exit.h"
+
+#include <stdlib.h>
+#include <dlfcn.h>
+
+#include "utils_misc.h"
+
+static int fastExitEnabled = 0;
+
+int glvndPinLibrary(const void *addr)
+{
+#if defined(HAVE_RTLD_NOLOAD) && defined(RTLD_NODELETE)
+    Dl_info info;
+
+    if (dladdr((void *) addr, &info) == 0 || info.dli_fname == NULL) {
+        return 0;
+    }
+    return (dlopen(info.dli_fname, RTLD_LAZY | RTLD_NOLOAD | RTLD_NODELETE) != NULL);
+#else
+    return 0;
+#endif
+}
+
+int glvndFastExitInit(const void *addr)
+{
+    const char *env = glvndGetEnv("__GLVND_FAST_EXIT");
+
+    if (env != NULL && atoi(env) != 0 && glvndPinLibrary(addr)) {
+        fastExitEnabled = 1;
+    }
+    return fastExitEnabled;
+}
+
+int glvndFastExitEnabled(void)
+{
+    return fastExitEnabled;
+}
@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+#if !defined(__GLVND_EXIT_H)
+#define __GLVND_EXIT_H
+
+/*!
+ * \file
+ *
+ * Support for the fast exit mode.
+ *
+ * Normally, each library's destructor frees all of its state, since the
+ * destructor also runs when an app unloads the library with dlclose. If the
+ * __GLVND_FAST_EXIT environment variable is set, then each library pins
+ * itself with RTLD_NODELETE instead. A pinned library is never unloaded, so
+ * its destructor only runs when the process is exiting, and it can skip
+ * everything except the work that the process can see, like writing out
+ * reports.
+ *
+ * Each library that links against this gets its own copy of the state.
+ */
+
+/*!
+ * Pins the library that contains \p addr, so that it stays loaded until the
+ * process exits.
+ *
+ * \return Non-zero on success, or zero if the library can't be pinned.
+ */
+int glvndPinLibrary(const void *addr);
+
+/*!
+ * Sets up the fast exit mode, if __GLVND_FAST_EXIT is set.
+ *
+ * This should be called from the library's constructor.
+ *
+ * \param addr The address of anything in the calling library.
+ * \return Non-zero if the fast exit mode is enabled.
+ */
+int glvndFastExitInit(const void *addr);
+
+/*!
+ * Returns non-zero if \c glvndFastExitInit enabled the fast exit mode.
+ *
+ * If this returns non-zero, then the library's destructor only runs at
+ * process exit, and it can leave its memory for the OS to clean up.
+ */
+int glvndFastExitEnabled(void);
+
+#endif // !defined(__GLVND_EXIT_H)
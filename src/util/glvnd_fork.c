@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+#include "glvnd_fork.h"
+
+#include <pthread.h>
+
+#include "glvnd_pthread.h"
+#include "glvnd_atomic.h"
+#include "glvnd_probe.h"
+
+static void (*forkResetCallback)(void) = NULL;
+
+/*!
+ * The number of times that this process (or any of its parents, since the
+ * value is inherited) has forked. This is only modified in the child handler,
+ * when there's only one thread.
+ */
+static int volatile forkGeneration = 0;
+
+/*!
+ * The value of forkGeneration the last time the reset callback finished.
+ */
+static int volatile forkHandledGeneration = 0;
+
+/*!
+ * Serializes the reset callback after a fork. This is re-initialized in the
+ * child handler, since another thread might have held it when the process
+ * forked.
+ */
+static glvnd_mutex_t forkMutex = GLVND_MUTEX_INITIALIZER;
+
+static void ForkChildHandler(void)
+{
+    forkGeneration++;
+    __glvndPthreadFuncs.mutex_init(&forkMutex, NULL);
+}
+
+void glvndForkInit(void (*resetCallback)(void))
+{
+    forkResetCallback = resetCallback;
+
+    // Note that pthread_atfork records which DSO the handler belongs to, so
+    // glibc will remove it if this library gets unloaded.
+    pthread_atfork(NULL, NULL, ForkChildHandler);
+}
+
+void glvndCheckFork(void)
+{
+    int generation = forkGeneration;
+
+    if (glvndAtomicLoadAcquire(&forkHandledGeneration) == generation) {
+        return;
+    }
+
+    __glvndPthreadFuncs.mutex_lock(&forkMutex);
+    generation = forkGeneration;
+    if (forkHandledGeneration != generation) {
+        if (forkResetCallback != NULL) {
+            GLVND_PROBE1(fork_reset_begin, generation);
+            forkResetCallback();
+            GLVND_PROBE1(fork_reset_end, generation);
+        }
+        glvndAtomicStoreRelease(&forkHandledGeneration, generation);
+    }
+    __glvndPthreadFuncs.mutex_unlock(&forkMutex);
+}
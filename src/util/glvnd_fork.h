@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+#if !defined(__GLVND_FORK_H)
+#define __GLVND_FORK_H
+
+/*!
+ * \file
+ *
+ * Fork detection for the window system libraries.
+ *
+ * This installs a pthread_atfork child handler that bumps a generation
+ * counter, so that checking for a fork on each entrypoint only needs to read
+ * a couple of variables that don't change until the next fork.
+ *
+ * Each library that links against this gets its own copy of the state, so
+ * libGLX and libEGL will each notice a fork independently.
+ */
+
+/*!
+ * Installs the fork handler.
+ *
+ * \p resetCallback is called from \c glvndCheckFork the first time it's
+ * called after a fork, and should reset any state that the child process
+ * can't keep using.
+ *
+ * This must be called after \c glvndSetupPthreads.
+ */
+void glvndForkInit(void (*resetCallback)(void));
+
+/*!
+ * Checks whether a fork has happened since the last call, and if so, calls the
+ * reset callback that was passed to \c glvndForkInit.
+ *
+ * If several threads call this at once after a fork, then only one of them
+ * will call the reset callback, and the others will wait until it finishes.
+ */
+void glvndCheckFork(void);
+
+#endif // !defined(__GLVND_FORK_H)
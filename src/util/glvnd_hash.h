@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+#if !defined(__GLVND_HASH_H)
+#define __GLVND_HASH_H
+
+/*!
+ * \file
+ *
+ * Hash functions for the hashtables in libglvnd.
+ *
+ * Most of those tables are keyed by a handle, such as a pointer or an XID.
+ * Those go through a single multiply, instead of a byte-at-a-time hash. Any
+ * other key, including function names, is hashed with FNV-1a.
+ *
+ * The static function name tables are generated at build time, so
+ * \c glvndHashString and \c glvndHashSlot must match the nameHash and
+ * hashSlot functions in src/generate/genCommon.py.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/*!
+ * Hashes a pointer-sized integer.
+ *
+ * The result is taken from the high half of the product, so that every bit
+ * of \p value affects the low bits of the hash. That matters for pointers,
+ * since their low bits are usually zero.
+ */
+static inline unsigned int glvndHashWord(uintptr_t value)
+{
+#if UINTPTR_MAX > 0xFFFFFFFFu
+    return (unsigned int) ((((uint64_t) value) * 0x9E3779B97F4A7C15ull) >> 32);
+#else
+    uint64_t product = ((uint64_t) value) * 0x9E3779B9u;
+    return (unsigned int) (product ^ (product >> 32));
+#endif
+}
+
+/*!
+ * Computes the 32-bit FNV-1a hash of a buffer.
+ */
+static inline uint32_t glvndHashFNV1a(const void *data, size_t len)
+{
+    const unsigned char *ptr = (const unsigned char *) data;
+    uint32_t hash = 0x811c9dc5u;
+    size_t i;
+
+    for (i=0; i<len; i++) {
+        hash = (hash ^ ptr[i]) * 0x01000193u;
+    }
+    return hash;
+}
+
+/*!
+ * Computes the 32-bit FNV-1a hash of a null-terminated string.
+ */
+static inline uint32_t glvndHashString(const char *str)
+{
+    const unsigned char *ptr = (const unsigned char *) str;
+    uint32_t hash = 0x811c9dc5u;
+
+    for (; *ptr != '\0'; ptr++) {
+        hash = (hash ^ *ptr) * 0x01000193u;
+    }
+    return hash;
+}
+
+/*!
+ * Mixes a string hash with a seed value to select one of \p count slots in a
+ * generated perfect hash table.
+ */
+static inline uint32_t glvndHashSlot(uint32_t hash, uint32_t seed, uint32_t count)
+{
+    hash ^= seed * 0x9e3779b9u;
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6bu;
+    hash ^= hash >> 13;
+    hash *= 0xc2b2ae35u;
+    hash ^= hash >> 16;
+    return hash % count;
+}
+
+/*!
+ * Hashes a key of any length. Keys that are the size of a pointer are
+ * treated as a single integer.
+ */
+static inline unsigned int glvndHashBytes(const void *key, size_t keyLen)
+{
+    if (keyLen == sizeof(uintptr_t)) {
+        uintptr_t value;
+        memcpy(&value, key, sizeof(value));
+        return glvndHashWord(value);
+    } else {
+        return glvndHashFNV1a(key, keyLen);
+    }
+}
+
+/*!
+ * A hash function for uthash. To use it, define \c HASH_FUNCTION to
+ * \c GLVND_UTHASH_FUNCTION before including uthash.h.
+ */
+#define GLVND_UTHASH_FUNCTION(key, keylen, num_bkts, hashv, bkt) do { \
+    (hashv) = glvndHashBytes((key), (keylen)); \
+    (bkt) = (hashv) & ((num_bkts) - 1); \
+} while (0)
+
+#endif // !defined(__GLVND_HASH_H)
@@ -0,0 +1,943 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+#include "glvnd_hashmap.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "glvnd_atomic.h"
+#include "glvnd_hash.h"
+#include "glvnd_memstats.h"
+
+/*!
+ * The number of buckets in a new table. This must be a power of two, and at
+ * least \c GLVND_HASHMAP_LOCK_COUNT, so that every node in a bucket uses the
+ * same lock.
+ */
+#define INITIAL_TABLE_SIZE 64
+
+/*!
+ * The table is resized once it has this many entries per bucket.
+ */
+#define MAX_LOAD_FACTOR 2
+
+/*!
+ * Epochs are stored shifted left by one, with the low bit set while a thread
+ * is in a read section, so they're limited to 30 bits.
+ */
+#define EPOCH_MASK 0x3FFFFFFF
+
+enum {
+    RETIRED_NODE,
+    RETIRED_NODE_AND_VALUE,
+    RETIRED_TABLE,
+};
+
+struct __GLVNDhashMapRetiredRec {
+    __GLVNDhashMapRetired *next;
+    int epoch;
+    int type;
+};
+
+struct __GLVNDhashMapNodeRec {
+    /// Used once the node has been removed.
+    __GLVNDhashMapRetired retired;
+
+    __GLVNDhashMapNode * volatile next;
+    void *value;
+    unsigned int hash;
+    size_t keyLen;
+    unsigned char key[];
+};
+
+struct __GLVNDhashMapTableRec {
+    __GLVNDhashMapRetired retired;
+    size_t size;
+    __GLVNDhashMapNode * volatile buckets[];
+};
+
+/*!
+ * The read section state for a thread.
+ *
+ * These are kept in a list that's only ever pushed onto, so that a writer can
+ * walk through it without a lock. When a thread exits, its record is marked
+ * as unused, and the next new thread takes it over.
+ */
+typedef struct __GLVNDhashMapReaderRec {
+    /*!
+     * The epoch that the thread saw when it entered its read section, shifted
+     * left by one with the low bit set, or zero if the thread isn't in a
+     * read section.
+     */
+    int volatile epoch;
+    int depth;
+    int volatile inUse;
+    struct __GLVNDhashMapReaderRec *next;
+} __GLVNDhashMapReader;
+
+static __GLVNDhashMapReader * volatile readerList = NULL;
+
+/*!
+ * The current epoch. A retired node is freed once the epoch has gone up by
+ * two, which can only happen once every thread that was in a read section
+ * when it was retired has left it.
+ */
+static int volatile globalEpoch = 0;
+static glvnd_mutex_t epochLock = GLVND_MUTEX_INITIALIZER;
+
+/*!
+ * Set if we couldn't allocate a thread's read section state. After that, we
+ * can't tell when it's safe to free anything, so retired nodes are just kept
+ * until the map is torn down.
+ */
+static int volatile reclaimDisabled = 0;
+
+static glvnd_once_t readerKeyOnce = GLVND_ONCE_INIT;
+static glvnd_key_t readerKey;
+static int readerKeyValid = 0;
+
+#if defined(GLDISPATCH_USE_TLS)
+static __thread __GLVNDhashMapReader *currentReader
+    __attribute__((tls_model("initial-exec"))) = NULL;
+#endif
+
+static unsigned int HashKey(const void *key, size_t keyLen)
+{
+    return glvndHashBytes(key, keyLen);
+}
+
+static glvnd_mutex_t *GetKeyLock(__GLVNDhashMap *map, unsigned int hash)
+{
+    return &map->locks[hash & (GLVND_HASHMAP_LOCK_COUNT - 1)];
+}
+
+static void AtomicAdd(int volatile *ptr, int delta)
+{
+    int old;
+    do {
+        old = glvndAtomicLoadAcquire(ptr);
+    } while (!glvndAtomicCompareExchange(ptr, old, old + delta));
+}
+
+static void ReleaseReader(void *data)
+{
+    __GLVNDhashMapReader *reader = (__GLVNDhashMapReader *) data;
+
+    reader->depth = 0;
+    glvndAtomicStoreRelease(&reader->epoch, 0);
+    glvndAtomicStoreRelease(&reader->inUse, 0);
+#if defined(GLDISPATCH_USE_TLS)
+    currentReader = NULL;
+#endif
+}
+
+static void CreateReaderKey(void)
+{
+    if (__glvndPthreadFuncs.key_create(&readerKey, ReleaseReader) == 0) {
+        readerKeyValid = 1;
+    }
+}
+
+static __GLVNDhashMapReader *AcquireReader(void)
+{
+    __GLVNDhashMapReader *reader;
+    __GLVNDhashMapReader *head;
+
+    for (reader = (__GLVNDhashMapReader *) glvndAtomicLoadAcquirePtr((void * volatile *) &readerList);
+            reader != NULL; reader = reader->next) {
+        if (reader->inUse == 0 && glvndAtomicCompareExchange(&reader->inUse, 0, 1)) {
+            reader->depth = 0;
+            return reader;
+        }
+    }
+
+    reader = (__GLVNDhashMapReader *) calloc(1, sizeof(__GLVNDhashMapReader));
+    if (reader == NULL) {
+        return NULL;
+    }
+    reader->inUse = 1;
+    do {
+        head = (__GLVNDhashMapReader *) glvndAtomicLoadAcquirePtr((void * volatile *) &readerList);
+        reader->next = head;
+    } while (!glvndAtomicCompareExchangePtr((void * volatile *) &readerList, head, reader));
+
+    return reader;
+}
+
+/*!
+ * Returns the current thread's read section state, without allocating it.
+ */
+static __GLVNDhashMapReader *FindCurrentReader(void)
+{
+#if defined(GLDISPATCH_USE_TLS)
+    return currentReader;
+#else
+    if (readerKeyValid) {
+        return (__GLVNDhashMapReader *) __glvndPthreadFuncs.getspecific(readerKey);
+    }
+    return NULL;
+#endif
+}
+
+static __GLVNDhashMapReader *GetCurrentReader(void)
+{
+    __GLVNDhashMapReader *reader = FindCurrentReader();
+
+    if (reader != NULL) {
+        return reader;
+    }
+
+    __glvndPthreadFuncs.once(&readerKeyOnce, CreateReaderKey);
+    if (!readerKeyValid) {
+        // Without a key, we'd have to allocate a new record each time.
+        reader = NULL;
+    } else {
+        reader = FindCurrentReader();
+        if (reader == NULL) {
+            reader = AcquireReader();
+            if (reader != NULL) {
+                __glvndPthreadFuncs.setspecific(readerKey, reader);
+#if defined(GLDISPATCH_USE_TLS)
+                currentReader = reader;
+#endif
+            }
+        }
+    }
+
+    if (reader == NULL) {
+        glvndAtomicStoreRelease(&reclaimDisabled, 1);
+        glvndAtomicFence();
+    }
+    return reader;
+}
+
+void __glvndHashMapReadBegin(void)
+{
+    __GLVNDhashMapReader *reader = GetCurrentReader();
+
+    if (reader != NULL && reader->depth++ == 0) {
+        int epoch = glvndAtomicLoadAcquire(&globalEpoch);
+        glvndAtomicStoreRelease(&reader->epoch, (epoch << 1) | 1);
+        // Make sure that any writer that looks at our epoch after this point
+        // will see it before we load any nodes.
+        glvndAtomicFence();
+    }
+}
+
+void __glvndHashMapReadEnd(void)
+{
+    __GLVNDhashMapReader *reader = FindCurrentReader();
+
+    if (reader != NULL) {
+        assert(reader->depth > 0);
+        if (--reader->depth == 0) {
+            glvndAtomicStoreRelease(&reader->epoch, 0);
+        }
+    }
+}
+
+/*!
+ * Moves to the next epoch, if every thread in a read section has already
+ * seen the current one.
+ */
+static void TryAdvanceEpoch(void)
+{
+    __GLVNDhashMapReader *reader;
+    int epoch;
+
+    if (__glvndPthreadFuncs.mutex_trylock(&epochLock) != 0) {
+        // Another thread is already doing this.
+        return;
+    }
+
+    glvndAtomicFence();
+    epoch = glvndAtomicLoadAcquire(&globalEpoch);
+    for (reader = (__GLVNDhashMapReader *) glvndAtomicLoadAcquirePtr((void * volatile *) &readerList);
+            reader != NULL; reader = reader->next) {
+        int readerEpoch = glvndAtomicLoadAcquire(&reader->epoch);
+        if (readerEpoch != 0 && (readerEpoch >> 1) != epoch) {
+            __glvndPthreadFuncs.mutex_unlock(&epochLock);
+            return;
+        }
+    }
+    glvndAtomicStoreRelease(&globalEpoch, (epoch + 1) & EPOCH_MASK);
+
+    __glvndPthreadFuncs.mutex_unlock(&epochLock);
+}
+
+static void FreeNode(__GLVNDhashMapNode *node)
+{
+    glvndMemStatsFree(GLVND_MEM_HASH, sizeof(__GLVNDhashMapNode) + node->keyLen);
+    free(node);
+}
+
+static void FreeTable(__GLVNDhashMapTable *table)
+{
+    if (table != NULL) {
+        glvndMemStatsFree(GLVND_MEM_HASH, sizeof(__GLVNDhashMapTable)
+                + table->size * sizeof(__GLVNDhashMapNode *));
+        free(table);
+    }
+}
+
+static void FreeRetired(__GLVNDhashMap *map, __GLVNDhashMapRetired *retired)
+{
+    if (retired->type == RETIRED_TABLE) {
+        FreeTable((__GLVNDhashMapTable *) retired);
+        return;
+    }
+    if (retired->type == RETIRED_NODE_AND_VALUE) {
+        map->freeValue(((__GLVNDhashMapNode *) retired)->value);
+    }
+    FreeNode((__GLVNDhashMapNode *) retired);
+}
+
+/*!
+ * Frees anything in the retired list that no reader can still be using.
+ *
+ * The caller must hold \c map->retiredLock.
+ */
+static void ReclaimRetired(__GLVNDhashMap *map)
+{
+    __GLVNDhashMapRetired **prev;
+    int epoch;
+
+    TryAdvanceEpoch();
+
+    glvndAtomicFence();
+    if (glvndAtomicLoadAcquire(&reclaimDisabled)) {
+        return;
+    }
+
+    epoch = glvndAtomicLoadAcquire(&globalEpoch);
+    prev = &map->retired;
+    while (*prev != NULL) {
+        __GLVNDhashMapRetired *retired = *prev;
+        if (((epoch - retired->epoch) & EPOCH_MASK) >= 2) {
+            *prev = retired->next;
+            FreeRetired(map, retired);
+        } else {
+            prev = &retired->next;
+        }
+    }
+}
+
+/*!
+ * Adds a node or table to the retired list. The caller must have already
+ * unlinked it, so that no new reader can find it.
+ */
+static void RetireLocked(__GLVNDhashMap *map, __GLVNDhashMapRetired *retired,
+        int type, int epoch)
+{
+    retired->epoch = epoch;
+    retired->type = type;
+    retired->next = map->retired;
+    map->retired = retired;
+}
+
+static void Retire(__GLVNDhashMap *map, __GLVNDhashMapRetired *retired, int type)
+{
+    // Make sure the unlink is visible before we look at the epoch.
+    glvndAtomicFence();
+
+    __glvndPthreadFuncs.mutex_lock(&map->retiredLock);
+    RetireLocked(map, retired, type, glvndAtomicLoadAcquire(&globalEpoch));
+    ReclaimRetired(map);
+    __glvndPthreadFuncs.mutex_unlock(&map->retiredLock);
+}
+
+static void FreeAllRetired(__GLVNDhashMap *map)
+{
+    while (map->retired != NULL) {
+        __GLVNDhashMapRetired *next = map->retired->next;
+        FreeRetired(map, map->retired);
+        map->retired = next;
+    }
+}
+
+static void ResetReaders(void)
+{
+    __GLVNDhashMapReader *self = FindCurrentReader();
+    __GLVNDhashMapReader *reader;
+
+    // Only the current thread exists in the child process, so any other
+    // thread's read section is gone.
+    for (reader = readerList; reader != NULL; reader = reader->next) {
+        if (reader != self) {
+            reader->depth = 0;
+            reader->epoch = 0;
+            reader->inUse = 0;
+        }
+    }
+    __glvndPthreadFuncs.mutex_init(&epochLock, NULL);
+}
+
+static void InitLocks(__GLVNDhashMap *map)
+{
+    int i;
+    for (i=0; i<GLVND_HASHMAP_LOCK_COUNT; i++) {
+        __glvndPthreadFuncs.mutex_init(&map->locks[i], NULL);
+    }
+    __glvndPthreadFuncs.mutex_init(&map->retiredLock, NULL);
+}
+
+static void DestroyLocks(__GLVNDhashMap *map)
+{
+    int i;
+    for (i=0; i<GLVND_HASHMAP_LOCK_COUNT; i++) {
+        __glvndPthreadFuncs.mutex_destroy(&map->locks[i]);
+    }
+    __glvndPthreadFuncs.mutex_destroy(&map->retiredLock);
+}
+
+void __glvndHashMapInit(__GLVNDhashMap *map, void (* freeValue) (void *value))
+{
+    map->table = NULL;
+    map->count = 0;
+    map->freeValue = freeValue;
+    map->retired = NULL;
+    memset(map->lockStats, 0, sizeof(map->lockStats));
+    InitLocks(map);
+}
+
+void __glvndHashMapReset(__GLVNDhashMap *map)
+{
+    InitLocks(map);
+    ResetReaders();
+}
+
+/*!
+ * Frees every node in the buckets that \p locked says are available, and
+ * removes them from the table.
+ */
+static void FreeNodes(__GLVNDhashMap *map, const int *locked,
+        void (* cleanup) (void *param, void *value), void *param)
+{
+    __GLVNDhashMapTable *table = map->table;
+    size_t i;
+
+    if (table == NULL) {
+        return;
+    }
+
+    for (i=0; i<table->size; i++) {
+        __GLVNDhashMapNode *node = table->buckets[i];
+
+        if (locked != NULL && !locked[i & (GLVND_HASHMAP_LOCK_COUNT - 1)]) {
+            continue;
+        }
+
+        table->buckets[i] = NULL;
+        while (node != NULL) {
+            __GLVNDhashMapNode *next = node->next;
+            if (cleanup != NULL) {
+                cleanup(param, node->value);
+            }
+            if (map->freeValue != NULL) {
+                map->freeValue(node->value);
+            }
+            FreeNode(node);
+            map->count--;
+            node = next;
+        }
+    }
+}
+
+void __glvndHashMapTeardown(__GLVNDhashMap *map,
+        void (* cleanup) (void *param, void *value), void *param, int reset)
+{
+    if (reset) {
+        // Any lock could have been held by another thread when we forked.
+        __glvndHashMapReset(map);
+    }
+
+    __glvndHashMapLockAll(map);
+    FreeNodes(map, NULL, cleanup, param);
+    assert(map->count == 0);
+    FreeTable(map->table);
+    map->table = NULL;
+    map->count = 0;
+
+    __glvndPthreadFuncs.mutex_lock(&map->retiredLock);
+    FreeAllRetired(map);
+    __glvndPthreadFuncs.mutex_unlock(&map->retiredLock);
+    __glvndHashMapUnlockAll(map);
+
+    if (!reset) {
+        DestroyLocks(map);
+    }
+}
+
+int __glvndHashMapTryTeardown(__GLVNDhashMap *map,
+        void (* cleanup) (void *param, void *value), void *param)
+{
+    int locked[GLVND_HASHMAP_LOCK_COUNT];
+    int allLocked = 1;
+    int i;
+
+    for (i=0; i<GLVND_HASHMAP_LOCK_COUNT; i++) {
+        locked[i] = (__glvndPthreadFuncs.mutex_trylock(&map->locks[i]) == 0);
+        if (!locked[i]) {
+            allLocked = 0;
+        }
+    }
+
+    FreeNodes(map, locked, cleanup, param);
+
+    if (allLocked) {
+        FreeTable(map->table);
+        map->table = NULL;
+        map->count = 0;
+
+        __glvndPthreadFuncs.mutex_lock(&map->retiredLock);
+        FreeAllRetired(map);
+        __glvndPthreadFuncs.mutex_unlock(&map->retiredLock);
+    }
+
+    for (i=GLVND_HASHMAP_LOCK_COUNT - 1; i>=0; i--) {
+        if (locked[i]) {
+            __glvndPthreadFuncs.mutex_unlock(&map->locks[i]);
+        }
+    }
+
+    if (allLocked) {
+        DestroyLocks(map);
+    }
+    return allLocked;
+}
+
+void __glvndHashMapFini(void)
+{
+    __GLVNDhashMapReader *reader = FindCurrentReader();
+
+    if (reader != NULL) {
+        ReleaseReader(reader);
+    }
+    if (readerKeyValid) {
+        __glvndPthreadFuncs.key_delete(readerKey);
+        readerKeyValid = 0;
+    }
+
+    // If another thread is still running, then it could still be using its
+    // record, so leave them all alone.
+    for (reader = readerList; reader != NULL; reader = reader->next) {
+        if (glvndAtomicLoadAcquire(&reader->inUse)) {
+            return;
+        }
+    }
+
+    reader = readerList;
+    readerList = NULL;
+    while (reader != NULL) {
+        __GLVNDhashMapReader *next = reader->next;
+        free(reader);
+        reader = next;
+    }
+}
+
+static __GLVNDhashMapNode *FindNode(__GLVNDhashMapTable *table,
+        const void *key, size_t keyLen, unsigned int hash)
+{
+    __GLVNDhashMapNode *node = (__GLVNDhashMapNode *) glvndAtomicLoadAcquirePtr(
+            (void * volatile *) &table->buckets[hash & (table->size - 1)]);
+
+    while (node != NULL) {
+        if (node->hash == hash && node->keyLen == keyLen
+                && memcmp(node->key, key, keyLen) == 0) {
+            return node;
+        }
+        node = (__GLVNDhashMapNode *) glvndAtomicLoadAcquirePtr((void * volatile *) &node->next);
+    }
+    return NULL;
+}
+
+void *__glvndHashMapFind(__GLVNDhashMap *map, const void *key, size_t keyLen)
+{
+    __GLVNDhashMapTable *table = (__GLVNDhashMapTable *)
+        glvndAtomicLoadAcquirePtr((void * volatile *) &map->table);
+    __GLVNDhashMapNode *node;
+
+    if (table == NULL) {
+        return NULL;
+    }
+
+    node = FindNode(table, key, keyLen, HashKey(key, keyLen));
+    return (node != NULL ? node->value : NULL);
+}
+
+static __GLVNDhashMapTable *AllocTable(size_t size)
+{
+    __GLVNDhashMapTable *table = (__GLVNDhashMapTable *) calloc(1,
+            sizeof(__GLVNDhashMapTable) + size * sizeof(__GLVNDhashMapNode *));
+    if (table != NULL) {
+        table->size = size;
+        glvndMemStatsAlloc(GLVND_MEM_HASH, sizeof(__GLVNDhashMapTable)
+                + size * sizeof(__GLVNDhashMapNode *));
+    }
+    return table;
+}
+
+static __GLVNDhashMapNode *AllocNode(const void *key, size_t keyLen,
+        unsigned int hash, void *value)
+{
+    __GLVNDhashMapNode *node = (__GLVNDhashMapNode *) malloc(sizeof(__GLVNDhashMapNode) + keyLen);
+    if (node != NULL) {
+        node->next = NULL;
+        node->value = value;
+        node->hash = hash;
+        node->keyLen = keyLen;
+        memcpy(node->key, key, keyLen);
+        glvndMemStatsAlloc(GLVND_MEM_HASH, sizeof(__GLVNDhashMapNode) + keyLen);
+    }
+    return node;
+}
+
+/*!
+ * Returns the current table, allocating it if this is the first entry.
+ *
+ * The caller only has to hold one key's lock, so two threads could get here
+ * at the same time. Whichever one loses just frees its table.
+ */
+static __GLVNDhashMapTable *GetTableForInsert(__GLVNDhashMap *map)
+{
+    __GLVNDhashMapTable *table = (__GLVNDhashMapTable *)
+        glvndAtomicLoadAcquirePtr((void * volatile *) &map->table);
+
+    if (table == NULL) {
+        __GLVNDhashMapTable *newTable = AllocTable(INITIAL_TABLE_SIZE);
+        if (newTable == NULL) {
+            return NULL;
+        }
+        if (glvndAtomicCompareExchangePtr((void * volatile *) &map->table, NULL, newTable)) {
+            table = newTable;
+        } else {
+            FreeTable(newTable);
+            table = (__GLVNDhashMapTable *)
+                glvndAtomicLoadAcquirePtr((void * volatile *) &map->table);
+        }
+    }
+    return table;
+}
+
+/*!
+ * Doubles the size of the table.
+ *
+ * Readers can still be walking through the old table, so this copies every
+ * node into the new table instead of moving it, and then retires the old
+ * nodes and the old table.
+ */
+static void GrowTable(__GLVNDhashMap *map)
+{
+    __GLVNDhashMapTable *oldTable;
+    __GLVNDhashMapTable *newTable;
+    size_t i;
+    int epoch;
+
+    __glvndHashMapLockAll(map);
+
+    oldTable = map->table;
+    if (oldTable == NULL || (size_t) map->count <= oldTable->size * MAX_LOAD_FACTOR) {
+        // Another thread already did it.
+        __glvndHashMapUnlockAll(map);
+        return;
+    }
+
+    newTable = AllocTable(oldTable->size * 2);
+    if (newTable == NULL) {
+        __glvndHashMapUnlockAll(map);
+        return;
+    }
+
+    for (i=0; i<oldTable->size; i++) {
+        __GLVNDhashMapNode *node;
+        for (node = oldTable->buckets[i]; node != NULL; node = node->next) {
+            __GLVNDhashMapNode *copy = AllocNode(node->key, node->keyLen,
+                    node->hash, node->value);
+            size_t bucket;
+
+            if (copy == NULL) {
+                // Throw away the new table. The old one still works, it's
+                // just slower.
+                size_t j;
+                for (j=0; j<newTable->size; j++) {
+                    while (newTable->buckets[j] != NULL) {
+                        __GLVNDhashMapNode *next = newTable->buckets[j]->next;
+                        FreeNode(newTable->buckets[j]);
+                        newTable->buckets[j] = next;
+                    }
+                }
+                FreeTable(newTable);
+                __glvndHashMapUnlockAll(map);
+                return;
+            }
+
+            bucket = copy->hash & (newTable->size - 1);
+            copy->next = newTable->buckets[bucket];
+            newTable->buckets[bucket] = copy;
+        }
+    }
+
+    glvndAtomicStoreReleasePtr((void * volatile *) &map->table, newTable);
+    glvndAtomicFence();
+
+    __glvndPthreadFuncs.mutex_lock(&map->retiredLock);
+    epoch = glvndAtomicLoadAcquire(&globalEpoch);
+    for (i=0; i<oldTable->size; i++) {
+        __GLVNDhashMapNode *node = oldTable->buckets[i];
+        while (node != NULL) {
+            __GLVNDhashMapNode *next = node->next;
+            RetireLocked(map, &node->retired, RETIRED_NODE, epoch);
+            node = next;
+        }
+    }
+    RetireLocked(map, &oldTable->retired, RETIRED_TABLE, epoch);
+    ReclaimRetired(map);
+    __glvndPthreadFuncs.mutex_unlock(&map->retiredLock);
+
+    __glvndHashMapUnlockAll(map);
+}
+
+void __glvndHashMapLock(__GLVNDhashMap *map, const void *key, size_t keyLen)
+{
+    unsigned int index = HashKey(key, keyLen) & (GLVND_HASHMAP_LOCK_COUNT - 1);
+    glvndProfiledMutexLock(&map->locks[index], &map->lockStats[index]);
+}
+
+void __glvndHashMapUnlock(__GLVNDhashMap *map, const void *key, size_t keyLen)
+{
+    __GLVNDhashMapTable *table;
+
+    __glvndPthreadFuncs.mutex_unlock(GetKeyLock(map, HashKey(key, keyLen)));
+
+    table = (__GLVNDhashMapTable *) glvndAtomicLoadAcquirePtr((void * volatile *) &map->table);
+    if (table != NULL
+            && (size_t) glvndAtomicLoadAcquire(&map->count) > table->size * MAX_LOAD_FACTOR) {
+        GrowTable(map);
+    }
+}
+
+void __glvndHashMapLockAll(__GLVNDhashMap *map)
+{
+    int i;
+    for (i=0; i<GLVND_HASHMAP_LOCK_COUNT; i++) {
+        glvndProfiledMutexLock(&map->locks[i], &map->lockStats[i]);
+    }
+}
+
+void __glvndHashMapUnlockAll(__GLVNDhashMap *map)
+{
+    int i;
+    for (i=GLVND_HASHMAP_LOCK_COUNT - 1; i>=0; i--) {
+        __glvndPthreadFuncs.mutex_unlock(&map->locks[i]);
+    }
+}
+
+int __glvndHashMapInsert(__GLVNDhashMap *map, const void *key, size_t keyLen,
+        void *value)
+{
+    unsigned int hash = HashKey(key, keyLen);
+    __GLVNDhashMapTable *table;
+    __GLVNDhashMapNode *node;
+    size_t bucket;
+
+    table = GetTableForInsert(map);
+    if (table == NULL) {
+        return 0;
+    }
+    assert(FindNode(table, key, keyLen, hash) == NULL);
+
+    node = AllocNode(key, keyLen, hash, value);
+    if (node == NULL) {
+        return 0;
+    }
+
+    bucket = hash & (table->size - 1);
+    node->next = table->buckets[bucket];
+    glvndAtomicStoreReleasePtr((void * volatile *) &table->buckets[bucket], node);
+    AtomicAdd(&map->count, 1);
+    return 1;
+}
+
+/*!
+ * Finds the pointer that links to a node in its bucket, or to the end of the
+ * bucket if the key isn't in the table.
+ */
+static __GLVNDhashMapNode * volatile *FindNodeLink(__GLVNDhashMapTable *table,
+        const void *key, size_t keyLen, unsigned int hash)
+{
+    __GLVNDhashMapNode * volatile *prev = &table->buckets[hash & (table->size - 1)];
+    __GLVNDhashMapNode *node;
+
+    for (node = *prev; node != NULL; node = *prev) {
+        if (node->hash == hash && node->keyLen == keyLen
+                && memcmp(node->key, key, keyLen) == 0) {
+            break;
+        }
+        prev = &node->next;
+    }
+    return prev;
+}
+
+int __glvndHashMapReplace(__GLVNDhashMap *map, const void *key, size_t keyLen,
+        void *value)
+{
+    unsigned int hash = HashKey(key, keyLen);
+    __GLVNDhashMapTable *table;
+    __GLVNDhashMapNode * volatile *prev;
+    __GLVNDhashMapNode *oldNode;
+    __GLVNDhashMapNode *node;
+
+    table = GetTableForInsert(map);
+    if (table == NULL) {
+        return 0;
+    }
+
+    node = AllocNode(key, keyLen, hash, value);
+    if (node == NULL) {
+        return 0;
+    }
+
+    prev = FindNodeLink(table, key, keyLen, hash);
+    oldNode = *prev;
+    if (oldNode != NULL) {
+        node->next = oldNode->next;
+        glvndAtomicStoreReleasePtr((void * volatile *) prev, node);
+        Retire(map, &oldNode->retired,
+                (map->freeValue != NULL ? RETIRED_NODE_AND_VALUE : RETIRED_NODE));
+    } else {
+        size_t bucket = hash & (table->size - 1);
+        node->next = table->buckets[bucket];
+        glvndAtomicStoreReleasePtr((void * volatile *) &table->buckets[bucket], node);
+        AtomicAdd(&map->count, 1);
+    }
+    return 1;
+}
+
+void *__glvndHashMapRemove(__GLVNDhashMap *map, const void *key, size_t keyLen)
+{
+    unsigned int hash = HashKey(key, keyLen);
+    __GLVNDhashMapTable *table = map->table;
+    __GLVNDhashMapNode * volatile *prev;
+    __GLVNDhashMapNode *node;
+    void *value;
+
+    if (table == NULL) {
+        return NULL;
+    }
+
+    prev = FindNodeLink(table, key, keyLen, hash);
+    node = *prev;
+    if (node == NULL) {
+        return NULL;
+    }
+
+    // Leave node->next alone, so that a reader that's looking at this node
+    // can still get to the rest of the bucket.
+    glvndAtomicStoreReleasePtr((void * volatile *) prev, node->next);
+    AtomicAdd(&map->count, -1);
+
+    value = node->value;
+    Retire(map, &node->retired,
+            (map->freeValue != NULL ? RETIRED_NODE_AND_VALUE : RETIRED_NODE));
+    return value;
+}
+
+void __glvndHashMapClear(__GLVNDhashMap *map)
+{
+    __GLVNDhashMapTable *table;
+    size_t i;
+
+    __glvndHashMapLockAll(map);
+    table = map->table;
+    if (table != NULL) {
+        int type = (map->freeValue != NULL ? RETIRED_NODE_AND_VALUE : RETIRED_NODE);
+
+        for (i=0; i<table->size; i++) {
+            __GLVNDhashMapNode *node = table->buckets[i];
+            int epoch;
+
+            if (node == NULL) {
+                continue;
+            }
+
+            glvndAtomicStoreReleasePtr((void * volatile *) &table->buckets[i], NULL);
+            glvndAtomicFence();
+
+            __glvndPthreadFuncs.mutex_lock(&map->retiredLock);
+            epoch = glvndAtomicLoadAcquire(&globalEpoch);
+            while (node != NULL) {
+                __GLVNDhashMapNode *next = node->next;
+                AtomicAdd(&map->count, -1);
+                RetireLocked(map, &node->retired, type, epoch);
+                node = next;
+            }
+            __glvndPthreadFuncs.mutex_unlock(&map->retiredLock);
+        }
+
+        __glvndPthreadFuncs.mutex_lock(&map->retiredLock);
+        ReclaimRetired(map);
+        __glvndPthreadFuncs.mutex_unlock(&map->retiredLock);
+    }
+    __glvndHashMapUnlockAll(map);
+}
+
+int __glvndHashMapCount(__GLVNDhashMap *map)
+{
+    return glvndAtomicLoadAcquire(&map->count);
+}
+
+void __glvndHashMapIterInit(__GLVNDhashMap *map, __GLVNDhashMapIter *iter)
+{
+    iter->table = (__GLVNDhashMapTable *) glvndAtomicLoadAcquirePtr((void * volatile *) &map->table);
+    iter->bucket = 0;
+    iter->next = NULL;
+}
+
+int __glvndHashMapIterNext(__GLVNDhashMapIter *iter, const void **key, void **value)
+{
+    __GLVNDhashMapNode *node = iter->next;
+
+    while (node == NULL) {
+        if (iter->table == NULL || iter->bucket >= iter->table->size) {
+            return 0;
+        }
+        node = (__GLVNDhashMapNode *) glvndAtomicLoadAcquirePtr(
+                (void * volatile *) &iter->table->buckets[iter->bucket++]);
+    }
+
+    // Grab the next node now, in case the caller removes this one.
+    iter->next = (__GLVNDhashMapNode *) glvndAtomicLoadAcquirePtr((void * volatile *) &node->next);
+    if (key != NULL) {
+        *key = node->key;
+    }
+    *value = node->value;
+    return 1;
+}
@@ -0,0 +1,266 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+#if !defined(__GLVND_HASHMAP_H)
+#define __GLVND_HASHMAP_H
+
+/*!
+ * \file
+ *
+ * A hashtable that can be read without taking a lock.
+ *
+ * Readers call \c __glvndHashMapReadBegin and \c __glvndHashMapReadEnd around
+ * a lookup. Those only touch per-thread state, so threads that look up
+ * entries at the same time don't contend with each other.
+ *
+ * Writers lock the key that they're changing with \c __glvndHashMapLock. The
+ * keys are split between several locks, so threads that change different
+ * keys usually don't have to wait for each other either.
+ *
+ * A removed entry is freed once every thread that could still be looking at
+ * it has left its read section. If the map has a \c freeValue callback, then
+ * the same goes for the value that was stored with it. Otherwise, the caller
+ * owns the values, and has to make sure that a reader can't still be using a
+ * value that it frees.
+ *
+ * Keys are copied into the map, and compared with memcmp.
+ *
+ * These functions use the pthreads function table in glvnd_pthread.h, so you
+ * have to call \c glvndSetupPthreads before using them.
+ */
+
+#include <stddef.h>
+
+#include "glvnd_pthread.h"
+
+/*!
+ * The number of locks that a map's keys are split between. This must be a
+ * power of two.
+ */
+#define GLVND_HASHMAP_LOCK_COUNT 16
+
+typedef struct __GLVNDhashMapNodeRec __GLVNDhashMapNode;
+typedef struct __GLVNDhashMapTableRec __GLVNDhashMapTable;
+typedef struct __GLVNDhashMapRetiredRec __GLVNDhashMapRetired;
+
+typedef struct __GLVNDhashMapRec {
+    __GLVNDhashMapTable * volatile table;
+    int volatile count;
+
+    /*!
+     * If this isn't NULL, then the map owns the values, and calls this to
+     * free them after they're removed.
+     */
+    void (* freeValue) (void *value);
+
+    glvnd_mutex_t locks[GLVND_HASHMAP_LOCK_COUNT];
+
+    /*!
+     * The nodes and tables that have been removed, but that a reader might
+     * still be looking at. This is protected by \c retiredLock.
+     */
+    __GLVNDhashMapRetired *retired;
+    glvnd_mutex_t retiredLock;
+
+    /*!
+     * Contention counters for each of \c locks, for lock profiling. Each one
+     * is protected by its lock. The static initializer leaves these zeroed.
+     */
+    glvnd_lock_stats_t lockStats[GLVND_HASHMAP_LOCK_COUNT];
+} __GLVNDhashMap;
+
+#define __GLVND_HASHMAP_LOCKS_4 \
+    GLVND_MUTEX_INITIALIZER, GLVND_MUTEX_INITIALIZER, \
+    GLVND_MUTEX_INITIALIZER, GLVND_MUTEX_INITIALIZER
+#define __GLVND_HASHMAP_LOCKS_16 \
+    __GLVND_HASHMAP_LOCKS_4, __GLVND_HASHMAP_LOCKS_4, \
+    __GLVND_HASHMAP_LOCKS_4, __GLVND_HASHMAP_LOCKS_4
+
+/*!
+ * A static initializer for a \c __GLVNDhashMap.
+ */
+#define GLVND_HASHMAP_INITIALIZER(_freeValue) \
+    { NULL, 0, _freeValue, { __GLVND_HASHMAP_LOCKS_16 }, NULL, GLVND_MUTEX_INITIALIZER }
+
+/*!
+ * An iterator for \c __glvndHashMapIterNext.
+ */
+typedef struct __GLVNDhashMapIterRec {
+    __GLVNDhashMapTable *table;
+    size_t bucket;
+    __GLVNDhashMapNode *next;
+} __GLVNDhashMapIter;
+
+/*!
+ * Initializes a map at runtime. This does the same thing as
+ * \c GLVND_HASHMAP_INITIALIZER.
+ */
+void __glvndHashMapInit(__GLVNDhashMap *map, void (* freeValue) (void *value));
+
+/*!
+ * Removes every entry from a map, and frees everything that the map
+ * allocated.
+ *
+ * If \p cleanup is not NULL, then it's called for each value first, followed
+ * by the map's \c freeValue callback.
+ *
+ * If \p reset is non-zero, then this is being called after a fork, so the
+ * locks are re-initialized instead of destroyed, and the map can still be
+ * used afterward.
+ */
+void __glvndHashMapTeardown(__GLVNDhashMap *map,
+        void (* cleanup) (void *param, void *value), void *param, int reset);
+
+/*!
+ * Does the same thing as \c __glvndHashMapTeardown with \p reset set to
+ * zero, but only cleans up the entries whose lock is available, instead of
+ * waiting for another thread to release it.
+ *
+ * This is meant for process termination, where another thread might be
+ * stuck while holding a lock.
+ *
+ * \return Non-zero if every entry was cleaned up.
+ */
+int __glvndHashMapTryTeardown(__GLVNDhashMap *map,
+        void (* cleanup) (void *param, void *value), void *param);
+
+/*!
+ * Re-initializes a map's locks after a fork, without removing any entries.
+ *
+ * This also forgets about any read sections from threads that don't exist in
+ * the child process.
+ */
+void __glvndHashMapReset(__GLVNDhashMap *map);
+
+/*!
+ * Frees the per-thread state used for read sections. This should be called
+ * when the library is unloaded, after tearing down every map.
+ *
+ * If any other thread has used a read section and is still running, then
+ * its state is leaked instead.
+ */
+void __glvndHashMapFini(void);
+
+/*!
+ * Starts a read section. Read sections can be nested, and can be used with
+ * any number of maps.
+ *
+ * Inside a read section, \c __glvndHashMapFind and \c __glvndHashMapIterNext
+ * can be called without holding a lock, and any value they return stays
+ * allocated until the read section ends.
+ */
+void __glvndHashMapReadBegin(void);
+void __glvndHashMapReadEnd(void);
+
+/*!
+ * Looks up a key, and returns its value, or NULL if it's not in the map.
+ *
+ * The caller must either be in a read section, or hold the lock for \p key.
+ */
+void *__glvndHashMapFind(__GLVNDhashMap *map, const void *key, size_t keyLen);
+
+/*!
+ * Locks or unlocks the lock for \p key.
+ *
+ * A thread should only hold one key's lock at a time, since unlocking a key
+ * might need to take every lock in the map to resize it.
+ */
+void __glvndHashMapLock(__GLVNDhashMap *map, const void *key, size_t keyLen);
+void __glvndHashMapUnlock(__GLVNDhashMap *map, const void *key, size_t keyLen);
+
+/*!
+ * Locks or unlocks every key in the map.
+ */
+void __glvndHashMapLockAll(__GLVNDhashMap *map);
+void __glvndHashMapUnlockAll(__GLVNDhashMap *map);
+
+/*!
+ * Adds an entry to the map.
+ *
+ * The caller must hold the lock for \p key, and \p key must not already be in
+ * the map.
+ *
+ * \return Non-zero on success, or zero if we couldn't allocate the entry.
+ */
+int __glvndHashMapInsert(__GLVNDhashMap *map, const void *key, size_t keyLen,
+        void *value);
+
+/*!
+ * Adds an entry to the map, or replaces the value of an existing entry.
+ *
+ * Unlike calling \c __glvndHashMapRemove and then \c __glvndHashMapInsert,
+ * a reader will always find either the old value or the new one.
+ *
+ * The caller must hold the lock for \p key. If the map has a \c freeValue
+ * callback, then the old value is freed after any readers are done with it.
+ *
+ * \return Non-zero on success, or zero if we couldn't allocate the entry, in
+ * which case the old value is still in the map.
+ */
+int __glvndHashMapReplace(__GLVNDhashMap *map, const void *key, size_t keyLen,
+        void *value);
+
+/*!
+ * Removes an entry from the map, and returns its value, or NULL if the key
+ * wasn't in the map.
+ *
+ * The caller must hold the lock for \p key. If the map has a \c freeValue
+ * callback, then the value is freed after any readers are done with it.
+ */
+void *__glvndHashMapRemove(__GLVNDhashMap *map, const void *key, size_t keyLen);
+
+/*!
+ * Removes every entry from the map.
+ */
+void __glvndHashMapClear(__GLVNDhashMap *map);
+
+/*!
+ * Returns the number of entries in the map.
+ */
+int __glvndHashMapCount(__GLVNDhashMap *map);
+
+/*!
+ * Iterates over every entry in a map.
+ *
+ * The caller must either be in a read section, or hold every lock in the map.
+ * In the second case, the caller can remove the current entry's key while
+ * iterating.
+ */
+void __glvndHashMapIterInit(__GLVNDhashMap *map, __GLVNDhashMapIter *iter);
+
+/*!
+ * Returns the next entry in the map.
+ *
+ * \param[out] key Optional. Returns a pointer to the entry's key.
+ * \param[out] value Returns the entry's value.
+ * \return Non-zero if there was another entry, or zero at the end of the map.
+ */
+int __glvndHashMapIterNext(__GLVNDhashMapIter *iter, const void **key, void **value);
+
+#endif // !defined(__GLVND_HASHMAP_H)
@@ -0,0 +1,563 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+#include "glvnd_json.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/*!
+ * The deepest that objects and arrays can be nested. This is the same limit
+ * that cJSON uses.
+ */
+#define JSON_NESTING_LIMIT 1000
+
+int __glvndJsonMapFile(const char *filename, __GLVNDjsonFile *file)
+{
+    struct stat st;
+    void *data;
+    int fd;
+
+    fd = open(filename, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0) {
+        close(fd);
+        return -1;
+    }
+
+    data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return -1;
+    }
+
+    file->data = (const char *) data;
+    file->size = st.st_size;
+    return 0;
+}
+
+void __glvndJsonUnmapFile(__GLVNDjsonFile *file)
+{
+    if (file->data != NULL) {
+        munmap((void *) file->data, file->size);
+        file->data = NULL;
+        file->size = 0;
+    }
+}
+
+void __glvndJsonReaderInit(__GLVNDjsonReader *reader, const char *data, size_t size)
+{
+    reader->ptr = data;
+    reader->end = data + size;
+    reader->first = 0;
+    reader->error = 0;
+}
+
+static int SetError(__GLVNDjsonReader *reader)
+{
+    reader->error = 1;
+    return 0;
+}
+
+static void SkipWhitespace(__GLVNDjsonReader *reader)
+{
+    // Like cJSON, treat any control character as whitespace.
+    while (reader->ptr < reader->end && *((const unsigned char *) reader->ptr) <= 32) {
+        reader->ptr++;
+    }
+}
+
+static int MatchLiteral(__GLVNDjsonReader *reader, const char *literal)
+{
+    size_t len = strlen(literal);
+    return ((size_t) (reader->end - reader->ptr) >= len
+            && memcmp(reader->ptr, literal, len) == 0);
+}
+
+static int IsDigit(const __GLVNDjsonReader *reader, const char *ptr)
+{
+    return (ptr < reader->end && *ptr >= '0' && *ptr <= '9');
+}
+
+/*!
+ * Skips a number.
+ *
+ * This accepts the same numbers that cJSON did, so that config files that
+ * used to load still do. cJSON passed the number to strtod, so it also
+ * accepted things that RFC 8259 doesn't allow, like "01", "1." and "-.5".
+ */
+static int SkipNumber(__GLVNDjsonReader *reader)
+{
+    const char *ptr = reader->ptr;
+    int digits = 0;
+
+    if (*ptr == '-') {
+        ptr++;
+    }
+    while (IsDigit(reader, ptr)) {
+        ptr++;
+        digits++;
+    }
+    if (ptr < reader->end && *ptr == '.') {
+        ptr++;
+        while (IsDigit(reader, ptr)) {
+            ptr++;
+            digits++;
+        }
+    }
+    if (digits == 0) {
+        return SetError(reader);
+    }
+
+    // Like strtod, only take the exponent if it has at least one digit.
+    // Otherwise, the 'e' is left for the caller, which will reject it.
+    if (ptr < reader->end && (*ptr == 'e' || *ptr == 'E')) {
+        const char *exp = ptr + 1;
+        if (exp < reader->end && (*exp == '+' || *exp == '-')) {
+            exp++;
+        }
+        if (IsDigit(reader, exp)) {
+            while (IsDigit(reader, exp)) {
+                exp++;
+            }
+            ptr = exp;
+        }
+    }
+
+    reader->ptr = ptr;
+    return 1;
+}
+
+__GLVNDjsonType __glvndJsonPeek(__GLVNDjsonReader *reader)
+{
+    if (reader->error) {
+        return GLVND_JSON_INVALID;
+    }
+    SkipWhitespace(reader);
+    if (reader->ptr >= reader->end) {
+        return GLVND_JSON_INVALID;
+    }
+
+    switch (*reader->ptr) {
+    case '{':
+        return GLVND_JSON_OBJECT;
+    case '[':
+        return GLVND_JSON_ARRAY;
+    case '"':
+        return GLVND_JSON_STRING;
+    case 't':
+        return (MatchLiteral(reader, "true") ? GLVND_JSON_TRUE : GLVND_JSON_INVALID);
+    case 'f':
+        return (MatchLiteral(reader, "false") ? GLVND_JSON_FALSE : GLVND_JSON_INVALID);
+    case 'n':
+        return (MatchLiteral(reader, "null") ? GLVND_JSON_NULL : GLVND_JSON_INVALID);
+    default:
+        if (*reader->ptr == '-' || (*reader->ptr >= '0' && *reader->ptr <= '9')) {
+            return GLVND_JSON_NUMBER;
+        }
+        return GLVND_JSON_INVALID;
+    }
+}
+
+static int BeginContainer(__GLVNDjsonReader *reader, __GLVNDjsonType type)
+{
+    if (__glvndJsonPeek(reader) != type) {
+        return 0;
+    }
+    reader->ptr++;
+    reader->first = 1;
+    return 1;
+}
+
+/*!
+ * Moves past the separator before the next member or element of a container.
+ *
+ * \return 1 if there's another item, 0 if the end of the container was
+ * consumed, or -1 on a syntax error.
+ */
+static int NextItem(__GLVNDjsonReader *reader, char close)
+{
+    if (reader->error) {
+        return -1;
+    }
+
+    SkipWhitespace(reader);
+    if (reader->ptr >= reader->end) {
+        SetError(reader);
+        return -1;
+    }
+
+    if (*reader->ptr == close) {
+        reader->ptr++;
+        // Whatever comes after this is in the enclosing container, and this
+        // container was an item in it, so it can't be the first one.
+        reader->first = 0;
+        return 0;
+    }
+
+    if (!reader->first) {
+        if (*reader->ptr != ',') {
+            SetError(reader);
+            return -1;
+        }
+        reader->ptr++;
+    }
+    reader->first = 0;
+    return 1;
+}
+
+int __glvndJsonBeginObject(__GLVNDjsonReader *reader)
+{
+    return BeginContainer(reader, GLVND_JSON_OBJECT);
+}
+
+int __glvndJsonNextMember(__GLVNDjsonReader *reader, __GLVNDjsonString *key)
+{
+    int ret = NextItem(reader, '}');
+    if (ret <= 0) {
+        return ret;
+    }
+
+    if (!__glvndJsonReadString(reader, key)) {
+        SetError(reader);
+        return -1;
+    }
+
+    SkipWhitespace(reader);
+    if (reader->ptr >= reader->end || *reader->ptr != ':') {
+        SetError(reader);
+        return -1;
+    }
+    reader->ptr++;
+    return 1;
+}
+
+int __glvndJsonBeginArray(__GLVNDjsonReader *reader)
+{
+    return BeginContainer(reader, GLVND_JSON_ARRAY);
+}
+
+int __glvndJsonNextElement(__GLVNDjsonReader *reader)
+{
+    return NextItem(reader, ']');
+}
+
+static int IsHexDigit(char c)
+{
+    return ((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F'));
+}
+
+static unsigned int ParseHex4(const char *ptr)
+{
+    unsigned int value = 0;
+    int i;
+
+    for (i=0; i<4; i++) {
+        char c = ptr[i];
+        value <<= 4;
+        if (c >= '0' && c <= '9') {
+            value |= c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            value |= c - 'a' + 10;
+        } else {
+            value |= c - 'A' + 10;
+        }
+    }
+    return value;
+}
+
+/*!
+ * Checks for a \\u escape sequence at \p ptr.
+ *
+ * \return The code unit, or -1 if \p ptr doesn't point to a valid \\u
+ * sequence.
+ */
+static int ReadUnicodeEscape(const __GLVNDjsonReader *reader, const char *ptr)
+{
+    int i;
+
+    if (reader->end - ptr < 6 || ptr[0] != '\\' || ptr[1] != 'u') {
+        return -1;
+    }
+    for (i=2; i<6; i++) {
+        if (!IsHexDigit(ptr[i])) {
+            return -1;
+        }
+    }
+    return (int) ParseHex4(ptr + 2);
+}
+
+int __glvndJsonReadString(__GLVNDjsonReader *reader, __GLVNDjsonString *str)
+{
+    const char *ptr;
+
+    if (__glvndJsonPeek(reader) != GLVND_JSON_STRING) {
+        return 0;
+    }
+
+    ptr = reader->ptr + 1;
+    str->ptr = ptr;
+    while (1) {
+        if (ptr >= reader->end || *ptr == '\0') {
+            return SetError(reader);
+        }
+        if (*ptr == '"') {
+            break;
+        }
+        if (*ptr == '\\' && ptr + 1 < reader->end && ptr[1] == 'u') {
+            // A UTF-16 surrogate has to be part of a valid pair.
+            int code = ReadUnicodeEscape(reader, ptr);
+            if (code < 0 || (code >= 0xDC00 && code <= 0xDFFF)) {
+                return SetError(reader);
+            }
+            ptr += 6;
+            if (code >= 0xD800 && code <= 0xDBFF) {
+                code = ReadUnicodeEscape(reader, ptr);
+                if (code < 0xDC00 || code > 0xDFFF) {
+                    return SetError(reader);
+                }
+                ptr += 6;
+            }
+            continue;
+        }
+        if (*ptr == '\\') {
+            ptr++;
+            if (ptr >= reader->end || *ptr == '\0'
+                    || strchr("\"\\/bfnrt", *ptr) == NULL) {
+                return SetError(reader);
+            }
+        }
+        ptr++;
+    }
+
+    str->len = ptr - str->ptr;
+    reader->ptr = ptr + 1;
+    return 1;
+}
+
+static int SkipValueRecursive(__GLVNDjsonReader *reader, int depth)
+{
+    __GLVNDjsonString key;
+    int ret;
+
+    if (depth >= JSON_NESTING_LIMIT) {
+        return SetError(reader);
+    }
+
+    switch (__glvndJsonPeek(reader)) {
+    case GLVND_JSON_OBJECT:
+        __glvndJsonBeginObject(reader);
+        while ((ret = __glvndJsonNextMember(reader, &key)) > 0) {
+            if (!SkipValueRecursive(reader, depth + 1)) {
+                return 0;
+            }
+        }
+        return (ret == 0);
+    case GLVND_JSON_ARRAY:
+        __glvndJsonBeginArray(reader);
+        while ((ret = __glvndJsonNextElement(reader)) > 0) {
+            if (!SkipValueRecursive(reader, depth + 1)) {
+                return 0;
+            }
+        }
+        return (ret == 0);
+    case GLVND_JSON_STRING:
+        return __glvndJsonReadString(reader, &key);
+    case GLVND_JSON_NUMBER:
+        return SkipNumber(reader);
+    case GLVND_JSON_TRUE:
+    case GLVND_JSON_NULL:
+        reader->ptr += 4;
+        return 1;
+    case GLVND_JSON_FALSE:
+        reader->ptr += 5;
+        return 1;
+    default:
+        return SetError(reader);
+    }
+}
+
+int __glvndJsonSkipValue(__GLVNDjsonReader *reader)
+{
+    return SkipValueRecursive(reader, 0);
+}
+
+/*!
+ * Decodes the next character of a string, which must have already been
+ * checked by \c __glvndJsonReadString.
+ *
+ * \param[in,out] ptr The current position in the string.
+ * \param end The end of the string.
+ * \param[out] out Returns the UTF-8 bytes of the decoded character.
+ * \return The number of bytes written to \p out, or -1 if the string has an
+ * invalid surrogate pair.
+ */
+static int DecodeNextChar(const char **ptr, const char *end, char out[4])
+{
+    const char *p = *ptr;
+    unsigned int code;
+
+    if (*p != '\\') {
+        out[0] = *p;
+        *ptr = p + 1;
+        return 1;
+    }
+
+    p++;
+    switch (*p) {
+    case 'b': out[0] = '\b'; break;
+    case 'f': out[0] = '\f'; break;
+    case 'n': out[0] = '\n'; break;
+    case 'r': out[0] = '\r'; break;
+    case 't': out[0] = '\t'; break;
+    case 'u': break;
+    default: out[0] = *p; break;
+    }
+    if (*p != 'u') {
+        *ptr = p + 1;
+        return 1;
+    }
+
+    code = ParseHex4(p + 1);
+    p += 5;
+    if (code >= 0xDC00 && code <= 0xDFFF) {
+        return -1;
+    }
+    if (code >= 0xD800 && code <= 0xDBFF) {
+        unsigned int low;
+        if (end - p < 6 || p[0] != '\\' || p[1] != 'u') {
+            return -1;
+        }
+        low = ParseHex4(p + 2);
+        if (low < 0xDC00 || low > 0xDFFF) {
+            return -1;
+        }
+        code = 0x10000 + (((code & 0x3FF) << 10) | (low & 0x3FF));
+        p += 6;
+    }
+    *ptr = p;
+
+    if (code < 0x80) {
+        out[0] = (char) code;
+        return 1;
+    } else if (code < 0x800) {
+        out[0] = (char) (0xC0 | (code >> 6));
+        out[1] = (char) (0x80 | (code & 0x3F));
+        return 2;
+    } else if (code < 0x10000) {
+        out[0] = (char) (0xE0 | (code >> 12));
+        out[1] = (char) (0x80 | ((code >> 6) & 0x3F));
+        out[2] = (char) (0x80 | (code & 0x3F));
+        return 3;
+    } else {
+        out[0] = (char) (0xF0 | (code >> 18));
+        out[1] = (char) (0x80 | ((code >> 12) & 0x3F));
+        out[2] = (char) (0x80 | ((code >> 6) & 0x3F));
+        out[3] = (char) (0x80 | (code & 0x3F));
+        return 4;
+    }
+}
+
+int __glvndJsonDecodeString(const __GLVNDjsonString *str, char *buf, size_t size)
+{
+    const char *ptr = str->ptr;
+    const char *end = str->ptr + str->len;
+    size_t len = 0;
+
+    while (ptr < end) {
+        char decoded[4];
+        int count = DecodeNextChar(&ptr, end, decoded);
+        int i;
+
+        if (count < 0) {
+            return -1;
+        }
+        for (i=0; i<count; i++) {
+            if (len + 1 < size) {
+                buf[len] = decoded[i];
+            }
+            len++;
+        }
+    }
+
+    if (size > 0) {
+        buf[len < size ? len : size - 1] = '\0';
+    }
+    return (int) len;
+}
+
+char *__glvndJsonCopyString(const __GLVNDjsonString *str)
+{
+    char *buf;
+    int len;
+
+    len = __glvndJsonDecodeString(str, NULL, 0);
+    if (len < 0) {
+        return NULL;
+    }
+    buf = (char *) malloc(len + 1);
+    if (buf != NULL) {
+        __glvndJsonDecodeString(str, buf, len + 1);
+    }
+    return buf;
+}
+
+static char ToLowerASCII(char c)
+{
+    return ((c >= 'A' && c <= 'Z') ? (c - 'A' + 'a') : c);
+}
+
+int __glvndJsonStringEquals(const __GLVNDjsonString *str, const char *name)
+{
+    const char *ptr = str->ptr;
+    const char *end = str->ptr + str->len;
+
+    while (ptr < end) {
+        char decoded[4];
+        int count = DecodeNextChar(&ptr, end, decoded);
+        int i;
+
+        if (count < 0) {
+            return 0;
+        }
+        for (i=0; i<count; i++) {
+            if (*name == '\0' || ToLowerASCII(decoded[i]) != ToLowerASCII(*name)) {
+                return 0;
+            }
+            name++;
+        }
+    }
+    return (*name == '\0');
+}
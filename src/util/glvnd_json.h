@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+#if !defined(__GLVND_JSON_H)
+#define __GLVND_JSON_H
+
+/*!
+ * \file
+ *
+ * A small pull-style JSON reader, used to read config files.
+ *
+ * Unlike a DOM parser, this doesn't build a tree of the document. The caller
+ * walks through the document one value at a time, and skips over anything it
+ * doesn't need. Strings are returned as pointers into the original buffer, so
+ * the only memory that the reader allocates is for any strings that the
+ * caller copies with \c __glvndJsonCopyString.
+ *
+ * Any syntax error puts the reader into an error state, after which every
+ * function fails. To reject a malformed file, the caller should read or skip
+ * every value in the document.
+ */
+
+#include <stddef.h>
+
+/*!
+ * A file that's been mapped into memory with \c __glvndJsonMapFile.
+ */
+typedef struct {
+    const char *data;
+    size_t size;
+} __GLVNDjsonFile;
+
+/*!
+ * The type of a JSON value, as returned by \c __glvndJsonPeek.
+ */
+typedef enum {
+    GLVND_JSON_INVALID = 0,
+    GLVND_JSON_OBJECT,
+    GLVND_JSON_ARRAY,
+    GLVND_JSON_STRING,
+    GLVND_JSON_NUMBER,
+    GLVND_JSON_TRUE,
+    GLVND_JSON_FALSE,
+    GLVND_JSON_NULL,
+} __GLVNDjsonType;
+
+/*!
+ * A string in a JSON document. \c ptr points to the contents between the
+ * quotes, before any escape sequences are decoded.
+ */
+typedef struct {
+    const char *ptr;
+    size_t len;
+} __GLVNDjsonString;
+
+/*!
+ * The state of a JSON reader.
+ *
+ * A reader can be copied to save its position, for example to come back to
+ * a value after reading the rest of an object. The copy stays valid for as
+ * long as the buffer does.
+ */
+typedef struct {
+    const char *ptr;
+    const char *end;
+    /// True if the next member or element is the first one in its container.
+    int first;
+    /// True if the reader has hit a syntax error.
+    int error;
+} __GLVNDjsonReader;
+
+/*!
+ * Maps a file into memory.
+ *
+ * \return 0 on success, or -1 if the file can't be opened or is empty.
+ */
+int __glvndJsonMapFile(const char *filename, __GLVNDjsonFile *file);
+
+/*!
+ * Unmaps a file that was mapped with \c __glvndJsonMapFile.
+ */
+void __glvndJsonUnmapFile(__GLVNDjsonFile *file);
+
+/*!
+ * Initializes a reader for a buffer. The buffer does not need to be
+ * null-terminated.
+ */
+void __glvndJsonReaderInit(__GLVNDjsonReader *reader, const char *data, size_t size);
+
+/*!
+ * Returns the type of the next value, without consuming it.
+ *
+ * \return The type of the value, or \c GLVND_JSON_INVALID if the reader is at
+ * the end of the buffer or is in an error state.
+ */
+__GLVNDjsonType __glvndJsonPeek(__GLVNDjsonReader *reader);
+
+/*!
+ * Consumes the start of an object.
+ *
+ * \return 1 on success, or 0 if the next value isn't an object.
+ */
+int __glvndJsonBeginObject(__GLVNDjsonReader *reader);
+
+/*!
+ * Moves to the next member of an object.
+ *
+ * On success, \p key is set to the member's name, and the reader is
+ * positioned at its value, which the caller must then read or skip.
+ *
+ * \return 1 if there's another member, 0 if the end of the object was
+ * consumed, or -1 on a syntax error.
+ */
+int __glvndJsonNextMember(__GLVNDjsonReader *reader, __GLVNDjsonString *key);
+
+/*!
+ * Consumes the start of an array.
+ *
+ * \return 1 on success, or 0 if the next value isn't an array.
+ */
+int __glvndJsonBeginArray(__GLVNDjsonReader *reader);
+
+/*!
+ * Moves to the next element of an array, which the caller must then read or
+ * skip.
+ *
+ * \return 1 if there's another element, 0 if the end of the array was
+ * consumed, or -1 on a syntax error.
+ */
+int __glvndJsonNextElement(__GLVNDjsonReader *reader);
+
+/*!
+ * Reads a string value.
+ *
+ * \return 1 on success, or 0 if the next value isn't a valid string.
+ */
+int __glvndJsonReadString(__GLVNDjsonReader *reader, __GLVNDjsonString *str);
+
+/*!
+ * Skips over the next value, including everything inside it if it's an
+ * object or array.
+ *
+ * \return 1 on success, or 0 on a syntax error.
+ */
+int __glvndJsonSkipValue(__GLVNDjsonReader *reader);
+
+/*!
+ * Decodes a string into a buffer.
+ *
+ * Like snprintf, this writes at most \p size bytes, including the null
+ * terminator, and returns the length of the whole decoded string. If the
+ * return value is \p size or more, then the result was truncated.
+ *
+ * \return The length of the decoded string, or -1 if it has an invalid escape
+ * sequence.
+ */
+int __glvndJsonDecodeString(const __GLVNDjsonString *str, char *buf, size_t size);
+
+/*!
+ * Returns a malloc'ed, null-terminated copy of a string, with any escape
+ * sequences decoded.
+ */
+char *__glvndJsonCopyString(const __GLVNDjsonString *str);
+
+/*!
+ * Checks whether a string matches a name, ignoring ASCII case.
+ */
+int __glvndJsonStringEquals(const __GLVNDjsonString *str, const char *name);
+
+#endif // !defined(__GLVND_JSON_H)
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+#include "glvnd_memstats.h"
+
+#include "glvnd_atomic.h"
+
+glvnd_mem_stats_t glvndMemStats[GLVND_MEM_CLASS_COUNT];
+
+static const char * const MEM_CLASS_NAMES[GLVND_MEM_CLASS_COUNT] = {
+    "dispatch_table",
+    "vendor",
+    "display",
+    "hash",
+    "name",
+    "client_string",
+    "winsys_dispatch",
+};
+
+const char *glvndMemClassName(int memClass)
+{
+    if (memClass >= 0 && memClass < GLVND_MEM_CLASS_COUNT) {
+        return MEM_CLASS_NAMES[memClass];
+    }
+    return NULL;
+}
+
+static int AtomicAdd(int volatile *ptr, int delta)
+{
+    int old;
+    do {
+        old = glvndAtomicLoadAcquire(ptr);
+    } while (!glvndAtomicCompareExchange(ptr, old, old + delta));
+    return old + delta;
+}
+
+static void Update(int memClass, int count, long delta)
+{
+    glvnd_mem_stats_t *stats = &glvndMemStats[memClass];
+    int bytes;
+    int peak;
+
+    if (count != 0) {
+        AtomicAdd((int volatile *) &stats->count, count);
+    }
+    bytes = AtomicAdd((int volatile *) &stats->bytes, (int) delta);
+
+    // Another thread can change the count in between, so the peak is only
+    // approximate.
+    do {
+        peak = glvndAtomicLoadAcquire((int volatile *) &stats->peakBytes);
+    } while (bytes > peak
+            && !glvndAtomicCompareExchange((int volatile *) &stats->peakBytes,
+                peak, bytes));
+}
+
+void glvndMemStatsAlloc(int memClass, size_t size)
+{
+    Update(memClass, 1, (long) size);
+}
+
+void glvndMemStatsFree(int memClass, size_t size)
+{
+    Update(memClass, -1, -(long) size);
+}
+
+void glvndMemStatsResize(int memClass, long delta)
+{
+    Update(memClass, 0, delta);
+}
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+#if !defined(__GLVND_MEMSTATS_H)
+#define __GLVND_MEMSTATS_H
+
+#include <stddef.h>
+
+/*!
+ * \file
+ *
+ * Counters for how much memory each kind of internal structure takes up.
+ *
+ * Each library has its own copy of these counters, and registers them with
+ * libGLdispatch so that they can be queried with \c __glDispatchGetMemStats
+ * or written out with __GLVND_MEM_STATS.
+ *
+ * The counts only include what libglvnd asks for from malloc or mmap, not any
+ * overhead that those add.
+ */
+
+enum {
+    /// Dispatch tables, including the overflow chunks.
+    GLVND_MEM_DISPATCH_TABLE,
+
+    /// Each vendor's arena, which holds its __GLXvendorInfo or __EGLvendorInfo
+    /// structure and its winsys dispatch table.
+    GLVND_MEM_VENDOR,
+
+    /// __GLXdisplayInfo and __EGLdisplayInfo structures.
+    GLVND_MEM_DISPLAY,
+
+    /// Hashtable buckets and nodes.
+    GLVND_MEM_HASH,
+
+    /// The function names in libGLdispatch's string pool.
+    GLVND_MEM_NAME,
+
+    /// The merged GLX client strings for each display.
+    GLVND_MEM_CLIENT_STRING,
+
+    /// The winsys dispatch index list.
+    GLVND_MEM_WINSYS_DISPATCH,
+
+    GLVND_MEM_CLASS_COUNT
+};
+
+typedef struct _glvnd_mem_stats_t {
+    /// The number of allocations that haven't been freed yet.
+    int count;
+
+    /// The number of bytes that haven't been freed yet.
+    int bytes;
+
+    /// The most bytes that were allocated at any one time.
+    int peakBytes;
+} glvnd_mem_stats_t;
+
+/*!
+ * This library's counters, indexed by the GLVND_MEM_* values.
+ */
+extern glvnd_mem_stats_t glvndMemStats[GLVND_MEM_CLASS_COUNT];
+
+/*!
+ * Returns a name for a GLVND_MEM_* value.
+ */
+const char *glvndMemClassName(int memClass);
+
+/*!
+ * Records a new allocation of \p size bytes.
+ */
+void glvndMemStatsAlloc(int memClass, size_t size);
+
+/*!
+ * Records that an allocation of \p size bytes was freed.
+ */
+void glvndMemStatsFree(int memClass, size_t size);
+
+/*!
+ * Records that an existing allocation grew or shrank by \p delta bytes.
+ */
+void glvndMemStatsResize(int memClass, long delta);
+
+#endif // !defined(__GLVND_MEMSTATS_H)
@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+#if !defined(__GLVND_PROBE_H)
+#define __GLVND_PROBE_H
+
+/*!
+ * \file
+ *
+ * USDT probes, for attaching tools like bpftrace, perf or systemtap to a
+ * running process.
+ *
+ * Each probe is a single no-op instruction and a note in the ELF file, so
+ * they cost nothing until something attaches to them. They're only compiled
+ * in if configure finds sys/sdt.h (see --enable-usdt); otherwise, these
+ * macros don't evaluate their arguments at all.
+ *
+ * Every probe uses the "libglvnd" provider. Most of them come in _begin and
+ * _end pairs on the same thread, so a tool can measure how long each
+ * operation took:
+ *
+ *   make_current_begin(vendorID)
+ *   make_current_end(vendorID, success)
+ *       __glDispatchMakeCurrent, in libGLdispatch.
+ *   lose_current_begin()
+ *   lose_current_end()
+ *       Releasing the current context, in libGLdispatch.
+ *   patch_begin(vendorID, stubCount)
+ *   patch_end(vendorID, ownerVendorID)
+ *       Patching or restoring the entrypoints, in libGLdispatch. stubCount is
+ *       the number of entrypoints, and ownerVendorID is the vendor that owns
+ *       them afterward, or 0 if they're unpatched.
+ *   fixup_begin(dispatch)
+ *   fixup_end(dispatch, slotCount)
+ *       Filling in a dispatch table, in libGLdispatch. slotCount is the number
+ *       of slots that were filled in.
+ *   vendor_dlopen_begin(api, name)
+ *   vendor_dlopen_end(api, name, handle)
+ *       Loading a vendor library. api is a GLDISPATCH_API_* value, and name
+ *       is the GLX vendor name or the EGL library path.
+ *   vendor_load(api, vendorID)
+ *       A vendor library finished loading.
+ *   fork_reset_begin(generation)
+ *   fork_reset_end(generation)
+ *       Cleaning up after a fork, in each of libGLX and libEGL.
+ */
+
+#if defined(USE_USDT_PROBES)
+
+#include <sys/sdt.h>
+
+#define GLVND_PROBE0(name) DTRACE_PROBE(libglvnd, name)
+#define GLVND_PROBE1(name, a1) DTRACE_PROBE1(libglvnd, name, a1)
+#define GLVND_PROBE2(name, a1, a2) DTRACE_PROBE2(libglvnd, name, a1, a2)
+#define GLVND_PROBE3(name, a1, a2, a3) DTRACE_PROBE3(libglvnd, name, a1, a2, a3)
+
+#else // defined(USE_USDT_PROBES)
+
+#define GLVND_PROBE0(name) do { } while (0)
+#define GLVND_PROBE1(name, a1) do { } while (0)
+#define GLVND_PROBE2(name, a1, a2) do { } while (0)
+#define GLVND_PROBE3(name, a1, a2, a3) do { } while (0)
+
+#endif // defined(USE_USDT_PROBES)
+
+#endif // !defined(__GLVND_PROBE_H)
@@ -34,14 +34,20 @@
 #include <assert.h>
 #include <string.h>
 #include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
 
 #include "trace.h"
 #include "glvnd_pthread.h"
-
-GLVNDPthreadFuncs __glvndPthreadFuncs = {};
+#include "glvnd_atomic.h"
+#include "utils_misc.h"
 
 const glvnd_thread_t GLVND_THREAD_NULL = GLVND_THREAD_NULL_INIT;
 
+#if !defined(GLVND_DIRECT_PTHREADS)
+
+GLVNDPthreadFuncs __glvndPthreadFuncs = {};
+
 /* The real function pointers */
 typedef struct GLVNDPthreadRealFuncsRec {
     /* Should never be used by libglvnd. May be used by some unit tests */
@@ -432,7 +438,7 @@ static void *mt_getspecific(glvnd_key_t key)
 
 void glvndSetupPthreads(void)
 {
-    char *force_st = getenv("__GL_SINGLETHREADED");
+    const char *force_st = glvndGetEnv("__GL_SINGLETHREADED");
     void *dlhandle = RTLD_DEFAULT;
     GLVNDPthreadFuncs *funcs = &__glvndPthreadFuncs;
 
@@ -510,3 +516,129 @@ fail:
     // Single-threaded
     funcs->is_singlethreaded = 1;
 }
+
+#endif // !defined(GLVND_DIRECT_PTHREADS)
+
+void glvndRWLockInitWriterPreferred(glvnd_rwlock_t *rwlock)
+{
+#if defined(HAVE_PTHREAD_RWLOCK_T) && defined(PTHREAD_RWLOCK_WRITER_NONRECURSIVE_INITIALIZER_NP)
+    // There's no way to set the kind through the wrapped functions, but a
+    // static initializer is just data, so copy one in.
+    static const glvnd_rwlock_t writerPreferred = PTHREAD_RWLOCK_WRITER_NONRECURSIVE_INITIALIZER_NP;
+    *rwlock = writerPreferred;
+#else
+    __glvndPthreadFuncs.rwlock_init(rwlock, NULL);
+#endif
+}
+
+int glvndLockProfiling = 0;
+
+/*!
+ * Protects the counters for rwlocks, since a read lock doesn't keep other
+ * readers from updating them. This is only used if profiling is enabled.
+ */
+static glvnd_mutex_t rwlockStatsMutex = GLVND_MUTEX_INITIALIZER;
+
+static uint64_t GetTimeNS(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t) ts.tv_sec) * 1000000000 + ((uint64_t) ts.tv_nsec);
+}
+
+void glvndLockProfilingInit(void)
+{
+    const char *env;
+
+    // Don't let the environment pick a file to write to in a setuid program.
+    if (getuid() != geteuid() || getgid() != getegid()) {
+        return;
+    }
+
+    env = glvndGetEnv("__GLVND_LOCK_STATS");
+    glvndLockProfiling = (env != NULL && env[0] != '\0');
+}
+
+void glvndAdaptiveMutexLockContended(glvnd_adaptive_mutex_t *mutex)
+{
+    uint64_t start = 0;
+    int i;
+
+    if (glvndLockProfiling) {
+        start = GetTimeNS();
+    }
+
+    for (i = 0; i < GLVND_ADAPTIVE_MUTEX_SPIN_COUNT; i++) {
+        glvndCpuRelax();
+        if (__glvndPthreadFuncs.mutex_trylock(&mutex->mutex) == 0) {
+            mutex->stats.acquired++;
+            mutex->stats.spun++;
+            if (glvndLockProfiling) {
+                mutex->stats.waitNS += GetTimeNS() - start;
+            }
+            return;
+        }
+    }
+
+    __glvndPthreadFuncs.mutex_lock(&mutex->mutex);
+    mutex->stats.acquired++;
+    mutex->stats.parked++;
+    if (glvndLockProfiling) {
+        mutex->stats.waitNS += GetTimeNS() - start;
+    }
+}
+
+void glvndProfiledMutexLockSlow(glvnd_mutex_t *mutex, glvnd_lock_stats_t *stats)
+{
+    uint64_t start;
+
+    if (__glvndPthreadFuncs.mutex_trylock(mutex) == 0) {
+        stats->acquired++;
+        return;
+    }
+
+    start = GetTimeNS();
+    __glvndPthreadFuncs.mutex_lock(mutex);
+    stats->acquired++;
+    stats->parked++;
+    stats->waitNS += GetTimeNS() - start;
+}
+
+void glvndProfiledRWLockSlow(glvnd_rwlock_t *rwlock, int write,
+        glvnd_lock_stats_t *stats)
+{
+    uint64_t start = 0;
+    int contended = 0;
+    int ret;
+
+    if (write) {
+        ret = __glvndPthreadFuncs.rwlock_trywrlock(rwlock);
+    } else {
+        ret = __glvndPthreadFuncs.rwlock_tryrdlock(rwlock);
+    }
+    if (ret != 0) {
+        contended = 1;
+        start = GetTimeNS();
+        if (write) {
+            __glvndPthreadFuncs.rwlock_wrlock(rwlock);
+        } else {
+            __glvndPthreadFuncs.rwlock_rdlock(rwlock);
+        }
+    }
+
+    __glvndPthreadFuncs.mutex_lock(&rwlockStatsMutex);
+    stats->acquired++;
+    if (contended) {
+        stats->parked++;
+        stats->waitNS += GetTimeNS() - start;
+    }
+    __glvndPthreadFuncs.mutex_unlock(&rwlockStatsMutex);
+}
+
+void glvndAdaptiveMutexGetStats(glvnd_adaptive_mutex_t *mutex,
+        glvnd_lock_stats_t *stats)
+{
+    __glvndPthreadFuncs.mutex_lock(&mutex->mutex);
+    *stats = mutex->stats;
+    __glvndPthreadFuncs.mutex_unlock(&mutex->mutex);
+}
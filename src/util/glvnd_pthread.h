@@ -32,6 +32,7 @@
 
 #include <pthread.h>
 #include <errno.h>
+#include <stdint.h>
 
 /*
  * pthread wrapper functions used to prevent the vendor-neutral library from
@@ -39,6 +40,12 @@
  * the library is linked against pthreads.
  * This wrapper code is also utilized by some unit tests which dynamically load
  * pthreads.
+ *
+ * If GLVND_DIRECT_PTHREADS is defined, then the library is linked against
+ * pthreads instead, which is free on systems where the pthreads functions are
+ * part of libc. In that case, __glvndPthreadFuncs is a constant table of
+ * inline wrappers, so the compiler turns each call through it into a direct
+ * call to the pthreads function, and is_singlethreaded is always zero.
  */
 
 /*
@@ -90,7 +97,7 @@ typedef union {
  * singlethreaded case.
  */
 typedef struct GLVNDPthreadFuncsRec {
-    /* Should never be used by libglvnd. May be used by some unit tests */
+    /* Used by libGLX to preload vendor libraries, and by some unit tests */
     int (*create)(glvnd_thread_t *thread, const glvnd_thread_attr_t *attr,
                   void *(*start_routine) (void *), void *arg);
     int (*join)(glvnd_thread_t thread, void **retval);
@@ -143,6 +150,111 @@ typedef struct GLVNDPthreadFuncsRec {
  */
 extern const glvnd_thread_t GLVND_THREAD_NULL;
 
+#if defined(GLVND_DIRECT_PTHREADS)
+
+static inline int __glvndDirectCreate(glvnd_thread_t *thread, const glvnd_thread_attr_t *attr,
+                  void *(*start_routine) (void *), void *arg)
+{
+    int rv = pthread_create(&thread->tid, attr, start_routine, arg);
+    thread->valid = (rv == 0 ? 1 : 0);
+    return rv;
+}
+
+static inline int __glvndDirectJoin(glvnd_thread_t thread, void **retval)
+{
+    return pthread_join(thread.tid, retval);
+}
+
+static inline glvnd_thread_t __glvndDirectSelf(void)
+{
+    glvnd_thread_t thread;
+    thread.tid = pthread_self();
+    thread.valid = 1;
+    return thread;
+}
+
+static inline int __glvndDirectEqual(glvnd_thread_t t1, glvnd_thread_t t2)
+{
+    return (!t1.valid && !t2.valid) ||
+            (t1.valid && t2.valid && pthread_equal(t1.tid, t2.tid));
+}
+
+static inline int __glvndDirectOnce(glvnd_once_t *once_control, void (*init_routine)(void))
+{
+    return pthread_once(&once_control->once, init_routine);
+}
+
+static inline int __glvndDirectKeyCreate(glvnd_key_t *key, void (*destr_function)(void *))
+{
+    return pthread_key_create(&key->key, destr_function);
+}
+
+static inline int __glvndDirectKeyDelete(glvnd_key_t key)
+{
+    return pthread_key_delete(key.key);
+}
+
+static inline int __glvndDirectSetSpecific(glvnd_key_t key, const void *p)
+{
+    return pthread_setspecific(key.key, p);
+}
+
+static inline void *__glvndDirectGetSpecific(glvnd_key_t key)
+{
+    return pthread_getspecific(key.key);
+}
+
+static const GLVNDPthreadFuncs __glvndPthreadDirectFuncs __attribute__((unused)) = {
+    .create = __glvndDirectCreate,
+    .join = __glvndDirectJoin,
+    .self = __glvndDirectSelf,
+    .equal = __glvndDirectEqual,
+
+    .mutex_init = pthread_mutex_init,
+    .mutex_destroy = pthread_mutex_destroy,
+    .mutex_lock = pthread_mutex_lock,
+    .mutex_trylock = pthread_mutex_trylock,
+    .mutex_unlock = pthread_mutex_unlock,
+
+    .mutexattr_init = pthread_mutexattr_init,
+    .mutexattr_destroy = pthread_mutexattr_destroy,
+    .mutexattr_settype = pthread_mutexattr_settype,
+
+#if defined(HAVE_PTHREAD_RWLOCK_T)
+    .rwlock_init = pthread_rwlock_init,
+    .rwlock_destroy = pthread_rwlock_destroy,
+    .rwlock_rdlock = pthread_rwlock_rdlock,
+    .rwlock_wrlock = pthread_rwlock_wrlock,
+    .rwlock_tryrdlock = pthread_rwlock_tryrdlock,
+    .rwlock_trywrlock = pthread_rwlock_trywrlock,
+    .rwlock_unlock = pthread_rwlock_unlock,
+#else
+    .rwlock_init = pthread_mutex_init,
+    .rwlock_destroy = pthread_mutex_destroy,
+    .rwlock_rdlock = pthread_mutex_lock,
+    .rwlock_wrlock = pthread_mutex_lock,
+    .rwlock_tryrdlock = pthread_mutex_trylock,
+    .rwlock_trywrlock = pthread_mutex_trylock,
+    .rwlock_unlock = pthread_mutex_unlock,
+#endif
+
+    .once = __glvndDirectOnce,
+    .key_create = __glvndDirectKeyCreate,
+    .key_delete = __glvndDirectKeyDelete,
+    .setspecific = __glvndDirectSetSpecific,
+    .getspecific = __glvndDirectGetSpecific,
+
+    .is_singlethreaded = 0,
+};
+
+#define __glvndPthreadFuncs __glvndPthreadDirectFuncs
+
+static inline void glvndSetupPthreads(void)
+{
+}
+
+#else // defined(GLVND_DIRECT_PTHREADS)
+
 /**
  * The function table with all of the pthreads function pointers. This table
  * is initialized by \c glvndSetupPthreads.
@@ -158,6 +270,163 @@ extern GLVNDPthreadFuncs __glvndPthreadFuncs;
  */
 void glvndSetupPthreads(void);
 
+#endif // defined(GLVND_DIRECT_PTHREADS)
+
+/*
+ * An adaptive mutex, for a global lock whose critical sections are only a few
+ * instructions long. Locking one spins for a short while with trylock before
+ * it blocks in mutex_lock, so that a thread doesn't have to sleep and wake up
+ * again just because another thread was holding the lock for a moment.
+ *
+ * The counters are only modified while holding the lock. Use
+ * \c glvndAdaptiveMutexGetStats to read them.
+ */
+
+/**
+ * The number of times that \c glvndAdaptiveMutexLock will try to take a
+ * contended mutex before it blocks.
+ */
+#define GLVND_ADAPTIVE_MUTEX_SPIN_COUNT 100
+
+typedef struct _glvnd_lock_stats_t {
+    /// The number of times that the lock was taken.
+    unsigned long acquired;
+    /// The number of times that the lock was taken after spinning.
+    unsigned long spun;
+    /// The number of times that a thread blocked waiting for the lock.
+    unsigned long parked;
+    /// The total time that threads spent spinning or blocked, in nanoseconds.
+    /// This is only counted if lock profiling is enabled.
+    uint64_t waitNS;
+} glvnd_lock_stats_t;
+
+typedef struct _glvnd_adaptive_mutex_t {
+    glvnd_mutex_t mutex;
+    glvnd_lock_stats_t stats;
+} glvnd_adaptive_mutex_t;
+
+#define GLVND_ADAPTIVE_MUTEX_INITIALIZER { GLVND_MUTEX_INITIALIZER, { 0, 0, 0, 0 } }
 
+/**
+ * The slow path of \c glvndAdaptiveMutexLock, after the first trylock fails.
+ */
+void glvndAdaptiveMutexLockContended(glvnd_adaptive_mutex_t *mutex);
+
+static inline void glvndAdaptiveMutexInit(glvnd_adaptive_mutex_t *mutex)
+{
+    __glvndPthreadFuncs.mutex_init(&mutex->mutex, NULL);
+    mutex->stats.acquired = 0;
+    mutex->stats.spun = 0;
+    mutex->stats.parked = 0;
+    mutex->stats.waitNS = 0;
+}
+
+static inline void glvndAdaptiveMutexDestroy(glvnd_adaptive_mutex_t *mutex)
+{
+    __glvndPthreadFuncs.mutex_destroy(&mutex->mutex);
+}
+
+static inline void glvndAdaptiveMutexLock(glvnd_adaptive_mutex_t *mutex)
+{
+    if (__glvndPthreadFuncs.mutex_trylock(&mutex->mutex) == 0) {
+        mutex->stats.acquired++;
+    } else {
+        glvndAdaptiveMutexLockContended(mutex);
+    }
+}
+
+static inline void glvndAdaptiveMutexUnlock(glvnd_adaptive_mutex_t *mutex)
+{
+    __glvndPthreadFuncs.mutex_unlock(&mutex->mutex);
+}
+
+/**
+ * Returns a snapshot of a mutex's contention counters.
+ *
+ * The caller must not already hold the mutex.
+ */
+void glvndAdaptiveMutexGetStats(glvnd_adaptive_mutex_t *mutex,
+        glvnd_lock_stats_t *stats);
+
+/*
+ * Lock profiling.
+ *
+ * If the __GLVND_LOCK_STATS environment variable is set, then the locks that
+ * libglvnd registers with \c __glDispatchRegisterLockStats count how often
+ * they're taken, how often a thread has to wait for them, and how long it
+ * waits. Adaptive mutexes always keep their counts, and only add the wait
+ * time when profiling is on. Other locks have to be taken with
+ * \c glvndProfiledMutexLock and the like, which only look at their stats
+ * when profiling is on.
+ *
+ * Every library that links against this has its own copy of
+ * \c glvndLockProfiling, so each one needs to call
+ * \c glvndLockProfilingInit when it's loaded.
+ */
+extern int glvndLockProfiling;
+
+/**
+ * Checks the __GLVND_LOCK_STATS environment variable, and sets
+ * \c glvndLockProfiling.
+ */
+void glvndLockProfilingInit(void);
+
+void glvndProfiledMutexLockSlow(glvnd_mutex_t *mutex, glvnd_lock_stats_t *stats);
+void glvndProfiledRWLockSlow(glvnd_rwlock_t *rwlock, int write,
+        glvnd_lock_stats_t *stats);
+
+/**
+ * Locks a mutex, and updates \p stats if lock profiling is enabled.
+ */
+static inline void glvndProfiledMutexLock(glvnd_mutex_t *mutex,
+        glvnd_lock_stats_t *stats)
+{
+    if (!glvndLockProfiling) {
+        __glvndPthreadFuncs.mutex_lock(mutex);
+    } else {
+        glvndProfiledMutexLockSlow(mutex, stats);
+    }
+}
+
+/**
+ * Takes a read or write lock, and updates \p stats if lock profiling is
+ * enabled.
+ *
+ * Since several readers can hold the lock at once, the counts for an rwlock
+ * are updated under a separate mutex.
+ */
+static inline void glvndProfiledRWLockRead(glvnd_rwlock_t *rwlock,
+        glvnd_lock_stats_t *stats)
+{
+    if (!glvndLockProfiling) {
+        __glvndPthreadFuncs.rwlock_rdlock(rwlock);
+    } else {
+        glvndProfiledRWLockSlow(rwlock, 0, stats);
+    }
+}
+
+static inline void glvndProfiledRWLockWrite(glvnd_rwlock_t *rwlock,
+        glvnd_lock_stats_t *stats)
+{
+    if (!glvndLockProfiling) {
+        __glvndPthreadFuncs.rwlock_wrlock(rwlock);
+    } else {
+        glvndProfiledRWLockSlow(rwlock, 1, stats);
+    }
+}
+
+/**
+ * Initializes an rwlock that prefers writers.
+ *
+ * With the default rwlock, a new reader can always join the readers that
+ * already hold the lock, so a steady stream of readers can keep a writer
+ * waiting for a long time. With this one, new readers wait behind a waiting
+ * writer instead. That means that a thread must never take the read lock
+ * while it's already holding it, since it could deadlock behind a writer.
+ *
+ * This uses glibc's PTHREAD_RWLOCK_WRITER_NONRECURSIVE_INITIALIZER_NP where
+ * it's available. Otherwise, it's the same as a default rwlock.
+ */
+void glvndRWLockInitWriterPreferred(glvnd_rwlock_t *rwlock);
 
 #endif // __GLVND_PTHREAD_H__
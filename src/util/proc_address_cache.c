@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+#include "proc_address_cache.h"
+
+#include <string.h>
+#include <stdint.h>
+#include <assert.h>
+
+#include "glvnd_hashmap.h"
+
+/*!
+ * A map of names to addresses. The map doesn't own the addresses, and entries
+ * are never removed until \c __glvndProcAddressCacheCleanup.
+ */
+static __GLVNDhashMap cacheMap = GLVND_HASHMAP_INITIALIZER(NULL);
+
+/*!
+ * A map of names that couldn't be found, to the generation that they were
+ * looked up in.
+ */
+static __GLVNDhashMap missMap = GLVND_HASHMAP_INITIALIZER(NULL);
+
+/*!
+ * The most names that \c missMap will hold.
+ */
+#define MAX_MISS_COUNT 256
+
+void *__glvndProcAddressCacheLookup(const char *name)
+{
+    void *addr;
+
+    __glvndHashMapReadBegin();
+    addr = __glvndHashMapFind(&cacheMap, name, strlen(name));
+    __glvndHashMapReadEnd();
+
+    return addr;
+}
+
+void __glvndProcAddressCacheAdd(const char *name, void *addr)
+{
+    size_t len = strlen(name);
+    void *oldAddr;
+
+    __glvndHashMapLock(&cacheMap, name, len);
+    oldAddr = __glvndHashMapFind(&cacheMap, name, len);
+    if (oldAddr == NULL) {
+        __glvndHashMapInsert(&cacheMap, name, len, addr);
+    } else {
+        assert(oldAddr == addr);
+    }
+    __glvndHashMapUnlock(&cacheMap, name, len);
+}
+
+int __glvndProcAddressCacheIsMiss(const char *name, unsigned int generation)
+{
+    uintptr_t value;
+
+    __glvndHashMapReadBegin();
+    value = (uintptr_t) __glvndHashMapFind(&missMap, name, strlen(name));
+    __glvndHashMapReadEnd();
+
+    return (value != 0 && value == generation);
+}
+
+void __glvndProcAddressCacheAddMiss(const char *name, unsigned int generation)
+{
+    size_t len = strlen(name);
+
+    assert(generation != 0);
+
+    __glvndHashMapLock(&missMap, name, len);
+    if (__glvndHashMapFind(&missMap, name, len) != NULL) {
+        __glvndHashMapReplace(&missMap, name, len, (void *) (uintptr_t) generation);
+    } else if (__glvndHashMapCount(&missMap) < MAX_MISS_COUNT) {
+        __glvndHashMapInsert(&missMap, name, len, (void *) (uintptr_t) generation);
+    }
+    __glvndHashMapUnlock(&missMap, name, len);
+}
+
+void __glvndProcAddressCacheReset(void)
+{
+    __glvndHashMapReset(&cacheMap);
+    __glvndHashMapReset(&missMap);
+}
+
+void __glvndProcAddressCacheCleanup(void)
+{
+    __glvndHashMapTeardown(&cacheMap, NULL, NULL, 0);
+    __glvndHashMapTeardown(&missMap, NULL, NULL, 0);
+}
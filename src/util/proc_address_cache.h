@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+#if !defined(__PROC_ADDRESS_CACHE_H)
+#define __PROC_ADDRESS_CACHE_H
+
+/*!
+ * \file
+ *
+ * A cache of function names and addresses for glXGetProcAddress and
+ * eglGetProcAddress.
+ *
+ * This covers the functions that are looked up at runtime. Functions that the
+ * library itself exports are in static sorted tables instead, which the
+ * caller should search first.
+ *
+ * The cache is global state, and each library that links against this gets
+ * its own copy.
+ */
+
+/*!
+ * Looks up a function in the runtime cache.
+ *
+ * \return The address of the function, or \c NULL if it's not in the cache.
+ */
+void *__glvndProcAddressCacheLookup(const char *name);
+
+/*!
+ * Adds a function to the runtime cache. If the function is already in the
+ * cache, then this does nothing.
+ */
+void __glvndProcAddressCacheAdd(const char *name, void *addr);
+
+/*!
+ * Checks whether a function was recorded as missing by
+ * \c __glvndProcAddressCacheAddMiss with the same \p generation.
+ *
+ * The caller should change \p generation whenever a function that was
+ * missing could have become available, such as when it loads another vendor
+ * library.
+ */
+int __glvndProcAddressCacheIsMiss(const char *name, unsigned int generation);
+
+/*!
+ * Records that a function couldn't be found, so that the next lookup for it
+ * can fail without searching again.
+ *
+ * \p generation must not be zero. Only a limited number of names are kept,
+ * so a program that looks up a lot of different names can't grow the cache
+ * forever.
+ */
+void __glvndProcAddressCacheAddMiss(const char *name, unsigned int generation);
+
+/*!
+ * Resets the cache locks after a fork. The cached addresses are kept.
+ */
+void __glvndProcAddressCacheReset(void);
+
+/*!
+ * Frees everything in the runtime cache.
+ */
+void __glvndProcAddressCacheCleanup(void);
+
+#endif // !defined(__PROC_ADDRESS_CACHE_H)
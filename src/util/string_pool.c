@@ -0,0 +1,249 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+#include "string_pool.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "glvnd_pthread.h"
+#include "glvnd_atomic.h"
+#include "glvnd_hash.h"
+#include "glvnd_memstats.h"
+
+/*!
+ * The default size of each block of memory that strings are copied into.
+ */
+#define STRING_BLOCK_SIZE 16384
+
+/*!
+ * The starting size of the hash table. The table is doubled in size whenever
+ * it would be more than half full.
+ */
+#define STRING_HASH_MIN_SIZE 512
+
+/*!
+ * A block of memory that strings are packed into.
+ *
+ * Each string is stored as its 32-bit hash, followed by the string itself,
+ * padded out so that the next hash is aligned.
+ */
+typedef struct StringBlockRec {
+    struct StringBlockRec *next;
+    size_t size;
+    size_t used;
+    uint32_t data[];
+} StringBlock;
+
+/*!
+ * An open-addressing hash table of the strings in the pool.
+ *
+ * When the table grows, the old table is kept around until the pool is
+ * cleaned up, since another thread might still be looking through it.
+ */
+typedef struct StringHashTableRec {
+    struct StringHashTableRec *prev;
+    uint32_t size;
+    const char * volatile slots[];
+} StringHashTable;
+
+static StringHashTable * volatile stringHash;
+static uint32_t stringCount;
+static StringBlock *stringBlocks;
+
+/*!
+ * Protects adding strings to the pool. Readers don't need it.
+ */
+static glvnd_mutex_t stringLock = GLVND_MUTEX_INITIALIZER;
+
+static size_t StringHashTableSize(uint32_t size)
+{
+    return sizeof(StringHashTable) + size * sizeof(const char *);
+}
+
+static const char *FindString(const StringHashTable *table,
+        const char *str, uint32_t hash)
+{
+    uint32_t mask = table->size - 1;
+    uint32_t slot;
+    const char *entry;
+
+    for (slot = hash & mask;
+            (entry = glvndAtomicLoadAcquirePtr((void * volatile *) &table->slots[slot])) != NULL;
+            slot = (slot + 1) & mask) {
+        if (__glvndStringPoolGetHash(entry) == hash && strcmp(entry, str) == 0) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+static void InsertString(StringHashTable *table, const char *str)
+{
+    uint32_t mask = table->size - 1;
+    uint32_t slot = __glvndStringPoolGetHash(str) & mask;
+
+    while (table->slots[slot] != NULL) {
+        slot = (slot + 1) & mask;
+    }
+    glvndAtomicStoreReleasePtr((void * volatile *) &table->slots[slot], (void *) str);
+}
+
+/*!
+ * Makes sure that there's room in the hash table for one more string. This
+ * must be called while holding stringLock.
+ */
+static StringHashTable *ReserveHashSlot(void)
+{
+    StringHashTable *table = stringHash;
+    StringHashTable *newTable;
+    uint32_t newSize;
+    uint32_t i;
+
+    if (table != NULL && (stringCount + 1) * 2 <= table->size) {
+        return table;
+    }
+
+    newSize = (table != NULL ? table->size * 2 : STRING_HASH_MIN_SIZE);
+    newTable = calloc(1, StringHashTableSize(newSize));
+    if (newTable == NULL) {
+        return NULL;
+    }
+    glvndMemStatsAlloc(GLVND_MEM_HASH, StringHashTableSize(newSize));
+    newTable->size = newSize;
+    newTable->prev = table;
+
+    if (table != NULL) {
+        for (i=0; i<table->size; i++) {
+            if (table->slots[i] != NULL) {
+                InsertString(newTable, table->slots[i]);
+            }
+        }
+    }
+
+    glvndAtomicStoreReleasePtr((void * volatile *) &stringHash, newTable);
+    return newTable;
+}
+
+/*!
+ * Copies a string into the string blocks, along with its hash. This must be
+ * called while holding stringLock.
+ */
+static const char *CopyString(const char *str, uint32_t hash)
+{
+    StringBlock *block = stringBlocks;
+    size_t len = strlen(str) + 1;
+    // The number of 32-bit words for the hash and the string.
+    size_t words = 1 + (len + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+    uint32_t *entry;
+
+    if (block == NULL || block->size - block->used < words) {
+        size_t size = STRING_BLOCK_SIZE / sizeof(uint32_t);
+        if (size < words) {
+            size = words;
+        }
+
+        block = malloc(sizeof(*block) + size * sizeof(uint32_t));
+        if (block == NULL) {
+            return NULL;
+        }
+        glvndMemStatsAlloc(GLVND_MEM_NAME, sizeof(*block) + size * sizeof(uint32_t));
+        block->size = size;
+        block->used = 0;
+        block->next = stringBlocks;
+        stringBlocks = block;
+    }
+
+    entry = block->data + block->used;
+    entry[0] = hash;
+    memcpy(&entry[1], str, len);
+    block->used += words;
+    return (const char *) &entry[1];
+}
+
+const char *__glvndStringPoolIntern(const char *str)
+{
+    StringHashTable *table;
+    const char *entry;
+    uint32_t hash = glvndHashString(str);
+
+    table = glvndAtomicLoadAcquirePtr((void * volatile *) &stringHash);
+    if (table != NULL) {
+        entry = FindString(table, str, hash);
+        if (entry != NULL) {
+            return entry;
+        }
+    }
+
+    __glvndPthreadFuncs.mutex_lock(&stringLock);
+
+    // Check again in case another thread added the same string.
+    entry = NULL;
+    if (stringHash != NULL) {
+        entry = FindString(stringHash, str, hash);
+    }
+    if (entry == NULL) {
+        table = ReserveHashSlot();
+        if (table != NULL) {
+            entry = CopyString(str, hash);
+            if (entry != NULL) {
+                InsertString(table, entry);
+                stringCount++;
+            }
+        }
+    }
+
+    __glvndPthreadFuncs.mutex_unlock(&stringLock);
+    return entry;
+}
+
+void __glvndStringPoolReset(void)
+{
+    __glvndPthreadFuncs.mutex_init(&stringLock, NULL);
+}
+
+void __glvndStringPoolCleanup(void)
+{
+    while (stringBlocks != NULL) {
+        StringBlock *next = stringBlocks->next;
+        glvndMemStatsFree(GLVND_MEM_NAME,
+                sizeof(*stringBlocks) + stringBlocks->size * sizeof(uint32_t));
+        free(stringBlocks);
+        stringBlocks = next;
+    }
+
+    while (stringHash != NULL) {
+        StringHashTable *prev = stringHash->prev;
+        glvndMemStatsFree(GLVND_MEM_HASH, StringHashTableSize(stringHash->size));
+        free(stringHash);
+        stringHash = prev;
+    }
+    stringCount = 0;
+}
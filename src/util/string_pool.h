@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+#if !defined(__STRING_POOL_H)
+#define __STRING_POOL_H
+
+#include <stdint.h>
+
+/*!
+ * \file
+ *
+ * A pool of interned strings.
+ *
+ * Each distinct string is only stored once, so two strings from the pool are
+ * equal if and only if the pointers are equal. The hash of each string is
+ * stored along with it, so that it doesn't have to be computed again.
+ *
+ * This is linked into libGLdispatch, which exports it to libGLX and libEGL
+ * through \c __glDispatchInternString, so that every library shares the same
+ * copy of each function name.
+ *
+ * Looking up a string that's already in the pool doesn't take a lock. Strings
+ * are never removed until \c __glvndStringPoolCleanup.
+ */
+
+/*!
+ * Returns the pooled copy of a string, adding it if it isn't there yet.
+ *
+ * \return The pooled string, or NULL if it couldn't be added.
+ */
+const char *__glvndStringPoolIntern(const char *str);
+
+/*!
+ * Returns the \c glvndHashString hash of a string that was returned by
+ * \c __glvndStringPoolIntern.
+ */
+static inline uint32_t __glvndStringPoolGetHash(const char *str)
+{
+    return ((const uint32_t *) str)[-1];
+}
+
+/*!
+ * Resets the pool's lock after a fork. The strings are kept.
+ */
+void __glvndStringPoolReset(void);
+
+/*!
+ * Frees every string in the pool.
+ */
+void __glvndStringPoolCleanup(void);
+
+#endif // !defined(__STRING_POOL_H)
@@ -55,8 +55,8 @@ void __glvnd_dbg_printf(
     int ret;
 
     if (!debugPrintfInitialized) {
-        char *debugStr = getenv("__GL_DEBUG");
-        char *showPrefixStr = getenv("__GL_DEBUG_FILE_LINE_INFO");
+        const char *debugStr = glvndGetEnv("__GL_DEBUG");
+        const char *showPrefixStr = glvndGetEnv("__GL_DEBUG_FILE_LINE_INFO");
         if (debugStr) {
             debugPrintfLevel = atoi(debugStr);
         }
@@ -39,6 +39,11 @@
 #include <fcntl.h>
 #include <assert.h>
 
+#include "glvnd_hash.h"
+#include "glvnd_atomic.h"
+
+extern char **environ;
+
 int glvnd_asprintf(char **strp, const char *fmt, ...)
 {
     va_list args;
@@ -101,22 +106,137 @@ void glvnd_byte_swap16(uint16_t* array, const size_t size)
     }
 }
 
-int FindNextStringToken(const char **tok, size_t *len, const char *sep)
+void glvnd_prefault_pages(const void *start, size_t size, int lock)
 {
-    // Skip to the end of the current name.
-    const char *ptr = *tok + *len;
+    long pageSize = sysconf(_SC_PAGESIZE);
+    uintptr_t first, end, addr;
+
+    if (size == 0 || pageSize <= 0) {
+        return;
+    }
+
+    first = ((uintptr_t) start) & ~((uintptr_t) pageSize - 1);
+    end = ((uintptr_t) start) + size;
+
+    // mlock faults in the pages, too, so if it works, then we're done.
+    if (lock && mlock((void *) first, end - first) == 0) {
+        return;
+    }
+
+#if defined(MADV_POPULATE_READ)
+    if (madvise((void *) first, end - first, MADV_POPULATE_READ) == 0) {
+        return;
+    }
+#endif
+
+    // Otherwise, read a byte from each page. The first page might start
+    // before the caller's memory, so start reading at the caller's address.
+    for (addr = first; addr < end; addr += pageSize) {
+        const volatile char *ptr = (const volatile char *)
+            (addr > (uintptr_t) start ? addr : (uintptr_t) start);
+        (void) *ptr;
+    }
+}
+
+/*!
+ * A copy of the environment variables that \c glvndGetEnv can return.
+ */
+typedef struct {
+    size_t count;
+    /// Each entry is a "NAME=VALUE" string.
+    const char *vars[];
+} GLVNDenvSnapshot;
+
+static GLVNDenvSnapshot *envSnapshot = NULL;
+
+static int IsSnapshotEnvName(const char *name, size_t len)
+{
+    return (len >= 4 && strncmp(name, "__GL", 4) == 0)
+        || (len >= 6 && strncmp(name, "__EGL_", 6) == 0)
+        || (len == 12 && strncmp(name, "EGL_PLATFORM", 12) == 0);
+}
+
+static GLVNDenvSnapshot *CreateEnvSnapshot(void)
+{
+    GLVNDenvSnapshot *snapshot;
+    size_t count = 0;
+    size_t size = 0;
+    char *buf;
+    char **var;
+
+    for (var = environ; var != NULL && *var != NULL; var++) {
+        if (IsSnapshotEnvName(*var, strcspn(*var, "="))) {
+            count++;
+            size += strlen(*var) + 1;
+        }
+    }
+
+    snapshot = malloc(sizeof(GLVNDenvSnapshot) + count * sizeof(const char *) + size);
+    if (snapshot == NULL) {
+        return NULL;
+    }
 
-    // Skip any leading separators.
-    while (*ptr != '\x00' && strchr(sep, *ptr) != NULL) {
-        ptr++;
+    buf = (char *) (snapshot->vars + count);
+    snapshot->count = 0;
+    for (var = environ; var != NULL && *var != NULL; var++) {
+        if (IsSnapshotEnvName(*var, strcspn(*var, "="))) {
+            size_t len = strlen(*var) + 1;
+            if (snapshot->count >= count || len > size) {
+                // Something changed the environment since the first pass.
+                break;
+            }
+            memcpy(buf, *var, len);
+            snapshot->vars[snapshot->count++] = buf;
+            buf += len;
+            size -= len;
+        }
+    }
+    return snapshot;
+}
+
+const char *glvndGetEnv(const char *name)
+{
+    GLVNDenvSnapshot *snapshot;
+    size_t len = strlen(name);
+    size_t i;
+
+    if (!IsSnapshotEnvName(name, len)) {
+        return getenv(name);
     }
 
-    // Find the length of the current token.
-    *len = 0;
-    while (ptr[*len] != '\x00' && strchr(sep, ptr[*len]) == NULL) {
-        (*len)++;
+    snapshot = glvndAtomicLoadAcquirePtr((void * volatile *) &envSnapshot);
+    if (snapshot == NULL) {
+        snapshot = CreateEnvSnapshot();
+        if (snapshot == NULL) {
+            return getenv(name);
+        }
+        if (!glvndAtomicCompareExchangePtr((void * volatile *) &envSnapshot, NULL, snapshot)) {
+            // Another thread got here first, so use its copy.
+            free(snapshot);
+            snapshot = glvndAtomicLoadAcquirePtr((void * volatile *) &envSnapshot);
+        }
     }
+
+    for (i=0; i<snapshot->count; i++) {
+        const char *var = snapshot->vars[i];
+        if (strncmp(var, name, len) == 0 && var[len] == '=') {
+            return var + len + 1;
+        }
+    }
+    return NULL;
+}
+
+int FindNextStringToken(const char **tok, size_t *len, const char *sep)
+{
+    // Skip to the end of the current name.
+    const char *ptr = *tok + *len;
+
+    // Skip any leading separators, and then find the length of the current
+    // token. The C library's strspn and strcspn scan a block at a time, so
+    // they're faster than checking each character with strchr.
+    ptr += strspn(ptr, sep);
     *tok = ptr;
+    *len = strcspn(ptr, sep);
     return (*len > 0 ? 1 : 0);
 }
 
@@ -181,8 +301,122 @@ int IsTokenInString(const char *str, const char *token, size_t tokenLen, const c
     return 0;
 }
 
+/**
+ * The smallest number of slots in an extension set.
+ */
+#define EXTENSION_SET_MIN_CAPACITY 16
+
+static GLVNDstringView *FindExtensionSetSlot(GLVNDstringView *slots, size_t capacity,
+        const char *token, size_t tokenLen)
+{
+    size_t mask = capacity - 1;
+    size_t i = glvndHashBytes(token, tokenLen) & mask;
+
+    while (slots[i].str != NULL) {
+        if (slots[i].len == tokenLen && memcmp(slots[i].str, token, tokenLen) == 0) {
+            break;
+        }
+        i = (i + 1) & mask;
+    }
+    return &slots[i];
+}
+
+static int ResizeExtensionSet(GLVNDextensionSet *set, size_t capacity)
+{
+    GLVNDstringView *slots;
+    size_t i;
+
+    slots = (GLVNDstringView *) calloc(capacity, sizeof(GLVNDstringView));
+    if (slots == NULL) {
+        return -1;
+    }
+    for (i=0; i<set->capacity; i++) {
+        if (set->slots[i].str != NULL) {
+            *FindExtensionSetSlot(slots, capacity, set->slots[i].str,
+                    set->slots[i].len) = set->slots[i];
+        }
+    }
+    free(set->slots);
+    set->slots = slots;
+    set->capacity = capacity;
+    return 0;
+}
+
+int ExtensionSetInit(GLVNDextensionSet *set, const char *str)
+{
+    const char *token;
+    size_t tokenLen;
+    size_t count = 0;
+    size_t capacity = EXTENSION_SET_MIN_CAPACITY;
+
+    token = str;
+    tokenLen = 0;
+    while (FindNextStringToken(&token, &tokenLen, " ")) {
+        count++;
+    }
+    // Keep the table at most half full, so that probes stay short.
+    while (capacity < count * 2) {
+        capacity *= 2;
+    }
+
+    set->slots = NULL;
+    set->capacity = 0;
+    set->count = 0;
+    if (ResizeExtensionSet(set, capacity) != 0) {
+        return -1;
+    }
+
+    token = str;
+    tokenLen = 0;
+    while (FindNextStringToken(&token, &tokenLen, " ")) {
+        if (ExtensionSetAdd(set, token, tokenLen) < 0) {
+            ExtensionSetFree(set);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+void ExtensionSetFree(GLVNDextensionSet *set)
+{
+    free(set->slots);
+    set->slots = NULL;
+    set->capacity = 0;
+    set->count = 0;
+}
+
+int ExtensionSetAdd(GLVNDextensionSet *set, const char *token, size_t tokenLen)
+{
+    GLVNDstringView *slot;
+
+    if ((set->count + 1) * 2 > set->capacity) {
+        if (ResizeExtensionSet(set, set->capacity * 2) != 0) {
+            return -1;
+        }
+    }
+
+    slot = FindExtensionSetSlot(set->slots, set->capacity, token, tokenLen);
+    if (slot->str != NULL) {
+        return 0;
+    }
+    slot->str = token;
+    slot->len = tokenLen;
+    set->count++;
+    return 1;
+}
+
+const GLVNDstringView *ExtensionSetFind(const GLVNDextensionSet *set,
+        const char *token, size_t tokenLen)
+{
+    const GLVNDstringView *slot;
+
+    slot = FindExtensionSetSlot(set->slots, set->capacity, token, tokenLen);
+    return (slot->str != NULL ? slot : NULL);
+}
+
 char *UnionExtensionStrings(char *currentString, const char *newString)
 {
+    GLVNDextensionSet set;
     size_t origLen;
     size_t newLen;
     const char *token;
@@ -203,51 +437,81 @@ char *UnionExtensionStrings(char *currentString, const char *newString)
         return buf;
     }
 
+    if (ExtensionSetInit(&set, currentString) != 0) {
+        free(currentString);
+        return NULL;
+    }
+
+    // Add each new extension to the set. The set then points to the first
+    // copy of each name in newString that isn't already in currentString.
     token = newString;
     tokenLen = 0;
     while (FindNextStringToken(&token, &tokenLen, " ")) {
-        if (!IsTokenInString(currentString, token, tokenLen, " ")) {
+        int ret = ExtensionSetAdd(&set, token, tokenLen);
+        if (ret < 0) {
+            ExtensionSetFree(&set);
+            free(currentString);
+            return NULL;
+        } else if (ret > 0) {
             newLen += tokenLen + 1;
         }
     }
     if (origLen == newLen) {
         // No new extensions to add.
+        ExtensionSetFree(&set);
         return currentString;
     }
 
-    buf = (char *) realloc(currentString, newLen + 1);
+    // Copy into a new buffer rather than using realloc, because the set still
+    // points into currentString.
+    buf = (char *) malloc(newLen + 1);
     if (buf == NULL) {
+        ExtensionSetFree(&set);
         free(currentString);
         return NULL;
     }
-    currentString = NULL;
+    memcpy(buf, currentString, origLen);
 
     ptr = buf + origLen;
     token = newString;
     tokenLen = 0;
     while (FindNextStringToken(&token, &tokenLen, " ")) {
-        if (!IsTokenInString(buf, token, tokenLen, " ")) {
+        if (ExtensionSetFind(&set, token, tokenLen)->str == token) {
             *ptr++ = ' ';
             memcpy(ptr, token, tokenLen);
             ptr += tokenLen;
-            *ptr = '\0';
         }
     }
+    *ptr = '\0';
     assert((size_t) (ptr - buf) == newLen);
+
+    ExtensionSetFree(&set);
+    free(currentString);
     return buf;
 }
 
 void IntersectionExtensionStrings(char *currentString, const char *newString)
 {
+    GLVNDextensionSet set;
     const char *token;
     size_t tokenLen;
     char *ptr;
 
+    // If the set can't be allocated, then set.slots will be NULL, and this
+    // falls back to scanning newString for each token.
+    ExtensionSetInit(&set, newString);
+
     token = currentString;
     tokenLen = 0;
     ptr = currentString;
     while(FindNextStringToken(&token, &tokenLen, " ")) {
-        if (IsTokenInString(newString, token, tokenLen, " ")) {
+        int found;
+        if (set.slots != NULL) {
+            found = (ExtensionSetFind(&set, token, tokenLen) != NULL);
+        } else {
+            found = IsTokenInString(newString, token, tokenLen, " ");
+        }
+        if (found) {
             if (ptr != currentString) {
                 *ptr++ = ' ';
             }
@@ -256,4 +520,8 @@ void IntersectionExtensionStrings(char *currentString, const char *newString)
         }
     }
     *ptr = '\0';
+
+    if (set.slots != NULL) {
+        ExtensionSetFree(&set);
+    }
 }
@@ -76,6 +76,27 @@ int glvnd_vasprintf(char **strp, const char *fmt, va_list args);
  */
 void glvnd_byte_swap16(uint16_t* array, const size_t size);
 
+/*!
+ * Faults in every page from \p start to \p start + \p size, so that the
+ * first real access to them doesn't take a page fault.
+ *
+ * The memory must be readable. If \p lock is non-zero, then this also tries
+ * to lock the pages in memory with mlock(2). Any errors are ignored.
+ */
+void glvnd_prefault_pages(const void *start, size_t size, int lock);
+
+/*!
+ * Returns the value of a libglvnd environment variable.
+ *
+ * The first call copies every variable whose name starts with "__GL" or
+ * "__EGL_", along with "EGL_PLATFORM", out of the environment. Later lookups
+ * for those names only search that copy, instead of scanning all of
+ * \c environ again. Any other name is passed to getenv.
+ *
+ * Changes to the environment after the first call are not seen.
+ */
+const char *glvndGetEnv(const char *name);
+
 /*!
  * Helper function for tokenizing a string.
  *
@@ -128,6 +149,65 @@ char **SplitString(const char *str, size_t *count, const char *sep);
  */
 int IsTokenInString(const char *str, const char *token, size_t tokenLen, const char *sep);
 
+/*!
+ * A token in an extension string. This points into the string that it came
+ * from, so it's only valid for as long as that string is.
+ */
+typedef struct {
+    const char *str;
+    size_t len;
+} GLVNDstringView;
+
+/*!
+ * A hash set of extension names, used to merge extension strings without
+ * rescanning a string for every token.
+ *
+ * The set doesn't copy the names, so any string that it's built from must
+ * stay valid and unmodified until the set is freed.
+ */
+typedef struct {
+    /// An open-addressed table. An unused slot has a NULL \c str.
+    GLVNDstringView *slots;
+    /// The number of slots, which is always a power of two.
+    size_t capacity;
+    /// The number of names in the set.
+    size_t count;
+} GLVNDextensionSet;
+
+/*!
+ * Initializes an extension set with every name in an extension string.
+ *
+ * \param[out] set The set to initialize.
+ * \param[in] str A space-separated extension string.
+ * \return 0 on success, or -1 if an allocation failed.
+ */
+int ExtensionSetInit(GLVNDextensionSet *set, const char *str);
+
+/*!
+ * Frees the memory used by an extension set.
+ */
+void ExtensionSetFree(GLVNDextensionSet *set);
+
+/*!
+ * Adds a name to an extension set.
+ *
+ * \param set The set.
+ * \param token The name to add. It does not need to be null-terminated.
+ * \param tokenLen The length of \p token.
+ * \return 1 if the name was added, 0 if it was already in the set, or -1 if
+ * an allocation failed.
+ */
+int ExtensionSetAdd(GLVNDextensionSet *set, const char *token, size_t tokenLen);
+
+/*!
+ * Looks up a name in an extension set.
+ *
+ * \return The copy of the name that's in the set, or NULL if it isn't in the
+ * set.
+ */
+const GLVNDstringView *ExtensionSetFind(const GLVNDextensionSet *set,
+        const char *token, size_t tokenLen);
+
 /**
  * Merges two extension strings (that is, finds the union of two sets of
  * extensions).
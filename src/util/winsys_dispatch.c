@@ -30,7 +30,12 @@
 #include "winsys_dispatch.h"
 
 #include "glvnd_pthread.h"
-#include "lkdhash.h"
+#include "glvnd_atomic.h"
+#include "glvnd_memstats.h"
+#include "glvnd_hash.h"
+#include "GLdispatch.h"
+#include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 
 // The initial size to use when we allocate the function list. This is large
@@ -38,13 +43,134 @@
 #define INITIAL_LIST_SIZE 64
 
 typedef struct __GLVNDwinsysDispatchIndexEntryRec {
-    char *name;
+    /// The name, from libGLdispatch's string pool.
+    const char *name;
     void *dispatchFunc;
+    unsigned int hash;
 } __GLVNDwinsysDispatchIndexEntry;
 
-static __GLVNDwinsysDispatchIndexEntry *dispatchIndexList = NULL;
-static int dispatchIndexCount = 0;
-static int dispatchIndexAllocCount = 0;
+/*!
+ * The functions from __glvndWinsysDispatchSetStaticList, which get the first
+ * indices. Any functions in indexTable come after those.
+ */
+static const __GLVNDwinsysDispatchStaticList *staticList = NULL;
+static int staticCount = 0;
+
+/*!
+ * The functions that were added with __glvndWinsysDispatchAllocIndex.
+ *
+ * Lookups don't take a lock. An entry is filled in before it's counted in
+ * \c count, and \c count is updated before the entry's hash slot, so a reader
+ * that finds an index can always look up its name and dispatch function.
+ *
+ * When the table fills up, a larger copy is allocated and published in its
+ * place. The old table is kept in the \c retired list until
+ * __glvndWinsysDispatchCleanup, since another thread could still be reading
+ * it. The names are shared between the copies.
+ */
+typedef struct __GLVNDwinsysDispatchIndexTableRec {
+    struct __GLVNDwinsysDispatchIndexTableRec *retired;
+    int volatile count;
+    int allocCount;
+    __GLVNDwinsysDispatchIndexEntry *entries;
+
+    /*!
+     * An open-addressed hashtable of (index + 1) into \c entries, keyed by the
+     * function name. A zero means an empty slot.
+     *
+     * The size is always twice \c allocCount, so that a lookup always
+     * reaches an empty slot.
+     */
+    int volatile *hash;
+} __GLVNDwinsysDispatchIndexTable;
+
+static __GLVNDwinsysDispatchIndexTable * volatile indexTable = NULL;
+
+static size_t IndexTableSize(int allocCount)
+{
+    return sizeof(__GLVNDwinsysDispatchIndexTable)
+        + allocCount * sizeof(__GLVNDwinsysDispatchIndexEntry)
+        + allocCount * 2 * sizeof(int);
+}
+
+static __GLVNDwinsysDispatchIndexTable *GetIndexTable(void)
+{
+    return (__GLVNDwinsysDispatchIndexTable *)
+        glvndAtomicLoadAcquirePtr((void * volatile *) &indexTable);
+}
+
+static int FindStaticIndex(const char *name, unsigned int hash)
+{
+    const __GLVNDwinsysDispatchHashSlot *slot;
+    unsigned int seed;
+
+    if (staticCount == 0) {
+        return -1;
+    }
+
+    seed = staticList->seeds[hash % staticList->seedCount];
+    slot = &staticList->slots[glvndHashSlot(hash, seed, staticCount)];
+    if (slot->hash == hash && strcmp(staticList->names[slot->index], name) == 0) {
+        return slot->index;
+    }
+    return -1;
+}
+
+/*!
+ * Returns the hash slot in \p table for a name, which is either the slot
+ * that holds it or the empty slot where it would go.
+ */
+static int FindDispatchHashSlot(__GLVNDwinsysDispatchIndexTable *table,
+        const char *name, unsigned int hash)
+{
+    int mask = table->allocCount * 2 - 1;
+    int slot = (int) (hash & mask);
+    int value;
+
+    while ((value = glvndAtomicLoadAcquire(&table->hash[slot])) != 0) {
+        const __GLVNDwinsysDispatchIndexEntry *entry = &table->entries[value - 1];
+        if (entry->hash == hash && strcmp(entry->name, name) == 0) {
+            break;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+/*!
+ * Replaces indexTable with a larger copy.
+ */
+static __GLVNDwinsysDispatchIndexTable *GrowIndexTable(void)
+{
+    __GLVNDwinsysDispatchIndexTable *oldTable = indexTable;
+    __GLVNDwinsysDispatchIndexTable *table;
+    int allocCount = (oldTable != NULL ? oldTable->allocCount * 2 : INITIAL_LIST_SIZE);
+    int i;
+
+    table = (__GLVNDwinsysDispatchIndexTable *) calloc(1, IndexTableSize(allocCount));
+    if (table == NULL) {
+        return NULL;
+    }
+    glvndMemStatsAlloc(GLVND_MEM_WINSYS_DISPATCH, IndexTableSize(allocCount));
+
+    table->retired = oldTable;
+    table->allocCount = allocCount;
+    table->entries = (__GLVNDwinsysDispatchIndexEntry *) (table + 1);
+    table->hash = (int volatile *) (table->entries + allocCount);
+
+    if (oldTable != NULL) {
+        table->count = oldTable->count;
+        memcpy(table->entries, oldTable->entries,
+                oldTable->count * sizeof(__GLVNDwinsysDispatchIndexEntry));
+        for (i=0; i<table->count; i++) {
+            const __GLVNDwinsysDispatchIndexEntry *entry = &table->entries[i];
+            table->hash[FindDispatchHashSlot(table, entry->name, entry->hash)] = i + 1;
+        }
+    }
+
+    glvndAtomicStoreReleasePtr((void * volatile *) &indexTable, table);
+    return table;
+}
 
 void __glvndWinsysDispatchInit(void)
 {
@@ -53,63 +179,97 @@ void __glvndWinsysDispatchInit(void)
 
 void __glvndWinsysDispatchCleanup(void)
 {
-    int i;
+    __GLVNDwinsysDispatchIndexTable *table = indexTable;
 
-    for (i=0; i<dispatchIndexCount; i++) {
-        free(dispatchIndexList[i].name);
+    while (table != NULL) {
+        __GLVNDwinsysDispatchIndexTable *next = table->retired;
+        glvndMemStatsFree(GLVND_MEM_WINSYS_DISPATCH, IndexTableSize(table->allocCount));
+        free(table);
+        table = next;
     }
-    free(dispatchIndexList);
-    dispatchIndexList = NULL;
-    dispatchIndexCount = dispatchIndexAllocCount = 0;
+    indexTable = NULL;
+
+    staticList = NULL;
+    staticCount = 0;
 }
 
+void __glvndWinsysDispatchSetStaticList(const __GLVNDwinsysDispatchStaticList *list)
+{
+    assert(staticList == NULL && indexTable == NULL);
+    staticList = list;
+    staticCount = list->count;
+}
 
 int __glvndWinsysDispatchFindIndex(const char *name)
 {
-    int i;
+    __GLVNDwinsysDispatchIndexTable *table;
+    unsigned int hash = glvndHashString(name);
+    int index;
+    int slot;
 
-    for (i=0; i<dispatchIndexCount; i++) {
-        if (strcmp(dispatchIndexList[i].name, name) == 0) {
-            return i;
-        }
+    index = FindStaticIndex(name, hash);
+    if (index >= 0) {
+        return index;
     }
 
-    return -1;
+    table = GetIndexTable();
+    if (table == NULL) {
+        return -1;
+    }
+
+    slot = FindDispatchHashSlot(table, name, hash);
+    index = glvndAtomicLoadAcquire(&table->hash[slot]);
+    if (index == 0) {
+        return -1;
+    }
+    return staticCount + index - 1;
 }
 
 int __glvndWinsysDispatchAllocIndex(const char *name, void *dispatch)
 {
-    assert(__glvndWinsysDispatchFindIndex(name) < 0);
+    __GLVNDwinsysDispatchIndexTable *table = indexTable;
+    __GLVNDwinsysDispatchIndexEntry *entry;
+    unsigned int hash = glvndHashString(name);
+    int index;
+    int slot;
 
-    if (dispatchIndexCount == dispatchIndexAllocCount) {
-        __GLVNDwinsysDispatchIndexEntry *newList;
-        int newSize = dispatchIndexAllocCount * 2;
-        if (newSize <= 0) {
-            newSize = INITIAL_LIST_SIZE;
-        }
+    assert(FindStaticIndex(name, hash) < 0);
 
-        newList = realloc(dispatchIndexList, newSize * sizeof(__GLVNDwinsysDispatchIndexEntry));
-        if (newList == NULL) {
+    if (table == NULL || table->count == table->allocCount) {
+        table = GrowIndexTable();
+        if (table == NULL) {
             return -1;
         }
-
-        dispatchIndexList = newList;
-        dispatchIndexAllocCount = newSize;
     }
 
-    dispatchIndexList[dispatchIndexCount].name = strdup(name);
-    if (dispatchIndexList[dispatchIndexCount].name == NULL) {
+    slot = FindDispatchHashSlot(table, name, hash);
+    assert(table->hash[slot] == 0);
+
+    index = table->count;
+    entry = &table->entries[index];
+    entry->name = __glDispatchInternString(name);
+    if (entry->name == NULL) {
         return -1;
     }
+    entry->dispatchFunc = dispatch;
+    entry->hash = hash;
 
-    dispatchIndexList[dispatchIndexCount].dispatchFunc = dispatch;
-    return dispatchIndexCount++;
+    glvndAtomicStoreRelease(&table->count, index + 1);
+    glvndAtomicStoreRelease(&table->hash[slot], index + 1);
+    return staticCount + index;
 }
 
 const char *__glvndWinsysDispatchGetName(int index)
 {
-    if (index >= 0 && index < dispatchIndexCount) {
-        return dispatchIndexList[index].name;
+    __GLVNDwinsysDispatchIndexTable *table;
+
+    if (index >= 0 && index < staticCount) {
+        return staticList->names[index];
+    }
+    index -= staticCount;
+    table = GetIndexTable();
+    if (table != NULL && index >= 0 && index < glvndAtomicLoadAcquire(&table->count)) {
+        return table->entries[index].name;
     } else {
         return NULL;
     }
@@ -117,8 +277,15 @@ const char *__glvndWinsysDispatchGetName(int index)
 
 void *__glvndWinsysDispatchGetDispatch(int index)
 {
-    if (index >= 0 && index < dispatchIndexCount) {
-        return dispatchIndexList[index].dispatchFunc;
+    __GLVNDwinsysDispatchIndexTable *table;
+
+    if (index >= 0 && index < staticCount) {
+        return (void *) staticList->funcs[index];
+    }
+    index -= staticCount;
+    table = GetIndexTable();
+    if (table != NULL && index >= 0 && index < glvndAtomicLoadAcquire(&table->count)) {
+        return table->entries[index].dispatchFunc;
     } else {
         return NULL;
     }
@@ -126,76 +293,133 @@ void *__glvndWinsysDispatchGetDispatch(int index)
 
 int __glvndWinsysDispatchGetCount(void)
 {
-    return dispatchIndexCount;
+    __GLVNDwinsysDispatchIndexTable *table = GetIndexTable();
+    return staticCount + (table != NULL ? glvndAtomicLoadAcquire(&table->count) : 0);
 }
 
+const char **__glvndWinsysDispatchGetNames(int *count)
+{
+    __GLVNDwinsysDispatchIndexTable *table = GetIndexTable();
+    int dynamicCount = (table != NULL ? glvndAtomicLoadAcquire(&table->count) : 0);
+    const char **names;
+    int i;
 
-typedef struct __GLVNDwinsysDispatchFuncHashRec {
-    int index;
-    void *implFunc;
-    UT_hash_handle hh;
-} __GLVNDwinsysDispatchFuncHash;
+    *count = 0;
+    if (staticCount + dynamicCount == 0) {
+        return NULL;
+    }
+    names = malloc((staticCount + dynamicCount) * sizeof(const char *));
+    if (names == NULL) {
+        return NULL;
+    }
+
+    for (i=0; i<staticCount; i++) {
+        names[i] = staticList->names[i];
+    }
+    for (i=0; i<dynamicCount; i++) {
+        names[staticCount + i] = table->entries[i].name;
+    }
+    *count = staticCount + dynamicCount;
+    return names;
+}
+
+
+/*!
+ * A block of function pointers, indexed by the dispatch index.
+ *
+ * A vendor's dispatch table only ever grows. When an index doesn't fit, a
+ * larger block is allocated, the old pointers are copied into it, and then
+ * the new block is published with a release store. The old block stays in
+ * the vendor's arena, since another thread might still be reading from it.
+ */
+typedef struct __GLVNDwinsysDispatchFuncBlockRec {
+    int size;
+    void * volatile funcs[];
+} __GLVNDwinsysDispatchFuncBlock;
 
 struct __GLVNDwinsysVendorDispatchRec {
-    DEFINE_LKDHASH(__GLVNDwinsysDispatchFuncHash, table);
+    __GLVNDwinsysDispatchFuncBlock * volatile block;
+
+    /*!
+     * The arena to allocate new blocks from.
+     */
+    __GLVNDarena *arena;
+
+    /*!
+     * Serializes __glvndWinsysVendorDispatchAddFunc. Lookups don't take this.
+     */
+    glvnd_mutex_t mutex;
 };
 
-__GLVNDwinsysVendorDispatch *__glvndWinsysVendorDispatchCreate(void)
+__GLVNDwinsysVendorDispatch *__glvndWinsysVendorDispatchCreate(__GLVNDarena *arena)
 {
     __GLVNDwinsysVendorDispatch *table = (__GLVNDwinsysVendorDispatch *)
-        malloc(sizeof(__GLVNDwinsysVendorDispatch));
+        __glvndArenaAlloc(arena, sizeof(__GLVNDwinsysVendorDispatch));
     if (table == NULL) {
         return NULL;
     }
 
-    LKDHASH_INIT(table->table);
+    table->block = NULL;
+    table->arena = arena;
+    __glvndPthreadFuncs.mutex_init(&table->mutex, NULL);
     return table;
 }
 
 void __glvndWinsysVendorDispatchDestroy(__GLVNDwinsysVendorDispatch *table)
 {
     if (table != NULL) {
-        LKDHASH_TEARDOWN(__GLVNDwinsysDispatchFuncHash,
-                         table->table, NULL, NULL, 0);
-        free(table);
+        __glvndPthreadFuncs.mutex_destroy(&table->mutex);
     }
 }
 
 int __glvndWinsysVendorDispatchAddFunc(__GLVNDwinsysVendorDispatch *table, int index, void *func)
 {
-    __GLVNDwinsysDispatchFuncHash *entry;
+    __GLVNDwinsysDispatchFuncBlock *block;
+
+    if (index < 0) {
+        return -1;
+    }
+
+    __glvndPthreadFuncs.mutex_lock(&table->mutex);
+    block = table->block;
+    if (block == NULL || index >= block->size) {
+        __GLVNDwinsysDispatchFuncBlock *newBlock;
+        int newSize = (block != NULL ? block->size * 2 : INITIAL_LIST_SIZE);
+
+        if (newSize < __glvndWinsysDispatchGetCount()) {
+            newSize = __glvndWinsysDispatchGetCount();
+        }
+        if (newSize <= index) {
+            newSize = index + 1;
+        }
 
-    LKDHASH_WRLOCK(table->table);
-    HASH_FIND_INT(_LH(table->table), &index, entry);
-    if (entry == NULL) {
-        entry = (__GLVNDwinsysDispatchFuncHash *) malloc(sizeof(__GLVNDwinsysDispatchFuncHash));
-        if (entry == NULL) {
-            LKDHASH_UNLOCK(table->table);
+        newBlock = (__GLVNDwinsysDispatchFuncBlock *) __glvndArenaAlloc(table->arena,
+                sizeof(__GLVNDwinsysDispatchFuncBlock) + newSize * sizeof(void *));
+        if (newBlock == NULL) {
+            __glvndPthreadFuncs.mutex_unlock(&table->mutex);
             return -1;
         }
+        newBlock->size = newSize;
+        if (block != NULL) {
+            memcpy((void *) newBlock->funcs, (void *) block->funcs,
+                    block->size * sizeof(void *));
+        }
 
-        entry->index = index;
-        HASH_ADD_INT(_LH(table->table), index, entry);
+        glvndAtomicStoreReleasePtr((void * volatile *) &table->block, newBlock);
+        block = newBlock;
     }
-    entry->implFunc = func;
-    LKDHASH_UNLOCK(table->table);
+    glvndAtomicStoreReleasePtr(&block->funcs[index], func);
+    __glvndPthreadFuncs.mutex_unlock(&table->mutex);
     return 0;
 }
 
 void *__glvndWinsysVendorDispatchLookupFunc(__GLVNDwinsysVendorDispatch *table, int index)
 {
-    __GLVNDwinsysDispatchFuncHash *entry;
-    void *func;
+    __GLVNDwinsysDispatchFuncBlock *block = (__GLVNDwinsysDispatchFuncBlock *)
+        glvndAtomicLoadAcquirePtr((void * volatile *) &table->block);
 
-    LKDHASH_RDLOCK(table->table);
-    HASH_FIND_INT(_LH(table->table), &index, entry);
-    if (entry != NULL) {
-        func = entry->implFunc;
-    } else {
-        func = NULL;
+    if (block == NULL || index < 0 || index >= block->size) {
+        return NULL;
     }
-    LKDHASH_UNLOCK(table->table);
-
-    return func;
+    return glvndAtomicLoadAcquirePtr(&block->funcs[index]);
 }
-
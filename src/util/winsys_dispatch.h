@@ -30,6 +30,8 @@
 #ifndef WINSYS_DISPATCH_H
 #define WINSYS_DISPATCH_H
 
+#include "glvnd_arena.h"
+
 /*!
  * \file
  *
@@ -38,6 +40,10 @@
  *
  * These functions keep track of an array of functions, with a name and pointer
  * for each.
+ *
+ * Looking up a function doesn't take a lock, and is safe to do at the same
+ * time as \c __glvndWinsysDispatchAllocIndex. Adding functions still has to
+ * be serialized by the caller.
  */
 
 /*!
@@ -50,6 +56,68 @@ void __glvndWinsysDispatchInit(void);
  */
 void __glvndWinsysDispatchCleanup(void);
 
+/*!
+ * A slot in the hash table of a static function list.
+ */
+typedef struct __GLVNDwinsysDispatchHashSlotRec {
+    /*!
+     * The FNV-1a hash of the function name.
+     */
+    unsigned int hash;
+
+    /*!
+     * The index of the function in the list.
+     */
+    int index;
+} __GLVNDwinsysDispatchHashSlot;
+
+/*!
+ * A list of functions that's generated at build time.
+ *
+ * The hash table is a minimal perfect hash of the names, generated by
+ * buildPerfectHash in genCommon.py, so a lookup only ever has to check one
+ * slot.
+ */
+typedef struct __GLVNDwinsysDispatchStaticListRec {
+    /*!
+     * The number of functions, which is also the number of hash slots.
+     */
+    int count;
+
+    /*!
+     * The name of each function.
+     */
+    const char * const *names;
+
+    /*!
+     * The dispatch stub for each function.
+     */
+    void (* const *funcs)(void);
+
+    /*!
+     * The seed value for each hash bucket.
+     */
+    const unsigned short *seeds;
+    int seedCount;
+
+    /*!
+     * The hash table.
+     */
+    const __GLVNDwinsysDispatchHashSlot *slots;
+} __GLVNDwinsysDispatchStaticList;
+
+/*!
+ * Adds a static list of functions.
+ *
+ * The functions get the indices from 0 to list->count - 1, in the same order
+ * as the list, without copying anything. This must be called before any other
+ * function is added.
+ *
+ * \param list The function list. This must stay valid until
+ *      __glvndWinsysDispatchCleanup is called.
+ */
+void __glvndWinsysDispatchSetStaticList(const __GLVNDwinsysDispatchStaticList *list);
+
 /*!
  * Looks up a function by name.
  *
@@ -62,7 +130,12 @@ int __glvndWinsysDispatchFindIndex(const char *name);
  * Adds a function to the list. The function must not already be in the list.
  *
  * Note that the function index list is global state, and this function is not
- * thread-safe. The caller is responsible for protecting access to it.
+ * thread-safe with respect to itself. The caller is responsible for making
+ * sure that only one thread adds a function at a time.
+ *
+ * Another thread can find the new function as soon as it's added, so the
+ * caller needs its own way to tell other threads when anything else about the
+ * function is ready, such as telling each vendor about the new index.
  *
  * \param name The name of the function.
  * \param dispatch A pointer to the dispatch stub for the function.
@@ -91,6 +164,15 @@ void *__glvndWinsysDispatchGetDispatch(int index);
  */
 int __glvndWinsysDispatchGetCount(void);
 
+/*!
+ * Returns the name of every function in the list, in index order.
+ *
+ * \param[out] count Returns the number of names.
+ * \return An array that the caller must free, or \c NULL if the list is
+ *      empty or we couldn't allocate the array.
+ */
+const char **__glvndWinsysDispatchGetNames(int *count);
+
 
 /*!
  * A dispatch table to keep track of the window-system functions from a vendor
@@ -100,11 +182,16 @@ typedef struct __GLVNDwinsysVendorDispatchRec __GLVNDwinsysVendorDispatch;
 
 /*!
  * Creates an empty dispatch table.
+ *
+ * The table and its function blocks are allocated from \p arena, which
+ * should be the vendor's arena. After this, the table takes its own lock
+ * before allocating from the arena, so the caller shouldn't allocate anything
+ * else from it while another thread could be adding functions.
  */
-__GLVNDwinsysVendorDispatch *__glvndWinsysVendorDispatchCreate(void);
+__GLVNDwinsysVendorDispatch *__glvndWinsysVendorDispatchCreate(__GLVNDarena *arena);
 
 /*!
- * Frees a dispatch table.
+ * Cleans up a dispatch table. The memory is freed along with the arena.
  */
 void __glvndWinsysVendorDispatchDestroy(__GLVNDwinsysVendorDispatch *table);
 
@@ -0,0 +1,403 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+
+/*
+ * Measures GetProcAddress throughput by replaying the lookups that a
+ * generated loader like glad or epoxy makes at startup.
+ *
+ * The name trace comes from procaddress_trace.txt, which is generated from
+ * the XML files in src/generate/xml at build time. Each line has an API ("gl", "glx" or
+ * "egl") and a function name. The -a option picks which function to call:
+ *
+ *   gldispatch  __glDispatchGetProcAddress, with only the "gl" names.
+ *   glx         glXGetProcAddress, with the "gl" and "glx" names.
+ *   egl         eglGetProcAddress, with the "gl" and "egl" names.
+ *
+ * Each API should run in its own process, since the first pass through the
+ * trace is what fills in libglvnd's caches. The first pass runs on -c
+ * threads at once, and every call in it is timed on its own. After that,
+ * the whole trace is replayed -n more times on one thread, and then on -t
+ * threads at once.
+ *
+ * The output has one line for each pass, with comma-separated fields: the
+ * API, the pass ("cold" or "warm"), the number of threads, the number of
+ * names that were found and not found, the average nanoseconds per name, the
+ * 50th and 99th percentile and maximum nanoseconds for a single name (cold
+ * pass only), and for the multithreaded warm pass, the slowdown compared to
+ * the single-threaded one. With no more threads than CPUs, a slowdown much
+ * above 1 means that the threads are waiting on each other's locks. The
+ * slowest names in the cold pass follow as '#' comments.
+ */
+
+#include <GL/glx.h>
+#include <EGL/egl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "GLdispatch.h"
+
+#define SLOWEST_NAME_COUNT 10
+
+enum {
+    API_GLDISPATCH,
+    API_GLX,
+    API_EGL,
+    API_COUNT
+};
+
+static const char *API_NAMES[API_COUNT] = { "gldispatch", "glx", "egl" };
+
+typedef void *(*GetProcFunc)(const char *name);
+
+typedef struct BenchThreadRec {
+    pthread_t thread;
+    int passes;
+    uint64_t *latencies; // One per name, or NULL to time the whole pass
+    int hits;
+    int misses;
+    uint64_t elapsed;
+} BenchThread;
+
+static GetProcFunc getProc;
+static char **names;
+static int nameCount;
+static pthread_barrier_t startBarrier;
+
+static void *GetProcGLdispatch(const char *name)
+{
+    return __glDispatchGetProcAddress(name);
+}
+
+static void *GetProcGLX(const char *name)
+{
+    return (void *) glXGetProcAddress((const GLubyte *) name);
+}
+
+static void *GetProcEGL(const char *name)
+{
+    return (void *) eglGetProcAddress(name);
+}
+
+static uint64_t GetTimeNS(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t) ts.tv_sec) * 1000000000 + ((uint64_t) ts.tv_nsec);
+}
+
+static int CompareLatencies(const void *a, const void *b)
+{
+    uint64_t va = *((const uint64_t *) a);
+    uint64_t vb = *((const uint64_t *) b);
+    return (va < vb ? -1 : (va > vb ? 1 : 0));
+}
+
+/*!
+ * Reads the names for \p api from the trace file.
+ */
+static int ReadTrace(const char *filename, int api)
+{
+    char line[256];
+    int capacity = 0;
+    FILE *in = fopen(filename, "r");
+
+    if (in == NULL) {
+        printf("Can't open %s\n", filename);
+        return 0;
+    }
+
+    while (fgets(line, sizeof(line), in) != NULL) {
+        char *name = strchr(line, ' ');
+
+        if (line[0] == '#' || name == NULL) {
+            continue;
+        }
+        *name++ = '\0';
+        name[strcspn(name, "\r\n")] = '\0';
+
+        if (strcmp(line, "gl") != 0 && strcmp(line, API_NAMES[api]) != 0) {
+            continue;
+        }
+
+        if (nameCount >= capacity) {
+            capacity = (capacity > 0 ? capacity * 2 : 1024);
+            names = realloc(names, capacity * sizeof(char *));
+            if (names == NULL) {
+                printf("Out of memory\n");
+                fclose(in);
+                return 0;
+            }
+        }
+        names[nameCount] = strdup(name);
+        if (names[nameCount] == NULL) {
+            printf("Out of memory\n");
+            fclose(in);
+            return 0;
+        }
+        nameCount++;
+    }
+    fclose(in);
+
+    if (nameCount == 0) {
+        printf("No names for %s in %s\n", API_NAMES[api], filename);
+        return 0;
+    }
+    return 1;
+}
+
+static void *BenchThreadProc(void *param)
+{
+    BenchThread *bt = (BenchThread *) param;
+    uint64_t start;
+    int pass, i;
+
+    pthread_barrier_wait(&startBarrier);
+
+    start = GetTimeNS();
+    for (pass=0; pass<bt->passes; pass++) {
+        for (i=0; i<nameCount; i++) {
+            uint64_t nameStart = 0;
+            void *addr;
+
+            if (bt->latencies != NULL) {
+                nameStart = GetTimeNS();
+            }
+            addr = getProc(names[i]);
+            if (bt->latencies != NULL) {
+                bt->latencies[i] = GetTimeNS() - nameStart;
+            }
+
+            if (addr != NULL) {
+                bt->hits++;
+            } else {
+                bt->misses++;
+            }
+        }
+    }
+    bt->elapsed = GetTimeNS() - start;
+    return NULL;
+}
+
+/*!
+ * Replays the trace \p passes times on each of \p numThreads threads, and
+ * prints the results.
+ *
+ * \param baseline The ns per name of the single-threaded pass to compare
+ *      against, or 0 if this is the single-threaded pass.
+ * \return The average ns per name, or a negative number on failure.
+ */
+static double RunPass(int api, const char *passName, int numThreads, int passes,
+        int timeEachName, double baseline)
+{
+    BenchThread *threads;
+    uint64_t *all = NULL;
+    double nsPerName;
+    uint64_t totalElapsed = 0;
+    int hits = 0, misses = 0;
+    int i;
+
+    threads = calloc(numThreads, sizeof(BenchThread));
+    if (threads == NULL) {
+        printf("Out of memory\n");
+        return -1.0;
+    }
+    if (timeEachName) {
+        all = malloc(((size_t) numThreads) * nameCount * sizeof(uint64_t));
+        if (all == NULL) {
+            printf("Out of memory\n");
+            free(threads);
+            return -1.0;
+        }
+    }
+
+    pthread_barrier_init(&startBarrier, NULL, numThreads);
+    for (i=0; i<numThreads; i++) {
+        threads[i].passes = passes;
+        if (timeEachName) {
+            threads[i].latencies = all + ((size_t) i) * nameCount;
+        }
+    }
+    // The first thread runs on the main thread, so that a single-threaded
+    // pass doesn't involve any other threads at all.
+    for (i=1; i<numThreads; i++) {
+        if (pthread_create(&threads[i].thread, NULL, BenchThreadProc, &threads[i]) != 0) {
+            printf("pthread_create failed\n");
+            abort();
+        }
+    }
+    BenchThreadProc(&threads[0]);
+    for (i=1; i<numThreads; i++) {
+        pthread_join(threads[i].thread, NULL);
+    }
+    pthread_barrier_destroy(&startBarrier);
+
+    for (i=0; i<numThreads; i++) {
+        totalElapsed += threads[i].elapsed;
+        hits += threads[i].hits;
+        misses += threads[i].misses;
+    }
+    nsPerName = ((double) totalElapsed) / (((double) numThreads) * passes * nameCount);
+
+    printf("%s,%s,%d,%d,%d,%.1f", API_NAMES[api], passName, numThreads,
+            hits, misses, nsPerName);
+    if (timeEachName) {
+        size_t total = ((size_t) numThreads) * nameCount;
+        uint64_t *sorted = malloc(total * sizeof(uint64_t));
+        if (sorted == NULL) {
+            printf("\nOut of memory\n");
+            abort();
+        }
+        memcpy(sorted, all, total * sizeof(uint64_t));
+        qsort(sorted, total, sizeof(uint64_t), CompareLatencies);
+        printf(",%llu,%llu,%llu",
+                (unsigned long long) sorted[total / 2],
+                (unsigned long long) sorted[(total * 99) / 100],
+                (unsigned long long) sorted[total - 1]);
+        free(sorted);
+    } else {
+        printf(",,,");
+    }
+    if (baseline > 0.0) {
+        printf(",%.2f\n", nsPerName / baseline);
+    } else {
+        printf(",\n");
+    }
+
+    if (timeEachName) {
+        // List the slowest names from the first thread. A name can show up
+        // more than once, since the trace has repeats.
+        for (i=0; i<SLOWEST_NAME_COUNT && i<nameCount; i++) {
+            int slowest = 0;
+            int j;
+            for (j=1; j<nameCount; j++) {
+                if (all[j] > all[slowest]) {
+                    slowest = j;
+                }
+            }
+            printf("# %s %llu ns\n", names[slowest], (unsigned long long) all[slowest]);
+            all[slowest] = 0;
+        }
+    }
+
+    free(all);
+    free(threads);
+    return nsPerName;
+}
+
+int main(int argc, char **argv)
+{
+    const char *traceFile;
+    int api = API_GLDISPATCH;
+    int passes = 100;
+    int coldThreads = 1;
+    int maxThreads = 8;
+    double single;
+
+    while (1) {
+        int opt = getopt(argc, argv, "a:c:n:t:");
+        if (opt == -1) {
+            break;
+        }
+        switch (opt) {
+        case 'a':
+            for (api=0; api<API_COUNT; api++) {
+                if (strcmp(optarg, API_NAMES[api]) == 0) {
+                    break;
+                }
+            }
+            if (api >= API_COUNT) {
+                printf("Unknown API %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'c':
+            coldThreads = atoi(optarg);
+            break;
+        case 'n':
+            passes = atoi(optarg);
+            break;
+        case 't':
+            maxThreads = atoi(optarg);
+            break;
+        default:
+            return 1;
+        }
+    }
+    if (optind + 1 != argc) {
+        printf("Usage: %s [-a gldispatch|glx|egl] [-c threads] [-n passes] [-t threads] trace\n",
+                argv[0]);
+        return 1;
+    }
+    traceFile = argv[optind];
+    if (passes <= 0 || coldThreads <= 0 || maxThreads <= 0) {
+        printf("Invalid pass or thread count\n");
+        return 1;
+    }
+
+    if (!ReadTrace(traceFile, api)) {
+        return 1;
+    }
+
+    switch (api) {
+    case API_GLX:
+        getProc = GetProcGLX;
+        break;
+    case API_EGL:
+        getProc = GetProcEGL;
+        break;
+    default:
+        __glDispatchInit();
+        getProc = GetProcGLdispatch;
+        break;
+    }
+
+    printf("# api,pass,threads,hits,misses,ns_per_name,p50_ns,p99_ns,max_ns,slowdown (%d names, %d warm passes)\n",
+            nameCount, passes);
+    if (RunPass(api, "cold", coldThreads, 1, 1, 0.0) < 0.0) {
+        return 1;
+    }
+    single = RunPass(api, "warm", 1, passes, 0, 0.0);
+    if (single < 0.0) {
+        return 1;
+    }
+    if (maxThreads > 1 && RunPass(api, "warm", maxThreads, passes, 0, single) < 0.0) {
+        return 1;
+    }
+
+    if (api == API_GLDISPATCH) {
+        __glDispatchFini();
+    }
+    return 0;
+}
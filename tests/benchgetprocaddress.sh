@@ -0,0 +1,10 @@
+#!/bin/sh
+
+# Runs benchgetprocaddress for each API, each in a separate process so that
+# every run starts with empty caches. The arguments are passed through.
+
+. $TOP_SRCDIR/tests/eglenv.sh
+
+for api in gldispatch glx egl ; do
+    ./benchgetprocaddress -a $api "$@" $TOP_BUILDDIR/tests/procaddress_trace.txt || exit 1
+done
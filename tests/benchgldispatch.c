@@ -0,0 +1,326 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+/*
+ * Measures how long a call takes through each kind of dispatch stub.
+ *
+ * Each path is timed by calling a function with a trivial implementation
+ * many times in a loop:
+ *
+ *   static             A static stub in libOpenGL.
+ *   generated          A stub from __glDispatchGetProcAddress.
+ *   noop               A static stub in libOpenGL, with no current context.
+ *   patched_static     The static stub, after the vendor patched it.
+ *   patched_generated  The generated stub, after the vendor patched it.
+ *
+ * Every path is timed once while libGLdispatch is still in single-threaded
+ * mode, and again after a second thread forces it into multi-threaded mode.
+ * Whether the stubs use TLS or TSD is fixed at build time, so that's reported
+ * along with each result.
+ *
+ * The output has one line for each result, with comma-separated fields: the
+ * path, "single" or "multi", "tls" or "tsd", and the best time per call in
+ * nanoseconds. Lines starting with '#' are comments. Paths that aren't
+ * available in this build are left out.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <time.h>
+#include <GL/gl.h>
+
+#include <GLdispatch.h>
+
+#include "dummy/patchentrypoints.h"
+
+#define BENCH_REPEATS 5
+static const char *GENERATED_FUNCTION_NAME = "glDummyBenchGLVND";
+
+typedef void (* pfn_glVertex3fv) (const GLfloat *v);
+
+typedef struct BenchVendorRec {
+    __GLdispatchThreadState threadState;
+    __GLdispatchTable *dispatch;
+    int vendorID;
+    const __GLdispatchPatchCallbacks *patchCallbacks;
+} BenchVendor;
+
+static void *bench_getProcAddressCallback(const char *procName, void *param);
+static void bench_glVertex3fv(const GLfloat *v);
+static GLboolean bench_InitiatePatch(int type, int stubSize,
+        DispatchPatchLookupStubOffset lookupStubOffset);
+
+static const __GLdispatchPatchCallbacks patchCallbacks = {
+    dummyCheckPatchSupported,
+    bench_InitiatePatch,
+};
+
+/*
+ * The number of calls that went through the dispatch table, and the number
+ * that went through a patched stub. These are ints because that's what the
+ * patched stubs increment.
+ */
+static int unpatchedCalls;
+static int patchedCalls;
+
+static const char *stubType =
+#if defined(GLDISPATCH_USE_TLS)
+    "tls";
+#else
+    "tsd";
+#endif
+
+static int iterations = 10000000;
+
+static double GetTimeNS(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((double) ts.tv_sec) * 1000000000.0 + ((double) ts.tv_nsec);
+}
+
+/*
+ * Calls \p func in a loop, and returns the best time per call out of
+ * BENCH_REPEATS runs.
+ */
+static double TimeCalls(pfn_glVertex3fv func)
+{
+    double best = -1.0;
+    int repeat, i;
+
+    for (repeat=0; repeat<BENCH_REPEATS; repeat++) {
+        double start = GetTimeNS();
+        double elapsed;
+        for (i=0; i<iterations; i++) {
+            func(NULL);
+        }
+        elapsed = (GetTimeNS() - start) / iterations;
+        if (best < 0.0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+    return best;
+}
+
+static void PrintResult(const char *path, const char *threads, double ns)
+{
+    printf("%s,%s,%s,%.3f\n", path, threads, stubType, ns);
+    fflush(stdout);
+}
+
+static GLboolean MakeCurrent(BenchVendor *vendor)
+{
+    if (!__glDispatchMakeCurrent(&vendor->threadState, vendor->dispatch,
+                vendor->vendorID, vendor->patchCallbacks)) {
+        fprintf(stderr, "__glDispatchMakeCurrent failed\n");
+        return GL_FALSE;
+    }
+    return GL_TRUE;
+}
+
+/*
+ * Times a function, and checks that the calls ended up where they should
+ * have. Returns GL_FALSE if they went somewhere else.
+ */
+static GLboolean RunPath(const char *path, const char *threads,
+        pfn_glVertex3fv func, int *expectCounter)
+{
+    int unpatched = unpatchedCalls;
+    int patched = patchedCalls;
+    int expected = (expectCounter != NULL ? *expectCounter : 0);
+    double ns = TimeCalls(func);
+
+    if (expectCounter == NULL) {
+        if (unpatchedCalls != unpatched || patchedCalls != patched) {
+            fprintf(stderr, "The %s path called a vendor function\n", path);
+            return GL_FALSE;
+        }
+    } else if (*expectCounter == expected) {
+        fprintf(stderr, "The %s path didn't reach the vendor\n", path);
+        return GL_FALSE;
+    }
+
+    PrintResult(path, threads, ns);
+    return GL_TRUE;
+}
+
+static GLboolean RunAllPaths(BenchVendor *plain, BenchVendor *patching,
+        pfn_glVertex3fv generatedFunc, const char *threads)
+{
+    int patched;
+
+    // Making the plain vendor current also restores the default stubs, since
+    // libGLdispatch leaves them patched after losing current.
+    if (!MakeCurrent(plain)) {
+        return GL_FALSE;
+    }
+    if (!RunPath("static", threads, glVertex3fv, &unpatchedCalls)) {
+        return GL_FALSE;
+    }
+    if (generatedFunc != NULL
+            && !RunPath("generated", threads, generatedFunc, &unpatchedCalls)) {
+        return GL_FALSE;
+    }
+    __glDispatchLoseCurrent();
+
+    if (!RunPath("noop", threads, glVertex3fv, NULL)) {
+        return GL_FALSE;
+    }
+
+    if (!MakeCurrent(patching)) {
+        return GL_FALSE;
+    }
+    // Patching isn't supported on every architecture, so make one call
+    // first to see if it worked.
+    patched = patchedCalls;
+    glVertex3fv(NULL);
+    if (patchedCalls != patched) {
+        if (!RunPath("patched_static", threads, glVertex3fv, &patchedCalls)) {
+            return GL_FALSE;
+        }
+        if (generatedFunc != NULL && !RunPath("patched_generated", threads,
+                    generatedFunc, &patchedCalls)) {
+            return GL_FALSE;
+        }
+    }
+    __glDispatchLoseCurrent();
+
+    return GL_TRUE;
+}
+
+static void *ForceMultiThreadedProc(void *param)
+{
+    __glDispatchCheckMultithreaded();
+    return NULL;
+}
+
+static GLboolean InitVendor(BenchVendor *vendor,
+        const __GLdispatchPatchCallbacks *callbacks)
+{
+    memset(vendor, 0, sizeof(*vendor));
+    vendor->vendorID = __glDispatchNewVendorID();
+    vendor->dispatch = __glDispatchCreateTable(bench_getProcAddressCallback, NULL);
+    vendor->patchCallbacks = callbacks;
+    if (vendor->dispatch == NULL) {
+        fprintf(stderr, "__glDispatchCreateTable failed\n");
+        return GL_FALSE;
+    }
+    return GL_TRUE;
+}
+
+int main(int argc, char **argv)
+{
+    BenchVendor plain, patching;
+    pfn_glVertex3fv generatedFunc = NULL;
+    pthread_t thr;
+    int ret = 1;
+
+    while (1) {
+        int opt = getopt(argc, argv, "n:");
+        if (opt == -1) {
+            break;
+        }
+        switch (opt) {
+        case 'n':
+            iterations = atoi(optarg);
+            break;
+        default:
+            return 1;
+        }
+    }
+    if (iterations <= 0) {
+        fprintf(stderr, "Invalid iteration count\n");
+        return 1;
+    }
+
+    __glDispatchInit();
+    if (!InitVendor(&plain, NULL) || !InitVendor(&patching, &patchCallbacks)) {
+        return 1;
+    }
+
+#if defined(USE_DISPATCH_ASM)
+    // Without the assembly stubs, this would get a stub that can't be
+    // dispatched through, and __glDispatchGetProcAddress could return NULL
+    // anyway if there aren't any dynamic stubs.
+    generatedFunc = (pfn_glVertex3fv) __glDispatchGetProcAddress(GENERATED_FUNCTION_NAME);
+#endif
+
+    printf("# path,threads,stubs,ns_per_call (%d calls, best of %d)\n",
+            iterations, BENCH_REPEATS);
+
+    if (!RunAllPaths(&plain, &patching, generatedFunc, "single")) {
+        goto done;
+    }
+
+    __glDispatchCheckMultithreaded();
+    pthread_create(&thr, NULL, ForceMultiThreadedProc, NULL);
+    pthread_join(thr, NULL);
+
+    if (!RunAllPaths(&plain, &patching, generatedFunc, "multi")) {
+        goto done;
+    }
+    ret = 0;
+
+done:
+    __glDispatchDestroyTable(plain.dispatch);
+    __glDispatchDestroyTable(patching.dispatch);
+    __glDispatchFini();
+    return ret;
+}
+
+static void *bench_getProcAddressCallback(const char *procName, void *param)
+{
+    if (strcmp(procName, "glVertex3fv") == 0
+            || strcmp(procName, GENERATED_FUNCTION_NAME) == 0) {
+        return bench_glVertex3fv;
+    }
+    return NULL;
+}
+
+static void bench_glVertex3fv(const GLfloat *v)
+{
+    unpatchedCalls++;
+}
+
+static GLboolean bench_InitiatePatch(int type, int stubSize,
+        DispatchPatchLookupStubOffset lookupStubOffset)
+{
+    if (!dummyPatchFunction(type, stubSize, lookupStubOffset, "Vertex3fv",
+                &patchedCalls)) {
+        return GL_FALSE;
+    }
+    // The generated stub is only in libGLdispatch, so it's fine if
+    // libOpenGL's entrypoints don't have it.
+    dummyPatchFunction(type, stubSize, lookupStubOffset, GENERATED_FUNCTION_NAME,
+            &patchedCalls);
+    return GL_TRUE;
+}
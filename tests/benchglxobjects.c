@@ -0,0 +1,356 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+/*
+ * Measures how libGLX's context, drawable, and GLXFBConfig mappings scale
+ * with the number of objects, as in a long-lived compositor.
+ *
+ * This needs an X server. It prints a comment and exits without an error if
+ * it can't open a display.
+ *
+ * For each kind of object, this creates -n of them through the dummy vendor,
+ * timing the whole batch and, with glibc, counting how much memory the
+ * process allocated. Then 1, 2, 4, and so on up to -t threads each call a
+ * GLX function -i times on random objects, which makes libGLX look up the
+ * vendor for each one:
+ *
+ *   context   glXQueryContext, which uses __glXVendorFromContext.
+ *   drawable  glXQueryDrawable on a pbuffer, which uses
+ *             __glXVendorFromDrawable. If the server doesn't support
+ *             GLX_EXT_libglvnd, libGLX doesn't record drawables at all, and
+ *             uses screen 0's vendor instead.
+ *   fbconfig  glXGetFBConfigAttrib, which uses __glXVendorFromFBConfig. The
+ *             configs come from glXGetFBConfigs, with
+ *             GLVND_TEST_FBCONFIGS_PER_SCREEN set to -n.
+ *
+ * The output has one line for each result, with comma-separated fields: the
+ * kind of object, the number of objects, the average nanoseconds to create
+ * each one, the bytes allocated per object or -1 if that isn't available, the
+ * number of threads, the total calls per second, and the 50th and 99th
+ * percentile and maximum nanoseconds for a single call. Lines starting with
+ * '#' are comments.
+ */
+
+#include <X11/Xlib.h>
+#include <GL/glx.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <getopt.h>
+#include <malloc.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "dummy/GLX_dummy.h"
+
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+#define HAVE_MALLINFO2 1
+#endif
+
+enum {
+    KIND_CONTEXT,
+    KIND_DRAWABLE,
+    KIND_FBCONFIG,
+    KIND_COUNT
+};
+
+static const char *KIND_NAMES[KIND_COUNT] = { "context", "drawable", "fbconfig" };
+
+typedef struct BenchThreadRec {
+    pthread_t thread;
+    int kind;
+    unsigned int seed;
+    uint64_t *latencies;
+} BenchThread;
+
+static Display *dpy;
+static GLXFBConfig baseConfig;
+static int objectCount = 20000;
+static int iterations = 100000;
+static GLXContext *contexts;
+static GLXPbuffer *drawables;
+static GLXFBConfig *configs;
+static pthread_barrier_t startBarrier;
+
+static uint64_t GetTimeNS(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t) ts.tv_sec) * 1000000000 + ((uint64_t) ts.tv_nsec);
+}
+
+static int CompareLatencies(const void *a, const void *b)
+{
+    uint64_t va = *((const uint64_t *) a);
+    uint64_t vb = *((const uint64_t *) b);
+    return (va < vb ? -1 : (va > vb ? 1 : 0));
+}
+
+static long GetAllocatedBytes(void)
+{
+#if defined(HAVE_MALLINFO2)
+    struct mallinfo2 info = mallinfo2();
+    return (long) (info.uordblks + info.hblkhd);
+#else
+    return -1;
+#endif
+}
+
+/*
+ * Creates every object of one kind, and returns the number of nanoseconds
+ * that it took, or zero on failure.
+ */
+static uint64_t CreateObjects(int kind)
+{
+    static const int pbufferAttribs[] = {
+        GLX_PBUFFER_WIDTH, 1,
+        GLX_PBUFFER_HEIGHT, 1,
+        None
+    };
+    uint64_t start = GetTimeNS();
+    int i;
+
+    if (kind == KIND_CONTEXT) {
+        for (i=0; i<objectCount; i++) {
+            contexts[i] = glXCreateNewContext(dpy, baseConfig, GLX_RGBA_TYPE,
+                    NULL, True);
+            if (contexts[i] == NULL) {
+                printf("glXCreateNewContext failed\n");
+                return 0;
+            }
+        }
+    } else if (kind == KIND_DRAWABLE) {
+        for (i=0; i<objectCount; i++) {
+            drawables[i] = glXCreatePbuffer(dpy, baseConfig, pbufferAttribs);
+            if (drawables[i] == None) {
+                printf("glXCreatePbuffer failed\n");
+                return 0;
+            }
+        }
+    } else {
+        GLXFBConfig *list;
+        int count = 0;
+
+        list = glXGetFBConfigs(dpy, DefaultScreen(dpy), &count);
+        if (list == NULL || count < objectCount) {
+            printf("glXGetFBConfigs returned %d configs, expected %d\n",
+                    count, objectCount);
+            return 0;
+        }
+        memcpy(configs, list, objectCount * sizeof(GLXFBConfig));
+        XFree(list);
+    }
+    return GetTimeNS() - start;
+}
+
+static void DestroyObjects(void)
+{
+    int i;
+    for (i=0; i<objectCount; i++) {
+        if (contexts[i] != NULL) {
+            glXDestroyContext(dpy, contexts[i]);
+        }
+        if (drawables[i] != None) {
+            glXDestroyPbuffer(dpy, drawables[i]);
+        }
+    }
+}
+
+static void *BenchThreadProc(void *param)
+{
+    BenchThread *bt = (BenchThread *) param;
+    int i;
+
+    pthread_barrier_wait(&startBarrier);
+
+    for (i=0; i<iterations; i++) {
+        int index = rand_r(&bt->seed) % objectCount;
+        uint64_t start = GetTimeNS();
+        int ivalue;
+        unsigned int uvalue;
+
+        if (bt->kind == KIND_CONTEXT) {
+            glXQueryContext(dpy, contexts[index], GLX_CONTEX_ATTRIB_DUMMY, &ivalue);
+        } else if (bt->kind == KIND_DRAWABLE) {
+            glXQueryDrawable(dpy, drawables[index], GLX_WIDTH, &uvalue);
+        } else {
+            glXGetFBConfigAttrib(dpy, configs[index], GLX_RED_SIZE, &ivalue);
+        }
+        bt->latencies[i] = GetTimeNS() - start;
+    }
+
+    pthread_barrier_wait(&startBarrier);
+    return NULL;
+}
+
+static int RunLookups(int kind, int numThreads, uint64_t createTime,
+        long allocated)
+{
+    BenchThread *threads;
+    uint64_t *all;
+    uint64_t start, elapsed;
+    size_t total = ((size_t) numThreads) * iterations;
+    int i;
+
+    threads = calloc(numThreads, sizeof(BenchThread));
+    all = malloc(total * sizeof(uint64_t));
+    if (threads == NULL || all == NULL) {
+        printf("Out of memory\n");
+        free(threads);
+        free(all);
+        return 0;
+    }
+
+    for (i=0; i<numThreads; i++) {
+        threads[i].kind = kind;
+        threads[i].seed = i + 1;
+        threads[i].latencies = all + ((size_t) i) * iterations;
+    }
+
+    pthread_barrier_init(&startBarrier, NULL, numThreads + 1);
+    for (i=0; i<numThreads; i++) {
+        pthread_create(&threads[i].thread, NULL, BenchThreadProc, &threads[i]);
+    }
+    pthread_barrier_wait(&startBarrier);
+    start = GetTimeNS();
+    pthread_barrier_wait(&startBarrier);
+    elapsed = GetTimeNS() - start;
+    for (i=0; i<numThreads; i++) {
+        pthread_join(threads[i].thread, NULL);
+    }
+    pthread_barrier_destroy(&startBarrier);
+
+    qsort(all, total, sizeof(uint64_t), CompareLatencies);
+    printf("%s,%d,%llu,%ld,%d,%.0f,%llu,%llu,%llu\n", KIND_NAMES[kind],
+            objectCount, (unsigned long long) (createTime / objectCount),
+            (allocated >= 0 ? allocated / objectCount : -1L), numThreads,
+            ((double) total) * 1000000000.0 / ((double) elapsed),
+            (unsigned long long) all[total / 2],
+            (unsigned long long) all[total * 99 / 100],
+            (unsigned long long) all[total - 1]);
+    fflush(stdout);
+
+    free(threads);
+    free(all);
+    return 1;
+}
+
+int main(int argc, char **argv)
+{
+    char countStr[32];
+    GLXFBConfig *list;
+    int maxThreads = 4;
+    int kind, numThreads, count;
+
+    while (1) {
+        int opt = getopt(argc, argv, "n:t:i:");
+        if (opt == -1) {
+            break;
+        }
+        switch (opt) {
+        case 'n':
+            objectCount = atoi(optarg);
+            break;
+        case 't':
+            maxThreads = atoi(optarg);
+            break;
+        case 'i':
+            iterations = atoi(optarg);
+            break;
+        default:
+            return 1;
+        }
+    }
+    if (objectCount <= 0 || maxThreads <= 0 || iterations <= 0) {
+        printf("Invalid object, thread, or iteration count\n");
+        return 1;
+    }
+
+    // The dummy vendor reads this when it's loaded.
+    snprintf(countStr, sizeof(countStr), "%d", objectCount);
+    setenv("GLVND_TEST_FBCONFIGS_PER_SCREEN", countStr, 1);
+
+    XInitThreads();
+    dpy = XOpenDisplay(NULL);
+    if (dpy == NULL) {
+        printf("# No X display, skipping\n");
+        return 0;
+    }
+
+    list = glXGetFBConfigs(dpy, DefaultScreen(dpy), &count);
+    if (list == NULL || count <= 0) {
+        printf("glXGetFBConfigs failed\n");
+        return 1;
+    }
+    baseConfig = list[0];
+    XFree(list);
+
+    contexts = calloc(objectCount, sizeof(GLXContext));
+    drawables = calloc(objectCount, sizeof(GLXPbuffer));
+    configs = calloc(objectCount, sizeof(GLXFBConfig));
+    if (contexts == NULL || drawables == NULL || configs == NULL) {
+        printf("Out of memory\n");
+        return 1;
+    }
+
+    printf("# kind,objects,create_ns,bytes_per_object,threads,calls_per_sec,p50_ns,p99_ns,max_ns (%d calls per thread)\n",
+            iterations);
+    for (kind=0; kind<KIND_COUNT; kind++) {
+        long before = GetAllocatedBytes();
+        uint64_t createTime = CreateObjects(kind);
+        long allocated = -1;
+
+        if (createTime == 0) {
+            return 1;
+        }
+        if (before >= 0) {
+            allocated = GetAllocatedBytes() - before;
+        }
+
+        for (numThreads=1; ; numThreads *= 2) {
+            if (numThreads > maxThreads) {
+                numThreads = maxThreads;
+            }
+            if (!RunLookups(kind, numThreads, createTime, allocated)) {
+                return 1;
+            }
+            if (numThreads == maxThreads) {
+                break;
+            }
+        }
+    }
+
+    DestroyObjects();
+    free(contexts);
+    free(drawables);
+    free(configs);
+    XCloseDisplay(dpy);
+    return 0;
+}
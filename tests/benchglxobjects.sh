@@ -0,0 +1,8 @@
+#!/bin/sh
+
+# Runs benchglxobjects with the GLX dummy vendor. It's skipped if there's no
+# X display. The arguments are passed through.
+
+. $TOP_SRCDIR/tests/glxenv.sh
+
+./benchglxobjects "$@"
@@ -0,0 +1,28 @@
+#!/bin/sh
+
+# Reports how long the dynamic loader takes to start a program that imports
+# a set of OpenGL functions from libOpenGL.so, with lazy and immediate
+# binding.
+#
+# LD_DEBUG=statistics is specific to glibc. Anywhere else, this just won't
+# print anything.
+
+for bind in lazy now ; do
+    times=""
+    i=0
+    while [ $i -lt 20 ] ; do
+        if [ $bind = now ] ; then
+            t=$(LD_BIND_NOW=1 LD_DEBUG=statistics ./testldstartup 2>&1 | \
+                sed -n 's/.*total startup time in dynamic loader: *\([0-9]*\).*/\1/p')
+        else
+            t=$(LD_DEBUG=statistics ./testldstartup 2>&1 | \
+                sed -n 's/.*total startup time in dynamic loader: *\([0-9]*\).*/\1/p')
+        fi
+        times="$times $t"
+        i=$((i + 1))
+    done
+    best=$(for t in $times ; do echo $t ; done | sort -n | head -n 1)
+    if [ -n "$best" ] ; then
+        echo "Dynamic loader startup with $bind binding: $best cycles (best of 20)"
+    fi
+done
@@ -0,0 +1,294 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+/*
+ * Measures eglMakeCurrent throughput and latency as the number of threads
+ * goes up.
+ *
+ * Each thread has its own contexts, and calls eglMakeCurrent in a loop,
+ * switching between two of them:
+ *
+ *   same       Two contexts from the same vendor.
+ *   different  Contexts from two different vendors.
+ *   none       One context and EGL_NO_CONTEXT.
+ *
+ * Each mode runs with 1, 2, 4, and so on up to the -t thread count. Every
+ * eglMakeCurrent call is timed on its own, so the latency percentiles are
+ * across every call from every thread.
+ *
+ * The output has one line for each result, with comma-separated fields: the
+ * mode, the number of threads, the total calls per second, and the 50th, 90th
+ * and 99th percentile and maximum latency in nanoseconds. Lines starting with
+ * '#' are comments.
+ */
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "dummy/EGL_dummy.h"
+#include "egl_test_utils.h"
+
+enum {
+    MODE_SAME,
+    MODE_DIFFERENT,
+    MODE_NONE,
+    MODE_COUNT
+};
+
+static const char *MODE_NAMES[MODE_COUNT] = { "same", "different", "none" };
+
+typedef struct BenchThreadRec {
+    pthread_t thread;
+    EGLContext contexts[2];
+    EGLDisplay displays[2];
+    uint64_t *latencies;
+    EGLBoolean success;
+} BenchThread;
+
+static EGLDisplay vendorDisplays[DUMMY_VENDOR_COUNT];
+static int iterations = 100000;
+static pthread_barrier_t startBarrier;
+
+static uint64_t GetTimeNS(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t) ts.tv_sec) * 1000000000 + ((uint64_t) ts.tv_nsec);
+}
+
+static int CompareLatencies(const void *a, const void *b)
+{
+    uint64_t va = *((const uint64_t *) a);
+    uint64_t vb = *((const uint64_t *) b);
+    return (va < vb ? -1 : (va > vb ? 1 : 0));
+}
+
+static void *BenchThreadProc(void *param)
+{
+    BenchThread *bt = (BenchThread *) param;
+    int i;
+
+    pthread_barrier_wait(&startBarrier);
+
+    for (i=0; i<iterations; i++) {
+        int which = (i & 1);
+        EGLDisplay dpy = bt->displays[which];
+        EGLContext ctx = bt->contexts[which];
+        uint64_t start = GetTimeNS();
+
+        if (ctx != EGL_NO_CONTEXT) {
+            bt->success = eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, ctx);
+        } else {
+            bt->success = eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE,
+                    EGL_NO_CONTEXT);
+        }
+        bt->latencies[i] = GetTimeNS() - start;
+        if (!bt->success) {
+            printf("eglMakeCurrent failed on iteration %d\n", i);
+            break;
+        }
+    }
+
+    eglMakeCurrent(bt->displays[0], EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    pthread_barrier_wait(&startBarrier);
+    return NULL;
+}
+
+static EGLBoolean InitThread(BenchThread *bt, int mode)
+{
+    int vendors[2] = { 0, 0 };
+    int i;
+
+    if (mode == MODE_DIFFERENT) {
+        vendors[1] = 1;
+    }
+
+    memset(bt, 0, sizeof(*bt));
+    for (i=0; i<2; i++) {
+        bt->displays[i] = vendorDisplays[vendors[i]];
+        if (mode == MODE_NONE && i == 1) {
+            bt->contexts[i] = EGL_NO_CONTEXT;
+            continue;
+        }
+        bt->contexts[i] = eglCreateContext(bt->displays[i], NULL, EGL_NO_CONTEXT, NULL);
+        if (bt->contexts[i] == EGL_NO_CONTEXT) {
+            printf("eglCreateContext failed\n");
+            return EGL_FALSE;
+        }
+    }
+
+    bt->latencies = malloc(iterations * sizeof(uint64_t));
+    if (bt->latencies == NULL) {
+        printf("Can't allocate latency array\n");
+        return EGL_FALSE;
+    }
+    return EGL_TRUE;
+}
+
+static void CleanupThread(BenchThread *bt)
+{
+    int i;
+    for (i=0; i<2; i++) {
+        if (bt->contexts[i] != EGL_NO_CONTEXT) {
+            eglDestroyContext(bt->displays[i], bt->contexts[i]);
+        }
+    }
+    free(bt->latencies);
+}
+
+static EGLBoolean RunMode(int mode, int numThreads)
+{
+    BenchThread *threads;
+    uint64_t *all;
+    uint64_t start, elapsed;
+    size_t total = ((size_t) numThreads) * iterations;
+    EGLBoolean success = EGL_TRUE;
+    int i;
+
+    threads = calloc(numThreads, sizeof(BenchThread));
+    all = malloc(total * sizeof(uint64_t));
+    if (threads == NULL || all == NULL) {
+        printf("Out of memory\n");
+        free(threads);
+        free(all);
+        return EGL_FALSE;
+    }
+
+    for (i=0; i<numThreads; i++) {
+        if (!InitThread(&threads[i], mode)) {
+            numThreads = i;
+            success = EGL_FALSE;
+            break;
+        }
+    }
+
+    if (success) {
+        // The main thread waits on the same barrier, so that the time only
+        // covers the eglMakeCurrent loops and not creating the threads.
+        pthread_barrier_init(&startBarrier, NULL, numThreads + 1);
+        for (i=0; i<numThreads; i++) {
+            pthread_create(&threads[i].thread, NULL, BenchThreadProc, &threads[i]);
+        }
+        pthread_barrier_wait(&startBarrier);
+        start = GetTimeNS();
+        pthread_barrier_wait(&startBarrier);
+        elapsed = GetTimeNS() - start;
+        for (i=0; i<numThreads; i++) {
+            pthread_join(threads[i].thread, NULL);
+            if (!threads[i].success) {
+                success = EGL_FALSE;
+            }
+        }
+        pthread_barrier_destroy(&startBarrier);
+    }
+
+    if (success) {
+        for (i=0; i<numThreads; i++) {
+            memcpy(all + ((size_t) i) * iterations, threads[i].latencies,
+                    iterations * sizeof(uint64_t));
+        }
+        qsort(all, total, sizeof(uint64_t), CompareLatencies);
+
+        printf("%s,%d,%.0f,%llu,%llu,%llu,%llu\n", MODE_NAMES[mode], numThreads,
+                ((double) total) * 1000000000.0 / ((double) elapsed),
+                (unsigned long long) all[total / 2],
+                (unsigned long long) all[total * 9 / 10],
+                (unsigned long long) all[total * 99 / 100],
+                (unsigned long long) all[total - 1]);
+        fflush(stdout);
+    }
+
+    for (i=0; i<numThreads; i++) {
+        CleanupThread(&threads[i]);
+    }
+    free(threads);
+    free(all);
+    return success;
+}
+
+int main(int argc, char **argv)
+{
+    int maxThreads = 4;
+    int mode, numThreads, i;
+
+    while (1) {
+        int opt = getopt(argc, argv, "n:t:");
+        if (opt == -1) {
+            break;
+        }
+        switch (opt) {
+        case 'n':
+            iterations = atoi(optarg);
+            break;
+        case 't':
+            maxThreads = atoi(optarg);
+            break;
+        default:
+            return 1;
+        }
+    }
+    if (iterations <= 0 || maxThreads <= 0) {
+        printf("Invalid iteration or thread count\n");
+        return 1;
+    }
+
+    for (i=0; i<DUMMY_VENDOR_COUNT; i++) {
+        vendorDisplays[i] = eglGetPlatformDisplay(EGL_DUMMY_PLATFORM,
+                (void *) DUMMY_VENDOR_NAMES[i], NULL);
+        if (vendorDisplays[i] == EGL_NO_DISPLAY) {
+            printf("eglGetPlatformDisplay failed\n");
+            return 1;
+        }
+    }
+
+    printf("# mode,threads,calls_per_sec,p50_ns,p90_ns,p99_ns,max_ns (%d calls per thread)\n",
+            iterations);
+    for (mode=0; mode<MODE_COUNT; mode++) {
+        for (numThreads=1; ; numThreads *= 2) {
+            if (numThreads > maxThreads) {
+                numThreads = maxThreads;
+            }
+            if (!RunMode(mode, numThreads)) {
+                return 1;
+            }
+            if (numThreads == maxThreads) {
+                break;
+            }
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,358 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+/*
+ * Measures how long a forked child takes to get back to a working context,
+ * as in a prefork server that sets up GL once and then forks its workers.
+ *
+ * The parent makes an EGL context current, along with a GLX context if it can
+ * open an X display, and looks up -p made-up GL functions through
+ * eglGetProcAddress so that there's a populated set of dispatch stubs. Then
+ * it forks -n children, one at a time. Each child times these steps:
+ *
+ *   start        From the fork call in the parent until the child runs.
+ *   egl_current  The first eglMakeCurrent, which is where libEGL,
+ *                libGLdispatch, and the vendor notice the fork and reset.
+ *   egl_gl       The first GL call after that.
+ *   glx_current  The first glXMakeCurrent, using the inherited X connection.
+ *   glx_gl       The first GL call through the GLX context.
+ *   procaddress  Looking up all of the -p functions again.
+ *
+ * The output has one line for each step, with comma-separated fields: the
+ * step, the number of children, and the average, 50th, 90th and 99th
+ * percentile and maximum nanoseconds. Lines starting with '#' are comments.
+ */
+
+#include <X11/Xlib.h>
+#include <GL/glx.h>
+#include <GL/gl.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <getopt.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "dummy/EGL_dummy.h"
+#include "egl_test_utils.h"
+#include "test_utils.h"
+
+enum {
+    STEP_START,
+    STEP_EGL_CURRENT,
+    STEP_EGL_GL,
+    STEP_GLX_CURRENT,
+    STEP_GLX_GL,
+    STEP_PROCADDRESS,
+    STEP_COUNT
+};
+
+static const char *STEP_NAMES[STEP_COUNT] = {
+    "start", "egl_current", "egl_gl", "glx_current", "glx_gl", "procaddress"
+};
+
+static EGLDisplay eglDpy = EGL_NO_DISPLAY;
+static EGLContext eglCtx = EGL_NO_CONTEXT;
+static Display *xDpy = NULL;
+static GLXContext glxCtx = NULL;
+static struct window_info windowInfo;
+
+static char **procNames;
+static int procCount = 2000;
+
+static uint64_t GetTimeNS(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t) ts.tv_sec) * 1000000000 + ((uint64_t) ts.tv_nsec);
+}
+
+static int CompareLatencies(const void *a, const void *b)
+{
+    uint64_t va = *((const uint64_t *) a);
+    uint64_t vb = *((const uint64_t *) b);
+    return (va < vb ? -1 : (va > vb ? 1 : 0));
+}
+
+static int InitParent(void)
+{
+    int i;
+
+    eglDpy = eglGetPlatformDisplay(EGL_DUMMY_PLATFORM,
+            (void *) DUMMY_VENDOR_NAMES[0], NULL);
+    if (eglDpy == EGL_NO_DISPLAY) {
+        printf("eglGetPlatformDisplay failed\n");
+        return 0;
+    }
+    eglCtx = eglCreateContext(eglDpy, NULL, EGL_NO_CONTEXT, NULL);
+    if (eglCtx == EGL_NO_CONTEXT) {
+        printf("eglCreateContext failed\n");
+        return 0;
+    }
+
+    xDpy = XOpenDisplay(NULL);
+    if (xDpy != NULL) {
+        if (!testUtilsCreateWindow(xDpy, &windowInfo, 0)) {
+            printf("Failed to create window\n");
+            return 0;
+        }
+        glxCtx = glXCreateContext(xDpy, windowInfo.visinfo, NULL, True);
+        if (glxCtx == NULL) {
+            printf("glXCreateContext failed\n");
+            return 0;
+        }
+        if (!glXMakeContextCurrent(xDpy, windowInfo.draw, windowInfo.draw, glxCtx)
+                || !glXMakeContextCurrent(xDpy, None, None, NULL)) {
+            printf("glXMakeContextCurrent failed\n");
+            return 0;
+        }
+    } else {
+        printf("# No X display, skipping GLX\n");
+    }
+
+    // Leave the EGL context current, like a server that set everything up
+    // before forking.
+    if (!eglMakeCurrent(eglDpy, EGL_NO_SURFACE, EGL_NO_SURFACE, eglCtx)) {
+        printf("eglMakeCurrent failed\n");
+        return 0;
+    }
+
+    procNames = malloc(procCount * sizeof(char *));
+    if (procNames == NULL) {
+        printf("Out of memory\n");
+        return 0;
+    }
+    for (i=0; i<procCount; i++) {
+        char name[64];
+        snprintf(name, sizeof(name), "glBenchPreforkGLVND_%d", i);
+        procNames[i] = strdup(name);
+        if (procNames[i] == NULL) {
+            printf("Out of memory\n");
+            return 0;
+        }
+        eglGetProcAddress(procNames[i]);
+    }
+    return 1;
+}
+
+/*
+ * Runs in the child, and fills in the time for each step.
+ */
+static int RunChild(uint64_t forkTime, uint64_t *steps)
+{
+    static const GLfloat v[] = { 0, 0, 0 };
+    uint64_t t0, t1;
+    int i;
+
+    t0 = GetTimeNS();
+    steps[STEP_START] = t0 - forkTime;
+
+    if (!eglMakeCurrent(eglDpy, EGL_NO_SURFACE, EGL_NO_SURFACE, eglCtx)) {
+        return 0;
+    }
+    t1 = GetTimeNS();
+    steps[STEP_EGL_CURRENT] = t1 - t0;
+
+    if (glGetString(GL_VENDOR) == NULL) {
+        return 0;
+    }
+    t0 = GetTimeNS();
+    steps[STEP_EGL_GL] = t0 - t1;
+
+    if (glxCtx != NULL) {
+        eglMakeCurrent(eglDpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+
+        t0 = GetTimeNS();
+        if (!glXMakeContextCurrent(xDpy, windowInfo.draw, windowInfo.draw, glxCtx)) {
+            return 0;
+        }
+        t1 = GetTimeNS();
+        steps[STEP_GLX_CURRENT] = t1 - t0;
+
+        glBegin(GL_TRIANGLES);
+        glVertex3fv(v);
+        glEnd();
+        t0 = GetTimeNS();
+        steps[STEP_GLX_GL] = t0 - t1;
+    }
+
+    t0 = GetTimeNS();
+    for (i=0; i<procCount; i++) {
+        if (eglGetProcAddress(procNames[i]) == NULL) {
+            return 0;
+        }
+    }
+    steps[STEP_PROCADDRESS] = GetTimeNS() - t0;
+
+    return 1;
+}
+
+/*
+ * Forks a child, and reads back its step times through a pipe.
+ */
+static int ForkChild(uint64_t *steps)
+{
+    int fds[2];
+    pid_t pid;
+    int status;
+    uint64_t forkTime;
+    ssize_t len;
+
+    if (pipe(fds) != 0) {
+        printf("pipe failed\n");
+        return 0;
+    }
+
+    forkTime = GetTimeNS();
+    pid = fork();
+    if (pid < 0) {
+        printf("fork failed\n");
+        return 0;
+    }
+    if (pid == 0) {
+        uint64_t childSteps[STEP_COUNT];
+        int ok;
+
+        close(fds[0]);
+        memset(childSteps, 0, sizeof(childSteps));
+        ok = RunChild(forkTime, childSteps);
+        if (ok) {
+            ok = (write(fds[1], childSteps, sizeof(childSteps)) == sizeof(childSteps));
+        }
+        _exit(ok ? 0 : 1);
+    }
+
+    close(fds[1]);
+    len = read(fds[0], steps, STEP_COUNT * sizeof(uint64_t));
+    close(fds[0]);
+    if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status)
+            || WEXITSTATUS(status) != 0 || len != STEP_COUNT * sizeof(uint64_t)) {
+        printf("Child process failed\n");
+        return 0;
+    }
+    return 1;
+}
+
+static void PrintStep(int step, uint64_t *times, int count)
+{
+    uint64_t sum = 0;
+    int i;
+
+    for (i=0; i<count; i++) {
+        sum += times[i];
+    }
+    qsort(times, count, sizeof(uint64_t), CompareLatencies);
+
+    printf("%s,%d,%llu,%llu,%llu,%llu,%llu\n", STEP_NAMES[step], count,
+            (unsigned long long) (sum / count),
+            (unsigned long long) times[count / 2],
+            (unsigned long long) times[count * 9 / 10],
+            (unsigned long long) times[count * 99 / 100],
+            (unsigned long long) times[count - 1]);
+}
+
+int main(int argc, char **argv)
+{
+    uint64_t *stepTimes[STEP_COUNT];
+    int numChildren = 200;
+    int i, step;
+
+    while (1) {
+        int opt = getopt(argc, argv, "n:p:");
+        if (opt == -1) {
+            break;
+        }
+        switch (opt) {
+        case 'n':
+            numChildren = atoi(optarg);
+            break;
+        case 'p':
+            procCount = atoi(optarg);
+            break;
+        default:
+            return 1;
+        }
+    }
+    if (numChildren <= 0 || procCount < 0) {
+        printf("Invalid child or function count\n");
+        return 1;
+    }
+
+    if (!InitParent()) {
+        return 1;
+    }
+
+    for (step=0; step<STEP_COUNT; step++) {
+        stepTimes[step] = malloc(numChildren * sizeof(uint64_t));
+        if (stepTimes[step] == NULL) {
+            printf("Out of memory\n");
+            return 1;
+        }
+    }
+
+    for (i=0; i<numChildren; i++) {
+        uint64_t steps[STEP_COUNT];
+        if (!ForkChild(steps)) {
+            return 1;
+        }
+        for (step=0; step<STEP_COUNT; step++) {
+            stepTimes[step][i] = steps[step];
+        }
+    }
+
+    printf("# step,children,avg_ns,p50_ns,p90_ns,p99_ns,max_ns (%d functions)\n",
+            procCount);
+    for (step=0; step<STEP_COUNT; step++) {
+        if ((step == STEP_GLX_CURRENT || step == STEP_GLX_GL) && glxCtx == NULL) {
+            continue;
+        }
+        PrintStep(step, stepTimes[step], numChildren);
+    }
+
+    for (step=0; step<STEP_COUNT; step++) {
+        free(stepTimes[step]);
+    }
+    for (i=0; i<procCount; i++) {
+        free(procNames[i]);
+    }
+    free(procNames);
+
+    eglMakeCurrent(eglDpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglDestroyContext(eglDpy, eglCtx);
+    if (xDpy != NULL) {
+        glXDestroyContext(xDpy, glxCtx);
+        testUtilsDestroyWindow(xDpy, &windowInfo);
+        XCloseDisplay(xDpy);
+    }
+    return 0;
+}
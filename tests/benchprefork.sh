@@ -0,0 +1,9 @@
+#!/bin/sh
+
+# Runs benchprefork with the EGL and GLX dummy vendors. The GLX steps are
+# skipped if there's no X display. The arguments are passed through.
+
+. $TOP_SRCDIR/tests/eglenv.sh
+. $TOP_SRCDIR/tests/glxenv.sh
+
+./benchprefork "$@"
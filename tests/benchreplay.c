@@ -0,0 +1,458 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+/*
+ * Measures the per-call dispatch overhead of libOpenGL or libGLESv2 by
+ * replaying a log of OpenGL calls through their entrypoints.
+ *
+ * The current context comes from the EGL dummy vendor, using the
+ * DUMMY_VARIANT_COUNT_CALLS dispatch table, so every call goes to a stub
+ * that only counts it. That way, the time is almost all libglvnd's.
+ *
+ * The call log is a text file with one call per line. Each line has a
+ * function name, optionally followed by a repeat count:
+ *
+ *   glBindBuffer 2
+ *   glDrawElements
+ *
+ * The output of "apitrace dump" works too: a leading call number is skipped,
+ * and so is everything after the '(' that starts the argument list. Lines
+ * that don't start with an OpenGL function name, including GLX and EGL calls,
+ * are ignored. The arguments are never passed to the function; the counting
+ * stub doesn't look at them.
+ *
+ * Each function is looked up in the library from -l ("opengl" or "glesv2").
+ * Functions that the library doesn't export go through eglGetProcAddress
+ * instead, just like an application would call them.
+ *
+ * The whole log is replayed -n times. For comparison, the same loop also
+ * runs with every call going straight to a local function, which gives the
+ * cost of the loop and the indirect call by themselves.
+ *
+ * The output has one line with comma-separated fields: the library, the
+ * number of calls in the log, the number of distinct functions and how many
+ * of them came from eglGetProcAddress, the nanoseconds per call through
+ * libglvnd and through the local function, the difference between them, and
+ * the iTLB and L1 icache misses per 1000 calls through libglvnd. The cache
+ * misses are "n/a" if the performance counters aren't available.
+ */
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <ctype.h>
+#include <dlfcn.h>
+#include <getopt.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+#include "dummy/EGL_dummy.h"
+#include "egl_test_utils.h"
+
+typedef void (* ReplayFunc) (void);
+
+enum {
+    LIB_OPENGL,
+    LIB_GLESV2,
+    LIB_COUNT
+};
+
+static const char *LIB_NAMES[LIB_COUNT] = { "opengl", "glesv2" };
+static const char *LIB_SONAMES[LIB_COUNT] = { "libOpenGL.so.0", "libGLESv2.so.2" };
+static const EGLenum LIB_APIS[LIB_COUNT] = { EGL_OPENGL_API, EGL_OPENGL_ES_API };
+
+enum {
+    COUNTER_ITLB,
+    COUNTER_L1I,
+    COUNTER_COUNT
+};
+
+typedef struct ReplayNameRec {
+    char *name;
+    ReplayFunc func;
+} ReplayName;
+
+static void *libHandle;
+static ReplayName *replayNames;
+static int replayNameCount;
+static int replayNameCapacity;
+static int procAddressCount;
+static ReplayFunc *calls;
+static size_t callCount;
+static volatile unsigned long localCallCount;
+
+static void LocalCountCall(void)
+{
+    localCallCount++;
+}
+
+static uint64_t GetTimeNS(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t) ts.tv_sec) * 1000000000 + ((uint64_t) ts.tv_nsec);
+}
+
+/*!
+ * Returns the function for \p name, looking it up the first time.
+ */
+static ReplayFunc LookupReplayFunc(const char *name)
+{
+    ReplayFunc func;
+    int i;
+
+    for (i=0; i<replayNameCount; i++) {
+        if (strcmp(replayNames[i].name, name) == 0) {
+            return replayNames[i].func;
+        }
+    }
+
+    func = (ReplayFunc) dlsym(libHandle, name);
+    if (func == NULL) {
+        func = (ReplayFunc) eglGetProcAddress(name);
+        if (func == NULL) {
+            return NULL;
+        }
+        procAddressCount++;
+    }
+
+    if (replayNameCount >= replayNameCapacity) {
+        int capacity = (replayNameCapacity > 0 ? replayNameCapacity * 2 : 64);
+        ReplayName *newNames = realloc(replayNames, capacity * sizeof(ReplayName));
+        if (newNames == NULL) {
+            return NULL;
+        }
+        replayNames = newNames;
+        replayNameCapacity = capacity;
+    }
+    replayNames[replayNameCount].name = strdup(name);
+    if (replayNames[replayNameCount].name == NULL) {
+        return NULL;
+    }
+    replayNames[replayNameCount].func = func;
+    replayNameCount++;
+    return func;
+}
+
+/*!
+ * Parses one line of the call log.
+ *
+ * \param[out] count Returns the repeat count.
+ * \return The function name, or NULL if the line doesn't have one.
+ */
+static char *ParseLine(char *line, long *count)
+{
+    char *name, *end;
+
+    while (isspace((unsigned char) *line) || isdigit((unsigned char) *line)) {
+        line++;
+    }
+    if (strncmp(line, "gl", 2) != 0 || strncmp(line, "glX", 3) == 0) {
+        return NULL;
+    }
+
+    name = line;
+    end = name;
+    while (isalnum((unsigned char) *end) || *end == '_') {
+        end++;
+    }
+
+    *count = 1;
+    if (*end != '(' && *end != '\0') {
+        char *countEnd;
+        long n = strtol(end, &countEnd, 10);
+        if (countEnd != end && n > 0) {
+            *count = n;
+        }
+    }
+    *end = '\0';
+    return name;
+}
+
+static int ReadCallLog(const char *filename)
+{
+    char line[1024];
+    size_t capacity = 0;
+    FILE *in = fopen(filename, "r");
+
+    if (in == NULL) {
+        printf("Can't open %s\n", filename);
+        return 0;
+    }
+
+    while (fgets(line, sizeof(line), in) != NULL) {
+        ReplayFunc func;
+        long count;
+        char *name;
+
+        if (line[0] == '#') {
+            continue;
+        }
+        name = ParseLine(line, &count);
+        if (name == NULL) {
+            continue;
+        }
+
+        func = LookupReplayFunc(name);
+        if (func == NULL) {
+            printf("Can't look up %s\n", name);
+            fclose(in);
+            return 0;
+        }
+
+        while (count-- > 0) {
+            if (callCount >= capacity) {
+                ReplayFunc *newCalls;
+                capacity = (capacity > 0 ? capacity * 2 : 4096);
+                newCalls = realloc(calls, capacity * sizeof(ReplayFunc));
+                if (newCalls == NULL) {
+                    printf("Out of memory\n");
+                    fclose(in);
+                    return 0;
+                }
+                calls = newCalls;
+            }
+            calls[callCount++] = func;
+        }
+    }
+    fclose(in);
+
+    if (callCount == 0) {
+        printf("No OpenGL calls in %s\n", filename);
+        return 0;
+    }
+    return 1;
+}
+
+/*!
+ * Opens a user-space hardware cache counter for the calling thread.
+ *
+ * \return A file descriptor, or -1 if the counter isn't available.
+ */
+static int OpenCacheCounter(int counter)
+{
+#if defined(__linux__)
+    struct perf_event_attr attr;
+    uint64_t cache = (counter == COUNTER_ITLB ? PERF_COUNT_HW_CACHE_ITLB
+            : PERF_COUNT_HW_CACHE_L1I);
+
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.config = cache | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+        | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int) syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#else
+    return -1;
+#endif
+}
+
+static void EnableCacheCounter(int fd, int enable)
+{
+#if defined(__linux__)
+    if (fd >= 0) {
+        if (enable) {
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        } else {
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        }
+    }
+#endif
+}
+
+static void PrintCacheMisses(int fd, uint64_t totalCalls)
+{
+    uint64_t value;
+
+    if (fd >= 0 && read(fd, &value, sizeof(value)) == sizeof(value)) {
+        printf(",%.3f", ((double) value) * 1000.0 / ((double) totalCalls));
+    } else {
+        printf(",n/a");
+    }
+}
+
+static uint64_t Replay(ReplayFunc *funcs, int passes)
+{
+    uint64_t start = GetTimeNS();
+    int pass;
+    size_t i;
+
+    for (pass=0; pass<passes; pass++) {
+        for (i=0; i<callCount; i++) {
+            funcs[i]();
+        }
+    }
+    return GetTimeNS() - start;
+}
+
+int main(int argc, char **argv)
+{
+    const EGLint contextAttribs[] = {
+        EGL_CREATE_CONTEXT_DISPATCH_VARIANT, DUMMY_VARIANT_COUNT_CALLS,
+        EGL_NONE
+    };
+    int lib = LIB_OPENGL;
+    int passes = 100;
+    EGLDisplay dpy;
+    EGLContext ctx;
+    ReplayFunc *localCalls;
+    int counters[COUNTER_COUNT];
+    uint64_t elapsed, localElapsed, totalCalls, vendorCalls;
+    double nsPerCall, localNsPerCall;
+    size_t i;
+
+    while (1) {
+        int opt = getopt(argc, argv, "l:n:");
+        if (opt == -1) {
+            break;
+        }
+        switch (opt) {
+        case 'l':
+            for (lib=0; lib<LIB_COUNT; lib++) {
+                if (strcmp(optarg, LIB_NAMES[lib]) == 0) {
+                    break;
+                }
+            }
+            if (lib >= LIB_COUNT) {
+                printf("Invalid library: %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'n':
+            passes = atoi(optarg);
+            break;
+        default:
+            return 1;
+        }
+    }
+    if (passes <= 0 || optind + 1 != argc) {
+        printf("Usage: %s [-l opengl|glesv2] [-n passes] CALL_LOG\n", argv[0]);
+        return 1;
+    }
+
+    libHandle = dlopen(LIB_SONAMES[lib], RTLD_LAZY);
+    if (libHandle == NULL) {
+        printf("Can't load %s: %s\n", LIB_SONAMES[lib], dlerror());
+        return 1;
+    }
+
+    loadEGLExtensions();
+    dpy = eglGetPlatformDisplay(EGL_DUMMY_PLATFORM,
+            (void *) DUMMY_VENDOR_NAMES[0], NULL);
+    if (dpy == EGL_NO_DISPLAY) {
+        printf("eglGetPlatformDisplay failed\n");
+        return 1;
+    }
+    if (!eglBindAPI(LIB_APIS[lib])) {
+        printf("eglBindAPI failed\n");
+        return 1;
+    }
+    ctx = eglCreateContext(dpy, NULL, EGL_NO_CONTEXT, contextAttribs);
+    if (ctx == EGL_NO_CONTEXT) {
+        printf("eglCreateContext failed\n");
+        return 1;
+    }
+    if (!eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, ctx)) {
+        printf("eglMakeCurrent failed\n");
+        return 1;
+    }
+
+    if (!ReadCallLog(argv[optind])) {
+        return 1;
+    }
+
+    localCalls = malloc(callCount * sizeof(ReplayFunc));
+    if (localCalls == NULL) {
+        printf("Out of memory\n");
+        return 1;
+    }
+    for (i=0; i<callCount; i++) {
+        localCalls[i] = LocalCountCall;
+    }
+
+    // Run one pass of each first, to fill in any lazily-resolved dispatch
+    // table slots and to warm up the caches.
+    Replay(calls, 1);
+    Replay(localCalls, 1);
+
+    for (i=0; i<COUNTER_COUNT; i++) {
+        counters[i] = OpenCacheCounter(i);
+        EnableCacheCounter(counters[i], 1);
+    }
+    elapsed = Replay(calls, passes);
+    for (i=0; i<COUNTER_COUNT; i++) {
+        EnableCacheCounter(counters[i], 0);
+    }
+    localElapsed = Replay(localCalls, passes);
+
+    // Make sure that every call actually made it to the vendor library.
+    totalCalls = ((uint64_t) callCount) * passes;
+    vendorCalls = (uint64_t) (uintptr_t) ptr_eglTestDispatchCurrent(
+            DUMMY_COMMAND_GET_CALL_COUNT, 0);
+    if (vendorCalls != totalCalls + callCount) {
+        printf("Expected %llu calls to the vendor library, but got %llu\n",
+                (unsigned long long) (totalCalls + callCount),
+                (unsigned long long) vendorCalls);
+        return 1;
+    }
+
+    nsPerCall = ((double) elapsed) / ((double) totalCalls);
+    localNsPerCall = ((double) localElapsed) / ((double) totalCalls);
+
+    printf("# library,calls,functions,proc_address_functions,ns_per_call,"
+            "local_ns_per_call,overhead_ns,itlb_misses_per_1k,l1i_misses_per_1k\n");
+    printf("%s,%lu,%d,%d,%.2f,%.2f,%.2f", LIB_NAMES[lib],
+            (unsigned long) callCount, replayNameCount, procAddressCount,
+            nsPerCall, localNsPerCall, nsPerCall - localNsPerCall);
+    for (i=0; i<COUNTER_COUNT; i++) {
+        PrintCacheMisses(counters[i], totalCalls);
+        if (counters[i] >= 0) {
+            close(counters[i]);
+        }
+    }
+    printf("\n");
+
+    eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglDestroyContext(dpy, ctx);
+    free(localCalls);
+    return 0;
+}
@@ -0,0 +1,10 @@
+#!/bin/sh
+
+# Replays the sample call log through libOpenGL and libGLESv2. The arguments
+# are passed through.
+
+. $TOP_SRCDIR/tests/eglenv.sh
+
+for lib in opengl glesv2 ; do
+    ./benchreplay -l $lib "$@" $TOP_SRCDIR/tests/replay_calls.txt || exit 1
+done
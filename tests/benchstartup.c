@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+/*
+ * Measures how long it takes libEGL to get from a cold start to a current
+ * context.
+ *
+ * This should be run once per process, since it's the first call into libEGL
+ * that pays for loading the vendor libraries. It prints the time from the
+ * start of main to each step, with comma-separated fields: the step name and
+ * the microseconds since main started. Lines starting with '#' are comments.
+ *
+ *   display     eglGetPlatformDisplay returned, which loads every vendor.
+ *   initialize  eglInitialize returned.
+ *   context     eglCreateContext returned.
+ *   current     eglMakeCurrent returned, which fills in the dispatch table.
+ *
+ * benchstartup.sh runs this with extra vendor config files, and uses the
+ * trace file to break the time down by phase.
+ */
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "dummy/EGL_dummy.h"
+#include "egl_test_utils.h"
+
+static uint64_t startTime;
+
+static uint64_t GetTimeNS(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t) ts.tv_sec) * 1000000000 + ((uint64_t) ts.tv_nsec);
+}
+
+static void PrintStep(const char *name)
+{
+    printf("%s,%.3f\n", name, (GetTimeNS() - startTime) / 1000.0);
+}
+
+int main(void)
+{
+    EGLDisplay dpy;
+    EGLContext ctx;
+    EGLint major, minor;
+
+    startTime = GetTimeNS();
+
+    dpy = eglGetPlatformDisplay(EGL_DUMMY_PLATFORM,
+            (void *) DUMMY_VENDOR_NAMES[0], NULL);
+    if (dpy == EGL_NO_DISPLAY) {
+        printf("eglGetPlatformDisplay failed\n");
+        return 1;
+    }
+    PrintStep("display");
+
+    if (!eglInitialize(dpy, &major, &minor)) {
+        printf("eglInitialize failed\n");
+        return 1;
+    }
+    PrintStep("initialize");
+
+    ctx = eglCreateContext(dpy, NULL, EGL_NO_CONTEXT, NULL);
+    if (ctx == EGL_NO_CONTEXT) {
+        printf("eglCreateContext failed\n");
+        return 1;
+    }
+    PrintStep("context");
+
+    if (!eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, ctx)) {
+        printf("eglMakeCurrent failed\n");
+        return 1;
+    }
+    PrintStep("current");
+
+    eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglDestroyContext(dpy, ctx);
+    eglTerminate(dpy);
+    return 0;
+}
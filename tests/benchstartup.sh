@@ -0,0 +1,49 @@
+#!/bin/sh
+
+# Runs benchstartup with more and more vendor config files, and prints how
+# long each startup phase took. The extra config files point to libraries
+# that don't exist, so they cost a directory scan, a JSON parse, and a failed
+# dlopen each, which is about what a stale ICD file costs.
+#
+# The arguments are the numbers of extra config files to try. The default is
+# "0 16 64".
+
+. $TOP_SRCDIR/tests/eglenv.sh
+
+COUNTS="$*"
+if test -z "$COUNTS" ; then
+    COUNTS="0 16 64"
+fi
+
+TMPDIR=`mktemp -d` || exit 1
+trap 'rm -rf "$TMPDIR"' EXIT
+
+for count in $COUNTS ; do
+    rm -rf "$TMPDIR/json" "$TMPDIR"/trace.*
+    mkdir "$TMPDIR/json" || exit 1
+    cp $TOP_SRCDIR/tests/json/*.json "$TMPDIR/json" || exit 1
+
+    i=0
+    while test $i -lt $count ; do
+        cat > "$TMPDIR/json/50_missing$i.json" <<EOJSON
+{
+    "file_format_version" : "1.0.0",
+    "ICD" : {
+        "library_path" : "libEGL_missing$i.so.0"
+    }
+}
+EOJSON
+        i=`expr $i + 1`
+    done
+
+    echo "# $count extra config files"
+    echo "# step,us_since_main"
+    __EGL_VENDOR_LIBRARY_DIRS="$TMPDIR/json" __GLVND_TRACE_FILE="$TMPDIR/trace" \
+        ./benchstartup || exit 1
+
+    if test -n "$PYTHON" -a "$PYTHON" != ":" ; then
+        for trace in "$TMPDIR"/trace.* ; do
+            test -f "$trace" && "$PYTHON" $TOP_SRCDIR/bin/trace-decode.py --phases "$trace"
+        done
+    fi
+done
@@ -0,0 +1,400 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+/*
+ * Measures the per-thread cost of short-lived threads that each make a
+ * context current, make a few GL calls, release it, and exit.
+ *
+ * That covers creating libEGL's or libGLX's per-thread state and
+ * libGLdispatch's thread state on the first MakeCurrent, and freeing them
+ * again in the TLS destructors when the thread exits. The -a option picks the
+ * API, "egl" or "glx". The GLX mode needs an X server, and prints a comment
+ * and exits without an error if it can't open a display.
+ *
+ * The -n option sets how many threads to start in total, and -c sets how many
+ * run at once. Each running thread gets its own context, which is reused by
+ * the next thread once that one has exited. Each thread makes -g GL calls.
+ *
+ * Each thread times these phases:
+ *
+ *   start    From pthread_create until the thread starts running.
+ *   current  The first MakeCurrent call.
+ *   gl       The GL calls.
+ *   release  The MakeCurrent call that releases the context.
+ *   exit     From the end of the thread function until pthread_join
+ *            returns, which includes the TLS destructors. This is only exact
+ *            with -c 1, since otherwise a thread can finish before the main
+ *            thread gets around to joining it.
+ *
+ * The output has one line for each phase, with comma-separated fields: the
+ * API, the phase, the number of threads, and the average, 50th, 90th and 99th
+ * percentile and maximum nanoseconds. Lines starting with '#' are comments.
+ */
+
+#include <X11/Xlib.h>
+#include <GL/glx.h>
+#include <GL/gl.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "dummy/EGL_dummy.h"
+#include "egl_test_utils.h"
+#include "test_utils.h"
+
+enum {
+    API_EGL,
+    API_GLX,
+    API_COUNT
+};
+
+static const char *API_NAMES[API_COUNT] = { "egl", "glx" };
+
+enum {
+    PHASE_START,
+    PHASE_CURRENT,
+    PHASE_GL,
+    PHASE_RELEASE,
+    PHASE_EXIT,
+    PHASE_COUNT
+};
+
+static const char *PHASE_NAMES[PHASE_COUNT] = {
+    "start", "current", "gl", "release", "exit"
+};
+
+typedef struct ChurnSlotRec {
+    pthread_t thread;
+    EGLContext eglContext;
+    GLXContext glxContext;
+
+    uint64_t createTime;
+    uint64_t startTime;
+    uint64_t endTime;
+    uint64_t phases[PHASE_COUNT];
+    int success;
+} ChurnSlot;
+
+static int api = API_EGL;
+static int glCalls = 4;
+static EGLDisplay eglDpy = EGL_NO_DISPLAY;
+static Display *xDpy = NULL;
+static struct window_info windowInfo;
+
+// PHASE_COUNT arrays of one latency per thread.
+static uint64_t *phaseTimes[PHASE_COUNT];
+
+static uint64_t GetTimeNS(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t) ts.tv_sec) * 1000000000 + ((uint64_t) ts.tv_nsec);
+}
+
+static int CompareLatencies(const void *a, const void *b)
+{
+    uint64_t va = *((const uint64_t *) a);
+    uint64_t vb = *((const uint64_t *) b);
+    return (va < vb ? -1 : (va > vb ? 1 : 0));
+}
+
+static int MakeCurrent(ChurnSlot *slot, int release)
+{
+    if (api == API_EGL) {
+        return eglMakeCurrent(eglDpy, EGL_NO_SURFACE, EGL_NO_SURFACE,
+                release ? EGL_NO_CONTEXT : slot->eglContext);
+    } else if (release) {
+        return glXMakeContextCurrent(xDpy, None, None, NULL);
+    } else {
+        return glXMakeContextCurrent(xDpy, windowInfo.draw, windowInfo.draw,
+                slot->glxContext);
+    }
+}
+
+static void MakeGLCalls(void)
+{
+    static const GLfloat v[] = { 0, 0, 0 };
+    int i;
+
+    // The EGL dummy vendor only implements glGetString, and the GLX one only
+    // implements glBegin, glVertex3fv, and glEnd.
+    for (i=0; i<glCalls; i++) {
+        if (api == API_EGL) {
+            glGetString(GL_VENDOR);
+        } else {
+            glBegin(GL_TRIANGLES);
+            glVertex3fv(v);
+            glEnd();
+        }
+    }
+}
+
+static void *ChurnThreadProc(void *param)
+{
+    ChurnSlot *slot = (ChurnSlot *) param;
+    uint64_t t0, t1;
+
+    slot->startTime = GetTimeNS();
+
+    t0 = GetTimeNS();
+    if (!MakeCurrent(slot, 0)) {
+        printf("MakeCurrent failed\n");
+        return NULL;
+    }
+    t1 = GetTimeNS();
+    slot->phases[PHASE_CURRENT] = t1 - t0;
+
+    MakeGLCalls();
+    t0 = GetTimeNS();
+    slot->phases[PHASE_GL] = t0 - t1;
+
+    if (!MakeCurrent(slot, 1)) {
+        printf("Releasing current failed\n");
+        return NULL;
+    }
+    t1 = GetTimeNS();
+    slot->phases[PHASE_RELEASE] = t1 - t0;
+
+    slot->success = 1;
+    slot->endTime = GetTimeNS();
+    return NULL;
+}
+
+static int InitAPI(void)
+{
+    if (api == API_EGL) {
+        eglDpy = eglGetPlatformDisplay(EGL_DUMMY_PLATFORM,
+                (void *) DUMMY_VENDOR_NAMES[0], NULL);
+        if (eglDpy == EGL_NO_DISPLAY) {
+            printf("eglGetPlatformDisplay failed\n");
+            return -1;
+        }
+        return 1;
+    }
+
+    XInitThreads();
+    xDpy = XOpenDisplay(NULL);
+    if (xDpy == NULL) {
+        printf("# No X display, skipping GLX\n");
+        return 0;
+    }
+    if (!testUtilsCreateWindow(xDpy, &windowInfo, 0)) {
+        printf("Failed to create window\n");
+        return -1;
+    }
+    return 1;
+}
+
+static void CleanupAPI(void)
+{
+    if (xDpy != NULL) {
+        testUtilsDestroyWindow(xDpy, &windowInfo);
+        XCloseDisplay(xDpy);
+    }
+}
+
+static int CreateSlotContext(ChurnSlot *slot)
+{
+    if (api == API_EGL) {
+        slot->eglContext = eglCreateContext(eglDpy, NULL, EGL_NO_CONTEXT, NULL);
+        return (slot->eglContext != EGL_NO_CONTEXT);
+    } else {
+        slot->glxContext = glXCreateContext(xDpy, windowInfo.visinfo, NULL, True);
+        return (slot->glxContext != NULL);
+    }
+}
+
+static void DestroySlotContext(ChurnSlot *slot)
+{
+    if (slot->eglContext != EGL_NO_CONTEXT) {
+        eglDestroyContext(eglDpy, slot->eglContext);
+    }
+    if (slot->glxContext != NULL) {
+        glXDestroyContext(xDpy, slot->glxContext);
+    }
+}
+
+static void PrintPhase(int phase, int numThreads)
+{
+    uint64_t *times = phaseTimes[phase];
+    uint64_t sum = 0;
+    int i;
+
+    for (i=0; i<numThreads; i++) {
+        sum += times[i];
+    }
+    qsort(times, numThreads, sizeof(uint64_t), CompareLatencies);
+
+    printf("%s,%s,%d,%llu,%llu,%llu,%llu,%llu\n", API_NAMES[api],
+            PHASE_NAMES[phase], numThreads,
+            (unsigned long long) (sum / numThreads),
+            (unsigned long long) times[numThreads / 2],
+            (unsigned long long) times[numThreads * 9 / 10],
+            (unsigned long long) times[numThreads * 99 / 100],
+            (unsigned long long) times[numThreads - 1]);
+}
+
+int main(int argc, char **argv)
+{
+    ChurnSlot *slots;
+    int numThreads = 10000;
+    int concurrency = 1;
+    int started, i, ret;
+    uint64_t start, elapsed;
+
+    while (1) {
+        int opt = getopt(argc, argv, "a:n:c:g:");
+        if (opt == -1) {
+            break;
+        }
+        switch (opt) {
+        case 'a':
+            for (api=0; api<API_COUNT; api++) {
+                if (strcmp(optarg, API_NAMES[api]) == 0) {
+                    break;
+                }
+            }
+            if (api == API_COUNT) {
+                printf("Unknown API: %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'n':
+            numThreads = atoi(optarg);
+            break;
+        case 'c':
+            concurrency = atoi(optarg);
+            break;
+        case 'g':
+            glCalls = atoi(optarg);
+            break;
+        default:
+            return 1;
+        }
+    }
+    if (numThreads <= 0 || concurrency <= 0 || glCalls < 0) {
+        printf("Invalid thread count, concurrency, or GL call count\n");
+        return 1;
+    }
+    if (concurrency > numThreads) {
+        concurrency = numThreads;
+    }
+
+    ret = InitAPI();
+    if (ret <= 0) {
+        return (ret < 0 ? 1 : 0);
+    }
+
+    slots = calloc(concurrency, sizeof(ChurnSlot));
+    for (i=0; i<PHASE_COUNT; i++) {
+        phaseTimes[i] = malloc(numThreads * sizeof(uint64_t));
+        if (phaseTimes[i] == NULL) {
+            printf("Out of memory\n");
+            return 1;
+        }
+    }
+    if (slots == NULL) {
+        printf("Out of memory\n");
+        return 1;
+    }
+    for (i=0; i<concurrency; i++) {
+        if (!CreateSlotContext(&slots[i])) {
+            printf("Failed to create a context\n");
+            return 1;
+        }
+    }
+
+    // Make the main thread current once, so that the first worker thread
+    // doesn't pay for loading the vendor library and filling in the dispatch
+    // table.
+    if (!MakeCurrent(&slots[0], 0) || !MakeCurrent(&slots[0], 1)) {
+        printf("MakeCurrent failed on the main thread\n");
+        return 1;
+    }
+
+    start = GetTimeNS();
+    for (started=0; started<numThreads; started += concurrency) {
+        int batch = numThreads - started;
+        if (batch > concurrency) {
+            batch = concurrency;
+        }
+
+        for (i=0; i<batch; i++) {
+            ChurnSlot *slot = &slots[i];
+            slot->success = 0;
+            slot->createTime = GetTimeNS();
+            if (pthread_create(&slot->thread, NULL, ChurnThreadProc, slot) != 0) {
+                printf("pthread_create failed\n");
+                return 1;
+            }
+        }
+        for (i=0; i<batch; i++) {
+            ChurnSlot *slot = &slots[i];
+            int index = started + i;
+            uint64_t joinTime;
+
+            pthread_join(slot->thread, NULL);
+            joinTime = GetTimeNS();
+            if (!slot->success) {
+                return 1;
+            }
+            phaseTimes[PHASE_START][index] = slot->startTime - slot->createTime;
+            phaseTimes[PHASE_CURRENT][index] = slot->phases[PHASE_CURRENT];
+            phaseTimes[PHASE_GL][index] = slot->phases[PHASE_GL];
+            phaseTimes[PHASE_RELEASE][index] = slot->phases[PHASE_RELEASE];
+            phaseTimes[PHASE_EXIT][index] = joinTime - slot->endTime;
+        }
+    }
+    elapsed = GetTimeNS() - start;
+
+    printf("# api,phase,threads,avg_ns,p50_ns,p90_ns,p99_ns,max_ns (%d at once, %d GL calls each)\n",
+            concurrency, glCalls);
+    for (i=0; i<PHASE_COUNT; i++) {
+        PrintPhase(i, numThreads);
+    }
+    printf("# %d threads in %llu ms, %.0f threads per second\n", numThreads,
+            (unsigned long long) (elapsed / 1000000),
+            ((double) numThreads) * 1000000000.0 / ((double) elapsed));
+
+    for (i=0; i<concurrency; i++) {
+        DestroySlotContext(&slots[i]);
+    }
+    for (i=0; i<PHASE_COUNT; i++) {
+        free(phaseTimes[i]);
+    }
+    free(slots);
+    CleanupAPI();
+    return 0;
+}
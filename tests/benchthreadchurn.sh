@@ -0,0 +1,11 @@
+#!/bin/sh
+
+# Runs benchthreadchurn for EGL and GLX. The GLX run is skipped if there's no
+# X display. The arguments are passed through.
+
+. $TOP_SRCDIR/tests/eglenv.sh
+. $TOP_SRCDIR/tests/glxenv.sh
+
+./benchthreadchurn -a egl "$@" || exit 1
+./benchthreadchurn -a egl -c 8 "$@" || exit 1
+./benchthreadchurn -a glx "$@" || exit 1
@@ -0,0 +1,584 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+/*
+ * Measures the data structures in src/util by themselves, so that a
+ * replacement for one of them can be compared without building it into
+ * libGLX or libEGL.
+ *
+ * These run with 1, 2, 4, and so on up to the -t thread count, and with 16,
+ * 256, 4096, and 65536 entries:
+ *
+ *   hashmap,find       __glvndHashMapFind in a read section, with
+ *                      pointer-sized keys.
+ *   hashmap,insert     __glvndHashMapInsert and then __glvndHashMapRemove
+ *                      with a key that isn't in the map, so the map stays
+ *                      the same size. Each thread uses its own keys.
+ *   string_pool,intern __glvndStringPoolIntern with a string that's already
+ *                      in the pool.
+ *   winsys,find_index  __glvndWinsysDispatchFindIndex.
+ *   winsys,lookup      __glvndWinsysVendorDispatchLookupFunc.
+ *
+ * Each thread makes -n calls. Each thread times its own loop, and the result
+ * covers the first thread starting until the last one finishes.
+ *
+ * These run on one thread, with the extension strings below, which are from
+ * real GLX vendor libraries:
+ *
+ *   ext,union          UnionExtensionStrings, including copying the first
+ *                      string.
+ *   ext,intersect      IntersectionExtensionStrings, including copying the
+ *                      first string.
+ *   ext,set_init       ExtensionSetInit and ExtensionSetFree.
+ *   ext,split          SplitString.
+ *   ext,token_hit      IsTokenInString, with the last token in the string.
+ *   ext,token_miss     IsTokenInString, with a token that isn't there.
+ *
+ * Each of those is called -s times.
+ *
+ * These run with 1 up to -t minus 1 reader threads, which keep taking an
+ * rwlock for reading, while one more thread takes it for writing:
+ *
+ *   rwlock,write_default          A default rwlock.
+ *   rwlock,write_writer_preferred An rwlock from
+ *                                 glvndRWLockInitWriterPreferred.
+ *
+ * The writer takes the lock -n / 1000 times. For these, the size is the
+ * number of readers, and the rest of the line only counts the writer, so the
+ * nanoseconds per operation are how long each write lock took.
+ *
+ * The output has one line for each result, with comma-separated fields: the
+ * structure, the operation, the number of entries or extension names, the
+ * number of threads, the total operations per second, and the average
+ * wall-clock nanoseconds per operation on each thread. Lines starting with '#'
+ * are comments.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "glvnd_pthread.h"
+#include "glvnd_hashmap.h"
+#include "glvnd_arena.h"
+#include "glvnd_memstats.h"
+#include "string_pool.h"
+#include "winsys_dispatch.h"
+#include "utils_misc.h"
+#include "glvnd_atomic.h"
+
+#define MAX_ENTRIES 65536
+#define MAX_THREADS 256
+
+static const int ENTRY_COUNTS[] = { 16, 256, 4096, MAX_ENTRIES };
+#define ENTRY_COUNT_COUNT (sizeof(ENTRY_COUNTS) / sizeof(ENTRY_COUNTS[0]))
+
+static const char *EXT_STRING_A =
+    "GLX_ARB_context_flush_control GLX_ARB_create_context "
+    "GLX_ARB_create_context_no_error GLX_ARB_create_context_profile "
+    "GLX_ARB_create_context_robustness GLX_ARB_fbconfig_float "
+    "GLX_ARB_get_proc_address GLX_ARB_multisample GLX_EXT_buffer_age "
+    "GLX_EXT_create_context_es2_profile GLX_EXT_create_context_es_profile "
+    "GLX_EXT_fbconfig_packed_float GLX_EXT_framebuffer_sRGB "
+    "GLX_EXT_import_context GLX_EXT_stereo_tree GLX_EXT_swap_control "
+    "GLX_EXT_swap_control_tear GLX_EXT_texture_from_pixmap "
+    "GLX_EXT_visual_info GLX_EXT_visual_rating GLX_NV_copy_buffer "
+    "GLX_NV_copy_image GLX_NV_delay_before_swap GLX_NV_float_buffer "
+    "GLX_NV_multigpu_context GLX_NV_robustness_video_memory_purge "
+    "GLX_SGIX_fbconfig GLX_SGIX_pbuffer GLX_SGI_swap_control "
+    "GLX_SGI_video_sync";
+
+static const char *EXT_STRING_B =
+    "GLX_ARB_context_flush_control GLX_ARB_create_context "
+    "GLX_ARB_create_context_no_error GLX_ARB_create_context_profile "
+    "GLX_ARB_create_context_robustness GLX_ARB_fbconfig_float "
+    "GLX_ARB_framebuffer_sRGB GLX_ARB_get_proc_address GLX_ARB_multisample "
+    "GLX_EXT_buffer_age GLX_EXT_create_context_es2_profile "
+    "GLX_EXT_create_context_es_profile GLX_EXT_fbconfig_packed_float "
+    "GLX_EXT_framebuffer_sRGB GLX_EXT_import_context GLX_EXT_no_config_context "
+    "GLX_EXT_swap_control GLX_EXT_swap_control_tear GLX_EXT_texture_from_pixmap "
+    "GLX_EXT_visual_info GLX_EXT_visual_rating GLX_INTEL_swap_event "
+    "GLX_MESA_copy_sub_buffer GLX_MESA_query_renderer GLX_MESA_swap_control "
+    "GLX_OML_swap_method GLX_OML_sync_control GLX_SGIS_multisample "
+    "GLX_SGIX_fbconfig GLX_SGIX_pbuffer GLX_SGIX_visual_select_group "
+    "GLX_SGI_make_current_read GLX_SGI_swap_control GLX_SGI_video_sync";
+
+typedef struct BenchThreadRec {
+    pthread_t thread;
+    int index;
+    uint64_t startTime;
+    uint64_t endTime;
+} BenchThread;
+
+typedef void (* BenchFunc) (int threadIndex, int numThreads);
+
+static int iterations = 1000000;
+static int stringIterations = 10000;
+
+static BenchFunc benchFunc;
+static int benchThreads;
+static pthread_barrier_t startBarrier;
+
+static int numEntries;
+static uintptr_t keys[MAX_ENTRIES];
+static uintptr_t threadKeys[MAX_THREADS];
+static char *names[MAX_ENTRIES];
+static __GLVNDhashMap hashMap = GLVND_HASHMAP_INITIALIZER(NULL);
+static __GLVNDwinsysVendorDispatch *vendorDispatch;
+static glvnd_rwlock_t benchRWLock;
+static int rwlockWrites;
+static int volatile rwlockWriterDone;
+static uintptr_t volatile rwlockSink;
+
+static uint64_t GetTimeNS(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t) ts.tv_sec) * 1000000000 + ((uint64_t) ts.tv_nsec);
+}
+
+static void BenchStubFunc(void)
+{
+}
+
+static void PrintResult(const char *structure, const char *op, int size,
+        int numThreads, uint64_t opsPerThread, uint64_t elapsed)
+{
+    printf("%s,%s,%d,%d,%.0f,%.3f\n", structure, op, size, numThreads,
+            ((double) numThreads) * opsPerThread * 1000000000.0 / ((double) elapsed),
+            ((double) elapsed) / ((double) opsPerThread));
+    fflush(stdout);
+}
+
+static void *BenchThreadProc(void *param)
+{
+    BenchThread *bt = (BenchThread *) param;
+
+    pthread_barrier_wait(&startBarrier);
+    bt->startTime = GetTimeNS();
+    benchFunc(bt->index, benchThreads);
+    bt->endTime = GetTimeNS();
+    return NULL;
+}
+
+/**
+ * Runs \p func on each thread, and returns the time from when the first thread
+ * started until the last one finished.
+ */
+static uint64_t RunThreads(BenchFunc func, int numThreads)
+{
+    BenchThread *threads;
+    uint64_t start = UINT64_MAX, end = 0;
+    int i;
+
+    threads = calloc(numThreads, sizeof(BenchThread));
+    if (threads == NULL) {
+        printf("Out of memory\n");
+        exit(1);
+    }
+
+    benchFunc = func;
+    benchThreads = numThreads;
+
+    // The threads wait on a barrier so that the time doesn't include creating
+    // them.
+    pthread_barrier_init(&startBarrier, NULL, numThreads);
+    for (i=0; i<numThreads; i++) {
+        threads[i].index = i;
+        pthread_create(&threads[i].thread, NULL, BenchThreadProc, &threads[i]);
+    }
+    for (i=0; i<numThreads; i++) {
+        pthread_join(threads[i].thread, NULL);
+        if (threads[i].startTime < start) {
+            start = threads[i].startTime;
+        }
+        if (threads[i].endTime > end) {
+            end = threads[i].endTime;
+        }
+    }
+    pthread_barrier_destroy(&startBarrier);
+    free(threads);
+    return end - start;
+}
+
+static void HashMapFindFunc(int threadIndex, int numThreads)
+{
+    unsigned int mask = numEntries - 1;
+    int i;
+
+    for (i=0; i<iterations; i++) {
+        uintptr_t key = keys[(i + threadIndex) & mask];
+        void *value;
+
+        __glvndHashMapReadBegin();
+        value = __glvndHashMapFind(&hashMap, &key, sizeof(key));
+        __glvndHashMapReadEnd();
+        if (value == NULL) {
+            printf("Missing key %p\n", (void *) key);
+            abort();
+        }
+    }
+}
+
+static void HashMapInsertFunc(int threadIndex, int numThreads)
+{
+    uintptr_t key = threadKeys[threadIndex];
+    int i;
+
+    for (i=0; i<iterations; i++) {
+        __glvndHashMapLock(&hashMap, &key, sizeof(key));
+        if (!__glvndHashMapInsert(&hashMap, &key, sizeof(key), &threadKeys[threadIndex])) {
+            printf("__glvndHashMapInsert failed\n");
+            abort();
+        }
+        __glvndHashMapUnlock(&hashMap, &key, sizeof(key));
+
+        __glvndHashMapLock(&hashMap, &key, sizeof(key));
+        __glvndHashMapRemove(&hashMap, &key, sizeof(key));
+        __glvndHashMapUnlock(&hashMap, &key, sizeof(key));
+    }
+}
+
+static void StringPoolInternFunc(int threadIndex, int numThreads)
+{
+    unsigned int mask = numEntries - 1;
+    int i;
+
+    for (i=0; i<iterations; i++) {
+        if (__glvndStringPoolIntern(names[(i + threadIndex) & mask]) == NULL) {
+            printf("__glvndStringPoolIntern failed\n");
+            abort();
+        }
+    }
+}
+
+static void WinsysFindIndexFunc(int threadIndex, int numThreads)
+{
+    unsigned int mask = numEntries - 1;
+    int i;
+
+    for (i=0; i<iterations; i++) {
+        if (__glvndWinsysDispatchFindIndex(names[(i + threadIndex) & mask]) < 0) {
+            printf("__glvndWinsysDispatchFindIndex failed\n");
+            abort();
+        }
+    }
+}
+
+static void WinsysLookupFunc(int threadIndex, int numThreads)
+{
+    unsigned int mask = numEntries - 1;
+    int i;
+
+    for (i=0; i<iterations; i++) {
+        if (__glvndWinsysVendorDispatchLookupFunc(vendorDispatch,
+                    (i + threadIndex) & mask) == NULL) {
+            printf("__glvndWinsysVendorDispatchLookupFunc failed\n");
+            abort();
+        }
+    }
+}
+
+/**
+ * Thread 0 is the writer, and every other thread is a reader. The readers
+ * keep going until the writer is done.
+ */
+static void RWLockFunc(int threadIndex, int numThreads)
+{
+    int i;
+
+    if (threadIndex == 0) {
+        for (i=0; i<rwlockWrites; i++) {
+            __glvndPthreadFuncs.rwlock_wrlock(&benchRWLock);
+            rwlockSink = keys[i & 15];
+            __glvndPthreadFuncs.rwlock_unlock(&benchRWLock);
+        }
+        glvndAtomicStoreRelease(&rwlockWriterDone, 1);
+        return;
+    }
+
+    while (!glvndAtomicLoadAcquire(&rwlockWriterDone)) {
+        uintptr_t sum = 0;
+
+        __glvndPthreadFuncs.rwlock_rdlock(&benchRWLock);
+        for (i=0; i<16; i++) {
+            sum += keys[i];
+        }
+        __glvndPthreadFuncs.rwlock_unlock(&benchRWLock);
+        rwlockSink = sum;
+    }
+}
+
+static void RunRWLockBenchmarks(int maxThreads)
+{
+    int numReaders;
+
+    rwlockWrites = (iterations >= 1000 ? iterations / 1000 : 1);
+    for (numReaders=1; numReaders<maxThreads; numReaders *= 2) {
+        uint64_t elapsed;
+
+        __glvndPthreadFuncs.rwlock_init(&benchRWLock, NULL);
+        rwlockWriterDone = 0;
+        elapsed = RunThreads(RWLockFunc, numReaders + 1);
+        PrintResult("rwlock", "write_default", numReaders, 1, rwlockWrites, elapsed);
+        __glvndPthreadFuncs.rwlock_destroy(&benchRWLock);
+
+        glvndRWLockInitWriterPreferred(&benchRWLock);
+        rwlockWriterDone = 0;
+        elapsed = RunThreads(RWLockFunc, numReaders + 1);
+        PrintResult("rwlock", "write_writer_preferred", numReaders, 1, rwlockWrites, elapsed);
+        __glvndPthreadFuncs.rwlock_destroy(&benchRWLock);
+    }
+}
+
+static void RunEntryBenchmarks(int maxThreads)
+{
+    __GLVNDarena *arena;
+    int sizeIndex, numThreads, i;
+    int winsysCount = 0;
+
+    for (sizeIndex=0; sizeIndex<ENTRY_COUNT_COUNT; sizeIndex++) {
+        numEntries = ENTRY_COUNTS[sizeIndex];
+
+        // The string pool and the winsys function list are global, so each
+        // size just adds the names that the previous sizes didn't.
+        for (i=0; i<numEntries; i++) {
+            uintptr_t key = keys[i];
+            __glvndHashMapLock(&hashMap, &key, sizeof(key));
+            __glvndHashMapInsert(&hashMap, &key, sizeof(key), &keys[i]);
+            __glvndHashMapUnlock(&hashMap, &key, sizeof(key));
+            __glvndStringPoolIntern(names[i]);
+        }
+        for (; winsysCount<numEntries; winsysCount++) {
+            if (__glvndWinsysDispatchAllocIndex(names[winsysCount],
+                        (void *) BenchStubFunc) != winsysCount) {
+                printf("__glvndWinsysDispatchAllocIndex failed\n");
+                exit(1);
+            }
+        }
+
+        arena = __glvndArenaCreate(4096, GLVND_MEM_WINSYS_DISPATCH);
+        vendorDispatch = (arena != NULL ? __glvndWinsysVendorDispatchCreate(arena) : NULL);
+        if (vendorDispatch == NULL) {
+            printf("__glvndWinsysVendorDispatchCreate failed\n");
+            exit(1);
+        }
+        for (i=0; i<numEntries; i++) {
+            if (__glvndWinsysVendorDispatchAddFunc(vendorDispatch, i,
+                        (void *) BenchStubFunc) != 0) {
+                printf("__glvndWinsysVendorDispatchAddFunc failed\n");
+                exit(1);
+            }
+        }
+
+        for (numThreads=1; ; numThreads *= 2) {
+            uint64_t elapsed;
+
+            if (numThreads > maxThreads) {
+                numThreads = maxThreads;
+            }
+
+            elapsed = RunThreads(HashMapFindFunc, numThreads);
+            PrintResult("hashmap", "find", numEntries, numThreads, iterations, elapsed);
+
+            elapsed = RunThreads(HashMapInsertFunc, numThreads);
+            PrintResult("hashmap", "insert", numEntries, numThreads, iterations, elapsed);
+
+            elapsed = RunThreads(StringPoolInternFunc, numThreads);
+            PrintResult("string_pool", "intern", numEntries, numThreads, iterations, elapsed);
+
+            elapsed = RunThreads(WinsysFindIndexFunc, numThreads);
+            PrintResult("winsys", "find_index", numEntries, numThreads, iterations, elapsed);
+
+            elapsed = RunThreads(WinsysLookupFunc, numThreads);
+            PrintResult("winsys", "lookup", numEntries, numThreads, iterations, elapsed);
+
+            if (numThreads == maxThreads) {
+                break;
+            }
+        }
+
+        __glvndWinsysVendorDispatchDestroy(vendorDispatch);
+        __glvndArenaDestroy(arena);
+        vendorDispatch = NULL;
+        __glvndHashMapClear(&hashMap);
+    }
+}
+
+static int CountTokens(const char *str)
+{
+    const char *tok = str;
+    size_t len = 0;
+    int count = 0;
+
+    while (FindNextStringToken(&tok, &len, " ")) {
+        count++;
+    }
+    return count;
+}
+
+static void RunStringBenchmarks(void)
+{
+    const char *lastToken;
+    int countA = CountTokens(EXT_STRING_A);
+    uint64_t start;
+    int i;
+
+    start = GetTimeNS();
+    for (i=0; i<stringIterations; i++) {
+        char *str = UnionExtensionStrings(strdup(EXT_STRING_A), EXT_STRING_B);
+        if (str == NULL) {
+            printf("UnionExtensionStrings failed\n");
+            exit(1);
+        }
+        free(str);
+    }
+    PrintResult("ext", "union", countA + CountTokens(EXT_STRING_B), 1,
+            stringIterations, GetTimeNS() - start);
+
+    start = GetTimeNS();
+    for (i=0; i<stringIterations; i++) {
+        char *str = strdup(EXT_STRING_A);
+        if (str == NULL) {
+            printf("Out of memory\n");
+            exit(1);
+        }
+        IntersectionExtensionStrings(str, EXT_STRING_B);
+        free(str);
+    }
+    PrintResult("ext", "intersect", countA + CountTokens(EXT_STRING_B), 1,
+            stringIterations, GetTimeNS() - start);
+
+    start = GetTimeNS();
+    for (i=0; i<stringIterations; i++) {
+        GLVNDextensionSet set;
+        if (ExtensionSetInit(&set, EXT_STRING_A) != 0) {
+            printf("ExtensionSetInit failed\n");
+            exit(1);
+        }
+        ExtensionSetFree(&set);
+    }
+    PrintResult("ext", "set_init", countA, 1, stringIterations, GetTimeNS() - start);
+
+    start = GetTimeNS();
+    for (i=0; i<stringIterations; i++) {
+        char **tokens = SplitString(EXT_STRING_A, NULL, " ");
+        if (tokens == NULL) {
+            printf("SplitString failed\n");
+            exit(1);
+        }
+        free(tokens);
+    }
+    PrintResult("ext", "split", countA, 1, stringIterations, GetTimeNS() - start);
+
+    lastToken = strrchr(EXT_STRING_A, ' ') + 1;
+    start = GetTimeNS();
+    for (i=0; i<stringIterations; i++) {
+        if (!IsTokenInString(EXT_STRING_A, lastToken, strlen(lastToken), " ")) {
+            printf("IsTokenInString failed\n");
+            exit(1);
+        }
+    }
+    PrintResult("ext", "token_hit", countA, 1, stringIterations, GetTimeNS() - start);
+
+    start = GetTimeNS();
+    for (i=0; i<stringIterations; i++) {
+        if (IsTokenInString(EXT_STRING_A, "GLX_EXT_not_there", 17, " ")) {
+            printf("IsTokenInString found a missing token\n");
+            exit(1);
+        }
+    }
+    PrintResult("ext", "token_miss", countA, 1, stringIterations, GetTimeNS() - start);
+}
+
+int main(int argc, char **argv)
+{
+    int maxThreads = 8;
+    int i;
+
+    while (1) {
+        int opt = getopt(argc, argv, "n:s:t:");
+        if (opt == -1) {
+            break;
+        }
+        switch (opt) {
+        case 'n':
+            iterations = atoi(optarg);
+            break;
+        case 's':
+            stringIterations = atoi(optarg);
+            break;
+        case 't':
+            maxThreads = atoi(optarg);
+            break;
+        default:
+            return 1;
+        }
+    }
+    if (iterations <= 0 || stringIterations <= 0 || maxThreads <= 0
+            || maxThreads > MAX_THREADS) {
+        printf("Invalid iteration or thread count\n");
+        return 1;
+    }
+
+    glvndSetupPthreads();
+    __glvndWinsysDispatchInit();
+
+    for (i=0; i<MAX_ENTRIES; i++) {
+        // Space the keys out like heap pointers, since that's what most of
+        // the maps in libGLX and libEGL use as keys.
+        keys[i] = 0x10000 + ((uintptr_t) i) * 48;
+        if (glvnd_asprintf(&names[i], "glBenchUtilFunction%05d", i) < 0) {
+            printf("Out of memory\n");
+            return 1;
+        }
+    }
+    for (i=0; i<MAX_THREADS; i++) {
+        threadKeys[i] = keys[MAX_ENTRIES - 1] + ((uintptr_t) i + 1) * 48;
+    }
+
+    printf("# structure,op,size,threads,ops_per_sec,ns_per_op (%d calls per thread, %d string calls)\n",
+            iterations, stringIterations);
+    RunEntryBenchmarks(maxThreads);
+    RunStringBenchmarks();
+    RunRWLockBenchmarks(maxThreads);
+
+    __glvndHashMapTeardown(&hashMap, NULL, NULL, 0);
+    __glvndHashMapFini();
+    __glvndWinsysDispatchCleanup();
+    __glvndStringPoolCleanup();
+    for (i=0; i<MAX_ENTRIES; i++) {
+        free(names[i]);
+    }
+    return 0;
+}
@@ -0,0 +1,314 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+/*
+ * Compares calling a vendor's GL function through libglvnd to calling it
+ * directly.
+ *
+ * The vendor is a separate library, libbenchvendor, with a glVertex3fv that
+ * just counts calls. This calls it in a loop through each path:
+ *
+ *   direct             The vendor's function, called directly.
+ *   static             A static stub in libOpenGL.
+ *   generated          A stub from __glDispatchGetProcAddress.
+ *   patched_static     The static stub, after the vendor patched it.
+ *   patched_generated  The generated stub, after the vendor patched it.
+ *
+ * Every call goes through a function pointer, so the direct path costs the
+ * same as a call through the PLT, and the difference between it and each of
+ * the other paths is the overhead that libglvnd adds. The patched paths can
+ * come out ahead of the direct one, since the vendor's code runs in the stub
+ * itself.
+ *
+ * Every path is timed once while libGLdispatch is still in single-threaded
+ * mode, and again after a second thread forces it into multi-threaded mode.
+ * The stub flavor depends on how libGLdispatch was built and loaded, so it's
+ * reported along with each result. To compare flavors, run this against each
+ * build, for example with and without --disable-tls.
+ *
+ * The output has one line for each result, with comma-separated fields: the
+ * path, "single" or "multi", the entrypoint type, the stub flavor, the best
+ * time per call in nanoseconds, and the difference from the direct path in
+ * the same mode. Lines starting with '#' are comments. Paths that aren't
+ * available in this build are left out.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <time.h>
+#include <GL/gl.h>
+
+#include <GLdispatch.h>
+
+#include "dummy/benchvendor.h"
+#include "dummy/patchentrypoints.h"
+
+#define BENCH_REPEATS 5
+static const char *GENERATED_FUNCTION_NAME = "glDummyBenchDirectGLVND";
+
+typedef void (* pfn_glVertex3fv) (const GLfloat *v);
+
+static void *bench_getProcAddressCallback(const char *procName, void *param);
+static GLboolean bench_InitiatePatch(int type, int stubSize,
+        DispatchPatchLookupStubOffset lookupStubOffset);
+
+static const __GLdispatchPatchCallbacks patchCallbacks = {
+    dummyCheckPatchSupported,
+    bench_InitiatePatch,
+};
+
+/*
+ * The number of calls that went through a patched stub. The patched stubs
+ * increment this directly, the same way that benchVendor_glVertex3fv
+ * increments benchVendorCalls.
+ */
+static int patchedCalls;
+
+static int iterations = 10000000;
+static const char *entryType = "";
+static const char *stubFlavor = "";
+
+static double GetTimeNS(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((double) ts.tv_sec) * 1000000000.0 + ((double) ts.tv_nsec);
+}
+
+/*
+ * Calls \p func in a loop, and returns the best time per call out of
+ * BENCH_REPEATS runs.
+ */
+static double TimeCalls(pfn_glVertex3fv func)
+{
+    double best = -1.0;
+    int repeat, i;
+
+    for (repeat=0; repeat<BENCH_REPEATS; repeat++) {
+        double start = GetTimeNS();
+        double elapsed;
+        for (i=0; i<iterations; i++) {
+            func(NULL);
+        }
+        elapsed = (GetTimeNS() - start) / iterations;
+        if (best < 0.0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+    return best;
+}
+
+/*
+ * Times a function, and checks that the calls reached \p counter. Returns a
+ * negative value if they went somewhere else.
+ */
+static double RunPath(const char *path, const char *threads,
+        pfn_glVertex3fv func, int *counter, double directNS)
+{
+    int before = *counter;
+    double ns = TimeCalls(func);
+
+    if (*counter == before) {
+        fprintf(stderr, "The %s path didn't reach the vendor\n", path);
+        return -1.0;
+    }
+
+    printf("%s,%s,%s,%s,%.3f,%.3f\n", path, threads, entryType, stubFlavor,
+            ns, (directNS >= 0.0 ? ns - directNS : 0.0));
+    fflush(stdout);
+    return ns;
+}
+
+static GLboolean RunAllPaths(__GLdispatchThreadState *threadState,
+        __GLdispatchTable *dispatch, int vendorID,
+        pfn_glVertex3fv generatedFunc, const char *threads)
+{
+    double directNS;
+    int patched;
+
+    directNS = RunPath("direct", threads, benchVendor_glVertex3fv,
+            &benchVendorCalls, -1.0);
+    if (directNS < 0.0) {
+        return GL_FALSE;
+    }
+
+    // Make the vendor current without patching first. That also restores
+    // the default stubs, since libGLdispatch leaves them patched after
+    // losing current.
+    if (!__glDispatchMakeCurrent(threadState, dispatch, vendorID, NULL)) {
+        fprintf(stderr, "__glDispatchMakeCurrent failed\n");
+        return GL_FALSE;
+    }
+    if (RunPath("static", threads, glVertex3fv, &benchVendorCalls, directNS) < 0.0) {
+        return GL_FALSE;
+    }
+    if (generatedFunc != NULL && RunPath("generated", threads, generatedFunc,
+                &benchVendorCalls, directNS) < 0.0) {
+        return GL_FALSE;
+    }
+    __glDispatchLoseCurrent();
+
+    if (!__glDispatchMakeCurrent(threadState, dispatch, vendorID, &patchCallbacks)) {
+        fprintf(stderr, "__glDispatchMakeCurrent failed\n");
+        return GL_FALSE;
+    }
+    // Patching isn't supported on every architecture, so make one call
+    // first to see if it worked.
+    patched = patchedCalls;
+    glVertex3fv(NULL);
+    if (patchedCalls != patched) {
+        if (RunPath("patched_static", threads, glVertex3fv, &patchedCalls,
+                    directNS) < 0.0) {
+            return GL_FALSE;
+        }
+        if (generatedFunc != NULL && RunPath("patched_generated", threads,
+                    generatedFunc, &patchedCalls, directNS) < 0.0) {
+            return GL_FALSE;
+        }
+    }
+    __glDispatchLoseCurrent();
+
+    return GL_TRUE;
+}
+
+static void *ForceMultiThreadedProc(void *param)
+{
+    __glDispatchCheckMultithreaded();
+    return NULL;
+}
+
+static const char *GetStubFlavorName(int flavor)
+{
+    switch (flavor) {
+    case GLDISPATCH_STUB_FLAVOR_TLS:
+        return "tls";
+    case GLDISPATCH_STUB_FLAVOR_STATIC_TLS:
+        return "static_tls";
+    case GLDISPATCH_STUB_FLAVOR_TSD:
+        return "tsd";
+    default:
+        return "unknown";
+    }
+}
+
+int main(int argc, char **argv)
+{
+    __GLdispatchThreadState threadState;
+    __GLdispatchTable *dispatch;
+    __GLdispatchConfig config;
+    pfn_glVertex3fv generatedFunc = NULL;
+    pthread_t thr;
+    int vendorID;
+    int ret = 1;
+
+    while (1) {
+        int opt = getopt(argc, argv, "n:");
+        if (opt == -1) {
+            break;
+        }
+        switch (opt) {
+        case 'n':
+            iterations = atoi(optarg);
+            break;
+        default:
+            return 1;
+        }
+    }
+    if (iterations <= 0) {
+        fprintf(stderr, "Invalid iteration count\n");
+        return 1;
+    }
+
+    __glDispatchInit();
+    __glDispatchGetConfig(&config);
+    entryType = config.entryType;
+    stubFlavor = GetStubFlavorName(config.stubFlavor);
+
+    memset(&threadState, 0, sizeof(threadState));
+    vendorID = __glDispatchNewVendorID();
+    dispatch = __glDispatchCreateTable(bench_getProcAddressCallback, NULL);
+    if (dispatch == NULL) {
+        fprintf(stderr, "__glDispatchCreateTable failed\n");
+        return 1;
+    }
+
+#if defined(USE_DISPATCH_ASM)
+    // Without the assembly stubs, this would get a stub that can't be
+    // dispatched through, and __glDispatchGetProcAddress could return NULL
+    // anyway if there aren't any dynamic stubs.
+    generatedFunc = (pfn_glVertex3fv) __glDispatchGetProcAddress(GENERATED_FUNCTION_NAME);
+#endif
+
+    printf("# path,threads,entry_type,stub_flavor,ns_per_call,overhead_ns"
+            " (%d calls, best of %d)\n", iterations, BENCH_REPEATS);
+
+    if (!RunAllPaths(&threadState, dispatch, vendorID, generatedFunc, "single")) {
+        goto done;
+    }
+
+    __glDispatchCheckMultithreaded();
+    pthread_create(&thr, NULL, ForceMultiThreadedProc, NULL);
+    pthread_join(thr, NULL);
+
+    if (!RunAllPaths(&threadState, dispatch, vendorID, generatedFunc, "multi")) {
+        goto done;
+    }
+    ret = 0;
+
+done:
+    __glDispatchDestroyTable(dispatch);
+    __glDispatchFini();
+    return ret;
+}
+
+static void *bench_getProcAddressCallback(const char *procName, void *param)
+{
+    if (strcmp(procName, "glVertex3fv") == 0
+            || strcmp(procName, GENERATED_FUNCTION_NAME) == 0) {
+        return benchVendor_glVertex3fv;
+    }
+    return NULL;
+}
+
+static GLboolean bench_InitiatePatch(int type, int stubSize,
+        DispatchPatchLookupStubOffset lookupStubOffset)
+{
+    if (!dummyPatchFunction(type, stubSize, lookupStubOffset, "Vertex3fv",
+                &patchedCalls)) {
+        return GL_FALSE;
+    }
+    // The generated stub is only in libGLdispatch, so it's fine if
+    // libOpenGL's entrypoints don't have it.
+    dummyPatchFunction(type, stubSize, lookupStubOffset, GENERATED_FUNCTION_NAME,
+            &patchedCalls);
+    return GL_TRUE;
+}
@@ -0,0 +1,358 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+/*
+ * Measures how long a call takes through the EGL and GLX dispatch paths,
+ * which are separate from the GL dispatch stubs that benchgldispatch covers.
+ *
+ * The -a option picks the API, "egl" or "glx". Each path is timed by calling
+ * a function with a trivial implementation in the dummy vendor many times in
+ * a loop:
+ *
+ *   display      eglGetConfigAttrib, through libEGL's generated stub and
+ *                __eglDispatchFetchByDisplay.
+ *   current      eglWaitGL, through libEGL's generated stub and
+ *                __eglDispatchFetchByCurrent. Each thread has its own context
+ *                current.
+ *   ext_display  eglTestDispatchDisplay, through the vendor's dispatch stub,
+ *                getVendorFromDisplay, and __eglFetchDispatchEntry.
+ *   ext_device   eglTestDispatchDevice, the same but with getVendorFromDevice.
+ *   ext_current  eglTestDispatchCurrent, the same but with getCurrentVendor.
+ *   ext          glXExampleExtensionFunction, through the stub from
+ *                glXGetProcAddress, the vendor's dispatch stub, getDynDispatch,
+ *                and __glXFetchDispatchEntry.
+ *
+ * The GLX mode needs an X server, and prints a comment and exits without an
+ * error if it can't open a display.
+ *
+ * Each path runs with 1, 2, 4, and so on up to the -t thread count, with every
+ * thread making -n calls. The output has one line for each result, with
+ * comma-separated fields: the API, the path, the number of threads, the total
+ * calls per second, and the average wall-clock nanoseconds per call on each
+ * thread. Lines starting with '#' are comments.
+ */
+
+#include <X11/Xlib.h>
+#include <GL/glx.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "dummy/EGL_dummy.h"
+#include "dummy/GLX_dummy.h"
+#include "egl_test_utils.h"
+
+enum {
+    API_EGL,
+    API_GLX,
+    API_COUNT
+};
+
+static const char *API_NAMES[API_COUNT] = { "egl", "glx" };
+
+enum {
+    PATH_DISPLAY,
+    PATH_CURRENT,
+    PATH_EXT_DISPLAY,
+    PATH_EXT_DEVICE,
+    PATH_EXT_CURRENT,
+    PATH_GLX_EXT,
+    PATH_COUNT
+};
+
+static const struct {
+    const char *name;
+    int api;
+} PATHS[PATH_COUNT] = {
+    { "display", API_EGL },
+    { "current", API_EGL },
+    { "ext_display", API_EGL },
+    { "ext_device", API_EGL },
+    { "ext_current", API_EGL },
+    { "ext", API_GLX },
+};
+
+typedef struct BenchThreadRec {
+    pthread_t thread;
+    EGLContext context;
+    int path;
+    int success;
+} BenchThread;
+
+static int api = API_EGL;
+static int iterations = 1000000;
+static pthread_barrier_t startBarrier;
+
+static EGLDisplay eglDpy = EGL_NO_DISPLAY;
+static EGLDeviceEXT eglDevice = EGL_NO_DEVICE_EXT;
+static Display *xDpy = NULL;
+static PFNGLXEXAMPLEEXTENSIONFUNCTION ptr_glXExampleExtensionFunction;
+
+static uint64_t GetTimeNS(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t) ts.tv_sec) * 1000000000 + ((uint64_t) ts.tv_nsec);
+}
+
+/**
+ * Makes one call through the given path, and returns non-zero if it got as
+ * far as the vendor's implementation.
+ */
+static int CallPath(int path)
+{
+    EGLint value = 0;
+    int retval = 0;
+
+    switch (path) {
+    case PATH_DISPLAY:
+        // The dummy vendor returns EGL_FALSE without setting an error.
+        eglGetConfigAttrib(eglDpy, NULL, EGL_CONFIG_ID, &value);
+        return 1;
+    case PATH_CURRENT:
+        eglWaitGL();
+        return 1;
+    case PATH_EXT_DISPLAY:
+        return (ptr_eglTestDispatchDisplay(eglDpy,
+                    DUMMY_COMMAND_GET_VENDOR_NAME, 0) != NULL);
+    case PATH_EXT_DEVICE:
+        return (ptr_eglTestDispatchDevice(eglDevice,
+                    DUMMY_COMMAND_GET_VENDOR_NAME, 0) != NULL);
+    case PATH_EXT_CURRENT:
+        return (ptr_eglTestDispatchCurrent(DUMMY_COMMAND_GET_VENDOR_NAME, 0) != NULL);
+    case PATH_GLX_EXT:
+        ptr_glXExampleExtensionFunction(xDpy, DefaultScreen(xDpy), &retval);
+        return (retval == 1);
+    default:
+        return 0;
+    }
+}
+
+static void *BenchThreadProc(void *param)
+{
+    BenchThread *bt = (BenchThread *) param;
+    int i;
+
+    if (bt->context != EGL_NO_CONTEXT) {
+        if (!eglMakeCurrent(eglDpy, EGL_NO_SURFACE, EGL_NO_SURFACE, bt->context)) {
+            printf("eglMakeCurrent failed\n");
+        }
+    }
+
+    // Check the path once before the timed loop, so that a broken path fails
+    // instead of reporting a fast time.
+    bt->success = CallPath(bt->path);
+    if (!bt->success) {
+        printf("The %s path didn't reach the vendor\n", PATHS[bt->path].name);
+    }
+
+    pthread_barrier_wait(&startBarrier);
+    if (bt->success) {
+        for (i=0; i<iterations; i++) {
+            CallPath(bt->path);
+        }
+    }
+    pthread_barrier_wait(&startBarrier);
+
+    if (bt->context != EGL_NO_CONTEXT) {
+        eglMakeCurrent(eglDpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    }
+    return NULL;
+}
+
+static int RunPath(int path, int numThreads)
+{
+    BenchThread *threads;
+    uint64_t start, elapsed;
+    int success = 1;
+    int i;
+
+    threads = calloc(numThreads, sizeof(BenchThread));
+    if (threads == NULL) {
+        printf("Out of memory\n");
+        return 0;
+    }
+
+    for (i=0; i<numThreads; i++) {
+        threads[i].path = path;
+        threads[i].context = EGL_NO_CONTEXT;
+        if (path == PATH_CURRENT || path == PATH_EXT_CURRENT) {
+            threads[i].context = eglCreateContext(eglDpy, NULL, EGL_NO_CONTEXT, NULL);
+            if (threads[i].context == EGL_NO_CONTEXT) {
+                printf("eglCreateContext failed\n");
+                numThreads = i;
+                success = 0;
+                break;
+            }
+        }
+    }
+
+    if (success) {
+        // The main thread waits on the same barrier, so that the time only
+        // covers the call loops and not creating the threads.
+        pthread_barrier_init(&startBarrier, NULL, numThreads + 1);
+        for (i=0; i<numThreads; i++) {
+            pthread_create(&threads[i].thread, NULL, BenchThreadProc, &threads[i]);
+        }
+        pthread_barrier_wait(&startBarrier);
+        start = GetTimeNS();
+        pthread_barrier_wait(&startBarrier);
+        elapsed = GetTimeNS() - start;
+        for (i=0; i<numThreads; i++) {
+            pthread_join(threads[i].thread, NULL);
+            if (!threads[i].success) {
+                success = 0;
+            }
+        }
+        pthread_barrier_destroy(&startBarrier);
+    }
+
+    if (success) {
+        printf("%s,%s,%d,%.0f,%.3f\n", API_NAMES[api], PATHS[path].name,
+                numThreads,
+                ((double) numThreads) * iterations * 1000000000.0 / ((double) elapsed),
+                ((double) elapsed) / ((double) iterations));
+        fflush(stdout);
+    }
+
+    for (i=0; i<numThreads; i++) {
+        if (threads[i].context != EGL_NO_CONTEXT) {
+            eglDestroyContext(eglDpy, threads[i].context);
+        }
+    }
+    free(threads);
+    return success;
+}
+
+static int InitAPI(void)
+{
+    if (api == API_EGL) {
+        EGLint count = 0;
+
+        eglDpy = eglGetPlatformDisplay(EGL_DUMMY_PLATFORM,
+                (void *) DUMMY_VENDOR_NAMES[0], NULL);
+        if (eglDpy == EGL_NO_DISPLAY) {
+            printf("eglGetPlatformDisplay failed\n");
+            return -1;
+        }
+        loadEGLExtensions();
+        if (!ptr_eglQueryDevicesEXT(1, &eglDevice, &count) || count != 1) {
+            printf("eglQueryDevicesEXT failed\n");
+            return -1;
+        }
+        return 1;
+    }
+
+    XInitThreads();
+    xDpy = XOpenDisplay(NULL);
+    if (xDpy == NULL) {
+        printf("# No X display, skipping GLX\n");
+        return 0;
+    }
+    ptr_glXExampleExtensionFunction = (PFNGLXEXAMPLEEXTENSIONFUNCTION)
+        glXGetProcAddress((const GLubyte *) "glXExampleExtensionFunction");
+    if (ptr_glXExampleExtensionFunction == NULL) {
+        printf("Can't look up glXExampleExtensionFunction\n");
+        return -1;
+    }
+    return 1;
+}
+
+int main(int argc, char **argv)
+{
+    int maxThreads = 8;
+    int path, numThreads, ret;
+
+    while (1) {
+        int opt = getopt(argc, argv, "a:n:t:");
+        if (opt == -1) {
+            break;
+        }
+        switch (opt) {
+        case 'a':
+            for (api=0; api<API_COUNT; api++) {
+                if (strcmp(optarg, API_NAMES[api]) == 0) {
+                    break;
+                }
+            }
+            if (api == API_COUNT) {
+                printf("Unknown API: %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'n':
+            iterations = atoi(optarg);
+            break;
+        case 't':
+            maxThreads = atoi(optarg);
+            break;
+        default:
+            return 1;
+        }
+    }
+    if (iterations <= 0 || maxThreads <= 0) {
+        printf("Invalid iteration or thread count\n");
+        return 1;
+    }
+
+    ret = InitAPI();
+    if (ret <= 0) {
+        return (ret < 0 ? 1 : 0);
+    }
+
+    printf("# api,path,threads,calls_per_sec,ns_per_call (%d calls per thread)\n",
+            iterations);
+    for (path=0; path<PATH_COUNT; path++) {
+        if (PATHS[path].api != api) {
+            continue;
+        }
+        for (numThreads=1; ; numThreads *= 2) {
+            if (numThreads > maxThreads) {
+                numThreads = maxThreads;
+            }
+            if (!RunPath(path, numThreads)) {
+                return 1;
+            }
+            if (numThreads == maxThreads) {
+                break;
+            }
+        }
+    }
+
+    if (xDpy != NULL) {
+        XCloseDisplay(xDpy);
+    }
+    return 0;
+}
@@ -0,0 +1,10 @@
+#!/bin/sh
+
+# Runs benchwinsys for EGL and GLX. The GLX run is skipped if there's no X
+# display. The arguments are passed through.
+
+. $TOP_SRCDIR/tests/eglenv.sh
+. $TOP_SRCDIR/tests/glxenv.sh
+
+./benchwinsys -a egl "$@" || exit 1
+./benchwinsys -a glx "$@" || exit 1
@@ -36,6 +36,8 @@
 #include "glvnd_list.h"
 #include "glvnd_pthread.h"
 #include "compiler.h"
+#include "patchentrypoints.h"
+#include "dummycost.h"
 
 enum
 {
@@ -76,6 +78,11 @@ static glvnd_key_t threadStateKey;
 static struct glvnd_list displayList;
 static EGLint failNextMakeCurrentError = EGL_NONE;
 
+static unsigned long glCallCount = 0;
+static unsigned long bulkLookupCount = 0;
+static unsigned long bindAPICount = 0;
+static unsigned long getPlatformDisplayCount = 0;
+
 static EGLDEBUGPROCKHR debugCallbackFunc = NULL;
 static EGLBoolean debugCallbackEnabled = EGL_TRUE;
 
@@ -168,6 +175,7 @@ static EGLDisplay dummyGetPlatformDisplay(EGLenum platform, void *native_display
     CommonEntrypoint();
     DummyEGLDisplay *disp = NULL;
 
+    getPlatformDisplayCount++;
     if (platform == EGL_NONE) {
         if (native_display != EGL_DEFAULT_DISPLAY) {
             // If the native display is not EGL_DEFAULT_DISPLAY, then libEGL
@@ -269,6 +277,7 @@ static EGLContext EGLAPIENTRY dummy_eglCreateContext(EGLDisplay dpy,
 {
     DummyEGLContext *dctx;
     DummyEGLDisplay *disp;
+    int dispatchVariant = 0;
 
     CommonEntrypoint();
     disp = LookupEGLDisplay(dpy);
@@ -279,6 +288,8 @@ static EGLContext EGLAPIENTRY dummy_eglCreateContext(EGLDisplay dpy,
             if (attrib_list[i] == EGL_CREATE_CONTEXT_FAIL) {
                 SetLastError("eglCreateContext", disp->label, attrib_list[i + 1]);
                 return EGL_NO_CONTEXT;
+            } else if (attrib_list[i] == EGL_CREATE_CONTEXT_DISPATCH_VARIANT) {
+                dispatchVariant = attrib_list[i + 1];
             } else {
                 printf("Invalid attribute 0x%04x in eglCreateContext\n", attrib_list[i]);
                 abort();
@@ -288,6 +299,7 @@ static EGLContext EGLAPIENTRY dummy_eglCreateContext(EGLDisplay dpy,
 
     dctx = (DummyEGLContext *) calloc(1, sizeof(DummyEGLContext));
     dctx->vendorName = DUMMY_VENDOR_NAME;
+    dctx->dispatchVariant = dispatchVariant;
 
     return (EGLContext) dctx;
 }
@@ -373,6 +385,7 @@ static EGLBoolean EGLAPIENTRY dummy_eglMakeCurrent(EGLDisplay dpy, EGLSurface dr
 
     thr = GetThreadState();
     thr->currentContext = ctx;
+    dummyCostSpin(dummyCosts.makeCurrentNS);
 
     return EGL_TRUE;
 }
@@ -458,6 +471,7 @@ static EGLBoolean EGLAPIENTRY dummy_eglBindAPI(EGLenum api)
         printf("eglBindAPI called with invalid API 0x%04x\n", api);
         abort();
     }
+    bindAPICount++;
     return EGL_TRUE;
 }
 
@@ -559,6 +573,24 @@ static const GLubyte *dummy_glGetString(GLenum name)
     return NULL;
 }
 
+static const GLubyte *dummy_glGetString_variant(GLenum name)
+{
+    if (name == GL_RENDERER) {
+        return (const GLubyte *) DUMMY_VARIANT_RENDERER;
+    }
+    return dummy_glGetString(name);
+}
+
+/*
+ * Every function in the DUMMY_VARIANT_COUNT_CALLS dispatch table points here.
+ * The caller's arguments are ignored, and a non-void function returns
+ * whatever happens to be in the return register.
+ */
+static void dummy_glCountCall(void)
+{
+    glCallCount++;
+}
+
 static void *CommonTestDispatch(const char *funcName,
         EGLDisplay dpy, EGLDeviceEXT dev,
         EGLint command, EGLAttrib param)
@@ -578,6 +610,14 @@ static void *CommonTestDispatch(const char *funcName,
     } else if (command == DUMMY_COMMAND_FAIL_NEXT_MAKE_CURRENT) {
         failNextMakeCurrentError = (EGLint) param;
         return DUMMY_VENDOR_NAME;
+    } else if (command == DUMMY_COMMAND_GET_CALL_COUNT) {
+        return (void *) (uintptr_t) glCallCount;
+    } else if (command == DUMMY_COMMAND_GET_BULK_LOOKUP_COUNT) {
+        return (void *) (uintptr_t) bulkLookupCount;
+    } else if (command == DUMMY_COMMAND_GET_BIND_API_COUNT) {
+        return (void *) (uintptr_t) bindAPICount;
+    } else if (command == DUMMY_COMMAND_GET_PLATFORM_DISPLAY_COUNT) {
+        return (void *) (uintptr_t) getPlatformDisplayCount;
     } else {
         printf("Invalid command: %d\n", command);
         abort();
@@ -734,6 +774,9 @@ static const struct {
 static void *dummyGetProcAddress(const char *procName)
 {
     int i;
+
+    dummyCostSpin(dummyCosts.procAddressNS);
+
     for (i=0; PROC_ADDRESSES[i].name != NULL; i++) {
         if (strcmp(procName, PROC_ADDRESSES[i].name) == 0) {
             return PROC_ADDRESSES[i].addr;
@@ -745,7 +788,76 @@ static void *dummyGetProcAddress(const char *procName)
             return EGL_EXTENSION_PROCS[i].addr;
         }
     }
-    return NULL;
+    return dummyCostGetExtensionProc(procName);
+}
+
+static void dummyGetProcAddressBulk(const char * const *procNames,
+        void **procs, int count)
+{
+    int i;
+
+    bulkLookupCount++;
+    for (i=0; i<count; i++) {
+        procs[i] = dummyGetProcAddress(procNames[i]);
+    }
+}
+
+/*
+ * Hands over most of the core EGL functions directly. The rest, including
+ * eglQueryString and the extension functions, are left out so that libEGL
+ * still looks those up with getProcAddress.
+ */
+static void dummyGetStaticDispatch(__EGLdispatchTableStatic *table)
+{
+    table->initialize = dummy_eglInitialize;
+    table->chooseConfig = dummy_eglChooseConfig;
+    table->copyBuffers = dummy_eglCopyBuffers;
+    table->createContext = dummy_eglCreateContext;
+    table->createPbufferSurface = dummy_eglCreatePbufferSurface;
+    table->createPixmapSurface = dummy_eglCreatePixmapSurface;
+    table->createWindowSurface = dummy_eglCreateWindowSurface;
+    table->destroyContext = dummy_eglDestroyContext;
+    table->destroySurface = dummy_eglDestroySurface;
+    table->getConfigAttrib = dummy_eglGetConfigAttrib;
+    table->getConfigs = dummy_eglGetConfigs;
+    table->makeCurrent = dummy_eglMakeCurrent;
+    table->queryContext = dummy_eglQueryContext;
+    table->querySurface = dummy_eglQuerySurface;
+    table->swapBuffers = dummy_eglSwapBuffers;
+    table->terminate = dummy_eglTerminate;
+    table->waitGL = dummy_eglWaitGL;
+    table->waitNative = dummy_eglWaitNative;
+    table->bindTexImage = dummy_eglBindTexImage;
+    table->releaseTexImage = dummy_eglReleaseTexImage;
+    table->surfaceAttrib = dummy_eglSurfaceAttrib;
+    table->swapInterval = dummy_eglSwapInterval;
+    table->bindAPI = dummy_eglBindAPI;
+    table->createPbufferFromClientBuffer = dummy_eglCreatePbufferFromClientBuffer;
+    table->releaseThread = dummy_eglReleaseThread;
+    table->waitClient = dummy_eglWaitClient;
+    table->getError = dummy_eglGetError;
+    table->createPlatformWindowSurface = dummy_eglCreatePlatformWindowSurface;
+    table->createPlatformPixmapSurface = dummy_eglCreatePlatformPixmapSurface;
+}
+
+static int dummyGetContextDispatchVariant(EGLDisplay dpy, EGLContext ctx)
+{
+    DummyEGLContext *dctx = (DummyEGLContext *) ctx;
+    return dctx->dispatchVariant;
+}
+
+static void *dummyGetVariantProcAddress(int variant, const char *procName)
+{
+    if (variant == DUMMY_VARIANT_COUNT_CALLS) {
+        if (strncmp(procName, "gl", 2) == 0) {
+            return dummy_glCountCall;
+        }
+        return dummyGetProcAddress(procName);
+    }
+    if (strcmp(procName, "glGetString") == 0) {
+        return dummy_glGetString_variant;
+    }
+    return dummyGetProcAddress(procName);
 }
 
 static void *dummyFindDispatchFunction(const char *name)
@@ -769,6 +881,44 @@ static void dummySetDispatchIndex(const char *name, int index)
     }
 }
 
+static void dummySetDispatchIndexBulk(const char * const *names, int first, int count)
+{
+    int i;
+    for (i=0; i<count; i++) {
+        dummySetDispatchIndex(names[i], first + i);
+    }
+}
+
+/*
+ * The number of glVertex3fv calls that went through the patched entrypoint,
+ * with GLVND_TEST_PATCH_ENTRYPOINTS set.
+ */
+static int sawVertex3fv;
+
+static GLboolean dummyInitiatePatch(int type, int stubSize,
+        DispatchPatchLookupStubOffset lookupStubOffset)
+{
+    return dummyPatchFunction(type, stubSize, lookupStubOffset, "Vertex3fv",
+            &sawVertex3fv);
+}
+
+static EGLBoolean dummyDetachCurrent(void **vendorState)
+{
+    DummyThreadState *thr = GetThreadState();
+
+    *vendorState = thr->currentContext;
+    thr->currentContext = EGL_NO_CONTEXT;
+    return EGL_TRUE;
+}
+
+static EGLBoolean dummyAttachCurrent(void *vendorState)
+{
+    DummyThreadState *thr = GetThreadState();
+
+    thr->currentContext = (EGLContext) vendorState;
+    return EGL_TRUE;
+}
+
 static EGLBoolean dummyGetSupportsAPI(EGLenum api)
 {
     if (api == EGL_OPENGL_ES_API || api == EGL_OPENGL_API) {
@@ -797,6 +947,7 @@ __egl_Main(uint32_t version, const __EGLapiExports *exports,
     apiExports = exports;
     __glvndPthreadFuncs.key_create(&threadStateKey, OnThreadTerminate);
     glvnd_list_init(&displayList);
+    dummyCostInit();
 
     imports->getPlatformDisplay = dummyGetPlatformDisplay;
     imports->getSupportsAPI = dummyGetSupportsAPI;
@@ -804,6 +955,19 @@ __egl_Main(uint32_t version, const __EGLapiExports *exports,
     imports->getProcAddress = dummyGetProcAddress;
     imports->getDispatchAddress = dummyFindDispatchFunction;
     imports->setDispatchIndex = dummySetDispatchIndex;
+    imports->setDispatchIndexBulk = dummySetDispatchIndexBulk;
+    imports->getContextDispatchVariant = dummyGetContextDispatchVariant;
+    imports->getVariantProcAddress = dummyGetVariantProcAddress;
+    imports->getProcAddressBulk = dummyGetProcAddressBulk;
+    imports->detachCurrent = dummyDetachCurrent;
+    imports->attachCurrent = dummyAttachCurrent;
+    imports->getStaticDispatch = dummyGetStaticDispatch;
+
+    if (getenv("GLVND_TEST_PATCH_ENTRYPOINTS") != NULL
+            && atoi(getenv("GLVND_TEST_PATCH_ENTRYPOINTS")) != 0) {
+        imports->isPatchSupported = dummyCheckPatchSupported;
+        imports->initiatePatch = dummyInitiatePatch;
+    }
 
     return EGL_TRUE;
 }
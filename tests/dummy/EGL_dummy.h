@@ -80,11 +80,57 @@
  */
 #define EGL_CREATE_CONTEXT_FAIL 0x010001
 
+/**
+ * This attribute tells eglCreateContext which dispatch table variant to use
+ * for the new context. The vendor returns it from getContextDispatchVariant.
+ *
+ * Any variant other than zero uses a version of glGetString that returns
+ * \c DUMMY_VARIANT_RENDERER for GL_RENDERER, so the caller can check which
+ * dispatch table is current. The default glGetString returns NULL for it.
+ */
+#define EGL_CREATE_CONTEXT_DISPATCH_VARIANT 0x010002
+
+#define DUMMY_VARIANT_RENDERER "dummy variant"
+
+/**
+ * A dispatch table variant where every OpenGL function goes to the same stub,
+ * which just counts how many times it was called. This is used to benchmark
+ * the dispatch overhead by itself.
+ *
+ * The count isn't atomic, so it's only accurate with a single thread. This is
+ * the highest variant that libEGL allows, __EGL_DISPATCH_VARIANT_COUNT - 1.
+ */
+#define DUMMY_VARIANT_COUNT_CALLS 7
+
 enum
 {
     DUMMY_COMMAND_GET_VENDOR_NAME,
     DUMMY_COMMAND_GET_CURRENT_CONTEXT,
     DUMMY_COMMAND_FAIL_NEXT_MAKE_CURRENT,
+
+    /**
+     * Returns the number of calls to the \c DUMMY_VARIANT_COUNT_CALLS stub,
+     * cast to a pointer.
+     */
+    DUMMY_COMMAND_GET_CALL_COUNT,
+
+    /**
+     * Returns the number of times that libEGL called the vendor's
+     * getProcAddressBulk function, cast to a pointer.
+     */
+    DUMMY_COMMAND_GET_BULK_LOOKUP_COUNT,
+
+    /**
+     * Returns the number of times that libEGL called the vendor's eglBindAPI
+     * function, cast to a pointer.
+     */
+    DUMMY_COMMAND_GET_BIND_API_COUNT,
+
+    /**
+     * Returns the number of times that libEGL called the vendor's
+     * getPlatformDisplay function, cast to a pointer.
+     */
+    DUMMY_COMMAND_GET_PLATFORM_DISPLAY_COUNT,
 };
 
 /**
@@ -93,6 +139,7 @@ enum
  */
 typedef struct DummyEGLContextRec {
     const char *vendorName;
+    int dispatchVariant;
 } DummyEGLContext;
 
 /**
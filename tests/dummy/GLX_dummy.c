@@ -41,6 +41,7 @@
 #include "trace.h"
 #include "compiler.h"
 #include "patchentrypoints.h"
+#include "dummycost.h"
 
 
 static const __GLXapiExports *apiExports = NULL;
@@ -54,7 +55,18 @@ typedef struct __GLXcontextRec {
     GLint endHit;
 } __GLXcontext;
 
-static const int FBCONFIGS_PER_SCREEN = 10;
+/*
+ * The number of fake GLXFBConfigs on each screen. The
+ * GLVND_TEST_FBCONFIGS_PER_SCREEN environment variable can raise this, to
+ * test with lots of configs.
+ */
+static int fbconfigsPerScreen = 10;
+
+/*
+ * The number of times that glXGetFBConfigs or glXChooseFBConfig has been
+ * called. See GLX_FBCONFIG_ATTRIB_QUERY_COUNT_DUMMY.
+ */
+static int fbconfigQueryCount = 0;
 
 static GLXContext dummy_glXCreateContextVendorDUMMY(Display *dpy,
         GLXFBConfig config, GLXContext share_list, Bool direct,
@@ -67,6 +79,8 @@ static void dummy_glXExampleExtensionFunction(Display *dpy, int screen, int *ret
 static void dispatch_glXExampleExtensionFunction(Display *dpy, int screen, int *retval);
 static void dummy_glXExampleExtensionFunction2(Display *dpy, int screen, int *retval);
 static void dispatch_glXExampleExtensionFunction2(Display *dpy, int screen, int *retval);
+static void dummy_glXExampleExtensionFunction3(Display *dpy, int screen, int *retval);
+static void dispatch_glXExampleExtensionFunction3(Display *dpy, int screen, int *retval);
 static void dummy_glXMakeCurrentTestResults(GLint req, GLboolean *saw, void **ret);
 static void dispatch_glXMakeCurrentTestResults(GLint req, GLboolean *saw, void **ret);
 
@@ -74,6 +88,7 @@ enum
 {
     DI_glXExampleExtensionFunction,
     DI_glXExampleExtensionFunction2,
+    DI_glXExampleExtensionFunction3,
     DI_glXCreateContextVendorDUMMY,
     DI_glXMakeCurrentTestResults,
     DI_COUNT,
@@ -87,6 +102,7 @@ static struct {
 #define PROC_ENTRY(name) { #name, dummy_##name, dispatch_##name, -1 }
     PROC_ENTRY(glXExampleExtensionFunction),
     PROC_ENTRY(glXExampleExtensionFunction2),
+    PROC_ENTRY(glXExampleExtensionFunction3),
     PROC_ENTRY(glXCreateContextVendorDUMMY),
     PROC_ENTRY(glXMakeCurrentTestResults),
 #undef PROC_ENTRY
@@ -95,15 +111,15 @@ static struct {
 static GLXFBConfig GetFBConfigFromScreen(Display *dpy, int screen, int index)
 {
     // Pick an arbitrary base address.
-    uintptr_t baseConfig = (uintptr_t) &FBCONFIGS_PER_SCREEN;
-    baseConfig += (screen * FBCONFIGS_PER_SCREEN);
+    uintptr_t baseConfig = (uintptr_t) &fbconfigsPerScreen;
+    baseConfig += (screen * fbconfigsPerScreen);
     return (GLXFBConfig) (baseConfig + index);
 }
 
 static int GetScreenFromFBConfig(Display *dpy, GLXFBConfig config)
 {
-    uintptr_t screen = ((uintptr_t) config) - ((uintptr_t) &FBCONFIGS_PER_SCREEN);
-    screen = screen / FBCONFIGS_PER_SCREEN;
+    uintptr_t screen = ((uintptr_t) config) - ((uintptr_t) &fbconfigsPerScreen);
+    screen = screen / fbconfigsPerScreen;
     if (screen < (uintptr_t) ScreenCount(dpy)) {
         return (int) screen;
     } else {
@@ -297,6 +313,7 @@ static Bool          dummy_glXMakeCurrent           (Display *dpy,
                                               GLXContext ctx)
 {
     // This doesn't do anything, but fakes success
+    dummyCostSpin(dummyCosts.makeCurrentNS);
     return True;
 }
 
@@ -377,14 +394,16 @@ static GLXFBConfig*  dummy_glXGetFBConfigs          (Display *dpy,
     GLXFBConfig *configs = NULL;
     int i;
 
+    fbconfigQueryCount++;
+
     // Pick an arbitrary base address.
-    configs = malloc(sizeof(GLXFBConfig) * FBCONFIGS_PER_SCREEN);
+    configs = malloc(sizeof(GLXFBConfig) * fbconfigsPerScreen);
     if (configs != NULL) {
-        for (i=0; i<FBCONFIGS_PER_SCREEN; i++) {
+        for (i=0; i<fbconfigsPerScreen; i++) {
             configs[i] = GetFBConfigFromScreen(dpy, screen, i);
         }
     }
-    *nelements = FBCONFIGS_PER_SCREEN;
+    *nelements = fbconfigsPerScreen;
     return configs;
 }
 
@@ -442,6 +461,12 @@ static int           dummy_glXGetFBConfigAttrib     (Display *dpy,
                                                  int attribute,
                                                  int *value)
 {
+    if (attribute == GLX_FBCONFIG_ATTRIB_QUERY_COUNT_DUMMY) {
+        *value = fbconfigQueryCount;
+    } else if (attribute == GLX_FBCONFIG_ATTRIB_INVALIDATE_DUMMY) {
+        apiExports->invalidateFBConfigCache(dpy, GetScreenFromFBConfig(dpy, config));
+        *value = 1;
+    }
     return 0;
 }
 
@@ -467,6 +492,7 @@ static Bool          dummy_glXMakeContextCurrent    (Display *dpy, GLXDrawable d
                                               GLXDrawable read, GLXContext ctx)
 {
     // This doesn't do anything, but fakes success
+    dummyCostSpin(dummyCosts.makeCurrentNS);
     return True;
 }
 
@@ -619,6 +645,20 @@ static void dispatch_glXExampleExtensionFunction2(Display *dpy,
             DI_glXExampleExtensionFunction2);
 }
 
+static void dummy_glXExampleExtensionFunction3(Display *dpy, int screen, int *retval)
+{
+    *retval = 3;
+}
+
+static void dispatch_glXExampleExtensionFunction3(Display *dpy,
+                                                int screen,
+                                                int *retval)
+{
+    *retval = -3;
+    commonDispatch_glXExampleExtensionFunction(dpy, screen, retval,
+            DI_glXExampleExtensionFunction3);
+}
+
 /*
  * Note we only fill in real implementations for a few core GL functions.
  * The rest will dispatch to the NOP stub.
@@ -677,6 +717,8 @@ static void         *dummyGetProcAddress         (const GLubyte *procName)
 {
     int i;
 
+    dummyCostSpin(dummyCosts.procAddressNS);
+
     for (i = 0; i < ARRAY_LEN(procAddresses); i++) {
         if (!strcmp(procAddresses[i].name, (const char *)procName)) {
             return procAddresses[i].addr;
@@ -689,7 +731,7 @@ static void         *dummyGetProcAddress         (const GLubyte *procName)
         }
     }
 
-    return NULL;
+    return dummyCostGetExtensionProc((const char *) procName);
 }
 
 static void         *dummyGetDispatchAddress     (const GLubyte *procName)
@@ -713,6 +755,28 @@ static void         dummySetDispatchIndex      (const GLubyte *procName, int ind
     }
 }
 
+static void         dummySetDispatchIndexBulk  (const GLubyte * const *procNames,
+                                                int first, int count)
+{
+    int i;
+    for (i = 0; i<count; i++) {
+        dummySetDispatchIndex(procNames[i], first + i);
+    }
+}
+
+static const char * const *dummyGetDispatchProcNames(void)
+{
+    static const char * const names[] = {
+        "glXExampleExtensionFunction",
+        "glXExampleExtensionFunction2",
+        "glXExampleExtensionFunction3",
+        "glXCreateContextVendorDUMMY",
+        "glXMakeCurrentTestResults",
+        NULL
+    };
+    return names;
+}
+
 PUBLIC int __glXSawVertex3fv;
 
 static GLboolean dummyInitiatePatch(int type,
@@ -722,6 +786,11 @@ static GLboolean dummyInitiatePatch(int type,
     return dummyPatchFunction(type, stubSize, lookupStubOffset, "Vertex3fv", &__glXSawVertex3fv);
 }
 
+static Bool dummyIsFBConfigCacheable(Display *dpy, int screen)
+{
+    return True;
+}
+
 static Bool GetEnvFlag(const char *name)
 {
     const char *env = getenv(name);
@@ -744,17 +813,29 @@ PUBLIC Bool __glx_Main(uint32_t version,
         if (GLX_VENDOR_ABI_GET_MINOR_VERSION(version)
                 >= GLX_VENDOR_ABI_MINOR_VERSION) {
             apiExports = exports;
+            dummyCostInit();
 
             imports->isScreenSupported = dummyCheckSupportsScreen;
             imports->getProcAddress = dummyGetProcAddress;
             imports->getDispatchAddress = dummyGetDispatchAddress;
             imports->setDispatchIndex = dummySetDispatchIndex;
+            imports->setDispatchIndexBulk = dummySetDispatchIndexBulk;
+            imports->getDispatchProcNames = dummyGetDispatchProcNames;
+
+            if (getenv("GLVND_TEST_FBCONFIGS_PER_SCREEN") != NULL
+                    && atoi(getenv("GLVND_TEST_FBCONFIGS_PER_SCREEN")) > 0) {
+                fbconfigsPerScreen = atoi(getenv("GLVND_TEST_FBCONFIGS_PER_SCREEN"));
+            }
 
             if (GetEnvFlag("GLVND_TEST_PATCH_ENTRYPOINTS")) {
                 imports->isPatchSupported = dummyCheckPatchSupported;
                 imports->initiatePatch = dummyInitiatePatch;
             }
 
+            if (GetEnvFlag("GLVND_TEST_CACHE_FBCONFIGS")) {
+                imports->isFBConfigCacheable = dummyIsFBConfigCacheable;
+            }
+
             return True;
         }
     }
@@ -62,11 +62,28 @@ enum {
  */
 #define GLX_CONTEX_ATTRIB_DUMMY 0x10000
 
+/**
+ * Attributes to query using glXGetFBConfigAttrib, to test the config cache.
+ *
+ * For GLX_FBCONFIG_ATTRIB_QUERY_COUNT_DUMMY, the dummy vendor library returns
+ * the number of times that its glXGetFBConfigs or glXChooseFBConfig function
+ * has been called. Querying GLX_FBCONFIG_ATTRIB_INVALIDATE_DUMMY makes it
+ * invalidate libGLX's config cache for the config's screen.
+ *
+ * The dummy vendor only lets libGLX cache its configs if the
+ * GLVND_TEST_CACHE_FBCONFIGS environment variable is set.
+ */
+#define GLX_FBCONFIG_ATTRIB_QUERY_COUNT_DUMMY 0x10001
+#define GLX_FBCONFIG_ATTRIB_INVALIDATE_DUMMY 0x10002
+
 /**
  * glXExampleExtensionFunction(): Dummy GLX extension function.
  *
  * This function just assigns 1 to *retval. It's used to test dispatching
  * through a venodr-supplied dispatch function.
+ *
+ * glXExampleExtensionFunction2() and glXExampleExtensionFunction3() are the
+ * same, but assign 2 and 3 to *retval.
  */
 typedef void (* PFNGLXEXAMPLEEXTENSIONFUNCTION) (Display *dpy, int screen, int *retval);
 
@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+#include "GLdispatch_layer_dummy.h"
+
+#include <string.h>
+#include <GL/gl.h>
+
+#include "glvnd/GLdispatchLayerABI.h"
+#include "compiler.h"
+
+typedef void (* pfn_glVertex3fv) (const GLfloat *v);
+
+static const __GLdispatchLayerExports *layerExports = NULL;
+static int layerIndex = -1;
+static int vertexSlot = -1;
+static unsigned long vertexCallCount = 0;
+
+static void dummyLayer_glVertex3fv(const GLfloat *v)
+{
+    pfn_glVertex3fv next = (pfn_glVertex3fv)
+        layerExports->getNext(layerIndex, vertexSlot);
+
+    vertexCallCount++;
+    next(v);
+}
+
+static void *dummyLayerGetProcAddress(const char *procName, int slot, void *param)
+{
+    if (strcmp(procName, "glVertex3fv") == 0) {
+        vertexSlot = slot;
+        return dummyLayer_glVertex3fv;
+    }
+    return NULL;
+}
+
+PUBLIC unsigned long dummyLayerGetCallCount(void)
+{
+    return vertexCallCount;
+}
+
+PUBLIC GLboolean __glDispatchLayerMain(uint32_t version,
+        const __GLdispatchLayerExports *exports, int index,
+        __GLdispatchLayerImports *imports)
+{
+    if (GLDISPATCH_LAYER_ABI_GET_MAJOR_VERSION(version)
+            != GLDISPATCH_LAYER_ABI_MAJOR_VERSION) {
+        return GL_FALSE;
+    }
+
+    layerExports = exports;
+    layerIndex = index;
+    imports->getProcAddress = dummyLayerGetProcAddress;
+    imports->param = NULL;
+    return GL_TRUE;
+}
@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+/**
+ * \file
+ *
+ * A dispatch layer for the libGLdispatch tests.
+ *
+ * This intercepts glVertex3fv, counts each call, and then passes the call on
+ * to the vendor.
+ */
+
+#ifndef GLDISPATCH_LAYER_DUMMY_H
+#define GLDISPATCH_LAYER_DUMMY_H
+
+/**
+ * The name of the function that returns the number of glVertex3fv calls.
+ *
+ * A test should look this up with dlsym, using a handle from dlopen with
+ * RTLD_NOLOAD, so that it can tell whether libGLdispatch loaded the layer.
+ */
+#define DUMMY_LAYER_GET_CALL_COUNT_NAME "dummyLayerGetCallCount"
+
+/**
+ * The name of the layer library.
+ */
+#define DUMMY_LAYER_LIBRARY_NAME "libGLdispatch_layer_dummy.so"
+
+typedef unsigned long (* PFNDUMMYLAYERGETCALLCOUNTPROC) (void);
+
+#endif // GLDISPATCH_LAYER_DUMMY_H
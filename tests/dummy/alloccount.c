@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+#include <stddef.h>
+#include <errno.h>
+
+#include "compiler.h"
+#include "alloccount.h"
+
+/*
+ * These are glibc's own allocation functions. Calling them directly instead
+ * of looking up the next malloc with dlsym avoids recursing when dlsym
+ * itself allocates memory.
+ */
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void *__libc_memalign(size_t alignment, size_t size);
+extern void __libc_free(void *ptr);
+
+static unsigned long allocCount = 0;
+
+PUBLIC unsigned long allocCountGet(void)
+{
+    return __sync_fetch_and_add(&allocCount, 0);
+}
+
+PUBLIC void *malloc(size_t size)
+{
+    __sync_fetch_and_add(&allocCount, 1);
+    return __libc_malloc(size);
+}
+
+PUBLIC void *calloc(size_t nmemb, size_t size)
+{
+    __sync_fetch_and_add(&allocCount, 1);
+    return __libc_calloc(nmemb, size);
+}
+
+PUBLIC void *realloc(void *ptr, size_t size)
+{
+    __sync_fetch_and_add(&allocCount, 1);
+    return __libc_realloc(ptr, size);
+}
+
+PUBLIC void *memalign(size_t alignment, size_t size)
+{
+    __sync_fetch_and_add(&allocCount, 1);
+    return __libc_memalign(alignment, size);
+}
+
+PUBLIC void *aligned_alloc(size_t alignment, size_t size)
+{
+    __sync_fetch_and_add(&allocCount, 1);
+    return __libc_memalign(alignment, size);
+}
+
+PUBLIC int posix_memalign(void **memptr, size_t alignment, size_t size)
+{
+    void *ptr;
+
+    if (alignment == 0 || (alignment & (alignment - 1)) != 0
+            || alignment % sizeof(void *) != 0) {
+        return EINVAL;
+    }
+
+    __sync_fetch_and_add(&allocCount, 1);
+    ptr = __libc_memalign(alignment, size);
+    if (ptr == NULL) {
+        return ENOMEM;
+    }
+    *memptr = ptr;
+    return 0;
+}
+
+PUBLIC void free(void *ptr)
+{
+    __libc_free(ptr);
+}
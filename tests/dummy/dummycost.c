@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+#include "dummycost.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+DummyCosts dummyCosts;
+
+static long GetEnvLong(const char *name)
+{
+    const char *env = getenv(name);
+    long value = (env != NULL ? atol(env) : 0);
+    return (value > 0 ? value : 0);
+}
+
+static void dummyExtensionProc(void)
+{
+    // nop
+}
+
+void dummyCostSpin(long ns)
+{
+    struct timespec start, now;
+    long elapsed;
+
+    if (ns <= 0) {
+        return;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    do {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        elapsed = (now.tv_sec - start.tv_sec) * 1000000000L
+            + (now.tv_nsec - start.tv_nsec);
+    } while (elapsed < ns);
+}
+
+void dummyCostInit(void)
+{
+    dummyCosts.initNS = GetEnvLong("GLVND_TEST_DUMMY_INIT_US") * 1000;
+    dummyCosts.procAddressNS = GetEnvLong("GLVND_TEST_DUMMY_PROC_ADDRESS_NS");
+    dummyCosts.makeCurrentNS = GetEnvLong("GLVND_TEST_DUMMY_MAKE_CURRENT_NS");
+    dummyCosts.extensionProcCount = (int) GetEnvLong("GLVND_TEST_DUMMY_EXTENSION_PROCS");
+
+    dummyCostSpin(dummyCosts.initNS);
+}
+
+void *dummyCostGetExtensionProc(const char *procName)
+{
+    const size_t prefixLen = sizeof(DUMMY_EXTENSION_PROC_PREFIX) - 1;
+    const char *digits;
+    char *end;
+    long index;
+
+    if (dummyCosts.extensionProcCount <= 0
+            || strncmp(procName, DUMMY_EXTENSION_PROC_PREFIX, prefixLen) != 0) {
+        return NULL;
+    }
+
+    digits = procName + prefixLen;
+    if (digits[0] < '0' || digits[0] > '9'
+            || (digits[0] == '0' && digits[1] != '\0')) {
+        return NULL;
+    }
+    index = strtol(digits, &end, 10);
+    if (*end != '\0' || index >= dummyCosts.extensionProcCount) {
+        return NULL;
+    }
+    return (void *) dummyExtensionProc;
+}
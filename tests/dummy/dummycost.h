@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+/**
+ * \file
+ *
+ * Configurable costs for the EGL and GLX dummy vendor libraries.
+ *
+ * The dummy vendors normally return right away from everything, which is
+ * what the tests want, but it makes benchmarks look better than they would
+ * with a real driver. These environment variables add some work back in:
+ *
+ *   GLVND_TEST_DUMMY_INIT_US           Time to spend in __glx_Main or
+ *                                      __egl_Main, in microseconds, like a
+ *                                      driver's library initialization.
+ *   GLVND_TEST_DUMMY_PROC_ADDRESS_NS   Time to spend in each getProcAddress
+ *                                      call, in nanoseconds.
+ *   GLVND_TEST_DUMMY_MAKE_CURRENT_NS   Time to spend in each make current
+ *                                      call, in nanoseconds.
+ *   GLVND_TEST_DUMMY_EXTENSION_PROCS   The number of extra GL functions that
+ *                                      the vendor supports. They're named
+ *                                      glDummyExtensionProc0,
+ *                                      glDummyExtensionProc1, and so on.
+ *
+ * The delays spin instead of sleeping, since a driver is usually busy during
+ * these calls, and a sleep can't get anywhere near nanosecond precision.
+ */
+
+#ifndef DUMMYCOST_H
+#define DUMMYCOST_H
+
+#define DUMMY_EXTENSION_PROC_PREFIX "glDummyExtensionProc"
+
+typedef struct DummyCostsRec {
+    long initNS;
+    long procAddressNS;
+    long makeCurrentNS;
+    int extensionProcCount;
+} DummyCosts;
+
+/**
+ * The costs from the environment. These are all zero until
+ * \c dummyCostInit is called.
+ */
+extern DummyCosts dummyCosts;
+
+/**
+ * Reads the environment variables, and then spends the time in
+ * \c GLVND_TEST_DUMMY_INIT_US. This is called from __glx_Main and __egl_Main.
+ */
+void dummyCostInit(void);
+
+/**
+ * Spins for \p ns nanoseconds.
+ */
+void dummyCostSpin(long ns);
+
+/**
+ * Returns one of the functions from \c GLVND_TEST_DUMMY_EXTENSION_PROCS, or
+ * NULL if \p procName isn't one of them.
+ */
+void *dummyCostGetExtensionProc(const char *procName);
+
+#endif // DUMMYCOST_H
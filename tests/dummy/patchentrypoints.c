@@ -43,11 +43,11 @@ static void patch_x86_64(char *writeEntry, const char *execEntry,
     // here uses a 64-bit address. Cast incrementPtr to a 64-bit integer so
     // that it's the right size for either build.
     uint64_t incrementAddr = (uint64_t) ((uintptr_t) incrementPtr);
+    // This has to fit in the 16-byte stubs from --enable-compact-tls-stubs.
     const char tmpl[] = {
-        0xa1, 0xf0, 0xde, 0xbc, 0x9a, 0x78, 0x56, 0x34, 0x12, // movabs 0x123456789abcdef0, %eax
-        0x83, 0xc0, 0x01,                                     // add    $0x1,%eax
-        0xa3, 0xf0, 0xde, 0xbc, 0x9a, 0x78, 0x56, 0x34, 0x12, // movabs %eax,0x123456789abcdef0
-        0xc3,                                                 // ret
+        0x48, 0xb8, 0xf0, 0xde, 0xbc, 0x9a, 0x78, 0x56, 0x34, 0x12, // movabs $0x123456789abcdef0, %rax
+        0xff, 0x00,                                                 // incl   (%rax)
+        0xc3,                                                       // ret
     };
 
     if (stubSize < sizeof(tmpl)) {
@@ -55,8 +55,7 @@ static void patch_x86_64(char *writeEntry, const char *execEntry,
     }
 
     memcpy(writeEntry, tmpl, sizeof(tmpl));
-    memcpy(writeEntry + 1, &incrementAddr, sizeof(incrementAddr));
-    memcpy(writeEntry + 13, &incrementAddr, sizeof(incrementAddr));
+    memcpy(writeEntry + 2, &incrementAddr, sizeof(incrementAddr));
 
 #else
     assert(0); // Should not be calling this
@@ -130,6 +129,35 @@ static void patch_armv7_thumb(char *writeEntry, const char *execEntry,
 #endif
 }
 
+static void patch_armv7_arm(char *writeEntry, const char *execEntry,
+        int stubSize, void *incrementPtr)
+{
+#if defined(__arm__)
+    const uint32_t tmpl[] = {
+        0xe59f000c,     // ldr r0, 1f
+        0xe5901000,     // ldr r1, [r0]
+        0xe2811001,     // add r1, r1, #1
+        0xe5801000,     // str r1, [r0]
+        0xe12fff1e,     // bx lr
+        // 1:
+        0x00000000,
+    };
+
+    static const int offsetAddr = sizeof(tmpl) - 4;
+
+    if (stubSize < sizeof(tmpl)) {
+        return;
+    }
+
+    memcpy(writeEntry, tmpl, sizeof(tmpl));
+    *((uint32_t *)(writeEntry + offsetAddr)) = (uint32_t)incrementPtr;
+
+    __builtin___clear_cache((char *) execEntry, (char *) (execEntry + sizeof(tmpl)));
+#else
+    assert(0); // Should not be calling this
+#endif
+}
+
 static void patch_aarch64(char *writeEntry, const char *execEntry,
         int stubSize, void *incrementPtr)
 {
@@ -164,6 +192,78 @@ static void patch_aarch64(char *writeEntry, const char *execEntry,
 #endif
 }
 
+static void patch_riscv64(char *writeEntry, const char *execEntry,
+        int stubSize, void *incrementPtr)
+{
+#if defined(__riscv) && (__riscv_xlen == 64)
+    const uint32_t tmpl[] = {
+        // auipc t0, 0
+        0x00000297,
+        // ld t0, 24(t0)
+        0x0182b283,
+        // lw t1, 0(t0)
+        0x0002a303,
+        // addi t1, t1, 1
+        0x00130313,
+        // sw t1, 0(t0)
+        0x0062a023,
+        // ret
+        0x00008067,
+        // 24:
+        0x00000000, 0x00000000,
+    };
+
+    static const int offsetAddr = sizeof(tmpl) - 8;
+
+    if (stubSize < sizeof(tmpl)) {
+        return;
+    }
+
+    memcpy(writeEntry, tmpl, sizeof(tmpl));
+    *((uint64_t *)(writeEntry + offsetAddr)) = (uint64_t) incrementPtr;
+
+    __builtin___clear_cache((char *) execEntry, (char *) (execEntry + sizeof(tmpl)));
+#else
+    assert(0); // Should not be calling this
+#endif
+}
+
+static void patch_loongarch64(char *writeEntry, const char *execEntry,
+        int stubSize, void *incrementPtr)
+{
+#if defined(__loongarch64)
+    const uint32_t tmpl[] = {
+        // pcaddi $t0, 0
+        0x1800000c,
+        // ld.d $t0, $t0, 24
+        0x28c0618c,
+        // ld.w $t1, $t0, 0
+        0x2880018d,
+        // addi.w $t1, $t1, 1
+        0x028005ad,
+        // st.w $t1, $t0, 0
+        0x2980018d,
+        // jr $ra
+        0x4c000020,
+        // 24:
+        0x00000000, 0x00000000,
+    };
+
+    static const int offsetAddr = sizeof(tmpl) - 8;
+
+    if (stubSize < sizeof(tmpl)) {
+        return;
+    }
+
+    memcpy(writeEntry, tmpl, sizeof(tmpl));
+    *((uint64_t *)(writeEntry + offsetAddr)) = (uint64_t) incrementPtr;
+
+    __builtin___clear_cache((char *) execEntry, (char *) (execEntry + sizeof(tmpl)));
+#else
+    assert(0); // Should not be calling this
+#endif
+}
+
 static void patch_ppc64(char *writeEntry, const char *execEntry,
         int stubSize, void *incrementPtr)
 {
@@ -218,9 +318,12 @@ GLboolean dummyCheckPatchSupported(int type, int stubSize)
         case __GLDISPATCH_STUB_X86_64:
         case __GLDISPATCH_STUB_X86:
         case __GLDISPATCH_STUB_ARMV7_THUMB:
+        case __GLDISPATCH_STUB_ARMV7_ARM:
         case __GLDISPATCH_STUB_AARCH64:
         case __GLDISPATCH_STUB_X32:
         case __GLDISPATCH_STUB_PPC64:
+        case __GLDISPATCH_STUB_RISCV64:
+        case __GLDISPATCH_STUB_LOONGARCH64:
             return GL_TRUE;
         default:
             return GL_FALSE;
@@ -250,12 +353,21 @@ GLboolean dummyPatchFunction(int type, int stubSize,
             case __GLDISPATCH_STUB_ARMV7_THUMB:
                 patch_armv7_thumb(writeAddr, execAddr, stubSize, incrementPtr);
                 break;
+            case __GLDISPATCH_STUB_ARMV7_ARM:
+                patch_armv7_arm(writeAddr, execAddr, stubSize, incrementPtr);
+                break;
             case __GLDISPATCH_STUB_AARCH64:
                 patch_aarch64(writeAddr, execAddr, stubSize, incrementPtr);
                 break;
             case __GLDISPATCH_STUB_PPC64:
                 patch_ppc64(writeAddr, execAddr, stubSize, incrementPtr);
                 break;
+            case __GLDISPATCH_STUB_RISCV64:
+                patch_riscv64(writeAddr, execAddr, stubSize, incrementPtr);
+                break;
+            case __GLDISPATCH_STUB_LOONGARCH64:
+                patch_loongarch64(writeAddr, execAddr, stubSize, incrementPtr);
+                break;
             default:
                 assert(0);
         }
@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+/**
+ * \file
+ *
+ * Checks that the steady-state paths in libEGL, libGLX, and libGLdispatch
+ * don't allocate any memory.
+ *
+ * This has to run with liballoccount in LD_PRELOAD. Each test calls a
+ * function once to let it fill in any caches, and then makes sure that
+ * repeated calls don't call malloc, calloc, realloc, or any of the aligned
+ * allocation functions.
+ */
+
+#include <EGL/egl.h>
+#include <GL/glx.h>
+#include <dlfcn.h>
+#include <stdio.h>
+
+#include "dummy/alloccount.h"
+#include "egl_test_utils.h"
+
+#define ITERATIONS 1000
+
+typedef void (* TestFunc) (void);
+
+static PFNALLOCCOUNTGETPROC ptr_allocCountGet;
+static EGLDisplay dpy = EGL_NO_DISPLAY;
+static EGLContext ctx = EGL_NO_CONTEXT;
+
+static void testEGLMakeCurrent(void)
+{
+    eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, ctx);
+}
+
+static void testEGLMakeCurrentRelease(void)
+{
+    eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, ctx);
+    eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+}
+
+static void testEGLGetError(void)
+{
+    eglGetError();
+}
+
+static void testGLXGetProcAddress(void)
+{
+    glXGetProcAddress((const GLubyte *) "glVertex3fv");
+}
+
+static void testGLXGetCurrentContext(void)
+{
+    glXGetCurrentContext();
+}
+
+static int checkNoAllocs(const char *name, TestFunc func)
+{
+    unsigned long before, after;
+    int i;
+
+    func();
+
+    before = ptr_allocCountGet();
+    for (i=0; i<ITERATIONS; i++) {
+        func();
+    }
+    after = ptr_allocCountGet();
+
+    if (after != before) {
+        printf("%s: %lu allocations in %d calls\n", name, after - before, ITERATIONS);
+        return 0;
+    }
+    printf("%s: no allocations\n", name);
+    return 1;
+}
+
+int main(int argc, char **argv)
+{
+    int success = 1;
+
+    ptr_allocCountGet = (PFNALLOCCOUNTGETPROC) dlsym(RTLD_DEFAULT, ALLOC_COUNT_GET_NAME);
+    if (ptr_allocCountGet == NULL) {
+        printf("liballoccount is not loaded\n");
+        return 1;
+    }
+
+    dpy = eglGetPlatformDisplay(EGL_DUMMY_PLATFORM,
+            (void *) DUMMY_VENDOR_NAMES[0], NULL);
+    if (dpy == EGL_NO_DISPLAY) {
+        printf("eglGetPlatformDisplay failed\n");
+        return 1;
+    }
+    ctx = eglCreateContext(dpy, NULL, EGL_NO_CONTEXT, NULL);
+    if (ctx == EGL_NO_CONTEXT) {
+        printf("eglCreateContext failed\n");
+        return 1;
+    }
+
+    success &= checkNoAllocs("eglMakeCurrent", testEGLMakeCurrent);
+    success &= checkNoAllocs("eglMakeCurrent/release", testEGLMakeCurrentRelease);
+    success &= checkNoAllocs("eglGetError", testEGLGetError);
+    success &= checkNoAllocs("glXGetProcAddress", testGLXGetProcAddress);
+    success &= checkNoAllocs("glXGetCurrentContext", testGLXGetCurrentContext);
+
+    eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglDestroyContext(dpy, ctx);
+
+    return (success ? 0 : 1);
+}
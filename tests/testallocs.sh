@@ -0,0 +1,14 @@
+#!/bin/sh
+
+. $TOP_SRCDIR/tests/eglenv.sh
+
+LD_PRELOAD=$TOP_BUILDDIR/tests/dummy/.libs/liballoccount.so ./testallocs || exit 1
+
+# Run it again with lock profiling. After the first eglMakeCurrent, binding and
+# releasing the context should reuse the thread's cached state without taking
+# the state list lock.
+rm -f ./testallocs.locks.*
+LD_PRELOAD=$TOP_BUILDDIR/tests/dummy/.libs/liballoccount.so \
+    __GLVND_LOCK_STATS=./testallocs.locks ./testallocs || exit 1
+grep -q "^EGL:currentStateListMutex,1," ./testallocs.locks.* || exit 1
+rm -f ./testallocs.locks.*
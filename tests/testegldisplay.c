@@ -46,6 +46,52 @@
 #include "dummy/EGL_dummy.h"
 #include "egl_test_utils.h"
 
+static uintptr_t getPlatformDisplayCount(EGLDisplay dpy)
+{
+    return (uintptr_t) ptr_eglTestDispatchDisplay(dpy,
+            DUMMY_COMMAND_GET_PLATFORM_DISPLAY_COUNT, 0);
+}
+
+/**
+ * Calls eglGetPlatformDisplay with the same arguments as before, and makes
+ * sure that libEGL returns the same display without asking the vendor again.
+ * A different attribute list still has to go to the vendor.
+ */
+static void testDisplayCache(EGLDisplay expected, const char *name)
+{
+    // The dummy vendor ignores the attributes, so any attribute will do.
+    const EGLAttrib attribs[] = { EGL_DUMMY_PLATFORM, 1, EGL_NONE };
+    uintptr_t count = getPlatformDisplayCount(expected);
+    EGLDisplay dpy;
+
+    dpy = eglGetPlatformDisplay(EGL_DUMMY_PLATFORM, (void *) name, NULL);
+    if (dpy != expected) {
+        printf("eglGetPlatformDisplay returned %p, expected %p\n", dpy, expected);
+        exit(1);
+    }
+    if (getPlatformDisplayCount(expected) != count) {
+        printf("eglGetPlatformDisplay called into the vendor again\n");
+        exit(1);
+    }
+
+    dpy = eglGetPlatformDisplay(EGL_DUMMY_PLATFORM, (void *) name, attribs);
+    if (dpy != expected) {
+        printf("eglGetPlatformDisplay returned %p, expected %p\n", dpy, expected);
+        exit(1);
+    }
+    if (getPlatformDisplayCount(expected) == count) {
+        printf("eglGetPlatformDisplay didn't call the vendor for new attributes\n");
+        exit(1);
+    }
+    count = getPlatformDisplayCount(expected);
+
+    dpy = eglGetPlatformDisplay(EGL_DUMMY_PLATFORM, (void *) name, attribs);
+    if (dpy != expected || getPlatformDisplayCount(expected) != count) {
+        printf("eglGetPlatformDisplay didn't cache a display with attributes\n");
+        exit(1);
+    }
+}
+
 int main(int argc, char **argv)
 {
     EGLDisplay displays[DUMMY_VENDOR_COUNT];
@@ -53,6 +99,8 @@ int main(int argc, char **argv)
     EGLint error;
     int i;
 
+    loadEGLExtensions();
+
     for (i=0; i<DUMMY_VENDOR_COUNT; i++) {
         const char *name = DUMMY_VENDOR_NAMES[i];
         const char *str;
@@ -83,6 +131,9 @@ int main(int argc, char **argv)
         }
     }
 
+    testDisplayCache(displays[DUMMY_VENDOR_COUNT - 1],
+            DUMMY_VENDOR_NAMES[DUMMY_VENDOR_COUNT - 1]);
+
     // Test getting a default display from eglGetDisplay. This should iterate
     // over each vendor, and the first vendor library should return the same
     // display as it did for EGL_DUMMY_PLATFORM.
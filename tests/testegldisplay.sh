@@ -2,4 +2,28 @@
 
 . $TOP_SRCDIR/tests/eglenv.sh
 
-./testegldisplay
+./testegldisplay || exit 1
+
+# Run it again, reading the vendor config files on worker threads.
+__EGL_VENDOR_LIBRARY_PREFETCH=1 ./testegldisplay || exit 1
+
+# Run it again, with the first vendor listing its platforms, so that it doesn't
+# get loaded until the test asks for a display on EGL_DUMMY_PLATFORM. It should
+# still end up ahead of the second vendor.
+__EGL_VENDOR_LIBRARY_FILENAMES=$TOP_SRCDIR/tests/json_platforms/egldummy0.json:$TOP_SRCDIR/tests/json/20_egldummy1.json \
+    ./testegldisplay || exit 1
+
+# Run it again, with the second vendor asking to be tried first for
+# EGL_DUMMY_PLATFORM. Each display should still go to the vendor that it names,
+# and EGL_DEFAULT_DISPLAY should still go to the first vendor.
+__EGL_VENDOR_LIBRARY_FILENAMES=$TOP_SRCDIR/tests/json/10_egldummy0.json:$TOP_SRCDIR/tests/json_platforms/egldummy1.json \
+    ./testegldisplay || exit 1
+
+# Run it twice with the vendor config cache: once to write the cache, and once
+# to read it back.
+__EGL_VENDOR_CONFIG_CACHE=./testegldisplay.cache
+export __EGL_VENDOR_CONFIG_CACHE
+rm -f $__EGL_VENDOR_CONFIG_CACHE
+./testegldisplay || exit 1
+./testegldisplay || exit 1
+rm -f $__EGL_VENDOR_CONFIG_CACHE
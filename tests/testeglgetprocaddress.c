@@ -34,11 +34,13 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "glvnd/glvnd.h"
 #include "dummy/EGL_dummy.h"
 #include "egl_test_utils.h"
 
 static __eglMustCastToProperFunctionPointerType checkEGLFunction(const char *name);
 static void checkResult(const char *func, const char *result);
+static void checkBulkLookup(void);
 
 int main(int argc, char **argv)
 {
@@ -73,6 +75,13 @@ int main(int argc, char **argv)
         printf("Got a pointer to a non-existant EGL function.\n");
         return 1;
     }
+    // The second lookup should come from the cache of missing functions.
+    if (eglGetProcAddress("eglNonExistantFunction") != NULL) {
+        printf("Got a pointer to a non-existant EGL function from the cache.\n");
+        return 1;
+    }
+
+    checkBulkLookup();
 
     // Test a built-in EGL function.
     result = ptr_eglQueryString(dpy, EGL_VENDOR);
@@ -138,3 +147,47 @@ static __eglMustCastToProperFunctionPointerType checkEGLFunction(const char *nam
 
     return func;
 }
+
+static void checkBulkLookup(void)
+{
+    // A mix of libEGL functions, vendor-provided EGL functions, static and
+    // dynamic GL functions, and functions that don't exist. Whether the
+    // dynamic one is found depends on whether libGLdispatch can generate
+    // stubs, so just make sure that the results all match eglGetProcAddress.
+    static const char * const NAMES[] = {
+        "eglQueryString",
+        "glBulkLookupTestGLVND",
+        "eglTestDispatchDisplay",
+        "eglNonExistantFunction",
+        "glGetString",
+        "glVertex3fv",
+        "notAFunction",
+    };
+    const int numNames = sizeof(NAMES) / sizeof(NAMES[0]);
+    GLVNDproc procs[sizeof(NAMES) / sizeof(NAMES[0])];
+    int expectedCount = 0;
+    int count;
+    int i;
+
+    count = eglGetProcAddressesGLVND(NAMES, procs, numNames);
+
+    for (i=0; i<numNames; i++) {
+        if (procs[i] != eglGetProcAddress(NAMES[i])) {
+            printf("Got different address for \"%s\" from eglGetProcAddressesGLVND\n",
+                    NAMES[i]);
+            exit(1);
+        }
+        if (procs[i] != NULL) {
+            expectedCount++;
+        }
+    }
+    if (procs[0] == NULL || procs[2] == NULL || procs[4] == NULL) {
+        printf("eglGetProcAddressesGLVND didn't find a required function\n");
+        exit(1);
+    }
+    if (count != expectedCount) {
+        printf("eglGetProcAddressesGLVND found %d functions, expected %d\n",
+                count, expectedCount);
+        exit(1);
+    }
+}
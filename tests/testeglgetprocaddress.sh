@@ -2,4 +2,18 @@
 
 . $TOP_SRCDIR/tests/eglenv.sh
 
-./testeglgetprocaddress
+./testeglgetprocaddress || exit 1
+
+# Run it again, looking up the vendors' dispatch functions on demand instead
+# of when each vendor is loaded.
+__EGL_LAZY_DISPATCH=1 ./testeglgetprocaddress || exit 1
+
+# Run it with __GLVND_PERF_MAP set, and make sure that the dynamic stub that
+# it generates gets a line in perf's map file. The shell prints its PID and
+# then execs the test, so that's the PID in the file name.
+PERF_MAP_PID=$(__GLVND_PERF_MAP=1 sh -c 'echo $$; exec ./testeglgetprocaddress >&2') || exit 1
+PERF_MAP=/tmp/perf-$PERF_MAP_PID.map
+grep -q "^[0-9a-f]* [0-9a-f]* glBulkLookupTestGLVND\$" $PERF_MAP
+STATUS=$?
+rm -f $PERF_MAP
+exit $STATUS
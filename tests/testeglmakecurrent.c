@@ -34,35 +34,65 @@
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include <pthread.h>
 
+#include "glvnd/glvnd.h"
 #include "dummy/EGL_dummy.h"
 #include "egl_test_utils.h"
 #include "utils_misc.h"
+#include "GLdispatch.h"
 
 typedef struct {
     const char *vendorName;
     EGLDisplay dpy;
     EGLContext ctx;
+    int dispatchVariant;
 } TestContextInfo;
 
+/// The handle from __glDispatchDetachCurrent, for testMigrate.
+static void *migrateState;
+
 void checkIsCurrent(const TestContextInfo *ci);
 void testSwitchContext(const TestContextInfo *oldCi, const TestContextInfo *ci);
 void testSwitchContextFail(const TestContextInfo *oldCi,
         const TestContextInfo *newCi, const TestContextInfo *failCi);
+void testMigrate(const TestContextInfo *ci);
+void testPushPop(const TestContextInfo *oldCi, const TestContextInfo *newCi);
+void testBindAPI(EGLDisplay dpy, EGLDisplay otherDpy);
+void testErrorCheckRestore(void);
 
 int main(int argc, char **argv)
 {
-    TestContextInfo contexts[3];
+    TestContextInfo contexts[4];
     int i;
 
+    if (argc > 1 && strcmp(argv[1], "-p") == 0) {
+        // Load the vendors and fill in their dispatch tables up front, the
+        // way a server would before it forks. Everything below should still
+        // work the same way.
+        if (!eglPreinitializeGLVND(GLVND_PREINIT_ALL)) {
+            printf("eglPreinitializeGLVND failed\n");
+            return 1;
+        }
+    }
+
     loadEGLExtensions();
 
     contexts[0].vendorName = DUMMY_VENDOR_NAMES[0];
     contexts[1].vendorName = DUMMY_VENDOR_NAMES[0];
     contexts[2].vendorName = DUMMY_VENDOR_NAMES[1];
+    contexts[3].vendorName = DUMMY_VENDOR_NAMES[0];
+    for (i=0; i<ARRAY_LEN(contexts); i++) {
+        contexts[i].dispatchVariant = 0;
+    }
+    contexts[3].dispatchVariant = 1;
 
     for (i=0; i<ARRAY_LEN(contexts); i++) {
         DummyEGLContext *dctx;
+        const EGLint attribs[] = {
+            EGL_CREATE_CONTEXT_DISPATCH_VARIANT, contexts[i].dispatchVariant,
+            EGL_NONE
+        };
 
         contexts[i].dpy = eglGetPlatformDisplay(EGL_DUMMY_PLATFORM,
                 (void *) contexts[i].vendorName, NULL);
@@ -71,7 +101,7 @@ int main(int argc, char **argv)
             return 1;
         }
 
-        contexts[i].ctx = eglCreateContext(contexts[i].dpy, NULL, EGL_NO_CONTEXT, NULL);
+        contexts[i].ctx = eglCreateContext(contexts[i].dpy, NULL, EGL_NO_CONTEXT, attribs);
         if (contexts[i].ctx == EGL_NO_CONTEXT) {
             printf("Failed to create context for vendor %s\n", contexts[i].vendorName);
             return 1;
@@ -92,6 +122,16 @@ int main(int argc, char **argv)
     printf("Test NULL -> ctx1\n");
     testSwitchContext(NULL, &contexts[0]);
 
+    // The dummy vendor provides getProcAddressBulk, so libEGL should use it
+    // to fill in the default dispatch table, unless the on-disk cache already
+    // had every function.
+    if (getenv("__GLVND_DISPATCH_CACHE_DIR") == NULL
+            && ptr_eglTestDispatchDisplay(contexts[0].dpy,
+                DUMMY_COMMAND_GET_BULK_LOOKUP_COUNT, 0) == NULL) {
+        printf("getProcAddressBulk was not called\n");
+        return 1;
+    }
+
     printf("Test ctx1 -> ctx1\n");
     testSwitchContext(&contexts[0], &contexts[0]);
 
@@ -101,8 +141,23 @@ int main(int argc, char **argv)
     printf("Test ctx2 -> ctx3 (different vendor)\n");
     testSwitchContext(&contexts[1], &contexts[2]);
 
+    // A vendor can select a different dispatch table for each context, so
+    // libEGL has to update libGLdispatch even when the vendor doesn't change.
+    printf("Test ctx3 -> ctx4 (different vendor, dispatch variant)\n");
+    testSwitchContext(&contexts[2], &contexts[3]);
+
+    printf("Test ctx4 -> ctx1 (same vendor, different dispatch variant)\n");
+    testSwitchContext(&contexts[3], &contexts[0]);
+
+    printf("Test ctx1 -> ctx4 (same vendor, different dispatch variant)\n");
+    testSwitchContext(&contexts[0], &contexts[3]);
+
+    printf("Test ctx4 -> ctx3 (different vendor)\n");
+    testSwitchContext(&contexts[3], &contexts[2]);
+
     printf("Test ctx3 -> NULL\n");
     testSwitchContext(&contexts[2], NULL);
+    testErrorCheckRestore();
 
     // Next, make sure libEGL can deal with cases where the vendor's
     // eglMakeCurrent call fails.
@@ -132,6 +187,35 @@ int main(int argc, char **argv)
     printf("Test failed ctx1 -> ctx3 (different vendor, new vendor fails)\n");
     testSwitchContextFail(NULL, &contexts[2], &contexts[2]);
 
+    // Move a current context to another thread and back, the way a fiber
+    // scheduler would.
+    printf("Test detaching ctx4 and attaching it on another thread\n");
+    testSwitchContext(NULL, &contexts[3]);
+    testMigrate(&contexts[3]);
+
+    // Push the current context, make another one current, and pop the first
+    // one back, the way an overlay would.
+    printf("Test push ctx4, ctx3 (different vendor), pop\n");
+    testPushPop(&contexts[3], &contexts[2]);
+
+    printf("Test push ctx4, ctx1 (same vendor), pop\n");
+    testPushPop(&contexts[3], &contexts[0]);
+
+    printf("Test push ctx4, NULL, pop\n");
+    testPushPop(&contexts[3], NULL);
+
+    printf("Test push NULL, ctx3, pop\n");
+    testSwitchContext(&contexts[3], NULL);
+    testPushPop(NULL, &contexts[2]);
+
+    if (eglPopCurrentGLVND() || eglGetError() != EGL_BAD_ACCESS) {
+        printf("eglPopCurrentGLVND should fail with an empty stack\n");
+        return 1;
+    }
+
+    printf("Test eglBindAPI with no current context\n");
+    testBindAPI(contexts[0].dpy, contexts[2].dpy);
+
     // Cleanup.
 
     eglMakeCurrent(EGL_NO_DISPLAY, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
@@ -183,6 +267,20 @@ void checkIsCurrent(const TestContextInfo *ci)
             printf("glGetString returned NULL, expected \"%s\"\n", ci->vendorName);
             exit(1);
         }
+
+        // Make sure the vendor's dispatch table variant for this context is
+        // the one that's current.
+        str = (const char *) glGetString(GL_RENDERER);
+        if (ci->dispatchVariant != 0) {
+            if (str == NULL || strcmp(str, DUMMY_VARIANT_RENDERER) != 0) {
+                printf("glGetString(GL_RENDERER) returned \"%s\", expected \"%s\"\n",
+                        str != NULL ? str : "(null)", DUMMY_VARIANT_RENDERER);
+                exit(1);
+            }
+        } else if (str != NULL) {
+            printf("glGetString(GL_RENDERER) returned \"%s\", expected NULL\n", str);
+            exit(1);
+        }
     }
 }
 
@@ -239,3 +337,158 @@ void testSwitchContextFail(const TestContextInfo *oldCi,
     checkIsCurrent(oldCi);
 }
 
+
+static void *MigrateThreadProc(void *param)
+{
+    const TestContextInfo *ci = (const TestContextInfo *) param;
+
+    checkIsCurrent(NULL);
+    if (!__glDispatchAttachCurrent(migrateState)) {
+        printf("__glDispatchAttachCurrent failed on the second thread\n");
+        exit(1);
+    }
+    checkIsCurrent(ci);
+
+    if (__glDispatchDetachCurrent() != migrateState) {
+        printf("__glDispatchDetachCurrent failed on the second thread\n");
+        exit(1);
+    }
+    checkIsCurrent(NULL);
+    return NULL;
+}
+
+void testMigrate(const TestContextInfo *ci)
+{
+    pthread_t thread;
+
+    migrateState = __glDispatchDetachCurrent();
+    if (migrateState == NULL) {
+        printf("__glDispatchDetachCurrent failed\n");
+        exit(1);
+    }
+    checkIsCurrent(NULL);
+
+    if (__glDispatchDetachCurrent() != NULL) {
+        printf("__glDispatchDetachCurrent succeeded without a current context\n");
+        exit(1);
+    }
+
+    if (pthread_create(&thread, NULL, MigrateThreadProc, (void *) ci) != 0
+            || pthread_join(thread, NULL) != 0) {
+        printf("Failed to run the second thread\n");
+        exit(1);
+    }
+
+    if (!__glDispatchAttachCurrent(migrateState)) {
+        printf("__glDispatchAttachCurrent failed\n");
+        exit(1);
+    }
+    checkIsCurrent(ci);
+
+    // A thread that already has a current context can't take another one.
+    if (__glDispatchAttachCurrent(migrateState)) {
+        printf("__glDispatchAttachCurrent succeeded with a current context\n");
+        exit(1);
+    }
+    migrateState = NULL;
+}
+
+void testPushPop(const TestContextInfo *oldCi, const TestContextInfo *newCi)
+{
+    if (!eglPushCurrentGLVND()) {
+        printf("eglPushCurrentGLVND failed with error 0x%04x\n", eglGetError());
+        exit(1);
+    }
+    checkIsCurrent(NULL);
+
+    if (newCi != NULL) {
+        testSwitchContext(NULL, newCi);
+    }
+
+    if (!eglPopCurrentGLVND()) {
+        printf("eglPopCurrentGLVND failed with error 0x%04x\n", eglGetError());
+        exit(1);
+    }
+    checkIsCurrent(oldCi);
+
+    if (newCi != NULL && (oldCi == NULL || oldCi->dpy != newCi->dpy)) {
+        // The pop should have released the other vendor's context.
+        EGLContext currCtx = ptr_eglTestDispatchDisplay(newCi->dpy,
+                DUMMY_COMMAND_GET_CURRENT_CONTEXT, 0);
+        if (currCtx != EGL_NO_CONTEXT) {
+            printf("The vendor's current context is %p, expected EGL_NO_CONTEXT\n",
+                    currCtx);
+            exit(1);
+        }
+    }
+}
+
+static uintptr_t getBindAPICount(EGLDisplay dpy)
+{
+    return (uintptr_t) ptr_eglTestDispatchDisplay(dpy,
+            DUMMY_COMMAND_GET_BIND_API_COUNT, 0);
+}
+
+void testBindAPI(EGLDisplay dpy, EGLDisplay otherDpy)
+{
+    uintptr_t count = getBindAPICount(dpy);
+    uintptr_t otherCount = getBindAPICount(otherDpy);
+    uintptr_t newCount;
+
+    if (!eglBindAPI(EGL_OPENGL_API) || !eglBindAPI(EGL_OPENGL_ES_API)
+            || !eglBindAPI(EGL_OPENGL_API)) {
+        printf("eglBindAPI failed\n");
+        exit(1);
+    }
+
+    // Each vendor should only be told about the API when it's used, and
+    // only once, no matter how many times the API changed before that.
+    newCount = getBindAPICount(dpy);
+    if (newCount != count + 1) {
+        printf("Vendor got %lu eglBindAPI calls, expected 1\n",
+                (unsigned long) (newCount - count));
+        exit(1);
+    }
+    newCount = getBindAPICount(dpy);
+    if (newCount != count + 1) {
+        printf("Vendor got another eglBindAPI call without an API change\n");
+        exit(1);
+    }
+    newCount = getBindAPICount(otherDpy);
+    if (newCount != otherCount + 1) {
+        printf("Other vendor got %lu eglBindAPI calls, expected 1\n",
+                (unsigned long) (newCount - otherCount));
+        exit(1);
+    }
+
+    if (!eglBindAPI(EGL_OPENGL_ES_API)) {
+        printf("eglBindAPI failed\n");
+        exit(1);
+    }
+}
+
+/**
+ * With app error checking, libGLdispatch should restore the default
+ * entrypoints once no context is current, so that a GL call goes to the
+ * no-op table instead of the vendor's patched function.
+ */
+void testErrorCheckRestore(void)
+{
+    __GLdispatchConfig config;
+
+    if (getenv("__GLVND_APP_ERROR_CHECKING") == NULL
+            || atoi(getenv("__GLVND_APP_ERROR_CHECKING")) == 0) {
+        return;
+    }
+
+    __glDispatchGetConfig(&config);
+    if (config.patchOwnerVendorID != 0) {
+        printf("The entrypoints are still patched by vendor %d\n",
+                config.patchOwnerVendorID);
+        exit(1);
+    }
+    if (glGetString(GL_VENDOR) != NULL) {
+        printf("glGetString didn't go to the no-op table\n");
+        exit(1);
+    }
+}
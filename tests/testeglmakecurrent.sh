@@ -2,4 +2,80 @@
 
 . $TOP_SRCDIR/tests/eglenv.sh
 
-./testeglmakecurrent
+./testeglmakecurrent || exit 1
+
+# Run it again after preinitializing libglvnd.
+./testeglmakecurrent -p || exit 1
+
+# Run it with the dummy vendors patching the entrypoints and spending some
+# time in each call, like a real driver.
+GLVND_TEST_PATCH_ENTRYPOINTS=1 GLVND_TEST_DUMMY_MAKE_CURRENT_NS=1000 \
+    GLVND_TEST_DUMMY_PROC_ADDRESS_NS=100 ./testeglmakecurrent || exit 1
+
+# Run it with app error checking and patched entrypoints. The entrypoints
+# should get restored when no context is current.
+GLVND_TEST_PATCH_ENTRYPOINTS=1 __GLVND_APP_ERROR_CHECKING=1 \
+    __GLVND_ABORT_ON_APP_ERROR=0 ./testeglmakecurrent || exit 1
+
+# Run it twice with the dispatch table cache: once to write the cache files,
+# and once to fill in the dispatch tables from them.
+__GLVND_DISPATCH_CACHE_DIR=./testeglmakecurrent.cache
+export __GLVND_DISPATCH_CACHE_DIR
+rm -rf $__GLVND_DISPATCH_CACHE_DIR
+mkdir $__GLVND_DISPATCH_CACHE_DIR || exit 1
+./testeglmakecurrent || exit 1
+./testeglmakecurrent || exit 1
+rm -rf $__GLVND_DISPATCH_CACHE_DIR
+
+# Run it with lock profiling, and make sure that the counts got written.
+unset __GLVND_DISPATCH_CACHE_DIR
+rm -f ./testeglmakecurrent.locks.*
+__GLVND_LOCK_STATS=./testeglmakecurrent.locks ./testeglmakecurrent || exit 1
+grep -q "^GLdispatch:dispatchLock,[1-9]" ./testeglmakecurrent.locks.* || exit 1
+grep -q "^EGL:currentStateListMutex,[1-9]" ./testeglmakecurrent.locks.* || exit 1
+rm -f ./testeglmakecurrent.locks.*
+
+# Run it with the memory counters. Check the peak footprint against a budget,
+# and make sure that everything libEGL allocated was freed during teardown.
+rm -f ./testeglmakecurrent.mem.*
+__GLVND_MEM_STATS=./testeglmakecurrent.mem ./testeglmakecurrent || exit 1
+grep -q "^GLdispatch:dispatch_table," ./testeglmakecurrent.mem.* || exit 1
+grep -q "^EGL:vendor," ./testeglmakecurrent.mem.* || exit 1
+awk -F, '
+    $1 == "GLdispatch:dispatch_table" && $4 > 262144 { exit 1 }
+    $1 == "EGL:vendor" && $4 > 8192 { exit 1 }
+    $1 ~ /^EGL:/ && $3 != 0 { exit 1 }
+' ./testeglmakecurrent.mem.* || exit 1
+rm -f ./testeglmakecurrent.mem.*
+
+# Run it again in the fast exit mode. The counters should still get written,
+# but libEGL shouldn't free its vendors on the way out.
+__GLVND_FAST_EXIT=1 __GLVND_MEM_STATS=./testeglmakecurrent.mem ./testeglmakecurrent || exit 1
+grep -q "^EGL:vendor,[1-9]" ./testeglmakecurrent.mem.* || exit 1
+rm -f ./testeglmakecurrent.mem.*
+
+# Run it with a slow operation threshold of zero, so that every timed
+# operation gets reported, and make sure that the reports name the vendor.
+rm -f ./testeglmakecurrent.slow
+__GLVND_SLOW_OP_US=0 ./testeglmakecurrent 2> ./testeglmakecurrent.slow || exit 1
+grep -q "^libglvnd: slow operation: LoadVendor for vendor \".*EGL_dummy0.*\" took [0-9]* us$" ./testeglmakecurrent.slow || exit 1
+grep -q "^libglvnd: slow operation: MakeCurrent (vendor switch) for vendor ID [1-9][0-9]* took" ./testeglmakecurrent.slow || exit 1
+grep -q "^libglvnd: slow operation: FixupDispatchTable for vendor " ./testeglmakecurrent.slow || exit 1
+rm -f ./testeglmakecurrent.slow
+
+# Run it with the window system call times, and make sure that the vendor's
+# part of each call is no more than the total.
+rm -f ./testeglmakecurrent.winsys.*
+__GLVND_WINSYS_TIMES=./testeglmakecurrent.winsys ./testeglmakecurrent || exit 1
+grep -q "^eglMakeCurrent,[1-9]" ./testeglmakecurrent.winsys.* || exit 1
+grep -q "^eglGetPlatformDisplay,[1-9]" ./testeglmakecurrent.winsys.* || exit 1
+awk -F, '!/^#/ && ($4 > $3 || $3 != $4 + $5) { exit 1 }' ./testeglmakecurrent.winsys.* || exit 1
+rm -f ./testeglmakecurrent.winsys.*
+
+# Run it with the latency histograms, and make sure that every call lands in
+# a bucket, in order of latency.
+rm -f ./testeglmakecurrent.hist.*
+__GLVND_WINSYS_HISTOGRAMS=./testeglmakecurrent.hist ./testeglmakecurrent || exit 1
+grep -q "^eglMakeCurrent,[0-9]*,[1-9]" ./testeglmakecurrent.hist.* || exit 1
+awk -F, '!/^#/ { if ($1 == last && $2 <= lastBucket) exit 1; last = $1; lastBucket = $2 }' ./testeglmakecurrent.hist.* || exit 1
+rm -f ./testeglmakecurrent.hist.*
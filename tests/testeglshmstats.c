@@ -0,0 +1,228 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+/*
+ * Tests the shared memory statistics.
+ *
+ * This has to run with __GLVND_SHM_STATS set to a directory. It switches
+ * between contexts from two vendors, and then reads its own statistics file
+ * back. Then, it forks, and checks that the child gets a file of its own and
+ * removes it when it exits.
+ */
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "dummy/EGL_dummy.h"
+#include "egl_test_utils.h"
+
+#define SWITCH_LOOPS 10
+
+/*
+ * This has to match __GLdispatchShmStats in GLdispatchPrivate.h.
+ */
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t size;
+    uint64_t pid;
+
+    uint64_t makeCurrentCount;
+    uint64_t vendorSwitchCount;
+    uint64_t fixupCount;
+    uint64_t fixupTimeNS;
+
+    uint64_t tableCount;
+    uint64_t patchOwnerVendorID;
+    uint64_t patchCount;
+    uint64_t unpatchCount;
+    uint64_t patchTimeUS;
+    uint64_t lockAcquired;
+    uint64_t lockContended;
+    uint64_t lockWaitNS;
+    uint64_t dynamicStubCount;
+    uint64_t dynamicStubMax;
+} ShmStats;
+
+static const char *shmDir;
+
+static void GetStatsPath(char *path, size_t size, pid_t pid)
+{
+    snprintf(path, size, "%s/glvnd-%ld", shmDir, (long) pid);
+}
+
+static int ReadStats(pid_t pid, ShmStats *stats)
+{
+    char path[4096];
+    FILE *f;
+    int ret = 0;
+
+    GetStatsPath(path, sizeof(path), pid);
+    f = fopen(path, "rb");
+    if (f == NULL) {
+        printf("Can't open %s\n", path);
+        return 0;
+    }
+    if (fread(stats, sizeof(*stats), 1, f) != 1) {
+        printf("%s is truncated\n", path);
+    } else if (memcmp(stats->magic, "GLVNDSHM", 8) != 0
+            || stats->version != 1 || stats->size != sizeof(*stats)) {
+        printf("%s doesn't have a valid header\n", path);
+    } else if (stats->pid != (uint64_t) pid) {
+        printf("%s has the wrong pid: %llu\n", path,
+                (unsigned long long) stats->pid);
+    } else {
+        ret = 1;
+    }
+    fclose(f);
+    return ret;
+}
+
+static int CheckChild(void)
+{
+    ShmStats stats;
+    char path[4096];
+    pid_t pid;
+    int status;
+
+    pid = fork();
+    if (pid < 0) {
+        printf("fork failed\n");
+        return 0;
+    }
+    if (pid == 0) {
+        // Any EGL call notices the fork and creates the new file.
+        eglGetCurrentContext();
+        if (!ReadStats(getpid(), &stats)) {
+            exit(1);
+        }
+        if (stats.makeCurrentCount != 0 || stats.vendorSwitchCount != 0) {
+            printf("The child inherited the parent's counters\n");
+            exit(1);
+        }
+        exit(0);
+    }
+
+    waitpid(pid, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        printf("The child failed\n");
+        return 0;
+    }
+    GetStatsPath(path, sizeof(path), pid);
+    if (access(path, F_OK) == 0) {
+        printf("The child didn't remove %s\n", path);
+        unlink(path);
+        return 0;
+    }
+    return 1;
+}
+
+int main(int argc, char **argv)
+{
+    EGLDisplay dpy[2];
+    EGLContext ctx[2];
+    ShmStats stats;
+    uint64_t makeCurrentCount;
+    int i;
+
+    shmDir = getenv("__GLVND_SHM_STATS");
+    if (shmDir == NULL || shmDir[0] == '\0') {
+        printf("__GLVND_SHM_STATS isn't set\n");
+        return 1;
+    }
+
+    for (i=0; i<2; i++) {
+        dpy[i] = eglGetPlatformDisplay(EGL_DUMMY_PLATFORM,
+                (void *) DUMMY_VENDOR_NAMES[i], NULL);
+        if (dpy[i] == EGL_NO_DISPLAY) {
+            printf("eglGetPlatformDisplay failed\n");
+            return 1;
+        }
+        ctx[i] = eglCreateContext(dpy[i], NULL, EGL_NO_CONTEXT, NULL);
+        if (ctx[i] == EGL_NO_CONTEXT) {
+            printf("eglCreateContext failed\n");
+            return 1;
+        }
+    }
+
+    for (i=0; i<SWITCH_LOOPS; i++) {
+        if (!eglMakeCurrent(dpy[0], EGL_NO_SURFACE, EGL_NO_SURFACE, ctx[0])
+                || !eglMakeCurrent(dpy[1], EGL_NO_SURFACE, EGL_NO_SURFACE, ctx[1])) {
+            printf("eglMakeCurrent failed\n");
+            return 1;
+        }
+    }
+
+    if (!ReadStats(getpid(), &stats)) {
+        return 1;
+    }
+    if (stats.makeCurrentCount != SWITCH_LOOPS * 2) {
+        printf("Expected %d MakeCurrent calls, but got %llu\n", SWITCH_LOOPS * 2,
+                (unsigned long long) stats.makeCurrentCount);
+        return 1;
+    }
+    if (stats.vendorSwitchCount != SWITCH_LOOPS * 2 - 1) {
+        printf("Expected %d vendor switches, but got %llu\n", SWITCH_LOOPS * 2 - 1,
+                (unsigned long long) stats.vendorSwitchCount);
+        return 1;
+    }
+    if (stats.fixupCount < 2 || stats.tableCount < 2 || stats.lockAcquired == 0
+            || stats.dynamicStubMax == 0) {
+        printf("Missing counters: fixup %llu, tables %llu, lock %llu, stubs %llu\n",
+                (unsigned long long) stats.fixupCount,
+                (unsigned long long) stats.tableCount,
+                (unsigned long long) stats.lockAcquired,
+                (unsigned long long) stats.dynamicStubMax);
+        return 1;
+    }
+    makeCurrentCount = stats.makeCurrentCount;
+
+    if (!CheckChild()) {
+        return 1;
+    }
+
+    // The child's calls shouldn't show up in the parent's counters.
+    if (!ReadStats(getpid(), &stats)) {
+        return 1;
+    }
+    if (stats.makeCurrentCount != makeCurrentCount) {
+        printf("The child changed the parent's counters\n");
+        return 1;
+    }
+
+    eglMakeCurrent(dpy[0], EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    return 0;
+}
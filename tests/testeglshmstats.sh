@@ -0,0 +1,16 @@
+#!/bin/sh
+
+. $TOP_SRCDIR/tests/eglenv.sh
+
+__GLVND_SHM_STATS=./testeglshmstats.shm
+export __GLVND_SHM_STATS
+rm -rf $__GLVND_SHM_STATS
+mkdir $__GLVND_SHM_STATS || exit 1
+
+./testeglshmstats || exit 1
+
+# The file should be gone once the process exits.
+if [ -n "$(ls $__GLVND_SHM_STATS)" ] ; then
+    exit 1
+fi
+rm -rf $__GLVND_SHM_STATS
@@ -0,0 +1,230 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+/*
+ * Tests that the steady-state EGL and GL paths don't make any syscalls.
+ *
+ * A real-time render loop can't afford to block in the kernel, so once a
+ * context is current, making the same context current again, looking up a
+ * function that's already been looked up, the eglGetCurrent* functions,
+ * swapping the same surface, and calling a GL function should all stay in
+ * user space, at least as far as libglvnd itself goes.
+ *
+ * This runs each of those once to warm up any caches, and then installs a
+ * seccomp filter that traps every syscall except for writing to stderr and
+ * exiting, and runs them again. The test runs in a child process, since
+ * there's no way to remove the filter afterward.
+ *
+ * Note that this only checks libglvnd and the dummy vendor. An uncontended
+ * mutex or a vDSO function like clock_gettime don't make syscalls.
+ */
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GL/gl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#include <linux/filter.h>
+#include <linux/seccomp.h>
+
+#include "dummy/EGL_dummy.h"
+#include "egl_test_utils.h"
+
+#define LOOP_COUNT 1000
+
+/*
+ * The exit code that tells automake to skip a test.
+ */
+#define EXIT_SKIP 77
+
+static EGLDisplay dpy;
+static EGLContext ctx;
+
+static void ReportSyscall(int sig, siginfo_t *info, void *ucontext)
+{
+    static const char prefix[] = "Unexpected syscall ";
+    char buf[16];
+    int nr = info->si_syscall;
+    int len = 0;
+    int i;
+
+    // Only async-signal-safe calls here, and write(2) is the only thing
+    // that the filter lets through.
+    do {
+        buf[len++] = '0' + (nr % 10);
+        nr /= 10;
+    } while (nr > 0 && len < (int) sizeof(buf) - 1);
+    for (i=0; i<len / 2; i++) {
+        char c = buf[i];
+        buf[i] = buf[len - 1 - i];
+        buf[len - 1 - i] = c;
+    }
+    buf[len++] = '\n';
+
+    if (write(STDERR_FILENO, prefix, sizeof(prefix) - 1) < 0
+            || write(STDERR_FILENO, buf, len) < 0) {
+        // Nothing else to do about it.
+    }
+    _exit(1);
+}
+
+/*
+ * Installs a seccomp filter that sends SIGSYS for any syscall other than
+ * write(2), exit_group, and rt_sigreturn.
+ *
+ * Returns 0 on success, or -1 if seccomp isn't available.
+ */
+static int InstallSyscallTrap(void)
+{
+    struct sock_filter filter[] = {
+        BPF_STMT(BPF_LD | BPF_W | BPF_ABS, offsetof(struct seccomp_data, nr)),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, SYS_exit_group, 4, 0),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, SYS_rt_sigreturn, 3, 0),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, SYS_write, 0, 1),
+        BPF_STMT(BPF_LD | BPF_W | BPF_ABS, offsetof(struct seccomp_data, args[0])),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, STDERR_FILENO, 0, 1),
+        BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_ALLOW),
+        BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_TRAP),
+    };
+    struct sock_fprog prog = {
+        .len = sizeof(filter) / sizeof(filter[0]),
+        .filter = filter,
+    };
+    struct sigaction sa;
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_sigaction = ReportSyscall;
+    sa.sa_flags = SA_SIGINFO;
+    sigemptyset(&sa.sa_mask);
+    if (sigaction(SIGSYS, &sa, NULL) != 0) {
+        return -1;
+    }
+
+    if (prctl(PR_SET_NO_NEW_PRIVS, 1, 0, 0, 0) != 0) {
+        return -1;
+    }
+    if (prctl(PR_SET_SECCOMP, SECCOMP_MODE_FILTER, &prog) != 0) {
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Runs each of the steady-state paths once.
+ */
+static int RunSteadyState(void)
+{
+    if (!eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, ctx)) {
+        printf("eglMakeCurrent failed\n");
+        return 0;
+    }
+    if (eglGetCurrentContext() != ctx || eglGetCurrentDisplay() != dpy
+            || eglGetCurrentSurface(EGL_DRAW) != EGL_NO_SURFACE) {
+        printf("Wrong current state\n");
+        return 0;
+    }
+    if (eglGetProcAddress("glGetString") == NULL
+            || eglGetProcAddress("eglTestDispatchCurrent") == NULL) {
+        printf("eglGetProcAddress failed\n");
+        return 0;
+    }
+    eglSwapBuffers(dpy, EGL_NO_SURFACE);
+    if (glGetString(GL_VENDOR) == NULL) {
+        printf("glGetString failed\n");
+        return 0;
+    }
+    return 1;
+}
+
+static int RunChild(void)
+{
+    int i;
+
+    dpy = eglGetPlatformDisplay(EGL_DUMMY_PLATFORM,
+            (void *) DUMMY_VENDOR_NAMES[0], NULL);
+    if (dpy == EGL_NO_DISPLAY) {
+        printf("eglGetPlatformDisplay failed\n");
+        return 1;
+    }
+    ctx = eglCreateContext(dpy, NULL, EGL_NO_CONTEXT, NULL);
+    if (ctx == EGL_NO_CONTEXT) {
+        printf("eglCreateContext failed\n");
+        return 1;
+    }
+
+    if (!RunSteadyState()) {
+        return 1;
+    }
+
+    fflush(stdout);
+    if (InstallSyscallTrap() != 0) {
+        printf("seccomp isn't available, skipping\n");
+        return EXIT_SKIP;
+    }
+
+    for (i=0; i<LOOP_COUNT; i++) {
+        if (!RunSteadyState()) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    int status;
+    pid_t pid;
+
+    pid = fork();
+    if (pid < 0) {
+        printf("fork failed\n");
+        return 1;
+    }
+    if (pid == 0) {
+        // Skip the teardown and the atexit handlers, which are allowed to
+        // make syscalls.
+        _exit(RunChild());
+    }
+
+    waitpid(pid, &status, 0);
+    if (!WIFEXITED(status)) {
+        printf("The child was killed by signal %d\n",
+                WIFSIGNALED(status) ? WTERMSIG(status) : 0);
+        return 1;
+    }
+    return WEXITSTATUS(status);
+}
@@ -0,0 +1,8 @@
+#!/bin/sh
+
+. $TOP_SRCDIR/tests/eglenv.sh
+
+./testeglsyscalls || exit $?
+
+# Run it again with the dummy vendor patching the entrypoints.
+GLVND_TEST_PATCH_ENTRYPOINTS=1 ./testeglsyscalls || exit $?
@@ -0,0 +1,291 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+/*
+ * Tests the trace flight recorder.
+ *
+ * This has to run with __GLVND_TRACE_FILE set, along with
+ * __GLVND_TRACE_FLIGHT_RECORDER=1 and __GLVND_TRACE_RECORDS=16.
+ *
+ * It forks a child process for each way that the file can get written. Each
+ * child makes a context current more times than the buffer holds, looks up a
+ * function, and swaps, and then:
+ *
+ *   - Exits normally, which shouldn't write the file.
+ *   - Calls __glDispatchDumpTrace, and then exits.
+ *   - Calls abort, which should write the file from the signal handler.
+ *
+ * After each child, the parent reads the file back, and checks that the
+ * buffer wrapped around and that it still has the lookup and the swap.
+ */
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include <GLdispatch.h>
+
+#include "dummy/EGL_dummy.h"
+#include "egl_test_utils.h"
+#include "glvnd_hash.h"
+
+#define RING_SIZE 16
+#define MAKE_CURRENT_LOOPS 20
+
+/*
+ * The dummy vendor doesn't create real surfaces, and eglSwapBuffers only
+ * looks at the display, so any handle works here.
+ */
+#define TEST_SURFACE ((EGLSurface) (uintptr_t) 0x5a5a0000)
+
+/*
+ * These have to match the file format in GLdispatchTrace.c.
+ */
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize;
+    uint64_t startTicks;
+    uint64_t startNS;
+    uint64_t endTicks;
+    uint64_t endNS;
+} TraceFileHeader;
+
+typedef struct {
+    uint64_t threadID;
+    uint32_t recordCount;
+    uint32_t reserved;
+} TraceThreadHeader;
+
+typedef struct {
+    uint64_t timestamp;
+    uint32_t event;
+    uint32_t reserved;
+    uint64_t arg0;
+    uint64_t arg1;
+} TraceRecord;
+
+enum {
+    MODE_EXIT,
+    MODE_DUMP,
+    MODE_ABORT,
+};
+
+static const char *MODE_NAMES[] = { "exit", "dump", "abort" };
+
+static void RecordEvents(void)
+{
+    EGLDisplay dpy;
+    EGLContext ctx;
+    int i;
+
+    dpy = eglGetPlatformDisplay(EGL_DUMMY_PLATFORM,
+            (void *) DUMMY_VENDOR_NAMES[0], NULL);
+    if (dpy == EGL_NO_DISPLAY) {
+        printf("eglGetPlatformDisplay failed\n");
+        exit(1);
+    }
+    ctx = eglCreateContext(dpy, NULL, EGL_NO_CONTEXT, NULL);
+    if (ctx == EGL_NO_CONTEXT) {
+        printf("Can't create a context\n");
+        exit(1);
+    }
+
+    for (i=0; i<MAKE_CURRENT_LOOPS; i++) {
+        if (!eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, ctx)
+                || !eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT)) {
+            printf("eglMakeCurrent failed\n");
+            exit(1);
+        }
+    }
+
+    if (eglGetProcAddress("glGetString") == NULL) {
+        printf("Can't look up glGetString\n");
+        exit(1);
+    }
+    eglSwapBuffers(dpy, TEST_SURFACE);
+}
+
+static int CheckTraceFile(const char *path)
+{
+    TraceFileHeader header;
+    TraceThreadHeader threadHeader;
+    TraceRecord records[RING_SIZE];
+    const TraceRecord *lookup = NULL;
+    const TraceRecord *swap;
+    FILE *f;
+    int i;
+    int ret = 0;
+
+    f = fopen(path, "rb");
+    if (f == NULL) {
+        printf("Can't open %s\n", path);
+        return 0;
+    }
+
+    if (fread(&header, sizeof(header), 1, f) != 1
+            || memcmp(header.magic, "GLVNDTRC", 8) != 0
+            || header.recordSize != sizeof(TraceRecord)) {
+        printf("%s doesn't have a valid header\n", path);
+        goto done;
+    }
+
+    // Only the child's thread recorded anything.
+    if (fread(&threadHeader, sizeof(threadHeader), 1, f) != 1) {
+        printf("%s doesn't have any buffers\n", path);
+        goto done;
+    }
+    if (threadHeader.recordCount != RING_SIZE) {
+        printf("Expected %d records, but got %u\n", RING_SIZE,
+                (unsigned int) threadHeader.recordCount);
+        goto done;
+    }
+    if (fread(records, sizeof(TraceRecord), RING_SIZE, f) != RING_SIZE) {
+        printf("%s is truncated\n", path);
+        goto done;
+    }
+
+    // Looking up a GL function can also patch the entrypoints, so there
+    // might be other records between the lookup and the swap.
+    swap = &records[RING_SIZE - 1];
+    for (i=RING_SIZE - 2; i>=0; i--) {
+        if (records[i].event == GLDISPATCH_TRACE_PROC_LOOKUP) {
+            lookup = &records[i];
+            break;
+        }
+    }
+    if (lookup == NULL) {
+        printf("Missing the lookup event\n");
+        goto done;
+    }
+    if (lookup->arg0 != GLDISPATCH_API_EGL
+            || lookup->arg1 != glvndHashString("glGetString")) {
+        printf("Wrong lookup event: %u, 0x%llx, 0x%llx\n", lookup->event,
+                (unsigned long long) lookup->arg0,
+                (unsigned long long) lookup->arg1);
+        goto done;
+    }
+    if (swap->event != GLDISPATCH_TRACE_SWAP
+            || swap->arg0 != GLDISPATCH_API_EGL
+            || swap->arg1 != (uint64_t) (uintptr_t) TEST_SURFACE) {
+        printf("Wrong swap event: %u, 0x%llx, 0x%llx\n", swap->event,
+                (unsigned long long) swap->arg0,
+                (unsigned long long) swap->arg1);
+        goto done;
+    }
+    if (records[0].timestamp > swap->timestamp) {
+        printf("The records are out of order\n");
+        goto done;
+    }
+    ret = 1;
+
+done:
+    fclose(f);
+    return ret;
+}
+
+static int RunChild(const char *tracePath, int mode)
+{
+    char path[4096];
+    int status;
+    pid_t pid;
+
+    pid = fork();
+    if (pid < 0) {
+        printf("fork failed\n");
+        return 0;
+    }
+    if (pid == 0) {
+        RecordEvents();
+        if (mode == MODE_DUMP) {
+            if (!__glDispatchDumpTrace()) {
+                printf("__glDispatchDumpTrace failed\n");
+                exit(1);
+            }
+        } else if (mode == MODE_ABORT) {
+            abort();
+        }
+        exit(0);
+    }
+
+    waitpid(pid, &status, 0);
+
+    if (mode == MODE_ABORT) {
+        if (!WIFSIGNALED(status) || WTERMSIG(status) != SIGABRT) {
+            printf("The child didn't get SIGABRT\n");
+            return 0;
+        }
+    } else if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        printf("The child failed\n");
+        return 0;
+    }
+
+    snprintf(path, sizeof(path), "%s.%ld", tracePath, (long) pid);
+    if (mode == MODE_EXIT) {
+        if (access(path, F_OK) == 0) {
+            printf("The trace file was written at exit\n");
+            unlink(path);
+            return 0;
+        }
+        return 1;
+    }
+
+    if (!CheckTraceFile(path)) {
+        return 0;
+    }
+    unlink(path);
+    return 1;
+}
+
+int main(int argc, char **argv)
+{
+    const char *tracePath = getenv("__GLVND_TRACE_FILE");
+    int mode;
+
+    if (tracePath == NULL || tracePath[0] == '\0') {
+        printf("__GLVND_TRACE_FILE isn't set\n");
+        return 1;
+    }
+
+    for (mode = MODE_EXIT; mode <= MODE_ABORT; mode++) {
+        printf("Testing %s\n", MODE_NAMES[mode]);
+        fflush(stdout);
+        if (!RunChild(tracePath, mode)) {
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,7 @@
+#!/bin/sh
+
+. $TOP_SRCDIR/tests/eglenv.sh
+
+__GLVND_TRACE_FILE=./testegltrace.trace \
+    __GLVND_TRACE_FLIGHT_RECORDER=1 __GLVND_TRACE_RECORDS=16 \
+    ./testegltrace || exit 1
@@ -32,14 +32,21 @@
 #include <string.h>
 #include <getopt.h>
 #include <pthread.h>
+#include <dlfcn.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/wait.h>
 #include <GL/gl.h>
 
 #include <GLdispatch.h>
+#include "glvnd/glvnd.h"
 
 #include "dummy/patchentrypoints.h"
+#include "dummy/GLdispatch_layer_dummy.h"
 
 #define DUMMY_VENDOR_COUNT 3
 #define NUM_GLDISPATCH_CALLS 2
+#define NUM_ERROR_CHECK_RELEASES 256
 static const char *GENERATED_FUNCTION_NAME = "glDummyTestGLVND";
 
 enum {
@@ -64,6 +71,8 @@ typedef struct DummyVendorLibRec {
     __GLdispatchPatchCallbacks patchCallbacks;
 
     int callCounts[CALL_INDEX_COUNT];
+    int bulkLookupCount;
+    int lookupCount;
 } DummyVendorLib;
 
 static void InitDummyVendors(void);
@@ -71,10 +80,21 @@ static void CleanupDummyVendors(void);
 
 static void *ForceMultiThreadedProc(void *param);
 
-static GLboolean TestDispatch(int vendorIndex,
+static GLboolean TestDispatch(int vendorIndex, GLboolean expectPatched,
         GLboolean testStatic, GLboolean testGenerated);
+static GLboolean TestPinnedVendor(int vendorIndex);
+static GLboolean TestOtherThreadCurrent(void);
+static GLboolean TestFork(void);
+static GLboolean TestStatistics(void);
+static GLboolean TestErrorCheckRestore(void);
+static GLboolean TestConfig(void);
+static GLboolean TestInternString(void);
+static GLboolean TestCurrentInfo(void);
+static GLboolean TestStaticFuncs(void);
 
 static void *common_getProcAddressCallback(const char *procName, void *param, int vendorIndex);
+static void common_getProcAddressBulkCallback(const char * const *procNames,
+        void **procs, int count, void *param);
 static GLboolean common_InitiatePatch(int type, int stubSize,
         DispatchPatchLookupStubOffset lookupStubOffset, int vendorIndex);
 
@@ -83,12 +103,18 @@ static void dummy0_glVertex3fv(const GLfloat *v);
 static void dummy0_glDummyTestProc(const GLfloat *v);
 static GLboolean dummy0_InitiatePatch(int type, int stubSize,
         DispatchPatchLookupStubOffset lookupStubOffset);
+static GLboolean dummy0_InitiatePatchTargets(DispatchPatchSetStubTarget setStubTarget);
+static void dummy0_glVertex3fv_patched(const GLfloat *v);
+static void dummy0_glDummyTestProc_patched(const GLfloat *v);
 
 static void *dummy1_getProcAddressCallback(const char *procName, void *param);
 static void dummy1_glVertex3fv(const GLfloat *v);
 static void dummy1_glDummyTestProc(const GLfloat *v);
 static GLboolean dummy1_InitiatePatch(int type, int stubSize,
         DispatchPatchLookupStubOffset lookupStubOffset);
+static GLboolean dummy1_InitiatePatchTargets(DispatchPatchSetStubTarget setStubTarget);
+static void dummy1_glVertex3fv_patched(const GLfloat *v);
+static void dummy1_glDummyTestProc_patched(const GLfloat *v);
 
 static void *dummy2_getProcAddressCallback(const char *procName, void *param);
 static void dummy2_glVertex3fv(const GLfloat *v);
@@ -106,15 +132,24 @@ static pfn_glVertex3fv ptr_glDummyTestProc;
 static GLboolean enableStaticTest = GL_FALSE;
 static GLboolean enableGeneratedTest = GL_FALSE;
 static GLboolean enablePatching = GL_FALSE;
+static GLboolean enablePatchTargets = GL_FALSE;
+static GLboolean testOtherThreadCurrent = GL_FALSE;
+static GLboolean testFork = GL_FALSE;
 static GLboolean forceMultiThreaded = GL_FALSE;
 static GLboolean useLastGenerated = GL_FALSE;
+static GLboolean useOverflowGenerated = GL_FALSE;
+static GLboolean useBulkLookup = GL_FALSE;
+static GLboolean expectLazyLookup = GL_FALSE;
+static GLboolean expectPinnedVendor = GL_FALSE;
+static GLboolean expectErrorCheckRestore = GL_FALSE;
+static PFNDUMMYLAYERGETCALLCOUNTPROC layerGetCallCount = NULL;
 
 int main(int argc, char **argv)
 {
     int i;
 
     while (1) {
-        int opt = getopt(argc, argv, "sgptl");
+        int opt = getopt(argc, argv, "sgpatlobcf");
         if (opt == -1) {
             break;
         }
@@ -128,12 +163,27 @@ int main(int argc, char **argv)
         case 'p':
             enablePatching = GL_TRUE;
             break;
+        case 'a':
+            enablePatchTargets = GL_TRUE;
+            break;
         case 't':
             forceMultiThreaded = GL_TRUE;
             break;
         case 'l':
             useLastGenerated = GL_TRUE;
             break;
+        case 'o':
+            useOverflowGenerated = GL_TRUE;
+            break;
+        case 'b':
+            useBulkLookup = GL_TRUE;
+            break;
+        case 'c':
+            testOtherThreadCurrent = GL_TRUE;
+            break;
+        case 'f':
+            testFork = GL_TRUE;
+            break;
         default:
             return 1;
         }
@@ -143,15 +193,101 @@ int main(int argc, char **argv)
     // If the assembly dispatch stubs aren't enabled, then generating and
     // patching entrypoints won't work. In that case, exit with 77 to tell
     // automake to skip the test instead of failing.
-    if (enablePatching || enableGeneratedTest)
+    if (enablePatching || enablePatchTargets || enableGeneratedTest)
     {
         return 77;
     }
 #endif
 
+#if defined(GLDISPATCH_STATIC_STUBS_ONLY)
+    // Without any dynamic stubs, libGLdispatch can't generate a stub for the
+    // test function.
+    if (enableGeneratedTest) {
+        return 77;
+    }
+#endif
+
+#if !defined(USE_X86_64_ASM)
+    // Only the x86-64 stubs support patching with initiatePatchTargets.
+    if (enablePatchTargets) {
+        return 77;
+    }
+#endif
+
+#if !defined(USE_X86_64_ASM) || defined(__ILP32__)
+    // Overflow stubs are only supported on x86-64.
+    if (useOverflowGenerated) {
+        return 77;
+    }
+#endif
+
+#if defined(USE_X86_64_ASM) && !defined(__ILP32__)
+    // Lazy dispatch tables are only supported on x86-64. Anywhere else,
+    // libGLdispatch will ignore __GLVND_LAZY_DISPATCH.
+    if (getenv("__GLVND_LAZY_DISPATCH") != NULL
+            && atoi(getenv("__GLVND_LAZY_DISPATCH")) != 0) {
+        expectLazyLookup = GL_TRUE;
+    }
+#endif
+
+    // libGLdispatch doesn't patch the entrypoints while it's counting calls.
+    if ((enablePatching || enablePatchTargets)
+            && getenv("__GLVND_CALL_COUNTS") != NULL
+            && getenv("__GLVND_CALL_COUNTS")[0] != '\0') {
+        return 77;
+    }
+
+    if (getenv("__GLVND_PIN_VENDOR") != NULL
+            && atoi(getenv("__GLVND_PIN_VENDOR")) != 0) {
+        // The first vendor gets pinned, so every other vendor should fail to
+        // make current.
+        expectPinnedVendor = GL_TRUE;
+    } else if ((enablePatching || enablePatchTargets)
+            && getenv("__GLVND_APP_ERROR_CHECKING") != NULL
+            && atoi(getenv("__GLVND_APP_ERROR_CHECKING")) != 0) {
+        // With app error checking, libGLdispatch restores the patched
+        // entrypoints when no context is current, unless a vendor is pinned.
+        expectErrorCheckRestore = GL_TRUE;
+    }
+
     __glDispatchInit();
     InitDummyVendors();
 
+    {
+        // The test links to libGLdispatch, so it's always loaded at startup,
+        // and should get the static TLS stubs with --enable-runtime-tls.
+#if defined(GLDISPATCH_USE_TLS)
+        int expectedFlavor = GLDISPATCH_STUB_FLAVOR_TLS;
+#elif defined(GLDISPATCH_RUNTIME_TLS_STUBS) && !defined(__ILP32__) \
+        && defined(__GLIBC__)
+        int expectedFlavor = GLDISPATCH_STUB_FLAVOR_STATIC_TLS;
+#else
+        int expectedFlavor = GLDISPATCH_STUB_FLAVOR_TSD;
+#endif
+        if (__glDispatchGetStubFlavor() != expectedFlavor) {
+            printf("Wrong stub flavor: Expected %d, got %d\n", expectedFlavor,
+                    __glDispatchGetStubFlavor());
+            return 1;
+        }
+    }
+
+    if (getenv("__GLVND_LAYER_FILENAMES") != NULL) {
+        // libGLdispatch should have loaded the dummy layer already, so this
+        // just gets a handle to it.
+        void *layer = dlopen(DUMMY_LAYER_LIBRARY_NAME, RTLD_LAZY | RTLD_NOLOAD);
+        if (layer == NULL) {
+            printf("The dispatch layer wasn't loaded\n");
+            return 1;
+        }
+        layerGetCallCount = (PFNDUMMYLAYERGETCALLCOUNTPROC)
+            dlsym(layer, DUMMY_LAYER_GET_CALL_COUNT_NAME);
+        if (layerGetCallCount == NULL) {
+            printf("Can't find %s in the dispatch layer\n",
+                    DUMMY_LAYER_GET_CALL_COUNT_NAME);
+            return 1;
+        }
+    }
+
     if (forceMultiThreaded) {
         pthread_t thr;
 
@@ -167,19 +303,26 @@ int main(int argc, char **argv)
     }
 
     if (enableGeneratedTest) {
+        int paddingCount = 0;
+
         if (useLastGenerated) {
             // Get enough dispatch stubs so that the one we test is at the very
             // end of the dispatch table. On some architectures, loading from a
             // high index can be more complicated than a low index, so make
             // sure we got it right.
-            for (i=0; i<4095; i++) {
-                char name[32];
-                snprintf(name, sizeof(name), "glDummyTestPaddingGLVND_%d", i);
-                __GLdispatchProc proc = __glDispatchGetProcAddress(name);
-                if (proc == NULL) {
-                    printf("Can't find padding dispatch function for %d\n", i);
-                    return 1;
-                }
+            paddingCount = 4095;
+        } else if (useOverflowGenerated) {
+            // Get enough dispatch stubs that the one we test is an overflow
+            // stub, and isn't in the first overflow chunk.
+            paddingCount = 4096 + 600;
+        }
+        for (i=0; i<paddingCount; i++) {
+            char name[48];
+            snprintf(name, sizeof(name), "glDummyTestPaddingGLVND_%d", i);
+            __GLdispatchProc proc = __glDispatchGetProcAddress(name);
+            if (proc == NULL) {
+                printf("Can't find padding dispatch function for %d\n", i);
+                return 1;
             }
         }
         ptr_glDummyTestProc = (pfn_glVertex3fv) __glDispatchGetProcAddress(GENERATED_FUNCTION_NAME);
@@ -187,23 +330,73 @@ int main(int argc, char **argv)
             printf("Can't find dispatch function for %s\n", GENERATED_FUNCTION_NAME);
             return 1;
         }
+#if !defined(USE_X86_64_ASM) || defined(__ILP32__)
         if (useLastGenerated) {
             // We should have reached the end of the dispatch table by now, so
             // another __glDispatchGetProcAddress call should return NULL.
+            // On x86-64, this would be an overflow stub instead.
             __GLdispatchProc proc = __glDispatchGetProcAddress("glDummyTestPaddingGLVND_last");
             if (proc != NULL) {
                 printf("Got dispatch function past the end of the dispatch table.\n");
                 return 1;
             }
         }
+#endif
     }
 
     for (i=0; i<DUMMY_VENDOR_COUNT; i++) {
-        if (!TestDispatch(i, enableStaticTest, enableGeneratedTest)) {
+        if (expectPinnedVendor && i > 0) {
+            if (!TestPinnedVendor(i)) {
+                return 1;
+            }
+            continue;
+        }
+        if (!TestDispatch(i, (dummyVendors[i].patchCallbacksPtr != NULL),
+                    enableStaticTest, enableGeneratedTest)) {
             return 1;
         }
     }
 
+    if (expectPinnedVendor) {
+        // Make current again, which should skip straight to the pinned table.
+        if (!TestDispatch(0, (dummyVendors[0].patchCallbacksPtr != NULL),
+                    enableStaticTest, enableGeneratedTest)) {
+            return 1;
+        }
+    }
+
+    if (testOtherThreadCurrent && !TestOtherThreadCurrent()) {
+        return 1;
+    }
+
+    if (testFork && !TestFork()) {
+        return 1;
+    }
+
+    if (!TestStatistics()) {
+        return 1;
+    }
+
+    if (expectErrorCheckRestore && !TestErrorCheckRestore()) {
+        return 1;
+    }
+
+    if (!TestConfig()) {
+        return 1;
+    }
+
+    if (!TestInternString()) {
+        return 1;
+    }
+
+    if (!TestCurrentInfo()) {
+        return 1;
+    }
+
+    if (!TestStaticFuncs()) {
+        return 1;
+    }
+
     CleanupDummyVendors();
     __glDispatchFini();
     return 0;
@@ -225,8 +418,14 @@ static void InitDummyVendors(void)
             abort();
         }
 
-        dummyVendors[i].dispatch = __glDispatchCreateTable(
-                dummyVendors[i].getProcCallback, &dummyVendors[i]);
+        if (useBulkLookup) {
+            dummyVendors[i].dispatch = __glDispatchCreateTableBulk(
+                    dummyVendors[i].getProcCallback,
+                    common_getProcAddressBulkCallback, &dummyVendors[i]);
+        } else {
+            dummyVendors[i].dispatch = __glDispatchCreateTable(
+                    dummyVendors[i].getProcCallback, &dummyVendors[i]);
+        }
         if (dummyVendors[i].dispatch == NULL) {
             printf("__glDispatchCreateTable failed\n");
             abort();
@@ -242,6 +441,14 @@ static void InitDummyVendors(void)
         dummyVendors[1].patchCallbacks.initiatePatch = dummy1_InitiatePatch;
         dummyVendors[1].patchCallbacksPtr = &dummyVendors[1].patchCallbacks;
     }
+
+    if (enablePatchTargets) {
+        dummyVendors[0].patchCallbacks.initiatePatchTargets = dummy0_InitiatePatchTargets;
+        dummyVendors[0].patchCallbacksPtr = &dummyVendors[0].patchCallbacks;
+
+        dummyVendors[1].patchCallbacks.initiatePatchTargets = dummy1_InitiatePatchTargets;
+        dummyVendors[1].patchCallbacksPtr = &dummyVendors[1].patchCallbacks;
+    }
 }
 
 static void CleanupDummyVendors(void)
@@ -265,6 +472,21 @@ static void ResetCallCounts(void)
     }
 }
 
+/*
+ * Checks that the dispatch layer, if there is one, got \p count calls since
+ * \p layerCount was recorded.
+ */
+static GLboolean CheckLayerCallCount(unsigned long layerCount, int count)
+{
+    if (layerGetCallCount != NULL
+            && layerGetCallCount() - layerCount != (unsigned long) count) {
+        printf("Wrong call count for the dispatch layer: Expected %d, got %lu\n",
+                count, layerGetCallCount() - layerCount);
+        return GL_FALSE;
+    }
+    return GL_TRUE;
+}
+
 static GLboolean CheckCallCounts(int expectedVendorIndex, int expectedCallIndex, int count)
 {
     int vendorIndex, callIndex;
@@ -290,12 +512,16 @@ static GLboolean CheckCallCounts(int expectedVendorIndex, int expectedCallIndex,
     return result;
 }
 
-static GLboolean TestDispatch(int vendorIndex,
+static GLboolean TestDispatch(int vendorIndex, GLboolean expectPatched,
         GLboolean testStatic, GLboolean testGenerated)
 {
     int i;
     GLboolean result = GL_FALSE;
-    GLboolean patched = (dummyVendors[vendorIndex].patchCallbacksPtr != NULL);
+    GLboolean patched = expectPatched;
+    unsigned long generation = __glDispatchGetCurrentGeneration();
+    unsigned long currentGeneration;
+    unsigned long layerCount = 0;
+    __GLdispatchProc proc;
 
     if (!__glDispatchMakeCurrent(&dummyVendors[vendorIndex].threadState,
                 dummyVendors[vendorIndex].dispatch, dummyVendors[vendorIndex].vendorID,
@@ -303,26 +529,53 @@ static GLboolean TestDispatch(int vendorIndex,
         printf("__glDispatchMakeCurrent failed\n");
         return GL_FALSE;
     }
+    __glDispatchSetCurrentVendorContext(&dummyVendors[vendorIndex]);
+    if (getenv("__GLVND_PREWARM_DISPATCH") != NULL
+            && atoi(getenv("__GLVND_PREWARM_DISPATCH")) != 0) {
+        // The current table has been faulted in already, but this does it
+        // again, along with the stubs.
+        __glDispatchPrewarm();
+    }
 
     printf("Testing vendor %d, patched = %d\n", vendorIndex, (int) patched);
+    if (expectLazyLookup && !useOverflowGenerated) {
+        // With a lazy dispatch table, nothing should get looked up until the
+        // first time each function is called. Overflow stubs don't have lazy
+        // trampolines, though, so those always get looked up up front.
+        if (dummyVendors[vendorIndex].lookupCount != 0
+                || dummyVendors[vendorIndex].bulkLookupCount != 0) {
+            printf("Functions were looked up before they were called\n");
+            goto done;
+        }
+    } else if (useBulkLookup && layerGetCallCount == NULL
+            && dummyVendors[vendorIndex].bulkLookupCount == 0) {
+        // With a dispatch layer, libGLdispatch looks up each function
+        // separately, so that it can ask the layer about each one.
+        printf("The bulk lookup callback was not called\n");
+        goto done;
+    }
     if (testStatic) {
         int callIndex = (patched ? CALL_INDEX_STATIC_PATCH : CALL_INDEX_STATIC);
 
         printf("Testing static dispatch through libOpenGL\n");
         ResetCallCounts();
+        layerCount = (layerGetCallCount != NULL ? layerGetCallCount() : 0);
         for (i = 0; i < NUM_GLDISPATCH_CALLS; i++) {
             glVertex3fv(NULL);
         }
-        if (!CheckCallCounts(vendorIndex, callIndex, NUM_GLDISPATCH_CALLS)) {
+        if (!CheckCallCounts(vendorIndex, callIndex, NUM_GLDISPATCH_CALLS)
+                || !CheckLayerCallCount(layerCount, NUM_GLDISPATCH_CALLS)) {
             goto done;
         }
 
         printf("Testing static dispatch through GetProcAddress\n");
         ResetCallCounts();
+        layerCount = (layerGetCallCount != NULL ? layerGetCallCount() : 0);
         for (i = 0; i < NUM_GLDISPATCH_CALLS; i++) {
             ptr_glVertex3fv(NULL);
         }
-        if (!CheckCallCounts(vendorIndex, callIndex, NUM_GLDISPATCH_CALLS)) {
+        if (!CheckCallCounts(vendorIndex, callIndex, NUM_GLDISPATCH_CALLS)
+                || !CheckLayerCallCount(layerCount, NUM_GLDISPATCH_CALLS)) {
             goto done;
         }
     }
@@ -340,13 +593,441 @@ static GLboolean TestDispatch(int vendorIndex,
         }
     }
 
+    printf("Testing direct function lookup\n");
+    proc = __glDispatchGetCurrentProc("glVertex3fv", &currentGeneration);
+    if (layerGetCallCount != NULL) {
+        // The dispatch table should have the layer's function instead of the
+        // vendor's.
+        if (proc == NULL || proc == (__GLdispatchProc) dummyVendors[vendorIndex].vertexProc) {
+            printf("__glDispatchGetCurrentProc didn't return the layer's function\n");
+            goto done;
+        }
+    } else if (proc != (__GLdispatchProc) dummyVendors[vendorIndex].vertexProc) {
+        printf("__glDispatchGetCurrentProc returned the wrong function\n");
+        goto done;
+    }
+    if (currentGeneration == generation
+            || currentGeneration != __glDispatchGetCurrentGeneration()) {
+        printf("The generation didn't change after __glDispatchMakeCurrent\n");
+        goto done;
+    }
+    generation = currentGeneration;
+
+    if (__glDispatchGetCurrentVendorContext() != &dummyVendors[vendorIndex]) {
+        printf("__glDispatchGetCurrentVendorContext returned the wrong context\n");
+        goto done;
+    }
+
     result = GL_TRUE;
 
 done:
     __glDispatchLoseCurrent();
+    if (result) {
+        if (__glDispatchGetCurrentGeneration() == generation) {
+            printf("The generation didn't change after __glDispatchLoseCurrent\n");
+            result = GL_FALSE;
+        } else if (__glDispatchGetCurrentProc("glVertex3fv", NULL) != NULL) {
+            printf("__glDispatchGetCurrentProc returned a function without a current context\n");
+            result = GL_FALSE;
+        } else if (__glDispatchGetCurrentVendorContext() != NULL) {
+            printf("The vendor context wasn't cleared after __glDispatchLoseCurrent\n");
+            result = GL_FALSE;
+        }
+    }
     return result;
 }
 
+static GLboolean TestPinnedVendor(int vendorIndex)
+{
+    printf("Testing vendor %d with another vendor pinned\n", vendorIndex);
+    if (__glDispatchMakeCurrent(&dummyVendors[vendorIndex].threadState,
+                dummyVendors[vendorIndex].dispatch, dummyVendors[vendorIndex].vendorID,
+                dummyVendors[vendorIndex].patchCallbacksPtr)) {
+        printf("__glDispatchMakeCurrent succeeded for an unpinned vendor\n");
+        __glDispatchLoseCurrent();
+        return GL_FALSE;
+    }
+    return GL_TRUE;
+}
+
+typedef struct OtherThreadStateRec {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    int vendorIndex;
+    GLboolean ready;
+    GLboolean success;
+    GLboolean finished;
+} OtherThreadState;
+
+static void *OtherThreadProc(void *param)
+{
+    OtherThreadState *state = (OtherThreadState *) param;
+    DummyVendorLib *vendor = &dummyVendors[state->vendorIndex];
+    __GLdispatchThreadState threadState;
+
+    memset(&threadState, 0, sizeof(threadState));
+    __glDispatchCheckMultithreaded();
+
+    pthread_mutex_lock(&state->mutex);
+    state->success = __glDispatchMakeCurrent(&threadState, vendor->dispatch,
+            vendor->vendorID, vendor->patchCallbacksPtr);
+    state->ready = GL_TRUE;
+    pthread_cond_broadcast(&state->cond);
+
+    while (!state->finished) {
+        pthread_cond_wait(&state->cond, &state->mutex);
+    }
+    pthread_mutex_unlock(&state->mutex);
+
+    if (state->success) {
+        __glDispatchLoseCurrent();
+    }
+    return NULL;
+}
+
+/*
+ * Tests switching vendors while another thread has a current context.
+ *
+ * This makes vendor 0 current on a second thread. After that, vendor 1 should
+ * still be able to make current without patching the entrypoints, and then
+ * vendor 0 should be able to make current and patch them again.
+ */
+static GLboolean TestOtherThreadCurrent(void)
+{
+    OtherThreadState state;
+    pthread_t thr;
+    GLboolean result = GL_FALSE;
+
+    printf("Testing with a context current on another thread\n");
+
+    memset(&state, 0, sizeof(state));
+    pthread_mutex_init(&state.mutex, NULL);
+    pthread_cond_init(&state.cond, NULL);
+    state.vendorIndex = 0;
+
+    __glDispatchCheckMultithreaded();
+    if (pthread_create(&thr, NULL, OtherThreadProc, &state) != 0) {
+        printf("pthread_create failed\n");
+        return GL_FALSE;
+    }
+
+    pthread_mutex_lock(&state.mutex);
+    while (!state.ready) {
+        pthread_cond_wait(&state.cond, &state.mutex);
+    }
+    pthread_mutex_unlock(&state.mutex);
+
+    if (!state.success) {
+        printf("__glDispatchMakeCurrent failed on the other thread\n");
+        goto done;
+    }
+
+    if (!TestDispatch(1, GL_FALSE, enableStaticTest, enableGeneratedTest)) {
+        goto done;
+    }
+    if (!TestDispatch(0, enablePatchTargets, enableStaticTest, enableGeneratedTest)) {
+        goto done;
+    }
+    result = GL_TRUE;
+
+done:
+    pthread_mutex_lock(&state.mutex);
+    state.finished = GL_TRUE;
+    pthread_cond_broadcast(&state.cond);
+    pthread_mutex_unlock(&state.mutex);
+
+    pthread_join(thr, NULL);
+    pthread_mutex_destroy(&state.mutex);
+    pthread_cond_destroy(&state.cond);
+    return result;
+}
+
+/*
+ * Forks, and then checks that the child process can make each vendor current
+ * again after __glDispatchReset, without looking up any functions again.
+ */
+static GLboolean TestFork(void)
+{
+    pid_t pid;
+    int status;
+    int i;
+
+    printf("Testing after fork\n");
+    fflush(stdout);
+    pid = fork();
+    if (pid < 0) {
+        printf("fork failed\n");
+        return GL_FALSE;
+    }
+
+    if (pid == 0) {
+        __glDispatchReset();
+
+        for (i=0; i<DUMMY_VENDOR_COUNT; i++) {
+            int lookupCount = dummyVendors[i].lookupCount;
+            int bulkLookupCount = dummyVendors[i].bulkLookupCount;
+
+            if (expectPinnedVendor && i > 0) {
+                if (!TestPinnedVendor(i)) {
+                    _exit(1);
+                }
+                continue;
+            }
+            if (!TestDispatch(i, (dummyVendors[i].patchCallbacksPtr != NULL),
+                        enableStaticTest, enableGeneratedTest)) {
+                _exit(1);
+            }
+            if (dummyVendors[i].lookupCount != lookupCount
+                    || dummyVendors[i].bulkLookupCount != bulkLookupCount) {
+                printf("Vendor %d looked up functions again after fork\n", i);
+                _exit(1);
+            }
+        }
+        fflush(stdout);
+        _exit(0);
+    }
+
+    if (waitpid(pid, &status, 0) != pid) {
+        printf("waitpid failed\n");
+        return GL_FALSE;
+    }
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        printf("The child process failed\n");
+        return GL_FALSE;
+    }
+    return GL_TRUE;
+}
+
+static GLboolean TestInternString(void)
+{
+    char buf[64];
+    const char *name;
+
+    printf("Checking the string pool\n");
+
+    // The dynamic stub's name should already be in the pool, and a copy of a
+    // string should give back the same pointer.
+    strcpy(buf, GENERATED_FUNCTION_NAME);
+    name = __glDispatchInternString(buf);
+    if (name == NULL || name == buf || strcmp(name, GENERATED_FUNCTION_NAME) != 0) {
+        printf("Wrong string from __glDispatchInternString\n");
+        return GL_FALSE;
+    }
+    if (__glDispatchInternString(GENERATED_FUNCTION_NAME) != name) {
+        printf("Got a different copy of the same string\n");
+        return GL_FALSE;
+    }
+    if (__glDispatchInternString("glDummyOtherTestGLVND") == name) {
+        printf("Got the same copy of a different string\n");
+        return GL_FALSE;
+    }
+    return GL_TRUE;
+}
+
+static GLVNDcurrentInfo signalCurrentInfo;
+
+static void CurrentInfoSignalHandler(int sig)
+{
+    const volatile GLVNDcurrentInfo *info = __glDispatchGetCurrentInfo();
+
+    signalCurrentInfo.sequence = info->sequence;
+    signalCurrentInfo.api = info->api;
+    signalCurrentInfo.vendorID = info->vendorID;
+    signalCurrentInfo.context = info->context;
+    signalCurrentInfo.display = info->display;
+}
+
+static GLboolean CheckCurrentInfo(int api, int vendorID,
+        const void *display, const void *context)
+{
+    // Read the record from a signal handler, the way a profiler would.
+    memset(&signalCurrentInfo, 0xff, sizeof(signalCurrentInfo));
+    raise(SIGUSR1);
+
+    if ((signalCurrentInfo.sequence & 1) != 0) {
+        printf("The current info record was left partially updated\n");
+        return GL_FALSE;
+    }
+    if (signalCurrentInfo.api != api || signalCurrentInfo.vendorID != vendorID
+            || signalCurrentInfo.display != display
+            || signalCurrentInfo.context != context) {
+        printf("Got current info {%d, %d, %p, %p}, expected {%d, %d, %p, %p}\n",
+                signalCurrentInfo.api, signalCurrentInfo.vendorID,
+                signalCurrentInfo.display, signalCurrentInfo.context,
+                api, vendorID, display, context);
+        return GL_FALSE;
+    }
+    return GL_TRUE;
+}
+
+static GLboolean TestCurrentInfo(void)
+{
+    static int dummyDisplay;
+    DummyVendorLib *vendor = &dummyVendors[0];
+    GLboolean ret;
+
+    if (__glDispatchGetCurrentInfo() == NULL) {
+        // libGLdispatch was built without TLS, so there's no record.
+        return GL_TRUE;
+    }
+
+    printf("Checking the current info record\n");
+    signal(SIGUSR1, CurrentInfoSignalHandler);
+
+    if (!CheckCurrentInfo(GLVND_CURRENT_API_NONE, 0, NULL, NULL)) {
+        return GL_FALSE;
+    }
+
+    if (!__glDispatchMakeCurrent(&vendor->threadState, vendor->dispatch,
+                vendor->vendorID, vendor->patchCallbacksPtr)) {
+        printf("__glDispatchMakeCurrent failed\n");
+        return GL_FALSE;
+    }
+    __glDispatchSetCurrentInfo(&dummyDisplay, vendor);
+    ret = CheckCurrentInfo(GLVND_CURRENT_API_GLX, vendor->vendorID,
+            &dummyDisplay, vendor);
+    __glDispatchLoseCurrent();
+
+    if (ret) {
+        ret = CheckCurrentInfo(GLVND_CURRENT_API_NONE, 0, NULL, NULL);
+    }
+    signal(SIGUSR1, SIG_DFL);
+    return ret;
+}
+
+static GLboolean TestStatistics(void)
+{
+    __GLdispatchStats stats;
+
+    printf("Checking libGLdispatch statistics\n");
+    __glDispatchGetStatistics(&stats);
+
+    if (stats.tableCount != DUMMY_VENDOR_COUNT) {
+        printf("Got %d dispatch tables, expected %d\n",
+                stats.tableCount, DUMMY_VENDOR_COUNT);
+        return GL_FALSE;
+    }
+    if (stats.currentContextCount != 0) {
+        printf("Got %d current contexts after losing current\n",
+                stats.currentContextCount);
+        return GL_FALSE;
+    }
+    if (stats.dynamicStubCount < 0
+            || stats.dynamicStubCount > stats.dynamicStubMax) {
+        printf("Got %d dynamic stubs out of %d\n",
+                stats.dynamicStubCount, stats.dynamicStubMax);
+        return GL_FALSE;
+    }
+    if (enableGeneratedTest && stats.dynamicStubCount == 0) {
+        printf("The generated stub wasn't counted\n");
+        return GL_FALSE;
+    }
+    if (stats.slotsResolved == 0) {
+        printf("No dispatch table slots were resolved\n");
+        return GL_FALSE;
+    }
+    if ((enablePatching || enablePatchTargets) && stats.patchCount == 0) {
+        printf("The entrypoints were never patched\n");
+        return GL_FALSE;
+    }
+    if (stats.lockAcquired == 0) {
+        printf("The dispatch lock was never taken\n");
+        return GL_FALSE;
+    }
+    return GL_TRUE;
+}
+
+static GLboolean TestErrorCheckRestore(void)
+{
+    DummyVendorLib *vendor = &dummyVendors[0];
+    __GLdispatchStats stats;
+    uint64_t patchCount, unpatchCount;
+    int i;
+
+    printf("Testing entrypoint restores with app error checking\n");
+    __glDispatchGetStatistics(&stats);
+    patchCount = stats.patchCount;
+    unpatchCount = stats.unpatchCount;
+
+    // Release and re-bind the same context, like an app that does that every
+    // frame. libGLdispatch should still restore the entrypoints now and then,
+    // but it shouldn't repatch them every time.
+    for (i=0; i<NUM_ERROR_CHECK_RELEASES; i++) {
+        if (!__glDispatchMakeCurrent(&vendor->threadState, vendor->dispatch,
+                    vendor->vendorID, vendor->patchCallbacksPtr)) {
+            printf("__glDispatchMakeCurrent failed\n");
+            return GL_FALSE;
+        }
+        __glDispatchLoseCurrent();
+    }
+
+    __glDispatchGetStatistics(&stats);
+    patchCount = stats.patchCount - patchCount;
+    unpatchCount = stats.unpatchCount - unpatchCount;
+    if (unpatchCount == 0) {
+        printf("The entrypoints were never restored\n");
+        return GL_FALSE;
+    }
+    if (patchCount > NUM_ERROR_CHECK_RELEASES / 16) {
+        printf("The entrypoints were patched %llu times in %d releases\n",
+                (unsigned long long) patchCount, NUM_ERROR_CHECK_RELEASES);
+        return GL_FALSE;
+    }
+    return GL_TRUE;
+}
+
+static GLboolean TestConfig(void)
+{
+    __GLdispatchConfig config;
+    const char *disallowPatchStr = getenv("__GLVND_DISALLOW_PATCHING");
+
+    printf("Checking libGLdispatch configuration\n");
+    __glDispatchGetConfig(&config);
+
+    if (config.entryType == NULL || config.entryType[0] == '\0') {
+        printf("Missing entrypoint type\n");
+        return GL_FALSE;
+    }
+    if (config.stubFlavor != __glDispatchGetStubFlavor()) {
+        printf("Got stub flavor %d, expected %d\n", config.stubFlavor,
+                __glDispatchGetStubFlavor());
+        return GL_FALSE;
+    }
+    if (forceMultiThreaded && !config.isMultiThreaded) {
+        printf("libGLdispatch didn't switch to multi-threaded mode\n");
+        return GL_FALSE;
+    }
+    if (disallowPatchStr != NULL && atoi(disallowPatchStr) != 0) {
+        if (config.patchDisabledReason != GLDISPATCH_PATCH_DISABLED_ENV_VAR) {
+            printf("Got patch disabled reason %d, expected %d\n",
+                    config.patchDisabledReason,
+                    GLDISPATCH_PATCH_DISABLED_ENV_VAR);
+            return GL_FALSE;
+        }
+    } else if (disallowPatchStr == NULL && layerGetCallCount != NULL) {
+        if (config.patchDisabledReason != GLDISPATCH_PATCH_DISABLED_LAYERS) {
+            printf("Got patch disabled reason %d, expected %d\n",
+                    config.patchDisabledReason,
+                    GLDISPATCH_PATCH_DISABLED_LAYERS);
+            return GL_FALSE;
+        }
+    }
+    if ((enablePatching || enablePatchTargets)
+            && config.patchDisabledReason == GLDISPATCH_PATCH_DISABLED_NONE
+            && !config.patchSupported) {
+        printf("The entrypoints were patched, but patching isn't supported\n");
+        return GL_FALSE;
+    }
+    if ((config.patchRefusalCount == 0)
+            != (config.lastPatchRefusal == GLDISPATCH_PATCH_REFUSED_NONE)) {
+        printf("Got %llu patch refusals, but last refusal reason %d\n",
+                (unsigned long long) config.patchRefusalCount,
+                config.lastPatchRefusal);
+        return GL_FALSE;
+    }
+    return GL_TRUE;
+}
+
 static void *common_getProcAddressCallback(const char *procName, void *param, int vendorIndex)
 {
     DummyVendorLib *dummyVendor = (DummyVendorLib *) param;
@@ -355,6 +1036,7 @@ static void *common_getProcAddressCallback(const char *procName, void *param, in
         abort();
     }
 
+    dummyVendor->lookupCount++;
     if (strcmp(procName, "glVertex3fv") == 0) {
         return dummyVendor->vertexProc;
     } else if (strcmp(procName, GENERATED_FUNCTION_NAME) == 0) {
@@ -364,6 +1046,18 @@ static void *common_getProcAddressCallback(const char *procName, void *param, in
     }
 }
 
+static void common_getProcAddressBulkCallback(const char * const *procNames,
+        void **procs, int count, void *param)
+{
+    DummyVendorLib *dummyVendor = (DummyVendorLib *) param;
+    int i;
+
+    dummyVendor->bulkLookupCount++;
+    for (i=0; i<count; i++) {
+        procs[i] = dummyVendor->getProcCallback(procNames[i], param);
+    }
+}
+
 static void *dummy0_getProcAddressCallback(const char *procName, void *param)
 {
     return common_getProcAddressCallback(procName, param, 0);
@@ -438,3 +1132,143 @@ static GLboolean dummy1_InitiatePatch(int type, int stubSize,
     return common_InitiatePatch(type, stubSize, lookupStubOffset, 1);
 }
 
+static GLboolean common_InitiatePatchTargets(DispatchPatchSetStubTarget setStubTarget,
+        pfn_glVertex3fv vertexProc, pfn_glVertex3fv testProc)
+{
+    // Each set of entrypoints might not have both functions, so it's not an
+    // error if either one is missing.
+    GLboolean anyPatched = GL_FALSE;
+
+    if (setStubTarget("glVertex3fv", vertexProc)) {
+        anyPatched = GL_TRUE;
+    }
+    if (enableGeneratedTest && setStubTarget(GENERATED_FUNCTION_NAME, testProc)) {
+        anyPatched = GL_TRUE;
+    }
+    return anyPatched;
+}
+
+static GLboolean dummy0_InitiatePatchTargets(DispatchPatchSetStubTarget setStubTarget)
+{
+    return common_InitiatePatchTargets(setStubTarget,
+            dummy0_glVertex3fv_patched, dummy0_glDummyTestProc_patched);
+}
+
+static GLboolean dummy1_InitiatePatchTargets(DispatchPatchSetStubTarget setStubTarget)
+{
+    return common_InitiatePatchTargets(setStubTarget,
+            dummy1_glVertex3fv_patched, dummy1_glDummyTestProc_patched);
+}
+
+static void dummy0_glVertex3fv_patched(const GLfloat *v)
+{
+    dummyVendors[0].callCounts[CALL_INDEX_STATIC_PATCH]++;
+}
+
+static void dummy1_glVertex3fv_patched(const GLfloat *v)
+{
+    dummyVendors[1].callCounts[CALL_INDEX_STATIC_PATCH]++;
+}
+
+static void dummy0_glDummyTestProc_patched(const GLfloat *v)
+{
+    dummyVendors[0].callCounts[CALL_INDEX_GENERATED_PATCH]++;
+}
+
+static void dummy1_glDummyTestProc_patched(const GLfloat *v)
+{
+    dummyVendors[1].callCounts[CALL_INDEX_GENERATED_PATCH]++;
+}
+
+static int staticFuncsLookupCount = 0;
+static int staticFuncsCallCount = 0;
+
+static void *staticFuncs_getProcAddressCallback(const char *procName, void *param)
+{
+    if (strcmp(procName, "glVertex3fv") == 0) {
+        staticFuncsLookupCount++;
+    }
+    return NULL;
+}
+
+static void staticFuncs_glVertex3fv(const GLfloat *v)
+{
+    staticFuncsCallCount++;
+}
+
+static GLboolean TestStaticFuncs(void)
+{
+    static const GLfloat NORMAL[3] = { 1.0f, 0.0f, 0.0f };
+    DummyVendorLib *vendor = &dummyVendors[0];
+    __GLdispatchThreadState threadState;
+    __GLdispatchTable *dispatch;
+    const void **funcs;
+    uint32_t layoutHash;
+    int staticCount = 0;
+    GLboolean ret = GL_FALSE;
+    int i;
+
+    // A patched entrypoint would skip the dispatch table, and a dispatch
+    // layer needs every function to be looked up.
+    if (!enableStaticTest || vendor->patchCallbacksPtr != NULL
+            || layerGetCallCount != NULL || expectPinnedVendor) {
+        return GL_TRUE;
+    }
+
+    printf("Checking a dispatch table with static functions\n");
+
+    layoutHash = __glDispatchGetTableLayout(&staticCount);
+    if (staticCount <= 0) {
+        printf("Wrong static slot count: %d\n", staticCount);
+        return GL_FALSE;
+    }
+
+    // Every static slot gets the same function, so it doesn't matter which
+    // slot glVertex3fv is in.
+    funcs = malloc(staticCount * sizeof(void *));
+    if (funcs == NULL) {
+        printf("Can't allocate static function array\n");
+        return GL_FALSE;
+    }
+    for (i=0; i<staticCount; i++) {
+        funcs[i] = (const void *) staticFuncs_glVertex3fv;
+    }
+
+    dispatch = __glDispatchCreateTable(staticFuncs_getProcAddressCallback, NULL);
+    if (dispatch == NULL) {
+        printf("__glDispatchCreateTable failed\n");
+        free(funcs);
+        return GL_FALSE;
+    }
+    if (__glDispatchSetTableStaticFuncs(dispatch, layoutHash + 1, funcs, staticCount)) {
+        printf("Static functions with the wrong layout were accepted\n");
+        goto done;
+    }
+    if (!__glDispatchSetTableStaticFuncs(dispatch, layoutHash, funcs, staticCount)) {
+        printf("__glDispatchSetTableStaticFuncs failed\n");
+        goto done;
+    }
+
+    memset(&threadState, 0, sizeof(threadState));
+    if (!__glDispatchMakeCurrent(&threadState, dispatch, vendor->vendorID, NULL)) {
+        printf("__glDispatchMakeCurrent failed\n");
+        goto done;
+    }
+    ptr_glVertex3fv(NORMAL);
+    __glDispatchLoseCurrent();
+
+    if (staticFuncsCallCount != 1) {
+        printf("Static function was called %d times\n", staticFuncsCallCount);
+        goto done;
+    }
+    if (staticFuncsLookupCount != 0) {
+        printf("glVertex3fv was looked up by name\n");
+        goto done;
+    }
+    ret = GL_TRUE;
+
+done:
+    __glDispatchDestroyTable(dispatch);
+    free(funcs);
+    return ret;
+}
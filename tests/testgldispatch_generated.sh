@@ -4,4 +4,9 @@ set -e
 
 ./testgldispatch -g
 ./testgldispatch -g -l
-
+./testgldispatch -g -b
+__GLVND_LAZY_DISPATCH=1 ./testgldispatch -g
+__GLVND_LAZY_DISPATCH=1 ./testgldispatch -g -l
+__GLVND_PIN_VENDOR=1 ./testgldispatch -g
+__GLVND_SHARE_DISPATCH_TABLES=1 ./testgldispatch -g
+__GLVND_NUMA_DISPATCH_TABLES=1 ./testgldispatch -g
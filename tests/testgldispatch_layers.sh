@@ -0,0 +1,14 @@
+#!/bin/sh
+
+set -e
+
+__GLVND_LAYER_FILENAMES=$TOP_SRCDIR/tests/json_layers/10_gldispatchlayer.json
+export __GLVND_LAYER_FILENAMES
+
+LD_LIBRARY_PATH=$LD_LIBRARY_PATH:$TOP_BUILDDIR/tests/dummy/.libs
+export LD_LIBRARY_PATH
+
+./testgldispatch -s
+./testgldispatch -s -b
+__GLVND_LAZY_DISPATCH=1 ./testgldispatch -s
+./testgldispatch -g
@@ -0,0 +1,8 @@
+#!/bin/sh
+
+set -e
+
+./testgldispatch -g -o
+./testgldispatch -g -o -t
+./testgldispatch -g -o -b
+__GLVND_LAZY_DISPATCH=1 ./testgldispatch -g -o
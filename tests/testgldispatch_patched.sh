@@ -5,3 +5,11 @@ set -e
 ./testgldispatch -s -g -p
 ./testgldispatch -s -g -p -l
 
+__GLVND_PIN_VENDOR=1 ./testgldispatch -s -g -p
+__GLVND_PREWARM_DISPATCH=2 ./testgldispatch -s -g -p
+
+# With app error checking, the entrypoints get restored when no context is
+# current, but not after every release.
+__GLVND_APP_ERROR_CHECKING=1 __GLVND_ABORT_ON_APP_ERROR=0 ./testgldispatch -s -g -p
+
+./testgldispatch -s -g -p -f
@@ -0,0 +1,8 @@
+#!/bin/sh
+
+set -e
+
+./testgldispatch -s -g -a
+./testgldispatch -s -g -a -l
+./testgldispatch -s -g -a -t
+./testgldispatch -s -g -a -c
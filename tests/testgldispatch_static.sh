@@ -1,4 +1,14 @@
 #!/bin/sh
 
+set -e
+
 ./testgldispatch -s
+./testgldispatch -s -b
+__GLVND_LAZY_DISPATCH=1 ./testgldispatch -s
+__GLVND_PIN_VENDOR=1 ./testgldispatch -s
+__GLVND_SHARE_DISPATCH_TABLES=1 ./testgldispatch -s
+__GLVND_NUMA_DISPATCH_TABLES=1 ./testgldispatch -s
+__GLVND_PREWARM_DISPATCH=2 ./testgldispatch -s
+__GLVND_DISALLOW_PATCHING=1 ./testgldispatch -s
 
+./testgldispatch -s -f
@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+/*
+ * Tests the glXGetFBConfigs and glXChooseFBConfig cache.
+ *
+ * The dummy vendor only allows caching if GLVND_TEST_CACHE_FBCONFIGS is set,
+ * so the script runs this with and without it. Without it, every call should
+ * go to the vendor library.
+ */
+
+#include <X11/Xlib.h>
+#include <GL/glx.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "dummy/GLX_dummy.h"
+
+#define printError(...) fprintf(stderr, __VA_ARGS__)
+
+static int GetQueryCount(Display *dpy, GLXFBConfig config)
+{
+    int value = -1;
+    glXGetFBConfigAttrib(dpy, config, GLX_FBCONFIG_ATTRIB_QUERY_COUNT_DUMMY, &value);
+    return value;
+}
+
+/**
+ * Calls glXChooseFBConfig, and checks that it returns the same configs as
+ * \p expected.
+ */
+static GLXFBConfig *ChooseAndCompare(Display *dpy, int screen,
+        const int *attribs, const GLXFBConfig *expected, int expectedCount)
+{
+    GLXFBConfig *configs;
+    int count = 0;
+    int i;
+
+    configs = glXChooseFBConfig(dpy, screen, attribs, &count);
+    if (configs == NULL) {
+        printError("glXChooseFBConfig failed\n");
+        return NULL;
+    }
+    if (expected != NULL) {
+        if (count != expectedCount) {
+            printError("glXChooseFBConfig returned %d configs, expected %d\n",
+                    count, expectedCount);
+            XFree(configs);
+            return NULL;
+        }
+        for (i=0; i<count; i++) {
+            if (configs[i] != expected[i]) {
+                printError("glXChooseFBConfig returned a different config %d\n", i);
+                XFree(configs);
+                return NULL;
+            }
+        }
+    }
+    return configs;
+}
+
+int main(int argc, char **argv)
+{
+    static const int attribs[] = {
+        GLX_RENDER_TYPE, GLX_RGBA_BIT,
+        GLX_DOUBLEBUFFER, True,
+        None
+    };
+    static const int otherAttribs[] = {
+        GLX_RENDER_TYPE, GLX_RGBA_BIT,
+        None
+    };
+    Display *dpy = NULL;
+    GLXFBConfig *first = NULL;
+    GLXFBConfig *configs = NULL;
+    int firstCount = 0;
+    int expectCached;
+    int screen;
+    int start, count, value;
+    int result = 1;
+
+    expectCached = (getenv("GLVND_TEST_CACHE_FBCONFIGS") != NULL
+            && atoi(getenv("GLVND_TEST_CACHE_FBCONFIGS")) != 0);
+
+    dpy = XOpenDisplay(NULL);
+    if (dpy == NULL) {
+        printError("No display! Please re-test with a running X server\n"
+                   "and the DISPLAY environment variable set appropriately.\n");
+        goto done;
+    }
+    screen = DefaultScreen(dpy);
+
+    first = glXChooseFBConfig(dpy, screen, attribs, &firstCount);
+    if (first == NULL || firstCount <= 0) {
+        printError("glXChooseFBConfig failed\n");
+        goto done;
+    }
+    start = GetQueryCount(dpy, first[0]);
+
+    // The same attributes should come from the cache.
+    configs = ChooseAndCompare(dpy, screen, attribs, first, firstCount);
+    if (configs == NULL) {
+        goto done;
+    }
+    XFree(configs);
+    count = GetQueryCount(dpy, first[0]);
+    if (count != start + (expectCached ? 0 : 1)) {
+        printError("Same attributes: expected %d vendor calls, got %d\n",
+                (expectCached ? 0 : 1), count - start);
+        goto done;
+    }
+
+    // Different attributes, and glXGetFBConfigs, should both go to the
+    // vendor the first time.
+    configs = ChooseAndCompare(dpy, screen, otherAttribs, NULL, 0);
+    if (configs == NULL) {
+        goto done;
+    }
+    XFree(configs);
+    configs = glXGetFBConfigs(dpy, screen, &value);
+    if (configs == NULL) {
+        printError("glXGetFBConfigs failed\n");
+        goto done;
+    }
+    XFree(configs);
+    start = count;
+    count = GetQueryCount(dpy, first[0]);
+    if (count != start + 2) {
+        printError("New attributes: expected 2 vendor calls, got %d\n", count - start);
+        goto done;
+    }
+
+    // After the vendor invalidates the cache, the next call should go to the
+    // vendor again.
+    glXGetFBConfigAttrib(dpy, first[0], GLX_FBCONFIG_ATTRIB_INVALIDATE_DUMMY, &value);
+    configs = ChooseAndCompare(dpy, screen, attribs, first, firstCount);
+    if (configs == NULL) {
+        goto done;
+    }
+    XFree(configs);
+    start = count;
+    count = GetQueryCount(dpy, first[0]);
+    if (count != start + 1) {
+        printError("After invalidating: expected 1 vendor call, got %d\n", count - start);
+        goto done;
+    }
+
+    printf("Test succeeded: %s\n", expectCached ? "cached" : "not cached");
+    result = 0;
+
+done:
+    if (first != NULL) {
+        XFree(first);
+    }
+    if (dpy != NULL) {
+        XCloseDisplay(dpy);
+    }
+    return result;
+}
@@ -0,0 +1,6 @@
+#!/bin/sh
+
+. $TOP_SRCDIR/tests/glxenv.sh
+
+./testglxfbconfigcache || exit 1
+GLVND_TEST_CACHE_FBCONFIGS=1 ./testglxfbconfigcache
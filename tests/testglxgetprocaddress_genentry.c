@@ -36,10 +36,19 @@
 
 #include "dummy/GLX_dummy.h"
 
+#if defined(USE_X86_64_ASM) && !defined(__ILP32__)
+// This matches the check in glvnd_genentry.c. On these platforms, libGLX
+// keeps generating stubs once the static ones are used up.
+#define USE_RUNTIME_STUBS 1
+#endif
+
 int main(int argc, char **argv)
 {
     PFNGLXEXAMPLEEXTENSIONFUNCTION ptr_glXExampleExtensionFunction;
     PFNGLXEXAMPLEEXTENSIONFUNCTION ptr_glXExampleExtensionFunction2;
+#if defined(USE_RUNTIME_STUBS)
+    PFNGLXEXAMPLEEXTENSIONFUNCTION ptr_glXExampleExtensionFunction3;
+#endif
     __GLXextFuncPtr proc;
     Display *dpy = NULL;
     int result = 0;
@@ -77,12 +86,40 @@ int main(int argc, char **argv)
     }
     printf("Got glXExampleExtensionFunction2 at address %p\n", ptr_glXExampleExtensionFunction2);
 
+#if defined(USE_RUNTIME_STUBS)
+    // The static stubs are all used up now, so libGLX should start generating
+    // stubs in a runtime block.
+    proc = glXGetProcAddress((const GLubyte *) "glXLastUndefinedDummy");
+    if (proc == NULL) {
+        printf("Can't generate a runtime stub for glXLastUndefinedDummy\n");
+        return 1;
+    }
+
+    ptr_glXExampleExtensionFunction3 = (PFNGLXEXAMPLEEXTENSIONFUNCTION)
+        glXGetProcAddress((const GLubyte *) "glXExampleExtensionFunction3");
+    if (ptr_glXExampleExtensionFunction3 == NULL) {
+        printf("Can't look up glXExampleExtensionFunction3\n");
+        return 1;
+    }
+    printf("Got glXExampleExtensionFunction3 at address %p\n", ptr_glXExampleExtensionFunction3);
+
+    // Nothing has loaded a vendor library yet, so the runtime stub should go
+    // to libGLX's default no-op function. This tests that the generated code
+    // can run at all, without needing a display.
+    result = 0;
+    ptr_glXExampleExtensionFunction3(NULL, 0, &result);
+    if (result != 0) {
+        printf("Unexpected glXExampleExtensionFunction3() return value before loading a vendor: %d\n", result);
+        return 1;
+    }
+#else
     // Make one more call to glXGetProcAddress. This should return NULL.
     proc = glXGetProcAddress((const GLubyte *) "glXLastUndefinedDummy");
     if (proc != NULL) {
         printf("Last glXGetProcAddress returned non-NULL: %p\n", proc);
         return 1;
     }
+#endif
 
     dpy = XOpenDisplay(NULL);
     if (dpy == NULL) {
@@ -107,6 +144,15 @@ int main(int argc, char **argv)
         return 1;
     }
 
+#if defined(USE_RUNTIME_STUBS)
+    ptr_glXExampleExtensionFunction3(dpy, 0, &result);
+    if (result != 3) {
+        printf("Unexpected glXExampleExtensionFunction3() return value: %d\n", result);
+        XCloseDisplay(dpy);
+        return 1;
+    }
+#endif
+
     printf("%p - %p = %d\n", ptr_glXExampleExtensionFunction2,
             ptr_glXExampleExtensionFunction,
             (int) (((intptr_t) ptr_glXExampleExtensionFunction2) - ((intptr_t) ptr_glXExampleExtensionFunction)));
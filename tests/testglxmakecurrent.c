@@ -38,6 +38,7 @@
 #include <stdlib.h>
 #include <errno.h>
 #include <assert.h>
+#include <time.h>
 
 #include "utils_misc.h"
 #include "test_utils.h"
@@ -49,6 +50,7 @@
 typedef struct TestOptionsRec {
     int iterations;
     int threads;
+    int reportRate;
 } TestOptions;
 
 static void print_help(void)
@@ -57,7 +59,9 @@ static void print_help(void)
         "Options: \n"
         " -h, --help              Print this help message.\n"
         " -i<N>, --iterations=<N> Run N make current iterations in each thread \n"
-        " -t<N>, --threads=<N>    Run with N threads.\n";
+        " -t<N>, --threads=<N>    Run with N threads.\n"
+        " -r, --rate              Print the number of make current calls per\n"
+        "                         second across all threads.\n";
     printf("%s", help_string);
 }
 
@@ -69,15 +73,17 @@ void init_options(int argc, char **argv, TestOptions *t)
         { "help", no_argument, NULL, 'h'},
         { "iterations", required_argument, NULL, 'i'},
         { "threads", required_argument, NULL, 't'},
+        { "rate", no_argument, NULL, 'r'},
         { NULL, no_argument, NULL, 0 }
     };
 
     // Initialize defaults
     t->iterations = 1;
     t->threads = 1;
+    t->reportRate = 0;
 
     do {
-        c = getopt_long(argc, argv, "hi:t:", long_options, NULL);
+        c = getopt_long(argc, argv, "hi:t:r", long_options, NULL);
         switch (c) {
         case -1:
         default:
@@ -102,6 +108,9 @@ void init_options(int argc, char **argv, TestOptions *t)
                 exit(1);
             }
             break;
+        case 'r':
+            t->reportRate = 1;
+            break;
         }
     } while (c != -1);
 
@@ -255,6 +264,7 @@ int main(int argc, char **argv)
     int i;
     void *ret;
     int all_ret = 0;
+    struct timespec start, end;
 
     init_options(argc, argv, &t);
 
@@ -268,6 +278,8 @@ int main(int argc, char **argv)
         }
     }
 
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
     if (t.threads == 1) {
         ret = MakeCurrentThread((void *)&t);
         if (!ret) {
@@ -294,5 +306,18 @@ int main(int argc, char **argv)
             }
         }
     }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    if (t.reportRate && all_ret == 0) {
+        double elapsed = (end.tv_sec - start.tv_sec)
+            + (end.tv_nsec - start.tv_nsec) / 1000000000.0;
+        // Each iteration makes a context current and then releases it.
+        double calls = 2.0 * t.iterations * t.threads;
+
+        printf("%d thread(s): %.0f make current calls per second\n",
+                t.threads, calls / elapsed);
+    }
+
     return all_ret;
 }
@@ -0,0 +1,14 @@
+#!/bin/sh
+
+. $TOP_SRCDIR/tests/glxenv.sh
+
+# We require pthreads be loaded before libGLX for correctness
+LD_PRELOAD=libpthread.so.0
+export LD_PRELOAD
+
+# Report the make current rate with one thread and with several threads, each
+# using its own context and display. The rate should scale with the number of
+# threads, since the threads don't share any locks while calling into the
+# vendor library.
+./testglxmakecurrent -t 1 -i 20000 -r || exit 1
+./testglxmakecurrent -t 4 -i 20000 -r || exit 1
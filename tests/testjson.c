@@ -0,0 +1,329 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "glvnd_json.h"
+
+/*
+ * Unit tests for the JSON reader that libEGL uses for vendor config files.
+ *
+ * Any arguments are config files to check, such as the ones in tests/json.
+ */
+
+static int failures = 0;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            printf("%s:%d: Check failed: %s\n", __FILE__, __LINE__, #cond); \
+            failures++; \
+        } \
+    } while (0)
+
+/**
+ * Skips over a whole document. The buffer is copied into a malloc'ed buffer
+ * of exactly the right size, so that valgrind or ASan will catch the reader
+ * running off the end.
+ */
+static int SkipDocument(const char *text, size_t len)
+{
+    __GLVNDjsonReader reader;
+    char *buf = malloc(len > 0 ? len : 1);
+    int ret;
+
+    memcpy(buf, text, len);
+    __glvndJsonReaderInit(&reader, buf, len);
+    ret = __glvndJsonSkipValue(&reader);
+    free(buf);
+    return ret;
+}
+
+static int IsValid(const char *text)
+{
+    return SkipDocument(text, strlen(text));
+}
+
+static void TestValid(void)
+{
+    static const char *DOCS[] = {
+        "{}",
+        "[]",
+        " \n\t{ } ",
+        "{\"a\":1,\"b\":[true,false,null],\"c\":{\"d\":\"e\"}}",
+        "[0, -0, 1.5, -2.25e10, 3E-2, 4e+1]",
+        "[\"\", \"\\\"\\\\\\/\\b\\f\\n\\r\\t\", \"\\u0041\\ud83d\\ude00\"]",
+        "[[[[]]], {}, [{}]]",
+        // cJSON used strtod for numbers, so these were accepted too.
+        "[01, 1., -.5, 1.e5]",
+    };
+    size_t i;
+
+    for (i=0; i<sizeof(DOCS) / sizeof(DOCS[0]); i++) {
+        if (!IsValid(DOCS[i])) {
+            printf("Failed to read valid document: %s\n", DOCS[i]);
+            failures++;
+        }
+    }
+}
+
+static void TestMalformed(void)
+{
+    static const char *DOCS[] = {
+        "",
+        "   ",
+        "{",
+        "{\"a\"}",
+        "{\"a\" 1}",
+        "{a:1}",
+        "{\"a\":1,}",
+        "{\"a\":1 \"b\":2}",
+        "[1,]",
+        "[,1]",
+        "[1 2]",
+        "[tru]",
+        "[nul]",
+        "[True]",
+        "[-]",
+        "[.5]",
+        "[1e]",
+        "[+1]",
+        "[\"abc]",
+        "[\"\\x\"]",
+        "[\"\\u12\"]",
+        "[\"\\u12G4\"]",
+        "[\"\\udc00\"]",
+        "[\"\\ud800\"]",
+        "[\"\\ud800\\u0041\"]",
+        "}",
+        "]",
+    };
+    size_t i;
+
+    for (i=0; i<sizeof(DOCS) / sizeof(DOCS[0]); i++) {
+        if (IsValid(DOCS[i])) {
+            printf("Accepted malformed document: %s\n", DOCS[i]);
+            failures++;
+        }
+    }
+
+    // A null character can't be in a string, even though the buffer has a
+    // length and doesn't need to be null-terminated.
+    CHECK(!SkipDocument("[\"a\0b\"]", 7));
+}
+
+static void TestTruncated(void)
+{
+    static const char *DOCS[] = {
+        "{\"file_format_version\" : \"1.0.0\", \"ICD\" : "
+            "{ \"library_path\" : \"libEGL_dummy0.so.0\" } }",
+        "[1.5e3, true, false, null, \"\\u00e9\\ud83d\\ude00\", [{}]]",
+    };
+    size_t i, len;
+
+    for (i=0; i<sizeof(DOCS) / sizeof(DOCS[0]); i++) {
+        size_t full = strlen(DOCS[i]);
+        CHECK(SkipDocument(DOCS[i], full));
+        for (len=0; len<full; len++) {
+            if (SkipDocument(DOCS[i], len)) {
+                printf("Accepted truncated document: %.*s\n", (int) len, DOCS[i]);
+                failures++;
+            }
+        }
+    }
+}
+
+static char *MakeNested(int depth)
+{
+    char *text = malloc(depth * 2 + 1);
+    memset(text, '[', depth);
+    memset(text + depth, ']', depth);
+    text[depth * 2] = '\0';
+    return text;
+}
+
+static void TestNesting(void)
+{
+    // This is the same limit that cJSON had.
+    char *text = MakeNested(1000);
+    CHECK(IsValid(text));
+    free(text);
+
+    text = MakeNested(1001);
+    CHECK(!IsValid(text));
+    free(text);
+
+    // Make sure a very deep document fails cleanly instead of overflowing the
+    // stack.
+    text = MakeNested(1000000);
+    CHECK(!IsValid(text));
+    free(text);
+}
+
+static void TestEscapes(void)
+{
+    static const char DOC[] = "[\"a\\\"\\\\\\/\\b\\f\\n\\r\\t"
+        "\\u0041\\u00e9\\u20ac\\ud83d\\ude00z\"]";
+    static const char EXPECTED[] = "a\"\\/\b\f\n\r\t"
+        "A\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80z";
+    __GLVNDjsonReader reader;
+    __GLVNDjsonString str;
+    char buf[64];
+    char small[4];
+    char *copy;
+
+    __glvndJsonReaderInit(&reader, DOC, strlen(DOC));
+    CHECK(__glvndJsonBeginArray(&reader));
+    CHECK(__glvndJsonNextElement(&reader) == 1);
+    CHECK(__glvndJsonReadString(&reader, &str));
+
+    CHECK(__glvndJsonDecodeString(&str, buf, sizeof(buf)) == (int) strlen(EXPECTED));
+    CHECK(strcmp(buf, EXPECTED) == 0);
+
+    // A short buffer gets truncated, like snprintf.
+    CHECK(__glvndJsonDecodeString(&str, small, sizeof(small)) == (int) strlen(EXPECTED));
+    CHECK(strcmp(small, "a\"\\") == 0);
+
+    copy = __glvndJsonCopyString(&str);
+    CHECK(copy != NULL && strcmp(copy, EXPECTED) == 0);
+    free(copy);
+
+    CHECK(__glvndJsonNextElement(&reader) == 0);
+}
+
+static void TestMembers(void)
+{
+    static const char DOC[] = "{ \"Library_Path\" : \"lib\\u0041.so\", "
+        "\"skip\" : [1, {\"x\" : null}], \"n\" : 5 }";
+    __GLVNDjsonReader reader;
+    __GLVNDjsonString key, str;
+    char buf[32];
+
+    __glvndJsonReaderInit(&reader, DOC, strlen(DOC));
+    CHECK(__glvndJsonPeek(&reader) == GLVND_JSON_OBJECT);
+    CHECK(__glvndJsonBeginObject(&reader));
+
+    CHECK(__glvndJsonNextMember(&reader, &key) == 1);
+    // Member names are compared without case, the same as cJSON.
+    CHECK(__glvndJsonStringEquals(&key, "library_path"));
+    CHECK(!__glvndJsonStringEquals(&key, "library_pat"));
+    CHECK(!__glvndJsonStringEquals(&key, "library_paths"));
+    CHECK(__glvndJsonReadString(&reader, &str));
+    CHECK(__glvndJsonDecodeString(&str, buf, sizeof(buf)) == 7);
+    CHECK(strcmp(buf, "libA.so") == 0);
+
+    CHECK(__glvndJsonNextMember(&reader, &key) == 1);
+    CHECK(__glvndJsonStringEquals(&key, "skip"));
+    CHECK(__glvndJsonPeek(&reader) == GLVND_JSON_ARRAY);
+    CHECK(__glvndJsonSkipValue(&reader));
+
+    CHECK(__glvndJsonNextMember(&reader, &key) == 1);
+    CHECK(__glvndJsonStringEquals(&key, "n"));
+    CHECK(__glvndJsonPeek(&reader) == GLVND_JSON_NUMBER);
+    // Reading a number as a string fails without consuming it.
+    CHECK(!__glvndJsonReadString(&reader, &str));
+    CHECK(__glvndJsonSkipValue(&reader));
+
+    CHECK(__glvndJsonNextMember(&reader, &key) == 0);
+    CHECK(__glvndJsonPeek(&reader) == GLVND_JSON_INVALID);
+}
+
+/**
+ * Reads a vendor config file the same way that libEGL does.
+ */
+static void TestConfigFile(const char *filename)
+{
+    __GLVNDjsonFile file;
+    __GLVNDjsonReader reader;
+    __GLVNDjsonString key, str;
+    int haveVersion = 0, haveLibraryPath = 0;
+    int ret;
+
+    if (__glvndJsonMapFile(filename, &file) != 0) {
+        printf("Can't open %s\n", filename);
+        failures++;
+        return;
+    }
+
+    CHECK(SkipDocument(file.data, file.size));
+
+    __glvndJsonReaderInit(&reader, file.data, file.size);
+    CHECK(__glvndJsonBeginObject(&reader));
+    while ((ret = __glvndJsonNextMember(&reader, &key)) > 0) {
+        if (__glvndJsonStringEquals(&key, "file_format_version")) {
+            CHECK(__glvndJsonReadString(&reader, &str));
+            haveVersion = 1;
+        } else if (__glvndJsonStringEquals(&key, "ICD")) {
+            CHECK(__glvndJsonBeginObject(&reader));
+            while ((ret = __glvndJsonNextMember(&reader, &key)) > 0) {
+                if (__glvndJsonStringEquals(&key, "library_path")) {
+                    CHECK(__glvndJsonReadString(&reader, &str));
+                    haveLibraryPath = 1;
+                } else {
+                    CHECK(__glvndJsonSkipValue(&reader));
+                }
+            }
+            CHECK(ret == 0);
+        } else {
+            CHECK(__glvndJsonSkipValue(&reader));
+        }
+    }
+    CHECK(ret == 0);
+
+    if (!haveVersion || !haveLibraryPath) {
+        printf("%s is missing file_format_version or library_path\n", filename);
+        failures++;
+    }
+
+    __glvndJsonUnmapFile(&file);
+}
+
+int main(int argc, char **argv)
+{
+    int i;
+
+    TestValid();
+    TestMalformed();
+    TestTruncated();
+    TestNesting();
+    TestEscapes();
+    TestMembers();
+
+    for (i=1; i<argc; i++) {
+        TestConfigFile(argv[i]);
+    }
+
+    if (failures != 0) {
+        printf("%d checks failed\n", failures);
+        return 1;
+    }
+    return 0;
+}
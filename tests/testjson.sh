@@ -0,0 +1,3 @@
+#!/bin/sh
+
+./testjson $TOP_SRCDIR/tests/json/*.json $TOP_SRCDIR/tests/json_platforms/*.json
@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * unaltered in all copies or substantial portions of the Materials.
+ * Any additions, deletions, or changes to the original source files
+ * must be clearly indicated in accompanying documentation.
+ *
+ * If only executable code is distributed, then the accompanying
+ * documentation must state that "this software is based in part on the
+ * work of the Khronos Group."
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+#include <stdio.h>
+#include <GL/gl.h>
+
+/*
+ * A program that imports a typical set of OpenGL functions from
+ * libOpenGL.so and does nothing else. testldstartup.sh runs it to measure
+ * how long the dynamic loader takes to resolve those imports.
+ *
+ * Taking each function's address means the dynamic loader has to resolve it
+ * at startup, whether or not lazy binding is enabled.
+ */
+static void (* const volatile importedFuncs[])(void) = {
+    (void (*)(void)) glBindTexture,
+    (void (*)(void)) glBlendFunc,
+    (void (*)(void)) glClear,
+    (void (*)(void)) glClearColor,
+    (void (*)(void)) glClearDepth,
+    (void (*)(void)) glColorMask,
+    (void (*)(void)) glCullFace,
+    (void (*)(void)) glDeleteTextures,
+    (void (*)(void)) glDepthFunc,
+    (void (*)(void)) glDepthMask,
+    (void (*)(void)) glDisable,
+    (void (*)(void)) glDrawArrays,
+    (void (*)(void)) glDrawElements,
+    (void (*)(void)) glEnable,
+    (void (*)(void)) glFinish,
+    (void (*)(void)) glFlush,
+    (void (*)(void)) glFrontFace,
+    (void (*)(void)) glGenTextures,
+    (void (*)(void)) glGetError,
+    (void (*)(void)) glGetIntegerv,
+    (void (*)(void)) glGetString,
+    (void (*)(void)) glHint,
+    (void (*)(void)) glLineWidth,
+    (void (*)(void)) glPixelStorei,
+    (void (*)(void)) glPolygonOffset,
+    (void (*)(void)) glReadPixels,
+    (void (*)(void)) glScissor,
+    (void (*)(void)) glStencilFunc,
+    (void (*)(void)) glStencilMask,
+    (void (*)(void)) glStencilOp,
+    (void (*)(void)) glTexImage2D,
+    (void (*)(void)) glTexParameteri,
+    (void (*)(void)) glTexSubImage2D,
+    (void (*)(void)) glViewport,
+};
+
+int main(int argc, char **argv)
+{
+    size_t i;
+
+    for (i=0; i<sizeof(importedFuncs) / sizeof(importedFuncs[0]); i++) {
+        if (importedFuncs[i] == NULL) {
+            printf("Function %d was not resolved\n", (int) i);
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,23 @@
+#!/bin/sh
+
+# Checks that a program that imports a set of OpenGL functions from
+# libOpenGL.so starts. If libglvnd was configured with --enable-gnu-hash-only,
+# then this also checks that libOpenGL.so and libGL.so only have a GNU-style
+# hash table.
+
+set -e
+
+if [ "$GNU_HASH_ONLY" = "yes" ] && command -v readelf > /dev/null 2>&1 ; then
+    for lib in $TOP_BUILDDIR/src/OpenGL/.libs/libOpenGL.so \
+            $TOP_BUILDDIR/src/GL/.libs/libGL.so ; do
+        if [ ! -e "$lib" ] ; then
+            continue
+        fi
+        if readelf -d "$lib" | grep -q "(HASH)" ; then
+            echo "$lib has a DT_HASH table"
+            exit 1
+        fi
+    done
+fi
+
+./testldstartup
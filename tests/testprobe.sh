@@ -0,0 +1,15 @@
+#!/bin/sh
+
+. $TOP_SRCDIR/tests/eglenv.sh
+
+# Run glvnd-probe against the dummy vendors, and make sure that it found each
+# one and timed the GL calls.
+rm -f ./testprobe.out
+$TOP_BUILDDIR/src/probe/glvnd-probe -n 1000 > ./testprobe.out || exit 1
+grep -q "^  first MakeCurrent: *[0-9.]* us$" ./testprobe.out || exit 1
+grep -q "^  glGetError: *[0-9.]* ns/call (1000 calls)$" ./testprobe.out || exit 1
+grep -q "^  stub flavor: " ./testprobe.out || exit 1
+grep -q "^  LoadVendor for vendor \".*EGL_dummy0.*\" took [0-9]* us$" ./testprobe.out || exit 1
+grep -q "^  LoadVendor for vendor \".*EGL_dummy1.*\" took [0-9]* us$" ./testprobe.out || exit 1
+grep -q "^  FixupDispatchTable for vendor " ./testprobe.out || exit 1
+rm -f ./testprobe.out